@@ -0,0 +1,86 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef ABSTRACTIMMERSEDBOUNDARYFFTINTERFACEFACTORY_HPP_
+#define ABSTRACTIMMERSEDBOUNDARYFFTINTERFACEFACTORY_HPP_
+
+#include <complex>
+#include "AbstractImmersedBoundaryFftInterface.hpp"
+#include "ImmersedBoundaryMesh.hpp"
+
+/**
+ * An abstract factory for discrete Fourier transform backends, for use in immersed boundary simulations.
+ *
+ * The grids a backend transforms are only allocated when ImmersedBoundarySimulationModifier sets up its solver, so a
+ * backend other than fftw is supplied to the modifier as a factory, which is asked for a backend once the grids exist.
+ */
+template<unsigned DIM>
+class AbstractImmersedBoundaryFftInterfaceFactory
+{
+public:
+
+    /**
+     * Default constructor.
+     */
+    AbstractImmersedBoundaryFftInterfaceFactory();
+
+    /**
+     * Destructor.
+     */
+    virtual ~AbstractImmersedBoundaryFftInterfaceFactory();
+
+    /**
+     * Create a backend for the periodic transforms of a fluid solved in double precision.  The backend must follow
+     * the conventions of fftw's real-to-complex transforms: the Fourier-domain grids hold the Ny/2 + 1 non-redundant
+     * values of each row, and the inverse transform is not normalised.
+     *
+     * As this method is pure virtual, it must be overridden in subclasses.
+     *
+     * @param pMesh the immersed boundary mesh, whose grid size is that of the transforms
+     * @param pIn pointer to the input array, of 3 real Nx by Ny grids if activeSources is true, and 2 otherwise
+     * @param pComplex pointer to the Fourier-domain array, of as many complex Nx by (Ny/2 + 1) grids
+     * @param pOut pointer to the output array, of 2 real Nx by Ny grids
+     * @param activeSources whether the population has active fluid sources
+     *
+     * @return a new backend, to be deleted by the caller
+     */
+    virtual AbstractImmersedBoundaryFftInterface<DIM>* CreateFftInterface(ImmersedBoundaryMesh<DIM,DIM>* pMesh,
+                                                                         double* pIn,
+                                                                         std::complex<double>* pComplex,
+                                                                         double* pOut,
+                                                                         bool activeSources)=0;
+};
+
+#endif /*ABSTRACTIMMERSEDBOUNDARYFFTINTERFACEFACTORY_HPP_*/
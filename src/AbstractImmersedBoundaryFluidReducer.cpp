@@ -0,0 +1,130 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "AbstractImmersedBoundaryFluidReducer.hpp"
+
+AbstractImmersedBoundaryFluidReducer::AbstractImmersedBoundaryFluidReducer(const std::string& rFileName)
+    : mFileName(rFileName),
+      mNumGridPtsX(0u),
+      mNumGridPtsY(0u),
+      mDomainWidth(1.0),
+      mDomainHeight(1.0),
+      mBinaryOutput(false)
+{
+}
+
+AbstractImmersedBoundaryFluidReducer::~AbstractImmersedBoundaryFluidReducer()
+{
+}
+
+void AbstractImmersedBoundaryFluidReducer::Setup(const std::string& rDirectory,
+                                                 unsigned numGridPtsX,
+                                                 unsigned numGridPtsY,
+                                                 double domainWidth,
+                                                 double domainHeight)
+{
+    assert(numGridPtsX > 0 && numGridPtsY > 0);
+    assert(domainWidth > 0.0 && domainHeight > 0.0);
+    mNumGridPtsX = numGridPtsX;
+    mNumGridPtsY = numGridPtsY;
+    mDomainWidth = domainWidth;
+    mDomainHeight = domainHeight;
+
+    if (mWriter.IsStreaming())
+    {
+        mWriter.StopStreaming();
+    }
+    mWriter.SetDirectoryName(rDirectory);
+    mWriter.SetFileName(mFileName);
+    StartStreaming();
+}
+
+bool AbstractImmersedBoundaryFluidReducer::UsesFourierGrids() const
+{
+    return false;
+}
+
+void AbstractImmersedBoundaryFluidReducer::ReduceFourierGrids(const multi_array<std::complex<double>, 3>& rFourierGrids)
+{
+}
+
+void AbstractImmersedBoundaryFluidReducer::ReduceFourierGrids(const multi_array<std::complex<float>, 3>& rFourierGrids)
+{
+    if (!UsesFourierGrids())
+    {
+        return;
+    }
+
+    multi_array<std::complex<double>, 3> double_grids(extents[2][rFourierGrids.shape()[1]][rFourierGrids.shape()[2]]);
+    for (unsigned dim = 0; dim < 2; dim++)
+    {
+        for (unsigned x = 0; x < rFourierGrids.shape()[1]; x++)
+        {
+            for (unsigned y = 0; y < rFourierGrids.shape()[2]; y++)
+            {
+                double_grids[dim][x][y] = std::complex<double>(rFourierGrids[dim][x][y].real(), rFourierGrids[dim][x][y].imag());
+            }
+        }
+    }
+    ReduceFourierGrids(double_grids);
+}
+
+void AbstractImmersedBoundaryFluidReducer::Finish()
+{
+    if (mWriter.IsStreaming())
+    {
+        mWriter.StopStreaming();
+    }
+}
+
+void AbstractImmersedBoundaryFluidReducer::SetBinaryOutput(bool binaryOutput)
+{
+    mBinaryOutput = binaryOutput;
+}
+
+bool AbstractImmersedBoundaryFluidReducer::GetBinaryOutput() const
+{
+    return mBinaryOutput;
+}
+
+const std::string& AbstractImmersedBoundaryFluidReducer::rGetFileName() const
+{
+    return mFileName;
+}
+
+const CsvWriter& AbstractImmersedBoundaryFluidReducer::rGetWriter() const
+{
+    return mWriter;
+}
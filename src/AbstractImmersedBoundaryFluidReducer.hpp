@@ -0,0 +1,173 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef ABSTRACTIMMERSEDBOUNDARYFLUIDREDUCER_HPP_
+#define ABSTRACTIMMERSEDBOUNDARYFLUIDREDUCER_HPP_
+
+#include <complex>
+#include <string>
+
+#include "CsvWriter.hpp"
+#include "ImmersedBoundaryArray.hpp"
+
+/**
+ * An abstract class for in-situ reductions of the 2D fluid velocity, run by an ImmersedBoundarySimulationModifier at
+ * its reducer output steps in place of, or alongside, writing the full grids.  Each reducer streams its results a
+ * row at a time to its own file, through a CsvWriter, so output grows with the size of the reduction rather than
+ * of the grid.
+ *
+ * Reducers needing the Fourier transform of the velocity override UsesFourierGrids(), and are then passed the Fourier
+ * grids during the fluid solve of each output step, immediately after the velocity is updated there and before the
+ * inverse transform overwrites them.  Reduce() is called once the solve is complete.
+ */
+class AbstractImmersedBoundaryFluidReducer
+{
+protected:
+
+    /** The name of the file the results are streamed to. */
+    std::string mFileName;
+
+    /** The number of grid points in the x direction. */
+    unsigned mNumGridPtsX;
+
+    /** The number of grid points in the y direction. */
+    unsigned mNumGridPtsY;
+
+    /** The size of the periodic domain in the x direction. */
+    double mDomainWidth;
+
+    /** The size of the periodic domain in the y direction. */
+    double mDomainHeight;
+
+    /** The writer the results are streamed to. */
+    CsvWriter mWriter;
+
+    /** Whether the results are streamed to a binary file (see CsvWriter::StartStreaming()).  Defaults to false. */
+    bool mBinaryOutput;
+
+    /**
+     * Set the headers of #mWriter and start streaming to it.  Called by Setup() once the grid size is known.
+     */
+    virtual void StartStreaming()=0;
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param rFileName the name of the file the results are streamed to, whose extension .csv is replaced by .csvb
+     *     for binary output
+     */
+    AbstractImmersedBoundaryFluidReducer(const std::string& rFileName);
+
+    /**
+     * Destructor.  The file is closed by the destructor of #mWriter.
+     */
+    virtual ~AbstractImmersedBoundaryFluidReducer();
+
+    /**
+     * Prepare to reduce grids of a given size, streaming the results to a file.
+     *
+     * @param rDirectory the output directory, relative to the test output directory
+     * @param numGridPtsX the number of grid points in the x direction
+     * @param numGridPtsY the number of grid points in the y direction
+     * @param domainWidth the size of the periodic domain in the x direction (defaults to 1.0)
+     * @param domainHeight the size of the periodic domain in the y direction (defaults to 1.0)
+     */
+    void Setup(const std::string& rDirectory,
+               unsigned numGridPtsX,
+               unsigned numGridPtsY,
+               double domainWidth=1.0,
+               double domainHeight=1.0);
+
+    /**
+     * @return whether the reducer is passed the Fourier grids during the solve (defaults to false)
+     */
+    virtual bool UsesFourierGrids() const;
+
+    /**
+     * Reduce the Fourier transform of the velocity, if UsesFourierGrids() is overridden to return true.  The default
+     * does nothing.
+     *
+     * @param rFourierGrids the normalised Fourier coefficients of the two velocity components, with extents
+     *     [at least 2][Nx][Ny/2 + 1]
+     */
+    virtual void ReduceFourierGrids(const multi_array<std::complex<double>, 3>& rFourierGrids);
+
+    /**
+     * As ReduceFourierGrids(), for the single precision fluid solve.  The default converts to double precision.
+     *
+     * @param rFourierGrids the normalised Fourier coefficients of the two velocity components
+     */
+    virtual void ReduceFourierGrids(const multi_array<std::complex<float>, 3>& rFourierGrids);
+
+    /**
+     * Reduce the velocity at an output step, and stream the result.
+     *
+     * @param step the number of timesteps elapsed
+     * @param time the simulation time
+     * @param rVelocityGrids the velocity grids, with extents [2][Nx][Ny]
+     */
+    virtual void Reduce(unsigned step, double time, const multi_array<double, 3>& rVelocityGrids)=0;
+
+    /**
+     * Write any buffered results and close the file.
+     */
+    void Finish();
+
+    /**
+     * Set #mBinaryOutput.  This must be called before Setup() to have any effect.
+     *
+     * @param binaryOutput whether the results are streamed to a binary file
+     */
+    void SetBinaryOutput(bool binaryOutput);
+
+    /**
+     * @return #mBinaryOutput
+     */
+    bool GetBinaryOutput() const;
+
+    /**
+     * @return #mFileName
+     */
+    const std::string& rGetFileName() const;
+
+    /**
+     * @return #mWriter
+     */
+    const CsvWriter& rGetWriter() const;
+};
+
+#endif /*ABSTRACTIMMERSEDBOUNDARYFLUIDREDUCER_HPP_*/
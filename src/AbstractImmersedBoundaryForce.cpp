@@ -61,6 +61,78 @@ void AbstractImmersedBoundaryForce<DIM>::OutputImmersedBoundaryForceParameters(o
     // No parameters to output
 }
 
+template<unsigned DIM>
+void AbstractImmersedBoundaryForce<DIM>::AddForceContributionsToNodeArrays(const ImmersedBoundaryNodePairList<DIM>& rNodePairs,
+                                                                           ImmersedBoundaryNodeArrays<DIM>& rNodeArrays,
+                                                                           ImmersedBoundaryCellPopulation<DIM>& rCellPopulation)
+{
+    // Forces using the node arrays must override this method
+    assert(!UsesNodeArrays());
+
+    // Contributions are added through the Node objects, and gathered into the node arrays by the modifier
+    AddImmersedBoundaryForceContribution(rNodePairs, rCellPopulation);
+}
+
+template<unsigned DIM>
+void AbstractImmersedBoundaryForce<DIM>::AddImmersedBoundaryForceContribution(const ImmersedBoundaryNodePairList<DIM>& rNodePairs,
+        ImmersedBoundaryCellPopulation<DIM>& rCellPopulation)
+{
+    std::vector<std::pair<Node<DIM>*, Node<DIM>*> > node_pairs(rNodePairs.GetNumPairs());
+    for (unsigned pair = 0; pair < rNodePairs.GetNumPairs(); pair++)
+    {
+        node_pairs[pair].first = rCellPopulation.GetNode(rNodePairs.rGetPair(pair).mNodeA);
+        node_pairs[pair].second = rCellPopulation.GetNode(rNodePairs.rGetPair(pair).mNodeB);
+    }
+
+    AddImmersedBoundaryForceContribution(node_pairs, rCellPopulation);
+}
+
+template<unsigned DIM>
+void AbstractImmersedBoundaryForce<DIM>::ConvertNodePairs(const std::vector<std::pair<Node<DIM>*, Node<DIM>*> >& rNodePairs,
+                                                          ImmersedBoundaryCellPopulation<DIM>& rCellPopulation,
+                                                          ImmersedBoundaryNodePairList<DIM>& rNodePairList)
+{
+    std::vector<typename ImmersedBoundaryNodePairList<DIM>::NodePair> pairs;
+    pairs.reserve(rNodePairs.size());
+    for (unsigned pair_idx = 0; pair_idx < rNodePairs.size(); pair_idx++)
+    {
+        Node<DIM>* p_node_a = rNodePairs[pair_idx].first;
+        Node<DIM>* p_node_b = rNodePairs[pair_idx].second;
+
+        typename ImmersedBoundaryNodePairList<DIM>::NodePair pair;
+        pair.mNodeA = p_node_a->GetIndex();
+        pair.mNodeB = p_node_b->GetIndex();
+        pair.mElementA = *(p_node_a->rGetContainingElementIndices().begin());
+        pair.mElementB = *(p_node_b->rGetContainingElementIndices().begin());
+        if (pair.mElementA != pair.mElementB)
+        {
+            c_vector<double, DIM> vector = rCellPopulation.rGetMesh().GetVectorFromAtoB(p_node_a->rGetLocation(),
+                                                                                         p_node_b->rGetLocation());
+            pair.mSquaredDistance = inner_prod(vector, vector);
+            pairs.push_back(pair);
+        }
+    }
+
+    rNodePairList.Restore(pairs);
+}
+
+template<unsigned DIM>
+bool AbstractImmersedBoundaryForce<DIM>::UsesNodeArrays() const
+{
+    return false;
+}
+
+template<unsigned DIM>
+bool AbstractImmersedBoundaryForce<DIM>::UsesNodePairs() const
+{
+    return true;
+}
+
+template<unsigned DIM>
+void AbstractImmersedBoundaryForce<DIM>::AddElementSpringConstants(std::vector<double>& rSpringConstants)
+{
+}
+
 // Explicit instantiation
 template class AbstractImmersedBoundaryForce<1>;
 template class AbstractImmersedBoundaryForce<2>;
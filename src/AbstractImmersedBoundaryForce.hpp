@@ -39,6 +39,7 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "ChasteSerialization.hpp"
 #include "ClassIsAbstract.hpp"
 #include "ImmersedBoundaryCellPopulation.hpp"
+#include "ImmersedBoundaryNodePairList.hpp"
 
 /**
  * An abstract immersed boundary force class, for use in 
@@ -66,6 +67,21 @@ private:
     {
     }
 
+protected:
+
+    /**
+     * Helper method for subclasses implementing the overload of AddImmersedBoundaryForceContribution() taking Node
+     * pointers through the one taking an ImmersedBoundaryNodePairList.  Pairs of nodes in the same element, which never
+     * interact, are dropped.
+     *
+     * @param rNodePairs pairs of Node pointers
+     * @param rCellPopulation an immersed boundary cell population
+     * @param rNodePairList the list into which the pairs are restored
+     */
+    void ConvertNodePairs(const std::vector<std::pair<Node<DIM>*, Node<DIM>*> >& rNodePairs,
+                          ImmersedBoundaryCellPopulation<DIM>& rCellPopulation,
+                          ImmersedBoundaryNodePairList<DIM>& rNodePairList);
+
 public:
 
     /**
@@ -79,7 +95,42 @@ public:
     virtual ~AbstractImmersedBoundaryForce();
 
     /**
-     * Calculates the force on each immersed boundary node.
+     * Adds the force on each immersed boundary node to a contiguous buffer: the applied forces of the mesh's node
+     * arrays, indexed by slot (see ImmersedBoundaryNodeArrays::GetSlotOfNode()), which are spread to the fluid grid
+     * directly.  This is the method called by ImmersedBoundarySimulationModifier.
+     *
+     * Subclasses able to work on the node arrays should override this method, and UsesNodeArrays() to return true.
+     * By default, this adapts forces written node by node: AddImmersedBoundaryForceContribution() is called, which
+     * adds contributions through the Node objects, and the modifier then gathers these into the node arrays.
+     *
+     * @param rNodePairs the pairs of nodes, in different elements and within the interaction distance plus any skin,
+     *     between which to contribute the force
+     * @param rNodeArrays the mesh's node arrays, to whose applied forces contributions are added
+     * @param rCellPopulation an immersed boundary cell population
+     */
+    virtual void AddForceContributionsToNodeArrays(const ImmersedBoundaryNodePairList<DIM>& rNodePairs,
+                                                   ImmersedBoundaryNodeArrays<DIM>& rNodeArrays,
+                                                   ImmersedBoundaryCellPopulation<DIM>& rCellPopulation);
+
+    /**
+     * Calculates the force on each immersed boundary node, node by node.  This is called by the default
+     * implementation of AddForceContributionsToNodeArrays().
+     *
+     * Subclasses not overriding AddForceContributionsToNodeArrays() should override this method, or the overload
+     * taking Node pointers.  By default, the compact node pairs are converted to pairs of Node pointers and passed to
+     * that overload, which is retained for subclasses written against it.
+     *
+     * @param rNodePairs the pairs of nodes, in different elements and within the interaction distance plus any skin,
+     *     between which to contribute the force
+     * @param rCellPopulation an immersed boundary cell population
+     */
+    virtual void AddImmersedBoundaryForceContribution(const ImmersedBoundaryNodePairList<DIM>& rNodePairs,
+            ImmersedBoundaryCellPopulation<DIM>& rCellPopulation);
+
+    /**
+     * Calculates the force on each immersed boundary node, given pairs of Node pointers.  This is called by the
+     * default implementation of the overload taking an ImmersedBoundaryNodePairList.  Subclasses overriding that
+     * overload may implement this one through it, using ConvertNodePairs().
      *
      * As this method is pure virtual, it must be overridden
      * in subclasses.
@@ -90,6 +141,35 @@ public:
     virtual void AddImmersedBoundaryForceContribution(std::vector<std::pair<Node<DIM>*, Node<DIM>*> >& rNodePairs,
             ImmersedBoundaryCellPopulation<DIM>& rCellPopulation)=0;
 
+    /**
+     * Whether this force adds its contributions to the mesh's node arrays (see ImmersedBoundaryMesh::rGetNodeArrays())
+     * rather than through Node::AddAppliedForceContribution().  Forces using the node arrays avoid a pass over the
+     * Node objects each timestep, so subclasses overriding AddForceContributionsToNodeArrays() should override this
+     * method to return true.
+     *
+     * @return false, unless overridden
+     */
+    virtual bool UsesNodeArrays() const;
+
+    /**
+     * Whether this force reads the node pairs passed to AddForceContributionsToNodeArrays().  A force which does not
+     * may be calculated while the node pairs are being recalculated, so subclasses ignoring the node pairs should
+     * override this method to return false.
+     *
+     * @return true, unless overridden
+     */
+    virtual bool UsesNodePairs() const;
+
+    /**
+     * Add, for each element, the spring constant of any linear springs this force places between consecutive nodes of
+     * the element, as used by the last call to AddForceContributionsToNodeArrays().  ImmersedBoundarySimulationModifier
+     * uses these to treat the stiffest part of the membrane forces semi-implicitly, if required.
+     *
+     * @param rSpringConstants the spring constant of each element, indexed by element, to which contributions are added
+     *     (resized to the number of elements, including deleted ones, if too short)
+     */
+    virtual void AddElementSpringConstants(std::vector<double>& rSpringConstants);
+
     /**
      * Outputs the name of the immersed boundary force used in 
      * the simulation to file and then calls OutputImmersedBoundaryForceParameters()
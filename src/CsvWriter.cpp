@@ -34,19 +34,39 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "CsvWriter.hpp"
-#include "OutputFileHandler.hpp"
+#include <cstdio>
 
 CsvWriter::CsvWriter()
     : mDirectoryName(""),
       mFileName(""),
       mDataLength(0),
       mDataLengthSet(false),
-      mHeader(false)
+      mHeader(false),
+      mIsStreaming(false),
+      mStreamIsBinary(false),
+      mRowsPerFlush(0),
+      mNumBufferedRows(0),
+      mNumRowsStreamed(0)
 {
+    mNumStreamColumns[0] = 0;
+    mNumStreamColumns[1] = 0;
+    mNumStreamColumns[2] = 0;
 }
 
 CsvWriter::~CsvWriter()
 {
+    // A destructor must not throw, so a failure to write the final rows cannot be reported here
+    if (mIsStreaming)
+    {
+        try
+        {
+            StopStreaming();
+        }
+        catch (Exception&)
+        {
+        }
+    }
+
     mVecUnsigned.clear();
     mVecDoubles.clear();
     mVecStrings.clear();
@@ -88,87 +108,321 @@ void CsvWriter::WriteDataToFile()
         EXCEPTION("There is no data to write");
     }
 
-    if (mDirectoryName == "")
-    {
-        EXCEPTION("Output directory has not been specified");
-    }
+    ValidateFileName();
 
-    if (mFileName == "")
+    if (mHeader && mHeaderStrings.size() != mVecUnsigned.size() + mVecDoubles.size() + mVecStrings.size())
     {
-        EXCEPTION("File name has not been specified");
+        EXCEPTION("Expecting to write a header row, but header length does not match number of data rows");
     }
 
-    if (mHeader && mHeaderStrings.size() != mVecUnsigned.size() + mVecDoubles.size() + mVecStrings.size())
+    if (mIsStreaming)
     {
-        EXCEPTION("Expecting to write a header row, but header length does not match number of data rows");
+        EXCEPTION("Cannot write data to a file that rows are being streamed to");
     }
 
     // Open file for writing
     OutputFileHandler output_file_handler(mDirectoryName, false);
     out_stream p_output = output_file_handler.OpenOutputFile(mFileName);
 
+    // Each line is formatted into this buffer before it is written
+    std::string line;
+
     // Output header, if present
     if (mHeader)
     {
-        unsigned headers_printed = 0;
-        std::string sep = ",";
-
         for (unsigned header_idx = 0; header_idx < mHeaderStrings.size(); header_idx++)
         {
-            headers_printed++;
-            if (headers_printed == mHeaderStrings.size())
+            if (header_idx > 0)
             {
-                sep.clear();
+                line += ',';
             }
-            *p_output << mHeaderStrings[header_idx] << sep.c_str();
+            line += mHeaderStrings[header_idx];
         }
-
-        *p_output << "\n";
+        line += '\n';
+        *p_output << line;
     }
 
-    unsigned num_rows = (unsigned int) (mVecUnsigned.size() + mVecDoubles.size() + mVecStrings.size());
-
     // Output data: unsigned then doubles then strings
     for (unsigned data_idx = 0; data_idx < mDataLength; data_idx++)
     {
-        unsigned rows_printed = 0;
-        std::string sep = ",";
+        line.clear();
 
         for (unsigned vec_idx = 0; vec_idx < mVecUnsigned.size(); vec_idx++)
         {
-            rows_printed++;
-            if (rows_printed == num_rows)
-            {
-                sep.clear();
-            }
-            *p_output << mVecUnsigned[vec_idx][data_idx] << sep.c_str();
+            AppendUnsigned(line, mVecUnsigned[vec_idx][data_idx]);
+            line += ',';
         }
 
         for (unsigned vec_idx = 0; vec_idx < mVecDoubles.size(); vec_idx++)
         {
-            rows_printed++;
-            if (rows_printed == num_rows)
+            AppendDouble(line, mVecDoubles[vec_idx][data_idx]);
+            line += ',';
+        }
+
+        for (unsigned vec_idx = 0; vec_idx < mVecStrings.size(); vec_idx++)
+        {
+            line += mVecStrings[vec_idx][data_idx];
+            line += ',';
+        }
+
+        // Replace the final separator with the end of the line
+        line[line.size() - 1] = '\n';
+        *p_output << line;
+    }
+
+    // Close file
+    p_output->close();
+}
+
+void CsvWriter::StartStreaming(unsigned numUnsignedColumns,
+                               unsigned numDoubleColumns,
+                               unsigned numStringColumns,
+                               unsigned rowsPerFlush,
+                               bool binary)
+{
+    if (mIsStreaming)
+    {
+        EXCEPTION("Rows are already being streamed to file");
+    }
+
+    unsigned num_columns = numUnsignedColumns + numDoubleColumns + numStringColumns;
+    if (num_columns == 0)
+    {
+        EXCEPTION("Streamed rows must contain at least one column");
+    }
+
+    if (rowsPerFlush == 0)
+    {
+        EXCEPTION("At least one row must be buffered between flushes");
+    }
+
+    if (binary && numStringColumns > 0)
+    {
+        EXCEPTION("String columns cannot be streamed to a binary file");
+    }
+
+    ValidateFileName();
+
+    if (mHeader && mHeaderStrings.size() != num_columns)
+    {
+        EXCEPTION("Expecting to write a header row, but header length does not match number of data rows");
+    }
+
+    mNumStreamColumns[0] = numUnsignedColumns;
+    mNumStreamColumns[1] = numDoubleColumns;
+    mNumStreamColumns[2] = numStringColumns;
+    mRowsPerFlush = rowsPerFlush;
+    mNumBufferedRows = 0;
+    mNumRowsStreamed = 0;
+    mStreamIsBinary = binary;
+
+    OutputFileHandler output_file_handler(mDirectoryName, false);
+    if (mStreamIsBinary)
+    {
+        std::string file_name = mFileName.substr(0, mFileName.find_last_of(".")) + ".csvb";
+        mpStream = output_file_handler.OpenOutputFile(file_name, std::ios::out | std::ios::binary);
+
+        unsigned num_headers = mHeader ? mHeaderStrings.size() : 0;
+        unsigned header[6] = {CsvWriterBinaryFormat::MAGIC,
+                              CsvWriterBinaryFormat::VERSION,
+                              CsvWriterBinaryFormat::BYTE_ORDER_MARK,
+                              numUnsignedColumns,
+                              numDoubleColumns,
+                              num_headers};
+        mpStream->write(reinterpret_cast<const char*>(header), sizeof(header));
+
+        for (unsigned header_idx = 0; header_idx < num_headers; header_idx++)
+        {
+            unsigned length = mHeaderStrings[header_idx].size();
+            mpStream->write(reinterpret_cast<const char*>(&length), sizeof(length));
+            mpStream->write(mHeaderStrings[header_idx].data(), length);
+        }
+
+        // The buffers are sized once, and reused for every block
+        mUnsignedBuffer.resize(numUnsignedColumns * mRowsPerFlush);
+        mDoubleBuffer.resize(numDoubleColumns * mRowsPerFlush);
+    }
+    else
+    {
+        mpStream = output_file_handler.OpenOutputFile(mFileName);
+
+        mTextBuffer.clear();
+        if (mHeader)
+        {
+            for (unsigned header_idx = 0; header_idx < mHeaderStrings.size(); header_idx++)
             {
-                sep.clear();
+                if (header_idx > 0)
+                {
+                    mTextBuffer += ',';
+                }
+                mTextBuffer += mHeaderStrings[header_idx];
             }
-            *p_output << std::scientific << mVecDoubles[vec_idx][data_idx] << sep.c_str();
+            mTextBuffer += '\n';
         }
+    }
 
-        for (unsigned vec_idx = 0; vec_idx < mVecStrings.size(); vec_idx++)
+    mIsStreaming = true;
+    FlushStream();
+}
+
+void CsvWriter::AppendRow(const std::vector<unsigned>& rUnsigned,
+                          const std::vector<double>& rDoubles,
+                          const std::vector<std::string>& rStrings)
+{
+    if (!mIsStreaming)
+    {
+        EXCEPTION("Rows are not being streamed to file");
+    }
+
+    if (rUnsigned.size() != mNumStreamColumns[0]
+        || rDoubles.size() != mNumStreamColumns[1]
+        || rStrings.size() != mNumStreamColumns[2])
+    {
+        EXCEPTION("Streamed rows must have the number of columns given when streaming was started");
+    }
+
+    if (mStreamIsBinary)
+    {
+        // Store the row column by column, so that each column of the block is contiguous
+        for (unsigned col = 0; col < rUnsigned.size(); col++)
+        {
+            mUnsignedBuffer[col * mRowsPerFlush + mNumBufferedRows] = rUnsigned[col];
+        }
+        for (unsigned col = 0; col < rDoubles.size(); col++)
+        {
+            mDoubleBuffer[col * mRowsPerFlush + mNumBufferedRows] = rDoubles[col];
+        }
+    }
+    else
+    {
+        for (unsigned col = 0; col < rUnsigned.size(); col++)
+        {
+            AppendUnsigned(mTextBuffer, rUnsigned[col]);
+            mTextBuffer += ',';
+        }
+        for (unsigned col = 0; col < rDoubles.size(); col++)
+        {
+            AppendDouble(mTextBuffer, rDoubles[col]);
+            mTextBuffer += ',';
+        }
+        for (unsigned col = 0; col < rStrings.size(); col++)
+        {
+            mTextBuffer += rStrings[col];
+            mTextBuffer += ',';
+        }
+
+        // Replace the final separator with the end of the line
+        mTextBuffer[mTextBuffer.size() - 1] = '\n';
+    }
+
+    mNumBufferedRows++;
+    mNumRowsStreamed++;
+
+    if (mNumBufferedRows == mRowsPerFlush)
+    {
+        FlushStream();
+    }
+}
+
+void CsvWriter::FlushStream()
+{
+    if (!mIsStreaming)
+    {
+        return;
+    }
+
+    if (mStreamIsBinary)
+    {
+        if (mNumBufferedRows > 0)
         {
-            rows_printed++;
-            if (rows_printed == num_rows)
+            mpStream->write(reinterpret_cast<const char*>(&mNumBufferedRows), sizeof(mNumBufferedRows));
+            for (unsigned col = 0; col < mNumStreamColumns[0]; col++)
             {
-                sep.clear();
+                mpStream->write(reinterpret_cast<const char*>(&mUnsignedBuffer[col * mRowsPerFlush]),
+                                mNumBufferedRows * sizeof(unsigned));
+            }
+            for (unsigned col = 0; col < mNumStreamColumns[1]; col++)
+            {
+                mpStream->write(reinterpret_cast<const char*>(&mDoubleBuffer[col * mRowsPerFlush]),
+                                mNumBufferedRows * sizeof(double));
             }
-            *p_output << mVecStrings[vec_idx][data_idx] << sep.c_str();
         }
+    }
+    else
+    {
+        mpStream->write(mTextBuffer.data(), mTextBuffer.size());
 
-        *p_output << "\n";
+        // Clearing a string keeps its capacity, so the buffer is not reallocated
+        mTextBuffer.clear();
     }
 
-    // Close file
-    p_output->close();
+    mNumBufferedRows = 0;
+    mpStream->flush();
+
+    if (!mpStream->good())
+    {
+        EXCEPTION("Error writing streamed rows to file");
+    }
+}
+
+void CsvWriter::StopStreaming()
+{
+    if (!mIsStreaming)
+    {
+        return;
+    }
+
+    FlushStream();
+    mpStream->close();
+    mIsStreaming = false;
+}
+
+bool CsvWriter::IsStreaming() const
+{
+    return mIsStreaming;
+}
+
+unsigned CsvWriter::GetNumRowsStreamed() const
+{
+    return mNumRowsStreamed;
+}
+
+void CsvWriter::AppendUnsigned(std::string& rText, unsigned value)
+{
+    // Write the digits backwards from the end of a buffer long enough for any unsigned value
+    char digits[16];
+    char* p_end = digits + sizeof(digits);
+    char* p_digit = p_end;
+    do
+    {
+        *(--p_digit) = char('0' + value % 10);
+        value /= 10;
+    }
+    while (value > 0);
+
+    rText.append(p_digit, p_end);
+}
+
+void CsvWriter::AppendDouble(std::string& rText, double value)
+{
+    // The default precision of iostreams is 6 digits after the decimal point, as for printf
+    char digits[32];
+    int length = sprintf(digits, "%.6e", value);
+    assert(length > 0 && length < (int) sizeof(digits));
+    rText.append(digits, length);
+}
+
+void CsvWriter::ValidateFileName() const
+{
+    if (mDirectoryName == "")
+    {
+        EXCEPTION("Output directory has not been specified");
+    }
+
+    if (mFileName == "")
+    {
+        EXCEPTION("File name has not been specified");
+    }
 }
 
 void CsvWriter::ValidateNewData(unsigned dataLength)
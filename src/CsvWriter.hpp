@@ -41,9 +41,16 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <fstream>
 #include <sys/stat.h>
 #include "Exception.hpp"
+#include "OutputFileHandler.hpp"
 
 /**
  * A class to write simple data collected during simulations to a CSV file.
+ *
+ * Data may either be added a column at a time and written at the end with WriteDataToFile(), or, for diagnostics
+ * recorded every timestep, streamed a row at a time between StartStreaming() and StopStreaming().  Streamed rows are
+ * formatted into a buffer that is reused, and written to the file every so many rows, so memory use does not grow
+ * with the length of a run and a run that fails loses at most one buffer of rows.  Streamed rows may instead be
+ * written to a compact binary file, with the layout given in CsvWriterBinaryFormat.
  */
 class CsvWriter
 {
@@ -76,6 +83,57 @@ private:
     /** Vector of vectors containing strings. */
     std::vector<std::vector<std::string> > mVecStrings;
 
+    /** Whether rows are being streamed to the file. */
+    bool mIsStreaming;
+
+    /** Whether streamed rows are written to a binary, rather than a text, file. */
+    bool mStreamIsBinary;
+
+    /** The number of unsigned, double and string columns of each streamed row. */
+    unsigned mNumStreamColumns[3];
+
+    /** The number of rows buffered before they are written to the file. */
+    unsigned mRowsPerFlush;
+
+    /** The number of rows currently buffered. */
+    unsigned mNumBufferedRows;
+
+    /** The total number of rows streamed. */
+    unsigned mNumRowsStreamed;
+
+    /** The file that rows are streamed to. */
+    out_stream mpStream;
+
+    /** Text of the buffered rows, when streaming to a text file. */
+    std::string mTextBuffer;
+
+    /** Unsigned columns of the buffered rows, column by column, when streaming to a binary file. */
+    std::vector<unsigned> mUnsignedBuffer;
+
+    /** Double columns of the buffered rows, column by column, when streaming to a binary file. */
+    std::vector<double> mDoubleBuffer;
+
+    /**
+     * Append an unsigned integer to a string, in the format used by iostreams.
+     *
+     * @param rText the string
+     * @param value the value
+     */
+    static void AppendUnsigned(std::string& rText, unsigned value);
+
+    /**
+     * Append a double to a string, in the format used by iostreams with std::scientific.
+     *
+     * @param rText the string
+     * @param value the value
+     */
+    static void AppendDouble(std::string& rText, double value);
+
+    /**
+     * Check that the output directory and file name have been set.
+     */
+    void ValidateFileName() const;
+
     /**
      * Helper method for AddData().
      *
@@ -128,6 +186,53 @@ public:
      */
     void WriteDataToFile();
 
+    /**
+     * Start streaming rows to file, truncating it and writing the header row, if there is one.
+     *
+     * @param numUnsignedColumns the number of unsigned columns of each row, which are written first
+     * @param numDoubleColumns the number of double columns of each row, which are written next
+     * @param numStringColumns the number of string columns of each row, which are written last (defaults to 0)
+     * @param rowsPerFlush the number of rows buffered before they are written to the file (defaults to 100)
+     * @param binary whether to write a binary file in place of the CSV file, whose name has the extension .csvb in
+     *     place of .csv (defaults to false)
+     */
+    void StartStreaming(unsigned numUnsignedColumns,
+                        unsigned numDoubleColumns,
+                        unsigned numStringColumns=0,
+                        unsigned rowsPerFlush=100,
+                        bool binary=false);
+
+    /**
+     * Append a row to the stream.  The column counts must match those given to StartStreaming().
+     *
+     * @param rUnsigned the unsigned values of the row
+     * @param rDoubles the double values of the row
+     * @param rStrings the string values of the row
+     */
+    void AppendRow(const std::vector<unsigned>& rUnsigned,
+                   const std::vector<double>& rDoubles,
+                   const std::vector<std::string>& rStrings=std::vector<std::string>());
+
+    /**
+     * Write any buffered rows to the file, and flush it.
+     */
+    void FlushStream();
+
+    /**
+     * Write any buffered rows to the file and close it.  This is also done by the destructor.
+     */
+    void StopStreaming();
+
+    /**
+     * @return #mIsStreaming
+     */
+    bool IsStreaming() const;
+
+    /**
+     * @return #mNumRowsStreamed
+     */
+    unsigned GetNumRowsStreamed() const;
+
     /**
      * @return #mDirectoryName
      */
@@ -153,4 +258,25 @@ public:
     void SetFileName(std::string fileName);
 };
 
+/**
+ * The layout of the binary files streamed by CsvWriter.  All values are in native byte order, which is
+ * recorded by the byte order mark.
+ *
+ * The header is the magic number, the version, the byte order mark, the numbers of unsigned and double columns and of
+ * header strings (each 32-bit unsigned), followed by each header string as its length then its characters.  Rows
+ * follow in blocks, each being the number of rows in the block, then every unsigned column of the block in turn as
+ * 32-bit unsigned values, then every double column in turn as 64-bit doubles.
+ */
+namespace CsvWriterBinaryFormat
+{
+    /** The magic number at the start of every file, being "IBCV" read as little-endian. */
+    const unsigned MAGIC = 0x56434249u;
+
+    /** The version of the layout. */
+    const unsigned VERSION = 1u;
+
+    /** The byte order mark, which reads as this value in the byte order of the file. */
+    const unsigned BYTE_ORDER_MARK = 0x01020304u;
+}
+
 #endif /*CSVWRITER_HPP_*/
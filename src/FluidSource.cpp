@@ -34,6 +34,7 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "FluidSource.hpp"
+#include "ImmersedBoundaryFluidSourceRegistry.hpp"
 
 template<unsigned SPACE_DIM>
 FluidSource<SPACE_DIM>::FluidSource(unsigned index, ChastePoint<SPACE_DIM> point)
@@ -41,7 +42,9 @@ FluidSource<SPACE_DIM>::FluidSource(unsigned index, ChastePoint<SPACE_DIM> point
       mLocation(point.rGetLocation()),
       mStrength(0.0),
       mIsSourceAssociatedWithElement(false),
-      mAssociatedElementIndex(UINT_MAX)
+      mAssociatedElementIndex(UINT_MAX),
+      mpRegistry(NULL),
+      mRegistrySlot(UINT_MAX)
 {
 }
 
@@ -51,7 +54,9 @@ FluidSource<SPACE_DIM>::FluidSource(unsigned index, c_vector<double, SPACE_DIM>
       mLocation(location),
       mStrength(0.0),
       mIsSourceAssociatedWithElement(false),
-      mAssociatedElementIndex(UINT_MAX)
+      mAssociatedElementIndex(UINT_MAX),
+      mpRegistry(NULL),
+      mRegistrySlot(UINT_MAX)
 {
 }
 
@@ -60,7 +65,9 @@ FluidSource<SPACE_DIM>::FluidSource(unsigned index, double v1, double v2, double
     : mIndex(index),
       mStrength(0.0),
       mIsSourceAssociatedWithElement(false),
-      mAssociatedElementIndex(UINT_MAX)
+      mAssociatedElementIndex(UINT_MAX),
+      mpRegistry(NULL),
+      mRegistrySlot(UINT_MAX)
 {
     mLocation[0] = v1;
     if (SPACE_DIM > 1)
@@ -118,6 +125,18 @@ template<unsigned SPACE_DIM>
 void FluidSource<SPACE_DIM>::SetStrength(double strength)
 {
     mStrength = strength;
+
+    if (mpRegistry)
+    {
+        mpRegistry->UpdateStrength(mRegistrySlot, strength);
+    }
+}
+
+template<unsigned SPACE_DIM>
+void FluidSource<SPACE_DIM>::SetRegistry(ImmersedBoundaryFluidSourceRegistry<SPACE_DIM>* pRegistry, unsigned slot)
+{
+    mpRegistry = pRegistry;
+    mRegistrySlot = slot;
 }
 
 template<unsigned SPACE_DIM>
@@ -38,6 +38,9 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "ChastePoint.hpp"
 
+template<unsigned DIM>
+class ImmersedBoundaryFluidSourceRegistry;
+
 /**
  * A fluid source in an immersed boundary mesh, used in ImmersedBoundary simulations.
  */
@@ -63,6 +66,12 @@ private:
     /** Index of the immersed boundary element associated with this fluid source. */
     unsigned mAssociatedElementIndex;
 
+    /** The registry holding this source, which is notified of changes to its strength, or NULL if unregistered. */
+    ImmersedBoundaryFluidSourceRegistry<SPACE_DIM>* mpRegistry;
+
+    /** The slot of this source in #mpRegistry. */
+    unsigned mRegistrySlot;
+
 public:
 
     /**
@@ -134,12 +143,20 @@ public:
     double GetStrength() const;
 
     /**
-     * Set the new strength of the fluid source.
+     * Set the new strength of the fluid source, and notify the registry holding it, if any.
      *
      * @param strength of the fluid source
      */
     void SetStrength(double strength);
 
+    /**
+     * Set the registry holding this fluid source.  This is called by ImmersedBoundaryFluidSourceRegistry.
+     *
+     * @param pRegistry the registry, or NULL if the source is no longer registered
+     * @param slot the slot of the source in the registry
+     */
+    void SetRegistry(ImmersedBoundaryFluidSourceRegistry<SPACE_DIM>* pRegistry, unsigned slot);
+
     /**
      * Set whether the fluid source is associated with an element.
      *
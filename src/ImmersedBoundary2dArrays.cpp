@@ -36,16 +36,71 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "ImmersedBoundary2dArrays.hpp"
 #include <assert.h>
+#include <algorithm>
+#include <boost/type_traits/is_same.hpp>
 #include "Exception.hpp"
 
-template<unsigned DIM>
-ImmersedBoundary2dArrays<DIM>::ImmersedBoundary2dArrays(ImmersedBoundaryMesh<DIM,DIM>* pMesh, double dt, double reynoldsNumber, bool activeSources)
+template<unsigned DIM, typename SCALAR>
+ImmersedBoundary2dArrays<DIM, SCALAR>::ImmersedBoundary2dArrays(ImmersedBoundaryMesh<DIM,DIM>* pMesh,
+                                                                double dt,
+                                                                double reynoldsNumber,
+                                                                bool activeSources,
+                                                                bool lowMemory,
+                                                                unsigned numThreads)
     : mpMesh(pMesh),
-      mActiveSources(activeSources)
+      mReynoldsNumber(reynoldsNumber),
+      mTimeStep(dt),
+      mActiveSources(activeSources),
+      mLowMemory(lowMemory),
+      mHasWalls(pMesh->HasWalls()),
+      mForceGrids(ImmersedBoundaryAlignedAllocator<double>(2, numThreads)),
+      mRightHandSideGrids(ImmersedBoundaryAlignedAllocator<SCALAR>(activeSources || mHasWalls ? 3 : 2, numThreads)),
+      mSourceGradientGrids(ImmersedBoundaryAlignedAllocator<double>(2, numThreads)),
+      mOperator1(ImmersedBoundaryAlignedAllocator<SCALAR>(1, numThreads)),
+      mOperator2(ImmersedBoundaryAlignedAllocator<SCALAR>(1, numThreads)),
+      mFourierGrids(ImmersedBoundaryAlignedAllocator<std::complex<SCALAR> >(activeSources ? 3 : 2, numThreads)),
+      mPressureGrid(ImmersedBoundaryAlignedAllocator<std::complex<SCALAR> >(1, numThreads)),
+      mpPressureGrid(&mPressureGrid),
+      mOutputGrids(ImmersedBoundaryAlignedAllocator<SCALAR>(2, numThreads)),
+      mpOutputGrids(&mOutputGrids),
+      mReciprocalOperator1(ImmersedBoundaryAlignedAllocator<SCALAR>(1, numThreads)),
+      mNormalisedReciprocalOperator2(ImmersedBoundaryAlignedAllocator<SCALAR>(1, numThreads))
 {
     unsigned num_gridpts_x = mpMesh->GetNumGridPtsX();
     unsigned num_gridpts_y = mpMesh->GetNumGridPtsY();
 
+    // In double precision the inverse DFT outputs to the velocity grids, which are also double
+    const bool double_precision = boost::is_same<SCALAR, double>::value;
+
+    /*
+     * Between walls, the real-to-real DFTs are done in place on the right-hand-side grids, whose third slice holds the
+     * pressure even without fluid sources.  Only the grids and tables needed for this solve are allocated.
+     */
+    if (mHasWalls)
+    {
+        if (!double_precision || mLowMemory)
+        {
+            EXCEPTION("A domain bounded by walls is only supported in double precision with the default grid layout");
+        }
+
+        mForceGrids.resize(extents[2][num_gridpts_x][num_gridpts_y]);
+        mRightHandSideGrids.resize(extents[3][num_gridpts_x][num_gridpts_y]);
+        if (mActiveSources)
+        {
+            mSourceGradientGrids.resize(extents[2][num_gridpts_x][num_gridpts_y]);
+        }
+
+        mRealOperator2.resize(extents[num_gridpts_x][num_gridpts_y]);
+        mRealReciprocalOperator1.resize(extents[num_gridpts_x][num_gridpts_y]);
+        mRealNormalisedReciprocalOperator2.resize(extents[2][num_gridpts_x][num_gridpts_y]);
+
+        CalculateDerivativeTables(0, num_gridpts_x, mpMesh->GetDomainWidth() / (double) num_gridpts_x);
+        CalculateDerivativeTables(1, num_gridpts_y, mpMesh->GetDomainHeight() / (double) num_gridpts_y);
+
+        UpdateTimeStep(dt);
+        return;
+    }
+
     // We require an even number of grid points
     assert(num_gridpts_y % 2 == 0);
 
@@ -69,128 +124,500 @@ ImmersedBoundary2dArrays<DIM>::ImmersedBoundary2dArrays(ImmersedBoundaryMesh<DIM
         mRightHandSideGrids.resize(extents[2][num_gridpts_x][num_gridpts_y]);
     }
 
-    // The source gradient grids are only needed when fluid sources are present.  Otherwise, we need do nothing
-    if(mActiveSources)
+    // The source gradient grids are only needed when fluid sources are present, and are not used by the solver
+    if(mActiveSources && !mLowMemory)
     {
         mSourceGradientGrids.resize(extents[2][num_gridpts_x][num_gridpts_y]);
     }
 
     // Resize Fourier-domain arrays
     // There are three such FourierGrid arrays if sources are active
-    mOperator1.resize(extents[num_gridpts_x][reduced_y]);
+    if (!mLowMemory)
+    {
+        mOperator1.resize(extents[num_gridpts_x][reduced_y]);
+    }
     mOperator2.resize(extents[num_gridpts_x][reduced_y]);
     mFourierGrids.resize(extents[2 + (int)mActiveSources][num_gridpts_x][reduced_y]);
-    mPressureGrid.resize(extents[num_gridpts_x][reduced_y]);
+
+    /*
+     * The right-hand-side grids are dead from the forward DFT until the right-hand side is next assembled.  In double
+     * precision their storage holds the pressure, which is calculated after the forward DFT and is needed only until
+     * the end of the timestep, when it may be written to file; it needs num_gridpts_x * (num_gridpts_y + 2) values,
+     * which the two or three right-hand-side grids can hold as num_gridpts_y is even.  In single precision their
+     * storage instead holds the output of the inverse DFT, which overwrites it while the pressure is still needed.
+     */
+    if (mLowMemory && double_precision)
+    {
+        mpPressureGrid = new multi_array_ref<std::complex<SCALAR>, 2>(
+                reinterpret_cast<std::complex<SCALAR>*>(mRightHandSideGrids.data()), extents[num_gridpts_x][reduced_y]);
+    }
+    else
+    {
+        mPressureGrid.resize(extents[num_gridpts_x][reduced_y]);
+    }
+
+    if (mLowMemory && !double_precision)
+    {
+        mpOutputGrids = new multi_array_ref<SCALAR, 3>(mRightHandSideGrids.data(), extents[2][num_gridpts_x][num_gridpts_y]);
+    }
+    else if (!double_precision)
+    {
+        mOutputGrids.resize(extents[2][num_gridpts_x][num_gridpts_y]);
+    }
 
     mSin2x.resize(num_gridpts_x);
     mSin2y.resize(reduced_y);
 
+    mReciprocalOperator1.resize(extents[num_gridpts_x][reduced_y]);
+    mNormalisedReciprocalOperator2.resize(extents[num_gridpts_x][reduced_y]);
+    mImagSin2xOverSpacing.resize(num_gridpts_x);
+    mImagSin2yOverSpacing.resize(reduced_y);
+
     /*
      * There are several constants used in the Fourier domain as part of the Navier-Stokes solution which are constant
      * once grid sizes are known. We pre-calculate these to eliminate re-calculation at every time step.
      */
-    double x_spacing = 1.0 / (double) num_gridpts_x;
-    double y_spacing = 1.0 / (double) num_gridpts_y;
+    double x_spacing = mpMesh->GetDomainWidth() / (double) num_gridpts_x;
+    double y_spacing = mpMesh->GetDomainHeight() / (double) num_gridpts_y;
 
+    // The sines depend only on the wavenumber index, while the derivatives below scale with the physical grid spacing
     for (unsigned x = 0; x < num_gridpts_x; x++)
     {
-        mSin2x[x] = sin(2 * M_PI * (double) x * x_spacing);
+        mSin2x[x] = sin(2 * M_PI * (double) x / (double) num_gridpts_x);
     }
 
     for (unsigned y = 0; y < reduced_y; y++)
     {
-        mSin2y[y] = sin(2 * M_PI * (double) y * y_spacing);
+        mSin2y[y] = sin(2 * M_PI * (double) y / (double) num_gridpts_y);
     }
 
+    // The solver in the Fourier domain multiplies by i * sin(2x) / h, which is independent of the timestep
+    for (unsigned x = 0; x < num_gridpts_x; x++)
+    {
+        mImagSin2xOverSpacing[x] = std::complex<SCALAR>(0.0, mSin2x[x] / x_spacing);
+    }
+
+    for (unsigned y = 0; y < reduced_y; y++)
+    {
+        mImagSin2yOverSpacing[y] = std::complex<SCALAR>(0.0, mSin2y[y] / y_spacing);
+    }
+
+    // Finally, calculate the operators, which depend on the timestep
+    UpdateTimeStep(dt);
+}
+
+template<unsigned DIM, typename SCALAR>
+void ImmersedBoundary2dArrays<DIM, SCALAR>::UpdateTimeStep(double dt)
+{
+    assert(dt > 0.0);
+    mTimeStep = dt;
+
+    if (mHasWalls)
+    {
+        UpdateRealOperators();
+        return;
+    }
+
+    unsigned num_gridpts_x = mpMesh->GetNumGridPtsX();
+    unsigned num_gridpts_y = mpMesh->GetNumGridPtsY();
+    unsigned reduced_y = 1 + (num_gridpts_y/2);
+
+    double x_spacing = mpMesh->GetDomainWidth() / (double) num_gridpts_x;
+    double y_spacing = mpMesh->GetDomainHeight() / (double) num_gridpts_y;
+
+    // The operators are separable sums, so the sine terms need only be calculated once in each dimension
+    std::vector<double> sin_x_squared(num_gridpts_x);
+    std::vector<double> sin_y_squared(reduced_y);
+
+    for (unsigned x = 0; x < num_gridpts_x; x++)
+    {
+        double sin_x = sin(M_PI * (double) x / (double) num_gridpts_x);
+        sin_x_squared[x] = sin_x * sin_x / (x_spacing * x_spacing);
+    }
+
+    for (unsigned y = 0; y < reduced_y; y++)
+    {
+        double sin_y = sin(M_PI * (double) y / (double) num_gridpts_y);
+        sin_y_squared[y] = sin_y * sin_y / (y_spacing * y_spacing);
+    }
+
+    /*
+     * The solver in the Fourier domain multiplies by the reciprocals of these quantities, which saves a division per
+     * grid point per timestep.  The DFT normalising constant is also folded into the second operator.  In the
+     * low-memory layout the first operator is not stored, and only its reciprocal is calculated.
+     */
+    const double fft_norm = (double) num_gridpts_x * (double) num_gridpts_y;
+
     for (unsigned x = 0; x < num_gridpts_x; x++)
     {
         for (unsigned y = 0; y < reduced_y; y++)
         {
-            mOperator1[x][y] = (mSin2x[x] * mSin2x[x] / (x_spacing * x_spacing)) + (mSin2y[y] * mSin2y[y] / (y_spacing * y_spacing));
-            mOperator1[x][y] *= dt / reynoldsNumber;
+            double operator_1 = (mSin2x[x] * mSin2x[x] / (x_spacing * x_spacing)) + (mSin2y[y] * mSin2y[y] / (y_spacing * y_spacing));
+            operator_1 *= dt / mReynoldsNumber;
 
-            double sin_x = sin(M_PI * (double) x * x_spacing);
-            double sin_y = sin(M_PI * (double) y * y_spacing);
+            double operator_2 = (sin_x_squared[x] + sin_y_squared[y]) * (4.0 * dt / mReynoldsNumber) + 1.0;
 
-            mOperator2[x][y] = (sin_x * sin_x / (x_spacing * x_spacing)) + (sin_y * sin_y / (y_spacing * y_spacing));
-            mOperator2[x][y] *= 4.0 * dt / reynoldsNumber;
-            mOperator2[x][y] += 1.0;
+            if (!mLowMemory)
+            {
+                mOperator1[x][y] = (SCALAR) operator_1;
+            }
+            mOperator2[x][y] = (SCALAR) operator_2;
+
+            // The reciprocals are calculated in double precision, whatever the precision they are stored in
+            mReciprocalOperator1[x][y] = (SCALAR) (1.0 / operator_1);
+            mNormalisedReciprocalOperator2[x][y] = (SCALAR) (1.0 / (operator_2 * fft_norm));
         }
     }
+
+    // The first operator is (numerically close to) zero where the pressure is fixed to be zero
+    mReciprocalOperator1[0][0] = 0.0;
+    mReciprocalOperator1[num_gridpts_x/2][0] = 0.0;
+    mReciprocalOperator1[num_gridpts_x/2][num_gridpts_y/2] = 0.0;
+    mReciprocalOperator1[0][num_gridpts_y/2] = 0.0;
 }
 
-template<unsigned DIM>
-ImmersedBoundary2dArrays<DIM>::~ImmersedBoundary2dArrays()
+template<unsigned DIM, typename SCALAR>
+void ImmersedBoundary2dArrays<DIM, SCALAR>::CalculateDerivativeTables(unsigned dim, unsigned numGridPts, double spacing)
 {
+    mGradientIndices[dim].resize(numGridPts);
+    mGradientFactors[dim].resize(numGridPts);
+    mDivergenceIndices[dim].resize(numGridPts);
+    mDivergenceFactors[dim].resize(numGridPts);
+
+    if (mpMesh->HasWalls(dim))
+    {
+        /*
+         * The central difference of cosine mode k is -sin(pi k / n) / h times sine mode k, which has index k - 1, and
+         * that of sine index m is sin(pi (m + 1) / n) / h times cosine mode m + 1.  Cosine mode 0 and sine index
+         * n - 1, whose central differences vanish on the grid, pair with nothing.
+         */
+        for (unsigned idx = 0; idx < numGridPts; idx++)
+        {
+            mGradientIndices[dim][idx] = (idx + 1 < numGridPts) ? idx + 1 : idx;
+            mGradientFactors[dim][idx] = (idx + 1 < numGridPts) ?
+                    -sin(M_PI * (double) (idx + 1) / (double) numGridPts) / spacing : 0.0;
+
+            mDivergenceIndices[dim][idx] = (idx > 0) ? idx - 1 : idx;
+            mDivergenceFactors[dim][idx] = (idx > 0) ? sin(M_PI * (double) idx / (double) numGridPts) / spacing : 0.0;
+        }
+    }
+    else
+    {
+        /*
+         * In halfcomplex order, index k < n/2 holds the real part of wavenumber k and index n - k its imaginary part.
+         * Multiplying by i sin(2 pi k / n) / h, the central difference, swaps the two with a change of sign.  Even and
+         * odd quantities are transformed alike, and the constant and highest modes have no central difference.
+         */
+        assert(numGridPts % 2 == 0);
+        for (unsigned idx = 0; idx < numGridPts; idx++)
+        {
+            unsigned partner = (numGridPts - idx) % numGridPts;
+            unsigned wavenumber = std::min(idx, partner);
+            double factor = sin(2.0 * M_PI * (double) wavenumber / (double) numGridPts) / spacing;
+            if (wavenumber == 0 || 2 * wavenumber == numGridPts)
+            {
+                factor = 0.0;
+            }
+
+            mGradientIndices[dim][idx] = partner;
+            mGradientFactors[dim][idx] = (idx < partner) ? -factor : factor;
+            mDivergenceIndices[dim][idx] = partner;
+            mDivergenceFactors[dim][idx] = mGradientFactors[dim][idx];
+        }
+    }
 }
 
-template<unsigned DIM>
-multi_array<double, 3>& ImmersedBoundary2dArrays<DIM>::rGetModifiableForceGrids()
+template<unsigned DIM, typename SCALAR>
+void ImmersedBoundary2dArrays<DIM, SCALAR>::UpdateRealOperators()
+{
+    unsigned num_gridpts[2] = {mpMesh->GetNumGridPtsX(), mpMesh->GetNumGridPtsY()};
+    double spacings[2] = {mpMesh->GetDomainWidth() / (double) num_gridpts[0],
+                          mpMesh->GetDomainHeight() / (double) num_gridpts[1]};
+
+    /*
+     * The operators are separable sums in each direction.  The second operator involves the discrete Laplacian, whose
+     * eigenvalue for a mode with wavenumber theta is 4 sin^2(theta / 2) / h^2, theta being pi k / n for cosine mode k
+     * (or sine mode k, at index k - 1) and 2 pi k / n in a periodic direction.  The first is minus the composition of
+     * the central differences, as tabulated.  Each sine or cosine DFT is normalised by 2n, and each periodic DFT by n.
+     */
+    std::vector<double> laplacian[2][2];
+    std::vector<double> operator_1[2];
+    double fft_norm = 1.0;
+
+    for (unsigned dim = 0; dim < 2; dim++)
+    {
+        unsigned n = num_gridpts[dim];
+        bool walls = mpMesh->HasWalls(dim);
+        fft_norm *= walls ? 2.0 * (double) n : (double) n;
+
+        laplacian[dim][0].resize(n);
+        laplacian[dim][1].resize(n);
+        operator_1[dim].resize(n);
+
+        for (unsigned idx = 0; idx < n; idx++)
+        {
+            double even_sin = walls ? sin(0.5 * M_PI * (double) idx / (double) n) : sin(M_PI * (double) idx / (double) n);
+            double odd_sin = walls ? sin(0.5 * M_PI * (double) (idx + 1) / (double) n) : even_sin;
+
+            laplacian[dim][0][idx] = even_sin * even_sin / (spacings[dim] * spacings[dim]);
+            laplacian[dim][1][idx] = odd_sin * odd_sin / (spacings[dim] * spacings[dim]);
+
+            operator_1[dim][idx] = -mDivergenceFactors[dim][idx] * mGradientFactors[dim][mDivergenceIndices[dim][idx]];
+        }
+    }
+
+    const double dt_over_re = mTimeStep / mReynoldsNumber;
+
+    for (unsigned x = 0; x < num_gridpts[0]; x++)
+    {
+        for (unsigned y = 0; y < num_gridpts[1]; y++)
+        {
+            // The central differences vanish exactly for the modes where the pressure is fixed to be zero
+            double op_1 = dt_over_re * (operator_1[0][x] + operator_1[1][y]);
+            mRealReciprocalOperator1[x][y] = (op_1 == 0.0) ? 0.0 : 1.0 / op_1;
+
+            mRealOperator2[x][y] = 1.0 + 4.0 * dt_over_re * (laplacian[0][0][x] + laplacian[1][0][y]);
+
+            // The x velocity is odd in x and even in y, and the y velocity is even in x and odd in y
+            double op_2_x = 1.0 + 4.0 * dt_over_re * (laplacian[0][1][x] + laplacian[1][0][y]);
+            double op_2_y = 1.0 + 4.0 * dt_over_re * (laplacian[0][0][x] + laplacian[1][1][y]);
+            mRealNormalisedReciprocalOperator2[0][x][y] = 1.0 / (op_2_x * fft_norm);
+            mRealNormalisedReciprocalOperator2[1][x][y] = 1.0 / (op_2_y * fft_norm);
+        }
+    }
+}
+
+template<unsigned DIM, typename SCALAR>
+ImmersedBoundary2dArrays<DIM, SCALAR>::~ImmersedBoundary2dArrays()
+{
+    // In the low-memory layout, the views of shared storage are owned by this object
+    if (mpPressureGrid != &mPressureGrid)
+    {
+        delete mpPressureGrid;
+    }
+    if (mpOutputGrids != &mOutputGrids)
+    {
+        delete mpOutputGrids;
+    }
+}
+
+template<unsigned DIM, typename SCALAR>
+multi_array<double, 3>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetModifiableForceGrids()
 {
     return mForceGrids;
 }
 
-template<unsigned DIM>
-multi_array<double, 3>& ImmersedBoundary2dArrays<DIM>::rGetModifiableRightHandSideGrids()
+template<unsigned DIM, typename SCALAR>
+multi_array<SCALAR, 3>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetModifiableRightHandSideGrids()
 {
     return mRightHandSideGrids;
 }
 
-template<unsigned DIM>
-multi_array<double, 3>& ImmersedBoundary2dArrays<DIM>::rGetModifiableSourceGradientGrids()
+template<unsigned DIM, typename SCALAR>
+multi_array<double, 3>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetModifiableSourceGradientGrids()
 {
     return mSourceGradientGrids;
 }
 
-template<unsigned DIM>
-multi_array<std::complex<double>, 3>& ImmersedBoundary2dArrays<DIM>::rGetModifiableFourierGrids()
+template<unsigned DIM, typename SCALAR>
+multi_array<std::complex<SCALAR>, 3>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetModifiableFourierGrids()
 {
     return mFourierGrids;
 }
 
-template<unsigned DIM>
-multi_array<std::complex<double>, 2>& ImmersedBoundary2dArrays<DIM>::rGetModifiablePressureGrid()
+template<unsigned DIM, typename SCALAR>
+multi_array_ref<std::complex<SCALAR>, 2>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetModifiablePressureGrid()
 {
-    return mPressureGrid;
+    return *mpPressureGrid;
 }
 
-template<unsigned DIM>
-const multi_array<double, 2>& ImmersedBoundary2dArrays<DIM>::rGetOperator1() const
+template<unsigned DIM, typename SCALAR>
+multi_array_ref<SCALAR, 3>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetModifiableOutputGrids()
+{
+    return *mpOutputGrids;
+}
+
+template<unsigned DIM, typename SCALAR>
+const multi_array<SCALAR, 2>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetOperator1() const
 {
     return mOperator1;
 }
 
-template<unsigned DIM>
-const multi_array<double, 2>& ImmersedBoundary2dArrays<DIM>::rGetOperator2() const
+template<unsigned DIM, typename SCALAR>
+const multi_array<SCALAR, 2>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetOperator2() const
 {
     return mOperator2;
 }
 
-template<unsigned DIM>
-const std::vector<double>& ImmersedBoundary2dArrays<DIM>::rGetSin2x() const
+template<unsigned DIM, typename SCALAR>
+const std::vector<double>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetSin2x() const
 {
     return mSin2x;
 }
 
-template<unsigned DIM>
-const std::vector<double>& ImmersedBoundary2dArrays<DIM>::rGetSin2y() const
+template<unsigned DIM, typename SCALAR>
+const std::vector<double>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetSin2y() const
 {
     return mSin2y;
 }
 
-template<unsigned DIM>
-ImmersedBoundaryMesh<DIM,DIM>* ImmersedBoundary2dArrays<DIM>::GetMesh()
+template<unsigned DIM, typename SCALAR>
+const multi_array<SCALAR, 2>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetReciprocalOperator1() const
+{
+    return mReciprocalOperator1;
+}
+
+template<unsigned DIM, typename SCALAR>
+const multi_array<SCALAR, 2>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetNormalisedReciprocalOperator2() const
+{
+    return mNormalisedReciprocalOperator2;
+}
+
+template<unsigned DIM, typename SCALAR>
+const std::vector<std::complex<SCALAR> >& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetImagSin2xOverSpacing() const
+{
+    return mImagSin2xOverSpacing;
+}
+
+template<unsigned DIM, typename SCALAR>
+const std::vector<std::complex<SCALAR> >& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetImagSin2yOverSpacing() const
+{
+    return mImagSin2yOverSpacing;
+}
+
+template<unsigned DIM, typename SCALAR>
+double ImmersedBoundary2dArrays<DIM, SCALAR>::GetTimeStep() const
+{
+    return mTimeStep;
+}
+
+template<unsigned DIM, typename SCALAR>
+ImmersedBoundaryMesh<DIM,DIM>* ImmersedBoundary2dArrays<DIM, SCALAR>::GetMesh()
 {
     return mpMesh;
 }
 
-template<unsigned DIM>
-bool ImmersedBoundary2dArrays<DIM>::HasActiveSources()
+template<unsigned DIM, typename SCALAR>
+bool ImmersedBoundary2dArrays<DIM, SCALAR>::HasActiveSources()
 {
     return mActiveSources;
 }
 
+template<unsigned DIM, typename SCALAR>
+bool ImmersedBoundary2dArrays<DIM, SCALAR>::IsLowMemory() const
+{
+    return mLowMemory;
+}
+
+template<unsigned DIM, typename SCALAR>
+bool ImmersedBoundary2dArrays<DIM, SCALAR>::HasWalls() const
+{
+    return mHasWalls;
+}
+
+template<unsigned DIM, typename SCALAR>
+const std::vector<unsigned>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetGradientIndices(unsigned dim) const
+{
+    assert(dim < 2);
+    return mGradientIndices[dim];
+}
+
+template<unsigned DIM, typename SCALAR>
+const std::vector<double>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetGradientFactors(unsigned dim) const
+{
+    assert(dim < 2);
+    return mGradientFactors[dim];
+}
+
+template<unsigned DIM, typename SCALAR>
+const std::vector<unsigned>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetDivergenceIndices(unsigned dim) const
+{
+    assert(dim < 2);
+    return mDivergenceIndices[dim];
+}
+
+template<unsigned DIM, typename SCALAR>
+const std::vector<double>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetDivergenceFactors(unsigned dim) const
+{
+    assert(dim < 2);
+    return mDivergenceFactors[dim];
+}
+
+template<unsigned DIM, typename SCALAR>
+const multi_array<double, 2>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetRealOperator2() const
+{
+    return mRealOperator2;
+}
+
+template<unsigned DIM, typename SCALAR>
+const multi_array<double, 2>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetRealReciprocalOperator1() const
+{
+    return mRealReciprocalOperator1;
+}
+
+template<unsigned DIM, typename SCALAR>
+const multi_array<double, 3>& ImmersedBoundary2dArrays<DIM, SCALAR>::rGetRealNormalisedReciprocalOperator2() const
+{
+    return mRealNormalisedReciprocalOperator2;
+}
+
+template<unsigned DIM, typename SCALAR>
+std::vector<std::pair<std::string, std::size_t> > ImmersedBoundary2dArrays<DIM, SCALAR>::GetMemoryReport() const
+{
+    std::vector<std::pair<std::string, std::size_t> > report;
+
+    // The velocity grids belong to the mesh, but are listed as they are the largest grids of all
+    report.push_back(std::make_pair(std::string("VelocityGrids"),
+                                    mpMesh->rGet2dVelocityGrids().num_elements() * sizeof(double)));
+
+    report.push_back(std::make_pair(std::string("ForceGrids"), mForceGrids.num_elements() * sizeof(double)));
+    report.push_back(std::make_pair(std::string("RightHandSideGrids"),
+                                    mRightHandSideGrids.num_elements() * sizeof(SCALAR)));
+    report.push_back(std::make_pair(std::string("SourceGradientGrids"),
+                                    mSourceGradientGrids.num_elements() * sizeof(double)));
+    report.push_back(std::make_pair(std::string("Operator1"), mOperator1.num_elements() * sizeof(SCALAR)));
+    report.push_back(std::make_pair(std::string("Operator2"), mOperator2.num_elements() * sizeof(SCALAR)));
+    report.push_back(std::make_pair(std::string("FourierGrids"),
+                                    mFourierGrids.num_elements() * sizeof(std::complex<SCALAR>)));
+
+    // Grids using the storage of the right-hand-side grids in the low-memory layout have none of their own
+    report.push_back(std::make_pair(std::string("PressureGrid"),
+                                    mPressureGrid.num_elements() * sizeof(std::complex<SCALAR>)));
+    report.push_back(std::make_pair(std::string("OutputGrids"), mOutputGrids.num_elements() * sizeof(SCALAR)));
+
+    report.push_back(std::make_pair(std::string("ReciprocalOperator1"),
+                                    mReciprocalOperator1.num_elements() * sizeof(SCALAR)));
+    report.push_back(std::make_pair(std::string("NormalisedReciprocalOperator2"),
+                                    mNormalisedReciprocalOperator2.num_elements() * sizeof(SCALAR)));
+    report.push_back(std::make_pair(std::string("RealOperators"),
+                                    (mRealOperator2.num_elements() + mRealReciprocalOperator1.num_elements()
+                                     + mRealNormalisedReciprocalOperator2.num_elements()) * sizeof(double)));
+
+    // The tables of sine values are tiny compared to the grids, so are listed together
+    report.push_back(std::make_pair(std::string("SineTables"),
+                                    (mSin2x.size() + mSin2y.size()) * sizeof(double)
+                                    + (mImagSin2xOverSpacing.size() + mImagSin2yOverSpacing.size()) * sizeof(std::complex<SCALAR>)));
+
+    return report;
+}
+
+template<unsigned DIM, typename SCALAR>
+std::size_t ImmersedBoundary2dArrays<DIM, SCALAR>::GetNumBytes() const
+{
+    std::vector<std::pair<std::string, std::size_t> > report = GetMemoryReport();
+
+    std::size_t num_bytes = 0;
+    for (unsigned grid = 0; grid < report.size(); grid++)
+    {
+        num_bytes += report[grid].second;
+    }
+    return num_bytes;
+}
+
 // Explicit instantiation
 template class ImmersedBoundary2dArrays<1>;
 template class ImmersedBoundary2dArrays<2>;
 template class ImmersedBoundary2dArrays<3>;
+template class ImmersedBoundary2dArrays<1, float>;
+template class ImmersedBoundary2dArrays<2, float>;
+template class ImmersedBoundary2dArrays<3, float>;
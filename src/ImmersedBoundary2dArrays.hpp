@@ -37,6 +37,9 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define IMMERSEDBOUNDARY2DARRAYS_HPP_
 
 #include <complex>
+#include <string>
+#include <utility>
+#include <vector>
 #include "ImmersedBoundaryArray.hpp"
 #include "ImmersedBoundaryMesh.hpp"
 
@@ -45,8 +48,38 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *
  * As these arrays will often be (very) large, it saves significant time to pre-allocate them and re-use during each
  * timestep, rather than creating them as needed.
+ *
+ * The grids that undergo a DFT, and the operators and tables used in the Fourier domain, are stored as SCALAR, which
+ * is double by default or float for a single precision solve.  The force grids, and the velocity grids of the mesh,
+ * are always double.  In double precision the inverse DFT outputs to the velocity grids directly, while in single
+ * precision it outputs to separate output grids, which are then copied to the velocity grids.
+ *
+ * By default, every grid has its own storage.  In the opt-in low-memory layout, grids that are live during only part
+ * of a timestep share storage with grids that are dead at that time, and grids not needed by the solver are not
+ * allocated:
+ *  - in double precision, the pressure grid shares the storage of the right-hand-side grids, which are dead from the
+ *    forward DFT until the right-hand side is next assembled, so the pressure is valid only until the next timestep
+ *    begins;
+ *  - in single precision, the output grids share that storage instead, and the pressure grid has its own;
+ *  - the source gradient grids and the first operator are not allocated, the reciprocal of the first operator being
+ *    calculated directly.
+ * In this layout, the right-hand-side grids must not be resized.
+ *
+ * The grids are aligned for FFTW, and the pages of each are first touched by the threads that will transform it, each
+ * taking a contiguous block of x as FFTW's threads do, so that on a multi-socket node they are spread across the NUMA
+ * domains of those threads.
+ *
+ * If the mesh is bounded by walls, which is supported only in double precision, the solve uses real-to-real DFTs in
+ * place on the right-hand-side grids, which then always have three slices, the third holding the fluid sources and
+ * then the pressure.  In each direction the coefficients of a quantity even about the walls are those of a cosine
+ * transform (DCT-II), and of a quantity odd about them, namely the velocity component normal to the walls, those of a
+ * sine transform (DST-II), index m being the mode with m + 1 half-periods across the domain.  In a periodic direction
+ * both are the coefficients of the real-to-halfcomplex transform.  Central differences map the coefficients of an
+ * even quantity to those of an odd one and vice versa, each coefficient coming from a single other; the index it
+ * comes from and the factor it is multiplied by are tabulated in each direction.  None of the complex Fourier-domain
+ * grids are allocated.
  */
-template<unsigned DIM>
+template<unsigned DIM, typename SCALAR=double>
 class ImmersedBoundary2dArrays
 {
 protected:
@@ -54,29 +87,57 @@ protected:
     /** The immersed boundary mesh. */
     ImmersedBoundaryMesh<DIM,DIM>* mpMesh;
 
+    /** The Reynolds number, which is needed to recalculate the operators if the timestep changes. */
+    double mReynoldsNumber;
+
+    /** The timestep used to calculate the operators. */
+    double mTimeStep;
+
     /** Whether the population has active fluid sources. */
     bool mActiveSources;
 
+    /** Whether the grids use the low-memory layout, in which transient grids share storage. */
+    bool mLowMemory;
+
+    /** Whether the mesh is bounded by walls in either direction, in which case the DFTs are real-to-real. */
+    bool mHasWalls;
+
     /** Grid to store force acting on fluid. */
     multi_array<double, 3> mForceGrids;
 
     /** Grid to calculate upwind scheme and store RHS of system. */
-    multi_array<double, 3> mRightHandSideGrids;
+    multi_array<SCALAR, 3> mRightHandSideGrids;
 
     /** Grid to store the gradient of the fluid sources. */
     multi_array<double, 3> mSourceGradientGrids;
 
     /** Grid to store the first of two operators needed for the FFT algorithm. */
-    multi_array<double, 2> mOperator1;
+    multi_array<SCALAR, 2> mOperator1;
 
     /** Grid to store the second of two operators needed for the FFT algorithm. */
-    multi_array<double, 2> mOperator2;
+    multi_array<SCALAR, 2> mOperator2;
 
     /** Grid to store results of R2C FFT. */
-    multi_array<std::complex<double>, 3> mFourierGrids;
+    multi_array<std::complex<SCALAR>, 3> mFourierGrids;
+
+    /** The storage of the pressure grid, unless it shares the storage of #mRightHandSideGrids. */
+    multi_array<std::complex<SCALAR>, 2> mPressureGrid;
+
+    /**
+     * The calculated pressure grid.  This refers to #mPressureGrid, or to the storage of #mRightHandSideGrids in the
+     * low-memory layout in double precision.
+     */
+    multi_array_ref<std::complex<SCALAR>, 2>* mpPressureGrid;
+
+    /** The storage of the output grids, in single precision in the default layout. */
+    multi_array<SCALAR, 3> mOutputGrids;
 
-    /** Grid to store the calculated pressure grid. */
-    multi_array<std::complex<double>, 2> mPressureGrid;
+    /**
+     * Grid to store the output of the inverse DFT in single precision, before it is copied to the velocity grids.  This
+     * refers to #mOutputGrids, which is empty in double precision, or to the storage of #mRightHandSideGrids in the
+     * low-memory layout in single precision.
+     */
+    multi_array_ref<SCALAR, 3>* mpOutputGrids;
 
     /** Vector of sin values in x, constant once grid size is known. */
     std::vector<double> mSin2x;
@@ -84,6 +145,83 @@ protected:
     /** Vector of sin values in x, constant once grid size is known. */
     std::vector<double> mSin2y;
 
+    /**
+     * Grid to store the reciprocal of the first operator.  This is set to zero at the four locations where the
+     * pressure is fixed to be zero, so no special treatment of those locations is needed in the solver.
+     */
+    multi_array<SCALAR, 2> mReciprocalOperator1;
+
+    /**
+     * Grid to store the reciprocal of the second operator, multiplied by the reciprocal of the DFT normalising
+     * constant, so that the output of the inverse DFT needs no further scaling.
+     */
+    multi_array<SCALAR, 2> mNormalisedReciprocalOperator2;
+
+    /** Vector of i * sin(2x) / (x grid spacing) values, constant once grid size is known. */
+    std::vector<std::complex<SCALAR> > mImagSin2xOverSpacing;
+
+    /** Vector of i * sin(2y) / (y grid spacing) values, constant once grid size is known. */
+    std::vector<std::complex<SCALAR> > mImagSin2yOverSpacing;
+
+    /**
+     * For each direction, and each coefficient index of a quantity odd in that direction, the index of the
+     * coefficient of an even quantity from which the central difference of that quantity is taken.
+     */
+    std::vector<unsigned> mGradientIndices[2];
+
+    /** For each direction, the factors multiplying the coefficients given by #mGradientIndices. */
+    std::vector<double> mGradientFactors[2];
+
+    /**
+     * For each direction, and each coefficient index of a quantity even in that direction, the index of the
+     * coefficient of an odd quantity from which the central difference of that quantity is taken.
+     */
+    std::vector<unsigned> mDivergenceIndices[2];
+
+    /** For each direction, the factors multiplying the coefficients given by #mDivergenceIndices. */
+    std::vector<double> mDivergenceFactors[2];
+
+    /** The second operator, for the real-to-real DFTs, for quantities even in both directions. */
+    multi_array<double, 2> mRealOperator2;
+
+    /**
+     * The reciprocal of the first operator, for the real-to-real DFTs.  This is zero wherever the first operator is,
+     * and the pressure is fixed to be zero.
+     */
+    multi_array<double, 2> mRealReciprocalOperator1;
+
+    /**
+     * The reciprocal of the second operator, for the real-to-real DFTs, for each velocity component in turn, multiplied
+     * by the reciprocal of the DFT normalising constant.
+     */
+    multi_array<double, 3> mRealNormalisedReciprocalOperator2;
+
+    /**
+     * Helper method for the constructor.  Tabulates the central differences of the coefficients in one direction.
+     *
+     * @param dim the direction
+     * @param numGridPts the number of grid points in that direction
+     * @param spacing the grid spacing in that direction
+     */
+    void CalculateDerivativeTables(unsigned dim, unsigned numGridPts, double spacing);
+
+    /**
+     * Helper method for UpdateTimeStep().  Recalculates the operators for the real-to-real DFTs.
+     */
+    void UpdateRealOperators();
+
+private:
+
+    /** Disallow copying, as #mpPressureGrid and #mpOutputGrids point into the object itself. */
+    ImmersedBoundary2dArrays(const ImmersedBoundary2dArrays<DIM, SCALAR>&);
+
+    /**
+     * Disallow assignment.
+     *
+     * @return reference to these arrays
+     */
+    ImmersedBoundary2dArrays<DIM, SCALAR>& operator=(const ImmersedBoundary2dArrays<DIM, SCALAR>&);
+
 public:
 
     /**
@@ -93,13 +231,26 @@ public:
      * @param dt the simulation timestep
      * @param reynoldsNumber the Reynolds Number of the fluid
      * @param activeSources whether the population has active fluid sources
+     * @param lowMemory whether to use the low-memory layout, in which transient grids share storage (defaults to
+     *     false)
+     * @param numThreads the number of threads that will transform the grids, between which the first touch of each
+     *     grid is split, or 0 for the number of OpenMP threads (defaults to 0)
      */
-    ImmersedBoundary2dArrays(ImmersedBoundaryMesh<DIM,DIM>* pMesh, double dt, double reynoldsNumber, bool activeSources);
+    ImmersedBoundary2dArrays(ImmersedBoundaryMesh<DIM,DIM>* pMesh,
+                             double dt,
+                             double reynoldsNumber,
+                             bool activeSources,
+                             bool lowMemory=false,
+                             unsigned numThreads=0);
 
     /**
      * Empty constructor.
      */
     ImmersedBoundary2dArrays()
+        : mLowMemory(false),
+          mHasWalls(false),
+          mpPressureGrid(&mPressureGrid),
+          mpOutputGrids(&mOutputGrids)
     {
     }
 
@@ -112,22 +263,31 @@ public:
     multi_array<double, 3>& rGetModifiableForceGrids();
 
     /** @return reference to modifiable right-hand-side grids. */
-    multi_array<double, 3>& rGetModifiableRightHandSideGrids();
+    multi_array<SCALAR, 3>& rGetModifiableRightHandSideGrids();
 
     /** @return reference to modifiable source gradient grids. */
     multi_array<double, 3>& rGetModifiableSourceGradientGrids();
 
     /** @return reference to modifiable Fourier grids. */
-    multi_array<std::complex<double>, 3>& rGetModifiableFourierGrids();
+    multi_array<std::complex<SCALAR>, 3>& rGetModifiableFourierGrids();
 
-    /** @return reference to modifiable pressure grid. */
-    multi_array<std::complex<double>, 2>& rGetModifiablePressureGrid();
+    /**
+     * @return reference to modifiable pressure grid, which shares storage in the low-memory layout in double
+     *     precision
+     */
+    multi_array_ref<std::complex<SCALAR>, 2>& rGetModifiablePressureGrid();
+
+    /**
+     * @return reference to modifiable output grids, which are empty in double precision and share storage in the
+     *     low-memory layout
+     */
+    multi_array_ref<SCALAR, 3>& rGetModifiableOutputGrids();
 
-    /** @return reference to the first operator. */
-    const multi_array<double, 2>& rGetOperator1() const;
+    /** @return reference to the first operator, which is empty in the low-memory layout. */
+    const multi_array<SCALAR, 2>& rGetOperator1() const;
 
     /** @return reference to the second operator. */
-    const multi_array<double, 2>& rGetOperator2() const;
+    const multi_array<SCALAR, 2>& rGetOperator2() const;
 
     /** @return reference to the vector of sine values in x. */
     const std::vector<double>& rGetSin2x() const;
@@ -135,11 +295,84 @@ public:
     /** @return reference to the vector of sine values in y. */
     const std::vector<double>& rGetSin2y() const;
 
+    /** @return reference to the reciprocal of the first operator. */
+    const multi_array<SCALAR, 2>& rGetReciprocalOperator1() const;
+
+    /** @return reference to the normalised reciprocal of the second operator. */
+    const multi_array<SCALAR, 2>& rGetNormalisedReciprocalOperator2() const;
+
+    /** @return reference to the vector of i * sin(2x) / (x grid spacing) values. */
+    const std::vector<std::complex<SCALAR> >& rGetImagSin2xOverSpacing() const;
+
+    /** @return reference to the vector of i * sin(2y) / (y grid spacing) values. */
+    const std::vector<std::complex<SCALAR> >& rGetImagSin2yOverSpacing() const;
+
     /** @return #mpMesh. */
     ImmersedBoundaryMesh<DIM,DIM>* GetMesh();
 
+    /**
+     * Recalculate the operators, and all quantities derived from them, for a new timestep.  This is cheap compared to
+     * constructing a new object, and is used by the adaptive timestepping in ImmersedBoundarySimulationModifier.
+     *
+     * @param dt the new timestep
+     */
+    void UpdateTimeStep(double dt);
+
+    /** @return #mTimeStep. */
+    double GetTimeStep() const;
+
     /** @return #mActiveSources. */
     bool HasActiveSources();
+
+    /** @return #mLowMemory. */
+    bool IsLowMemory() const;
+
+    /** @return #mHasWalls. */
+    bool HasWalls() const;
+
+    /**
+     * @param dim a direction
+     * @return reference to the indices from which central differences of even quantities are taken, in that direction
+     */
+    const std::vector<unsigned>& rGetGradientIndices(unsigned dim) const;
+
+    /**
+     * @param dim a direction
+     * @return reference to the factors multiplying the coefficients given by rGetGradientIndices()
+     */
+    const std::vector<double>& rGetGradientFactors(unsigned dim) const;
+
+    /**
+     * @param dim a direction
+     * @return reference to the indices from which central differences of odd quantities are taken, in that direction
+     */
+    const std::vector<unsigned>& rGetDivergenceIndices(unsigned dim) const;
+
+    /**
+     * @param dim a direction
+     * @return reference to the factors multiplying the coefficients given by rGetDivergenceIndices()
+     */
+    const std::vector<double>& rGetDivergenceFactors(unsigned dim) const;
+
+    /** @return reference to the second operator for the real-to-real DFTs. */
+    const multi_array<double, 2>& rGetRealOperator2() const;
+
+    /** @return reference to the reciprocal of the first operator for the real-to-real DFTs. */
+    const multi_array<double, 2>& rGetRealReciprocalOperator1() const;
+
+    /** @return reference to the normalised reciprocals of the second operator for the real-to-real DFTs. */
+    const multi_array<double, 3>& rGetRealNormalisedReciprocalOperator2() const;
+
+    /**
+     * List the storage used by each grid, including the velocity grids of the mesh.  Grids sharing the storage of
+     * another grid use no storage of their own, so are listed with zero bytes.
+     *
+     * @return the name and number of bytes of storage of each grid, in the order in which they are declared
+     */
+    std::vector<std::pair<std::string, std::size_t> > GetMemoryReport() const;
+
+    /** @return the total number of bytes of storage used by the grids listed by GetMemoryReport() */
+    std::size_t GetNumBytes() const;
 };
 
 #endif /*IMMERSEDBOUNDARY2DARRAYS_HPP_*/
@@ -37,11 +37,325 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define IMMERSEDBOUNDARYARRAY_HPP_
 
 #include <complex>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #define BOOST_DISABLE_ASSERTS
 #include <boost/multi_array.hpp>
 
-using boost::multi_array;
+using boost::multi_array_ref;
 using boost::extents;
 
+/**
+ * The allocator of the grids used by the immersed boundary method.
+ *
+ * Storage is aligned to a cache line, which is at least the alignment of fftw_malloc(), so every grid satisfies the
+ * alignment FFTW's SIMD codelets are planned for, and plans made on one grid may be executed on another.  Storage is
+ * rounded up to a whole number of cache lines, so no two grids share one.
+ *
+ * Memory is placed on a NUMA domain by the thread that first touches it.  A large allocation is therefore zeroed in
+ * parallel before its elements are constructed: each of its slices (the grid of each component, for instance) is
+ * split into contiguous blocks, one per thread, so each thread first touches the rows it is given by threaded
+ * transforms and kernels that split the grids along x in the same way.
+ */
+template<typename T>
+class ImmersedBoundaryAlignedAllocator
+{
+public:
+
+    /** The type allocated. */
+    typedef T value_type;
+    /** Pointer to the type allocated. */
+    typedef T* pointer;
+    /** Const pointer to the type allocated. */
+    typedef const T* const_pointer;
+    /** Reference to the type allocated. */
+    typedef T& reference;
+    /** Const reference to the type allocated. */
+    typedef const T& const_reference;
+    /** The type of a number of elements. */
+    typedef std::size_t size_type;
+    /** The type of a difference between pointers. */
+    typedef std::ptrdiff_t difference_type;
+
+    /** The same allocator for another type. */
+    template<typename U>
+    struct rebind
+    {
+        /** The rebound allocator. */
+        typedef ImmersedBoundaryAlignedAllocator<U> other;
+    };
+
+    /** The alignment, in bytes, of all storage: a cache line. */
+    static const std::size_t ALIGNMENT = 64;
+
+    /** The size, in bytes, of a page: allocations of less than a page per thread are first touched serially. */
+    static const std::size_t PAGE_SIZE = 4096;
+
+    /**
+     * Constructor.
+     *
+     * @param numSlices the number of slices, of equal size, into which each allocation is split for the first touch
+     *     (defaults to 1)
+     * @param numThreads the number of threads that first touch each allocation, or 0 for the number of OpenMP threads
+     *     (defaults to 0)
+     */
+    explicit ImmersedBoundaryAlignedAllocator(unsigned numSlices=1, unsigned numThreads=0)
+        : mNumSlices(numSlices),
+          mNumThreads(numThreads)
+    {
+    }
+
+    /**
+     * Converting constructor.
+     *
+     * @param rOther the allocator of another type, whose first touch layout is taken
+     */
+    template<typename U>
+    ImmersedBoundaryAlignedAllocator(const ImmersedBoundaryAlignedAllocator<U>& rOther)
+        : mNumSlices(rOther.GetNumSlices()),
+          mNumThreads(rOther.GetNumThreads())
+    {
+    }
+
+    /** @return #mNumSlices */
+    unsigned GetNumSlices() const
+    {
+        return mNumSlices;
+    }
+
+    /** @return #mNumThreads */
+    unsigned GetNumThreads() const
+    {
+        return mNumThreads;
+    }
+
+    /**
+     * Allocate aligned storage, and first touch it.
+     *
+     * @param numElements the number of elements
+     * @return pointer to uninitialised storage for the elements
+     */
+    T* allocate(size_type numElements, const void* = 0)
+    {
+        if (numElements == 0)
+        {
+            return NULL;
+        }
+        if (numElements > max_size())
+        {
+            throw std::bad_alloc();
+        }
+
+        std::size_t num_bytes = ALIGNMENT * ((numElements * sizeof(T) + ALIGNMENT - 1) / ALIGNMENT);
+        void* p_storage = NULL;
+        if (posix_memalign(&p_storage, ALIGNMENT, num_bytes) != 0)
+        {
+            throw std::bad_alloc();
+        }
+
+        FirstTouch(static_cast<char*>(p_storage), num_bytes);
+        return static_cast<T*>(p_storage);
+    }
+
+    /**
+     * Free storage from allocate().
+     *
+     * @param pStorage the storage
+     */
+    void deallocate(T* pStorage, size_type)
+    {
+        free(pStorage);
+    }
+
+    /** @return the largest number of elements that may be allocated */
+    size_type max_size() const
+    {
+        return std::numeric_limits<size_type>::max() / sizeof(T) - ALIGNMENT;
+    }
+
+    /**
+     * @param rValue an element
+     * @return its address
+     */
+    T* address(T& rValue) const
+    {
+        return &rValue;
+    }
+
+    /**
+     * @param rValue an element
+     * @return its address
+     */
+    const T* address(const T& rValue) const
+    {
+        return &rValue;
+    }
+
+    /**
+     * Construct an element by copying.
+     *
+     * @param pElement the storage of the element
+     * @param rValue the value to copy
+     */
+    void construct(T* pElement, const T& rValue)
+    {
+        new(static_cast<void*>(pElement)) T(rValue);
+    }
+
+    /**
+     * Destroy an element.
+     *
+     * @param pElement the element
+     */
+    void destroy(T* pElement)
+    {
+        pElement->~T();
+    }
+
+private:
+
+    /** The number of slices into which each allocation is split for the first touch. */
+    unsigned mNumSlices;
+
+    /** The number of threads that first touch each allocation, or 0 for the number of OpenMP threads. */
+    unsigned mNumThreads;
+
+    /**
+     * Zero newly allocated storage, split between threads so that the pages of each slice are placed on the NUMA
+     * domains of the threads that will use them.  Without OpenMP, or for a small allocation, this does nothing, and
+     * the storage is first touched when its elements are constructed.
+     *
+     * @param pBytes the storage
+     * @param numBytes its size in bytes
+     */
+    void FirstTouch(char* pBytes, std::size_t numBytes) const
+    {
+#ifdef _OPENMP
+        unsigned num_threads = mNumThreads > 0 ? mNumThreads : (unsigned) omp_get_max_threads();
+        unsigned num_slices = mNumSlices > 0 ? mNumSlices : 1;
+        if (num_threads > 1 && numBytes >= PAGE_SIZE * num_threads * num_slices)
+        {
+            std::size_t slice_bytes = numBytes / num_slices;
+
+#pragma omp parallel num_threads(num_threads)
+            {
+                std::size_t thread = omp_get_thread_num();
+                std::size_t team_size = omp_get_num_threads();
+
+                for (unsigned slice = 0; slice < num_slices; slice++)
+                {
+                    // The last slice also takes any bytes padding the allocation
+                    char* p_slice = pBytes + slice * slice_bytes;
+                    std::size_t this_slice_bytes = slice + 1 == num_slices ? numBytes - slice * slice_bytes : slice_bytes;
+
+                    std::size_t begin = this_slice_bytes * thread / team_size;
+                    std::size_t end = this_slice_bytes * (thread + 1) / team_size;
+                    memset(p_slice + begin, 0, end - begin);
+                }
+            }
+        }
+#endif
+    }
+};
+
+/**
+ * Allocators of the same type are interchangeable, as the storage they allocate is freed in the same way.
+ *
+ * @return true
+ */
+template<typename T, typename U>
+inline bool operator==(const ImmersedBoundaryAlignedAllocator<T>&, const ImmersedBoundaryAlignedAllocator<U>&)
+{
+    return true;
+}
+
+/**
+ * @return false
+ */
+template<typename T, typename U>
+inline bool operator!=(const ImmersedBoundaryAlignedAllocator<T>&, const ImmersedBoundaryAlignedAllocator<U>&)
+{
+    return false;
+}
+
+/**
+ * The multidimensional array used for all grids, being a boost::multi_array whose storage comes from
+ * ImmersedBoundaryAlignedAllocator.  By default, an allocation is first touched as a single slice by every OpenMP
+ * thread; an owner whose grids have several components, or are used by a set number of threads, passes an allocator
+ * with that layout to the constructor, which is kept when the array is resized.
+ */
+template<typename T, std::size_t NumDims>
+class multi_array : public boost::multi_array<T, NumDims, ImmersedBoundaryAlignedAllocator<T> >
+{
+public:
+
+    /** The boost::multi_array this is. */
+    typedef boost::multi_array<T, NumDims, ImmersedBoundaryAlignedAllocator<T> > boost_array_type;
+
+    /**
+     * Constructor for an empty array.
+     *
+     * @param rAllocator the allocator of the array (defaults to the default allocator)
+     */
+    explicit multi_array(const ImmersedBoundaryAlignedAllocator<T>& rAllocator=ImmersedBoundaryAlignedAllocator<T>())
+        : boost_array_type(rAllocator)
+    {
+    }
+
+    /**
+     * Constructor.
+     *
+     * @param rExtents the extents of the array, such as extents[2][n][n]
+     * @param rAllocator the allocator of the array (defaults to the default allocator)
+     */
+    template<typename ExtentList>
+    explicit multi_array(const ExtentList& rExtents,
+                         const ImmersedBoundaryAlignedAllocator<T>& rAllocator=ImmersedBoundaryAlignedAllocator<T>())
+        : boost_array_type(rExtents, boost::c_storage_order(), rAllocator)
+    {
+    }
+
+    /**
+     * Copy constructor, which takes the allocator of the copied array.
+     *
+     * @param rOther the array to copy
+     */
+    multi_array(const multi_array& rOther)
+        : boost_array_type(static_cast<const boost_array_type&>(rOther))
+    {
+    }
+
+    /**
+     * Copy the elements of an array of the same shape.
+     *
+     * @param rOther the array to copy
+     * @return this array
+     */
+    multi_array& operator=(const multi_array& rOther)
+    {
+        boost_array_type::operator=(static_cast<const boost_array_type&>(rOther));
+        return *this;
+    }
+
+    /**
+     * Copy the elements of any array, view or reference of the same shape.
+     *
+     * @param rOther the array to copy
+     * @return this array
+     */
+    template<typename ConstMultiArray>
+    multi_array& operator=(const ConstMultiArray& rOther)
+    {
+        boost_array_type::operator=(rOther);
+        return *this;
+    }
+};
+
 #endif /*IMMERSEDBOUNDARYARRAY_HPP_*/
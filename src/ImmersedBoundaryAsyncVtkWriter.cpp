@@ -0,0 +1,256 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "ImmersedBoundaryAsyncVtkWriter.hpp"
+#include <sstream>
+#include "Exception.hpp"
+#include "ImmersedBoundaryMeshWriter.hpp"
+#include "ImmersedBoundaryTracer.hpp"
+
+template<unsigned DIM>
+ImmersedBoundaryAsyncVtkWriter<DIM>::ImmersedBoundaryAsyncVtkWriter(const std::string& rDirectory,
+                                                                    unsigned maxQueueDepth,
+                                                                    bool writeRawBinaryVtk,
+                                                                    bool compressVtk)
+    : mDirectory(rDirectory),
+      mMaxQueueDepth(maxQueueDepth),
+      mWriteRawBinaryVtk(writeRawBinaryVtk),
+      mCompressVtk(compressVtk),
+      mIsWriting(false),
+      mStopRequested(false),
+      mNumSnapshotsWritten(0)
+{
+    assert(mMaxQueueDepth > 0);
+
+    pthread_mutex_init(&mMutex, NULL);
+    pthread_cond_init(&mCondition, NULL);
+    if (pthread_create(&mThread, NULL, ThreadFunction, this) != 0)
+    {
+        pthread_cond_destroy(&mCondition);
+        pthread_mutex_destroy(&mMutex);
+        EXCEPTION("Could not start the VTK output thread");
+    }
+}
+
+template<unsigned DIM>
+ImmersedBoundaryAsyncVtkWriter<DIM>::~ImmersedBoundaryAsyncVtkWriter()
+{
+    pthread_mutex_lock(&mMutex);
+    mStopRequested = true;
+    pthread_cond_broadcast(&mCondition);
+    pthread_mutex_unlock(&mMutex);
+
+    // The thread writes everything still waiting before it finishes
+    pthread_join(mThread, NULL);
+    pthread_cond_destroy(&mCondition);
+    pthread_mutex_destroy(&mMutex);
+
+    for (unsigned i = 0; i < mSnapshots.size(); i++)
+    {
+        delete mSnapshots[i];
+    }
+}
+
+template<unsigned DIM>
+void* ImmersedBoundaryAsyncVtkWriter<DIM>::ThreadFunction(void* pWriter)
+{
+    static_cast<ImmersedBoundaryAsyncVtkWriter<DIM>*>(pWriter)->Run();
+    return NULL;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryAsyncVtkWriter<DIM>::Run()
+{
+    ImmersedBoundaryTracer::SetThreadName("AsyncVtkWriter");
+
+    pthread_mutex_lock(&mMutex);
+    while (true)
+    {
+        while (mPendingSnapshots.empty() && !mStopRequested)
+        {
+            pthread_cond_wait(&mCondition, &mMutex);
+        }
+        if (mPendingSnapshots.empty())
+        {
+            break;
+        }
+
+        Snapshot* p_snapshot = mPendingSnapshots.front();
+        mPendingSnapshots.pop_front();
+        mIsWriting = true;
+        pthread_mutex_unlock(&mMutex);
+
+        // Format and write the file without holding the lock, so the simulation thread can stage the next snapshot
+        std::string error_message;
+        try
+        {
+            ImmersedBoundaryTraceSpan span("WriteVtkSnapshot", "output");
+            WriteSnapshot(*p_snapshot);
+        }
+        catch (Exception& e)
+        {
+            error_message = e.GetShortMessage();
+        }
+        catch (...)
+        {
+            // Nothing may escape the thread, as that would terminate the program
+            error_message = "unexpected error while writing";
+        }
+
+        pthread_mutex_lock(&mMutex);
+        if (!error_message.empty() && mErrorMessage.empty())
+        {
+            mErrorMessage = error_message;
+        }
+        mIsWriting = false;
+        mNumSnapshotsWritten++;
+        mFreeSnapshots.push_back(p_snapshot);
+        pthread_cond_broadcast(&mCondition);
+    }
+    pthread_mutex_unlock(&mMutex);
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryAsyncVtkWriter<DIM>::WriteSnapshot(const Snapshot& rSnapshot)
+{
+    ImmersedBoundaryMeshWriter<DIM, DIM> mesh_writer(mDirectory, "results", false);
+    mesh_writer.SetWriteRawBinaryVtk(mWriteRawBinaryVtk);
+    mesh_writer.SetCompressVtk(mCompressVtk);
+
+    // Elements broken into pieces for visualisation carry their cell data on each piece
+    mesh_writer.CalculateCellOverlaps(rSnapshot);
+    mesh_writer.AddCellData(rSnapshot);
+
+    std::stringstream time;
+    time << rSnapshot.GetTimeStep();
+    mesh_writer.WriteVtkUsingSnapshot(rSnapshot, time.str());
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryAsyncVtkWriter<DIM>::CheckForError()
+{
+    if (!mErrorMessage.empty())
+    {
+        std::string message = mErrorMessage;
+        mErrorMessage.clear();
+        pthread_mutex_unlock(&mMutex);
+        EXCEPTION("Asynchronous VTK output failed: " + message);
+    }
+}
+
+template<unsigned DIM>
+ImmersedBoundaryMeshSnapshot<DIM, DIM>& ImmersedBoundaryAsyncVtkWriter<DIM>::rAcquireSnapshot()
+{
+    pthread_mutex_lock(&mMutex);
+    if (mFreeSnapshots.empty() && mSnapshots.size() < mMaxQueueDepth)
+    {
+        mSnapshots.push_back(new Snapshot);
+        mFreeSnapshots.push_back(mSnapshots.back());
+    }
+
+    // Apply backpressure: wait for the background thread to finish with a snapshot
+    while (mFreeSnapshots.empty())
+    {
+        pthread_cond_wait(&mCondition, &mMutex);
+    }
+    CheckForError();
+
+    Snapshot* p_snapshot = mFreeSnapshots.back();
+    mFreeSnapshots.pop_back();
+    pthread_mutex_unlock(&mMutex);
+
+    return *p_snapshot;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryAsyncVtkWriter<DIM>::Submit(Snapshot& rSnapshot)
+{
+    pthread_mutex_lock(&mMutex);
+    mPendingSnapshots.push_back(&rSnapshot);
+    pthread_cond_broadcast(&mCondition);
+    CheckForError();
+    pthread_mutex_unlock(&mMutex);
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryAsyncVtkWriter<DIM>::Flush()
+{
+    pthread_mutex_lock(&mMutex);
+    while (!mPendingSnapshots.empty() || mIsWriting)
+    {
+        pthread_cond_wait(&mCondition, &mMutex);
+    }
+    CheckForError();
+    pthread_mutex_unlock(&mMutex);
+}
+
+template<unsigned DIM>
+const std::string& ImmersedBoundaryAsyncVtkWriter<DIM>::rGetDirectory() const
+{
+    return mDirectory;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundaryAsyncVtkWriter<DIM>::GetMaxQueueDepth() const
+{
+    return mMaxQueueDepth;
+}
+
+template<unsigned DIM>
+bool ImmersedBoundaryAsyncVtkWriter<DIM>::GetWriteRawBinaryVtk() const
+{
+    return mWriteRawBinaryVtk;
+}
+
+template<unsigned DIM>
+bool ImmersedBoundaryAsyncVtkWriter<DIM>::GetCompressVtk() const
+{
+    return mCompressVtk;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundaryAsyncVtkWriter<DIM>::GetNumSnapshotsWritten()
+{
+    pthread_mutex_lock(&mMutex);
+    unsigned num_written = mNumSnapshotsWritten;
+    pthread_mutex_unlock(&mMutex);
+    return num_written;
+}
+
+// Explicit instantiation
+template class ImmersedBoundaryAsyncVtkWriter<1>;
+template class ImmersedBoundaryAsyncVtkWriter<2>;
+template class ImmersedBoundaryAsyncVtkWriter<3>;
@@ -0,0 +1,199 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef IMMERSEDBOUNDARYASYNCVTKWRITER_HPP_
+#define IMMERSEDBOUNDARYASYNCVTKWRITER_HPP_
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include "ImmersedBoundaryMeshSnapshot.hpp"
+
+/**
+ * A class to write VTK results files on a background thread, so that the simulation does not wait while they are
+ * formatted and written.
+ *
+ * The simulation thread acquires a staging snapshot with AcquireSnapshot(), fills it from the mesh and cells, and
+ * passes it back with Submit().  The background thread then calculates the cell overlaps, builds the VTK mesh and
+ * writes the file results_<time step>.vtu, before returning the snapshot to be reused.  At most a fixed number of
+ * snapshots exist at once (two by default, so one can be filled while the other is written); if all are in use,
+ * AcquireSnapshot() waits for the oldest to be written, which caps the memory used however far output falls behind.
+ *
+ * An exception thrown while writing is reported by the next call to AcquireSnapshot(), Submit() or Flush().  As
+ * creating output directories may need all processes to synchronise, this class is only for use in sequential runs.
+ */
+template<unsigned DIM>
+class ImmersedBoundaryAsyncVtkWriter
+{
+private:
+
+    /** The snapshot type staged by this writer. */
+    typedef ImmersedBoundaryMeshSnapshot<DIM, DIM> Snapshot;
+
+    /** The output directory, relative to where Chaste output is stored. */
+    std::string mDirectory;
+
+    /** The maximum number of snapshots, being filled, waiting or being written, at any one time. */
+    unsigned mMaxQueueDepth;
+
+    /** Whether VTK files store their data as raw binary appended after the XML. */
+    bool mWriteRawBinaryVtk;
+
+    /** Whether VTK files compress their data with zlib. */
+    bool mCompressVtk;
+
+    /** Every snapshot created by this writer, which owns them. */
+    std::vector<Snapshot*> mSnapshots;
+
+    /** Snapshots available to be filled. */
+    std::vector<Snapshot*> mFreeSnapshots;
+
+    /** Snapshots submitted and waiting to be written, oldest first. */
+    std::deque<Snapshot*> mPendingSnapshots;
+
+    /** Whether the background thread is writing a snapshot. */
+    bool mIsWriting;
+
+    /** Whether the background thread has been asked to finish. */
+    bool mStopRequested;
+
+    /** The number of snapshots written so far. */
+    unsigned mNumSnapshotsWritten;
+
+    /** The message of the first exception thrown while writing, or empty if none has been. */
+    std::string mErrorMessage;
+
+    /** The background thread. */
+    pthread_t mThread;
+
+    /** Mutex protecting all of the above, other than #mDirectory and #mMaxQueueDepth. */
+    pthread_mutex_t mMutex;
+
+    /** Condition signalled whenever a snapshot is submitted, written or the writer is stopped. */
+    pthread_cond_t mCondition;
+
+    /**
+     * The entry point of the background thread.
+     *
+     * @param pWriter pointer to the writer
+     * @return NULL
+     */
+    static void* ThreadFunction(void* pWriter);
+
+    /**
+     * Write snapshots as they are submitted, until the writer is stopped and no snapshots are waiting.
+     */
+    void Run();
+
+    /**
+     * Write a snapshot to a VTK file.  Called on the background thread.
+     *
+     * @param rSnapshot the snapshot
+     */
+    void WriteSnapshot(const Snapshot& rSnapshot);
+
+    /**
+     * Throw an exception if writing has failed.  Must be called with #mMutex locked, and unlocks it before throwing.
+     */
+    void CheckForError();
+
+    /** Disallow copying. */
+    ImmersedBoundaryAsyncVtkWriter(const ImmersedBoundaryAsyncVtkWriter&);
+
+    /**
+     * Disallow assignment.
+     *
+     * @return reference to this writer
+     */
+    ImmersedBoundaryAsyncVtkWriter& operator=(const ImmersedBoundaryAsyncVtkWriter&);
+
+public:
+
+    /**
+     * Constructor.  Starts the background thread.
+     *
+     * @param rDirectory the output directory, relative to where Chaste output is stored
+     * @param maxQueueDepth the maximum number of snapshots at any one time (defaults to 2)
+     * @param writeRawBinaryVtk whether VTK files store their data as raw binary (defaults to false)
+     * @param compressVtk whether VTK files compress their data (defaults to false)
+     */
+    ImmersedBoundaryAsyncVtkWriter(const std::string& rDirectory,
+                                   unsigned maxQueueDepth=2,
+                                   bool writeRawBinaryVtk=false,
+                                   bool compressVtk=false);
+
+    /**
+     * Destructor.  Writes any waiting snapshots and stops the background thread.
+     */
+    virtual ~ImmersedBoundaryAsyncVtkWriter();
+
+    /**
+     * Get a snapshot to fill, waiting for one to be written if all are in use.  The snapshot must be passed to Submit().
+     *
+     * @return the snapshot
+     */
+    Snapshot& rAcquireSnapshot();
+
+    /**
+     * Queue a filled snapshot to be written.
+     *
+     * @param rSnapshot the snapshot, as returned by rAcquireSnapshot()
+     */
+    void Submit(Snapshot& rSnapshot);
+
+    /**
+     * Wait until every submitted snapshot has been written.
+     */
+    void Flush();
+
+    /** @return #mDirectory */
+    const std::string& rGetDirectory() const;
+
+    /** @return #mMaxQueueDepth */
+    unsigned GetMaxQueueDepth() const;
+
+    /** @return #mWriteRawBinaryVtk */
+    bool GetWriteRawBinaryVtk() const;
+
+    /** @return #mCompressVtk */
+    bool GetCompressVtk() const;
+
+    /** @return the number of snapshots written so far */
+    unsigned GetNumSnapshotsWritten();
+};
+
+#endif /*IMMERSEDBOUNDARYASYNCVTKWRITER_HPP_*/
@@ -0,0 +1,116 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryBlockAverageReducer.hpp"
+#include "Exception.hpp"
+
+#include <algorithm>
+
+ImmersedBoundaryBlockAverageReducer::ImmersedBoundaryBlockAverageReducer(unsigned blockSize, const std::string& rFileName)
+    : AbstractImmersedBoundaryFluidReducer(rFileName),
+      mBlockSize(blockSize)
+{
+    if (blockSize == 0)
+    {
+        EXCEPTION("The block size must be positive");
+    }
+}
+
+void ImmersedBoundaryBlockAverageReducer::StartStreaming()
+{
+    if (mNumGridPtsX % mBlockSize != 0 || mNumGridPtsY % mBlockSize != 0)
+    {
+        EXCEPTION("The block size must divide the number of grid points in each direction");
+    }
+    mBlockSums.resize(2 * (mNumGridPtsX / mBlockSize) * (mNumGridPtsY / mBlockSize));
+
+    std::vector<std::string> headers;
+    headers.push_back("step");
+    headers.push_back("block_x");
+    headers.push_back("block_y");
+    headers.push_back("time");
+    headers.push_back("velocity_x");
+    headers.push_back("velocity_y");
+    mWriter.AddHeaders(headers);
+
+    mWriter.StartStreaming(3, 3, 0, 100, mBinaryOutput);
+}
+
+void ImmersedBoundaryBlockAverageReducer::Reduce(unsigned step, double time, const multi_array<double, 3>& rVelocityGrids)
+{
+    assert(rVelocityGrids.shape()[1] == mNumGridPtsX && rVelocityGrids.shape()[2] == mNumGridPtsY);
+
+    unsigned num_blocks_x = mNumGridPtsX / mBlockSize;
+    unsigned num_blocks_y = mNumGridPtsY / mBlockSize;
+    unsigned num_blocks = num_blocks_x * num_blocks_y;
+
+    // Sum each block in a single pass over the grids, in memory order
+    std::fill(mBlockSums.begin(), mBlockSums.end(), 0.0);
+    for (unsigned dim = 0; dim < 2; dim++)
+    {
+        for (unsigned x = 0; x < mNumGridPtsX; x++)
+        {
+            double* p_sums = &mBlockSums[dim * num_blocks + (x / mBlockSize) * num_blocks_y];
+            for (unsigned y = 0; y < mNumGridPtsY; y++)
+            {
+                p_sums[y / mBlockSize] += rVelocityGrids[dim][x][y];
+            }
+        }
+    }
+
+    const double recip_block_area = 1.0 / (mBlockSize * mBlockSize);
+    std::vector<unsigned> unsigned_values(3);
+    std::vector<double> double_values(3);
+    unsigned_values[0] = step;
+    double_values[0] = time;
+
+    for (unsigned block_x = 0; block_x < num_blocks_x; block_x++)
+    {
+        for (unsigned block_y = 0; block_y < num_blocks_y; block_y++)
+        {
+            unsigned block = block_x * num_blocks_y + block_y;
+            unsigned_values[1] = block_x;
+            unsigned_values[2] = block_y;
+            double_values[1] = mBlockSums[block] * recip_block_area;
+            double_values[2] = mBlockSums[num_blocks + block] * recip_block_area;
+            mWriter.AppendRow(unsigned_values, double_values);
+        }
+    }
+}
+
+unsigned ImmersedBoundaryBlockAverageReducer::GetBlockSize() const
+{
+    return mBlockSize;
+}
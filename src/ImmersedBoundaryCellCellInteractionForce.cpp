@@ -33,6 +33,13 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 */
 
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "ImmersedBoundaryCellCellInteractionForce.hpp"
 #include "ImmersedBoundaryElement.hpp"
 
@@ -42,7 +49,12 @@ ImmersedBoundaryCellCellInteractionForce<DIM>::ImmersedBoundaryCellCellInteracti
           mpMesh(NULL),
           mSpringConst(1e3),
           mRestLength(DOUBLE_UNSET),
-          mNumProteins(3)
+          mNumProteins(3),
+          mNumPairListBuildsAtLastCache(UINT_MAX),
+          mCachedIntrinsicSpacing(DOUBLE_UNSET),
+          mPairConstantsAreStale(true),
+          mNumThreads(1u),
+          mDeterministicReduction(false)
 {
 }
 
@@ -52,8 +64,9 @@ ImmersedBoundaryCellCellInteractionForce<DIM>::~ImmersedBoundaryCellCellInteract
 }
 
 template<unsigned DIM>
-void ImmersedBoundaryCellCellInteractionForce<DIM>::AddImmersedBoundaryForceContribution(std::vector<std::pair<Node<DIM>*, Node<DIM>*> >& rNodePairs,
-        ImmersedBoundaryCellPopulation<DIM>& rCellPopulation)
+void ImmersedBoundaryCellCellInteractionForce<DIM>::AddForceContributionsToNodeArrays(const ImmersedBoundaryNodePairList<DIM>& rNodePairs,
+                                                                                      ImmersedBoundaryNodeArrays<DIM>& rNodeArrays,
+                                                                                      ImmersedBoundaryCellPopulation<DIM>& rCellPopulation)
 {
     /*
      * This force class calculates the force between pairs of nodes in different immersed boundaries.  Each node must
@@ -96,96 +109,386 @@ void ImmersedBoundaryCellCellInteractionForce<DIM>::AddImmersedBoundaryForceCont
 
         // Initialize protein levels
         InitializeProteinLevels();
+
+        /*
+         * The node attributes have changed, so their mirror in the node arrays is extended in place.  Rebuilding the
+         * arrays instead would discard the forces added to them by any force calculated before this one.
+         */
+        unsigned num_attributes = num_node_attributes + mNumProteins;
+        rNodeArrays.SetNumAttributes(num_attributes);
+        for (unsigned slot = 0; slot < rNodeArrays.GetNumSlots(); slot++)
+        {
+            const std::vector<double>& r_attributes = mpMesh->GetNode(rNodeArrays.GetNodeIndex(slot))->rGetNodeAttributes();
+            std::copy(r_attributes.begin(), r_attributes.begin() + num_attributes, rNodeArrays.GetAttributes(slot));
+        }
     }
 
     UpdateProteinLevels();
+    UpdatePairConstants(rNodePairs, rNodeArrays, rCellPopulation);
 
-    // Helper variables for loop
-    unsigned e_cad_idx = mProteinNodeAttributeLocations[0];
-    unsigned p_cad_idx = mProteinNodeAttributeLocations[1];
-    unsigned integrin_idx = mProteinNodeAttributeLocations[2];
-
-    double normed_dist;
-    double protein_mult;
+    double interaction_distance = rCellPopulation.GetInteractionDistance();
 
-    // The spring constant will be scaled by an amount determined by the intrinsic spacing
-    double intrinsic_spacing = rCellPopulation.GetIntrinsicSpacing();
-    double node_a_elem_spacing;
-    double node_b_elem_spacing;
-    double elem_spacing;
+    // If using Morse potential, this can be pre-calculated
+    double well_width = 0.25 * interaction_distance;
 
-    // The effective spring constant will be a scaled version of mSpringConst
-    double effective_spring_const;
+    const int num_pairs = (int) rNodePairs.GetNumPairs();
 
-    c_vector<double, DIM> vector_between_nodes;
-    c_vector<double, DIM> force_a_to_b;
-    c_vector<double, DIM> force_b_to_a;
+#ifdef _OPENMP
+    const unsigned num_threads = mNumThreads;
+#else
+    const unsigned num_threads = 1;
+#endif
 
-    Node<DIM>* p_node_a;
-    Node<DIM>* p_node_b;
+    if (num_threads == 1)
+    {
+        // Loop over all pairs of nodes that might be interacting; the pair list only contains pairs in different cells
+        double force[DIM];
+        for (int pair = 0; pair < num_pairs; pair++)
+        {
+            const typename ImmersedBoundaryNodePairList<DIM>::NodePair& r_pair = rNodePairs.rGetPair(pair);
+            const PairConstants& r_constants = mPairConstants[pair];
 
-    // If using Morse potential, this can be pre-calculated
-    double well_width = 0.25 * rCellPopulation.GetInteractionDistance();
+            unsigned slot_a = rNodeArrays.GetSlotOfNode(r_pair.mNodeA);
+            unsigned slot_b = rNodeArrays.GetSlotOfNode(r_pair.mNodeB);
 
-    // Loop over all pairs of nodes that might be interacting
-    for (unsigned pair = 0; pair < rNodePairs.size(); pair++)
+            if (CalculatePairForce(rNodeArrays, slot_a, slot_b, r_constants.mStrength, interaction_distance, well_width, force))
+            {
+                double* p_force_a = rNodeArrays.GetAppliedForce(slot_a);
+                double* p_force_b = rNodeArrays.GetAppliedForce(slot_b);
+                for (unsigned dim = 0; dim < DIM; dim++)
+                {
+                    p_force_a[dim] += force[dim] * r_constants.mScaleA;
+                    p_force_b[dim] -= force[dim] * r_constants.mScaleB;
+                }
+            }
+        }
+    }
+    else if (mDeterministicReduction)
+    {
+        AddForceContributionsDeterministically(rNodePairs, rNodeArrays, interaction_distance, well_width);
+    }
+    else
     {
         /*
-         * Interactions only occur between different cells.  Since each node is only ever in a single cell, we can test
-         * equality of the first ContainingElement.
+         * Each pair adds to the forces on both its nodes, so on several threads each accumulates into its own buffer,
+         * and the buffers are then summed in thread order.  The pairs are divided statically between threads, so the
+         * force is the same on each run with the same number of threads.
          */
-        if ( *(rNodePairs[pair].first->ContainingElementsBegin()) !=
-             *(rNodePairs[pair].second->ContainingElementsBegin()) )
+        const unsigned num_values = DIM * rNodeArrays.GetNumSlots();
+        mThreadForces.resize(num_threads);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(num_threads)
+#endif
         {
-            p_node_a = rNodePairs[pair].first;
-            p_node_b = rNodePairs[pair].second;
+            // The team may have fewer threads than requested, in which case only its buffers are used
+#ifdef _OPENMP
+            const unsigned team_size = omp_get_num_threads();
+            std::vector<double>& r_thread_forces = mThreadForces[omp_get_thread_num()];
+#else
+            const unsigned team_size = 1;
+            std::vector<double>& r_thread_forces = mThreadForces[0];
+#endif
+            r_thread_forces.assign(num_values, 0.0);
+
+            double force[DIM];
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (int pair = 0; pair < num_pairs; pair++)
+            {
+                const typename ImmersedBoundaryNodePairList<DIM>::NodePair& r_pair = rNodePairs.rGetPair(pair);
+                const PairConstants& r_constants = mPairConstants[pair];
 
-            std::vector<double>& r_a_attribs = p_node_a->rGetNodeAttributes();
-            std::vector<double>& r_b_attribs = p_node_b->rGetNodeAttributes();
+                unsigned slot_a = rNodeArrays.GetSlotOfNode(r_pair.mNodeA);
+                unsigned slot_b = rNodeArrays.GetSlotOfNode(r_pair.mNodeB);
 
-            vector_between_nodes = mpMesh->GetVectorFromAtoB(p_node_a->rGetLocation(), p_node_b->rGetLocation());
-            normed_dist = norm_2(vector_between_nodes);
+                if (CalculatePairForce(rNodeArrays, slot_a, slot_b, r_constants.mStrength, interaction_distance, well_width, force))
+                {
+                    for (unsigned dim = 0; dim < DIM; dim++)
+                    {
+                        r_thread_forces[DIM * slot_a + dim] += force[dim] * r_constants.mScaleA;
+                        r_thread_forces[DIM * slot_b + dim] -= force[dim] * r_constants.mScaleB;
+                    }
+                }
+            }
 
-            if (normed_dist < rCellPopulation.GetInteractionDistance())
+            // Sum the buffers; the implicit barrier above ensures every buffer is complete
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (int slot = 0; slot < (int) rNodeArrays.GetNumSlots(); slot++)
             {
-                // Get the element spacing for each of the nodes concerned and calculate the effective spring constant
-                node_a_elem_spacing = mpMesh->GetAverageNodeSpacingOfElement(*(p_node_a->rGetContainingElementIndices().begin()), false);
-                node_b_elem_spacing = mpMesh->GetAverageNodeSpacingOfElement(*(p_node_b->rGetContainingElementIndices().begin()), false);
-                elem_spacing = 0.5 * (node_a_elem_spacing + node_b_elem_spacing);
+                double* p_applied_force = rNodeArrays.GetAppliedForce(slot);
+                for (unsigned thread = 0; thread < team_size; thread++)
+                {
+                    for (unsigned dim = 0; dim < DIM; dim++)
+                    {
+                        p_applied_force[dim] += mThreadForces[thread][DIM * slot + dim];
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellCellInteractionForce<DIM>::AddForceContributionsDeterministically(const ImmersedBoundaryNodePairList<DIM>& rNodePairs,
+                                                                                          ImmersedBoundaryNodeArrays<DIM>& rNodeArrays,
+                                                                                          double interactionDistance,
+                                                                                          double wellWidth)
+{
+    const int num_pairs = (int) rNodePairs.GetNumPairs();
+    const int num_slots = (int) rNodeArrays.GetNumSlots();
+
+    /*
+     * Sort the contributions of the pairs by slot with a counting sort, which keeps them in pair order within each
+     * slot.  Summing them in that order then performs exactly the additions made on one thread.
+     */
+    mSlotContributionOffsets.assign(num_slots + 1, 0u);
+    for (int pair = 0; pair < num_pairs; pair++)
+    {
+        const typename ImmersedBoundaryNodePairList<DIM>::NodePair& r_pair = rNodePairs.rGetPair(pair);
+        mSlotContributionOffsets[rNodeArrays.GetSlotOfNode(r_pair.mNodeA) + 1]++;
+        mSlotContributionOffsets[rNodeArrays.GetSlotOfNode(r_pair.mNodeB) + 1]++;
+    }
+    for (int slot = 0; slot < num_slots; slot++)
+    {
+        mSlotContributionOffsets[slot + 1] += mSlotContributionOffsets[slot];
+    }
+
+    mSlotContributions.resize(2 * num_pairs);
+    std::vector<unsigned> next_position(mSlotContributionOffsets.begin(), mSlotContributionOffsets.end() - 1);
+    for (int pair = 0; pair < num_pairs; pair++)
+    {
+        const typename ImmersedBoundaryNodePairList<DIM>::NodePair& r_pair = rNodePairs.rGetPair(pair);
+        mSlotContributions[next_position[rNodeArrays.GetSlotOfNode(r_pair.mNodeA)]++] = 2 * pair;
+        mSlotContributions[next_position[rNodeArrays.GetSlotOfNode(r_pair.mNodeB)]++] = 2 * pair + 1;
+    }
 
-                effective_spring_const = mSpringConst * elem_spacing / intrinsic_spacing;
+    mPairForces.resize(DIM * num_pairs);
+    mPairInteracts.resize(num_pairs);
 
-                // The protein multiplier is a function of the levels of each protein in the current and comparison nodes
-                protein_mult = std::min(r_a_attribs[e_cad_idx], r_b_attribs[e_cad_idx]) +
-                               std::min(r_a_attribs[p_cad_idx], r_b_attribs[p_cad_idx]) +
-                               std::max(r_a_attribs[integrin_idx], r_b_attribs[integrin_idx]);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(mNumThreads)
+#endif
+    {
+        // Each pair force is calculated by a single thread
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (int pair = 0; pair < num_pairs; pair++)
+        {
+            const typename ImmersedBoundaryNodePairList<DIM>::NodePair& r_pair = rNodePairs.rGetPair(pair);
+            unsigned slot_a = rNodeArrays.GetSlotOfNode(r_pair.mNodeA);
+            unsigned slot_b = rNodeArrays.GetSlotOfNode(r_pair.mNodeB);
+
+            mPairInteracts[pair] = CalculatePairForce(rNodeArrays, slot_a, slot_b, mPairConstants[pair].mStrength,
+                                                      interactionDistance, wellWidth, &mPairForces[DIM * pair]);
+        }
 
-                /*
-                 * We must scale each applied force by a factor of elem_spacing / local spacing, so that forces
-                 * balance when spread to the grid later (where the multiplicative factor is the local spacing)
-                 */
+        // Each slot is then written by a single thread, adding its contributions in pair order
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (int slot = 0; slot < num_slots; slot++)
+        {
+            double* p_applied_force = rNodeArrays.GetAppliedForce(slot);
+            for (unsigned i = mSlotContributionOffsets[slot]; i < mSlotContributionOffsets[slot + 1]; i++)
+            {
+                unsigned pair = mSlotContributions[i] / 2;
+                if (!mPairInteracts[pair])
+                {
+                    continue;
+                }
 
-                if (mLinearSpring)
+                const double* p_force = &mPairForces[DIM * pair];
+                if (mSlotContributions[i] % 2 == 0)
                 {
-                    vector_between_nodes *=
-                            effective_spring_const * protein_mult * (normed_dist - mRestLength) / normed_dist;
+                    for (unsigned dim = 0; dim < DIM; dim++)
+                    {
+                        p_applied_force[dim] += p_force[dim] * mPairConstants[pair].mScaleA;
+                    }
                 }
-                else // Morse potential
+                else
                 {
-                    double morse_exp = exp((mRestLength - normed_dist) / well_width);
-                    vector_between_nodes *= 2.0 * well_width * effective_spring_const * protein_mult * morse_exp *
-                                            (1.0 - morse_exp) / normed_dist;
-
+                    for (unsigned dim = 0; dim < DIM; dim++)
+                    {
+                        p_applied_force[dim] -= p_force[dim] * mPairConstants[pair].mScaleB;
+                    }
                 }
+            }
+        }
+    }
+}
 
-                force_a_to_b = vector_between_nodes * elem_spacing / node_a_elem_spacing;
-                p_node_a->AddAppliedForceContribution(force_a_to_b);
+template<unsigned DIM>
+void ImmersedBoundaryCellCellInteractionForce<DIM>::AddImmersedBoundaryForceContribution(const ImmersedBoundaryNodePairList<DIM>& rNodePairs,
+        ImmersedBoundaryCellPopulation<DIM>& rCellPopulation)
+{
+    AddForceContributionsToNodeArrays(rNodePairs, rCellPopulation.rGetMesh().rGetNodeArrays(), rCellPopulation);
+}
 
-                force_b_to_a = -1.0 * vector_between_nodes * elem_spacing / node_b_elem_spacing;
-                p_node_b->AddAppliedForceContribution(force_b_to_a);
-            }
+template<unsigned DIM>
+void ImmersedBoundaryCellCellInteractionForce<DIM>::AddImmersedBoundaryForceContribution(std::vector<std::pair<Node<DIM>*, Node<DIM>*> >& rNodePairs,
+        ImmersedBoundaryCellPopulation<DIM>& rCellPopulation)
+{
+    ImmersedBoundaryNodePairList<DIM> node_pairs(rCellPopulation.GetInteractionDistance());
+    this->ConvertNodePairs(rNodePairs, rCellPopulation, node_pairs);
+
+    // The constants cached for each pair are keyed on the list they were calculated for, which this is not
+    mPairConstantsAreStale = true;
+    AddImmersedBoundaryForceContribution(node_pairs, rCellPopulation);
+}
+
+template<unsigned DIM>
+bool ImmersedBoundaryCellCellInteractionForce<DIM>::CalculatePairForce(const ImmersedBoundaryNodeArrays<DIM>& rArrays,
+                                                                       unsigned slotA,
+                                                                       unsigned slotB,
+                                                                       double strength,
+                                                                       double interactionDistance,
+                                                                       double wellWidth,
+                                                                       double* pForce) const
+{
+    assert(slotA != UINT_MAX && slotB != UINT_MAX);
+    assert(rArrays.GetElementIndex(slotA) != rArrays.GetElementIndex(slotB));
+
+    rArrays.GetVectorFromAtoB(slotA, slotB, pForce);
+
+    double normed_dist_squared = 0.0;
+    for (unsigned dim = 0; dim < DIM; dim++)
+    {
+        normed_dist_squared += pForce[dim] * pForce[dim];
+    }
+
+    if (normed_dist_squared >= interactionDistance * interactionDistance)
+    {
+        return false;
+    }
+
+    double normed_dist = sqrt(normed_dist_squared);
+
+    double scale;
+    if (mLinearSpring)
+    {
+        scale = strength * (normed_dist - mRestLength) / normed_dist;
+    }
+    else // Morse potential
+    {
+        double morse_exp = exp((mRestLength - normed_dist) / wellWidth);
+        scale = 2.0 * wellWidth * strength * morse_exp * (1.0 - morse_exp) / normed_dist;
+    }
+
+    for (unsigned dim = 0; dim < DIM; dim++)
+    {
+        pForce[dim] *= scale;
+    }
+    return true;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellCellInteractionForce<DIM>::UpdatePairConstants(const ImmersedBoundaryNodePairList<DIM>& rNodePairs,
+                                                                        const ImmersedBoundaryNodeArrays<DIM>& rNodeArrays,
+                                                                        ImmersedBoundaryCellPopulation<DIM>& rCellPopulation)
+{
+    // The spring constant will be scaled by an amount determined by the intrinsic spacing
+    double intrinsic_spacing = rCellPopulation.GetIntrinsicSpacing();
+
+    bool stale = mPairConstantsAreStale ||
+                 rNodePairs.GetNumBuilds() != mNumPairListBuildsAtLastCache ||
+                 rNodePairs.GetNumPairs() != mPairConstants.size() ||
+                 intrinsic_spacing != mCachedIntrinsicSpacing;
+
+    // Element spacings change when elements divide, or are remeshed
+    unsigned num_elements = mpMesh->GetNumAllElements();
+    if (mElementSpacings.size() != num_elements)
+    {
+        mElementSpacings.assign(num_elements, DOUBLE_UNSET);
+        stale = true;
+    }
+
+    for (typename ImmersedBoundaryMesh<DIM, DIM>::ImmersedBoundaryElementIterator elem_it = mpMesh->GetElementIteratorBegin();
+         elem_it != mpMesh->GetElementIteratorEnd();
+         ++elem_it)
+    {
+        double spacing = mpMesh->GetAverageNodeSpacingOfElement(elem_it->GetIndex(), false);
+        if (spacing != mElementSpacings[elem_it->GetIndex()])
+        {
+            mElementSpacings[elem_it->GetIndex()] = spacing;
+            stale = true;
         }
     }
+
+    if (!stale)
+    {
+        return;
+    }
+
+    unsigned e_cad_idx = mProteinNodeAttributeLocations[0];
+    unsigned p_cad_idx = mProteinNodeAttributeLocations[1];
+    unsigned integrin_idx = mProteinNodeAttributeLocations[2];
+
+    mPairConstants.resize(rNodePairs.GetNumPairs());
+    for (unsigned pair = 0; pair < rNodePairs.GetNumPairs(); pair++)
+    {
+        const typename ImmersedBoundaryNodePairList<DIM>::NodePair& r_pair = rNodePairs.rGetPair(pair);
+
+        unsigned slot_a = rNodeArrays.GetSlotOfNode(r_pair.mNodeA);
+        unsigned slot_b = rNodeArrays.GetSlotOfNode(r_pair.mNodeB);
+        assert(slot_a != UINT_MAX && slot_b != UINT_MAX);
+
+        // Get the element spacing for each of the nodes concerned and calculate the effective spring constant
+        double node_a_elem_spacing = mElementSpacings[rNodeArrays.GetElementIndex(slot_a)];
+        double node_b_elem_spacing = mElementSpacings[rNodeArrays.GetElementIndex(slot_b)];
+        double elem_spacing = 0.5 * (node_a_elem_spacing + node_b_elem_spacing);
+
+        double effective_spring_const = mSpringConst * elem_spacing / intrinsic_spacing;
+
+        // The protein multiplier is a function of the levels of each protein in the current and comparison nodes
+        const double* p_a_attribs = rNodeArrays.GetAttributes(slot_a);
+        const double* p_b_attribs = rNodeArrays.GetAttributes(slot_b);
+        double protein_mult = std::min(p_a_attribs[e_cad_idx], p_b_attribs[e_cad_idx]) +
+                              std::min(p_a_attribs[p_cad_idx], p_b_attribs[p_cad_idx]) +
+                              std::max(p_a_attribs[integrin_idx], p_b_attribs[integrin_idx]);
+
+        /*
+         * We must scale each applied force by a factor of elem_spacing / local spacing, so that forces
+         * balance when spread to the grid later (where the multiplicative factor is the local spacing)
+         */
+        mPairConstants[pair].mStrength = effective_spring_const * protein_mult;
+        mPairConstants[pair].mScaleA = elem_spacing / node_a_elem_spacing;
+        mPairConstants[pair].mScaleB = elem_spacing / node_b_elem_spacing;
+    }
+
+    mNumPairListBuildsAtLastCache = rNodePairs.GetNumBuilds();
+    mCachedIntrinsicSpacing = intrinsic_spacing;
+    mPairConstantsAreStale = false;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellCellInteractionForce<DIM>::SetNumThreads(unsigned numThreads)
+{
+    assert(numThreads > 0);
+    mNumThreads = numThreads;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundaryCellCellInteractionForce<DIM>::GetNumThreads()
+{
+    return mNumThreads;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellCellInteractionForce<DIM>::SetDeterministicReduction(bool deterministicReduction)
+{
+    mDeterministicReduction = deterministicReduction;
+}
+
+template<unsigned DIM>
+bool ImmersedBoundaryCellCellInteractionForce<DIM>::GetDeterministicReduction()
+{
+    return mDeterministicReduction;
 }
 
 template<unsigned DIM>
@@ -239,6 +542,7 @@ template<unsigned DIM>
 void ImmersedBoundaryCellCellInteractionForce<DIM>::SetSpringConstant(double springConst)
 {
     mSpringConst = springConst;
+    mPairConstantsAreStale = true;
 }
 
 template<unsigned DIM>
@@ -298,6 +602,12 @@ void ImmersedBoundaryCellCellInteractionForce<DIM>::OutputImmersedBoundaryForceP
     AbstractImmersedBoundaryForce<DIM>::OutputImmersedBoundaryForceParameters(rParamsFile);
 }
 
+template<unsigned DIM>
+bool ImmersedBoundaryCellCellInteractionForce<DIM>::UsesNodeArrays() const
+{
+    return true;
+}
+
 // Explicit instantiation
 template class ImmersedBoundaryCellCellInteractionForce<1>;
 template class ImmersedBoundaryCellCellInteractionForce<2>;
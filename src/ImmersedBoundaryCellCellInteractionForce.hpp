@@ -104,6 +104,119 @@ protected:
     /** A vector storing in which position of the node attributes vector each protein is represented. */
     std::vector<unsigned> mProteinNodeAttributeLocations;
 
+    /**
+     * The quantities used in calculating the force between a pair of nodes that change only when the pair list is
+     * rebuilt, or element spacings or parameters change.
+     */
+    struct PairConstants
+    {
+        /** The effective spring constant multiplied by the protein multiplier. */
+        double mStrength;
+
+        /** The factor by which the force on the first node is scaled, to balance when spread to the grid. */
+        double mScaleA;
+
+        /** The factor by which the force on the second node is scaled, to balance when spread to the grid. */
+        double mScaleB;
+    };
+
+    /** The constants for each pair in the node pair list, in the same order. */
+    std::vector<PairConstants> mPairConstants;
+
+    /** The number of builds of the node pair list when #mPairConstants was last calculated. */
+    unsigned mNumPairListBuildsAtLastCache;
+
+    /** The average node spacing of each element when #mPairConstants was last calculated. */
+    std::vector<double> mElementSpacings;
+
+    /** The intrinsic spacing of the cell population when #mPairConstants was last calculated. */
+    double mCachedIntrinsicSpacing;
+
+    /** Whether #mPairConstants must be recalculated, for instance because the spring constant has changed. */
+    bool mPairConstantsAreStale;
+
+    /**
+     * The number of threads used to calculate the force.
+     *
+     * Initialised to 1 in the constructor.
+     */
+    unsigned mNumThreads;
+
+    /** A force buffer for each thread, DIM values per slot, used when running on several threads. */
+    std::vector<std::vector<double> > mThreadForces;
+
+    /**
+     * Whether, on several threads, the force on each node is summed in the same order as on one thread, so that the
+     * force is identical for any number of threads.
+     *
+     * Initialised to false in the constructor.
+     */
+    bool mDeterministicReduction;
+
+    /** The force of each interacting pair, DIM values per pair, used by the deterministic reduction. */
+    std::vector<double> mPairForces;
+
+    /** Whether each pair is interacting, used by the deterministic reduction. */
+    std::vector<unsigned char> mPairInteracts;
+
+    /** Offsets into #mSlotContributions of the pair contributions to each slot, with a final entry of their number. */
+    std::vector<unsigned> mSlotContributionOffsets;
+
+    /**
+     * The pair contributions to each slot in pair order, each stored as twice the pair index, plus one if the slot is
+     * the pair's second node.
+     */
+    std::vector<unsigned> mSlotContributions;
+
+    /**
+     * Add the force contributions on several threads, summing the contributions to each node in pair order.
+     *
+     * @param rNodePairs the node pair list
+     * @param rNodeArrays the node arrays of the mesh
+     * @param interactionDistance the interaction distance of the cell population
+     * @param wellWidth the width of the Morse potential well
+     */
+    void AddForceContributionsDeterministically(const ImmersedBoundaryNodePairList<DIM>& rNodePairs,
+                                                ImmersedBoundaryNodeArrays<DIM>& rNodeArrays,
+                                                double interactionDistance,
+                                                double wellWidth);
+
+    /**
+     * Recalculate #mPairConstants if the pair list has been rebuilt, the average node spacing of any element has
+     * changed, or the parameters have changed, since it was last calculated.
+     *
+     * The protein multiplier is included in the cached constants, as protein levels do not change during a
+     * simulation; see UpdateProteinLevels().
+     *
+     * @param rNodePairs the node pairs
+     * @param rNodeArrays the mesh's node arrays
+     * @param rCellPopulation the cell population
+     */
+    void UpdatePairConstants(const ImmersedBoundaryNodePairList<DIM>& rNodePairs,
+                             const ImmersedBoundaryNodeArrays<DIM>& rNodeArrays,
+                             ImmersedBoundaryCellPopulation<DIM>& rCellPopulation);
+
+    /**
+     * Calculate the force between a pair of nodes, before scaling by PairConstants::mScaleA and
+     * PairConstants::mScaleB.
+     *
+     * @param rArrays the node arrays of the mesh
+     * @param slotA the slot of the first node
+     * @param slotB the slot of the second node
+     * @param strength the constant PairConstants::mStrength of the pair
+     * @param interactionDistance the distance beyond which nodes do not interact
+     * @param wellWidth the width of the Morse potential well
+     * @param pForce filled with the force on the first node, DIM values
+     * @return whether the nodes are close enough to interact; if not, pForce is not meaningful
+     */
+    bool CalculatePairForce(const ImmersedBoundaryNodeArrays<DIM>& rArrays,
+                            unsigned slotA,
+                            unsigned slotB,
+                            double strength,
+                            double interactionDistance,
+                            double wellWidth,
+                            double* pForce) const;
+
 public:
 
     /**
@@ -117,16 +230,75 @@ public:
     virtual ~ImmersedBoundaryCellCellInteractionForce();
 
     /**
-     * Overridden AddImmersedBoundaryForceContribution() method.
+     * Overridden AddForceContributionsToNodeArrays() method.
      *
      * Calculates the force on each node in the immersed boundary cell population as a result of cell-cell interactions.
      *
+     * @param rNodePairs the pairs of nodes in different elements between which to contribute the force
+     * @param rNodeArrays the mesh's node arrays, to whose applied forces contributions are added
+     * @param rCellPopulation reference to the cell population
+     */
+    void AddForceContributionsToNodeArrays(const ImmersedBoundaryNodePairList<DIM>& rNodePairs,
+                                           ImmersedBoundaryNodeArrays<DIM>& rNodeArrays,
+                                           ImmersedBoundaryCellPopulation<DIM>& rCellPopulation);
+
+    /**
+     * Overridden AddImmersedBoundaryForceContribution() method.
+     *
+     * Adds the force to the mesh's node arrays, as AddForceContributionsToNodeArrays() does.
+     *
+     * @param rNodePairs the pairs of nodes in different elements between which to contribute the force
+     * @param rCellPopulation reference to the cell population
+     */
+    void AddImmersedBoundaryForceContribution(const ImmersedBoundaryNodePairList<DIM>& rNodePairs,
+            ImmersedBoundaryCellPopulation<DIM>& rCellPopulation);
+
+    /**
+     * Overridden AddImmersedBoundaryForceContribution() method.
+     *
+     * Adds the force for the given pairs of Node pointers, through the overload taking an
+     * ImmersedBoundaryNodePairList.
+     *
      * @param rNodePairs reference to a vector set of node pairs between which to contribute the force
      * @param rCellPopulation reference to the cell population
      */
     void AddImmersedBoundaryForceContribution(std::vector<std::pair<Node<DIM>*, Node<DIM>*> >& rNodePairs,
             ImmersedBoundaryCellPopulation<DIM>& rCellPopulation);
 
+    /**
+     * Overridden UsesNodeArrays() method.
+     *
+     * @return true, as this force adds its contributions to the mesh's node arrays
+     */
+    bool UsesNodeArrays() const;
+
+    /**
+     * Set #mNumThreads.  With more than one thread, the force differs from that on one thread only by rounding, unless
+     * #mDeterministicReduction is set.
+     *
+     * @param numThreads the number of threads used to calculate the force
+     */
+    void SetNumThreads(unsigned numThreads);
+
+    /**
+     * @return #mNumThreads
+     */
+    unsigned GetNumThreads();
+
+    /**
+     * Set #mDeterministicReduction.  The pair forces are then calculated on several threads as before, but each
+     * thread sums the contributions to its own nodes in pair order, exactly as on one thread.  This costs a pass to
+     * sort the pair contributions by node each time the force is calculated.
+     *
+     * @param deterministicReduction whether the force is identical for any number of threads
+     */
+    void SetDeterministicReduction(bool deterministicReduction);
+
+    /**
+     * @return #mDeterministicReduction
+     */
+    bool GetDeterministicReduction();
+
     /**
      * @return mProteinNodeAttributeLocations
      */
@@ -142,7 +314,8 @@ public:
     /**
      * Helper method for AddImmersedBoundaryForceContribution().
      *
-     * Updates the levels of each protein at each timestep.
+     * Updates the levels of each protein at each timestep.  This currently does nothing; if it is made to change
+     * protein levels, it must set #mPairConstantsAreStale.
      */
     void UpdateProteinLevels();
 
@@ -43,6 +43,9 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/multi_array.hpp>
 #include "CellPopulationElementWriter.hpp"
 #include "RandomNumberGenerator.hpp"
+#include "SimulationTime.hpp"
+#include "PetscTools.hpp"
+#include "ImmersedBoundaryTracer.hpp"
 
 template<unsigned DIM>
 ImmersedBoundaryCellPopulation<DIM>::ImmersedBoundaryCellPopulation(ImmersedBoundaryMesh<DIM, DIM>& rMesh,
@@ -78,6 +81,20 @@ ImmersedBoundaryCellPopulation<DIM>::ImmersedBoundaryCellPopulation(ImmersedBoun
     // Default active sources to false
     mPopulationHasActiveSources = false;
 
+    mUseSimulationTimeStep = false;
+    mMaxNodeSpeed = 0.0;
+    mNodeDisplacementBound = 0.0;
+    mStencilWidth = 4;
+    mNumInterpolationThreads = 1;
+    mLimitNodeDisplacements = true;
+    mUpdateNodeLocationsPhase = 0;
+    mReMeshThreshold = 1;
+    mAsyncVtkOutputQueueDepth = 0;
+    mpAsyncVtkWriter = NULL;
+    mWriteRawBinaryVtk = false;
+    mCompressVtk = false;
+    mTimeStepsElapsedOffset = 0;
+
     // Set the intrinsic spacing to a default 0.01
     //\todo should this be static?
     mIntrinsicSpacing = 0.01;
@@ -86,7 +103,20 @@ ImmersedBoundaryCellPopulation<DIM>::ImmersedBoundaryCellPopulation(ImmersedBoun
 template<unsigned DIM>
 ImmersedBoundaryCellPopulation<DIM>::ImmersedBoundaryCellPopulation(ImmersedBoundaryMesh<DIM, DIM>& rMesh)
     : AbstractOffLatticeCellPopulation<DIM>(rMesh),
-      mDeleteMesh(true)
+      mDeleteMesh(true),
+      mUseSimulationTimeStep(false),
+      mMaxNodeSpeed(0.0),
+      mNodeDisplacementBound(0.0),
+      mStencilWidth(4),
+      mNumInterpolationThreads(1),
+      mLimitNodeDisplacements(true),
+      mUpdateNodeLocationsPhase(0),
+      mReMeshThreshold(1),
+      mAsyncVtkOutputQueueDepth(0),
+      mpAsyncVtkWriter(NULL),
+      mWriteRawBinaryVtk(false),
+      mCompressVtk(false),
+      mTimeStepsElapsedOffset(0)
 {
     mpImmersedBoundaryMesh = static_cast<ImmersedBoundaryMesh<DIM, DIM>* >(&(this->mrMesh));
 }
@@ -94,6 +124,11 @@ ImmersedBoundaryCellPopulation<DIM>::ImmersedBoundaryCellPopulation(ImmersedBoun
 template<unsigned DIM>
 ImmersedBoundaryCellPopulation<DIM>::~ImmersedBoundaryCellPopulation()
 {
+    // The background writer reads only its own snapshots, so can finish after the mesh has gone
+    if (mpAsyncVtkWriter)
+    {
+        delete mpAsyncVtkWriter;
+    }
     if (mDeleteMesh)
     {
         delete &this->mrMesh;
@@ -180,6 +215,7 @@ unsigned ImmersedBoundaryCellPopulation<DIM>::AddNode(Node<DIM>* pNewNode)
 template<unsigned DIM>
 void ImmersedBoundaryCellPopulation<DIM>::SetNode(unsigned nodeIndex, ChastePoint<DIM>& rNewLocation)
 {
+    mNodeStencilCache.Invalidate();
     mpImmersedBoundaryMesh->SetNode(nodeIndex, rNewLocation);
 }
 
@@ -200,6 +236,8 @@ CellPtr ImmersedBoundaryCellPopulation<DIM>::AddCell(CellPtr pNewCell,
                                                      const c_vector<double,DIM>& rCellDivisionVector,
                                                      CellPtr pParentCell)
 {
+    ImmersedBoundaryTraceSpan span("DivideElement", "mesh");
+
     // Get the element associated with this cell
     ImmersedBoundaryElement<DIM, DIM>* p_element = GetElementCorrespondingToCell(pParentCell);
 
@@ -207,6 +245,13 @@ CellPtr ImmersedBoundaryCellPopulation<DIM>::AddCell(CellPtr pNewCell,
     unsigned new_element_index = mpImmersedBoundaryMesh->DivideElementAlongGivenAxis(p_element,
                                                                                      rCellDivisionVector,
                                                                                      true);
+    // Until the modifier next sets them, treat the membrane of the new element as that of the one it divided from
+    if (!mImplicitMembraneCoefficients.empty())
+    {
+        mImplicitMembraneCoefficients.resize(std::max(mImplicitMembraneCoefficients.size(), (size_t) new_element_index + 1), 0.0);
+        mImplicitMembraneCoefficients[new_element_index] = mImplicitMembraneCoefficients[p_element->GetIndex()];
+    }
+
     // Associate the new cell with the element
     this->mCells.push_back(pNewCell);
 
@@ -220,10 +265,11 @@ CellPtr ImmersedBoundaryCellPopulation<DIM>::AddCell(CellPtr pNewCell,
 template<unsigned DIM>
 unsigned ImmersedBoundaryCellPopulation<DIM>::RemoveDeadCells()
 {
+    ImmersedBoundaryTraceSpan span("RemoveDeadCells", "mesh");
+
     unsigned num_removed = 0;
-    //\todo: may need to implement this
 
-    /*for (std::list<CellPtr>::iterator it = this->mCells.begin();
+    for (std::list<CellPtr>::iterator it = this->mCells.begin();
          it != this->mCells.end();
          )
     {
@@ -232,201 +278,599 @@ unsigned ImmersedBoundaryCellPopulation<DIM>::RemoveDeadCells()
             // Count the cell as dead
             num_removed++;
 
-            // Remove the element from the mesh if it is not deleted yet
-            ///\todo (#2489) this should cause an error - we should fix this!
-            if (!(this->GetElement(this->GetLocationIndexUsingCell((*it)))->IsDeleted()))
+            // Mark the element as deleted; it is removed from the mesh by ReMesh()
+            unsigned elem_index = this->GetLocationIndexUsingCell(*it);
+            if (!(this->GetElement(elem_index)->IsDeleted()))
             {
-                // This warning relies on the fact that there is only one other possibility for
-                // vertex elements to be marked as deleted: a T2 swap
-                WARN_ONCE_ONLY("A Cell is removed without performing a T2 swap. This could leave a void in the mesh.");
-                mpImmersedBoundaryMesh->DeleteElementPriorToReMesh(this->GetLocationIndexUsingCell((*it)));
+                mpImmersedBoundaryMesh->DeleteElementPriorToReMesh(elem_index);
             }
 
             // Delete the cell
+            this->RemoveCellUsingLocationIndex(elem_index, *it);
             it = this->mCells.erase(it);
         }
         else
         {
             ++it;
         }
-    }*/
+    }
     return num_removed;
 }
 
 template<unsigned DIM>
 void ImmersedBoundaryCellPopulation<DIM>::UpdateNodeLocations(double dt)
 {
-    // Helper variables, pre-declared for efficiency
-    unsigned num_grid_pts_x = this->rGetMesh().GetNumGridPtsX();
-    unsigned num_grid_pts_y = this->rGetMesh().GetNumGridPtsY();
+    // If the timestep is being adapted, the simulation's fixed timestep is superseded by that of SimulationTime
+    if (mUseSimulationTimeStep)
+    {
+        dt = SimulationTime::Instance()->GetTimeStep();
+    }
 
-    double characteristic_spacing = this->rGetMesh().GetCharacteristicNodeSpacing();
-    double grid_spacing_x = 1.0 / (double)num_grid_pts_x;
-    double grid_spacing_y = 1.0 / (double)num_grid_pts_y;
+    if (mpPhaseTimer)
+    {
+        mpPhaseTimer->StartPhase(mUpdateNodeLocationsPhase);
+    }
 
-    unsigned first_idx_x;
-    unsigned first_idx_y;
+    // The stencil width is a compile-time parameter of the interpolation, so dispatch on it here
+    switch (mStencilWidth)
+    {
+        case 3:
+            UpdateNodeLocationsWithStencil<3>(dt);
+            break;
+        case 4:
+            UpdateNodeLocationsWithStencil<4>(dt);
+            break;
+        case 6:
+            UpdateNodeLocationsWithStencil<6>(dt);
+            break;
+        default:
+            NEVER_REACHED;
+    }
 
-    std::vector<unsigned> x_indices(4);
-    std::vector<unsigned> y_indices(4);
+    if (mpPhaseTimer)
+    {
+        mpPhaseTimer->StopPhase(mUpdateNodeLocationsPhase);
+    }
+}
 
-    std::vector<double> x_deltas(4);
-    std::vector<double> y_deltas(4);
+template<unsigned DIM>
+template<unsigned WIDTH>
+c_vector<double, DIM> ImmersedBoundaryCellPopulation<DIM>::InterpolateVelocity(const ImmersedBoundaryStencil<WIDTH>& rStencil)
+{
+    const multi_array<double, 3>& vel_grids = this->rGetMesh().rGet2dVelocityGrids();
 
-    double delta;
+    /*
+     * Loop over the grid points which influence the velocity at this location, weighted by the delta function.  The
+     * velocity component normal to a wall is odd about it, so takes the sign of any grid point reflected in the wall.
+     */
+    c_vector<double, DIM> velocity = zero_vector<double>(DIM);
+    for (unsigned x_idx = 0; x_idx < WIDTH; x_idx++)
+    {
+        unsigned x = rStencil.GetIndexX(x_idx);
+        for (unsigned y_idx = 0; y_idx < WIDTH; y_idx++)
+        {
+            unsigned y = rStencil.GetIndexY(y_idx);
+            double delta = rStencil.GetWeight(x_idx, y_idx);
 
-    c_vector<double, DIM> node_location;
-    c_vector<double, DIM> displacement;
+            velocity[0] += vel_grids[0][x][y] * delta * rStencil.GetSignX(x_idx);
+            velocity[1] += vel_grids[1][x][y] * delta * rStencil.GetSignY(y_idx);
+        }
+    }
 
-    // Get references to the fluid velocity grid
-    const multi_array<double, 3>& vel_grids = this->rGetMesh().rGet2dVelocityGrids();
+    return velocity;
+}
 
-    // Iterate over all nodes
-    for (typename ImmersedBoundaryMesh<DIM, DIM>::NodeIterator node_iter = this->rGetMesh().GetNodeIteratorBegin(false);
-            node_iter != this->rGetMesh().GetNodeIteratorEnd();
-            ++node_iter)
+template<unsigned DIM>
+template<unsigned WIDTH>
+void ImmersedBoundaryCellPopulation<DIM>::UpdateNodeLocationsWithStencil(double dt)
+{
+    double characteristic_spacing = this->rGetMesh().GetCharacteristicNodeSpacing();
+    unsigned num_grid_pts_x = this->rGetMesh().GetNumGridPtsX();
+    unsigned num_grid_pts_y = this->rGetMesh().GetNumGridPtsY();
+    const c_vector<double, DIM>& r_domain_size = this->rGetMesh().rGetDomainSize();
+    bool walls_x = this->rGetMesh().HasWalls(0);
+    bool walls_y = this->rGetMesh().HasWalls(1);
+
+    ImmersedBoundaryNodeArrays<DIM>& r_node_arrays = this->rGetMesh().rGetNodeArrays();
+    unsigned num_slots = r_node_arrays.GetNumSlots();
+
+    // The stencils stored, by slot, when forces were spread to the grid can be reused provided no node has moved since
+    bool use_node_cache = mNodeStencilCache.IsValid(WIDTH, num_slots);
+
+    /*
+     * Each node's new location depends only on its old location and the fluid velocity, so nodes are independent and
+     * each slot of the node arrays can be updated in place.  The nodes themselves are synchronised once every node
+     * has been interpolated.  As threads cannot safely issue warnings, limited displacements are counted and warned
+     * about afterwards.  If any membrane is treated semi-implicitly, the displacements of each element depend on one
+     * another, so all are interpolated before any node is moved.
+     */
+    double max_speed = 0.0;
+    double max_displacement = 0.0;
+    int num_limited_nodes = 0;
+
+    bool correct_displacements = !mImplicitMembraneCoefficients.empty();
+    if (correct_displacements)
     {
-        // Get location of current node
-        node_location = node_iter->rGetLocation();
+        mNodeDisplacements.resize(DIM * num_slots);
+    }
 
-        // Get first grid index in each dimension, taking account of possible wrap-around
-        first_idx_x = unsigned(floor(node_location[0] / grid_spacing_x)) + num_grid_pts_x - 1;
-        first_idx_y = unsigned(floor(node_location[1] / grid_spacing_y)) + num_grid_pts_y - 1;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(mNumInterpolationThreads) reduction(max:max_speed) reduction(max:max_displacement) reduction(+:num_limited_nodes)
+#endif
+    {
+        ImmersedBoundaryStencil<WIDTH> stencil(num_grid_pts_x, num_grid_pts_y, r_domain_size[0], r_domain_size[1], walls_x, walls_y);
 
-        // Calculate all four indices and deltas in each dimension
-        for (unsigned i = 0; i < 4; i ++)
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (int slot = 0; slot < (int) num_slots; slot++)
         {
-            x_indices[i] = (first_idx_x + i) % num_grid_pts_x;
-            y_indices[i] = (first_idx_y + i) % num_grid_pts_y;
+            double* p_location = r_node_arrays.GetLocation(slot);
+
+            // Interpolate the fluid velocity to the node
+            if (!use_node_cache || !stencil.Load(mNodeStencilCache, slot))
+            {
+                stencil.Update(p_location[0], p_location[1]);
+            }
+            c_vector<double, DIM> displacement = InterpolateVelocity(stencil);
+
+            // Record the fastest node, for use in choosing a stable timestep
+            double speed = norm_2(displacement);
+            max_speed = std::max(max_speed, speed);
+
+            // Normalise by timestep
+            displacement *= dt;
 
-            x_deltas[i] = Delta1D(fabs(x_indices[i] * grid_spacing_x - node_location[0]), grid_spacing_x);
-            y_deltas[i] = Delta1D(fabs(y_indices[i] * grid_spacing_x - node_location[1]), grid_spacing_y);
+            // With a semi-implicit membrane, nodes are moved once the displacements of their element have been corrected
+            if (correct_displacements)
+            {
+                for (unsigned i = 0; i < DIM; i++)
+                {
+                    mNodeDisplacements[DIM * slot + i] = displacement[i];
+                }
+                continue;
+            }
+
+            if (MoveNodeInSlot(r_node_arrays, slot, displacement, characteristic_spacing))
+            {
+                num_limited_nodes++;
+            }
+            max_displacement = std::max(max_displacement, norm_2(displacement));
         }
+    }
 
-        // Loop over the 4x4 grid which will influence the displacement of the current node
-        for (unsigned x_idx = 0; x_idx < 4; x_idx++)
+    if (correct_displacements)
+    {
+        CorrectDisplacementsForImplicitMembrane(r_node_arrays);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(mNumInterpolationThreads) schedule(static) reduction(max:max_displacement) reduction(+:num_limited_nodes)
+#endif
+        for (int slot = 0; slot < (int) num_slots; slot++)
         {
-            for (unsigned y_idx = 0; y_idx < 4; y_idx++)
+            c_vector<double, DIM> displacement;
+            for (unsigned i = 0; i < DIM; i++)
             {
-                // The applied velocity is weighted by the delta function
-                delta = x_deltas[x_idx] * y_deltas[y_idx];
-                displacement[0] += vel_grids[0][x_indices[x_idx]][y_indices[y_idx]] * delta;
-                displacement[1] += vel_grids[1][x_indices[x_idx]][y_indices[y_idx]] * delta;
+                displacement[i] = mNodeDisplacements[DIM * slot + i];
             }
+
+            if (MoveNodeInSlot(r_node_arrays, slot, displacement, characteristic_spacing))
+            {
+                num_limited_nodes++;
+            }
+            max_displacement = std::max(max_displacement, norm_2(displacement));
         }
+    }
+
+    // Move the nodes
+    this->rGetMesh().SynchroniseNodeLocations();
 
-        // Normalise by timestep
-        displacement *= dt;
+    mMaxNodeSpeed = max_speed;
+    mNodeDisplacementBound += max_displacement;
 
-        //If the displacement is too big, warn the user once and scale it back
-        if (norm_2(displacement) > characteristic_spacing)
+    // The Warnings singleton is not thread safe, and the members of an ensemble move their nodes concurrently
+    if (num_limited_nodes > 0)
+    {
+#ifdef _OPENMP
+#pragma omp critical(ImmersedBoundaryWarnings)
+#endif
         {
             WARN_ONCE_ONLY("Nodes are moving more than half the CharacteristicNodeSpacing. This could cause elements to become inverted so the motion has been restricted. Use a smaller timestep to avoid these warnings.");
-            displacement *= characteristic_spacing / norm_2(displacement);
         }
+    }
+
+    // If active sources, we need to update those location as well
+    if (this->DoesPopulationHaveActiveSources())
+    {
+        ImmersedBoundaryFluidSourceRegistry<DIM>& r_registry = this->rGetMesh().rGetFluidSourceRegistry();
+        unsigned num_sources = r_registry.GetNumSources();
 
-        // Get new node location
-        node_location += displacement;
+        bool use_source_cache = mSourceStencilCache.IsValid(WIDTH, num_sources);
+        int num_limited_sources = 0;
 
-        // Account for periodic boundary
-        for (unsigned i = 0; i < DIM; i++)
+        // Iterate over all sources and update their locations; each source has its own location, so no buffer is needed
+#ifdef _OPENMP
+#pragma omp parallel num_threads(mNumInterpolationThreads) reduction(+:num_limited_sources)
+#endif
         {
-            node_location[i] = fmod(node_location[i] + 1.0, 1.0);
+            ImmersedBoundaryStencil<WIDTH> stencil(num_grid_pts_x, num_grid_pts_y, r_domain_size[0], r_domain_size[1], walls_x, walls_y);
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (int source_idx = 0; source_idx < (int) num_sources; source_idx++)
+            {
+                double* p_location = r_registry.GetLocation(source_idx);
+
+                // Interpolate the fluid velocity to the source, and normalise by timestep
+                if (!use_source_cache || !stencil.Load(mSourceStencilCache, source_idx))
+                {
+                    stencil.Update(p_location[0], p_location[1]);
+                }
+                c_vector<double, DIM> displacement = InterpolateVelocity(stencil);
+                displacement *= dt;
+
+                // If the displacement is too big, scale it back
+                if (mLimitNodeDisplacements && norm_2(displacement) > characteristic_spacing)
+                {
+                    num_limited_sources++;
+                    displacement *= characteristic_spacing / norm_2(displacement);
+                }
+
+                // Move the source, accounting for periodic boundary or walls, in both the registry and the source itself
+                c_vector<double, DIM>& r_location = r_registry.GetSource(source_idx)->rGetModifiableLocation();
+                for (unsigned i = 0; i < DIM; i++)
+                {
+                    if (this->rGetMesh().HasWalls(i))
+                    {
+                        p_location[i] = std::min(std::max(p_location[i] + displacement[i], 0.0), r_domain_size[i]);
+                    }
+                    else
+                    {
+                        p_location[i] = fmod(p_location[i] + displacement[i] + r_domain_size[i], r_domain_size[i]);
+                    }
+                    r_location[i] = p_location[i];
+                }
+            }
         }
 
-        // Create ChastePoint for new node location
-        ChastePoint <DIM> new_point(node_location);
+        if (num_limited_sources > 0)
+        {
+#ifdef _OPENMP
+#pragma omp critical(ImmersedBoundaryWarnings)
+#endif
+            {
+                WARN_ONCE_ONLY("Sources are moving more than half the CharacteristicNodeSpacing. This could cause elements to become inverted so the motion has been restricted. Use a smaller timestep to avoid these warnings.");
+            }
+        }
+    }
+
+    // Everything has moved, so the stored stencils are out of date
+    mNodeStencilCache.Invalidate();
+    mSourceStencilCache.Invalidate();
+}
+
+template<unsigned DIM>
+bool ImmersedBoundaryCellPopulation<DIM>::MoveNodeInSlot(ImmersedBoundaryNodeArrays<DIM>& rNodeArrays,
+                                                         unsigned slot,
+                                                         c_vector<double, DIM>& rDisplacement,
+                                                         double characteristicSpacing)
+{
+    const c_vector<double, DIM>& r_domain_size = this->rGetMesh().rGetDomainSize();
 
-        // Move the node
-        this->SetNode(node_iter->GetIndex(), new_point);
+    // If the displacement is too big, scale it back
+    bool limited = false;
+    double length = norm_2(rDisplacement);
+    if (mLimitNodeDisplacements && length > characteristicSpacing)
+    {
+        limited = true;
+        rDisplacement *= characteristicSpacing / length;
     }
 
-    // If active sources, we need to update those location as well
-    if (this->DoesPopulationHaveActiveSources())
+    // Get new node location, accounting for periodic boundary or, between walls, keeping the node in the domain
+    double* p_location = rNodeArrays.GetLocation(slot);
+    for (unsigned i = 0; i < DIM; i++)
     {
-        std::vector<FluidSource<DIM> *> &r_element_sources = this->rGetMesh().rGetElementFluidSources();
-        std::vector<FluidSource<DIM> *> &r_balance_sources = this->rGetMesh().rGetBalancingFluidSources();
+        double new_location = p_location[i] + rDisplacement[i];
+        if (this->rGetMesh().HasWalls(i))
+        {
+            p_location[i] = std::min(std::max(new_location, 0.0), r_domain_size[i]);
+        }
+        else
+        {
+            if (new_location < 0.0 || new_location >= r_domain_size[i])
+            {
+                this->rGetMesh().rGetModifiablePeriodicOverlaps().MarkElementStale(rNodeArrays.GetElementIndex(slot));
+            }
+            p_location[i] = fmod(new_location + r_domain_size[i], r_domain_size[i]);
+        }
+    }
 
-        // Construct a vector of all sources combined
-        std::vector<FluidSource<DIM> *> combined_sources;
-        combined_sources.insert(combined_sources.end(), r_element_sources.begin(), r_element_sources.end());
-        combined_sources.insert(combined_sources.end(), r_balance_sources.begin(), r_balance_sources.end());
+    return limited;
+}
 
-        c_vector<double, DIM> source_location;
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::CorrectDisplacementsForImplicitMembrane(const ImmersedBoundaryNodeArrays<DIM>& rNodeArrays)
+{
+    // Only elements whose membrane is treated semi-implicitly, and which have enough nodes to bend, are corrected
+    std::vector<unsigned> elements;
+    unsigned num_elements = std::min((unsigned) mImplicitMembraneCoefficients.size(), rNodeArrays.GetNumElements());
+    for (unsigned elem_idx = 0; elem_idx < num_elements; elem_idx++)
+    {
+        if (mImplicitMembraneCoefficients[elem_idx] > 0.0 &&
+            rNodeArrays.GetElementEnd(elem_idx) >= rNodeArrays.GetElementBegin(elem_idx) + 3)
+        {
+            elements.push_back(elem_idx);
+        }
+    }
 
-        // Iterate over all sources and update their locations
-        for (unsigned source_idx = 0; source_idx < combined_sources.size(); source_idx++)
+    /*
+     * Each element's displacements solve a cyclic tridiagonal system with constant coefficients, (1 + 2a) on the
+     * diagonal and -a off it, for each dimension.  The corner entries are removed by the Sherman-Morrison formula:
+     * the system is A = B + u v^T, with u = (g, 0, ..., 0, -a), v = (1, 0, ..., 0, -a/g) and g = -(1 + 2a), so the
+     * solution is x = y - (v.y) / (1 + v.z) z, where B y = d and B z = u are solved by the Thomas algorithm.  The
+     * elimination depends only on a and the number of nodes, so it is shared by the dimensions.  Each element is
+     * independent, and its displacements are written by a single thread.
+     */
+#ifdef _OPENMP
+#pragma omp parallel num_threads(mNumInterpolationThreads)
+#endif
+    {
+        std::vector<double> upper;
+        std::vector<double> inverse_pivots;
+        std::vector<double> z;
+        std::vector<double> y;
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+        for (int i = 0; i < (int) elements.size(); i++)
         {
-            // Get location of current node
-            source_location = combined_sources[source_idx]->rGetLocation();
+            unsigned elem_idx = elements[i];
+            unsigned first_slot = rNodeArrays.GetElementBegin(elem_idx);
+            unsigned num_nodes = rNodeArrays.GetElementEnd(elem_idx) - first_slot;
 
-            // Get first grid index in each dimension, taking account of possible wrap-around
-            first_idx_x = unsigned(floor(source_location[0] / grid_spacing_x)) + num_grid_pts_x - 1;
-            first_idx_y = unsigned(floor(source_location[1] / grid_spacing_y)) + num_grid_pts_y - 1;
+            double a = mImplicitMembraneCoefficients[elem_idx];
+            double b = 1.0 + 2.0 * a;
+            double g = -b;
 
-            // Calculate all four indices and deltas in each dimension
-            for (unsigned i = 0; i < 4; i ++)
+            upper.resize(num_nodes);
+            inverse_pivots.resize(num_nodes);
+            z.resize(num_nodes);
+            y.resize(num_nodes);
+
+            // Eliminate below the diagonal of B, whose first and last diagonal entries are modified
+            for (unsigned node = 0; node < num_nodes; node++)
             {
-                x_indices[i] = (first_idx_x + i) % num_grid_pts_x;
-                y_indices[i] = (first_idx_y + i) % num_grid_pts_y;
+                double diagonal = node == 0 ? b - g : (node == num_nodes - 1 ? b - a * a / g : b);
+                double pivot = node == 0 ? diagonal : diagonal + a * upper[node - 1];
+                inverse_pivots[node] = 1.0 / pivot;
+                upper[node] = -a * inverse_pivots[node];
+            }
 
-                x_deltas[i] = Delta1D(fabs(x_indices[i] * grid_spacing_x - source_location[0]), grid_spacing_x);
-                y_deltas[i] = Delta1D(fabs(y_indices[i] * grid_spacing_x - source_location[1]), grid_spacing_y);
+            // Solve B z = u
+            for (unsigned node = 0; node < num_nodes; node++)
+            {
+                double rhs = node == 0 ? g : (node == num_nodes - 1 ? -a : 0.0);
+                z[node] = (rhs + (node == 0 ? 0.0 : a * z[node - 1])) * inverse_pivots[node];
+            }
+            for (unsigned node = num_nodes - 1; node-- > 0; )
+            {
+                z[node] -= upper[node] * z[node + 1];
             }
+            double v_dot_z = z[0] - a / g * z[num_nodes - 1];
 
-            // Loop over the 4x4 grid which will influence the displacement of the current node
-            for (unsigned x_idx = 0; x_idx < 4; x_idx++)
+            for (unsigned dim = 0; dim < DIM; dim++)
             {
-                for (unsigned y_idx = 0; y_idx < 4; y_idx++)
+                // Solve B y = d
+                for (unsigned node = 0; node < num_nodes; node++)
                 {
-                    // The applied velocity is weighted by the delta function
-                    delta = x_deltas[x_idx] * y_deltas[y_idx];
-                    displacement[0] += vel_grids[0][x_indices[x_idx]][y_indices[y_idx]] * delta;
-                    displacement[1] += vel_grids[1][x_indices[x_idx]][y_indices[y_idx]] * delta;
+                    double rhs = mNodeDisplacements[DIM * (first_slot + node) + dim];
+                    y[node] = (rhs + (node == 0 ? 0.0 : a * y[node - 1])) * inverse_pivots[node];
+                }
+                for (unsigned node = num_nodes - 1; node-- > 0; )
+                {
+                    y[node] -= upper[node] * y[node + 1];
+                }
+
+                double factor = (y[0] - a / g * y[num_nodes - 1]) / (1.0 + v_dot_z);
+                for (unsigned node = 0; node < num_nodes; node++)
+                {
+                    mNodeDisplacements[DIM * (first_slot + node) + dim] = y[node] - factor * z[node];
                 }
             }
+        }
+    }
+}
 
-            // Normalise by timestep
-            displacement *= dt;
+template<unsigned DIM>
+bool ImmersedBoundaryCellPopulation<DIM>::IsCellAssociatedWithADeletedLocation(CellPtr pCell)
+{
+    return GetElementCorrespondingToCell(pCell)->IsDeleted();;
+}
 
-            //If the displacement is too big, warn the user once and scale it back
-            if (norm_2(displacement) > characteristic_spacing)
-            {
-                WARN_ONCE_ONLY("Sources are moving more than half the CharacteristicNodeSpacing. This could cause elements to become inverted so the motion has been restricted. Use a smaller timestep to avoid these warnings.");
-                displacement *= characteristic_spacing / norm_2(displacement);
-            }
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::Update(bool hasHadBirthsOrDeaths)
+{
+    ImmersedBoundaryTraceSpan span("UpdateCellPopulation", "mesh");
 
-            // Get new node location
-            source_location += displacement;
+    // Once enough cells have died, remove their elements so that the mesh has no holes
+    if (mReMeshThreshold > 0 && mpImmersedBoundaryMesh->GetNumDeletedElements() >= mReMeshThreshold)
+    {
+        ReMesh();
+    }
 
-            // Account for periodic boundary
-            for (unsigned i = 0; i < DIM; i++)
-            {
-                source_location[i] = fmod(source_location[i] + 1.0, 1.0);
-            }
+    // Births and deaths change the nodes and sources, so any stored stencils can no longer be trusted
+    if (hasHadBirthsOrDeaths)
+    {
+        mNodeStencilCache.Invalidate();
+        mSourceStencilCache.Invalidate();
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::ReorderAlongSpaceFillingCurve(bool useHilbertCurve)
+{
+    ImmersedBoundaryTraceSpan span("ReorderAlongSpaceFillingCurve", "mesh");
+
+    ImmersedBoundarySpaceFillingCurve curve(useHilbertCurve);
+    std::vector<unsigned> new_element_indices = mpImmersedBoundaryMesh->ReorderAlongSpaceFillingCurve(curve);
+    UpdateCellLocationsAfterRenumbering(new_element_indices);
+    RenumberImplicitMembraneCoefficients(new_element_indices);
+
+    // The node arrays are rebuilt in a new order, so any stored stencils no longer correspond to their slots
+    mNodeStencilCache.Invalidate();
+    mSourceStencilCache.Invalidate();
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::UpdateCellLocationsAfterRenumbering(const std::vector<unsigned>& rNewElementIndices)
+{
+    // Record the new location of each cell, then rebuild the maps between cells and locations
+    std::vector<std::pair<CellPtr, unsigned> > new_locations;
+    for (typename AbstractCellPopulation<DIM>::Iterator cell_iter = this->Begin();
+         cell_iter != this->End();
+         ++cell_iter)
+    {
+        unsigned old_index = this->GetLocationIndexUsingCell(*cell_iter);
+        assert(rNewElementIndices[old_index] != UINT_MAX);
+        new_locations.push_back(std::make_pair(*cell_iter, rNewElementIndices[old_index]));
+    }
+
+    this->mLocationCellMap.clear();
+    this->mCellLocationMap.clear();
+    for (unsigned i = 0; i < new_locations.size(); i++)
+    {
+        this->AddCellUsingLocationIndex(new_locations[i].second, new_locations[i].first);
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::RenumberImplicitMembraneCoefficients(const std::vector<unsigned>& rNewElementIndices)
+{
+    if (mImplicitMembraneCoefficients.empty())
+    {
+        return;
+    }
 
-            // Move the node
-            combined_sources[source_idx]->rGetModifiableLocation() = source_location;
+    std::vector<double> new_coefficients(mpImmersedBoundaryMesh->GetNumAllElements(), 0.0);
+    for (unsigned old_index = 0; old_index < rNewElementIndices.size(); old_index++)
+    {
+        unsigned new_index = rNewElementIndices[old_index];
+        if (new_index != UINT_MAX && old_index < mImplicitMembraneCoefficients.size())
+        {
+            new_coefficients[new_index] = mImplicitMembraneCoefficients[old_index];
         }
     }
+    mImplicitMembraneCoefficients.swap(new_coefficients);
 }
 
 template<unsigned DIM>
-double ImmersedBoundaryCellPopulation<DIM>::Delta1D(double dist, double spacing)
+void ImmersedBoundaryCellPopulation<DIM>::ReMesh()
 {
-    return (0.25 * (1.0 + cos(M_PI * dist / (2 * spacing))));
+    ImmersedBoundaryTraceSpan span("ReMesh", "mesh");
+
+    std::vector<unsigned> new_element_indices = mpImmersedBoundaryMesh->ReMesh();
+    UpdateCellLocationsAfterRenumbering(new_element_indices);
+    RenumberImplicitMembraneCoefficients(new_element_indices);
+
+    // The node arrays and fluid source registry are rebuilt without the removed nodes and sources
+    mNodeStencilCache.Invalidate();
+    mSourceStencilCache.Invalidate();
 }
 
 template<unsigned DIM>
-bool ImmersedBoundaryCellPopulation<DIM>::IsCellAssociatedWithADeletedLocation(CellPtr pCell)
+void ImmersedBoundaryCellPopulation<DIM>::SetReMeshThreshold(unsigned reMeshThreshold)
 {
-    return GetElementCorrespondingToCell(pCell)->IsDeleted();;
+    mReMeshThreshold = reMeshThreshold;
 }
 
 template<unsigned DIM>
-void ImmersedBoundaryCellPopulation<DIM>::Update(bool hasHadBirthsOrDeaths)
+unsigned ImmersedBoundaryCellPopulation<DIM>::GetReMeshThreshold()
+{
+    return mReMeshThreshold;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::SetAsyncVtkOutputQueueDepth(unsigned asyncVtkOutputQueueDepth)
 {
-    // I don't think this is needed for IB
+    mAsyncVtkOutputQueueDepth = asyncVtkOutputQueueDepth;
+
+    // A writer with a different depth is replaced when next needed
+    if (mpAsyncVtkWriter && mpAsyncVtkWriter->GetMaxQueueDepth() != mAsyncVtkOutputQueueDepth)
+    {
+        delete mpAsyncVtkWriter;
+        mpAsyncVtkWriter = NULL;
+    }
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundaryCellPopulation<DIM>::GetAsyncVtkOutputQueueDepth()
+{
+    return mAsyncVtkOutputQueueDepth;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::SetWriteRawBinaryVtk(bool writeRawBinaryVtk)
+{
+    mWriteRawBinaryVtk = writeRawBinaryVtk;
+}
+
+template<unsigned DIM>
+bool ImmersedBoundaryCellPopulation<DIM>::GetWriteRawBinaryVtk()
+{
+    return mWriteRawBinaryVtk;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::SetCompressVtk(bool compressVtk)
+{
+    mCompressVtk = compressVtk;
+}
+
+template<unsigned DIM>
+bool ImmersedBoundaryCellPopulation<DIM>::GetCompressVtk()
+{
+    return mCompressVtk;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::SetTimeStepsElapsedOffset(unsigned timeStepsElapsedOffset)
+{
+    mTimeStepsElapsedOffset = timeStepsElapsedOffset;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundaryCellPopulation<DIM>::GetTimeStepsElapsedOffset()
+{
+    return mTimeStepsElapsedOffset;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::FlushVtkOutput()
+{
+    if (mpAsyncVtkWriter)
+    {
+        mpAsyncVtkWriter->Flush();
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::CloseWritersFiles()
+{
+    FlushVtkOutput();
+    AbstractCellPopulation<DIM>::CloseWritersFiles();
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::RemeshElements(double targetNodeSpacing)
+{
+    ImmersedBoundaryTraceSpan span("RemeshElements", "mesh");
+
+    mpImmersedBoundaryMesh->RemeshElements(targetNodeSpacing);
+
+    // The nodes have moved and the node arrays are rebuilt, so any stored stencils are no longer valid
+    mNodeStencilCache.Invalidate();
 }
 
 template<unsigned DIM>
@@ -444,6 +888,12 @@ void ImmersedBoundaryCellPopulation<DIM>::Validate()
 
     for (unsigned i=0; i<validated_element.size(); i++)
     {
+        // Elements of dead cells have no cell until they are removed by ReMesh()
+        if (validated_element[i] == 0 && this->GetElement(i)->IsDeleted())
+        {
+            continue;
+        }
+
         if (validated_element[i] == 0)
         {
             EXCEPTION("At time " << SimulationTime::Instance()->GetTime() <<", Element " << i << " does not appear to have a cell associated with it");
@@ -513,94 +963,108 @@ double ImmersedBoundaryCellPopulation<DIM>::GetVolumeOfCell(CellPtr pCell)
 template<unsigned DIM>
 void ImmersedBoundaryCellPopulation<DIM>::WriteVtkResultsToFile(const std::string& rDirectory)
 {
-//#ifdef CHASTE_VTK
-    // Create mesh writer for VTK output
-    ImmersedBoundaryMeshWriter<DIM, DIM> mesh_writer(rDirectory, "results", false);
+    ImmersedBoundaryTraceSpan span("WriteVtkResultsToFile", "output");
 
-    // Calculated the cell overlap information, and get the number of cell parts needed for each element
-    mesh_writer.CalculateCellOverlaps(*mpImmersedBoundaryMesh);
-    std::vector<unsigned> num_cell_parts = mesh_writer.rGetNumCellParts();
+//#ifdef CHASTE_VTK
+    unsigned num_timesteps = mTimeStepsElapsedOffset + SimulationTime::Instance()->GetTimeStepsElapsed();
 
-    // Iterate over any cell writers that are present
-    for (typename std::vector<boost::shared_ptr<AbstractCellWriter<DIM, DIM> > >::iterator cell_writer_iter = this->mCellWriters.begin();
-         cell_writer_iter != this->mCellWriters.end();
-         ++cell_writer_iter)
+    // Stage the output for the background writer if there is one, and otherwise write it now
+    if (mAsyncVtkOutputQueueDepth > 0 && !PetscTools::IsParallel())
     {
-        // Create vector to store VTK cell data
-        std::vector<double> vtk_cell_data;
-
-        // Iterate over vertex elements ///\todo #2512 - replace with loop over cells
-        for (typename ImmersedBoundaryMesh<DIM,DIM>::ImmersedBoundaryElementIterator elem_iter = mpImmersedBoundaryMesh->GetElementIteratorBegin();
-             elem_iter != mpImmersedBoundaryMesh->GetElementIteratorEnd();
-             ++elem_iter)
+        // A writer for a different directory or format is replaced
+        if (mpAsyncVtkWriter && (mpAsyncVtkWriter->rGetDirectory() != rDirectory
+                                 || mpAsyncVtkWriter->GetWriteRawBinaryVtk() != mWriteRawBinaryVtk
+                                 || mpAsyncVtkWriter->GetCompressVtk() != mCompressVtk))
         {
-            // Get index of this element in the vertex mesh
-            unsigned elem_index = elem_iter->GetIndex();
-
-            // Get the cell corresponding to this element
-            CellPtr p_cell = this->GetCellUsingLocationIndex(elem_index);
-            assert(p_cell);
-
-            // Populate the vector of VTK cell data.  We loop over the number of output cells as this takes into
-            // account that some elements will be broken into pieces for visualisation
-            for (unsigned cell_part = 0; cell_part < num_cell_parts[elem_index]; cell_part++)
-            {
-                vtk_cell_data.push_back((*cell_writer_iter)->GetCellDataForVtkOutput(p_cell, this));
-            }
+            delete mpAsyncVtkWriter;
+            mpAsyncVtkWriter = NULL;
+        }
+        if (!mpAsyncVtkWriter)
+        {
+            mpAsyncVtkWriter = new ImmersedBoundaryAsyncVtkWriter<DIM>(rDirectory,
+                                                                       mAsyncVtkOutputQueueDepth,
+                                                                       mWriteRawBinaryVtk,
+                                                                       mCompressVtk);
         }
 
-        mesh_writer.AddCellData((*cell_writer_iter)->GetVtkCellDataName(), vtk_cell_data);
+        // Waits while the background writer has a full queue, which shows as an output stall when tracing
+        ImmersedBoundaryMeshSnapshot<DIM, DIM>* p_snapshot;
+        {
+            ImmersedBoundaryTraceSpan acquire_span("AcquireVtkSnapshot", "output");
+            p_snapshot = &(mpAsyncVtkWriter->rAcquireSnapshot());
+        }
+        ImmersedBoundaryMeshSnapshot<DIM, DIM>& r_snapshot = *p_snapshot;
+        TakeOutputSnapshot(r_snapshot, num_timesteps);
+        mpAsyncVtkWriter->Submit(r_snapshot);
+    }
+    else
+    {
+        this->WriteVtkResultsToFileNow(rDirectory, num_timesteps);
     }
 
-    // When outputting any CellData, we assume that the first cell is representative of all cells
-    unsigned num_cell_data_items = this->Begin()->GetCellData()->GetNumItems();
-    std::vector<std::string> cell_data_names = this->Begin()->GetCellData()->GetKeys();
+    *(this->mpVtkMetaFile) << "        <DataSet timestep=\"";
+    *(this->mpVtkMetaFile) << num_timesteps;
+    *(this->mpVtkMetaFile) << "\" group=\"\" part=\"0\" file=\"results_";
+    *(this->mpVtkMetaFile) << num_timesteps;
+    *(this->mpVtkMetaFile) << ".vtu\"/>\n";
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::TakeOutputSnapshot(ImmersedBoundaryMeshSnapshot<DIM, DIM>& rSnapshot,
+                                                             unsigned timeStep)
+{
+    rSnapshot.TakeFromMesh(*mpImmersedBoundaryMesh, timeStep);
 
-    std::vector<std::vector<double> > cell_data;
-    for (unsigned var=0; var<num_cell_data_items; var++)
+    // The cell writers come first, then any CellData, for which we assume that the first cell is representative
+    std::vector<std::string> names;
+    for (typename std::vector<boost::shared_ptr<AbstractCellWriter<DIM, DIM> > >::iterator cell_writer_iter = this->mCellWriters.begin();
+         cell_writer_iter != this->mCellWriters.end();
+         ++cell_writer_iter)
     {
-        std::vector<double> cell_data_var;
-        cell_data.push_back(cell_data_var);
+        names.push_back((*cell_writer_iter)->GetVtkCellDataName());
     }
+    unsigned num_writers = names.size();
 
-    // Loop over vertex elements ///\todo #2512 - replace with loop over cells
-    for (typename ImmersedBoundaryMesh<DIM,DIM>::ImmersedBoundaryElementIterator elem_iter = mpImmersedBoundaryMesh->GetElementIteratorBegin();
-         elem_iter != mpImmersedBoundaryMesh->GetElementIteratorEnd();
-         ++elem_iter)
-    {
-        // Get index of this element in the vertex mesh
-        unsigned elem_index = elem_iter->GetIndex();
+    std::vector<std::string> cell_data_names = this->Begin()->GetCellData()->GetKeys();
+    names.insert(names.end(), cell_data_names.begin(), cell_data_names.end());
+    rSnapshot.SetCellDataNames(names);
 
-        // Get the cell corresponding to this element
-        CellPtr p_cell = this->GetCellUsingLocationIndex(elem_index);
+    // Each cell is looked up once, and its values written straight into their columns
+    for (unsigned local_idx = 0; local_idx < rSnapshot.GetNumElements(); local_idx++)
+    {
+        CellPtr p_cell = this->GetCellUsingLocationIndex(rSnapshot.GetElementIndex(local_idx));
         assert(p_cell);
+        rSnapshot.SetCellId(local_idx, p_cell->GetCellId());
 
-        for (unsigned var=0; var<num_cell_data_items; var++)
+        for (unsigned writer = 0; writer < num_writers; writer++)
         {
-            // Populate the vector of VTK cell data.  We loop over the number of output cells as this takes into
-            // account that some elements will be broken into pieces for visualisation
-            for (unsigned cell_part = 0; cell_part < num_cell_parts[elem_index]; cell_part++)
-            {
-                cell_data[var].push_back(p_cell->GetCellData()->GetItem(cell_data_names[var]));
-            }
+            rSnapshot.GetCellData(writer)[local_idx] = this->mCellWriters[writer]->GetCellDataForVtkOutput(p_cell, this);
+        }
+
+        for (unsigned var = 0; var < cell_data_names.size(); var++)
+        {
+            rSnapshot.GetCellData(num_writers + var)[local_idx] = p_cell->GetCellData()->GetItem(cell_data_names[var]);
         }
     }
-    for (unsigned var=0; var<num_cell_data_items; var++)
-    {
-        mesh_writer.AddCellData(cell_data_names[var], cell_data[var]);
-    }
+}
 
-    unsigned num_timesteps = SimulationTime::Instance()->GetTimeStepsElapsed();
-    std::stringstream time;
-    time << num_timesteps;
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::WriteVtkResultsToFileNow(const std::string& rDirectory, unsigned numTimesteps)
+{
+    // Create mesh writer for VTK output
+    ImmersedBoundaryMeshWriter<DIM, DIM> mesh_writer(rDirectory, "results", false);
+    mesh_writer.SetWriteRawBinaryVtk(mWriteRawBinaryVtk);
+    mesh_writer.SetCompressVtk(mCompressVtk);
 
-    mesh_writer.WriteVtkUsingMesh(*mpImmersedBoundaryMesh, time.str());
+    // Elements broken into pieces for visualisation carry their cell data on each piece
+    TakeOutputSnapshot(mOutputSnapshot, numTimesteps);
+    mesh_writer.CalculateCellOverlaps(mOutputSnapshot);
+    mesh_writer.AddCellData(mOutputSnapshot);
 
-    *(this->mpVtkMetaFile) << "        <DataSet timestep=\"";
-    *(this->mpVtkMetaFile) << num_timesteps;
-    *(this->mpVtkMetaFile) << "\" group=\"\" part=\"0\" file=\"results_";
-    *(this->mpVtkMetaFile) << num_timesteps;
-    *(this->mpVtkMetaFile) << ".vtu\"/>\n";
+    std::stringstream time;
+    time << numTimesteps;
+
+    mesh_writer.WriteVtkUsingSnapshot(mOutputSnapshot, time.str());
 //#endif //CHASTE_VTK
 }
 
@@ -663,6 +1127,117 @@ bool ImmersedBoundaryCellPopulation<DIM>::DoesPopulationHaveActiveSources()
     return mPopulationHasActiveSources;
 }
 
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::SetUseSimulationTimeStep(bool useSimulationTimeStep)
+{
+    mUseSimulationTimeStep = useSimulationTimeStep;
+}
+
+template<unsigned DIM>
+bool ImmersedBoundaryCellPopulation<DIM>::GetUseSimulationTimeStep()
+{
+    return mUseSimulationTimeStep;
+}
+
+template<unsigned DIM>
+double ImmersedBoundaryCellPopulation<DIM>::GetMaxNodeSpeed()
+{
+    return mMaxNodeSpeed;
+}
+
+template<unsigned DIM>
+double ImmersedBoundaryCellPopulation<DIM>::GetNodeDisplacementBound()
+{
+    return mNodeDisplacementBound;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::ResetNodeDisplacementBound()
+{
+    mNodeDisplacementBound = 0.0;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::SetNodeDisplacementBound(double nodeDisplacementBound)
+{
+    mNodeDisplacementBound = nodeDisplacementBound;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::SetStencilWidth(unsigned stencilWidth)
+{
+    if (stencilWidth != 3 && stencilWidth != 4 && stencilWidth != 6)
+    {
+        EXCEPTION("The delta function stencil width must be 3, 4 or 6");
+    }
+    mStencilWidth = stencilWidth;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundaryCellPopulation<DIM>::GetStencilWidth()
+{
+    return mStencilWidth;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::SetNumInterpolationThreads(unsigned numInterpolationThreads)
+{
+    assert(numInterpolationThreads > 0);
+    mNumInterpolationThreads = numInterpolationThreads;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundaryCellPopulation<DIM>::GetNumInterpolationThreads()
+{
+    return mNumInterpolationThreads;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::SetPhaseTimer(boost::shared_ptr<ImmersedBoundaryPhaseTimer> pPhaseTimer)
+{
+    mpPhaseTimer = pPhaseTimer;
+    if (mpPhaseTimer)
+    {
+        mUpdateNodeLocationsPhase = mpPhaseTimer->AddPhase("UpdateNodeLocations");
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::SetLimitNodeDisplacements(bool limitNodeDisplacements)
+{
+    mLimitNodeDisplacements = limitNodeDisplacements;
+}
+
+template<unsigned DIM>
+bool ImmersedBoundaryCellPopulation<DIM>::GetLimitNodeDisplacements()
+{
+    return mLimitNodeDisplacements;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCellPopulation<DIM>::SetImplicitMembraneCoefficients(const std::vector<double>& rImplicitMembraneCoefficients)
+{
+    mImplicitMembraneCoefficients = rImplicitMembraneCoefficients;
+}
+
+template<unsigned DIM>
+const std::vector<double>& ImmersedBoundaryCellPopulation<DIM>::rGetImplicitMembraneCoefficients() const
+{
+    return mImplicitMembraneCoefficients;
+}
+
+template<unsigned DIM>
+ImmersedBoundaryStencilCache& ImmersedBoundaryCellPopulation<DIM>::rGetNodeStencilCache()
+{
+    return mNodeStencilCache;
+}
+
+template<unsigned DIM>
+ImmersedBoundaryStencilCache& ImmersedBoundaryCellPopulation<DIM>::rGetSourceStencilCache()
+{
+    return mSourceStencilCache;
+}
+
 template<unsigned DIM>
 void ImmersedBoundaryCellPopulation<DIM>::SetIfPopulationHasActiveSources(bool hasActiveSources)
 {
@@ -38,10 +38,14 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "AbstractOffLatticeCellPopulation.hpp"
 #include "ImmersedBoundaryMesh.hpp"
+#include "ImmersedBoundaryStencil.hpp"
+#include "ImmersedBoundaryPhaseTimer.hpp"
+#include "ImmersedBoundaryAsyncVtkWriter.hpp"
 #include "AbstractVertexBasedDivisionRule.hpp"
 
 #include "ChasteSerialization.hpp"
 #include <boost/serialization/base_object.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/serialization/set.hpp>
 #include <boost/serialization/vector.hpp>
 
@@ -93,6 +97,139 @@ private:
     /** Whether the simulation has active fluid sources */
     bool mPopulationHasActiveSources;
 
+    /**
+     * Whether UpdateNodeLocations() uses the SimulationTime timestep in place of the timestep passed in.  This is set
+     * by ImmersedBoundarySimulationModifier when it adapts the timestep during a simulation.
+     */
+    bool mUseSimulationTimeStep;
+
+    /** The largest fluid velocity magnitude interpolated to a node during the last call to UpdateNodeLocations(). */
+    double mMaxNodeSpeed;
+
+    /**
+     * An upper bound on how far any node has moved since ResetNodeDisplacementBound() was last called: the sum over
+     * calls to UpdateNodeLocations() of the largest displacement of any node.  This is used to decide when neighbour
+     * lists built with a skin must be rebuilt.
+     */
+    double mNodeDisplacementBound;
+
+    /**
+     * The width, in grid points, of the delta function stencil used to couple nodes and fluid sources to the fluid
+     * grid.  ImmersedBoundarySimulationModifier uses the same width when spreading to the grid.
+     *
+     * Initialised to 4 in the constructor.
+     */
+    unsigned mStencilWidth;
+
+    /**
+     * Stencils of the nodes, indexed by slot in the mesh's node arrays.  These are stored by ImmersedBoundarySimulationModifier when
+     * spreading forces to the fluid grid, and reused by UpdateNodeLocations() as the nodes have not moved since.
+     */
+    ImmersedBoundaryStencilCache mNodeStencilCache;
+
+    /**
+     * Stencils of the fluid sources, indexed by slot in the mesh's fluid source registry.
+     * These are stored and reused in the same way as #mNodeStencilCache.
+     */
+    ImmersedBoundaryStencilCache mSourceStencilCache;
+
+    /**
+     * The number of threads used to interpolate the fluid velocity and move nodes and sources in
+     * UpdateNodeLocations().  This has an effect only when built with OpenMP.
+     *
+     * Initialised to 1 in the constructor.
+     */
+    unsigned mNumInterpolationThreads;
+
+    /**
+     * Whether UpdateNodeLocations() limits each displacement to the characteristic node spacing.  This check may be
+     * turned off when the timestep is chosen to satisfy a CFL condition, which already bounds the displacements.
+     *
+     * Initialised to true in the constructor.
+     */
+    bool mLimitNodeDisplacements;
+
+    /**
+     * The timer in which UpdateNodeLocations() records its wall time, if any.  This is set by
+     * ImmersedBoundarySimulationModifier, with which ownership of the timer is shared, so it stays valid whichever of
+     * the two is destroyed first.
+     */
+    boost::shared_ptr<ImmersedBoundaryPhaseTimer> mpPhaseTimer;
+
+    /** The phase of #mpPhaseTimer timing UpdateNodeLocations(). */
+    unsigned mUpdateNodeLocationsPhase;
+
+    /**
+     * The number of elements deleted by RemoveDeadCells() at which Update() calls ReMesh() to remove them.  A value
+     * of zero means the mesh is never compacted automatically.
+     *
+     * Initialised to 1 in the constructor.
+     */
+    unsigned mReMeshThreshold;
+
+    /**
+     * The maximum number of VTK results snapshots staged for writing on a background thread.  A value of zero means
+     * VTK results are written synchronously, as they are in parallel runs whatever the value.
+     *
+     * Initialised to 0 in the constructor.
+     */
+    unsigned mAsyncVtkOutputQueueDepth;
+
+    /** The background VTK writer, created by WriteVtkResultsToFile() if #mAsyncVtkOutputQueueDepth is nonzero. */
+    ImmersedBoundaryAsyncVtkWriter<DIM>* mpAsyncVtkWriter;
+
+    /** The snapshot from which VTK results are written synchronously, reused each output step. */
+    ImmersedBoundaryMeshSnapshot<DIM, DIM> mOutputSnapshot;
+
+    /**
+     * Whether VTK results store their data as raw binary appended after the XML.
+     *
+     * Initialised to false in the constructor.
+     */
+    bool mWriteRawBinaryVtk;
+
+    /**
+     * Whether VTK results compress their data with zlib.
+     *
+     * Initialised to false in the constructor.
+     */
+    bool mCompressVtk;
+
+    /**
+     * The number of timesteps elapsed before SimulationTime last restarted its count, as set by
+     * ImmersedBoundarySimulationModifier when it changes the timestep.  VTK results are numbered by the timesteps
+     * elapsed including these, so later results do not overwrite earlier ones.
+     *
+     * Initialised to 0 in the constructor.
+     */
+    unsigned mTimeStepsElapsedOffset;
+
+    /**
+     * The coefficient with which UpdateNodeLocations() treats the membrane springs of each element semi-implicitly,
+     * indexed by element, as set by ImmersedBoundarySimulationModifier.  If empty, or zero for an element, its nodes
+     * move with the interpolated fluid velocity alone.
+     */
+    std::vector<double> mImplicitMembraneCoefficients;
+
+    /** The displacement of each node, indexed by slot, held while the semi-implicit correction is applied. */
+    std::vector<double> mNodeDisplacements;
+
+    /**
+     * Rebuild the maps between cells and locations after the elements of the mesh have been renumbered, so that each
+     * cell stays associated with the same element.
+     *
+     * @param rNewElementIndices the new index of each element, indexed by its old index
+     */
+    void UpdateCellLocationsAfterRenumbering(const std::vector<unsigned>& rNewElementIndices);
+
+    /**
+     * Move the implicit membrane coefficients to the new indices of their elements after the elements of the mesh have
+     * been renumbered.
+     *
+     * @param rNewElementIndices the new index of each element, indexed by its old index, or UINT_MAX if removed
+     */
+    void RenumberImplicitMembraneCoefficients(const std::vector<unsigned>& rNewElementIndices);
+
     /**
      * Overridden WriteVtkResultsToFile() method.
      *
@@ -100,6 +237,14 @@ private:
      */
     virtual void WriteVtkResultsToFile(const std::string& rDirectory);
 
+    /**
+     * Helper method for WriteVtkResultsToFile() to format and write the VTK results file on the calling thread.
+     *
+     * @param rDirectory  pathname of the output directory, relative to where Chaste output is stored
+     * @param numTimesteps the number of time steps elapsed, used to name the file
+     */
+    void WriteVtkResultsToFileNow(const std::string& rDirectory, unsigned numTimesteps);
+
     friend class boost::serialization::access;
     /**
      * Serialize the object and its member variables.
@@ -120,10 +265,49 @@ private:
     }
 
     /**
-     * Helper method
-     * Calculates the discrete delta approximation based on distance and grid spacing
+     * Helper method for UpdateNodeLocations()
+     * Moves each node and fluid source with the fluid velocity interpolated using a stencil of the given width.
+     *
+     * @param dt the time step
+     */
+    template<unsigned WIDTH>
+    void UpdateNodeLocationsWithStencil(double dt);
+
+    /**
+     * Helper method for UpdateNodeLocationsWithStencil()
+     * Interpolates the fluid velocity to a location.
+     *
+     * @param rStencil the stencil, already updated or loaded for the location
+     * @return the interpolated velocity
      */
-    double Delta1D(double dist, double spacing);
+    template<unsigned WIDTH>
+    c_vector<double, DIM> InterpolateVelocity(const ImmersedBoundaryStencil<WIDTH>& rStencil);
+
+    /**
+     * Helper method for UpdateNodeLocationsWithStencil()
+     * Corrects the displacements in #mNodeDisplacements of the nodes of each element with a nonzero implicit membrane
+     * coefficient a, so that the displacements x solve (I + a L) x = d, where d are the displacements interpolated from
+     * the fluid and L is the negated second difference around the element.  This damps the modes of the membrane whose
+     * relaxation would otherwise make an explicit update unstable.
+     *
+     * @param rNodeArrays the mesh's node arrays
+     */
+    void CorrectDisplacementsForImplicitMembrane(const ImmersedBoundaryNodeArrays<DIM>& rNodeArrays);
+
+    /**
+     * Helper method for UpdateNodeLocationsWithStencil()
+     * Moves the node in a slot, limiting its displacement if required and accounting for walls or periodicity.
+     *
+     * @param rNodeArrays the mesh's node arrays
+     * @param slot the slot of the node
+     * @param rDisplacement the displacement of the node, which is scaled back if limited
+     * @param characteristicSpacing the characteristic node spacing, to which displacements are limited
+     * @return whether the displacement was limited
+     */
+    bool MoveNodeInSlot(ImmersedBoundaryNodeArrays<DIM>& rNodeArrays,
+                        unsigned slot,
+                        c_vector<double, DIM>& rDisplacement,
+                        double characteristicSpacing);
 
     /**
      * Check the consistency of internal data structures.
@@ -331,6 +515,119 @@ public:
      */
     void Update(bool hasHadBirthsOrDeaths=true);
 
+    /**
+     * Renumber the nodes and elements of the mesh along a space filling curve (see
+     * ImmersedBoundaryMesh::ReorderAlongSpaceFillingCurve()), and update the correspondence with CellPtrs so that each
+     * cell stays associated with the same element.
+     *
+     * @param useHilbertCurve whether to order along a Hilbert curve, rather than a Morton curve (defaults to true)
+     */
+    void ReorderAlongSpaceFillingCurve(bool useHilbertCurve=true);
+
+    /**
+     * Redistribute the nodes of each element of the mesh uniformly along its boundary (see
+     * ImmersedBoundaryMesh::RemeshElements()).  Cells stay associated with the same elements.
+     *
+     * @param targetNodeSpacing the node spacing to aim for, or zero to keep the number of nodes in each element
+     *     (defaults to zero)
+     */
+    void RemeshElements(double targetNodeSpacing=0.0);
+
+    /**
+     * Remove the elements and nodes of dead cells from the mesh and renumber what remains densely (see
+     * ImmersedBoundaryMesh::ReMesh()), and update the correspondence with CellPtrs so that each cell stays associated
+     * with the same element.
+     */
+    void ReMesh();
+
+    /**
+     * Set #mReMeshThreshold.
+     *
+     * @param reMeshThreshold the number of deleted elements at which the mesh is compacted, or zero never to compact it
+     *     automatically
+     */
+    void SetReMeshThreshold(unsigned reMeshThreshold);
+
+    /**
+     * @return #mReMeshThreshold
+     */
+    unsigned GetReMeshThreshold();
+
+    /**
+     * Set #mAsyncVtkOutputQueueDepth.  With a nonzero depth, WriteVtkResultsToFile() only copies the node locations,
+     * connectivity and cell data, and the VTK file is formatted and written on a background thread; once that many
+     * snapshots are waiting, the next output waits for the oldest to be written.
+     *
+     * @param asyncVtkOutputQueueDepth the maximum number of snapshots waiting to be written, or zero to write VTK
+     *     results synchronously
+     */
+    void SetAsyncVtkOutputQueueDepth(unsigned asyncVtkOutputQueueDepth);
+
+    /**
+     * @return #mAsyncVtkOutputQueueDepth
+     */
+    unsigned GetAsyncVtkOutputQueueDepth();
+
+    /**
+     * Set #mWriteRawBinaryVtk.  Raw binary VTK results are smaller and faster to write than the default base64
+     * encoding, and are read by Paraview, but are not valid XML.
+     *
+     * @param writeRawBinaryVtk whether to write raw binary
+     */
+    void SetWriteRawBinaryVtk(bool writeRawBinaryVtk);
+
+    /**
+     * @return #mWriteRawBinaryVtk
+     */
+    bool GetWriteRawBinaryVtk();
+
+    /**
+     * Set #mCompressVtk.
+     *
+     * @param compressVtk whether to compress
+     */
+    void SetCompressVtk(bool compressVtk);
+
+    /**
+     * @return #mCompressVtk
+     */
+    bool GetCompressVtk();
+
+    /**
+     * Set #mTimeStepsElapsedOffset.
+     *
+     * @param timeStepsElapsedOffset the number of timesteps elapsed before SimulationTime last restarted its count
+     */
+    void SetTimeStepsElapsedOffset(unsigned timeStepsElapsedOffset);
+
+    /**
+     * @return #mTimeStepsElapsedOffset
+     */
+    unsigned GetTimeStepsElapsedOffset();
+
+    /**
+     * Wait until every VTK results file staged for writing on the background thread has been written.
+     */
+    void FlushVtkOutput();
+
+    /**
+     * Take a snapshot of the mesh together with the output of each cell, in a single pass over the elements: the ID
+     * of the cell of each element, the VTK cell data of each cell writer and each item of the cells' CellData, in
+     * that order.  The snapshot can then be written as VTK, appended to a CSV file or passed to any other output
+     * without further copying.
+     *
+     * @param rSnapshot the snapshot, whose storage is reused
+     * @param timeStep the time step at which the snapshot is taken
+     */
+    void TakeOutputSnapshot(ImmersedBoundaryMeshSnapshot<DIM, DIM>& rSnapshot, unsigned timeStep);
+
+    /**
+     * Overridden CloseWritersFiles() method.
+     *
+     * Waits for any VTK results still being written in the background before closing the writers' files.
+     */
+    virtual void CloseWritersFiles();
+
     /**
      * Overridden OpenWritersFiles() method.
      *
@@ -418,6 +715,106 @@ public:
      */
     void SetIfPopulationHasActiveSources(bool hasActiveSources);
 
+    /**
+     * Set #mUseSimulationTimeStep.
+     *
+     * @param useSimulationTimeStep whether UpdateNodeLocations() should use the SimulationTime timestep
+     */
+    void SetUseSimulationTimeStep(bool useSimulationTimeStep);
+
+    /**
+     * @return #mUseSimulationTimeStep
+     */
+    bool GetUseSimulationTimeStep();
+
+    /**
+     * @return #mMaxNodeSpeed
+     */
+    double GetMaxNodeSpeed();
+
+    /**
+     * @return #mNodeDisplacementBound
+     */
+    double GetNodeDisplacementBound();
+
+    /**
+     * Reset #mNodeDisplacementBound to zero, for instance when neighbour lists are rebuilt.
+     */
+    void ResetNodeDisplacementBound();
+
+    /**
+     * Set #mNodeDisplacementBound, for instance when restarting from a checkpoint.
+     *
+     * @param nodeDisplacementBound the bound on how far any node has moved since the node pairs were calculated
+     */
+    void SetNodeDisplacementBound(double nodeDisplacementBound);
+
+    /**
+     * Set #mStencilWidth.
+     *
+     * @param stencilWidth the stencil width, which must be 3, 4 or 6
+     */
+    void SetStencilWidth(unsigned stencilWidth);
+
+    /**
+     * @return #mStencilWidth
+     */
+    unsigned GetStencilWidth();
+
+    /**
+     * Set #mNumInterpolationThreads.
+     *
+     * @param numInterpolationThreads the number of threads to use in UpdateNodeLocations()
+     */
+    void SetNumInterpolationThreads(unsigned numInterpolationThreads);
+
+    /**
+     * @return #mNumInterpolationThreads
+     */
+    unsigned GetNumInterpolationThreads();
+
+    /**
+     * Set #mLimitNodeDisplacements.
+     *
+     * @param limitNodeDisplacements whether to limit each displacement to the characteristic node spacing
+     */
+    void SetLimitNodeDisplacements(bool limitNodeDisplacements);
+
+    /**
+     * @return #mLimitNodeDisplacements
+     */
+    bool GetLimitNodeDisplacements();
+
+    /**
+     * Set #mImplicitMembraneCoefficients.
+     *
+     * @param rImplicitMembraneCoefficients the coefficient of each element, indexed by element, or an empty vector
+     *     to move nodes with the interpolated fluid velocity alone
+     */
+    void SetImplicitMembraneCoefficients(const std::vector<double>& rImplicitMembraneCoefficients);
+
+    /**
+     * @return #mImplicitMembraneCoefficients
+     */
+    const std::vector<double>& rGetImplicitMembraneCoefficients() const;
+
+    /**
+     * Set #mpPhaseTimer, registering a phase for UpdateNodeLocations() with it.
+     *
+     * @param pPhaseTimer the timer in which to record the wall time of UpdateNodeLocations(), or empty not to time it
+     */
+    void SetPhaseTimer(boost::shared_ptr<ImmersedBoundaryPhaseTimer> pPhaseTimer);
+
+    /**
+     * @return reference to #mNodeStencilCache
+     */
+    ImmersedBoundaryStencilCache& rGetNodeStencilCache();
+
+    /**
+     * @return reference to #mSourceStencilCache
+     */
+    ImmersedBoundaryStencilCache& rGetSourceStencilCache();
+
     /**
      * Checks whether a given node displacement violates the movement threshold
      * for this population. If so, a stepSizeException is generated that contains
@@ -0,0 +1,398 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "ImmersedBoundaryCheckpoint.hpp"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include "Exception.hpp"
+
+/**
+ * Write an unsigned value to a binary stream.
+ *
+ * @param rFile the stream
+ * @param value the value
+ */
+static void WriteUnsigned(std::ofstream& rFile, unsigned value)
+{
+    rFile.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/**
+ * Write a double value to a binary stream.
+ *
+ * @param rFile the stream
+ * @param value the value
+ */
+static void WriteDouble(std::ofstream& rFile, double value)
+{
+    rFile.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/**
+ * Write a vector of doubles to a binary stream, preceded by its length.
+ *
+ * @param rFile the stream
+ * @param rValues the values
+ */
+static void WriteDoubles(std::ofstream& rFile, const std::vector<double>& rValues)
+{
+    WriteUnsigned(rFile, rValues.size());
+    if (!rValues.empty())
+    {
+        rFile.write(reinterpret_cast<const char*>(&rValues[0]), rValues.size() * sizeof(double));
+    }
+}
+
+/**
+ * Write a vector of unsigned values to a binary stream, preceded by its length.
+ *
+ * @param rFile the stream
+ * @param rValues the values
+ */
+static void WriteUnsigneds(std::ofstream& rFile, const std::vector<unsigned>& rValues)
+{
+    WriteUnsigned(rFile, rValues.size());
+    if (!rValues.empty())
+    {
+        rFile.write(reinterpret_cast<const char*>(&rValues[0]), rValues.size() * sizeof(unsigned));
+    }
+}
+
+/**
+ * Read an unsigned value from a binary stream.
+ *
+ * @param rFile the stream
+ * @return the value
+ */
+static unsigned ReadUnsigned(std::ifstream& rFile)
+{
+    unsigned value = 0;
+    rFile.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return value;
+}
+
+/**
+ * Read a double value from a binary stream.
+ *
+ * @param rFile the stream
+ * @return the value
+ */
+static double ReadDouble(std::ifstream& rFile)
+{
+    double value = 0.0;
+    rFile.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return value;
+}
+
+/**
+ * Read a vector of doubles, preceded by its length, from a binary stream.
+ *
+ * @param rFile the stream
+ * @param rValues the vector to fill
+ */
+static void ReadDoubles(std::ifstream& rFile, std::vector<double>& rValues)
+{
+    rValues.resize(ReadUnsigned(rFile));
+    if (rFile.good() && !rValues.empty())
+    {
+        rFile.read(reinterpret_cast<char*>(&rValues[0]), rValues.size() * sizeof(double));
+    }
+}
+
+/**
+ * Read a vector of unsigned values, preceded by its length, from a binary stream.
+ *
+ * @param rFile the stream
+ * @param rValues the vector to fill
+ */
+static void ReadUnsigneds(std::ifstream& rFile, std::vector<unsigned>& rValues)
+{
+    rValues.resize(ReadUnsigned(rFile));
+    if (rFile.good() && !rValues.empty())
+    {
+        rFile.read(reinterpret_cast<char*>(&rValues[0]), rValues.size() * sizeof(unsigned));
+    }
+}
+
+template<unsigned DIM>
+ImmersedBoundaryCheckpoint<DIM>::ImmersedBoundaryCheckpoint()
+    : mTime(0.0),
+      mTimeStepsElapsed(0),
+      mCharacteristicNodeSpacing(0.0),
+      mNodeDisplacementBound(0.0)
+{
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCheckpoint<DIM>::Write(const std::string& rPath) const
+{
+    /*
+     * Write to a temporary file and rename it, so that a job stopped part way through writing leaves the previous
+     * checkpoint intact.
+     */
+    std::stringstream temp_path;
+    temp_path << rPath << ".tmp." << getpid();
+
+    std::ofstream file(temp_path.str().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        EXCEPTION("Could not open checkpoint file " << temp_path.str() << " for writing");
+    }
+
+    WriteUnsigned(file, ImmersedBoundaryCheckpointFormat::MAGIC);
+    WriteUnsigned(file, ImmersedBoundaryCheckpointFormat::VERSION);
+    WriteUnsigned(file, ImmersedBoundaryCheckpointFormat::BYTE_ORDER_MARK);
+    WriteUnsigned(file, DIM);
+
+    WriteDouble(file, mTime);
+    WriteUnsigned(file, mTimeStepsElapsed);
+
+    // The grids are stored contiguously, so are written in one go
+    WriteUnsigned(file, mVelocityGrids.shape()[1]);
+    WriteUnsigned(file, mVelocityGrids.shape()[2]);
+    if (mVelocityGrids.num_elements() > 0)
+    {
+        file.write(reinterpret_cast<const char*>(mVelocityGrids.data()), mVelocityGrids.num_elements() * sizeof(double));
+    }
+
+    WriteDoubles(file, mNodeLocations);
+    WriteDoubles(file, mElementNodeSpacings);
+    WriteUnsigneds(file, mElementTopology);
+    WriteDouble(file, mCharacteristicNodeSpacing);
+    WriteDoubles(file, mSourceLocations);
+    WriteDoubles(file, mSourceStrengths);
+
+    // Pairs are written field by field, so no padding is written
+    WriteUnsigned(file, mNodePairs.size());
+    for (unsigned pair = 0; pair < mNodePairs.size(); pair++)
+    {
+        WriteUnsigned(file, mNodePairs[pair].mNodeA);
+        WriteUnsigned(file, mNodePairs[pair].mNodeB);
+        WriteUnsigned(file, mNodePairs[pair].mElementA);
+        WriteUnsigned(file, mNodePairs[pair].mElementB);
+        WriteDouble(file, mNodePairs[pair].mSquaredDistance);
+    }
+    WriteDouble(file, mNodeDisplacementBound);
+
+    WriteUnsigned(file, mForceNames.size());
+    for (unsigned force_idx = 0; force_idx < mForceNames.size(); force_idx++)
+    {
+        WriteUnsigned(file, mForceNames[force_idx].size());
+        file.write(mForceNames[force_idx].data(), mForceNames[force_idx].size());
+    }
+
+    file.close();
+    if (file.fail() || std::rename(temp_path.str().c_str(), rPath.c_str()) != 0)
+    {
+        std::remove(temp_path.str().c_str());
+        EXCEPTION("Could not write checkpoint file " << rPath);
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCheckpoint<DIM>::Read(const std::string& rPath)
+{
+    std::ifstream file(rPath.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open())
+    {
+        EXCEPTION("Could not open checkpoint file " << rPath);
+    }
+
+    if (ReadUnsigned(file) != ImmersedBoundaryCheckpointFormat::MAGIC)
+    {
+        EXCEPTION("File " << rPath << " is not a checkpoint");
+    }
+    if (ReadUnsigned(file) != ImmersedBoundaryCheckpointFormat::VERSION)
+    {
+        EXCEPTION("Checkpoint " << rPath << " was written by an unsupported version");
+    }
+    if (ReadUnsigned(file) != ImmersedBoundaryCheckpointFormat::BYTE_ORDER_MARK)
+    {
+        EXCEPTION("Checkpoint " << rPath << " was written on a machine of different byte order");
+    }
+    if (ReadUnsigned(file) != DIM)
+    {
+        EXCEPTION("Checkpoint " << rPath << " was written by a simulation of different dimension");
+    }
+
+    mTime = ReadDouble(file);
+    mTimeStepsElapsed = ReadUnsigned(file);
+
+    unsigned num_grid_pts_x = ReadUnsigned(file);
+    unsigned num_grid_pts_y = ReadUnsigned(file);
+    mVelocityGrids.resize(boost::extents[2][num_grid_pts_x][num_grid_pts_y]);
+    if (file.good() && mVelocityGrids.num_elements() > 0)
+    {
+        file.read(reinterpret_cast<char*>(mVelocityGrids.data()), mVelocityGrids.num_elements() * sizeof(double));
+    }
+
+    ReadDoubles(file, mNodeLocations);
+    ReadDoubles(file, mElementNodeSpacings);
+    ReadUnsigneds(file, mElementTopology);
+    mCharacteristicNodeSpacing = ReadDouble(file);
+    ReadDoubles(file, mSourceLocations);
+    ReadDoubles(file, mSourceStrengths);
+
+    mNodePairs.resize(file.good() ? ReadUnsigned(file) : 0);
+    for (unsigned pair = 0; pair < mNodePairs.size() && file.good(); pair++)
+    {
+        mNodePairs[pair].mNodeA = ReadUnsigned(file);
+        mNodePairs[pair].mNodeB = ReadUnsigned(file);
+        mNodePairs[pair].mElementA = ReadUnsigned(file);
+        mNodePairs[pair].mElementB = ReadUnsigned(file);
+        mNodePairs[pair].mSquaredDistance = ReadDouble(file);
+    }
+    mNodeDisplacementBound = ReadDouble(file);
+
+    mForceNames.resize(file.good() ? ReadUnsigned(file) : 0);
+    for (unsigned force_idx = 0; force_idx < mForceNames.size() && file.good(); force_idx++)
+    {
+        mForceNames[force_idx].resize(ReadUnsigned(file));
+        if (file.good() && !mForceNames[force_idx].empty())
+        {
+            file.read(&mForceNames[force_idx][0], mForceNames[force_idx].size());
+        }
+    }
+
+    // Any read past the end of the file leaves the stream failed
+    if (file.fail())
+    {
+        EXCEPTION("Checkpoint " << rPath << " is truncated");
+    }
+}
+
+template<unsigned DIM>
+double ImmersedBoundaryCheckpoint<DIM>::GetTime() const
+{
+    return mTime;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCheckpoint<DIM>::SetTime(double time)
+{
+    mTime = time;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundaryCheckpoint<DIM>::GetTimeStepsElapsed() const
+{
+    return mTimeStepsElapsed;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCheckpoint<DIM>::SetTimeStepsElapsed(unsigned timeStepsElapsed)
+{
+    mTimeStepsElapsed = timeStepsElapsed;
+}
+
+template<unsigned DIM>
+double ImmersedBoundaryCheckpoint<DIM>::GetCharacteristicNodeSpacing() const
+{
+    return mCharacteristicNodeSpacing;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCheckpoint<DIM>::SetCharacteristicNodeSpacing(double characteristicNodeSpacing)
+{
+    mCharacteristicNodeSpacing = characteristicNodeSpacing;
+}
+
+template<unsigned DIM>
+double ImmersedBoundaryCheckpoint<DIM>::GetNodeDisplacementBound() const
+{
+    return mNodeDisplacementBound;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryCheckpoint<DIM>::SetNodeDisplacementBound(double nodeDisplacementBound)
+{
+    mNodeDisplacementBound = nodeDisplacementBound;
+}
+
+template<unsigned DIM>
+multi_array<double, 3>& ImmersedBoundaryCheckpoint<DIM>::rGetVelocityGrids()
+{
+    return mVelocityGrids;
+}
+
+template<unsigned DIM>
+std::vector<double>& ImmersedBoundaryCheckpoint<DIM>::rGetNodeLocations()
+{
+    return mNodeLocations;
+}
+
+template<unsigned DIM>
+std::vector<double>& ImmersedBoundaryCheckpoint<DIM>::rGetElementNodeSpacings()
+{
+    return mElementNodeSpacings;
+}
+
+template<unsigned DIM>
+std::vector<unsigned>& ImmersedBoundaryCheckpoint<DIM>::rGetElementTopology()
+{
+    return mElementTopology;
+}
+
+template<unsigned DIM>
+std::vector<double>& ImmersedBoundaryCheckpoint<DIM>::rGetSourceLocations()
+{
+    return mSourceLocations;
+}
+
+template<unsigned DIM>
+std::vector<double>& ImmersedBoundaryCheckpoint<DIM>::rGetSourceStrengths()
+{
+    return mSourceStrengths;
+}
+
+template<unsigned DIM>
+std::vector<typename ImmersedBoundaryNodePairList<DIM>::NodePair>& ImmersedBoundaryCheckpoint<DIM>::rGetNodePairs()
+{
+    return mNodePairs;
+}
+
+template<unsigned DIM>
+std::vector<std::string>& ImmersedBoundaryCheckpoint<DIM>::rGetForceNames()
+{
+    return mForceNames;
+}
+
+// Explicit instantiation
+template class ImmersedBoundaryCheckpoint<1>;
+template class ImmersedBoundaryCheckpoint<2>;
+template class ImmersedBoundaryCheckpoint<3>;
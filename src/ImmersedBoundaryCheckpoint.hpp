@@ -0,0 +1,188 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef IMMERSEDBOUNDARYCHECKPOINT_HPP_
+#define IMMERSEDBOUNDARYCHECKPOINT_HPP_
+
+#include <string>
+#include <vector>
+#include "ImmersedBoundaryArray.hpp"
+#include "ImmersedBoundaryNodePairList.hpp"
+
+/**
+ * The layout of checkpoint files.  All values are in native byte order, which is recorded by the byte order mark.
+ *
+ * The header is the magic number, the version, the byte order mark and the dimension (each 32-bit unsigned).  It is
+ * followed by the simulation time and number of time steps elapsed, the fluid grid and its size, the node locations,
+ * the element node spacings, the element topology, the fluid sources, the node pairs and the names of the forces, in the
+ * order written by ImmersedBoundaryCheckpoint::Write().  Each list is preceded by its length.
+ */
+namespace ImmersedBoundaryCheckpointFormat
+{
+    /** The magic number at the start of every file, being "IBCK" read as little-endian. */
+    const unsigned MAGIC = 0x4b434249u;
+
+    /** The version of the layout. */
+    const unsigned VERSION = 2u;
+
+    /** The byte order mark, which reads as this value in the byte order of the file. */
+    const unsigned BYTE_ORDER_MARK = 0x01020304u;
+}
+
+/**
+ * The state of an immersed boundary simulation that cannot be cheaply rebuilt on restart: the fluid velocity, the
+ * node and fluid source locations, the node pairs within the interaction distance and the element node spacings.
+ * The mesh itself is not held, only the nodes of each element, so that a restart onto a mesh of different topology is
+ * detected rather than silently given the wrong state.
+ *
+ * A checkpoint is filled and restored by ImmersedBoundarySimulationModifier, and is written to and read from a
+ * single binary file.  Writing is atomic, so a job that is stopped while writing leaves the previous checkpoint intact.
+ */
+template<unsigned DIM>
+class ImmersedBoundaryCheckpoint
+{
+private:
+
+    /** The simulation time at which the checkpoint was taken. */
+    double mTime;
+
+    /** The number of time steps elapsed when the checkpoint was taken. */
+    unsigned mTimeStepsElapsed;
+
+    /** The fluid velocity grids, indexed by component then x then y. */
+    multi_array<double, 3> mVelocityGrids;
+
+    /** The location of each node, by global index, with DIM entries per node. */
+    std::vector<double> mNodeLocations;
+
+    /** The average node spacing of each element, by index, which is zero for deleted elements. */
+    std::vector<double> mElementNodeSpacings;
+
+    /**
+     * The nodes of each element, by index: the number of nodes of the element followed by their global indices, in
+     * order, with no nodes for deleted elements.
+     */
+    std::vector<unsigned> mElementTopology;
+
+    /** The characteristic node spacing of the mesh. */
+    double mCharacteristicNodeSpacing;
+
+    /** The location of each fluid source, in the order of the fluid source registry, with DIM entries per source. */
+    std::vector<double> mSourceLocations;
+
+    /** The strength of each fluid source, in the order of the fluid source registry. */
+    std::vector<double> mSourceStrengths;
+
+    /** The pairs of nodes within the interaction distance plus the neighbour skin, when last calculated. */
+    std::vector<typename ImmersedBoundaryNodePairList<DIM>::NodePair> mNodePairs;
+
+    /** The bound on how far any node has moved since the node pairs were calculated. */
+    double mNodeDisplacementBound;
+
+    /** The name of each force, in the order they were added, used to check a restart is set up as the original. */
+    std::vector<std::string> mForceNames;
+
+public:
+
+    /**
+     * Constructor.
+     */
+    ImmersedBoundaryCheckpoint();
+
+    /**
+     * Write the checkpoint to a file, replacing any existing file only once it has been completely written.
+     *
+     * @param rPath the absolute path of the file
+     */
+    void Write(const std::string& rPath) const;
+
+    /**
+     * Read the checkpoint from a file.
+     *
+     * @param rPath the absolute path of the file
+     */
+    void Read(const std::string& rPath);
+
+    /** @return #mTime */
+    double GetTime() const;
+
+    /** @param time the simulation time */
+    void SetTime(double time);
+
+    /** @return #mTimeStepsElapsed */
+    unsigned GetTimeStepsElapsed() const;
+
+    /** @param timeStepsElapsed the number of time steps elapsed */
+    void SetTimeStepsElapsed(unsigned timeStepsElapsed);
+
+    /** @return #mCharacteristicNodeSpacing */
+    double GetCharacteristicNodeSpacing() const;
+
+    /** @param characteristicNodeSpacing the characteristic node spacing of the mesh */
+    void SetCharacteristicNodeSpacing(double characteristicNodeSpacing);
+
+    /** @return #mNodeDisplacementBound */
+    double GetNodeDisplacementBound() const;
+
+    /** @param nodeDisplacementBound the bound on how far any node has moved since the node pairs were calculated */
+    void SetNodeDisplacementBound(double nodeDisplacementBound);
+
+    /** @return #mVelocityGrids */
+    multi_array<double, 3>& rGetVelocityGrids();
+
+    /** @return #mNodeLocations */
+    std::vector<double>& rGetNodeLocations();
+
+    /** @return #mElementNodeSpacings */
+    std::vector<double>& rGetElementNodeSpacings();
+
+    /** @return #mElementTopology */
+    std::vector<unsigned>& rGetElementTopology();
+
+    /** @return #mSourceLocations */
+    std::vector<double>& rGetSourceLocations();
+
+    /** @return #mSourceStrengths */
+    std::vector<double>& rGetSourceStrengths();
+
+    /** @return #mNodePairs */
+    std::vector<typename ImmersedBoundaryNodePairList<DIM>::NodePair>& rGetNodePairs();
+
+    /** @return #mForceNames */
+    std::vector<std::string>& rGetForceNames();
+};
+
+#endif /*IMMERSEDBOUNDARYCHECKPOINT_HPP_*/
@@ -85,6 +85,20 @@ void ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>::SetAverageNodeSpacing(doub
     mAverageNodeSpacing = averageNodeSpacing;
 }
 
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>::ReplaceNodes(const std::vector<Node<SPACE_DIM>*>& rNodes)
+{
+    assert(rNodes.size() > 2);
+
+    for (unsigned node_idx = 0; node_idx < this->mNodes.size(); node_idx++)
+    {
+        this->mNodes[node_idx]->RemoveElement(this->mIndex);
+    }
+
+    this->mNodes = rNodes;
+    this->RegisterWithNodes();
+}
+
 //////////////////////////////////////////////////////////////////////
 //                  Specialization for 1d elements                  //
 //                                                                  //
@@ -129,6 +143,18 @@ void ImmersedBoundaryElement<1, SPACE_DIM>::SetAverageNodeSpacing(double average
 {
 }
 
+template<unsigned SPACE_DIM>
+void ImmersedBoundaryElement<1, SPACE_DIM>::ReplaceNodes(const std::vector<Node<SPACE_DIM>*>& rNodes)
+{
+    for (unsigned node_idx = 0; node_idx < this->mNodes.size(); node_idx++)
+    {
+        this->mNodes[node_idx]->RemoveElement(this->mIndex);
+    }
+
+    this->mNodes = rNodes;
+    this->RegisterWithNodes();
+}
+
 // Explicit instantiation
 template class ImmersedBoundaryElement<1,1>;
 template class ImmersedBoundaryElement<1,2>;
@@ -130,6 +130,13 @@ public:
      * @param averageNodeSpacing the new average node spacing.
      */
     void SetAverageNodeSpacing(double averageNodeSpacing);
+
+    /**
+     * Replace the nodes of the element, updating the containing element indices of both the old and new nodes.
+     *
+     * @param rNodes the new nodes of the element, in order
+     */
+    void ReplaceNodes(const std::vector<Node<SPACE_DIM>*>& rNodes);
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -193,6 +200,13 @@ public:
      * @param averageNodeSpacing the new average node spacing.
      */
     void SetAverageNodeSpacing(double averageNodeSpacing);
+
+    /**
+     * Replace the nodes of the element, updating the containing element indices of both the old and new nodes.
+     *
+     * @param rNodes the new nodes of the element, in order
+     */
+    void ReplaceNodes(const std::vector<Node<SPACE_DIM>*>& rNodes);
 };
 
 #endif /*IMMERSEDBOUNDARYELEMENT_HPP_*/
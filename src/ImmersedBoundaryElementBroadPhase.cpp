@@ -0,0 +1,223 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryElementBroadPhase.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+template<unsigned DIM>
+ImmersedBoundaryElementBroadPhase<DIM>::ImmersedBoundaryElementBroadPhase()
+    : mPeriods(scalar_vector<double>(DIM, 1.0))
+{
+}
+
+template<unsigned DIM>
+bool ImmersedBoundaryElementBroadPhase<DIM>::IntervalsOverlap(double lowerA, double widthA, double lowerB, double widthB, double period)
+{
+    // The distance from the lower end of A forward to the lower end of B, around the periodic interval
+    double forward = lowerB - lowerA;
+    forward -= period * floor(forward / period);
+
+    return forward < widthA || period - forward < widthB;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryElementBroadPhase<DIM>::AddPairIfOverlapping(unsigned elemA, unsigned elemB)
+{
+    for (unsigned dim = 1; dim < DIM; dim++)
+    {
+        if (!IntervalsOverlap(mLowerCorners[DIM * elemA + dim], mWidths[DIM * elemA + dim],
+                              mLowerCorners[DIM * elemB + dim], mWidths[DIM * elemB + dim], mPeriods[dim]))
+        {
+            return;
+        }
+    }
+
+    mOverlappingPairs.push_back(std::make_pair(std::min(elemA, elemB), std::max(elemA, elemB)));
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryElementBroadPhase<DIM>::Update(const ImmersedBoundaryNodeArrays<DIM>& rArrays, double margin)
+{
+    // Boxes must have positive width to be found by the sweep
+    assert(margin > 0.0);
+
+    for (unsigned dim = 0; dim < DIM; dim++)
+    {
+        mPeriods[dim] = rArrays.GetPeriod(dim);
+    }
+
+    unsigned num_elements = rArrays.GetNumElements();
+    mLowerCorners.resize(DIM * num_elements);
+    mWidths.resize(DIM * num_elements);
+
+    // Calculate the inflated box of each element, relative to its first node to account for periodicity
+    unsigned num_elements_with_nodes = 0;
+    for (unsigned elem_idx = 0; elem_idx < num_elements; elem_idx++)
+    {
+        unsigned begin = rArrays.GetElementBegin(elem_idx);
+        unsigned end = rArrays.GetElementEnd(elem_idx);
+        if (begin == end)
+        {
+            continue;
+        }
+        num_elements_with_nodes++;
+
+        const double* p_ref_point = rArrays.GetLocation(begin);
+        double bottom_left[DIM];
+        double top_right[DIM];
+        std::fill(bottom_left, bottom_left + DIM, 0.0);
+        std::fill(top_right, top_right + DIM, 0.0);
+
+        for (unsigned slot = begin + 1; slot < end; slot++)
+        {
+            const double* p_location = rArrays.GetLocation(slot);
+            for (unsigned dim = 0; dim < DIM; dim++)
+            {
+                double difference = p_location[dim] - p_ref_point[dim];
+                difference -= mPeriods[dim] * floor(difference / mPeriods[dim] + 0.5);
+
+                bottom_left[dim] = std::min(bottom_left[dim], difference);
+                top_right[dim] = std::max(top_right[dim], difference);
+            }
+        }
+
+        for (unsigned dim = 0; dim < DIM; dim++)
+        {
+            double lower = p_ref_point[dim] + bottom_left[dim] - margin;
+            mLowerCorners[DIM * elem_idx + dim] = lower - mPeriods[dim] * floor(lower / mPeriods[dim]);
+            mWidths[DIM * elem_idx + dim] = std::min(top_right[dim] - bottom_left[dim] + 2.0 * margin, mPeriods[dim]);
+        }
+    }
+
+    // Rebuild the sweep order if elements have gained or lost nodes, and otherwise restore it by insertion sort
+    bool order_is_valid = mSortedElements.size() == num_elements_with_nodes;
+    for (unsigned pos = 0; order_is_valid && pos < mSortedElements.size(); pos++)
+    {
+        unsigned elem_idx = mSortedElements[pos];
+        order_is_valid = elem_idx < num_elements && rArrays.GetElementBegin(elem_idx) != rArrays.GetElementEnd(elem_idx);
+    }
+
+    if (!order_is_valid)
+    {
+        mSortedElements.clear();
+        for (unsigned elem_idx = 0; elem_idx < num_elements; elem_idx++)
+        {
+            if (rArrays.GetElementBegin(elem_idx) != rArrays.GetElementEnd(elem_idx))
+            {
+                mSortedElements.push_back(elem_idx);
+            }
+        }
+    }
+
+    for (unsigned pos = 1; pos < mSortedElements.size(); pos++)
+    {
+        unsigned elem_idx = mSortedElements[pos];
+        double lower_x = mLowerCorners[DIM * elem_idx];
+
+        unsigned insert_pos = pos;
+        while (insert_pos > 0 && mLowerCorners[DIM * mSortedElements[insert_pos - 1]] > lower_x)
+        {
+            mSortedElements[insert_pos] = mSortedElements[insert_pos - 1];
+            insert_pos--;
+        }
+        mSortedElements[insert_pos] = elem_idx;
+    }
+
+    /*
+     * Sweep along x.  Each box is compared with the boxes after it whose lower corner it covers and, if it wraps past
+     * the domain width, with the boxes at the start whose lower corner it covers on the far side.  A pair covering
+     * each other's lower corners would be found from both, so the second comparison skips pairs already found by the
+     * first.
+     */
+    mOverlappingPairs.clear();
+    const double width_x = mPeriods[0];
+    unsigned num_sorted = mSortedElements.size();
+    for (unsigned pos_a = 0; pos_a < num_sorted; pos_a++)
+    {
+        unsigned elem_a = mSortedElements[pos_a];
+        double lower_a = mLowerCorners[DIM * elem_a];
+        double upper_a = lower_a + mWidths[DIM * elem_a];
+
+        for (unsigned pos_b = pos_a + 1; pos_b < num_sorted; pos_b++)
+        {
+            unsigned elem_b = mSortedElements[pos_b];
+            if (mLowerCorners[DIM * elem_b] >= upper_a)
+            {
+                break;
+            }
+            AddPairIfOverlapping(elem_a, elem_b);
+        }
+
+        for (unsigned pos_b = 0; upper_a > width_x && pos_b < pos_a; pos_b++)
+        {
+            unsigned elem_b = mSortedElements[pos_b];
+            double lower_b = mLowerCorners[DIM * elem_b];
+            if (lower_b >= upper_a - width_x)
+            {
+                break;
+            }
+            if (lower_a >= lower_b + mWidths[DIM * elem_b])
+            {
+                AddPairIfOverlapping(elem_a, elem_b);
+            }
+        }
+    }
+}
+
+template<unsigned DIM>
+bool ImmersedBoundaryElementBroadPhase<DIM>::Contains(unsigned elementIndex, const double* pLocation, double extraMargin) const
+{
+    for (unsigned dim = 0; dim < DIM; dim++)
+    {
+        double width = mWidths[DIM * elementIndex + dim] + 2.0 * extraMargin;
+        if (width < mPeriods[dim])
+        {
+            double forward = pLocation[dim] - (mLowerCorners[DIM * elementIndex + dim] - extraMargin);
+            forward -= mPeriods[dim] * floor(forward / mPeriods[dim]);
+            if (forward >= width)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Explicit instantiation
+template class ImmersedBoundaryElementBroadPhase<1>;
+template class ImmersedBoundaryElementBroadPhase<2>;
+template class ImmersedBoundaryElementBroadPhase<3>;
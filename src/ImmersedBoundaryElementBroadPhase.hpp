@@ -0,0 +1,153 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYELEMENTBROADPHASE_HPP_
+#define IMMERSEDBOUNDARYELEMENTBROADPHASE_HPP_
+
+#include <vector>
+#include "ImmersedBoundaryNodeArrays.hpp"
+
+/**
+ * A broad phase for finding interacting nodes: the pairs of elements whose axis-aligned bounding boxes, inflated by a
+ * margin, overlap in the periodic domain of the node arrays.  Nodes in two elements can only be within twice the margin of
+ * each other if the inflated boxes of their elements overlap.
+ *
+ * Boxes are calculated from the node arrays in the same way as ImmersedBoundaryMesh::CalculateBoundingBoxOfElement(),
+ * relative to the first node of each element to account for periodicity.  Overlapping pairs are found by sweeping
+ * along the x axis in order of the lower box corners.  This order is kept between updates and restored by insertion
+ * sort, which takes close to linear time as elements move only a little between updates.
+ */
+template<unsigned DIM>
+class ImmersedBoundaryElementBroadPhase
+{
+private:
+
+    /** The period of the domain in each dimension, taken from the node arrays by Update(). */
+    c_vector<double, DIM> mPeriods;
+
+    /** The lower corner of the inflated box of each element, DIM per element, each in [0, period). */
+    std::vector<double> mLowerCorners;
+
+    /** The width of the inflated box of each element, DIM per element, each at most the period. */
+    std::vector<double> mWidths;
+
+    /** The indices of the elements with nodes, in increasing order of the lower x corner of their boxes. */
+    std::vector<unsigned> mSortedElements;
+
+    /** The pairs of elements whose inflated boxes overlap, with the lower index first. */
+    std::vector<std::pair<unsigned, unsigned> > mOverlappingPairs;
+
+    /**
+     * Whether two intervals of a periodic interval [0, period) overlap.
+     *
+     * @param lowerA the lower end of the first interval, in [0, period)
+     * @param widthA the width of the first interval, at most period
+     * @param lowerB the lower end of the second interval, in [0, period)
+     * @param widthB the width of the second interval, at most period
+     * @param period the length of the periodic interval
+     * @return whether the intervals overlap
+     */
+    static bool IntervalsOverlap(double lowerA, double widthA, double lowerB, double widthB, double period);
+
+    /**
+     * Add a pair of elements to #mOverlappingPairs if their boxes overlap in every dimension other than x.
+     *
+     * @param elemA the index of the first element
+     * @param elemB the index of the second element
+     */
+    void AddPairIfOverlapping(unsigned elemA, unsigned elemB);
+
+public:
+
+    /**
+     * Constructor.
+     */
+    ImmersedBoundaryElementBroadPhase();
+
+    /**
+     * Recalculate the box of each element and the pairs of elements whose boxes overlap.
+     *
+     * @param rArrays the node arrays of the mesh
+     * @param margin the distance by which each box is inflated on every side, which must be positive
+     */
+    void Update(const ImmersedBoundaryNodeArrays<DIM>& rArrays, double margin);
+
+    /**
+     * Whether a location lies within the box of an element, inflated by a further margin.
+     *
+     * @param elementIndex the global index of an element with nodes
+     * @param pLocation the location, DIM values
+     * @param extraMargin the distance by which the box is further inflated on every side
+     * @return whether the location is inside the inflated box
+     */
+    bool Contains(unsigned elementIndex, const double* pLocation, double extraMargin) const;
+
+    /** @return the number of pairs of elements whose boxes overlap */
+    unsigned GetNumOverlappingPairs() const
+    {
+        return mOverlappingPairs.size();
+    }
+
+    /**
+     * @param index the index of a pair
+     * @return the pair of element indices, with the lower index first
+     */
+    const std::pair<unsigned, unsigned>& rGetOverlappingPair(unsigned index) const
+    {
+        return mOverlappingPairs[index];
+    }
+
+    /**
+     * @param elementIndex the global index of an element with nodes
+     * @param dim a dimension
+     * @return the lower corner of the inflated box of the element in the given dimension
+     */
+    double GetLowerCorner(unsigned elementIndex, unsigned dim) const
+    {
+        return mLowerCorners[DIM * elementIndex + dim];
+    }
+
+    /**
+     * @param elementIndex the global index of an element with nodes
+     * @param dim a dimension
+     * @return the width of the inflated box of the element in the given dimension
+     */
+    double GetWidth(unsigned elementIndex, unsigned dim) const
+    {
+        return mWidths[DIM * elementIndex + dim];
+    }
+};
+
+#endif /*IMMERSEDBOUNDARYELEMENTBROADPHASE_HPP_*/
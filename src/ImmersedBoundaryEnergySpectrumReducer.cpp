@@ -0,0 +1,134 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryEnergySpectrumReducer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+ImmersedBoundaryEnergySpectrumReducer::ImmersedBoundaryEnergySpectrumReducer(const std::string& rFileName)
+    : AbstractImmersedBoundaryFluidReducer(rFileName),
+      mHasSpectrum(false),
+      mShellsPerIndexX(1.0),
+      mShellsPerIndexY(1.0)
+{
+}
+
+void ImmersedBoundaryEnergySpectrumReducer::StartStreaming()
+{
+    // Wavenumber index n in x is the wavenumber n / width, which spans max(width, height) / width shells
+    double max_size = std::max(mDomainWidth, mDomainHeight);
+    mShellsPerIndexX = max_size / mDomainWidth;
+    mShellsPerIndexY = max_size / mDomainHeight;
+
+    // The largest wavenumber magnitude on the grid is that of the corner mode (Nx/2, Ny/2)
+    double half_x = double(mNumGridPtsX / 2) * mShellsPerIndexX;
+    double half_y = double(mNumGridPtsY / 2) * mShellsPerIndexY;
+    unsigned num_shells = static_cast<unsigned>(floor(sqrt(half_x * half_x + half_y * half_y) + 0.5)) + 1;
+    mShellEnergies.assign(num_shells, 0.0);
+    mHasSpectrum = false;
+
+    std::vector<std::string> headers;
+    headers.push_back("step");
+    headers.push_back("shell");
+    headers.push_back("time");
+    headers.push_back("energy");
+    mWriter.AddHeaders(headers);
+
+    mWriter.StartStreaming(2, 2, 0, 100, mBinaryOutput);
+}
+
+bool ImmersedBoundaryEnergySpectrumReducer::UsesFourierGrids() const
+{
+    return true;
+}
+
+void ImmersedBoundaryEnergySpectrumReducer::ReduceFourierGrids(const multi_array<std::complex<double>, 3>& rFourierGrids)
+{
+    assert(rFourierGrids.shape()[0] >= 2);
+    assert(rFourierGrids.shape()[1] == mNumGridPtsX && rFourierGrids.shape()[2] == 1 + mNumGridPtsY / 2);
+
+    std::fill(mShellEnergies.begin(), mShellEnergies.end(), 0.0);
+
+    const unsigned reduced_size = 1 + mNumGridPtsY / 2;
+    for (unsigned x = 0; x < mNumGridPtsX; x++)
+    {
+        // Wavenumbers above Nx/2 are the negative wavenumbers x - Nx
+        double k_x = (x <= mNumGridPtsX / 2) ? double(x) : double(x) - double(mNumGridPtsX);
+        k_x *= mShellsPerIndexX;
+
+        for (unsigned y = 0; y < reduced_size; y++)
+        {
+            double k_y = double(y) * mShellsPerIndexY;
+            double k = sqrt(k_x * k_x + k_y * k_y);
+            unsigned shell = std::min(static_cast<unsigned>(floor(k + 0.5)), unsigned(mShellEnergies.size() - 1));
+
+            // Modes strictly between 0 and Ny/2 in y stand in for their unstored complex conjugates too
+            bool self_conjugate = (y == 0) || (mNumGridPtsY % 2 == 0 && y == mNumGridPtsY / 2);
+            double weight = self_conjugate ? 0.5 : 1.0;
+
+            mShellEnergies[shell] += weight * (std::norm(rFourierGrids[0][x][y]) + std::norm(rFourierGrids[1][x][y]));
+        }
+    }
+
+    mHasSpectrum = true;
+}
+
+void ImmersedBoundaryEnergySpectrumReducer::Reduce(unsigned step, double time, const multi_array<double, 3>& rVelocityGrids)
+{
+    if (!mHasSpectrum)
+    {
+        return;
+    }
+
+    std::vector<unsigned> unsigned_values(2);
+    std::vector<double> double_values(2);
+    unsigned_values[0] = step;
+    double_values[0] = time;
+
+    for (unsigned shell = 0; shell < mShellEnergies.size(); shell++)
+    {
+        unsigned_values[1] = shell;
+        double_values[1] = mShellEnergies[shell];
+        mWriter.AppendRow(unsigned_values, double_values);
+    }
+
+    mHasSpectrum = false;
+}
+
+const std::vector<double>& ImmersedBoundaryEnergySpectrumReducer::rGetShellEnergies() const
+{
+    return mShellEnergies;
+}
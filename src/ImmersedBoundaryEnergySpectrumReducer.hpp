@@ -0,0 +1,113 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYENERGYSPECTRUMREDUCER_HPP_
+#define IMMERSEDBOUNDARYENERGYSPECTRUMREDUCER_HPP_
+
+#include <vector>
+#include "AbstractImmersedBoundaryFluidReducer.hpp"
+
+/**
+ * A fluid reducer streaming the shell-summed kinetic energy spectrum of the velocity, taken from the Fourier grids
+ * already computed by the fluid solve.  Shell k holds the energy 0.5 (|u_hat|^2 + |v_hat|^2) of the Fourier modes
+ * whose wavenumber magnitude rounds to k times the shell width, so that the shells sum to the mean kinetic energy
+ * over the domain.  The shell width is the lowest nonzero wavenumber, 1 / max(width, height), so in the unit square
+ * shell k holds the modes of integer wavenumber magnitude close to k.  Each row
+ * holds the step, the shell index, the time and the energy of the shell.
+ */
+class ImmersedBoundaryEnergySpectrumReducer : public AbstractImmersedBoundaryFluidReducer
+{
+private:
+
+    /** The energy of each shell, from the last call to ReduceFourierGrids(). */
+    std::vector<double> mShellEnergies;
+
+    /** Whether the Fourier grids have been reduced since the last call to Reduce(). */
+    bool mHasSpectrum;
+
+    /** The number of shell widths spanned by a unit step in the wavenumber index in the x direction. */
+    double mShellsPerIndexX;
+
+    /** The number of shell widths spanned by a unit step in the wavenumber index in the y direction. */
+    double mShellsPerIndexY;
+
+    /**
+     * Overridden StartStreaming() method.
+     */
+    void StartStreaming();
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param rFileName the name of the file the results are streamed to (defaults to "energy_spectrum.csv")
+     */
+    ImmersedBoundaryEnergySpectrumReducer(const std::string& rFileName="energy_spectrum.csv");
+
+    /**
+     * Overridden UsesFourierGrids() method.
+     *
+     * @return true
+     */
+    bool UsesFourierGrids() const;
+
+    using AbstractImmersedBoundaryFluidReducer::ReduceFourierGrids;
+
+    /**
+     * Overridden ReduceFourierGrids() method.  Sums the energy of each shell over the half spectrum stored by the
+     * real-to-complex transform, counting the modes with 0 < k_y < Ny/2 twice for their complex conjugates.
+     *
+     * @param rFourierGrids the normalised Fourier coefficients of the two velocity components
+     */
+    void ReduceFourierGrids(const multi_array<std::complex<double>, 3>& rFourierGrids);
+
+    /**
+     * Overridden Reduce() method.  Streams the spectrum from the last call to ReduceFourierGrids(), if there has been
+     * one since the last output.
+     *
+     * @param step the number of timesteps elapsed
+     * @param time the simulation time
+     * @param rVelocityGrids the velocity grids (unused)
+     */
+    void Reduce(unsigned step, double time, const multi_array<double, 3>& rVelocityGrids);
+
+    /**
+     * @return #mShellEnergies
+     */
+    const std::vector<double>& rGetShellEnergies() const;
+};
+
+#endif /*IMMERSEDBOUNDARYENERGYSPECTRUMREDUCER_HPP_*/
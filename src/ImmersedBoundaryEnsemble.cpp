@@ -0,0 +1,307 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryEnsemble.hpp"
+#include <sstream>
+#include "Exception.hpp"
+#include "OutputFileHandler.hpp"
+#include "SimulationTime.hpp"
+
+template<unsigned DIM>
+ImmersedBoundaryEnsemble<DIM>::ImmersedBoundaryEnsemble()
+    : mNumThreads(1u),
+      mOutputDirectory(""),
+      mDt(0.01),
+      mEndTime(0.0),
+      mpFftInterface(NULL)
+{
+}
+
+template<unsigned DIM>
+ImmersedBoundaryEnsemble<DIM>::~ImmersedBoundaryEnsemble()
+{
+    if (mpFftInterface)
+    {
+        delete mpFftInterface;
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryEnsemble<DIM>::AddMember(ImmersedBoundaryCellPopulation<DIM>& rCellPopulation,
+                                              boost::shared_ptr<ImmersedBoundarySimulationModifier<DIM> > pModifier)
+{
+    if (mpFftInterface)
+    {
+        EXCEPTION("Members cannot be added to an ensemble once it has been solved");
+    }
+
+    if (!mCellPopulations.empty())
+    {
+        ImmersedBoundaryCellPopulation<DIM>* p_first = mCellPopulations[0];
+        if (rCellPopulation.rGetMesh().GetNumGridPtsX() != p_first->rGetMesh().GetNumGridPtsX() ||
+            rCellPopulation.rGetMesh().GetNumGridPtsY() != p_first->rGetMesh().GetNumGridPtsY())
+        {
+            EXCEPTION("Each member of an ensemble must have the same fluid grid size");
+        }
+        if (rCellPopulation.DoesPopulationHaveActiveSources() != p_first->DoesPopulationHaveActiveSources())
+        {
+            EXCEPTION("Either every member of an ensemble or none must have active fluid sources");
+        }
+    }
+
+    mCellPopulations.push_back(&rCellPopulation);
+    mModifiers.push_back(pModifier);
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundaryEnsemble<DIM>::GetNumMembers() const
+{
+    return mCellPopulations.size();
+}
+
+template<unsigned DIM>
+ImmersedBoundaryCellPopulation<DIM>& ImmersedBoundaryEnsemble<DIM>::rGetCellPopulation(unsigned memberIndex)
+{
+    assert(memberIndex < mCellPopulations.size());
+    return *(mCellPopulations[memberIndex]);
+}
+
+template<unsigned DIM>
+boost::shared_ptr<ImmersedBoundarySimulationModifier<DIM> > ImmersedBoundaryEnsemble<DIM>::GetModifier(unsigned memberIndex)
+{
+    assert(memberIndex < mModifiers.size());
+    return mModifiers[memberIndex];
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryEnsemble<DIM>::SetNumThreads(unsigned numThreads)
+{
+    assert(numThreads > 0);
+    mNumThreads = numThreads;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundaryEnsemble<DIM>::GetNumThreads() const
+{
+    return mNumThreads;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryEnsemble<DIM>::SetOutputDirectory(const std::string& rOutputDirectory)
+{
+    mOutputDirectory = rOutputDirectory;
+}
+
+template<unsigned DIM>
+const std::string& ImmersedBoundaryEnsemble<DIM>::rGetOutputDirectory() const
+{
+    return mOutputDirectory;
+}
+
+template<unsigned DIM>
+std::string ImmersedBoundaryEnsemble<DIM>::GetMemberOutputDirectory(unsigned memberIndex) const
+{
+    std::stringstream directory;
+    directory << mOutputDirectory << "/member_" << memberIndex;
+    return directory.str();
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryEnsemble<DIM>::SetDt(double dt)
+{
+    assert(dt > 0.0);
+    mDt = dt;
+}
+
+template<unsigned DIM>
+double ImmersedBoundaryEnsemble<DIM>::GetDt() const
+{
+    return mDt;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryEnsemble<DIM>::SetEndTime(double endTime)
+{
+    assert(endTime > 0.0);
+    mEndTime = endTime;
+}
+
+template<unsigned DIM>
+double ImmersedBoundaryEnsemble<DIM>::GetEndTime() const
+{
+    return mEndTime;
+}
+
+template<unsigned DIM>
+const ImmersedBoundaryFftInterface<DIM>* ImmersedBoundaryEnsemble<DIM>::GetFftInterface() const
+{
+    return mpFftInterface;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryEnsemble<DIM>::SetupFftInterface()
+{
+    if (mpFftInterface == NULL)
+    {
+        ImmersedBoundaryMesh<DIM,DIM>* p_mesh = &(mCellPopulations[0]->rGetMesh());
+        bool active_sources = mCellPopulations[0]->DoesPopulationHaveActiveSources();
+
+        int num_gridpts_x = (int)p_mesh->GetNumGridPtsX();
+        int num_gridpts_y = (int)p_mesh->GetNumGridPtsY();
+        int reduced_y = 1 + (num_gridpts_y/2);
+
+        // The grids have the shapes of those of each member, for which the plans are then executed
+        mPlanningInputGrids.resize(extents[2 + (int)active_sources][num_gridpts_x][num_gridpts_y]);
+        mPlanningFourierGrids.resize(extents[2 + (int)active_sources][num_gridpts_x][reduced_y]);
+        mPlanningOutputGrids.resize(extents[2][num_gridpts_x][num_gridpts_y]);
+
+        // The members are advanced concurrently, so each transform is planned for a single thread
+        mpFftInterface = new ImmersedBoundaryFftInterface<DIM>(p_mesh,
+                                                               &(mPlanningInputGrids[0][0][0]),
+                                                               &(mPlanningFourierGrids[0][0][0]),
+                                                               &(mPlanningOutputGrids[0][0][0]),
+                                                               1u,
+                                                               active_sources);
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryEnsemble<DIM>::AdvanceMembers(MemberStage stage)
+{
+    int num_members = (int)mCellPopulations.size();
+    std::string error_message;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(mNumThreads) schedule(dynamic)
+#endif
+    for (int member = 0; member < num_members; member++)
+    {
+        try
+        {
+            if (stage == UPDATE_NODE_LOCATIONS)
+            {
+                mCellPopulations[member]->UpdateNodeLocations(mDt);
+            }
+            else
+            {
+                mModifiers[member]->UpdateAtEndOfTimeStep(*(mCellPopulations[member]));
+            }
+        }
+        catch (Exception& e)
+        {
+#ifdef _OPENMP
+#pragma omp critical(ImmersedBoundaryEnsembleError)
+#endif
+            {
+                if (error_message.empty())
+                {
+                    std::stringstream message;
+                    message << "Member " << member << " of the ensemble failed: " << e.GetShortMessage();
+                    error_message = message.str();
+                }
+            }
+        }
+    }
+
+    if (!error_message.empty())
+    {
+        EXCEPTION(error_message);
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryEnsemble<DIM>::Solve()
+{
+    if (mCellPopulations.empty())
+    {
+        EXCEPTION("An ensemble must have at least one member to be solved");
+    }
+    if (mEndTime == 0.0)
+    {
+        EXCEPTION("SetEndTime has not yet been called.");
+    }
+    if (mOutputDirectory == "")
+    {
+        EXCEPTION("OutputDirectory not set");
+    }
+
+    for (unsigned member = 0; member < mModifiers.size(); member++)
+    {
+        if (mModifiers[member]->GetUseSinglePrecisionFluid())
+        {
+            EXCEPTION("Member " << member << " of the ensemble solves the fluid in single precision");
+        }
+        if (mModifiers[member]->GetUseAdaptiveTimestep())
+        {
+            EXCEPTION("Member " << member << " of the ensemble adapts its timestep, which the members must share");
+        }
+    }
+
+    // Set up SimulationTime as AbstractCellBasedSimulation::Solve() does
+    SimulationTime* p_simulation_time = SimulationTime::Instance();
+    double current_time = p_simulation_time->GetTime();
+    unsigned num_time_steps = (unsigned) ((mEndTime - current_time)/mDt + 0.5);
+    if (current_time > 0.0)
+    {
+        p_simulation_time->ResetEndTimeAndNumberOfTimeSteps(mEndTime, num_time_steps);
+    }
+    else
+    {
+        p_simulation_time->SetEndTimeAndNumberOfTimeSteps(mEndTime, num_time_steps);
+    }
+
+    // Planning is not thread-safe, so the transforms are planned, and the members set up, one at a time
+    SetupFftInterface();
+    for (unsigned member = 0; member < mModifiers.size(); member++)
+    {
+        OutputFileHandler output_file_handler(GetMemberOutputDirectory(member), true);
+
+        mModifiers[member]->SetSharedFftInterface(mpFftInterface);
+        mModifiers[member]->SetupSolve(*(mCellPopulations[member]), GetMemberOutputDirectory(member));
+    }
+
+    // Each timestep follows that of OffLatticeSimulation, with each stage applied to every member before the next
+    while (!p_simulation_time->IsFinished())
+    {
+        AdvanceMembers(UPDATE_NODE_LOCATIONS);
+        p_simulation_time->IncrementTimeOneStep();
+        AdvanceMembers(UPDATE_AT_END_OF_TIME_STEP);
+    }
+}
+
+// Explicit instantiation
+template class ImmersedBoundaryEnsemble<1>;
+template class ImmersedBoundaryEnsemble<2>;
+template class ImmersedBoundaryEnsemble<3>;
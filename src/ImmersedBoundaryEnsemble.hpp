@@ -0,0 +1,227 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYENSEMBLE_HPP_
+#define IMMERSEDBOUNDARYENSEMBLE_HPP_
+
+#include <complex>
+#include <string>
+#include <vector>
+#include <boost/multi_array.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "ImmersedBoundaryCellPopulation.hpp"
+#include "ImmersedBoundaryFftInterface.hpp"
+#include "ImmersedBoundarySimulationModifier.hpp"
+
+/**
+ * Advances a number of independent immersed boundary simulations of the same size in lockstep, in one process.
+ *
+ * This is intended for parameter sweeps, in which many small simulations differ only in, say, their force parameters
+ * or Reynolds number.  Each member of the ensemble is a cell population and the simulation modifier solving its fluid
+ * problem, which may be set up exactly as for an OffLatticeSimulation.  The ensemble plans the discrete Fourier
+ * transforms once, and every member then executes the same fftw plans on its own grids, so no member plans its own
+ * transforms.  Each timestep, the node updates and then the fluid solves of all members are spread over
+ * #mNumThreads threads, so the threaded kernels within each member are best left on one thread.
+ *
+ * All members must have the same fluid grid size and source mode, solve the fluid in double precision and use the
+ * fixed timestep of the ensemble.  The cells of the members are not updated, so cells should neither divide nor die;
+ * results may be taken from the populations once Solve() returns, or written by each modifier as its grid output and
+ * checkpoints, in the directory given by GetMemberOutputDirectory().  The modifiers execute plans owned by the
+ * ensemble, so must not be used once the ensemble has been destroyed.
+ */
+template<unsigned DIM>
+class ImmersedBoundaryEnsemble
+{
+private:
+
+    /** The stages of a timestep that are applied to every member in turn. */
+    enum MemberStage
+    {
+        UPDATE_NODE_LOCATIONS,
+        UPDATE_AT_END_OF_TIME_STEP
+    };
+
+    /** The cell population of each member, which are not owned by the ensemble. */
+    std::vector<ImmersedBoundaryCellPopulation<DIM>*> mCellPopulations;
+
+    /** The simulation modifier of each member. */
+    std::vector<boost::shared_ptr<ImmersedBoundarySimulationModifier<DIM> > > mModifiers;
+
+    /** The number of threads over which the members are advanced.  Defaults to 1. */
+    unsigned mNumThreads;
+
+    /** The output directory, relative to the Chaste test output directory, in which each member has a directory. */
+    std::string mOutputDirectory;
+
+    /** The timestep.  Defaults to 0.01. */
+    double mDt;
+
+    /** The end time, which must be set before Solve() is called. */
+    double mEndTime;
+
+    /** The interface whose plans every member executes, created by the first call to Solve(). */
+    ImmersedBoundaryFftInterface<DIM>* mpFftInterface;
+
+    /** The real input grids for which #mpFftInterface is planned. */
+    multi_array<double, 3> mPlanningInputGrids;
+
+    /** The Fourier grids for which #mpFftInterface is planned. */
+    multi_array<std::complex<double>, 3> mPlanningFourierGrids;
+
+    /** The real output grids for which #mpFftInterface is planned. */
+    multi_array<double, 3> mPlanningOutputGrids;
+
+    /**
+     * Helper method for Solve().  Plans the transforms shared by every member, if they have not yet been planned.
+     */
+    void SetupFftInterface();
+
+    /**
+     * Helper method for Solve().  Applies a stage of the timestep to every member, spread over #mNumThreads threads.
+     * If the stage throws for any member, an exception is thrown once every member has been advanced.  The warnings
+     * the members raise are serialised in the critical section ImmersedBoundaryWarnings.
+     *
+     * @param stage the stage to apply
+     */
+    void AdvanceMembers(MemberStage stage);
+
+public:
+
+    /**
+     * Constructor.
+     */
+    ImmersedBoundaryEnsemble();
+
+    /**
+     * Destructor.
+     */
+    ~ImmersedBoundaryEnsemble();
+
+    /**
+     * Add a member to the ensemble.  The members must all have the same fluid grid size and source mode.
+     *
+     * @param rCellPopulation the cell population of the member, which must outlive the ensemble
+     * @param pModifier the simulation modifier of the member, with its forces added
+     */
+    void AddMember(ImmersedBoundaryCellPopulation<DIM>& rCellPopulation,
+                   boost::shared_ptr<ImmersedBoundarySimulationModifier<DIM> > pModifier);
+
+    /**
+     * @return the number of members
+     */
+    unsigned GetNumMembers() const;
+
+    /**
+     * @return the cell population of a member
+     *
+     * @param memberIndex the index of the member
+     */
+    ImmersedBoundaryCellPopulation<DIM>& rGetCellPopulation(unsigned memberIndex);
+
+    /**
+     * @return the simulation modifier of a member
+     *
+     * @param memberIndex the index of the member
+     */
+    boost::shared_ptr<ImmersedBoundarySimulationModifier<DIM> > GetModifier(unsigned memberIndex);
+
+    /**
+     * Set #mNumThreads.  This has an effect only when built with OpenMP.
+     *
+     * @param numThreads the number of threads over which the members are advanced
+     */
+    void SetNumThreads(unsigned numThreads);
+
+    /**
+     * @return #mNumThreads
+     */
+    unsigned GetNumThreads() const;
+
+    /**
+     * Set #mOutputDirectory.
+     *
+     * @param rOutputDirectory the output directory
+     */
+    void SetOutputDirectory(const std::string& rOutputDirectory);
+
+    /**
+     * @return #mOutputDirectory
+     */
+    const std::string& rGetOutputDirectory() const;
+
+    /**
+     * @return the output directory of a member, which is passed to the SetupSolve() method of its modifier
+     *
+     * @param memberIndex the index of the member
+     */
+    std::string GetMemberOutputDirectory(unsigned memberIndex) const;
+
+    /**
+     * Set #mDt.
+     *
+     * @param dt the timestep
+     */
+    void SetDt(double dt);
+
+    /**
+     * @return #mDt
+     */
+    double GetDt() const;
+
+    /**
+     * Set #mEndTime.
+     *
+     * @param endTime the end time
+     */
+    void SetEndTime(double endTime);
+
+    /**
+     * @return #mEndTime
+     */
+    double GetEndTime() const;
+
+    /**
+     * @return #mpFftInterface, or NULL before Solve() has been called
+     */
+    const ImmersedBoundaryFftInterface<DIM>* GetFftInterface() const;
+
+    /**
+     * Set up each member as an OffLatticeSimulation would, and advance every member to the end time.
+     */
+    void Solve();
+};
+
+#endif /*IMMERSEDBOUNDARYENSEMBLE_HPP_*/
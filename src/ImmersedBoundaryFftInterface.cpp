@@ -34,87 +34,185 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "ImmersedBoundaryFftInterface.hpp"
+#include <algorithm>
 #include <assert.h>
-#include "FileFinder.hpp"
+#include <cstdio>
+#include <limits>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+#include "OutputFileHandler.hpp"
+#include "PetscTools.hpp"
 #include "Warnings.hpp"
 
-template<unsigned DIM>
-ImmersedBoundaryFftInterface<DIM>::ImmersedBoundaryFftInterface(ImmersedBoundaryMesh<DIM,DIM>* pMesh,
-                                                                double* pIn,
-                                                                std::complex<double>* pComplex,
-                                                                double* pOut,
-                                                                bool multiThread,
-                                                                bool activeSources)
-    : mThreadErrors(multiThread ? fftw_init_threads() : 1),
-      mpMesh(pMesh),
-      mpInputArray(pIn),
-      mpComplexArray(reinterpret_cast<fftw_complex*>(pComplex)),
-      mpOutputArray(pOut),
-      mMultiThread(multiThread)
+/** The mutex serialising use of the fftw planner, which is not thread-safe, by every interface. */
+static pthread_mutex_t fftw_planner_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Locks the fftw planner for the lifetime of the object.
+ */
+class FftwPlannerLock
 {
-    /*
-     * Set up fftw routines
-     */
+public:
 
-    // If more than one thread, the following must happen before any other fftw routines
-    if (mMultiThread)
+    /** Constructor.  Waits for and locks the planner. */
+    FftwPlannerLock()
     {
-//        int potential_thread_errors = fftw_init_threads();
-
-        // 1 means success, 0 indicates a failure
-        if (mThreadErrors != 1)
-        {
-            EXCEPTION("fftw thread error");
-        }
+        pthread_mutex_lock(&fftw_planner_mutex);
+    }
 
-        // Plan with number of threads equal to the max number of arrays to transform
-        fftw_plan_with_nthreads(2 + (int)activeSources);
+    /** Destructor.  Unlocks the planner. */
+    ~FftwPlannerLock()
+    {
+        pthread_mutex_unlock(&fftw_planner_mutex);
     }
+};
 
-    // Forget all wisdom; the correct wisdom for the number of threads used will be loaded from file
-    void fftw_forget_wisdom();
+template<unsigned DIM, typename SCALAR>
+ImmersedBoundaryFftInterface<DIM, SCALAR>::ImmersedBoundaryFftInterface(ImmersedBoundaryMesh<DIM,DIM>* pMesh,
+                                                                        SCALAR* pIn,
+                                                                        std::complex<SCALAR>* pComplex,
+                                                                        SCALAR* pOut,
+                                                                        unsigned numThreads,
+                                                                        bool activeSources,
+                                                                        bool fastStart)
+    : mThreadErrors(numThreads > 1 ? Traits::InitThreads() : 1),
+      mpMesh(pMesh),
+      mpInputArray(pIn),
+      mpComplexArray(reinterpret_cast<typename Traits::Complex*>(pComplex)),
+      mpOutputArray(pOut),
+      mUsesRealTransforms(false),
+      mMultiThread(numThreads > 1),
+      mNumThreads(numThreads),
+      mWisdomWasImportedFromCache(false),
+      mOwnsPlans(true),
+      mNumGridPtsX((int)pMesh->GetNumGridPtsX()),
+      mNumGridPtsY((int)pMesh->GetNumGridPtsY()),
+      mActiveSources(activeSources),
+      mUpgradeInProgress(false),
+      mUpgradeFinished(false),
+      mPlansWereUpgraded(false)
+{
+    FftwPlannerLock lock;
+
+    SetupThreads();
+
+    // We require an even number of grid points
+    assert(mNumGridPtsY % 2 == 0);
 
-    // Path to the wisdom file
-    std::string wisdom_path;
-    std::string wisdom_filename;
+    mWisdomCacheFile = ImportWisdom(GetWisdomCacheFilename(mNumGridPtsX, mNumGridPtsY, mNumThreads, mActiveSources));
 
-    if (!mMultiThread)
+    if (fastStart && !mWisdomWasImportedFromCache)
     {
-        wisdom_filename = "fftw.wisdom";
+        // Planning with FFTW_ESTIMATE is immediate and leaves the arrays alone; better plans are made in the background
+        Plan2dTransforms(mNumGridPtsX, mNumGridPtsY, mActiveSources, mpInputArray, mpComplexArray, mpOutputArray,
+                         FFTW_ESTIMATE, mFftwForwardPlan, mFftwInversePlan);
+
+        pthread_mutex_init(&mUpgradeMutex, NULL);
+        if (pthread_create(&mUpgradeThread, NULL, UpgradeThreadFunction, this) == 0)
+        {
+            mUpgradeInProgress = true;
+        }
+        else
+        {
+            pthread_mutex_destroy(&mUpgradeMutex);
+            WARNING("Unable to start a thread to upgrade the fftw plans, so FFTW_ESTIMATE plans are used throughout");
+        }
     }
     else
     {
-        wisdom_filename = "fftw_threads.wisdom";
+        Plan2dTransforms(mNumGridPtsX, mNumGridPtsY, mActiveSources, mpInputArray, mpComplexArray, mpOutputArray,
+                         FFTW_PATIENT, mFftwForwardPlan, mFftwInversePlan);
+
+        if (!mWisdomWasImportedFromCache)
+        {
+            ExportWisdom(mWisdomCacheFile);
+        }
     }
+}
 
-    FileFinder file_finder(wisdom_filename, RelativeTo::ChasteTestOutput);
+template<unsigned DIM, typename SCALAR>
+ImmersedBoundaryFftInterface<DIM, SCALAR>::ImmersedBoundaryFftInterface(const ImmersedBoundaryFftInterface<DIM,SCALAR>& rPlannedInterface,
+                                                                        SCALAR* pIn,
+                                                                        std::complex<SCALAR>* pComplex,
+                                                                        SCALAR* pOut,
+                                                                        bool activeSources)
+    : mThreadErrors(rPlannedInterface.mThreadErrors),
+      mpMesh(rPlannedInterface.mpMesh),
+      mFftwForwardPlan(rPlannedInterface.mFftwForwardPlan),
+      mFftwInversePlan(rPlannedInterface.mFftwInversePlan),
+      mpInputArray(pIn),
+      mpComplexArray(reinterpret_cast<typename Traits::Complex*>(pComplex)),
+      mpOutputArray(pOut),
+      mUsesRealTransforms(false),
+      mMultiThread(rPlannedInterface.mMultiThread),
+      mNumThreads(rPlannedInterface.mNumThreads),
+      mWisdomWasImportedFromCache(rPlannedInterface.mWisdomWasImportedFromCache),
+      mOwnsPlans(false),
+      mNumGridPtsX(rPlannedInterface.mNumGridPtsX),
+      mNumGridPtsY(rPlannedInterface.mNumGridPtsY),
+      mActiveSources(activeSources),
+      mWisdomCacheFile(rPlannedInterface.mWisdomCacheFile),
+      mUpgradeInProgress(false),
+      mUpgradeFinished(false),
+      mPlansWereUpgraded(false)
+{
+    assert(rPlannedInterface.mpMesh != NULL);
+    assert(activeSources == rPlannedInterface.mActiveSources);
 
-    if (!file_finder.IsFile())
+    // Real-to-real plans are specific to the contiguous grids they were planned for, so are never shared
+    if (rPlannedInterface.mUsesRealTransforms)
     {
-//        WARNING("It is strongly recommended to generate wisdom using TestGenerateFftwWisdom before using this code.");
+        EXCEPTION("The fftw plans of an interface using real-to-real transforms cannot be shared");
     }
 
-    wisdom_path = file_finder.GetAbsolutePath();
+    // The plans being upgraded are destroyed when the upgraded plans are swapped in
+    if (rPlannedInterface.mUpgradeInProgress)
+    {
+        EXCEPTION("The fftw plans of an interface cannot be shared while they are being upgraded");
+    }
 
-    int wisdom_flag = fftw_import_wisdom_from_filename(wisdom_path.c_str());
+    // fftw may execute a plan on new arrays only if they are aligned as the arrays it was planned for
+    bool aligned = Traits::AlignmentOf(mpInputArray) == Traits::AlignmentOf(rPlannedInterface.mpInputArray) &&
+                   Traits::AlignmentOf(reinterpret_cast<SCALAR*>(mpComplexArray)) ==
+                       Traits::AlignmentOf(reinterpret_cast<SCALAR*>(rPlannedInterface.mpComplexArray)) &&
+                   Traits::AlignmentOf(mpOutputArray) == Traits::AlignmentOf(rPlannedInterface.mpOutputArray);
 
-    // 1 means success, 0 indicates a failure
-    if (wisdom_flag != 1)
+    if (!aligned)
     {
-//        WARNING("fftw wisdom not imported correctly");
-    }
+        // Any wisdom accumulated planning the shared transforms is still loaded, so planning is quick
+        FftwPlannerLock lock;
+        SetupThreads();
+        Plan2dTransforms(mNumGridPtsX, mNumGridPtsY, mActiveSources, mpInputArray, mpComplexArray, mpOutputArray,
+                         FFTW_PATIENT, mFftwForwardPlan, mFftwInversePlan);
+        mOwnsPlans = true;
 
-    int num_gridpts_x = (int)mpMesh->GetNumGridPtsX();
-    int num_gridpts_y = (int)mpMesh->GetNumGridPtsY();
+        // Planning for the new alignment may have added to the wisdom, even if the rest came from the cache
+        ExportWisdom(mWisdomCacheFile);
+    }
+}
 
-    // We require an even number of grid points
-    assert(num_gridpts_y % 2 == 0);
+template<unsigned DIM, typename SCALAR>
+void ImmersedBoundaryFftInterface<DIM, SCALAR>::Plan2dTransforms(int numGridPtsX, int numGridPtsY, bool activeSources,
+                                                                 SCALAR* pIn, typename Traits::Complex* pComplex,
+                                                                 SCALAR* pOut, unsigned flags,
+                                                                 typename Traits::Plan& rForwardPlan,
+                                                                 typename Traits::Plan& rInversePlan)
+{
+    rForwardPlan = Plan2dTransform(true, numGridPtsX, numGridPtsY, activeSources, pIn, pComplex, pOut, flags);
+    rInversePlan = Plan2dTransform(false, numGridPtsX, numGridPtsY, activeSources, pIn, pComplex, pOut, flags);
+}
 
+template<unsigned DIM, typename SCALAR>
+typename ImmersedBoundaryFftwTraits<SCALAR>::Plan ImmersedBoundaryFftInterface<DIM, SCALAR>::Plan2dTransform(
+        bool forward, int numGridPtsX, int numGridPtsY, bool activeSources,
+        SCALAR* pIn, typename Traits::Complex* pComplex, SCALAR* pOut, unsigned flags)
+{
     /*
      * Resize the grids.  All complex grids are half-sized in the y-coordinate due to redundancy inherent in the
      * fast-Fourier method for solving Navier-Stokes.
      */
-    int reduced_y = 1 + (num_gridpts_y/2);
+    int reduced_y = 1 + (numGridPtsY/2);
 
     /*
      * Plan the discrete Fourier transforms:
@@ -129,48 +227,631 @@ ImmersedBoundaryFftInterface<DIM>::ImmersedBoundaryFftInterface(ImmersedBoundary
 
     // Plan variables
     int rank = 2;                                       // Number of dimensions for each array
-    int real_dims[] = {num_gridpts_x, num_gridpts_y};   // Dimensions of each real array
-    int comp_dims[] = {num_gridpts_x, reduced_y};       // Dimensions of each complex array
+    int real_dims[] = {numGridPtsX, numGridPtsY};       // Dimensions of each real array
+    int comp_dims[] = {numGridPtsX, reduced_y};         // Dimensions of each complex array
     int how_many_forward = 2 + (int)activeSources;      // Number of forward transforms (one more if sources are active)
     int how_many_inverse = 2;                           // Number of inverse transforms (always 2)
-    int real_sep = num_gridpts_x * num_gridpts_y;       // How many doubles between start of first array and start of second
-    int comp_sep = num_gridpts_x * reduced_y;           // How many fftw_complex between start of first array and start of second
+    int real_sep = numGridPtsX * numGridPtsY;           // How many doubles between start of first array and start of second
+    int comp_sep = numGridPtsX * reduced_y;             // How many fftw_complex between start of first array and start of second
     int real_stride = 1;                                // Each real array is contiguous in memory
     int comp_stride = 1;                                // Each complex array is contiguous in memory
     int* real_nembed = real_dims;
     int* comp_nembed = comp_dims;
 
-    mFftwForwardPlan = fftw_plan_many_dft_r2c(rank, real_dims, how_many_forward,
-                                              mpInputArray,   real_nembed, real_stride, real_sep,
-                                              mpComplexArray, comp_nembed, comp_stride, comp_sep,
-                                              FFTW_PATIENT);
+    if (forward)
+    {
+        return Traits::PlanManyR2c(rank, real_dims, how_many_forward,
+                                   pIn,      real_nembed, real_stride, real_sep,
+                                   pComplex, comp_nembed, comp_stride, comp_sep,
+                                   flags);
+    }
+
+    return Traits::PlanManyC2r(rank, real_dims, how_many_inverse,
+                               pComplex, comp_nembed, comp_stride, comp_sep,
+                               pOut,     real_nembed, real_stride, real_sep,
+                               flags);
+}
+
+template<unsigned DIM, typename SCALAR>
+void* ImmersedBoundaryFftInterface<DIM, SCALAR>::UpgradeThreadFunction(void* pInterface)
+{
+    static_cast<ImmersedBoundaryFftInterface<DIM, SCALAR>*>(pInterface)->PlanOnScratchArrays();
+    return NULL;
+}
+
+template<unsigned DIM, typename SCALAR>
+void ImmersedBoundaryFftInterface<DIM, SCALAR>::PlanOnScratchArrays()
+{
+    std::vector<std::string> wisdom;
+
+    try
+    {
+        /*
+         * Planning with FFTW_PATIENT overwrites the arrays, so it is done on scratch arrays laid out as the real ones.
+         * Arrays whose storage overlaps, such as the input and output grids in the low-memory layout, are grouped, and
+         * each group is given a block of scratch storage in which its arrays have the same offsets.  Each block starts
+         * as far past a cache line as the storage it stands in for, so fftw sees the same alignment.
+         */
+        int real_size = mNumGridPtsX * mNumGridPtsY;
+        int comp_size = mNumGridPtsX * (1 + mNumGridPtsY/2);
+        int how_many_forward = 2 + (int)mActiveSources;
+
+        const unsigned num_arrays = 3;
+        std::size_t starts[num_arrays] = {reinterpret_cast<std::size_t>(mpInputArray),
+                                          reinterpret_cast<std::size_t>(mpComplexArray),
+                                          reinterpret_cast<std::size_t>(mpOutputArray)};
+        std::size_t ends[num_arrays] = {starts[0] + how_many_forward * real_size * sizeof(SCALAR),
+                                        starts[1] + how_many_forward * comp_size * sizeof(typename Traits::Complex),
+                                        starts[2] + 2 * real_size * sizeof(SCALAR)};
+
+        // Merge overlapping arrays into groups, each labelled by its lowest-numbered array
+        unsigned groups[num_arrays] = {0, 1, 2};
+        for (unsigned i = 0; i < num_arrays; i++)
+        {
+            for (unsigned j = i + 1; j < num_arrays; j++)
+            {
+                if (starts[i] < ends[j] && starts[j] < ends[i] && groups[j] != groups[i])
+                {
+                    unsigned old_group = groups[j];
+                    for (unsigned k = 0; k < num_arrays; k++)
+                    {
+                        groups[k] = (groups[k] == old_group) ? groups[i] : groups[k];
+                    }
+                }
+            }
+        }
+
+        const std::size_t alignment = ImmersedBoundaryAlignedAllocator<char>::ALIGNMENT;
+        std::vector<char, ImmersedBoundaryAlignedAllocator<char> > blocks[num_arrays];
+        char* scratch[num_arrays];
+        for (unsigned group = 0; group < num_arrays; group++)
+        {
+            std::size_t group_start = std::numeric_limits<std::size_t>::max();
+            std::size_t group_end = 0;
+            for (unsigned i = 0; i < num_arrays; i++)
+            {
+                if (groups[i] == group)
+                {
+                    group_start = std::min(group_start, starts[i]);
+                    group_end = std::max(group_end, ends[i]);
+                }
+            }
+
+            if (group_end > 0)
+            {
+                std::size_t offset = group_start % alignment;
+                blocks[group].resize(offset + group_end - group_start);
+                for (unsigned i = 0; i < num_arrays; i++)
+                {
+                    if (groups[i] == group)
+                    {
+                        scratch[i] = &blocks[group][offset + starts[i] - group_start];
+                    }
+                }
+            }
+        }
+
+        SCALAR* p_input = reinterpret_cast<SCALAR*>(scratch[0]);
+        typename Traits::Complex* p_complex = reinterpret_cast<typename Traits::Complex*>(scratch[1]);
+        SCALAR* p_output = reinterpret_cast<SCALAR*>(scratch[2]);
+
+        // The planner is locked for each transform in turn, so other interfaces are not held up for the whole upgrade
+        for (unsigned transform = 0; transform < 2; transform++)
+        {
+            FftwPlannerLock lock;
+
+            if (mMultiThread)
+            {
+                Traits::PlanWithNThreads((int)mNumThreads);
+            }
+
+            typename Traits::Plan plan = Plan2dTransform(transform == 0, mNumGridPtsX, mNumGridPtsY, mActiveSources,
+                                                         p_input, p_complex, p_output, FFTW_PATIENT);
+
+            // Only the wisdom is needed, which another interface may forget before the plans are swapped in
+            if (plan)
+            {
+                wisdom.push_back(Traits::ExportWisdomToString());
+                Traits::DestroyPlan(plan);
+            }
+        }
+    }
+    catch (...)
+    {
+        // If the scratch arrays cannot be allocated, the existing plans are kept
+    }
+
+    pthread_mutex_lock(&mUpgradeMutex);
+    mUpgradedWisdom.swap(wisdom);
+    mUpgradeFinished = true;
+    pthread_mutex_unlock(&mUpgradeMutex);
+}
+
+template<unsigned DIM, typename SCALAR>
+void ImmersedBoundaryFftInterface<DIM, SCALAR>::SwapInUpgradedPlans()
+{
+    assert(mUpgradeInProgress);
+
+    pthread_join(mUpgradeThread, NULL);
+    pthread_mutex_destroy(&mUpgradeMutex);
+    mUpgradeInProgress = false;
+
+    FftwPlannerLock lock;
+
+    if (mMultiThread)
+    {
+        Traits::PlanWithNThreads((int)mNumThreads);
+    }
+
+    for (unsigned i = 0; i < mUpgradedWisdom.size(); i++)
+    {
+        // Failure here just means the existing plans are kept
+        Traits::ImportWisdomFromString(mUpgradedWisdom[i]);
+    }
+    mUpgradedWisdom.clear();
+
+    // With the wisdom in place, planning is immediate and the arrays are left alone
+    typename Traits::Plan forward_plan;
+    typename Traits::Plan inverse_plan;
+    Plan2dTransforms(mNumGridPtsX, mNumGridPtsY, mActiveSources, mpInputArray, mpComplexArray, mpOutputArray,
+                     FFTW_PATIENT | FFTW_WISDOM_ONLY, forward_plan, inverse_plan);
+
+    if (forward_plan && inverse_plan)
+    {
+        Traits::DestroyPlan(mFftwForwardPlan);
+        Traits::DestroyPlan(mFftwInversePlan);
+        mFftwForwardPlan = forward_plan;
+        mFftwInversePlan = inverse_plan;
+        mPlansWereUpgraded = true;
+    }
+    else
+    {
+        if (forward_plan)
+        {
+            Traits::DestroyPlan(forward_plan);
+        }
+        if (inverse_plan)
+        {
+            Traits::DestroyPlan(inverse_plan);
+        }
+    }
+
+    ExportWisdom(mWisdomCacheFile);
+}
+
+template<unsigned DIM, typename SCALAR>
+ImmersedBoundaryFftInterface<DIM, SCALAR>::ImmersedBoundaryFftInterface(unsigned numGridPtsX,
+                                                                        unsigned numGridPtsY,
+                                                                        bool wallsX,
+                                                                        bool wallsY,
+                                                                        SCALAR* pInOut,
+                                                                        SCALAR* pOut,
+                                                                        unsigned numThreads,
+                                                                        bool activeSources)
+    : mThreadErrors(numThreads > 1 ? Traits::InitThreads() : 1),
+      mpMesh(NULL),
+      mpInputArray(pInOut),
+      mpComplexArray(NULL),
+      mpOutputArray(pOut),
+      mUsesRealTransforms(true),
+      mMultiThread(numThreads > 1),
+      mNumThreads(numThreads),
+      mWisdomWasImportedFromCache(false),
+      mOwnsPlans(true),
+      mNumGridPtsX((int)numGridPtsX),
+      mNumGridPtsY((int)numGridPtsY),
+      mActiveSources(activeSources),
+      mUpgradeInProgress(false),
+      mUpgradeFinished(false),
+      mPlansWereUpgraded(false)
+{
+    assert(wallsX || wallsY);
+
+    FftwPlannerLock lock;
+
+    SetupThreads();
+
+    // In a periodic direction, the real-to-halfcomplex coefficients are paired up assuming an even number of points
+    assert((wallsX || numGridPtsX % 2 == 0) && (wallsY || numGridPtsY % 2 == 0));
+
+    std::stringstream cache_filename;
+    cache_filename << Traits::GetWisdomPrefix() << "_" << numGridPtsX << "x" << numGridPtsY
+                   << "_threads_" << mNumThreads
+                   << "_howmany_" << 2 + (unsigned)activeSources
+                   << "_walls_" << (wallsX ? "x" : "") << (wallsY ? "y" : "")
+                   << ".wisdom";
+
+    FileFinder cache_file = ImportWisdom(cache_filename.str());
+
+    /*
+     * The velocity component normal to a wall is odd about it, so is transformed with sines (DST-II, inverted by
+     * DST-III) in that direction; every other grid is even about the walls, so is transformed with cosines (DCT-II,
+     * inverted by DCT-III).  Periodic directions use the real-to-halfcomplex transform and its inverse.
+     */
+    fftw_r2r_kind odd_forward_x = wallsX ? FFTW_RODFT10 : FFTW_R2HC;
+    fftw_r2r_kind even_forward_x = wallsX ? FFTW_REDFT10 : FFTW_R2HC;
+    fftw_r2r_kind odd_forward_y = wallsY ? FFTW_RODFT10 : FFTW_R2HC;
+    fftw_r2r_kind even_forward_y = wallsY ? FFTW_REDFT10 : FFTW_R2HC;
+    fftw_r2r_kind odd_inverse_x = wallsX ? FFTW_RODFT01 : FFTW_HC2R;
+    fftw_r2r_kind even_inverse_x = wallsX ? FFTW_REDFT01 : FFTW_HC2R;
+    fftw_r2r_kind odd_inverse_y = wallsY ? FFTW_RODFT01 : FFTW_HC2R;
+    fftw_r2r_kind even_inverse_y = wallsY ? FFTW_REDFT01 : FFTW_HC2R;
+
+    // The kinds for the x velocity, y velocity and source grids, in the x then y directions
+    fftw_r2r_kind forward_kinds[3][2] = {{odd_forward_x, even_forward_y},
+                                         {even_forward_x, odd_forward_y},
+                                         {even_forward_x, even_forward_y}};
+    fftw_r2r_kind inverse_kinds[2][2] = {{odd_inverse_x, even_inverse_y},
+                                         {even_inverse_x, odd_inverse_y}};
+
+    int rank = 2;
+    int real_dims[] = {(int)numGridPtsX, (int)numGridPtsY};
+    int real_sep = (int)numGridPtsX * (int)numGridPtsY;
+
+    for (unsigned grid = 0; grid < 3; grid++)
+    {
+        mRealForwardPlans[grid] = NULL;
+        if (grid < 2 || activeSources)
+        {
+            SCALAR* p_grid = mpInputArray + grid * real_sep;
+            mRealForwardPlans[grid] = Traits::PlanManyR2r(rank, real_dims, 1,
+                                                          p_grid, real_dims, 1, real_sep,
+                                                          p_grid, real_dims, 1, real_sep,
+                                                          forward_kinds[grid], FFTW_PATIENT);
+        }
+    }
+
+    for (unsigned grid = 0; grid < 2; grid++)
+    {
+        mRealInversePlans[grid] = Traits::PlanManyR2r(rank, real_dims, 1,
+                                                      mpInputArray + grid * real_sep, real_dims, 1, real_sep,
+                                                      mpOutputArray + grid * real_sep, real_dims, 1, real_sep,
+                                                      inverse_kinds[grid], FFTW_PATIENT);
+    }
+
+    if (!mWisdomWasImportedFromCache)
+    {
+        ExportWisdom(cache_file);
+    }
+}
+
+template<unsigned DIM, typename SCALAR>
+void ImmersedBoundaryFftInterface<DIM, SCALAR>::SetupThreads()
+{
+    assert(mNumThreads > 0);
+
+    // If more than one thread, the following must happen before any other fftw routines
+    if (mMultiThread)
+    {
+        // 1 means success, 0 indicates a failure
+        if (mThreadErrors != 1)
+        {
+            EXCEPTION("fftw thread error");
+        }
+
+        // Plan with the requested number of threads
+        Traits::PlanWithNThreads((int)mNumThreads);
+    }
+}
+
+template<unsigned DIM, typename SCALAR>
+FileFinder ImmersedBoundaryFftInterface<DIM, SCALAR>::ImportWisdom(const std::string& rCacheFilename)
+{
+    // Forget all wisdom; the correct wisdom for the number of threads used will be loaded from file
+    Traits::ForgetWisdom();
+
+    /*
+     * Wisdom is cached in a file keyed by the grid size, number of threads, and source mode (which determines how many
+     * arrays are transformed).  If the cache file exists, planning is fast.  Otherwise, we seed fftw with any wisdom
+     * generated by TestGenerateFftwWisdom or TestGenerateFftwThreadsWisdom, plan as normal, and write the resulting
+     * wisdom back to the cache in ExportWisdom() so that subsequent simulations of the same size start quickly.
+     */
+    OutputFileHandler wisdom_handler(GetWisdomCacheDirectory(), false);
+    FileFinder cache_file = wisdom_handler.FindFile(rCacheFilename);
+
+    // 1 means success, 0 indicates a failure
+    mWisdomWasImportedFromCache = cache_file.IsFile() &&
+                                  (Traits::ImportWisdomFromFilename(cache_file.GetAbsolutePath().c_str()) == 1);
+
+    if (!mWisdomWasImportedFromCache)
+    {
+        FileFinder legacy_file(GetWisdomFilename(mNumThreads), RelativeTo::ChasteTestOutput);
+        if (legacy_file.IsFile())
+        {
+            // Failure here just means we plan from scratch
+            Traits::ImportWisdomFromFilename(legacy_file.GetAbsolutePath().c_str());
+        }
+    }
+
+    return cache_file;
+}
+
+template<unsigned DIM, typename SCALAR>
+void ImmersedBoundaryFftInterface<DIM, SCALAR>::ExportWisdom(const FileFinder& rCacheFile)
+{
+    // Every process plans the same transforms, so only the master writes the cache
+    if (PetscTools::AmMaster())
+    {
+        /*
+         * Write to a temporary file and rename it, so that other processes planning the same transforms concurrently
+         * never import a partially-written cache file.
+         */
+        std::string cache_path = rCacheFile.GetAbsolutePath();
+
+        std::stringstream temp_path;
+        temp_path << cache_path << ".tmp." << getpid();
+
+        if ((Traits::ExportWisdomToFilename(temp_path.str().c_str()) != 1) ||
+            (std::rename(temp_path.str().c_str(), cache_path.c_str()) != 0))
+        {
+            std::remove(temp_path.str().c_str());
+            WARNING("Unable to write fftw wisdom to the cache file " << cache_path);
+        }
+    }
+}
+
+template<unsigned DIM, typename SCALAR>
+ImmersedBoundaryFftInterface<DIM, SCALAR>::~ImmersedBoundaryFftInterface()
+{
+    // Planning cannot be interrupted, so any upgrade is waited for
+    if (mUpgradeInProgress)
+    {
+        pthread_join(mUpgradeThread, NULL);
+        pthread_mutex_destroy(&mUpgradeMutex);
+    }
+
+    if (mOwnsPlans && mUsesRealTransforms)
+    {
+        FftwPlannerLock lock;
+        for (unsigned grid = 0; grid < 3; grid++)
+        {
+            if (mRealForwardPlans[grid] != NULL)
+            {
+                Traits::DestroyPlan(mRealForwardPlans[grid]);
+            }
+        }
+        Traits::DestroyPlan(mRealInversePlans[0]);
+        Traits::DestroyPlan(mRealInversePlans[1]);
+    }
+    else if (mOwnsPlans)
+    {
+        FftwPlannerLock lock;
+        Traits::DestroyPlan(mFftwForwardPlan);
+        Traits::DestroyPlan(mFftwInversePlan);
+    }
+}
+
+template<unsigned DIM, typename SCALAR>
+void ImmersedBoundaryFftInterface<DIM, SCALAR>::FftExecuteForward()
+{
+    // The forward transforms start those of each timestep, so upgraded plans are swapped in here once they are ready
+    if (mUpgradeInProgress)
+    {
+        pthread_mutex_lock(&mUpgradeMutex);
+        bool upgrade_finished = mUpgradeFinished;
+        pthread_mutex_unlock(&mUpgradeMutex);
+
+        if (upgrade_finished)
+        {
+            SwapInUpgradedPlans();
+        }
+    }
+
+    if (mUsesRealTransforms)
+    {
+        for (unsigned grid = 0; grid < 2 + (unsigned)mActiveSources; grid++)
+        {
+            Traits::Execute(mRealForwardPlans[grid]);
+        }
+    }
+    else if (mOwnsPlans)
+    {
+        Traits::Execute(mFftwForwardPlan);
+    }
+    else
+    {
+        Traits::ExecuteR2c(mFftwForwardPlan, mpInputArray, mpComplexArray);
+    }
+}
+
+template<unsigned DIM, typename SCALAR>
+void ImmersedBoundaryFftInterface<DIM, SCALAR>::FftExecuteInverse()
+{
+    if (mUsesRealTransforms)
+    {
+        Traits::Execute(mRealInversePlans[0]);
+        Traits::Execute(mRealInversePlans[1]);
+    }
+    else if (mOwnsPlans)
+    {
+        Traits::Execute(mFftwInversePlan);
+    }
+    else
+    {
+        Traits::ExecuteC2r(mFftwInversePlan, mpComplexArray, mpOutputArray);
+    }
+}
+
+template<unsigned DIM, typename SCALAR>
+unsigned ImmersedBoundaryFftInterface<DIM, SCALAR>::GetNumThreads() const
+{
+    return mNumThreads;
+}
+
+template<unsigned DIM, typename SCALAR>
+std::string ImmersedBoundaryFftInterface<DIM, SCALAR>::GetWisdomFilename(unsigned numThreads)
+{
+    assert(numThreads > 0);
+
+    if (numThreads == 1)
+    {
+        return "fftw.wisdom";
+    }
+
+    std::stringstream filename;
+    filename << "fftw_threads_" << numThreads << ".wisdom";
+    return filename.str();
+}
+
+template<unsigned DIM, typename SCALAR>
+std::string ImmersedBoundaryFftInterface<DIM, SCALAR>::GetWisdomCacheDirectory()
+{
+    return "ImmersedBoundaryFftwWisdom";
+}
+
+template<unsigned DIM, typename SCALAR>
+std::string ImmersedBoundaryFftInterface<DIM, SCALAR>::GetWisdomCacheFilename(unsigned numGridPtsX,
+                                                                                      unsigned numGridPtsY,
+                                                                                      unsigned numThreads,
+                                                                                      bool activeSources)
+{
+    assert(numThreads > 0);
+
+    std::stringstream filename;
+    filename << Traits::GetWisdomPrefix() << "_" << numGridPtsX << "x" << numGridPtsY
+             << "_threads_" << numThreads
+             << "_howmany_" << 2 + (unsigned)activeSources
+             << (activeSources ? "_sources" : "_nosources")
+             << ".wisdom";
+    return filename.str();
+}
+
+template<unsigned DIM, typename SCALAR>
+bool ImmersedBoundaryFftInterface<DIM, SCALAR>::WasWisdomImportedFromCache() const
+{
+    return mWisdomWasImportedFromCache;
+}
+
+template<unsigned DIM, typename SCALAR>
+bool ImmersedBoundaryFftInterface<DIM, SCALAR>::OwnsPlans() const
+{
+    return mOwnsPlans;
+}
+
+template<unsigned DIM, typename SCALAR>
+bool ImmersedBoundaryFftInterface<DIM, SCALAR>::UsesRealTransforms() const
+{
+    return mUsesRealTransforms;
+}
 
-    mFftwInversePlan = fftw_plan_many_dft_c2r(rank, real_dims, how_many_inverse,
-                                              mpComplexArray, comp_nembed, comp_stride, comp_sep,
-                                              mpOutputArray,  real_nembed, real_stride, real_sep,
-                                              FFTW_PATIENT);
+template<unsigned DIM, typename SCALAR>
+bool ImmersedBoundaryFftInterface<DIM, SCALAR>::IsUpgradingPlans() const
+{
+    return mUpgradeInProgress;
 }
 
-template<unsigned DIM>
-ImmersedBoundaryFftInterface<DIM>::~ImmersedBoundaryFftInterface()
+template<unsigned DIM, typename SCALAR>
+bool ImmersedBoundaryFftInterface<DIM, SCALAR>::WerePlansUpgraded() const
 {
-    fftw_destroy_plan(mFftwForwardPlan);
-    fftw_destroy_plan(mFftwInversePlan);
+    return mPlansWereUpgraded;
 }
 
-template<unsigned DIM>
-void ImmersedBoundaryFftInterface<DIM>::FftExecuteForward()
+template<unsigned DIM, typename SCALAR>
+void ImmersedBoundaryFftInterface<DIM, SCALAR>::WaitForPlanUpgrade()
 {
-    fftw_execute(mFftwForwardPlan);
+    if (mUpgradeInProgress)
+    {
+        SwapInUpgradedPlans();
+    }
 }
 
-template<unsigned DIM>
-void ImmersedBoundaryFftInterface<DIM>::FftExecuteInverse()
+template<unsigned DIM, typename SCALAR>
+void ImmersedBoundaryFftInterface<DIM, SCALAR>::ProlongSpectrally(const multi_array<SCALAR, 3>& rCoarseGrids,
+                                                                  multi_array<SCALAR, 3>& rFineGrids)
 {
-    fftw_execute(mFftwInversePlan);
+    int num_grids = (int) rCoarseGrids.shape()[0];
+    int coarse_x = (int) rCoarseGrids.shape()[1];
+    int coarse_y = (int) rCoarseGrids.shape()[2];
+    int fine_x = (int) rFineGrids.shape()[1];
+    int fine_y = (int) rFineGrids.shape()[2];
+
+    if ((int) rFineGrids.shape()[0] != num_grids || fine_x < coarse_x || fine_y < coarse_y
+        || coarse_x % 2 != 0 || coarse_y % 2 != 0)
+    {
+        EXCEPTION("Grids can only be prolonged onto as many grids with at least as many points in each direction, from an even number of points");
+    }
+
+    int coarse_reduced_y = 1 + coarse_y / 2;
+    int fine_reduced_y = 1 + fine_y / 2;
+
+    // The forward transform is out of place, from a copy so the coarse grids are left alone
+    multi_array<SCALAR, 3> coarse_grids(rCoarseGrids);
+    multi_array<std::complex<SCALAR>, 3> coarse_modes(extents[num_grids][coarse_x][coarse_reduced_y]);
+    multi_array<std::complex<SCALAR>, 3> fine_modes(extents[num_grids][fine_x][fine_reduced_y]);
+    std::fill(fine_modes.data(), fine_modes.data() + fine_modes.num_elements(), std::complex<SCALAR>(0, 0));
+
+    int coarse_dims[] = {coarse_x, coarse_y};
+    int coarse_comp_dims[] = {coarse_x, coarse_reduced_y};
+    int fine_dims[] = {fine_x, fine_y};
+    int fine_comp_dims[] = {fine_x, fine_reduced_y};
+
+    typename Traits::Plan forward_plan;
+    typename Traits::Plan inverse_plan;
+    {
+        FftwPlannerLock lock;
+        forward_plan = Traits::PlanManyR2c(2, coarse_dims, num_grids,
+                                           coarse_grids.data(), coarse_dims, 1, coarse_x * coarse_y,
+                                           reinterpret_cast<typename Traits::Complex*>(coarse_modes.data()),
+                                           coarse_comp_dims, 1, coarse_x * coarse_reduced_y,
+                                           FFTW_ESTIMATE);
+        inverse_plan = Traits::PlanManyC2r(2, fine_dims, num_grids,
+                                           reinterpret_cast<typename Traits::Complex*>(fine_modes.data()),
+                                           fine_comp_dims, 1, fine_x * fine_reduced_y,
+                                           rFineGrids.data(), fine_dims, 1, fine_x * fine_y,
+                                           FFTW_ESTIMATE);
+    }
+
+    Traits::Execute(forward_plan);
+
+    /*
+     * Copy each coarse mode to the fine mode of the same frequency, normalising by the size of the coarse transform.
+     * A Nyquist mode of the coarse grid is half each of the modes at plus and minus that frequency on the fine grid;
+     * in y, the minus frequency is implied by the symmetry of the transform of real data.
+     */
+    const SCALAR norm = SCALAR(1) / SCALAR(coarse_x * coarse_y);
+    for (int grid = 0; grid < num_grids; grid++)
+    {
+        for (int x = 0; x < coarse_x; x++)
+        {
+            int frequency_x = (x <= coarse_x / 2) ? x : x - coarse_x;
+            bool nyquist_x = (x == coarse_x / 2) && (fine_x > coarse_x);
+            int fine_index_x = (frequency_x + fine_x) % fine_x;
+
+            for (int y = 0; y < coarse_reduced_y; y++)
+            {
+                bool nyquist_y = (y == coarse_y / 2) && (fine_y > coarse_y);
+                std::complex<SCALAR> mode = coarse_modes[grid][x][y] * norm;
+                if (nyquist_y)
+                {
+                    mode *= SCALAR(0.5);
+                }
+
+                if (nyquist_x)
+                {
+                    fine_modes[grid][fine_index_x][y] += mode * SCALAR(0.5);
+                    fine_modes[grid][fine_x - coarse_x / 2][y] += mode * SCALAR(0.5);
+                }
+                else
+                {
+                    fine_modes[grid][fine_index_x][y] += mode;
+                }
+            }
+        }
+    }
+
+    Traits::Execute(inverse_plan);
+
+    {
+        FftwPlannerLock lock;
+        Traits::DestroyPlan(forward_plan);
+        Traits::DestroyPlan(inverse_plan);
+    }
 }
 
 // Explicit instantiation
 template class ImmersedBoundaryFftInterface<1>;
 template class ImmersedBoundaryFftInterface<2>;
 template class ImmersedBoundaryFftInterface<3>;
+template class ImmersedBoundaryFftInterface<1, float>;
+template class ImmersedBoundaryFftInterface<2, float>;
+template class ImmersedBoundaryFftInterface<3, float>;
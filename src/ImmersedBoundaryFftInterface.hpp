@@ -37,18 +37,38 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define IMMERSEDBOUNDARYFFTINTERFACE_HPP_
 
 #include <complex>
-#include <fftw3.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include "AbstractImmersedBoundaryFftInterface.hpp"
+#include "FileFinder.hpp"
+#include "ImmersedBoundaryFftwTraits.hpp"
 #include "ImmersedBoundaryMesh.hpp"
 
 /**
- * A class to interface with discrete Fourier transform libraries and perform
+ * A class to interface with the fftw discrete Fourier transform library and perform
  * the necessary transforms for immersed boundary simulations.
+ *
+ * The transforms are done in double precision (fftw) by default, or in single precision (fftwf) if SCALAR is float.
+ *
+ * Planning with FFTW_PATIENT may take minutes for large grids if no wisdom is cached.  With fast start, the 2D
+ * transforms are instead first planned with FFTW_ESTIMATE, and replanned with FFTW_PATIENT on scratch arrays on a
+ * background thread.  The better plans are swapped in at the next forward transform once they are ready, which is
+ * between timesteps, and the wisdom is cached for the next simulation.  The fftw planner is not thread-safe, so all
+ * planning by this class is serialised, but fftw must not be planned with elsewhere while plans are being upgraded.
+ *
+ * For a domain bounded by walls, the 2D transforms are instead real-to-real: sine and cosine transforms between
+ * the walls, and real-to-halfcomplex transforms in any periodic direction.  These are planned separately for each
+ * grid, since the velocity component normal to a wall is transformed with sines and the rest with cosines.
  */
-template<unsigned DIM>
-class ImmersedBoundaryFftInterface
+template<unsigned DIM, typename SCALAR=double>
+class ImmersedBoundaryFftInterface : public AbstractImmersedBoundaryFftInterface<DIM>
 {
 protected:
 
+    /** The fftw types and routines for this precision. */
+    typedef ImmersedBoundaryFftwTraits<SCALAR> Traits;
+
     ///\todo document this member variable
     int mThreadErrors;
 
@@ -56,23 +76,160 @@ protected:
     ImmersedBoundaryMesh<DIM,DIM>* mpMesh;
 
     /** The fftw plan for the forward transforms. */
-    fftw_plan mFftwForwardPlan;
+    typename Traits::Plan mFftwForwardPlan;
 
-    /** The fftw plan for the forward transforms. */
-    fftw_plan mFftwInversePlan;
+    /** The fftw plan for the inverse transforms. */
+    typename Traits::Plan mFftwInversePlan;
 
     /** Pointer to the start of the input arrays. */
-    double* mpInputArray;
+    SCALAR* mpInputArray;
 
     /** Pointer to the start of Fourier domain. */
-    fftw_complex* mpComplexArray;
+    typename Traits::Complex* mpComplexArray;
 
     /** Pointer to the start output array. */
-    double* mpOutputArray;
+    SCALAR* mpOutputArray;
+
+    /** Whether the 2D transforms are real-to-real, for a domain bounded by walls, rather than real-to-complex. */
+    bool mUsesRealTransforms;
+
+    /** The fftw plans for the forward real-to-real transforms of each velocity grid and the source grid. */
+    typename Traits::Plan mRealForwardPlans[3];
 
-    /** The max number of threads to use for computing the DFT. */
+    /** The fftw plans for the inverse real-to-real transforms of each velocity grid. */
+    typename Traits::Plan mRealInversePlans[2];
+
+    /** Whether to use multiple threads for computing the DFT. */
     bool mMultiThread;
 
+    /** The number of threads used for computing the DFT. */
+    unsigned mNumThreads;
+
+    /** Whether the wisdom used to plan the transforms was found in the wisdom cache. */
+    bool mWisdomWasImportedFromCache;
+
+    /**
+     * Whether the plans were made by this interface, and so are destroyed with it.  An interface sharing the plans of
+     * another executes them on its own arrays, and the other interface must outlive it.
+     */
+    bool mOwnsPlans;
+
+    /** The number of grid points in the x direction. */
+    int mNumGridPtsX;
+
+    /** The number of grid points in the y direction. */
+    int mNumGridPtsY;
+
+    /** Whether the population has active fluid sources, so there is a third forward transform. */
+    bool mActiveSources;
+
+    /** The wisdom cache file, to which wisdom is written whenever planning may have added to it. */
+    FileFinder mWisdomCacheFile;
+
+    /** Whether plans are being upgraded on #mUpgradeThread and are yet to be swapped in.  Only used by the owner. */
+    bool mUpgradeInProgress;
+
+    /** Whether #mUpgradeThread has finished planning.  Protected by #mUpgradeMutex. */
+    bool mUpgradeFinished;
+
+    /**
+     * The wisdom accumulated by #mUpgradeThread planning each transform, imported when the plans are swapped in in
+     * case other interfaces have forgotten it in the meantime.  Protected by #mUpgradeMutex.
+     */
+    std::vector<std::string> mUpgradedWisdom;
+
+    /** Whether the plans made with FFTW_ESTIMATE for a fast start have been replaced by upgraded plans. */
+    bool mPlansWereUpgraded;
+
+    /** The thread replanning the transforms with FFTW_PATIENT, while #mUpgradeInProgress. */
+    pthread_t mUpgradeThread;
+
+    /** Mutex protecting #mUpgradeFinished. */
+    pthread_mutex_t mUpgradeMutex;
+
+    /**
+     * Helper method for the 2D constructors.  Plans the forward and inverse transforms on some arrays.  The fftw
+     * planner must be locked by the caller.
+     *
+     * @param numGridPtsX the number of grid points in the x direction
+     * @param numGridPtsY the number of grid points in the y direction
+     * @param activeSources whether the population has active fluid sources
+     * @param pIn pointer to the input array
+     * @param pComplex pointer to the complex number array
+     * @param pOut pointer to the output array
+     * @param flags the fftw planner flags
+     * @param rForwardPlan the plan for the forward transforms, which is NULL if planning failed
+     * @param rInversePlan the plan for the inverse transforms, which is NULL if planning failed
+     */
+    static void Plan2dTransforms(int numGridPtsX, int numGridPtsY, bool activeSources,
+                                 SCALAR* pIn, typename Traits::Complex* pComplex, SCALAR* pOut, unsigned flags,
+                                 typename Traits::Plan& rForwardPlan, typename Traits::Plan& rInversePlan);
+
+    /**
+     * Helper method for Plan2dTransforms().  Plans either the forward or the inverse transforms on some arrays.  The
+     * fftw planner must be locked by the caller.
+     *
+     * @param forward whether to plan the forward transforms, rather than the inverse transforms
+     * @param numGridPtsX the number of grid points in the x direction
+     * @param numGridPtsY the number of grid points in the y direction
+     * @param activeSources whether the population has active fluid sources
+     * @param pIn pointer to the input array
+     * @param pComplex pointer to the complex number array
+     * @param pOut pointer to the output array
+     * @param flags the fftw planner flags
+     * @return the plan, which is NULL if planning failed
+     */
+    static typename Traits::Plan Plan2dTransform(bool forward, int numGridPtsX, int numGridPtsY, bool activeSources,
+                                                 SCALAR* pIn, typename Traits::Complex* pComplex, SCALAR* pOut,
+                                                 unsigned flags);
+
+    /**
+     * The entry point of #mUpgradeThread.
+     *
+     * @param pInterface pointer to the interface
+     * @return NULL
+     */
+    static void* UpgradeThreadFunction(void* pInterface);
+
+    /**
+     * Replan the transforms with FFTW_PATIENT on scratch arrays, accumulating wisdom for them in #mUpgradedWisdom.
+     * The scratch arrays are laid out as the arrays of this interface: arrays sharing storage share scratch storage,
+     * and each block of scratch storage is aligned as the storage it stands in for, so the wisdom applies to the
+     * arrays of this interface.  The planner is locked for one transform at a time, so other interfaces may plan in
+     * between.  Called on #mUpgradeThread.
+     */
+    void PlanOnScratchArrays();
+
+    /**
+     * Wait for #mUpgradeThread, then replace the plans with FFTW_PATIENT plans made from #mUpgradedWisdom, and write
+     * the wisdom to the cache.  If the wisdom does not apply to the arrays of this interface, the existing
+     * plans are kept.
+     */
+    void SwapInUpgradedPlans();
+
+    /**
+     * Helper method for the constructors.  Checks that fftw threads were initialised correctly and sets the number of
+     * threads used for planning.
+     */
+    void SetupThreads();
+
+    /**
+     * Helper method for the constructors.  Forgets any existing wisdom and imports wisdom from the cache, falling back
+     * on any legacy wisdom file for the current number of threads.
+     *
+     * @param rCacheFilename the name of the cache file, relative to GetWisdomCacheDirectory()
+     * @return a file finder pointing to the cache file, which need not exist
+     */
+    FileFinder ImportWisdom(const std::string& rCacheFilename);
+
+    /**
+     * Helper method, called whenever planning may have added to the wisdom.  On the master process, atomically write
+     * the current wisdom to the cache file.
+     *
+     * @param rCacheFile the cache file
+     */
+    void ExportWisdom(const FileFinder& rCacheFile);
+
 public:
 
     /**
@@ -82,20 +239,70 @@ public:
      * @param pIn pointer to the input array
      * @param pComplex pointer to the complex number array
      * @param pOut pointer to the output array
-     * @param multiThread whether to use multiple threads
+     * @param numThreads the number of threads to use (a value of 1 means single-threaded)
      * @param activeSources whether the population has active fluid sources
+     * @param fastStart whether, if no wisdom is cached, to plan with FFTW_ESTIMATE and upgrade the plans in the
+     *     background (defaults to false)
      */
     ImmersedBoundaryFftInterface(ImmersedBoundaryMesh<DIM,DIM>* pMesh,
-                                 double* pIn,
-                                 std::complex<double>* pComplex,
-                                 double* pOut,
-                                 bool multiThread,
+                                 SCALAR* pIn,
+                                 std::complex<SCALAR>* pComplex,
+                                 SCALAR* pOut,
+                                 unsigned numThreads,
+                                 bool activeSources,
+                                 bool fastStart=false);
+
+    /**
+     * Constructor sharing the plans of another interface, which are executed on the arrays given here rather than
+     * on those they were planned for.  This avoids planning the same transforms again for each of a number of
+     * simulations of the same size, as in ImmersedBoundaryEnsemble, and the plans may be executed on the arrays of
+     * different simulations concurrently.  If the arrays are not aligned as those of the other interface, which fftw
+     * requires, the transforms are instead planned afresh for these arrays.
+     *
+     * @param rPlannedInterface the interface whose plans are shared, which must outlive this interface
+     * @param pIn pointer to the input array
+     * @param pComplex pointer to the complex number array
+     * @param pOut pointer to the output array
+     * @param activeSources whether the population has active fluid sources, as for rPlannedInterface
+     */
+    ImmersedBoundaryFftInterface(const ImmersedBoundaryFftInterface<DIM,SCALAR>& rPlannedInterface,
+                                 SCALAR* pIn,
+                                 std::complex<SCALAR>* pComplex,
+                                 SCALAR* pOut,
+                                 bool activeSources);
+
+    /**
+     * Constructor for the real-to-real 2D transforms of a domain bounded by walls in at least one direction.  The
+     * forward transforms are in-place, overwriting the velocity (and source) grids with their coefficients, and the
+     * inverse transforms are from these to the output grids.  The coefficients are laid out as described in
+     * ImmersedBoundary2dArrays.
+     *
+     * @param numGridPtsX the number of grid points in the x direction
+     * @param numGridPtsY the number of grid points in the y direction
+     * @param wallsX whether the domain is bounded by walls normal to x
+     * @param wallsY whether the domain is bounded by walls normal to y
+     * @param pInOut pointer to the input arrays, which are overwritten by the coefficients
+     * @param pOut pointer to the output array
+     * @param numThreads the number of threads to use (a value of 1 means single-threaded)
+     * @param activeSources whether the population has active fluid sources
+     */
+    ImmersedBoundaryFftInterface(unsigned numGridPtsX,
+                                 unsigned numGridPtsY,
+                                 bool wallsX,
+                                 bool wallsY,
+                                 SCALAR* pInOut,
+                                 SCALAR* pOut,
+                                 unsigned numThreads,
                                  bool activeSources);
 
     /**
      * Empty constructor.
      */
     ImmersedBoundaryFftInterface()
+        : mUsesRealTransforms(false),
+          mOwnsPlans(false),
+          mUpgradeInProgress(false),
+          mPlansWereUpgraded(false)
     {
     }
 
@@ -105,10 +312,87 @@ public:
     virtual ~ImmersedBoundaryFftInterface();
 
     /** Performs forward fourier transforms */
-    void FftExecuteForward();
+    virtual void FftExecuteForward();
 
     /** Performs inverse fourier transforms */
-    void FftExecuteInverse();
+    virtual void FftExecuteInverse();
+
+    /**
+     * @return #mNumThreads
+     */
+    unsigned GetNumThreads() const;
+
+    /**
+     * Helper method to get the name of the wisdom file corresponding to a given number of threads.  Wisdom generated
+     * for one thread count is not in general optimal for another, so each thread count has its own file.
+     *
+     * @param numThreads the number of threads
+     * @return the wisdom filename, relative to the Chaste test output directory
+     */
+    static std::string GetWisdomFilename(unsigned numThreads);
+
+    /**
+     * @return the directory, relative to the Chaste test output directory, in which cached wisdom is stored
+     */
+    static std::string GetWisdomCacheDirectory();
+
+    /**
+     * Helper method to get the name of the cached wisdom file for a particular set of transforms.  Single and double
+     * precision wisdom are cached separately.
+     *
+     * @param numGridPtsX the number of grid points in the x direction
+     * @param numGridPtsY the number of grid points in the y direction
+     * @param numThreads the number of threads
+     * @param activeSources whether the population has active fluid sources
+     * @return the wisdom cache filename, relative to GetWisdomCacheDirectory()
+     */
+    static std::string GetWisdomCacheFilename(unsigned numGridPtsX,
+                                              unsigned numGridPtsY,
+                                              unsigned numThreads,
+                                              bool activeSources);
+
+    /**
+     * @return #mWisdomWasImportedFromCache
+     */
+    bool WasWisdomImportedFromCache() const;
+
+    /**
+     * @return #mOwnsPlans
+     */
+    bool OwnsPlans() const;
+
+    /**
+     * @return #mUsesRealTransforms
+     */
+    bool UsesRealTransforms() const;
+
+    /**
+     * @return #mUpgradeInProgress
+     */
+    bool IsUpgradingPlans() const;
+
+    /**
+     * @return #mPlansWereUpgraded
+     */
+    bool WerePlansUpgraded() const;
+
+    /**
+     * If plans are being upgraded, wait for the upgrade to finish and swap the upgraded plans in.
+     */
+    void WaitForPlanUpgrade();
+
+    /**
+     * Interpolate periodic grids onto finer grids spectrally, by zero-padding their discrete Fourier transforms.  A
+     * grid resolved by the coarse grid is reproduced exactly at the fine grid points; the Nyquist modes of the coarse
+     * grid are split equally between the positive and negative frequencies of the fine grid.  The transforms are
+     * planned with FFTW_ESTIMATE, so this is intended for occasional use, for instance to start a fine simulation from
+     * a coarse one.
+     *
+     * @param rCoarseGrids the coarse grids, indexed by grid, x and y, with an even number of points in each direction
+     * @param rFineGrids the fine grids, already sized with the same number of grids and at least as many points as
+     *     the coarse grids in each direction, which are overwritten
+     */
+    static void ProlongSpectrally(const multi_array<SCALAR, 3>& rCoarseGrids, multi_array<SCALAR, 3>& rFineGrids);
 };
 
 #endif /*IMMERSEDBOUNDARYFFTINTERFACE_HPP_*/
@@ -0,0 +1,448 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYFFTWTRAITS_HPP_
+#define IMMERSEDBOUNDARYFFTWTRAITS_HPP_
+
+#include <cstdlib>
+#include <string>
+#include <fftw3.h>
+
+/**
+ * Traits class mapping a floating point type to the corresponding fftw types and routines, so that
+ * ImmersedBoundaryFftInterface may be used in either double (fftw) or single (fftwf) precision.
+ */
+template<typename SCALAR>
+struct ImmersedBoundaryFftwTraits;
+
+/**
+ * Specialisation of ImmersedBoundaryFftwTraits for double precision.
+ */
+template<>
+struct ImmersedBoundaryFftwTraits<double>
+{
+    /** The fftw plan type. */
+    typedef fftw_plan Plan;
+
+    /** The fftw complex type. */
+    typedef fftw_complex Complex;
+
+    /** @return the prefix used for wisdom files */
+    static std::string GetWisdomPrefix()
+    {
+        return "fftw";
+    }
+
+    /** @return the result of fftw_init_threads() */
+    static int InitThreads()
+    {
+        return fftw_init_threads();
+    }
+
+    /** @param numThreads the number of threads to plan with */
+    static void PlanWithNThreads(int numThreads)
+    {
+        fftw_plan_with_nthreads(numThreads);
+    }
+
+    /** Forget all accumulated wisdom. */
+    static void ForgetWisdom()
+    {
+        fftw_forget_wisdom();
+    }
+
+    /**
+     * @param pFilename the file to import from
+     * @return 1 on success, 0 on failure
+     */
+    static int ImportWisdomFromFilename(const char* pFilename)
+    {
+        return fftw_import_wisdom_from_filename(pFilename);
+    }
+
+    /**
+     * @param pFilename the file to export to
+     * @return 1 on success, 0 on failure
+     */
+    static int ExportWisdomToFilename(const char* pFilename)
+    {
+        return fftw_export_wisdom_to_filename(pFilename);
+    }
+
+    /**
+     * @param rWisdom the wisdom to import, as exported by ExportWisdomToString()
+     * @return 1 on success, 0 on failure
+     */
+    static int ImportWisdomFromString(const std::string& rWisdom)
+    {
+        return fftw_import_wisdom_from_string(rWisdom.c_str());
+    }
+
+    /** @return all accumulated wisdom, or an empty string on failure */
+    static std::string ExportWisdomToString()
+    {
+        char* p_wisdom = fftw_export_wisdom_to_string();
+        std::string wisdom(p_wisdom != NULL ? p_wisdom : "");
+        free(p_wisdom);
+        return wisdom;
+    }
+
+    /**
+     * Wrapper for fftw_plan_many_dft_r2c(); see the fftw documentation for parameter descriptions.
+     *
+     * @param rank rank
+     * @param pN n
+     * @param howMany howmany
+     * @param pIn in
+     * @param pInEmbed inembed
+     * @param inStride istride
+     * @param inDist idist
+     * @param pOut out
+     * @param pOutEmbed onembed
+     * @param outStride ostride
+     * @param outDist odist
+     * @param flags flags
+     * @return the plan
+     */
+    static Plan PlanManyR2c(int rank, const int* pN, int howMany,
+                            double* pIn, const int* pInEmbed, int inStride, int inDist,
+                            Complex* pOut, const int* pOutEmbed, int outStride, int outDist,
+                            unsigned flags)
+    {
+        return fftw_plan_many_dft_r2c(rank, pN, howMany, pIn, pInEmbed, inStride, inDist,
+                                      pOut, pOutEmbed, outStride, outDist, flags);
+    }
+
+    /**
+     * Wrapper for fftw_plan_many_dft_c2r(); see the fftw documentation for parameter descriptions.
+     *
+     * @param rank rank
+     * @param pN n
+     * @param howMany howmany
+     * @param pIn in
+     * @param pInEmbed inembed
+     * @param inStride istride
+     * @param inDist idist
+     * @param pOut out
+     * @param pOutEmbed onembed
+     * @param outStride ostride
+     * @param outDist odist
+     * @param flags flags
+     * @return the plan
+     */
+    static Plan PlanManyC2r(int rank, const int* pN, int howMany,
+                            Complex* pIn, const int* pInEmbed, int inStride, int inDist,
+                            double* pOut, const int* pOutEmbed, int outStride, int outDist,
+                            unsigned flags)
+    {
+        return fftw_plan_many_dft_c2r(rank, pN, howMany, pIn, pInEmbed, inStride, inDist,
+                                      pOut, pOutEmbed, outStride, outDist, flags);
+    }
+
+    /**
+     * Wrapper for fftw_plan_many_r2r(); see the fftw documentation for parameter descriptions.
+     *
+     * @param rank rank
+     * @param pN n
+     * @param howMany howmany
+     * @param pIn in
+     * @param pInEmbed inembed
+     * @param inStride istride
+     * @param inDist idist
+     * @param pOut out
+     * @param pOutEmbed onembed
+     * @param outStride ostride
+     * @param outDist odist
+     * @param pKinds kind, one per dimension
+     * @param flags flags
+     * @return the plan
+     */
+    static Plan PlanManyR2r(int rank, const int* pN, int howMany,
+                            double* pIn, const int* pInEmbed, int inStride, int inDist,
+                            double* pOut, const int* pOutEmbed, int outStride, int outDist,
+                            const fftw_r2r_kind* pKinds, unsigned flags)
+    {
+        return fftw_plan_many_r2r(rank, pN, howMany, pIn, pInEmbed, inStride, inDist,
+                                  pOut, pOutEmbed, outStride, outDist, pKinds, flags);
+    }
+
+    /** @param plan the plan to execute */
+    static void Execute(Plan plan)
+    {
+        fftw_execute(plan);
+    }
+
+    /**
+     * Wrapper for fftw_execute_dft_r2c(), which executes a real-to-complex plan on arrays other than those it was
+     * planned for.  The arrays must have the same sizes, strides and alignment as the original arrays.
+     *
+     * @param plan the plan to execute
+     * @param pIn the real input array
+     * @param pOut the complex output array
+     */
+    static void ExecuteR2c(Plan plan, double* pIn, Complex* pOut)
+    {
+        fftw_execute_dft_r2c(plan, pIn, pOut);
+    }
+
+    /**
+     * Wrapper for fftw_execute_dft_c2r(), which executes a complex-to-real plan on arrays other than those it was
+     * planned for.  The arrays must have the same sizes, strides and alignment as the original arrays.
+     *
+     * @param plan the plan to execute
+     * @param pIn the complex input array
+     * @param pOut the real output array
+     */
+    static void ExecuteC2r(Plan plan, Complex* pIn, double* pOut)
+    {
+        fftw_execute_dft_c2r(plan, pIn, pOut);
+    }
+
+    /**
+     * @param pArray an array
+     * @return the alignment of the array as seen by fftw, which must match between the arrays a plan is executed on
+     */
+    static int AlignmentOf(double* pArray)
+    {
+        return fftw_alignment_of(pArray);
+    }
+
+    /** @param plan the plan to destroy */
+    static void DestroyPlan(Plan plan)
+    {
+        fftw_destroy_plan(plan);
+    }
+};
+
+/**
+ * Specialisation of ImmersedBoundaryFftwTraits for single precision.
+ */
+template<>
+struct ImmersedBoundaryFftwTraits<float>
+{
+    /** The fftwf plan type. */
+    typedef fftwf_plan Plan;
+
+    /** The fftwf complex type. */
+    typedef fftwf_complex Complex;
+
+    /** @return the prefix used for wisdom files */
+    static std::string GetWisdomPrefix()
+    {
+        return "fftwf";
+    }
+
+    /** @return the result of fftwf_init_threads() */
+    static int InitThreads()
+    {
+        return fftwf_init_threads();
+    }
+
+    /** @param numThreads the number of threads to plan with */
+    static void PlanWithNThreads(int numThreads)
+    {
+        fftwf_plan_with_nthreads(numThreads);
+    }
+
+    /** Forget all accumulated wisdom. */
+    static void ForgetWisdom()
+    {
+        fftwf_forget_wisdom();
+    }
+
+    /**
+     * @param pFilename the file to import from
+     * @return 1 on success, 0 on failure
+     */
+    static int ImportWisdomFromFilename(const char* pFilename)
+    {
+        return fftwf_import_wisdom_from_filename(pFilename);
+    }
+
+    /**
+     * @param pFilename the file to export to
+     * @return 1 on success, 0 on failure
+     */
+    static int ExportWisdomToFilename(const char* pFilename)
+    {
+        return fftwf_export_wisdom_to_filename(pFilename);
+    }
+
+    /**
+     * @param rWisdom the wisdom to import, as exported by ExportWisdomToString()
+     * @return 1 on success, 0 on failure
+     */
+    static int ImportWisdomFromString(const std::string& rWisdom)
+    {
+        return fftwf_import_wisdom_from_string(rWisdom.c_str());
+    }
+
+    /** @return all accumulated wisdom, or an empty string on failure */
+    static std::string ExportWisdomToString()
+    {
+        char* p_wisdom = fftwf_export_wisdom_to_string();
+        std::string wisdom(p_wisdom != NULL ? p_wisdom : "");
+        free(p_wisdom);
+        return wisdom;
+    }
+
+    /**
+     * Wrapper for fftwf_plan_many_dft_r2c(); see the fftw documentation for parameter descriptions.
+     *
+     * @param rank rank
+     * @param pN n
+     * @param howMany howmany
+     * @param pIn in
+     * @param pInEmbed inembed
+     * @param inStride istride
+     * @param inDist idist
+     * @param pOut out
+     * @param pOutEmbed onembed
+     * @param outStride ostride
+     * @param outDist odist
+     * @param flags flags
+     * @return the plan
+     */
+    static Plan PlanManyR2c(int rank, const int* pN, int howMany,
+                            float* pIn, const int* pInEmbed, int inStride, int inDist,
+                            Complex* pOut, const int* pOutEmbed, int outStride, int outDist,
+                            unsigned flags)
+    {
+        return fftwf_plan_many_dft_r2c(rank, pN, howMany, pIn, pInEmbed, inStride, inDist,
+                                       pOut, pOutEmbed, outStride, outDist, flags);
+    }
+
+    /**
+     * Wrapper for fftwf_plan_many_dft_c2r(); see the fftw documentation for parameter descriptions.
+     *
+     * @param rank rank
+     * @param pN n
+     * @param howMany howmany
+     * @param pIn in
+     * @param pInEmbed inembed
+     * @param inStride istride
+     * @param inDist idist
+     * @param pOut out
+     * @param pOutEmbed onembed
+     * @param outStride ostride
+     * @param outDist odist
+     * @param flags flags
+     * @return the plan
+     */
+    static Plan PlanManyC2r(int rank, const int* pN, int howMany,
+                            Complex* pIn, const int* pInEmbed, int inStride, int inDist,
+                            float* pOut, const int* pOutEmbed, int outStride, int outDist,
+                            unsigned flags)
+    {
+        return fftwf_plan_many_dft_c2r(rank, pN, howMany, pIn, pInEmbed, inStride, inDist,
+                                       pOut, pOutEmbed, outStride, outDist, flags);
+    }
+
+    /**
+     * Wrapper for fftwf_plan_many_r2r(); see the fftw documentation for parameter descriptions.
+     *
+     * @param rank rank
+     * @param pN n
+     * @param howMany howmany
+     * @param pIn in
+     * @param pInEmbed inembed
+     * @param inStride istride
+     * @param inDist idist
+     * @param pOut out
+     * @param pOutEmbed onembed
+     * @param outStride ostride
+     * @param outDist odist
+     * @param pKinds kind, one per dimension
+     * @param flags flags
+     * @return the plan
+     */
+    static Plan PlanManyR2r(int rank, const int* pN, int howMany,
+                            float* pIn, const int* pInEmbed, int inStride, int inDist,
+                            float* pOut, const int* pOutEmbed, int outStride, int outDist,
+                            const fftwf_r2r_kind* pKinds, unsigned flags)
+    {
+        return fftwf_plan_many_r2r(rank, pN, howMany, pIn, pInEmbed, inStride, inDist,
+                                   pOut, pOutEmbed, outStride, outDist, pKinds, flags);
+    }
+
+    /** @param plan the plan to execute */
+    static void Execute(Plan plan)
+    {
+        fftwf_execute(plan);
+    }
+
+    /**
+     * Wrapper for fftwf_execute_dft_r2c(), which executes a real-to-complex plan on arrays other than those it was
+     * planned for.  The arrays must have the same sizes, strides and alignment as the original arrays.
+     *
+     * @param plan the plan to execute
+     * @param pIn the real input array
+     * @param pOut the complex output array
+     */
+    static void ExecuteR2c(Plan plan, float* pIn, Complex* pOut)
+    {
+        fftwf_execute_dft_r2c(plan, pIn, pOut);
+    }
+
+    /**
+     * Wrapper for fftwf_execute_dft_c2r(), which executes a complex-to-real plan on arrays other than those it was
+     * planned for.  The arrays must have the same sizes, strides and alignment as the original arrays.
+     *
+     * @param plan the plan to execute
+     * @param pIn the complex input array
+     * @param pOut the real output array
+     */
+    static void ExecuteC2r(Plan plan, Complex* pIn, float* pOut)
+    {
+        fftwf_execute_dft_c2r(plan, pIn, pOut);
+    }
+
+    /**
+     * @param pArray an array
+     * @return the alignment of the array as seen by fftwf, which must match between the arrays a plan is executed on
+     */
+    static int AlignmentOf(float* pArray)
+    {
+        return fftwf_alignment_of(pArray);
+    }
+
+    /** @param plan the plan to destroy */
+    static void DestroyPlan(Plan plan)
+    {
+        fftwf_destroy_plan(plan);
+    }
+};
+
+#endif /*IMMERSEDBOUNDARYFFTWTRAITS_HPP_*/
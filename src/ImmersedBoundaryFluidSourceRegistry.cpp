@@ -0,0 +1,139 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryFluidSourceRegistry.hpp"
+#include <cassert>
+#include <climits>
+#include "Exception.hpp"
+
+template<unsigned DIM>
+ImmersedBoundaryFluidSourceRegistry<DIM>::ImmersedBoundaryFluidSourceRegistry()
+    : mNumElementSources(0),
+      mTotalElementStrength(0.0),
+      mAppliedBalancingStrength(0.0)
+{
+}
+
+template<unsigned DIM>
+ImmersedBoundaryFluidSourceRegistry<DIM>::~ImmersedBoundaryFluidSourceRegistry()
+{
+    DetachSources();
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryFluidSourceRegistry<DIM>::DetachSources()
+{
+    for (unsigned slot = 0; slot < mSources.size(); slot++)
+    {
+        mSources[slot]->SetRegistry(NULL, UINT_MAX);
+    }
+    mSources.clear();
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryFluidSourceRegistry<DIM>::Reset(const std::vector<FluidSource<DIM>*>& rElementSources,
+                                                     const std::vector<FluidSource<DIM>*>& rBalancingSources)
+{
+    DetachSources();
+
+    mSources.insert(mSources.end(), rElementSources.begin(), rElementSources.end());
+    mSources.insert(mSources.end(), rBalancingSources.begin(), rBalancingSources.end());
+    mNumElementSources = rElementSources.size();
+
+    mLocations.resize(DIM * mSources.size());
+    mStrengths.resize(mSources.size());
+
+    // Summing afresh on each reset stops rounding errors in the incremental updates from accumulating indefinitely
+    mTotalElementStrength = 0.0;
+    for (unsigned slot = 0; slot < mSources.size(); slot++)
+    {
+        FluidSource<DIM>* p_source = mSources[slot];
+        p_source->SetRegistry(this, slot);
+
+        for (unsigned dim = 0; dim < DIM; dim++)
+        {
+            mLocations[DIM * slot + dim] = p_source->rGetLocation()[dim];
+        }
+
+        mStrengths[slot] = p_source->GetStrength();
+        if (slot < mNumElementSources)
+        {
+            mTotalElementStrength += mStrengths[slot];
+        }
+    }
+
+    // Force the balancing strength to be applied next time it is requested
+    mAppliedBalancingStrength = DOUBLE_UNSET;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryFluidSourceRegistry<DIM>::UpdateStrength(unsigned slot, double strength)
+{
+    assert(slot < mSources.size());
+
+    if (slot < mNumElementSources)
+    {
+        mTotalElementStrength += strength - mStrengths[slot];
+    }
+    mStrengths[slot] = strength;
+}
+
+template<unsigned DIM>
+double ImmersedBoundaryFluidSourceRegistry<DIM>::GetBalancingStrength() const
+{
+    unsigned num_balancing_sources = mSources.size() - mNumElementSources;
+    return num_balancing_sources > 0 ? -1.0 * mTotalElementStrength / (double)num_balancing_sources : 0.0;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryFluidSourceRegistry<DIM>::ApplyBalancingStrength()
+{
+    double balancing_strength = GetBalancingStrength();
+
+    if (balancing_strength != mAppliedBalancingStrength)
+    {
+        // Setting the strength of each source also updates its slot in this registry
+        for (unsigned slot = mNumElementSources; slot < mSources.size(); slot++)
+        {
+            mSources[slot]->SetStrength(balancing_strength);
+        }
+        mAppliedBalancingStrength = balancing_strength;
+    }
+}
+
+// Explicit instantiation
+template class ImmersedBoundaryFluidSourceRegistry<1>;
+template class ImmersedBoundaryFluidSourceRegistry<2>;
+template class ImmersedBoundaryFluidSourceRegistry<3>;
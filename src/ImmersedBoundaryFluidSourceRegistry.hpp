@@ -0,0 +1,173 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYFLUIDSOURCEREGISTRY_HPP_
+#define IMMERSEDBOUNDARYFLUIDSOURCEREGISTRY_HPP_
+
+#include <vector>
+#include "FluidSource.hpp"
+
+/**
+ * A registry of the fluid sources in an immersed boundary mesh, holding their locations and strengths in contiguous
+ * arrays.  Element sources occupy the first slots, followed by the balancing sources, which is the order used to
+ * index the cell population's source stencil cache.
+ *
+ * Registered sources notify the registry whenever their strength is set, so the total strength of the element
+ * sources, and hence the strength each balancing source needs for the sources to sum to zero, are maintained
+ * incrementally rather than re-summed every timestep.
+ */
+template<unsigned DIM>
+class ImmersedBoundaryFluidSourceRegistry
+{
+private:
+
+    /** The registered sources, by slot. */
+    std::vector<FluidSource<DIM>*> mSources;
+
+    /** The location of each source, DIM per slot. */
+    std::vector<double> mLocations;
+
+    /** The strength of each source, by slot. */
+    std::vector<double> mStrengths;
+
+    /** The number of element sources, which occupy the first slots. */
+    unsigned mNumElementSources;
+
+    /** The sum of the strengths of the element sources. */
+    double mTotalElementStrength;
+
+    /** The strength most recently given to the balancing sources by ApplyBalancingStrength(). */
+    double mAppliedBalancingStrength;
+
+public:
+
+    /**
+     * Default constructor.
+     */
+    ImmersedBoundaryFluidSourceRegistry();
+
+    /**
+     * Destructor.  Detaches any registered sources, which may outlive the registry.
+     */
+    ~ImmersedBoundaryFluidSourceRegistry();
+
+    /**
+     * Detach all registered sources from this registry, leaving it empty.  This must be called before any registered
+     * source is deleted, as the registry otherwise detaches it again when reset or destroyed.
+     */
+    void DetachSources();
+
+    /**
+     * Register a new set of sources, replacing any registered previously.
+     *
+     * @param rElementSources the sources associated with elements
+     * @param rBalancingSources the sources used to balance the element sources
+     */
+    void Reset(const std::vector<FluidSource<DIM>*>& rElementSources,
+               const std::vector<FluidSource<DIM>*>& rBalancingSources);
+
+    /**
+     * Record a change to the strength of a source.  This is called by FluidSource::SetStrength().
+     *
+     * @param slot the slot of the source
+     * @param strength the new strength
+     */
+    void UpdateStrength(unsigned slot, double strength);
+
+    /**
+     * Give each balancing source the strength needed to balance the element sources, if it has changed.
+     */
+    void ApplyBalancingStrength();
+
+    /** @return the number of registered sources */
+    unsigned GetNumSources() const
+    {
+        return mSources.size();
+    }
+
+    /** @return #mNumElementSources */
+    unsigned GetNumElementSources() const
+    {
+        return mNumElementSources;
+    }
+
+    /** @return #mTotalElementStrength */
+    double GetTotalElementStrength() const
+    {
+        return mTotalElementStrength;
+    }
+
+    /** @return the strength with which each balancing source exactly balances the element sources */
+    double GetBalancingStrength() const;
+
+    /**
+     * @param slot the slot of a source
+     * @return the source
+     */
+    FluidSource<DIM>* GetSource(unsigned slot) const
+    {
+        return mSources[slot];
+    }
+
+    /**
+     * @param slot the slot of a source
+     * @return pointer to the DIM coordinates of the source; moving a source through this pointer also requires its
+     *     FluidSource location to be set
+     */
+    double* GetLocation(unsigned slot)
+    {
+        return &mLocations[DIM * slot];
+    }
+
+    /**
+     * @param slot the slot of a source
+     * @return pointer to the DIM coordinates of the source
+     */
+    const double* GetLocation(unsigned slot) const
+    {
+        return &mLocations[DIM * slot];
+    }
+
+    /**
+     * @param slot the slot of a source
+     * @return the strength of the source
+     */
+    double GetStrength(unsigned slot) const
+    {
+        return mStrengths[slot];
+    }
+};
+
+#endif /*IMMERSEDBOUNDARYFLUIDSOURCEREGISTRY_HPP_*/
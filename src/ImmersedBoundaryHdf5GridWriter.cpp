@@ -0,0 +1,277 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "ImmersedBoundaryHdf5GridWriter.hpp"
+#include <assert.h>
+#include "Exception.hpp"
+#include "OutputFileHandler.hpp"
+#include "PetscTools.hpp"
+
+ImmersedBoundaryHdf5GridWriter::ImmersedBoundaryHdf5GridWriter(const std::string& rDirectory,
+                                                               const std::string& rFileName,
+                                                               unsigned numGridPtsX,
+                                                               unsigned numGridPtsY,
+                                                               bool writeForce,
+                                                               bool writePressure,
+                                                               unsigned compressionLevel)
+    : mNumGridPtsX(numGridPtsX),
+      mNumGridPtsY(numGridPtsY),
+      mCompressionLevel(compressionLevel),
+      mNumStepsWritten(0),
+      mFileId(-1),
+      mTimeDatasetId(-1),
+      mVelocityDatasetId(-1),
+      mForceDatasetId(-1),
+      mPressureDatasetId(-1)
+{
+    assert(mNumGridPtsX > 0);
+    assert(mNumGridPtsY > 0);
+    assert(mCompressionLevel <= 9);
+
+    // Creating the output directory is collective
+    OutputFileHandler output_file_handler(rDirectory, false);
+    std::string file_name = output_file_handler.GetOutputDirectoryFullPath() + rFileName + ".h5";
+
+    // Every process holds the full grids, so only the master writes them
+    if (!PetscTools::AmMaster())
+    {
+        return;
+    }
+
+    mFileId = H5Fcreate(file_name.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+    if (mFileId < 0)
+    {
+        EXCEPTION("Could not create HDF5 file: " + file_name);
+    }
+
+    bool compress = mCompressionLevel > 0;
+    hsize_t reduced_y = mNumGridPtsY / 2 + 1;
+
+    std::vector<hsize_t> time_chunk(1, 128);
+    mTimeDatasetId = CreateDataset("Time", std::vector<hsize_t>(), time_chunk, false);
+
+    // Chunk the grids by step and component
+    std::vector<hsize_t> grid_dims(3);
+    grid_dims[0] = 2;
+    grid_dims[1] = mNumGridPtsX;
+    grid_dims[2] = mNumGridPtsY;
+    std::vector<hsize_t> grid_chunk(4);
+    grid_chunk[0] = 1;
+    grid_chunk[1] = 1;
+    grid_chunk[2] = mNumGridPtsX;
+    grid_chunk[3] = mNumGridPtsY;
+    mVelocityDatasetId = CreateDataset("Velocity", grid_dims, grid_chunk, compress);
+    if (writeForce)
+    {
+        mForceDatasetId = CreateDataset("Force", grid_dims, grid_chunk, compress);
+    }
+
+    if (writePressure)
+    {
+        std::vector<hsize_t> pressure_dims(3);
+        pressure_dims[0] = mNumGridPtsX;
+        pressure_dims[1] = reduced_y;
+        pressure_dims[2] = 2;
+        std::vector<hsize_t> pressure_chunk(4);
+        pressure_chunk[0] = 1;
+        pressure_chunk[1] = mNumGridPtsX;
+        pressure_chunk[2] = reduced_y;
+        pressure_chunk[3] = 2;
+        mPressureDatasetId = CreateDataset("PressureSpectrum", pressure_dims, pressure_chunk, compress);
+        WriteStringAttribute(mPressureDatasetId, "Description",
+                             "Half spectrum of the pressure from a real-to-complex DFT, as [x][y][real, imaginary]; "
+                             "the pressure is its inverse real DFT");
+    }
+}
+
+ImmersedBoundaryHdf5GridWriter::~ImmersedBoundaryHdf5GridWriter()
+{
+    Close();
+}
+
+hid_t ImmersedBoundaryHdf5GridWriter::CreateDataset(const std::string& rName,
+                                                    const std::vector<hsize_t>& rDims,
+                                                    const std::vector<hsize_t>& rChunkDims,
+                                                    bool compress)
+{
+    assert(rChunkDims.size() == rDims.size() + 1);
+
+    unsigned rank = rChunkDims.size();
+    std::vector<hsize_t> dims(1, 0);
+    dims.insert(dims.end(), rDims.begin(), rDims.end());
+    std::vector<hsize_t> max_dims(dims);
+    max_dims[0] = H5S_UNLIMITED;
+
+    hid_t dataspace = H5Screate_simple(rank, &dims[0], &max_dims[0]);
+    hid_t creation_properties = H5Pcreate(H5P_DATASET_CREATE);
+    H5Pset_chunk(creation_properties, rank, &rChunkDims[0]);
+    if (compress)
+    {
+        // Shuffling the bytes of neighbouring values first makes smooth fields of doubles compress much better
+        H5Pset_shuffle(creation_properties);
+        H5Pset_deflate(creation_properties, mCompressionLevel);
+    }
+
+    hid_t dataset = H5Dcreate2(mFileId, rName.c_str(), H5T_NATIVE_DOUBLE, dataspace,
+                               H5P_DEFAULT, creation_properties, H5P_DEFAULT);
+    H5Pclose(creation_properties);
+    H5Sclose(dataspace);
+
+    if (dataset < 0)
+    {
+        EXCEPTION("Could not create HDF5 dataset " + rName);
+    }
+    return dataset;
+}
+
+void ImmersedBoundaryHdf5GridWriter::WriteStringAttribute(hid_t datasetId,
+                                                          const std::string& rName,
+                                                          const std::string& rValue)
+{
+    hid_t string_type = H5Tcopy(H5T_C_S1);
+    H5Tset_size(string_type, rValue.length());
+    hid_t attribute_space = H5Screate(H5S_SCALAR);
+    hid_t attribute = H5Acreate2(datasetId, rName.c_str(), string_type, attribute_space, H5P_DEFAULT, H5P_DEFAULT);
+    herr_t status = attribute < 0 ? -1 : H5Awrite(attribute, string_type, rValue.c_str());
+    if (attribute >= 0)
+    {
+        H5Aclose(attribute);
+    }
+    H5Sclose(attribute_space);
+    H5Tclose(string_type);
+
+    if (status < 0)
+    {
+        EXCEPTION("Could not write HDF5 attribute " + rName);
+    }
+}
+
+void ImmersedBoundaryHdf5GridWriter::AppendToDataset(hid_t datasetId, const double* pData)
+{
+    // Extend the dataset by one step
+    hid_t file_space = H5Dget_space(datasetId);
+    unsigned rank = H5Sget_simple_extent_ndims(file_space);
+    std::vector<hsize_t> dims(rank);
+    H5Sget_simple_extent_dims(file_space, &dims[0], NULL);
+    H5Sclose(file_space);
+
+    dims[0] = mNumStepsWritten + 1;
+    H5Dset_extent(datasetId, &dims[0]);
+
+    // Select the new step
+    file_space = H5Dget_space(datasetId);
+    std::vector<hsize_t> offset(rank, 0);
+    offset[0] = mNumStepsWritten;
+    std::vector<hsize_t> count(dims);
+    count[0] = 1;
+    H5Sselect_hyperslab(file_space, H5S_SELECT_SET, &offset[0], NULL, &count[0], NULL);
+    hid_t mem_space = rank == 1 ? H5Screate(H5S_SCALAR) : H5Screate_simple(rank - 1, &count[1], NULL);
+
+    herr_t status = H5Dwrite(datasetId, H5T_NATIVE_DOUBLE, mem_space, file_space, H5P_DEFAULT, pData);
+    H5Sclose(mem_space);
+    H5Sclose(file_space);
+
+    if (status < 0)
+    {
+        EXCEPTION("Could not write step " << mNumStepsWritten << " to HDF5 file");
+    }
+}
+
+void ImmersedBoundaryHdf5GridWriter::WriteStep(double time,
+                                               const multi_array<double, 3>& rVelocityGrids,
+                                               const multi_array<double, 3>* pForceGrids,
+                                               const multi_array_ref<std::complex<double>, 2>* pPressureGrid)
+{
+    if (PetscTools::AmMaster())
+    {
+        assert(mFileId >= 0);
+        assert((pForceGrids != NULL) == (mForceDatasetId >= 0));
+        assert((pPressureGrid != NULL) == (mPressureDatasetId >= 0));
+        assert(rVelocityGrids.shape()[0] == 2);
+        assert(rVelocityGrids.shape()[1] == mNumGridPtsX);
+        assert(rVelocityGrids.shape()[2] == mNumGridPtsY);
+
+        AppendToDataset(mTimeDatasetId, &time);
+        AppendToDataset(mVelocityDatasetId, rVelocityGrids.data());
+        if (pForceGrids)
+        {
+            assert(pForceGrids->num_elements() == rVelocityGrids.num_elements());
+            AppendToDataset(mForceDatasetId, pForceGrids->data());
+        }
+
+        if (pPressureGrid)
+        {
+            assert(pPressureGrid->shape()[0] == mNumGridPtsX);
+            assert(pPressureGrid->shape()[1] == mNumGridPtsY / 2 + 1);
+
+            // A std::complex<double> is laid out as its real part followed by its imaginary part
+            AppendToDataset(mPressureDatasetId, reinterpret_cast<const double*>(pPressureGrid->data()));
+        }
+    }
+
+    mNumStepsWritten++;
+}
+
+void ImmersedBoundaryHdf5GridWriter::Close()
+{
+    if (mFileId < 0)
+    {
+        return;
+    }
+
+    H5Dclose(mTimeDatasetId);
+    H5Dclose(mVelocityDatasetId);
+    if (mForceDatasetId >= 0)
+    {
+        H5Dclose(mForceDatasetId);
+    }
+    if (mPressureDatasetId >= 0)
+    {
+        H5Dclose(mPressureDatasetId);
+    }
+    H5Fclose(mFileId);
+
+    mFileId = -1;
+    mTimeDatasetId = -1;
+    mVelocityDatasetId = -1;
+    mForceDatasetId = -1;
+    mPressureDatasetId = -1;
+}
+
+unsigned ImmersedBoundaryHdf5GridWriter::GetNumStepsWritten() const
+{
+    return mNumStepsWritten;
+}
@@ -0,0 +1,176 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef IMMERSEDBOUNDARYHDF5GRIDWRITER_HPP_
+#define IMMERSEDBOUNDARYHDF5GRIDWRITER_HPP_
+
+#include <complex>
+#include <string>
+#include <vector>
+#include <hdf5.h>
+#include "ImmersedBoundaryArray.hpp"
+
+/**
+ * A class to write the 2D fluid grids at a sequence of output steps to a single HDF5 file, so that the flow history
+ * can be analysed without writing a full text snapshot at each step.
+ *
+ * Each grid is appended to its own dataset, whose first dimension is the output step and is extended as steps are
+ * written:
+ *   - "Time" [step], the simulation time of each step;
+ *   - "Velocity" [step][2][Nx][Ny], the velocity grids;
+ *   - "Force" [step][2][Nx][Ny], the force grids (optional);
+ *   - "PressureSpectrum" [step][Nx][Ny/2+1][2], the real and imaginary parts of the half spectrum of the pressure,
+ *     as held by the solver in the Fourier domain (optional).  The pressure itself is the inverse real DFT of this.
+ * The grid datasets are chunked by step and component, and compressed with deflate, so a component can be read over a
+ * range of steps without decompressing whole snapshots.
+ *
+ * Every process holds the full grids, so only the master process creates and writes the file.
+ */
+class ImmersedBoundaryHdf5GridWriter
+{
+private:
+
+    /** The total number of grid points in the x direction. */
+    unsigned mNumGridPtsX;
+
+    /** The total number of grid points in the y direction. */
+    unsigned mNumGridPtsY;
+
+    /** The deflate level (0 to 9) applied to the grid datasets; 0 means no compression. */
+    unsigned mCompressionLevel;
+
+    /** The number of steps written so far. */
+    unsigned mNumStepsWritten;
+
+    /** The HDF5 file, or a negative value once closed or on any process but the master. */
+    hid_t mFileId;
+
+    /** The time dataset. */
+    hid_t mTimeDatasetId;
+
+    /** The velocity dataset. */
+    hid_t mVelocityDatasetId;
+
+    /** The force dataset, or a negative value if forces are not written. */
+    hid_t mForceDatasetId;
+
+    /** The pressure spectrum dataset, or a negative value if the pressure is not written. */
+    hid_t mPressureDatasetId;
+
+    /**
+     * Helper method to create a dataset of doubles whose first (step) dimension is unlimited and initially zero.
+     *
+     * @param rName the name of the dataset
+     * @param rDims the extent of each dimension after the first
+     * @param rChunkDims the chunk extent of every dimension, including the first
+     * @param compress whether to apply deflate to the dataset
+     * @return the new dataset
+     */
+    hid_t CreateDataset(const std::string& rName,
+                        const std::vector<hsize_t>& rDims,
+                        const std::vector<hsize_t>& rChunkDims,
+                        bool compress);
+
+    /**
+     * Helper method to extend a dataset by one step, to #mNumStepsWritten + 1 steps, and write the new step.
+     *
+     * @param datasetId the dataset
+     * @param pData the start of the data for the step, which has the extents of the dataset after the first
+     */
+    void AppendToDataset(hid_t datasetId, const double* pData);
+
+    /**
+     * Helper method to attach a string attribute to a dataset.
+     *
+     * @param datasetId the dataset
+     * @param rName the name of the attribute
+     * @param rValue the value of the attribute
+     */
+    void WriteStringAttribute(hid_t datasetId, const std::string& rName, const std::string& rValue);
+
+public:
+
+    /**
+     * Constructor.  The master process creates the file, overwriting any existing file of the same name.  This is
+     * collective.
+     *
+     * @param rDirectory the output directory, relative to where Chaste output is stored
+     * @param rFileName the name of the file, without the ".h5" extension
+     * @param numGridPtsX the number of grid points in the x direction
+     * @param numGridPtsY the number of grid points in the y direction
+     * @param writeForce whether the force grids are written at each step (defaults to false)
+     * @param writePressure whether the pressure spectrum is written at each step (defaults to false)
+     * @param compressionLevel the deflate level (0 to 9) applied to the grid datasets (defaults to 4)
+     */
+    ImmersedBoundaryHdf5GridWriter(const std::string& rDirectory,
+                                   const std::string& rFileName,
+                                   unsigned numGridPtsX,
+                                   unsigned numGridPtsY,
+                                   bool writeForce=false,
+                                   bool writePressure=false,
+                                   unsigned compressionLevel=4);
+
+    /**
+     * Destructor.  Closes the file if Close() has not been called.
+     */
+    virtual ~ImmersedBoundaryHdf5GridWriter();
+
+    /**
+     * Append one output step to the file.  Only the master process writes, but each process counts the step.
+     *
+     * @param time the simulation time of the step
+     * @param rVelocityGrids the velocity grids
+     * @param pForceGrids the force grids, which must be given if and only if forces are written (defaults to NULL)
+     * @param pPressureGrid the half spectrum of the pressure, as held by ImmersedBoundary2dArrays, which must be given
+     *     if and only if the pressure is written (defaults to NULL)
+     */
+    void WriteStep(double time,
+                   const multi_array<double, 3>& rVelocityGrids,
+                   const multi_array<double, 3>* pForceGrids=NULL,
+                   const multi_array_ref<std::complex<double>, 2>* pPressureGrid=NULL);
+
+    /**
+     * Flush and close the file.  No further steps may be written.
+     */
+    void Close();
+
+    /**
+     * @return the number of steps written so far
+     */
+    unsigned GetNumStepsWritten() const;
+};
+
+#endif /*IMMERSEDBOUNDARYHDF5GRIDWRITER_HPP_*/
@@ -42,7 +42,8 @@ ImmersedBoundaryHoneycombMeshGenerator::ImmersedBoundaryHoneycombMeshGenerator(u
                                                                                unsigned numNodesPerEdge,
                                                                                double proportionalGap,
                                                                                double padding)
-        : mpMesh(NULL)
+        : mpMesh(NULL),
+          mpStamper(NULL)
 {
     // Check for sensible input
     assert(numElementsX > 0);
@@ -55,9 +56,6 @@ ImmersedBoundaryHoneycombMeshGenerator::ImmersedBoundaryHoneycombMeshGenerator(u
     unit_vector<double> x_unit(2,0);
     unit_vector<double> y_unit(2,1);
 
-    std::vector<Node<2>*> nodes;
-    std::vector<ImmersedBoundaryElement<2,2>*>  elements;
-
     double width = 0.5 + 1.5 * numElementsX;
     double height = sqrt(3.0) * numElementsY + 0.5 * sqrt(3.0) * (numElementsY > 1);
 
@@ -97,43 +95,52 @@ ImmersedBoundaryHoneycombMeshGenerator::ImmersedBoundaryHoneycombMeshGenerator(u
         }
     }
 
-    // Get locations for the reference hexagon
+    // Get locations for the reference hexagon, scaled to the size of each cell
     std::vector<c_vector<double, 2> > node_locations = GetUnitHexagon(numNodesPerEdge);
 
     double scale = 1.0 - proportionalGap;
-
-    // For each calculated centre, create the nodes representing each location around that hexagon
-    for (unsigned offset = 0; offset < offsets.size(); offset++)
+    for (unsigned location = 0; location < node_locations.size(); location++)
     {
-        std::vector<Node<2>*> nodes_this_elem;
-
-        for (unsigned location = 0; location < node_locations.size(); location++)
-        {
-            unsigned index = offset * node_locations.size() + location;
-            Node<2>* p_node = new Node<2>(index, offsets[offset] + scale * radius * node_locations[location], true);
+        node_locations[location] = scale * radius * node_locations[location];
+    }
 
-            nodes_this_elem.push_back(p_node);
-            nodes.push_back(p_node);
-        }
+    // Each calculated centre gives a cell, whose nodes are the reference hexagon about that centre
+    mpStamper = new ImmersedBoundaryMeshStamper(node_locations, 128, 128);
 
-        ImmersedBoundaryElement<2,2>* p_elem = new ImmersedBoundaryElement<2,2>(offset, nodes_this_elem);
-        elements.push_back(p_elem);
+    c_vector<double, 2> unit_scale = scalar_vector<double>(2, 1.0);
+    for (unsigned offset = 0; offset < offsets.size(); offset++)
+    {
+        mpStamper->AddCell(unit_scale, offsets[offset]);
     }
-
-    // Create the mesh, cells, cell population, and simulation
-    mpMesh = new ImmersedBoundaryMesh<2,2>(nodes, elements);
 }
 
 ImmersedBoundaryHoneycombMeshGenerator::~ImmersedBoundaryHoneycombMeshGenerator()
 {
     delete mpMesh;
+    delete mpStamper;
 }
 
 ImmersedBoundaryMesh<2,2>* ImmersedBoundaryHoneycombMeshGenerator::GetMesh()
 {
+    if (mpMesh == NULL && mpStamper != NULL)
+    {
+        mpMesh = mpStamper->CreateMesh();
+    }
     return mpMesh;
 }
 
+void ImmersedBoundaryHoneycombMeshGenerator::SetNumThreads(unsigned numThreads)
+{
+    assert(mpStamper != NULL);
+    mpStamper->SetNumThreads(numThreads);
+}
+
+void ImmersedBoundaryHoneycombMeshGenerator::WriteBinaryMeshFile(const std::string& rDirectory, const std::string& rBaseName, bool cleanOutputDirectory)
+{
+    assert(mpStamper != NULL);
+    mpStamper->WriteBinaryMeshFile(rDirectory, rBaseName, cleanOutputDirectory);
+}
+
 std::vector<c_vector<double, 2> > ImmersedBoundaryHoneycombMeshGenerator::GetUnitHexagon(unsigned numPtsPerSide)
 {
     std::vector<c_vector<double, 2> > locations(numPtsPerSide * 6);
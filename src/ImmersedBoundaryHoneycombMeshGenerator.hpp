@@ -37,13 +37,19 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define IMMERSEDBOUNDARYHONEYCOMBMESHGENERATOR_HPP_
 
 #include <cmath>
+#include <string>
 #include <vector>
 
 #include "ImmersedBoundaryMesh.hpp"
+#include "ImmersedBoundaryMeshStamper.hpp"
 
 /**
  * Creates a honeycomb of immersed boundary elements.
  *
+ * The cells are set up by the constructor, but the mesh is only created, with its cells stamped out in parallel, when
+ * first requested by GetMesh().  Alternatively, WriteBinaryMeshFile() writes the mesh straight to a binary mesh file
+ * without creating it.
+ *
  * NOTE: the user should delete the mesh after use to manage memory.
  */
 class ImmersedBoundaryHoneycombMeshGenerator
@@ -51,9 +57,12 @@ class ImmersedBoundaryHoneycombMeshGenerator
 
 private:
 
-    /** A pointer to the mesh this class creates */
+    /** A pointer to the mesh this class creates, or NULL until it is first requested */
     ImmersedBoundaryMesh<2,2>* mpMesh;
 
+    /** The stamper that creates the cells of the mesh from a reference hexagon */
+    ImmersedBoundaryMeshStamper* mpStamper;
+
 public:
 
     /**
@@ -75,6 +84,8 @@ public:
      * Null constructor for derived classes to call.
      */
     ImmersedBoundaryHoneycombMeshGenerator()
+        : mpMesh(NULL),
+          mpStamper(NULL)
     {
     }
 
@@ -86,10 +97,27 @@ public:
     virtual ~ImmersedBoundaryHoneycombMeshGenerator();
 
     /**
-     * @return a 2D honeycomb mesh based on a 2D plane
+     * @return a 2D honeycomb mesh based on a 2D plane, which is created on the first call
      */
     ImmersedBoundaryMesh<2,2>* GetMesh();
 
+    /**
+     * Set the number of threads with which the cells are stamped out by GetMesh() and WriteBinaryMeshFile().
+     *
+     * @param numThreads the number of threads; ignored without OpenMP
+     */
+    void SetNumThreads(unsigned numThreads);
+
+    /**
+     * Write the mesh straight to a binary mesh file, without creating it.  The file is that
+     * ImmersedBoundaryMeshWriter::WriteBinaryFilesUsingMesh() would write for the mesh given by GetMesh().
+     *
+     * @param rDirectory the output directory, relative to where Chaste output is stored
+     * @param rBaseName the base name of the file, to which ".ibm" is appended
+     * @param cleanOutputDirectory whether to clean the output directory (defaults to false)
+     */
+    void WriteBinaryMeshFile(const std::string& rDirectory, const std::string& rBaseName, bool cleanOutputDirectory=false);
+
     /**
      * Helper method for the constructor that calculates locations around a unit hexagon centred at the origin.
      *
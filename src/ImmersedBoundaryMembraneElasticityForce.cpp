@@ -34,6 +34,8 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "ImmersedBoundaryMembraneElasticityForce.hpp"
+#include <algorithm>
+#include <cmath>
 
 template<unsigned DIM>
 ImmersedBoundaryMembraneElasticityForce<DIM>::ImmersedBoundaryMembraneElasticityForce()
@@ -42,7 +44,9 @@ ImmersedBoundaryMembraneElasticityForce<DIM>::ImmersedBoundaryMembraneElasticity
       mSpringConstant(1e6),
       mRestLengthMultiplier(0.5),
       mBasementSpringConstantModifier(5.0),
-      mBasementRestLengthModifier(0.5)
+      mBasementRestLengthModifier(0.5),
+      mNumThreads(1u),
+      mCachedIntrinsicSpacing(DOUBLE_UNSET)
 {
 }
 
@@ -76,8 +80,9 @@ double ImmersedBoundaryMembraneElasticityForce<DIM>::GetBasalLengthForElement(un
 }
 
 template<unsigned DIM>
-void ImmersedBoundaryMembraneElasticityForce<DIM>::AddImmersedBoundaryForceContribution(std::vector<std::pair<Node<DIM>*, Node<DIM>*> >& rNodePairs,
-        ImmersedBoundaryCellPopulation<DIM>& rCellPopulation)
+void ImmersedBoundaryMembraneElasticityForce<DIM>::AddForceContributionsToNodeArrays(const ImmersedBoundaryNodePairList<DIM>& rNodePairs,
+                                                                                     ImmersedBoundaryNodeArrays<DIM>& rNodeArrays,
+                                                                                     ImmersedBoundaryCellPopulation<DIM>& rCellPopulation)
 {
     if (mpMesh == NULL)
     {
@@ -140,80 +145,63 @@ void ImmersedBoundaryMembraneElasticityForce<DIM>::AddImmersedBoundaryForceContr
         }
     }
 
-    // Used in the calculation of the spring constant
-    double intrinsic_spacing_squared = rCellPopulation.GetIntrinsicSpacing() * rCellPopulation.GetIntrinsicSpacing();
-
-    for (typename ImmersedBoundaryMesh<DIM, DIM>::ImmersedBoundaryElementIterator elem_it = mpMesh->GetElementIteratorBegin();
-         elem_it != mpMesh->GetElementIteratorEnd();
-         ++elem_it)
+    // The spring properties of each element are derived from its average node spacing, and only recalculated when
+    // that changes
+    UpdateElementSpringProperties(rCellPopulation.GetIntrinsicSpacing());
+
+    /*
+     * The force on each node is the difference between the spring forces on the edges to the next and from the
+     * previous node.  Rather than by element, whose sizes vary widely (the basement lamina, if present, has many more
+     * nodes than any cell), the work is split into equal chunks of consecutive slots, each of which may span several
+     * elements or part of one.  Along a chunk, the force on the edge to the next node is carried over as the force on
+     * the edge from the previous node, so each edge is calculated once, except at the start of a chunk or element.
+     * Each slot is written by a single thread, and the forces are the same for any number of threads.
+     */
+    const unsigned chunk_size = 256;
+    const int num_slots = (int) rNodeArrays.GetNumSlots();
+    const int num_chunks = (num_slots + chunk_size - 1) / chunk_size;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(mNumThreads) schedule(dynamic)
+#endif
+    for (int chunk = 0; chunk < num_chunks; chunk++)
     {
-        // Get index and number of nodes of current element
-        unsigned elem_idx = elem_it->GetIndex();
-        unsigned num_nodes = elem_it->GetNumNodes();
-
-        // Helper variables
-        double normed_dist;
-        c_vector<double, DIM> aggregate_force;
-
-        // Make a vector to store the force on node i+1 from node i
-        std::vector<c_vector<double, DIM> > elastic_force_to_next_node(num_nodes);
-
-        /*
-         * Get the node spacing ratio for this element.  The rest length and spring constant are derived from this
-         * characteristic length.
-         *
-         * The spring constant is derived with reference to the intrinsic spacing, so that with different node spacings
-         * the user-defined parameters do not have to be updated.
-         *
-         * The correct factor to increase the spring constant by is (intrinsic spacing / spacing_ratio)^2.  One factor
-         * takes into account the energy considerations of the elastic springs, and the other takes account of the
-         * factor of spacing_ratio used in discretising the force relation.
-         */
-        double spacing_ratio = mpMesh->GetAverageNodeSpacingOfElement(elem_idx, false);
-
-        double spring_constant = mSpringConstant * intrinsic_spacing_squared / (spacing_ratio * spacing_ratio);
-        double rest_length = mRestLengthMultiplier * spacing_ratio;
-
-        /*
-         * Here we make any necessary modifications to the spring properties
-         */
+        unsigned chunk_end = std::min((unsigned) (chunk + 1) * chunk_size, (unsigned) num_slots);
 
-        // The basement lamina, if present, will have different properties
-        if (elem_idx == mpMesh->GetMembraneIndex())
-        {
-            spring_constant *= mBasementSpringConstantModifier;
-            rest_length *= mBasementRestLengthModifier;
-        }
+        double force_from_prev[DIM];
+        double force_to_next[DIM];
 
-        // Loop over nodes and calculate the force exerted on node i+1 by node i
-        for (unsigned node_idx = 0; node_idx < num_nodes; node_idx++)
+        for (unsigned slot = chunk * chunk_size; slot < chunk_end; slot++)
         {
-            // Index of the next node, calculated modulo number of nodes in this element
-            unsigned next_idx = (node_idx + 1) % num_nodes;
-
-            double modified_spring_constant = spring_constant;
-            double modified_rest_length = rest_length;
+            unsigned elem_idx = rNodeArrays.GetElementIndex(slot);
+            unsigned first_slot = rNodeArrays.GetElementBegin(elem_idx);
+            unsigned last_slot = rNodeArrays.GetElementEnd(elem_idx) - 1;
 
-            // Hooke's law linear spring force
-            elastic_force_to_next_node[node_idx] = mpMesh->GetVectorFromAtoB(elem_it->GetNodeLocation(node_idx), elem_it->GetNodeLocation(next_idx));
-            normed_dist = norm_2(elastic_force_to_next_node[node_idx]);
-            elastic_force_to_next_node[node_idx] *= modified_spring_constant * (normed_dist - modified_rest_length) / normed_dist;
-        }
+            double spring_constant = mElementSpringConstants[elem_idx];
+            double rest_length = mElementRestLengths[elem_idx];
 
-        // Add the contributions of springs adjacent to each node
-        for (unsigned node_idx = 0; node_idx < num_nodes; node_idx++)
-        {
-            // Get index of previous node
-            unsigned prev_idx = (node_idx + num_nodes - 1) % num_nodes;
+            // At the start of a chunk or element, calculate the spring force on the edge from the previous node
+            if (slot == chunk * chunk_size || slot == first_slot)
+            {
+                unsigned prev_slot = slot == first_slot ? last_slot : slot - 1;
+                CalculateSpringForce(rNodeArrays, prev_slot, slot, spring_constant, rest_length, force_from_prev);
+            }
 
-            aggregate_force = elastic_force_to_next_node[node_idx] - elastic_force_to_next_node[prev_idx];
+            unsigned next_slot = slot == last_slot ? first_slot : slot + 1;
+            CalculateSpringForce(rNodeArrays, slot, next_slot, spring_constant, rest_length, force_to_next);
 
-            // Add the aggregate force contribution to the node
-            elem_it->GetNode(node_idx)->AddAppliedForceContribution(aggregate_force);
+            // Add the contributions of springs adjacent to the node
+            double* p_applied_force = rNodeArrays.GetAppliedForce(slot);
+            for (unsigned dim = 0; dim < DIM; dim++)
+            {
+                p_applied_force[dim] += force_to_next[dim] - force_from_prev[dim];
+                force_from_prev[dim] = force_to_next[dim];
+            }
         }
+    }
 
-        ///\todo Why is this code commented out?
-        // If corners are present, we add on the additional functionality
+    ///\todo Why is this code commented out?
+    // If corners are present, we add on the additional functionality, for each element
 //        if (mElementsHaveCorners)
 //        {
 //            // Add force contributions from apical and basal surfaces
@@ -245,6 +233,102 @@ void ImmersedBoundaryMembraneElasticityForce<DIM>::AddImmersedBoundaryForceContr
 //                r_corners[2]->AddAppliedForceContribution(basal_force);
 //            }
 //        }
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryMembraneElasticityForce<DIM>::AddImmersedBoundaryForceContribution(const ImmersedBoundaryNodePairList<DIM>& rNodePairs,
+        ImmersedBoundaryCellPopulation<DIM>& rCellPopulation)
+{
+    AddForceContributionsToNodeArrays(rNodePairs, rCellPopulation.rGetMesh().rGetNodeArrays(), rCellPopulation);
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryMembraneElasticityForce<DIM>::AddImmersedBoundaryForceContribution(std::vector<std::pair<Node<DIM>*, Node<DIM>*> >& rNodePairs,
+        ImmersedBoundaryCellPopulation<DIM>& rCellPopulation)
+{
+    ImmersedBoundaryNodePairList<DIM> node_pairs(rCellPopulation.GetInteractionDistance());
+    this->ConvertNodePairs(rNodePairs, rCellPopulation, node_pairs);
+    AddImmersedBoundaryForceContribution(node_pairs, rCellPopulation);
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryMembraneElasticityForce<DIM>::CalculateSpringForce(const ImmersedBoundaryNodeArrays<DIM>& rArrays,
+                                                                        unsigned slotA,
+                                                                        unsigned slotB,
+                                                                        double springConstant,
+                                                                        double restLength,
+                                                                        double* pForce)
+{
+    rArrays.GetVectorFromAtoB(slotA, slotB, pForce);
+
+    double normed_dist_squared = 0.0;
+    for (unsigned dim = 0; dim < DIM; dim++)
+    {
+        normed_dist_squared += pForce[dim] * pForce[dim];
+    }
+
+    // Hooke's law linear spring force
+    double normed_dist = sqrt(normed_dist_squared);
+    double scale = springConstant * (normed_dist - restLength) / normed_dist;
+    for (unsigned dim = 0; dim < DIM; dim++)
+    {
+        pForce[dim] *= scale;
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryMembraneElasticityForce<DIM>::UpdateElementSpringProperties(double intrinsicSpacing)
+{
+    assert(mpMesh != NULL);
+
+    unsigned num_elements = mpMesh->GetNumAllElements();
+    if (mElementSpacings.size() != num_elements || intrinsicSpacing != mCachedIntrinsicSpacing)
+    {
+        mElementSpacings.assign(num_elements, DOUBLE_UNSET);
+        mElementSpringConstants.resize(num_elements);
+        mElementRestLengths.resize(num_elements);
+        mCachedIntrinsicSpacing = intrinsicSpacing;
+    }
+
+    // Used in the calculation of the spring constant
+    double intrinsic_spacing_squared = intrinsicSpacing * intrinsicSpacing;
+
+    for (typename ImmersedBoundaryMesh<DIM, DIM>::ImmersedBoundaryElementIterator elem_it = mpMesh->GetElementIteratorBegin();
+         elem_it != mpMesh->GetElementIteratorEnd();
+         ++elem_it)
+    {
+        unsigned elem_idx = elem_it->GetIndex();
+
+        /*
+         * Get the node spacing ratio for this element.  The rest length and spring constant are derived from this
+         * characteristic length.
+         *
+         * The spring constant is derived with reference to the intrinsic spacing, so that with different node spacings
+         * the user-defined parameters do not have to be updated.
+         *
+         * The correct factor to increase the spring constant by is (intrinsic spacing / spacing_ratio)^2.  One factor
+         * takes into account the energy considerations of the elastic springs, and the other takes account of the
+         * factor of spacing_ratio used in discretising the force relation.
+         */
+        double spacing_ratio = mpMesh->GetAverageNodeSpacingOfElement(elem_idx, false);
+        if (spacing_ratio == mElementSpacings[elem_idx])
+        {
+            continue;
+        }
+        mElementSpacings[elem_idx] = spacing_ratio;
+
+        double spring_constant = mSpringConstant * intrinsic_spacing_squared / (spacing_ratio * spacing_ratio);
+        double rest_length = mRestLengthMultiplier * spacing_ratio;
+
+        // The basement lamina, if present, will have different properties
+        if (elem_idx == mpMesh->GetMembraneIndex())
+        {
+            spring_constant *= mBasementSpringConstantModifier;
+            rest_length *= mBasementRestLengthModifier;
+        }
+
+        mElementSpringConstants[elem_idx] = spring_constant;
+        mElementRestLengths[elem_idx] = rest_length;
     }
 }
 
@@ -336,6 +420,9 @@ template<unsigned DIM>
 void ImmersedBoundaryMembraneElasticityForce<DIM>::SetSpringConstant(double springConstant)
 {
     mSpringConstant = springConstant;
+
+    // Recalculate the spring properties of every element when next needed
+    mElementSpacings.clear();
 }
 
 template<unsigned DIM>
@@ -348,6 +435,9 @@ template<unsigned DIM>
 void ImmersedBoundaryMembraneElasticityForce<DIM>::SetRestLengthMultiplier(double restLengthMultiplier)
 {
     mRestLengthMultiplier = restLengthMultiplier;
+
+    // Recalculate the spring properties of every element when next needed
+    mElementSpacings.clear();
 }
 
 template<unsigned DIM>
@@ -356,6 +446,19 @@ double ImmersedBoundaryMembraneElasticityForce<DIM>::GetRestLengthMultiplier()
     return mRestLengthMultiplier;
 }
 
+template<unsigned DIM>
+void ImmersedBoundaryMembraneElasticityForce<DIM>::SetNumThreads(unsigned numThreads)
+{
+    assert(numThreads > 0);
+    mNumThreads = numThreads;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundaryMembraneElasticityForce<DIM>::GetNumThreads()
+{
+    return mNumThreads;
+}
+
 template<unsigned DIM>
 void ImmersedBoundaryMembraneElasticityForce<DIM>::OutputImmersedBoundaryForceParameters(out_stream& rParamsFile)
 {
@@ -368,6 +471,44 @@ void ImmersedBoundaryMembraneElasticityForce<DIM>::OutputImmersedBoundaryForcePa
     AbstractImmersedBoundaryForce<DIM>::OutputImmersedBoundaryForceParameters(rParamsFile);
 }
 
+template<unsigned DIM>
+bool ImmersedBoundaryMembraneElasticityForce<DIM>::UsesNodeArrays() const
+{
+    return true;
+}
+
+template<unsigned DIM>
+bool ImmersedBoundaryMembraneElasticityForce<DIM>::UsesNodePairs() const
+{
+    return false;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryMembraneElasticityForce<DIM>::AddElementSpringConstants(std::vector<double>& rSpringConstants)
+{
+    // Nothing to add until the spring properties have first been calculated
+    if (mpMesh == NULL)
+    {
+        return;
+    }
+
+    if (rSpringConstants.size() < mElementSpringConstants.size())
+    {
+        rSpringConstants.resize(mElementSpringConstants.size(), 0.0);
+    }
+
+    for (typename ImmersedBoundaryMesh<DIM, DIM>::ImmersedBoundaryElementIterator elem_it = mpMesh->GetElementIteratorBegin();
+         elem_it != mpMesh->GetElementIteratorEnd();
+         ++elem_it)
+    {
+        unsigned elem_idx = elem_it->GetIndex();
+        if (elem_idx < mElementSpringConstants.size())
+        {
+            rSpringConstants[elem_idx] += mElementSpringConstants[elem_idx];
+        }
+    }
+}
+
 // Explicit instantiation
 template class ImmersedBoundaryMembraneElasticityForce<1>;
 template class ImmersedBoundaryMembraneElasticityForce<2>;
@@ -128,6 +128,51 @@ protected:
     /** Vector containing locations of apical and basal rest-lengths in the element attribute vectors. */
     std::vector<unsigned> mRestLengthLocationsInAttributeVector;
 
+    /**
+     * The number of threads used to calculate the force.  The force is identical whatever the number of threads.
+     *
+     * Initialised to 1 in the constructor.
+     */
+    unsigned mNumThreads;
+
+    /** The average node spacing of each element when its spring properties were last calculated. */
+    std::vector<double> mElementSpacings;
+
+    /** The spring constant of each element, calculated from its average node spacing. */
+    std::vector<double> mElementSpringConstants;
+
+    /** The rest length of each element, calculated from its average node spacing. */
+    std::vector<double> mElementRestLengths;
+
+    /** The intrinsic spacing of the cell population when the element spring properties were last calculated. */
+    double mCachedIntrinsicSpacing;
+
+    /**
+     * Calculate the linear spring force along the edge from node A to node B, which is the force exerted on node A
+     * by node B, and minus that exerted on node B by node A.
+     *
+     * @param rArrays the node arrays of the mesh
+     * @param slotA the slot of node A
+     * @param slotB the slot of node B
+     * @param springConstant the spring constant
+     * @param restLength the rest length
+     * @param pForce filled with the force, DIM values
+     */
+    static void CalculateSpringForce(const ImmersedBoundaryNodeArrays<DIM>& rArrays,
+                                     unsigned slotA,
+                                     unsigned slotB,
+                                     double springConstant,
+                                     double restLength,
+                                     double* pForce);
+
+    /**
+     * Recalculate the spring constant and rest length of each element whose average node spacing has changed since
+     * they were last calculated, or of every element if the parameters or intrinsic spacing have changed.
+     *
+     * @param intrinsicSpacing the intrinsic spacing of the cell population
+     */
+    void UpdateElementSpringProperties(double intrinsicSpacing);
+
     /**
      * @param elemIndex index of the element to retrieve apical length of
      * @return apical length of the specified element
@@ -165,10 +210,35 @@ public:
      */
     virtual ~ImmersedBoundaryMembraneElasticityForce();
 
+    /**
+     * Overridden AddForceContributionsToNodeArrays() method.
+     *
+     * Calculates the force on each node in the immersed boundary cell population as a result of membrane elasticity.
+     *
+     * @param rNodePairs the pairs of nodes in different elements between which to contribute the force
+     * @param rNodeArrays the mesh's node arrays, to whose applied forces contributions are added
+     * @param rCellPopulation reference to the cell population
+     */
+    void AddForceContributionsToNodeArrays(const ImmersedBoundaryNodePairList<DIM>& rNodePairs,
+                                           ImmersedBoundaryNodeArrays<DIM>& rNodeArrays,
+                                           ImmersedBoundaryCellPopulation<DIM>& rCellPopulation);
+
     /**
      * Overridden AddImmersedBoundaryForceContribution() method.
      *
-     * Calculates the force on each node in the immersed boundary cell population as a result of cell-cell interactions.
+     * Adds the force to the mesh's node arrays, as AddForceContributionsToNodeArrays() does.
+     *
+     * @param rNodePairs the pairs of nodes in different elements between which to contribute the force
+     * @param rCellPopulation reference to the cell population
+     */
+    void AddImmersedBoundaryForceContribution(const ImmersedBoundaryNodePairList<DIM>& rNodePairs,
+            ImmersedBoundaryCellPopulation<DIM>& rCellPopulation);
+
+    /**
+     * Overridden AddImmersedBoundaryForceContribution() method.
+     *
+     * Adds the force for the given pairs of Node pointers, through the overload taking an
+     * ImmersedBoundaryNodePairList.
      *
      * @param rNodePairs reference to a vector set of node pairs between which to contribute the force
      * @param rCellPopulation reference to the cell population
@@ -176,6 +246,40 @@ public:
     void AddImmersedBoundaryForceContribution(std::vector<std::pair<Node<DIM>*, Node<DIM>*> >& rNodePairs,
             ImmersedBoundaryCellPopulation<DIM>& rCellPopulation);
 
+    /**
+     * Overridden UsesNodeArrays() method.
+     *
+     * @return true, as this force adds its contributions to the mesh's node arrays
+     */
+    bool UsesNodeArrays() const;
+
+    /**
+     * Overridden UsesNodePairs() method.
+     *
+     * @return false, as the membrane springs act only between neighbouring nodes of the same element
+     */
+    bool UsesNodePairs() const;
+
+    /**
+     * Overridden AddElementSpringConstants() method.
+     *
+     * @param rSpringConstants the spring constant of each element, indexed by element, to which the spring constant
+     *     of the membrane springs of each element is added
+     */
+    void AddElementSpringConstants(std::vector<double>& rSpringConstants);
+
+    /**
+     * Set #mNumThreads.
+     *
+     * @param numThreads the number of threads used to calculate the force
+     */
+    void SetNumThreads(unsigned numThreads);
+
+    /**
+     * @return #mNumThreads
+     */
+    unsigned GetNumThreads();
+
     /**
      * Set #mSpringConstant.
      *
@@ -39,15 +39,23 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Warnings.hpp"
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::ImmersedBoundaryMesh(std::vector<Node<SPACE_DIM>*> nodes,
-                                                                   std::vector<ImmersedBoundaryElement<ELEMENT_DIM,SPACE_DIM>*> elements,
+ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::ImmersedBoundaryMesh(const std::vector<Node<SPACE_DIM>*>& nodes,
+                                                                   const std::vector<ImmersedBoundaryElement<ELEMENT_DIM,SPACE_DIM>*>& elements,
                                                                    unsigned numGridPtsX,
                                                                    unsigned numGridPtsY,
                                                                    unsigned membraneIndex)
     : mNumGridPtsX(numGridPtsX),
       mNumGridPtsY(numGridPtsY),
+      mDomainSize(scalar_vector<double>(SPACE_DIM, 1.0)),
+      mHasWalls(SPACE_DIM, false),
+      mPeriods(scalar_vector<double>(SPACE_DIM, 1.0)),
       mMembraneIndex(membraneIndex),
-      mElementDivisionSpacing(DOUBLE_UNSET)
+      mElementDivisionSpacing(DOUBLE_UNSET),
+      m2dVelocityGrids(ImmersedBoundaryAlignedAllocator<double>(2)),
+      m3dVelocityGrids(ImmersedBoundaryAlignedAllocator<double>(3)),
+      mNumElementGeometryUpdates(0u),
+      mRefreshNodeSpacingWithGeometry(false),
+      mNumReMeshes(0u)
 {
     // Clear mNodes and mElements
     Clear();
@@ -72,6 +80,8 @@ ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::ImmersedBoundaryMesh(std::vector<N
     mMeshHasMembrane = mMembraneIndex != UINT_MAX;
 
     // Populate mNodes and mElements
+    this->mNodes.reserve(nodes.size());
+    mElements.reserve(elements.size());
     for (unsigned node_index=0; node_index<nodes.size(); node_index++)
     {
         Node<SPACE_DIM>* p_temp_node = nodes[node_index];
@@ -194,7 +204,8 @@ double ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetTortuosityOfMesh()
     c_vector<double, 2> last_centroid = this->GetCentroidOfElement(this->GetNumElements()-1);
 
     double straight_line_length = norm_2(this->GetVectorFromAtoB(first_centroid, last_centroid));
-    straight_line_length = std::max(straight_line_length, 1.0-straight_line_length);
+    // The elements span the periodic domain in x, so the line between the end elements may instead wrap around
+    straight_line_length = std::max(straight_line_length, this->GetDomainWidth() - straight_line_length);
 
     return total_length / straight_line_length;
 }
@@ -328,9 +339,15 @@ double ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetSkewnessOfElementMassDis
             to_previous = to_next;
         }
 
+        // Serialised with the other warnings, as the meshes of an ensemble's members are measured concurrently
         if (knots[location].size() > 2)
         {
-            WARN_ONCE_ONLY("Axis intersects polygon more than 2 times (concavity) - check element is fairly convex.");
+#ifdef _OPENMP
+#pragma omp critical(ImmersedBoundaryWarnings)
+#endif
+            {
+                WARN_ONCE_ONLY("Axis intersects polygon more than 2 times (concavity) - check element is fairly convex.");
+            }
         }
     }
 
@@ -453,6 +470,14 @@ ChasteCuboid<SPACE_DIM> ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::CalculateB
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::ImmersedBoundaryMesh()
+    : mDomainSize(scalar_vector<double>(SPACE_DIM, 1.0)),
+      mHasWalls(SPACE_DIM, false),
+      mPeriods(scalar_vector<double>(SPACE_DIM, 1.0)),
+      m2dVelocityGrids(ImmersedBoundaryAlignedAllocator<double>(2)),
+      m3dVelocityGrids(ImmersedBoundaryAlignedAllocator<double>(3)),
+      mNumElementGeometryUpdates(0u),
+      mRefreshNodeSpacingWithGeometry(false),
+      mNumReMeshes(0u)
 {
     this->mMeshChangesDuringSimulation = false;
     Clear();
@@ -487,19 +512,33 @@ unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::SolveBoundaryElementMappi
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::Clear()
 {
-    // Delete elements
+    // Delete elements, other than those created by division which belong to the element pool
     for (unsigned i=0; i<mElements.size(); i++)
     {
-        delete mElements[i];
+        if (!mElementPool.Owns(mElements[i]))
+        {
+            delete mElements[i];
+        }
     }
     mElements.clear();
+    mElementPool.Clear();
 
-    // Delete nodes
+    // Delete nodes, other than those created by division which belong to the node pool
     for (unsigned i=0; i<this->mNodes.size(); i++)
     {
-        delete this->mNodes[i];
+        if (!mNodePool.Owns(this->mNodes[i]))
+        {
+            delete this->mNodes[i];
+        }
     }
     this->mNodes.clear();
+    mNodePool.Clear();
+
+    mNodeArraysAreStale = true;
+    mFluidSourceRegistryIsStale = true;
+    mElementGeometriesAreStale = true;
+    mNumDeletedElements = 0;
+    mTopologyChanges.MarkIncomplete();
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
@@ -511,8 +550,86 @@ double ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetCharacteristicNodeSpacin
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 double ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetSpacingRatio() const
 {
-    ///todo If we ever permit mNumGridPtsX != mNumGridPtsY, need to decide how SpacingRatio is defined
-    return mCharacteristicNodeSpacing / (1.0 / double(mNumGridPtsX));
+    ///todo With anisotropic grid spacing, the ratio is taken relative to the spacing in the x direction
+    return mCharacteristicNodeSpacing / (mDomainSize[0] / double(mNumGridPtsX));
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::SetDomainSize(double width, double height)
+{
+    if (width <= 0.0 || height <= 0.0)
+    {
+        EXCEPTION("The domain width and height must be positive");
+    }
+
+    mDomainSize[0] = width;
+    if (SPACE_DIM > 1)
+    {
+        mDomainSize[1] = height;
+    }
+    UpdatePeriods();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::SetWalls(bool wallsNormalToX, bool wallsNormalToY)
+{
+    mHasWalls[0] = wallsNormalToX;
+    if (SPACE_DIM > 1)
+    {
+        mHasWalls[1] = wallsNormalToY;
+    }
+    UpdatePeriods();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::HasWalls(unsigned dim) const
+{
+    assert(dim < SPACE_DIM);
+    return mHasWalls[dim];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::HasWalls() const
+{
+    return std::find(mHasWalls.begin(), mHasWalls.end(), true) != mHasWalls.end();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const c_vector<double, SPACE_DIM>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetPeriods() const
+{
+    return mPeriods;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::UpdatePeriods()
+{
+    // A vector across a walled direction never exceeds half of twice the domain size, so is never wrapped
+    for (unsigned dim = 0; dim < SPACE_DIM; dim++)
+    {
+        mPeriods[dim] = mHasWalls[dim] ? 2.0 * mDomainSize[dim] : mDomainSize[dim];
+    }
+    mNodeArrays.SetPeriods(mPeriods);
+
+    // Centroids, and anything else depending on periodicity, must be recalculated
+    mElementGeometriesAreStale = true;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+double ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetDomainWidth() const
+{
+    return mDomainSize[0];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+double ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetDomainHeight() const
+{
+    return SPACE_DIM > 1 ? mDomainSize[1] : 1.0;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const c_vector<double, SPACE_DIM>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetDomainSize() const
+{
+    return mDomainSize;
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
@@ -559,6 +676,9 @@ template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::SetMembraneIndex(unsigned membrane_index)
 {
     mMembraneIndex = membrane_index;
+
+    // The membrane is never treated as overlapping, so every element's overlaps must be recalculated
+    mNodeArraysAreStale = true;
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
@@ -568,172 +688,951 @@ ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>* ImmersedBoundaryMesh<ELEMENT_DI
     {
         return this->GetElement(mMembraneIndex);
     }
-    else
+    else
+    {
+        return NULL;
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetMembraneIndex()
+{
+    return mMembraneIndex;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+std::vector<FluidSource<SPACE_DIM>*>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetElementFluidSources()
+{
+    return mElementFluidSources;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+std::vector<FluidSource<SPACE_DIM>*>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetBalancingFluidSources()
+{
+    return mBalancingFluidSources;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+ImmersedBoundaryFluidSourceRegistry<SPACE_DIM>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetFluidSourceRegistry()
+{
+    if (mFluidSourceRegistryIsStale)
+    {
+        mFluidSourceRegistry.Reset(mElementFluidSources, mBalancingFluidSources);
+        mFluidSourceRegistryIsStale = false;
+    }
+    return mFluidSourceRegistry;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const multi_array<double, 3>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGet2dVelocityGrids() const
+{
+    return m2dVelocityGrids;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const multi_array<double, 4>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGet3dVelocityGrids() const
+{
+    return m3dVelocityGrids;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+multi_array<double, 3>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetModifiable2dVelocityGrids()
+{
+    return m2dVelocityGrids;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+multi_array<double, 4>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetModifiable3dVelocityGrids()
+{
+    return m3dVelocityGrids;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+std::vector<Node<SPACE_DIM>*>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetNodes()
+{
+    return AbstractMesh<ELEMENT_DIM, SPACE_DIM>::mNodes;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+c_vector<double, SPACE_DIM> ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetVectorFromAtoB(const c_vector<double, SPACE_DIM>& rLocation1, const c_vector<double, SPACE_DIM>& rLocation2)
+{
+    c_vector<double, SPACE_DIM> vector;
+
+    /*
+     * Handle the periodic condition here: if the points are more than half
+     * the period apart in any direction, choose -(period-dist).
+     */
+    for (unsigned dim = 0; dim < SPACE_DIM; dim++)
+    {
+        vector[dim] = ImmersedBoundaryPeriodicGeometry::MinimumImage(rLocation2[dim] - rLocation1[dim], mPeriods[dim]);
+    }
+
+    return vector;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::SetNode(unsigned nodeIndex, ChastePoint<SPACE_DIM> point)
+{
+    this->mNodes[nodeIndex]->SetPoint(point);
+
+    // Only the elements containing this node change shape
+    std::set<unsigned>& r_containing_elements = this->mNodes[nodeIndex]->rGetContainingElementIndices();
+    for (std::set<unsigned>::iterator it = r_containing_elements.begin(); it != r_containing_elements.end(); ++it)
+    {
+        if (*it < mElementGeometryIsStale.size())
+        {
+            mElementGeometryIsStale[*it] = true;
+        }
+        if (*it < mPeriodicOverlaps.GetNumElements())
+        {
+            mPeriodicOverlaps.MarkElementStale(*it);
+        }
+    }
+
+    // Keep the node arrays in step, if they are in use
+    if (!mNodeArraysAreStale)
+    {
+        unsigned slot = mNodeArrays.GetSlotOfNode(nodeIndex);
+        if (slot != UINT_MAX)
+        {
+            double* p_location = mNodeArrays.GetLocation(slot);
+            for (unsigned dim = 0; dim < SPACE_DIM; dim++)
+            {
+                p_location[dim] = point[dim];
+            }
+        }
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::RebuildNodeArrays()
+{
+    // Only attributes common to every node are mirrored
+    unsigned num_attributes = this->mNodes.empty() ? 0 : UINT_MAX;
+    for (unsigned node_idx = 0; node_idx < this->mNodes.size(); node_idx++)
+    {
+        num_attributes = std::min(num_attributes, this->mNodes[node_idx]->GetNumNodeAttributes());
+    }
+
+    mNodeArrays.Reset(this->mNodes.size(), mElements.size(), num_attributes);
+
+    const std::vector<double> no_attributes;
+    for (unsigned elem_idx = 0; elem_idx < mElements.size(); elem_idx++)
+    {
+        ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>* p_element = mElements[elem_idx];
+        if (p_element->IsDeleted())
+        {
+            continue;
+        }
+
+        mNodeArrays.BeginElement(p_element->GetIndex());
+        for (unsigned node_idx = 0; node_idx < p_element->GetNumNodes(); node_idx++)
+        {
+            Node<SPACE_DIM>* p_node = p_element->GetNode(node_idx);
+            mNodeArrays.AddNode(p_node->GetIndex(),
+                                p_node->rGetLocation(),
+                                p_node->rGetAppliedForce(),
+                                num_attributes > 0 ? p_node->rGetNodeAttributes() : no_attributes);
+        }
+    }
+
+    mPeriodicOverlaps.MarkAllStale(mElements.size());
+    mNodeArraysAreStale = false;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+ImmersedBoundaryNodeArrays<SPACE_DIM>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetNodeArrays()
+{
+    if (mNodeArraysAreStale)
+    {
+        RebuildNodeArrays();
+    }
+    return mNodeArrays;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const ImmersedBoundaryPeriodicOverlaps<SPACE_DIM>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetPeriodicOverlaps()
+{
+    mPeriodicOverlaps.Update(rGetNodeArrays(), mMembraneIndex);
+    return mPeriodicOverlaps;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+ImmersedBoundaryPeriodicOverlaps<SPACE_DIM>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetModifiablePeriodicOverlaps()
+{
+    return mPeriodicOverlaps;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::InvalidateNodeArrays()
+{
+    mNodeArraysAreStale = true;
+    mElementGeometriesAreStale = true;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::SynchroniseNodeLocations()
+{
+    assert(!mNodeArraysAreStale);
+
+    // Every node may have moved
+    mElementGeometriesAreStale = true;
+
+    for (unsigned slot = 0; slot < mNodeArrays.GetNumSlots(); slot++)
+    {
+        c_vector<double, SPACE_DIM>& r_location = this->mNodes[mNodeArrays.GetNodeIndex(slot)]->rGetModifiableLocation();
+        const double* p_location = mNodeArrays.GetLocation(slot);
+
+        for (unsigned dim = 0; dim < SPACE_DIM; dim++)
+        {
+            r_location[dim] = p_location[dim];
+        }
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::SynchroniseNodeAppliedForces()
+{
+    assert(!mNodeArraysAreStale);
+
+    for (unsigned slot = 0; slot < mNodeArrays.GetNumSlots(); slot++)
+    {
+        c_vector<double, SPACE_DIM> force;
+        const double* p_force = mNodeArrays.GetAppliedForce(slot);
+        for (unsigned dim = 0; dim < SPACE_DIM; dim++)
+        {
+            force[dim] = p_force[dim];
+        }
+
+        Node<SPACE_DIM>* p_node = this->mNodes[mNodeArrays.GetNodeIndex(slot)];
+        p_node->ClearAppliedForce();
+        p_node->AddAppliedForceContribution(force);
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::AddNodeAppliedForcesToNodeArrays()
+{
+    assert(!mNodeArraysAreStale);
+
+    for (unsigned slot = 0; slot < mNodeArrays.GetNumSlots(); slot++)
+    {
+        mNodeArrays.AddAppliedForceContribution(slot, this->mNodes[mNodeArrays.GetNodeIndex(slot)]->rGetAppliedForce());
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+std::vector<unsigned> ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::ReorderAlongSpaceFillingCurve(const ImmersedBoundarySpaceFillingCurve& rCurve)
+{
+    unsigned num_nodes = this->mNodes.size();
+    unsigned num_elements = mElements.size();
+
+    std::vector<double> x_coordinates(std::max(num_nodes, num_elements));
+    std::vector<double> y_coordinates(std::max(num_nodes, num_elements));
+    std::vector<unsigned> order;
+
+    // Renumber the nodes by location; nothing refers to a node by index except the node itself
+    for (unsigned node_idx = 0; node_idx < num_nodes; node_idx++)
+    {
+        const c_vector<double, SPACE_DIM>& r_location = this->mNodes[node_idx]->rGetLocation();
+        x_coordinates[node_idx] = r_location[0];
+        y_coordinates[node_idx] = SPACE_DIM > 1 ? r_location[1] : 0.0;
+    }
+    x_coordinates.resize(num_nodes);
+    y_coordinates.resize(num_nodes);
+    rCurve.Sort(x_coordinates, y_coordinates, order);
+
+    std::vector<Node<SPACE_DIM>*> old_nodes = this->mNodes;
+    for (unsigned new_idx = 0; new_idx < num_nodes; new_idx++)
+    {
+        this->mNodes[new_idx] = old_nodes[order[new_idx]];
+        this->mNodes[new_idx]->SetIndex(new_idx);
+    }
+
+    // Renumber the elements by centroid
+    x_coordinates.resize(num_elements);
+    y_coordinates.resize(num_elements);
+    for (unsigned elem_idx = 0; elem_idx < num_elements; elem_idx++)
+    {
+        c_vector<double, SPACE_DIM> centroid = this->GetCentroidOfElement(elem_idx);
+        x_coordinates[elem_idx] = centroid[0];
+        y_coordinates[elem_idx] = SPACE_DIM > 1 ? centroid[1] : 0.0;
+    }
+    rCurve.Sort(x_coordinates, y_coordinates, order);
+
+    std::vector<unsigned> new_element_indices(num_elements);
+    for (unsigned new_idx = 0; new_idx < num_elements; new_idx++)
+    {
+        new_element_indices[order[new_idx]] = new_idx;
+    }
+
+    /*
+     * Resetting an element's index also replaces it in the containing element indices of each of its nodes.  Going
+     * via a temporary index not yet in use ensures no node ever loses the index of a different element it is in.
+     */
+    for (unsigned elem_idx = 0; elem_idx < num_elements; elem_idx++)
+    {
+        mElements[elem_idx]->ResetIndex(num_elements + new_element_indices[elem_idx]);
+    }
+
+    std::vector<ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>*> old_elements = mElements;
+    for (unsigned new_idx = 0; new_idx < num_elements; new_idx++)
+    {
+        mElements[new_idx] = old_elements[order[new_idx]];
+        mElements[new_idx]->ResetIndex(new_idx);
+
+        FluidSource<SPACE_DIM>* p_source = mElements[new_idx]->GetFluidSource();
+        if (p_source)
+        {
+            p_source->SetAssociatedElementIndex(new_idx);
+        }
+    }
+
+    if (mMembraneIndex != UINT_MAX)
+    {
+        mMembraneIndex = new_element_indices[mMembraneIndex];
+    }
+
+    mNodeArraysAreStale = true;
+    mElementGeometriesAreStale = true;
+    mTopologyChanges.MarkIncomplete();
+
+    return new_element_indices;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetNumNodes() const
+{
+    return this->mNodes.size();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetNumElements() const
+{
+    return mElements.size();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetNumAllElements() const
+{
+    return mElements.size();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>* ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetElement(unsigned index) const
+{
+    assert(index < mElements.size());
+    return mElements[index];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+c_vector<double, SPACE_DIM> ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetCentroidOfElement(unsigned index)
+{
+    // Only implemented in 2D
+    assert(SPACE_DIM == 2);
+
+    return rGetElementGeometry(index).mCentroid;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::CalculateElementGeometry(unsigned index, ElementGeometry& rGeometry)
+{
+    // Only implemented in 2D
+    assert(SPACE_DIM == 2);
+
+    ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>* p_element = GetElement(index);
+    unsigned num_nodes = p_element->GetNumNodes();
+
+    if (mGeometryEdgeLengths.size() < num_nodes)
+    {
+        mGeometryLocations.resize(2 * num_nodes);
+        mGeometryRelativeLocations.resize(2 * num_nodes);
+        mGeometryEdgeVectors.resize(2 * num_nodes);
+        mGeometryEdgeLengths.resize(num_nodes);
+    }
+
+    // Gather the locations of the nodes into a single interleaved run, for ImmersedBoundaryPeriodicGeometry
+    double* p_locations = &mGeometryLocations[0];
+    for (unsigned local_index = 0; local_index < num_nodes; local_index++)
+    {
+        const c_vector<double, SPACE_DIM>& r_location = p_element->GetNode(local_index)->rGetLocation();
+        p_locations[2*local_index] = r_location[0];
+        p_locations[2*local_index + 1] = r_location[1];
+    }
+
+    const double periods[2] = {mPeriods[0], mPeriods[1]};
+    double* p_relative = &mGeometryRelativeLocations[0];
+
+    // The edges are found directly, as the membrane element spans the domain and so is not a closed polygon
+    ImmersedBoundaryPeriodicGeometry::CalculateEdgeVectors(p_locations, num_nodes, periods, &mGeometryEdgeVectors[0]);
+    ImmersedBoundaryPeriodicGeometry::CalculateEdgeLengths(&mGeometryEdgeVectors[0], num_nodes, &mGeometryEdgeLengths[0]);
+    double surface_area = ImmersedBoundaryPeriodicGeometry::CalculatePerimeter(&mGeometryEdgeLengths[0], num_nodes);
+
+    // Map the first vertex to the origin to allow for periodicity
+    ImmersedBoundaryPeriodicGeometry::CalculateRelativeLocations(p_locations, num_nodes, periods, p_relative);
+    double element_signed_area = ImmersedBoundaryPeriodicGeometry::CalculateSignedArea(p_relative, num_nodes);
+
+    // The first node is at the origin, so the edges to and from it contribute nothing to the centroid
+    double centroid_x = 0.0;
+    double centroid_y = 0.0;
+    for (unsigned i = 0; i + 1 < num_nodes; i++)
+    {
+        double signed_area_term = p_relative[2*i] * p_relative[2*i + 3] - p_relative[2*i + 1] * p_relative[2*i + 2];
+        centroid_x += (p_relative[2*i] + p_relative[2*i + 2]) * signed_area_term;
+        centroid_y += (p_relative[2*i + 1] + p_relative[2*i + 3]) * signed_area_term;
+    }
+
+    // We take the absolute value just in case the nodes were really oriented clockwise
+    rGeometry.mVolume = fabs(element_signed_area);
+    rGeometry.mSurfaceArea = surface_area;
+
+    // The membrane must be treated differently
+    if (index == mMembraneIndex)
+    {
+        rGeometry.mCentroid = zero_vector<double>(SPACE_DIM);
+    }
+    else
+    {
+        assert(element_signed_area != 0.0);
+
+        // Finally, map back to allow for periodicity
+        rGeometry.mCentroid[0] = p_locations[0] + centroid_x / (6.0 * element_signed_area);
+        rGeometry.mCentroid[1] = p_locations[1] + centroid_y / (6.0 * element_signed_area);
+
+        for (unsigned dim = 0; dim < 2; dim++)
+        {
+            double size = mPeriods[dim];
+            rGeometry.mCentroid[dim] = rGeometry.mCentroid[dim] < 0 ? rGeometry.mCentroid[dim] + size : fmod(rGeometry.mCentroid[dim], size);
+        }
+    }
+
+    // Since we compute I_xx, I_yy and I_xy about the centroid, we must shift each vertex accordingly
+    const double centroid[2] = {rGeometry.mCentroid[0], rGeometry.mCentroid[1]};
+    ImmersedBoundaryPeriodicGeometry::CalculateLocationsRelativeTo(p_locations, num_nodes, centroid, periods, p_relative);
+
+    c_vector<double, 3>& r_moments = rGeometry.mMoments;
+    r_moments = zero_vector<double>(3);
+
+    for (unsigned i = 0; i < num_nodes; i++)
+    {
+        unsigned next = (i + 1 == num_nodes) ? 0 : i + 1;
+        double x_1 = p_relative[2*i];
+        double y_1 = p_relative[2*i + 1];
+        double x_2 = p_relative[2*next];
+        double y_2 = p_relative[2*next + 1];
+
+        double signed_area_term = x_1*y_2 - x_2*y_1;
+        // Ixx
+        r_moments(0) += (y_1*y_1 + y_1*y_2 + y_2*y_2) * signed_area_term;
+
+        // Iyy
+        r_moments(1) += (x_1*x_1 + x_1*x_2 + x_2*x_2) * signed_area_term;
+
+        // Ixy
+        r_moments(2) += (x_1*y_2 + 2*x_1*y_1 + 2*x_2*y_2 + x_2*y_1) * signed_area_term;
+    }
+
+    r_moments(0) /= 12;
+    r_moments(1) /= 12;
+    r_moments(2) /= 24;
+
+    /*
+     * If the nodes owned by the element were supplied in a clockwise rather
+     * than anticlockwise manner, or if this arose as a result of enforcing
+     * periodicity, then our computed quantities will be the wrong sign, so
+     * we need to fix this.
+     */
+    if (r_moments(0) < 0.0)
+    {
+        r_moments(0) = -r_moments(0);
+        r_moments(1) = -r_moments(1);
+        r_moments(2) = -r_moments(2);
+    }
+
+    if (mRefreshNodeSpacingWithGeometry)
+    {
+        p_element->SetAverageNodeSpacing(surface_area / num_nodes);
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const typename ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::ElementGeometry& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetElementGeometry(unsigned index)
+{
+    assert(index < mElements.size());
+
+    if (mElementGeometriesAreStale || index >= mElementGeometries.size())
+    {
+        UpdateElementGeometries();
+    }
+
+    // Only this element's nodes may have moved, or it is deleted and so skipped by UpdateElementGeometries()
+    if (mElementGeometryIsStale[index])
+    {
+        CalculateElementGeometry(index, mElementGeometries[index]);
+        mElementGeometryIsStale[index] = false;
+    }
+
+    return mElementGeometries[index];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::UpdateElementGeometries()
+{
+    unsigned num_elements = mElements.size();
+    if (mElementGeometries.size() != num_elements)
+    {
+        mElementGeometries.resize(num_elements);
+        mElementGeometryIsStale.resize(num_elements, true);
+    }
+
+    bool any_updated = false;
+    for (unsigned elem_idx = 0; elem_idx < num_elements; elem_idx++)
+    {
+        if (mElementGeometriesAreStale || mElementGeometryIsStale[elem_idx])
+        {
+            // Deleted elements are left stale, so they are only calculated if requested
+            if (mElements[elem_idx]->IsDeleted())
+            {
+                mElementGeometryIsStale[elem_idx] = true;
+            }
+            else
+            {
+                CalculateElementGeometry(elem_idx, mElementGeometries[elem_idx]);
+                mElementGeometryIsStale[elem_idx] = false;
+                any_updated = true;
+            }
+        }
+    }
+
+    mElementGeometriesAreStale = false;
+    if (any_updated)
     {
-        return NULL;
+        mNumElementGeometryUpdates++;
     }
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetMembraneIndex()
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::InvalidateElementGeometries()
 {
-    return mMembraneIndex;
+    mElementGeometriesAreStale = true;
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-std::vector<FluidSource<SPACE_DIM>*>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetElementFluidSources()
+unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetNumElementGeometryUpdates() const
 {
-    return mElementFluidSources;
+    return mNumElementGeometryUpdates;
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-std::vector<FluidSource<SPACE_DIM>*>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetBalancingFluidSources()
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::SetRefreshNodeSpacingWithGeometry(bool refreshNodeSpacingWithGeometry)
 {
-    return mBalancingFluidSources;
+    mRefreshNodeSpacingWithGeometry = refreshNodeSpacingWithGeometry;
+    mElementGeometriesAreStale = true;
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-const multi_array<double, 3>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGet2dVelocityGrids() const
+bool ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetRefreshNodeSpacingWithGeometry() const
 {
-    return m2dVelocityGrids;
+    return mRefreshNodeSpacingWithGeometry;
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-const multi_array<double, 4>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGet3dVelocityGrids() const
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::ReserveForDivisions(unsigned numDivisions)
 {
-    return m3dVelocityGrids;
-}
+    unsigned num_elements = mElements.size();
+    unsigned nodes_per_element = num_elements == 0 ? 0 : this->mNodes.size() / num_elements;
 
-template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-multi_array<double, 3>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetModifiable2dVelocityGrids()
-{
-    return m2dVelocityGrids;
+    this->mNodes.reserve(this->mNodes.size() + numDivisions * nodes_per_element);
+    mElements.reserve(num_elements + numDivisions);
+    mElementFluidSources.reserve(mElementFluidSources.size() + numDivisions);
+
+    mNodePool.Reserve(numDivisions * nodes_per_element);
+    mElementPool.Reserve(numDivisions);
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-multi_array<double, 4>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetModifiable3dVelocityGrids()
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::DeleteElementPriorToReMesh(unsigned index)
 {
-    return m3dVelocityGrids;
+    assert(index < mElements.size());
+    ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>* p_element = mElements[index];
+    assert(!p_element->IsDeleted());
+
+    // Each node belongs to this element alone
+    for (unsigned node_idx = 0; node_idx < p_element->GetNumNodes(); node_idx++)
+    {
+        p_element->GetNode(node_idx)->MarkAsDeleted();
+    }
+    p_element->MarkAsDeleted();
+
+    if (p_element->GetFluidSource())
+    {
+        p_element->GetFluidSource()->SetStrength(0.0);
+    }
+
+    mNumDeletedElements++;
+    mNodeArraysAreStale = true;
+    mTopologyChanges.RecordDeletedElement();
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-std::vector<Node<SPACE_DIM>*>& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetNodes()
+unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetNumDeletedElements() const
 {
-    return AbstractMesh<ELEMENT_DIM, SPACE_DIM>::mNodes;
+    return mNumDeletedElements;
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-c_vector<double, SPACE_DIM> ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetVectorFromAtoB(const c_vector<double, SPACE_DIM>& rLocation1, const c_vector<double, SPACE_DIM>& rLocation2)
+std::vector<unsigned> ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::ReMesh()
 {
-    // This code currently assumes the grid is precisely [0,1)x[0,1)
-    c_vector<double, SPACE_DIM> vector = rLocation2 - rLocation1;
+    unsigned num_elements = mElements.size();
+    std::vector<unsigned> new_element_indices(num_elements, UINT_MAX);
+
+    // Remove the deleted elements and their fluid sources, keeping the remaining elements in order
+    std::set<FluidSource<SPACE_DIM>*> removed_sources;
+    unsigned num_kept = 0;
+    for (unsigned elem_idx = 0; elem_idx < num_elements; elem_idx++)
+    {
+        ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>* p_element = mElements[elem_idx];
+        if (p_element->IsDeleted())
+        {
+            if (p_element->GetFluidSource())
+            {
+                removed_sources.insert(p_element->GetFluidSource());
+            }
+            if (mElementPool.Owns(p_element))
+            {
+                mElementPool.Release(p_element);
+            }
+            else
+            {
+                delete p_element;
+            }
+        }
+        else
+        {
+            /*
+             * Each new index is no greater than the old one, and the elements are renumbered in increasing order, so no
+             * element is ever given the index that another element still has.
+             */
+            new_element_indices[elem_idx] = num_kept;
+            mElements[num_kept] = p_element;
+            p_element->ResetIndex(num_kept);
+            num_kept++;
+        }
+    }
+    mElements.resize(num_kept);
 
     /*
-     * Handle the periodic condition here: if the points are more
-     * than 0.5 apart in any direction, choose -(1.0-dist).
+     * Remove their fluid sources, and renumber the remaining element sources to follow their elements.  The registry
+     * holds pointers to the sources, so they are detached first; it is re-registered when next requested.
      */
-    for (unsigned dim = 0; dim < SPACE_DIM; dim++)
+    mFluidSourceRegistry.DetachSources();
+    num_kept = 0;
+    for (unsigned source_idx = 0; source_idx < mElementFluidSources.size(); source_idx++)
     {
-        if (fabs(vector[dim]) > 0.5)
+        FluidSource<SPACE_DIM>* p_source = mElementFluidSources[source_idx];
+        if (removed_sources.count(p_source) > 0)
         {
-            vector[dim] = copysign(fabs(vector[dim]) - 1.0, -vector[dim]);
+            delete p_source;
+        }
+        else
+        {
+            mElementFluidSources[num_kept] = p_source;
+            p_source->SetIndex(num_kept);
+            if (p_source->GetAssociatedElementIndex() < num_elements)
+            {
+                p_source->SetAssociatedElementIndex(new_element_indices[p_source->GetAssociatedElementIndex()]);
+            }
+            num_kept++;
         }
     }
+    mElementFluidSources.resize(num_kept);
 
-    return vector;
-}
+    // Remove the deleted nodes, which belong to no element now, and keep the remaining nodes in order
+    std::vector<Node<SPACE_DIM>*> removed_nodes;
+    std::vector<unsigned> new_node_indices(this->mNodes.size(), UINT_MAX);
+    for (unsigned node_idx = 0; node_idx < this->mNodes.size(); node_idx++)
+    {
+        if (this->mNodes[node_idx]->IsDeleted())
+        {
+            removed_nodes.push_back(this->mNodes[node_idx]);
+        }
+        else
+        {
+            new_node_indices[node_idx] = node_idx - removed_nodes.size();
+        }
+    }
+    RemoveNodes(removed_nodes);
 
-template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::SetNode(unsigned nodeIndex, ChastePoint<SPACE_DIM> point)
-{
-    this->mNodes[nodeIndex]->SetPoint(point);
-}
+    if (mMembraneIndex != UINT_MAX)
+    {
+        mMembraneIndex = new_element_indices[mMembraneIndex];
+    }
 
-template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetNumNodes() const
-{
-    return this->mNodes.size();
-}
+    if (mNumDeletedElements > 0)
+    {
+        mNumReMeshes++;
+        mTopologyChanges.RecordRenumbering(new_node_indices, new_element_indices);
+    }
+    mNumDeletedElements = 0;
 
-template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetNumElements() const
-{
-    return mElements.size();
+    mNodeArraysAreStale = true;
+    mFluidSourceRegistryIsStale = true;
+    mElementGeometriesAreStale = true;
+
+    return new_element_indices;
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetNumAllElements() const
+unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetNumReMeshes() const
 {
-    return mElements.size();
+    return mNumReMeshes;
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>* ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetElement(unsigned index) const
+ImmersedBoundaryTopologyChanges& ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::rGetTopologyChanges()
 {
-    assert(index < mElements.size());
-    return mElements[index];
+    return mTopologyChanges;
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-c_vector<double, SPACE_DIM> ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetCentroidOfElement(unsigned index)
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::RedistributeElementNodes(unsigned index,
+                                                                           unsigned numNodes,
+                                                                           std::vector<Node<SPACE_DIM>*>& rRemovedNodes)
 {
-    // Only implemented in 2D
-    assert(SPACE_DIM == 2);
+    ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>* p_element = mElements[index];
+    unsigned old_num_nodes = p_element->GetNumNodes();
 
-    ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>* p_element = GetElement(index);
+    // The first node and any corner nodes of the element are anchors, which stay where they are
+    std::vector<unsigned> anchors(1, 0u);
+    std::vector<Node<SPACE_DIM>*>& r_corners = p_element->rGetCornerNodes();
+    for (unsigned corner = 0; corner < r_corners.size(); corner++)
+    {
+        for (unsigned node_idx = 1; node_idx < old_num_nodes; node_idx++)
+        {
+            if (p_element->GetNode(node_idx) == r_corners[corner])
+            {
+                anchors.push_back(node_idx);
+                break;
+            }
+        }
+    }
+    std::sort(anchors.begin(), anchors.end());
+    anchors.erase(std::unique(anchors.begin(), anchors.end()), anchors.end());
 
-    // The membrane must be treated differently
-    if (index == mMembraneIndex)
+    unsigned num_anchors = anchors.size();
+    if (numNodes < 3 || numNodes < num_anchors)
     {
-        return zero_vector<double>(2);
+        EXCEPTION("Cannot remesh element " << index << " with " << numNodes << " nodes");
     }
 
-    else
+    // Record the original nodes, since some are about to be moved
+    std::vector<c_vector<double, SPACE_DIM> > old_locations(old_num_nodes);
+    std::vector<unsigned> old_regions(old_num_nodes);
+    std::vector<std::vector<double> > old_attributes(old_num_nodes);
+    std::vector<double> cumulative_distances(old_num_nodes + 1, 0.0);
+    for (unsigned node_idx = 0; node_idx < old_num_nodes; node_idx++)
+    {
+        Node<SPACE_DIM>* p_node = p_element->GetNode(node_idx);
+        old_locations[node_idx] = p_node->rGetLocation();
+        old_regions[node_idx] = p_node->GetRegion();
+        if (p_node->GetNumNodeAttributes() > 0)
+        {
+            old_attributes[node_idx] = p_node->rGetNodeAttributes();
+        }
+    }
+    for (unsigned node_idx = 0; node_idx < old_num_nodes; node_idx++)
+    {
+        cumulative_distances[node_idx + 1] = cumulative_distances[node_idx] +
+            norm_2(this->GetVectorFromAtoB(old_locations[node_idx], old_locations[(node_idx + 1) % old_num_nodes]));
+    }
+
+    // Share the segments between the arcs separating the anchors, each time giving one to the arc whose are longest
+    anchors.push_back(old_num_nodes);
+    std::vector<double> arc_lengths(num_anchors);
+    for (unsigned arc = 0; arc < num_anchors; arc++)
+    {
+        arc_lengths[arc] = cumulative_distances[anchors[arc + 1]] - cumulative_distances[anchors[arc]];
+    }
+
+    std::vector<unsigned> num_segments(num_anchors, 1u);
+    for (unsigned num_allocated = num_anchors; num_allocated < numNodes; num_allocated++)
+    {
+        unsigned longest = 0;
+        for (unsigned arc = 1; arc < num_anchors; arc++)
+        {
+            if (arc_lengths[arc] * num_segments[longest] > arc_lengths[longest] * num_segments[arc])
+            {
+                longest = arc;
+            }
+        }
+        num_segments[longest]++;
+    }
+
+    // Place the nodes along each arc, reusing the original non-anchor nodes in order before creating new ones
+    std::vector<Node<SPACE_DIM>*> new_nodes;
+    new_nodes.reserve(numNodes);
+    unsigned next_old_idx = 1;
+    for (unsigned arc = 0; arc < num_anchors; arc++)
     {
-        unsigned num_nodes = p_element->GetNumNodes();
-        c_vector<double, SPACE_DIM> centroid = zero_vector<double>(SPACE_DIM);
+        new_nodes.push_back(p_element->GetNode(anchors[arc]));
+
+        unsigned segment = anchors[arc];
+        double target_spacing = arc_lengths[arc] / (double)num_segments[arc];
+        for (unsigned arc_node = 1; arc_node < num_segments[arc]; arc_node++)
+        {
+            double location_along_arc = cumulative_distances[anchors[arc]] + (double)arc_node * target_spacing;
+            while (segment + 1 < anchors[arc + 1] && location_along_arc > cumulative_distances[segment + 1])
+            {
+                segment++;
+            }
+
+            double segment_length = cumulative_distances[segment + 1] - cumulative_distances[segment];
+            double interpolant = segment_length > 0.0 ? (location_along_arc - cumulative_distances[segment]) / segment_length : 0.0;
+
+            c_vector<double, SPACE_DIM> this_to_next = this->GetVectorFromAtoB(old_locations[segment],
+                                                                               old_locations[(segment + 1) % old_num_nodes]);
+            c_vector<double, SPACE_DIM> new_location = old_locations[segment] + interpolant * this_to_next;
+
+            // Account for the periodic boundary
+            for (unsigned dim = 0; dim < SPACE_DIM; dim++)
+            {
+                new_location[dim] = fmod(new_location[dim] + mPeriods[dim], mPeriods[dim]);
+            }
+
+            // Skip past any anchors among the original nodes, as these are already placed
+            while (next_old_idx < old_num_nodes && std::binary_search(anchors.begin(), anchors.end() - 1, next_old_idx))
+            {
+                next_old_idx++;
+            }
 
-        double centroid_x = 0;
-        double centroid_y = 0;
+            Node<SPACE_DIM>* p_node;
+            if (next_old_idx < old_num_nodes)
+            {
+                p_node = p_element->GetNode(next_old_idx++);
+                p_node->rGetModifiableLocation() = new_location;
+            }
+            else
+            {
+                p_node = mNodePool.Create(this->mNodes.size(), new_location, true);
+                this->mNodes.push_back(p_node);
+            }
 
-        // Note that we cannot use GetVolumeOfElement() below as it returns the absolute, rather than signed, area
-        double element_signed_area = 0.0;
+            p_node->SetRegion(old_regions[segment]);
+            const std::vector<double>& r_attributes = old_attributes[segment];
+            for (unsigned attribute = 0; attribute < r_attributes.size(); attribute++)
+            {
+                if (attribute < p_node->GetNumNodeAttributes())
+                {
+                    p_node->rGetNodeAttributes()[attribute] = r_attributes[attribute];
+                }
+                else
+                {
+                    p_node->AddNodeAttribute(r_attributes[attribute]);
+                }
+            }
 
-        // Map the first vertex to the origin and employ GetVectorFromAtoB() to allow for periodicity
-        c_vector<double, SPACE_DIM> first_node_location = p_element->GetNodeLocation(0);
-        c_vector<double, SPACE_DIM> pos_1 = zero_vector<double>(SPACE_DIM);
+            new_nodes.push_back(p_node);
+        }
+    }
 
-        // Loop over vertices
-        for (unsigned local_index = 0; local_index < num_nodes; local_index++)
+    // Any original nodes not reused are no longer needed
+    for (; next_old_idx < old_num_nodes; next_old_idx++)
+    {
+        if (!std::binary_search(anchors.begin(), anchors.end() - 1, next_old_idx))
         {
-            c_vector<double, SPACE_DIM> next_node_location = p_element->GetNodeLocation((local_index + 1) % num_nodes);
-            c_vector<double, SPACE_DIM> pos_2 = GetVectorFromAtoB(first_node_location, next_node_location);
+            rRemovedNodes.push_back(p_element->GetNode(next_old_idx));
+        }
+    }
+
+    assert(new_nodes.size() == numNodes);
+    p_element->ReplaceNodes(new_nodes);
 
-            double this_x = pos_1[0];
-            double this_y = pos_1[1];
-            double next_x = pos_2[0];
-            double next_y = pos_2[1];
+    if (index < mElementGeometryIsStale.size())
+    {
+        mElementGeometryIsStale[index] = true;
+    }
+}
 
-            double signed_area_term = this_x * next_y - this_y * next_x;
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::RemoveNodes(const std::vector<Node<SPACE_DIM>*>& rRemovedNodes)
+{
+    if (rRemovedNodes.empty())
+    {
+        return;
+    }
 
-            centroid_x += (this_x + next_x) * signed_area_term;
-            centroid_y += (this_y + next_y) * signed_area_term;
-            element_signed_area += 0.5 * signed_area_term;
+    std::vector<bool> is_removed(this->mNodes.size(), false);
+    for (unsigned removed_idx = 0; removed_idx < rRemovedNodes.size(); removed_idx++)
+    {
+        assert(rRemovedNodes[removed_idx]->GetNumContainingElements() == 0);
+        is_removed[rRemovedNodes[removed_idx]->GetIndex()] = true;
 
-            pos_1 = pos_2;
+        if (mNodePool.Owns(rRemovedNodes[removed_idx]))
+        {
+            mNodePool.Release(rRemovedNodes[removed_idx]);
+        }
+        else
+        {
+            delete rRemovedNodes[removed_idx];
         }
+    }
 
-        assert(element_signed_area != 0.0);
+    unsigned num_kept = 0;
+    for (unsigned node_idx = 0; node_idx < this->mNodes.size(); node_idx++)
+    {
+        if (!is_removed[node_idx])
+        {
+            this->mNodes[num_kept] = this->mNodes[node_idx];
+            this->mNodes[num_kept]->SetIndex(num_kept);
+            num_kept++;
+        }
+    }
+    this->mNodes.resize(num_kept);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::RemeshElement(unsigned index, unsigned numNodes)
+{
+    assert(index < mElements.size());
+
+    std::vector<Node<SPACE_DIM>*> removed_nodes;
+    RedistributeElementNodes(index, numNodes == 0 ? mElements[index]->GetNumNodes() : numNodes, removed_nodes);
+    RemoveNodes(removed_nodes);
+
+    mNodeArraysAreStale = true;
+    mTopologyChanges.MarkIncomplete();
+    this->GetAverageNodeSpacingOfElement(index, true);
+}
 
-        // Finally, map back and employ GetVectorFromAtoB() to allow for periodicity
-        centroid = first_node_location;
-        centroid[0] += centroid_x / (6.0 * element_signed_area);
-        centroid[1] += centroid_y / (6.0 * element_signed_area);
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::RemeshElements(double targetNodeSpacing)
+{
+    std::vector<Node<SPACE_DIM>*> removed_nodes;
+    for (unsigned elem_idx = 0; elem_idx < mElements.size(); elem_idx++)
+    {
+        if (mElements[elem_idx]->IsDeleted())
+        {
+            continue;
+        }
 
-        centroid[0] = centroid[0] < 0 ? centroid[0] + 1.0 : fmod(centroid[0], 1.0);
-        centroid[1] = centroid[1] < 0 ? centroid[1] + 1.0 : fmod(centroid[1], 1.0);
+        unsigned num_nodes = mElements[elem_idx]->GetNumNodes();
+        if (targetNodeSpacing > 0.0 && elem_idx != mMembraneIndex)
+        {
+            double num_segments = floor(this->GetSurfaceAreaOfElement(elem_idx) / targetNodeSpacing + 0.5);
+            num_nodes = std::max(3u, (unsigned)num_segments);
+        }
+        RedistributeElementNodes(elem_idx, num_nodes, removed_nodes);
+    }
+    RemoveNodes(removed_nodes);
 
-        return centroid;
+    mNodeArraysAreStale = true;
+    mTopologyChanges.MarkIncomplete();
+    for (unsigned elem_idx = 0; elem_idx < mElements.size(); elem_idx++)
+    {
+        if (!mElements[elem_idx]->IsDeleted())
+        {
+            this->GetAverageNodeSpacingOfElement(elem_idx, true);
+        }
     }
 }
 
@@ -774,6 +1673,10 @@ void ImmersedBoundaryMesh<2,2>::ConstructFromMeshReader(AbstractMeshReader<2,2>&
     ImmersedBoundaryMeshReader<2,2>& rIBMeshReader = dynamic_cast<ImmersedBoundaryMeshReader<2,2>&>(rMeshReader);
 
     assert(rIBMeshReader.HasNodePermutation() == false);
+    mNodeArraysAreStale = true;
+    mFluidSourceRegistryIsStale = true;
+    mElementGeometriesAreStale = true;
+
     // Store numbers of nodes and elements
     unsigned num_nodes = rIBMeshReader.GetNumNodes();
     unsigned num_elements = rIBMeshReader.GetNumElements();
@@ -782,6 +1685,13 @@ void ImmersedBoundaryMesh<2,2>::ConstructFromMeshReader(AbstractMeshReader<2,2>&
     // Reserve memory for nodes
     this->mNodes.reserve(num_nodes);
 
+    // Data held in memory by the reader are used directly, without going through the GetNext methods
+    if (rIBMeshReader.AreDataInMemory())
+    {
+        ConstructFromMeshReaderData(rIBMeshReader);
+        return;
+    }
+
     rIBMeshReader.Reset();
 
     // Add nodes
@@ -790,8 +1700,15 @@ void ImmersedBoundaryMesh<2,2>::ConstructFromMeshReader(AbstractMeshReader<2,2>&
     {
         node_data = rIBMeshReader.GetNextNode();
         unsigned is_boundary_node = (bool) node_data[2];
-        node_data.pop_back();
-        this->mNodes.push_back(new Node<2>(i, node_data, is_boundary_node));
+        std::vector<double> location(node_data.begin(), node_data.begin() + 2);
+        Node<2>* p_node = new Node<2>(i, location, is_boundary_node);
+
+        // Any values after the boundary flag are node attributes
+        for (unsigned attribute = 3; attribute < node_data.size(); attribute++)
+        {
+            p_node->AddNodeAttribute(node_data[attribute]);
+        }
+        this->mNodes.push_back(p_node);
     }
 
     rIBMeshReader.Reset();
@@ -841,17 +1758,26 @@ void ImmersedBoundaryMesh<2,2>::ConstructFromMeshReader(AbstractMeshReader<2,2>&
     this->mNumGridPtsY = rIBMeshReader.GetNumGridPtsY();
     m2dVelocityGrids.resize(extents[2][mNumGridPtsX][mNumGridPtsY]);
 
-    // Construct the velocity grids from mesh reader
-    for (unsigned dim = 0; dim < 2; dim++)
+    // A binary mesh file stores the grids in the same layout as m2dVelocityGrids, so they can be copied in one go
+    const double* p_grid_data = rIBMeshReader.GetVelocityGridData();
+    if (p_grid_data)
+    {
+        std::copy(p_grid_data, p_grid_data + m2dVelocityGrids.num_elements(), m2dVelocityGrids.data());
+    }
+    else
     {
-        for (unsigned grid_row = 0; grid_row < mNumGridPtsY; grid_row++)
+        // Construct the velocity grids from mesh reader
+        for (unsigned dim = 0; dim < 2; dim++)
         {
-            std::vector<double> next_row = rIBMeshReader.GetNextGridRow();
-            assert(next_row.size() == mNumGridPtsX);
-
-            for (unsigned i = 0; i < mNumGridPtsX; i++)
+            for (unsigned grid_row = 0; grid_row < mNumGridPtsY; grid_row++)
             {
-                m2dVelocityGrids[dim][i][grid_row] = next_row[i];
+                std::vector<double> next_row = rIBMeshReader.GetNextGridRow();
+                assert(next_row.size() == mNumGridPtsX);
+
+                for (unsigned i = 0; i < mNumGridPtsX; i++)
+                {
+                    m2dVelocityGrids[dim][i][grid_row] = next_row[i];
+                }
             }
         }
     }
@@ -865,59 +1791,86 @@ void ImmersedBoundaryMesh<3,3>::ConstructFromMeshReader(AbstractMeshReader<3,3>&
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-double ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetVolumeOfElement(unsigned index)
+void ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::ConstructFromMeshReaderData(ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>& rMeshReader)
 {
-    assert(SPACE_DIM == 2);
+    assert(rMeshReader.AreDataInMemory());
 
-    // Get pointer to this element
-    ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>* p_element = GetElement(index);
+    unsigned num_nodes = rMeshReader.GetNumNodes();
+    unsigned num_elements = rMeshReader.GetNumElements();
+    unsigned num_node_attributes = rMeshReader.GetNumNodeAttributes();
 
-    double element_volume = 0.0;
+    // Add nodes
+    const double* p_locations = rMeshReader.GetNodeLocationData();
+    const double* p_attributes = rMeshReader.GetNodeAttributeData();
+    const unsigned* p_boundary_flags = rMeshReader.GetBoundaryFlagData();
+    for (unsigned node_idx = 0; node_idx < num_nodes; node_idx++)
+    {
+        c_vector<double, SPACE_DIM> location;
+        std::copy(p_locations + (std::size_t)node_idx * SPACE_DIM, p_locations + (std::size_t)(node_idx + 1) * SPACE_DIM, location.begin());
+        Node<SPACE_DIM>* p_node = new Node<SPACE_DIM>(node_idx, location, p_boundary_flags[node_idx] != 0);
 
-    // We map the first vertex to the origin and employ GetVectorFromAtoB() to allow for periodicity
-    c_vector<double, SPACE_DIM> first_node_location = p_element->GetNodeLocation(0);
-    c_vector<double, SPACE_DIM> pos_1 = zero_vector<double>(SPACE_DIM);
+        for (unsigned attribute = 0; attribute < num_node_attributes; attribute++)
+        {
+            p_node->AddNodeAttribute(p_attributes[(std::size_t)node_idx * num_node_attributes + attribute]);
+        }
+        this->mNodes.push_back(p_node);
+    }
 
-    unsigned num_nodes = p_element->GetNumNodes();
-    for (unsigned local_index=0; local_index<num_nodes; local_index++)
+    // Add elements
+    mElements.reserve(num_elements);
+    const unsigned* p_offsets = rMeshReader.GetElementOffsetData();
+    const unsigned* p_node_indices = rMeshReader.GetElementNodeIndexData();
+    const unsigned* p_element_attributes = rMeshReader.GetElementAttributeData();
+    bool has_element_attributes = rMeshReader.GetNumElementAttributes() > 0;
+
+    std::vector<Node<SPACE_DIM>*> element_nodes;
+    for (unsigned elem_idx = 0; elem_idx < num_elements; elem_idx++)
     {
-        c_vector<double, SPACE_DIM> next_node_location = p_element->GetNodeLocation((local_index+1)%num_nodes);
-        c_vector<double, SPACE_DIM> pos_2 = GetVectorFromAtoB(first_node_location, next_node_location);
-
-        double this_x = pos_1[0];
-        double this_y = pos_1[1];
-        double next_x = pos_2[0];
-        double next_y = pos_2[1];
+        element_nodes.clear();
+        for (unsigned i = p_offsets[elem_idx]; i < p_offsets[elem_idx + 1]; i++)
+        {
+            assert(p_node_indices[i] < this->mNodes.size());
+            element_nodes.push_back(this->mNodes[p_node_indices[i]]);
+        }
 
-        element_volume += 0.5*(this_x*next_y - next_x*this_y);
+        ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>* p_element = new ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>(elem_idx, element_nodes);
+        mElements.push_back(p_element);
 
-        pos_1 = pos_2;
+        if (has_element_attributes)
+        {
+            p_element->SetAttribute(p_element_attributes[elem_idx]);
+        }
     }
 
-    // We take the absolute value just in case the nodes were really oriented clockwise
-    return fabs(element_volume);
+    this->mMembraneIndex = rMeshReader.GetMembraneIndex();
+    this->mMeshHasMembrane = (this->mMembraneIndex != UINT_MAX);
+
+    // The grids are held in the same layout as m2dVelocityGrids, so can be copied in one go
+    this->mNumGridPtsX = rMeshReader.GetNumGridPtsX();
+    this->mNumGridPtsY = rMeshReader.GetNumGridPtsY();
+    m2dVelocityGrids.resize(extents[2][mNumGridPtsX][mNumGridPtsY]);
+
+    const double* p_grid_data = rMeshReader.GetVelocityGridData();
+    if (p_grid_data)
+    {
+        std::copy(p_grid_data, p_grid_data + m2dVelocityGrids.num_elements(), m2dVelocityGrids.data());
+    }
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-double ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetSurfaceAreaOfElement(unsigned index)
+double ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetVolumeOfElement(unsigned index)
 {
     assert(SPACE_DIM == 2);
 
-    // Get pointer to this element
-    ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>* p_element = GetElement(index);
-
-    double surface_area = 0.0;
-    unsigned num_nodes = p_element->GetNumNodes();
-    unsigned this_node_index = p_element->GetNodeGlobalIndex(0);
-    for (unsigned local_index=0; local_index<num_nodes; local_index++)
-    {
-        unsigned next_node_index = p_element->GetNodeGlobalIndex((local_index+1)%num_nodes);
+    return rGetElementGeometry(index).mVolume;
+}
 
-        surface_area += this->GetDistanceBetweenNodes(this_node_index, next_node_index);
-        this_node_index = next_node_index;
-    }
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+double ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::GetSurfaceAreaOfElement(unsigned index)
+{
+    assert(SPACE_DIM == 2);
 
-    return surface_area;
+    return rGetElementGeometry(index).mSurfaceArea;
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
@@ -957,53 +1910,7 @@ c_vector<double, 3> ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::CalculateMomen
 {
     assert(SPACE_DIM == 2);
 
-    // Define helper variables
-    ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>* p_element = GetElement(index);
-    unsigned num_nodes = p_element->GetNumNodes();
-    c_vector<double, 3> moments = zero_vector<double>(3);
-
-    // Since we compute I_xx, I_yy and I_xy about the centroid, we must shift each vertex accordingly
-    c_vector<double, SPACE_DIM> centroid = GetCentroidOfElement(index);
-
-    c_vector<double, SPACE_DIM> this_node_location = p_element->GetNodeLocation(0);
-    c_vector<double, SPACE_DIM> pos_1 = this->GetVectorFromAtoB(centroid, this_node_location);
-
-    for (unsigned local_index=0; local_index<num_nodes; local_index++)
-    {
-        unsigned next_index = (local_index+1)%num_nodes;
-        c_vector<double, SPACE_DIM> next_node_location = p_element->GetNodeLocation(next_index);
-        c_vector<double, SPACE_DIM> pos_2 = this->GetVectorFromAtoB(centroid, next_node_location);
-
-        double signed_area_term = pos_1(0)*pos_2(1) - pos_2(0)*pos_1(1);
-        // Ixx
-        moments(0) += (pos_1(1)*pos_1(1) + pos_1(1)*pos_2(1) + pos_2(1)*pos_2(1) ) * signed_area_term;
-
-        // Iyy
-        moments(1) += (pos_1(0)*pos_1(0) + pos_1(0)*pos_2(0) + pos_2(0)*pos_2(0)) * signed_area_term;
-
-        // Ixy
-        moments(2) += (pos_1(0)*pos_2(1) + 2*pos_1(0)*pos_1(1) + 2*pos_2(0)*pos_2(1) + pos_2(0)*pos_1(1)) * signed_area_term;
-
-        pos_1 = pos_2;
-    }
-
-    moments(0) /= 12;
-    moments(1) /= 12;
-    moments(2) /= 24;
-
-    /*
-     * If the nodes owned by the element were supplied in a clockwise rather
-     * than anticlockwise manner, or if this arose as a result of enforcing
-     * periodicity, then our computed quantities will be the wrong sign, so
-     * we need to fix this.
-     */
-    if (moments(0) < 0.0)
-    {
-        moments(0) = -moments(0);
-        moments(1) = -moments(1);
-        moments(2) = -moments(2);
-    }
-    return moments;
+    return rGetElementGeometry(index).mMoments;
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
@@ -1147,6 +2054,15 @@ unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::DivideElement(ImmersedBou
      *   half the required spacing, and are found by using the locations from the existing element as a stencil.
      */
 
+    // The division changes the nodes and elements, so the node arrays must be rebuilt
+    mNodeArraysAreStale = true;
+    mFluidSourceRegistryIsStale = true;
+
+    // Only this element and the new one change shape; the new element's geometry is calculated when first requested
+    if (pElement->GetIndex() < mElementGeometryIsStale.size())
+    {
+        mElementGeometryIsStale[pElement->GetIndex()] = true;
+    }
     double half_spacing = 0.5 * mElementDivisionSpacing;
 
     // Get unit vectors in the direction of the division axis, and the perpendicular
@@ -1277,7 +2193,8 @@ unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::DivideElement(ImmersedBou
     /*
      * Create location stencils for each of the daughter cells
      */
-    std::vector<c_vector<double, SPACE_DIM> > daughter_a_location_stencil;
+    std::vector<c_vector<double, SPACE_DIM> >& daughter_a_location_stencil = mDivisionStencilA;
+    daughter_a_location_stencil.clear();
     for (unsigned node_idx = start_a; node_idx != (end_a + 1) % num_nodes; )
     {
         daughter_a_location_stencil.push_back(c_vector<double, SPACE_DIM>(pElement->GetNode(node_idx)->rGetLocation()));
@@ -1286,7 +2203,8 @@ unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::DivideElement(ImmersedBou
         node_idx = (node_idx + 1) % num_nodes;
     }
 
-    std::vector<c_vector<double, SPACE_DIM> > daughter_b_location_stencil;
+    std::vector<c_vector<double, SPACE_DIM> >& daughter_b_location_stencil = mDivisionStencilB;
+    daughter_b_location_stencil.clear();
     for (unsigned node_idx = start_b; node_idx != (end_b + 1) % num_nodes; )
     {
         daughter_b_location_stencil.push_back(c_vector<double, SPACE_DIM>(pElement->GetNode(node_idx)->rGetLocation()));
@@ -1303,8 +2221,10 @@ unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::DivideElement(ImmersedBou
     daughter_b_location_stencil.push_back(daughter_b_location_stencil[0]);
 
     // Calculate the cumulative distances around the stencils
-    std::vector<double> cumulative_distances_a;
-    std::vector<double> cumulative_distances_b;
+    std::vector<double>& cumulative_distances_a = mDivisionDistancesA;
+    std::vector<double>& cumulative_distances_b = mDivisionDistancesB;
+    cumulative_distances_a.clear();
+    cumulative_distances_b.clear();
     cumulative_distances_a.push_back(0.0);
     cumulative_distances_b.push_back(0.0);
     for (unsigned loc_idx = 1; loc_idx < daughter_a_location_stencil.size(); loc_idx++)
@@ -1347,7 +2267,8 @@ unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::DivideElement(ImmersedBou
 
     // Create new nodes at positions around the daughter-B stencil
     last_idx_used = 0;
-    std::vector<Node<SPACE_DIM>*> new_nodes_vec;
+    std::vector<Node<SPACE_DIM>*>& new_nodes_vec = mDivisionNewNodes;
+    new_nodes_vec.clear();
     for (unsigned node_idx = 0; node_idx < num_nodes; node_idx++)
     {
         double location_along_arc = (double)node_idx * target_spacing_b;
@@ -1367,7 +2288,7 @@ unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::DivideElement(ImmersedBou
         c_vector<double, SPACE_DIM> new_location_b = daughter_b_location_stencil[last_idx_used] + interpolant * this_to_next;
 
         unsigned new_node_idx = this->mNodes.size();
-        this->mNodes.push_back(new Node<SPACE_DIM>(new_node_idx, new_location_b, true));
+        this->mNodes.push_back(mNodePool.Create(new_node_idx, new_location_b, true));
         new_nodes_vec.push_back(this->mNodes.back());
     }
 
@@ -1384,9 +2305,13 @@ unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::DivideElement(ImmersedBou
 
     // Create the new element
     unsigned new_elem_idx = this->mElements.size();
-    this->mElements.push_back(new ImmersedBoundaryElement<ELEMENT_DIM,SPACE_DIM>(new_elem_idx, new_nodes_vec));
+    this->mElements.push_back(mElementPool.Create(new_elem_idx, new_nodes_vec));
     this->mElements.back()->RegisterWithNodes();
 
+    // The nodes of the existing element have been moved, and those of the new element created
+    mTopologyChanges.RecordChangedElement(pElement->GetIndex());
+    mTopologyChanges.RecordChangedElement(new_elem_idx);
+
     // Copy any element attributes
     for (unsigned elem_attribute = 0; elem_attribute < pElement->GetNumElementAttributes(); elem_attribute++)
     {
@@ -1413,6 +2338,10 @@ unsigned ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::DivideElement(ImmersedBou
     // Associate source with element
     mElements[new_elem_idx]->SetFluidSource(mElementFluidSources.back());
 
+    // Both daughters have the same number of nodes as the original element, but shorter perimeters
+    this->GetAverageNodeSpacingOfElement(pElement->GetIndex(), true);
+    this->GetAverageNodeSpacingOfElement(new_elem_idx, true);
+
     return new_elem_idx;
 }
 
@@ -55,6 +55,13 @@ class ImmersedBoundaryMeshWriter;
 #include "ImmersedBoundaryMeshWriter.hpp"
 #include "ImmersedBoundaryElement.hpp"
 #include "ImmersedBoundaryArray.hpp"
+#include "ImmersedBoundaryObjectPool.hpp"
+#include "ImmersedBoundaryNodeArrays.hpp"
+#include "ImmersedBoundaryPeriodicGeometry.hpp"
+#include "ImmersedBoundaryPeriodicOverlaps.hpp"
+#include "ImmersedBoundaryFluidSourceRegistry.hpp"
+#include "ImmersedBoundarySpaceFillingCurve.hpp"
+#include "ImmersedBoundaryTopologyChanges.hpp"
 #include "FluidSource.hpp"
 
 /**
@@ -76,6 +83,21 @@ protected:
     /** Number of grid points in y direction */
     unsigned mNumGridPtsY;
 
+    /**
+     * The size of the periodic domain [0, width) x [0, height) in each dimension.  Initialised to the unit square in
+     * the constructors; see SetDomainSize().
+     */
+    c_vector<double, SPACE_DIM> mDomainSize;
+
+    /** Whether the domain is bounded by walls, rather than periodic, in each dimension; see SetWalls(). */
+    std::vector<bool> mHasWalls;
+
+    /**
+     * The period of the domain in each dimension, used for the minimum image convention.  This is the domain size,
+     * except in a direction bounded by walls, where it is twice the domain size so that no vector is wrapped.
+     */
+    c_vector<double, SPACE_DIM> mPeriods;
+
     /** Whether there is a membrane */
     bool mMeshHasMembrane;
 
@@ -94,10 +116,13 @@ protected:
     /** Indices of elements that have been deleted. These indices can be reused when adding new elements. */
     std::vector<unsigned> mDeletedElementIndices;
 
-    /** 2D grid for fluid x velocity */
+    /**
+     * 2D grid for fluid x velocity.  Each velocity component is first touched as a separate slice, split between the
+     * OpenMP threads.
+     */
     multi_array<double, 3> m2dVelocityGrids;
 
-    /** 3D grid for fluid x velocity */
+    /** 3D grid for fluid x velocity, first touched in the same way as #m2dVelocityGrids */
     multi_array<double, 4> m3dVelocityGrids;
 
     /** Vector of pointers to ImmersedBoundaryElements. */
@@ -109,6 +134,135 @@ protected:
     /** Vector of fluid sources used to balance those of the elements. */
     std::vector<FluidSource<SPACE_DIM>*> mBalancingFluidSources;
 
+    /** Structure-of-arrays mirror of the node state, used by the hot loops of a simulation. */
+    ImmersedBoundaryNodeArrays<SPACE_DIM> mNodeArrays;
+
+    /** Whether #mNodeArrays must be rebuilt from the nodes before it is next used. */
+    bool mNodeArraysAreStale;
+
+    /**
+     * Rebuild #mNodeArrays from the current elements and nodes.
+     */
+    void RebuildNodeArrays();
+
+    /**
+     * Recalculate #mPeriods from the domain size and walls, and pass them on to #mNodeArrays.
+     */
+    void UpdatePeriods();
+
+    /** Which elements overlap the periodic boundaries, kept up to date incrementally as nodes wrap around. */
+    ImmersedBoundaryPeriodicOverlaps<SPACE_DIM> mPeriodicOverlaps;
+
+    /** Registry holding the locations and strengths of all fluid sources contiguously. */
+    ImmersedBoundaryFluidSourceRegistry<SPACE_DIM> mFluidSourceRegistry;
+
+    /** Whether #mFluidSourceRegistry must be rebuilt from the fluid sources before it is next used. */
+    bool mFluidSourceRegistryIsStale;
+
+    /** The geometric quantities of an element, calculated together and cached until its nodes move. */
+    struct ElementGeometry
+    {
+        /** The area of the element. */
+        double mVolume;
+
+        /** The perimeter of the element. */
+        double mSurfaceArea;
+
+        /** The centroid of the element, or the origin for the membrane element. */
+        c_vector<double, SPACE_DIM> mCentroid;
+
+        /** The second moments and product moment of area about the centroid, (I_xx, I_yy, I_xy). */
+        c_vector<double, 3> mMoments;
+    };
+
+    /** The cached geometry of each element, indexed by element index. */
+    std::vector<ElementGeometry> mElementGeometries;
+
+    /** Whether each entry of #mElementGeometries must be recalculated before it is next used. */
+    std::vector<bool> mElementGeometryIsStale;
+
+    /**
+     * Whether every entry of #mElementGeometries must be recalculated before any is next used.  This is set whenever
+     * the nodes may all have moved, or the elements have changed.
+     */
+    bool mElementGeometriesAreStale;
+
+    /** The number of times UpdateElementGeometries() has recalculated the geometry of any element. */
+    unsigned mNumElementGeometryUpdates;
+
+    /**
+     * Whether the average node spacing stored in each element is refreshed whenever the element's geometry is
+     * recalculated; see GetAverageNodeSpacingOfElement().
+     *
+     * Initialised to false in the constructor.
+     */
+    bool mRefreshNodeSpacingWithGeometry;
+
+    /** The pool from which nodes created by DivideElement() are allocated.  These nodes are destroyed in Clear(). */
+    ImmersedBoundaryObjectPool<Node<SPACE_DIM> > mNodePool;
+
+    /** The pool from which elements created by DivideElement() are allocated.  These elements are destroyed in Clear(). */
+    ImmersedBoundaryObjectPool<ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM> > mElementPool;
+
+    /** Scratch space for the interleaved locations of an element's nodes in CalculateElementGeometry(). */
+    std::vector<double> mGeometryLocations;
+
+    /** Scratch space for the interleaved locations of an element's nodes relative to a point, in CalculateElementGeometry(). */
+    std::vector<double> mGeometryRelativeLocations;
+
+    /** Scratch space for the interleaved vectors along an element's edges in CalculateElementGeometry(). */
+    std::vector<double> mGeometryEdgeVectors;
+
+    /** Scratch space for the lengths of an element's edges in CalculateElementGeometry(). */
+    std::vector<double> mGeometryEdgeLengths;
+
+    /** Scratch space for the locations around daughter A in DivideElement(), kept to avoid reallocating each call. */
+    std::vector<c_vector<double, SPACE_DIM> > mDivisionStencilA;
+
+    /** Scratch space for the locations around daughter B in DivideElement(), kept to avoid reallocating each call. */
+    std::vector<c_vector<double, SPACE_DIM> > mDivisionStencilB;
+
+    /** Scratch space for the cumulative distances around #mDivisionStencilA in DivideElement(). */
+    std::vector<double> mDivisionDistancesA;
+
+    /** Scratch space for the cumulative distances around #mDivisionStencilB in DivideElement(). */
+    std::vector<double> mDivisionDistancesB;
+
+    /** Scratch space for the nodes of the new element in DivideElement(). */
+    std::vector<Node<SPACE_DIM>*> mDivisionNewNodes;
+
+    /** The number of elements marked as deleted by DeleteElementPriorToReMesh() since ReMesh() was last called. */
+    unsigned mNumDeletedElements;
+
+    /**
+     * The number of times ReMesh() has removed deleted elements and renumbered the nodes and elements.
+     *
+     * Initialised to 0 in the constructor.
+     */
+    unsigned mNumReMeshes;
+
+    /** The changes to the nodes and elements by division, death and ReMesh() since the record was last cleared. */
+    ImmersedBoundaryTopologyChanges mTopologyChanges;
+
+    /**
+     * Calculate the geometric quantities of an element, in two passes over its nodes: one for the area, perimeter and
+     * centroid, and one for the moments about the centroid.  The locations of the nodes are gathered into scratch
+     * space, and the passes use the kernels of ImmersedBoundaryPeriodicGeometry.
+     *
+     * @param index the global index of the element
+     * @param rGeometry filled in with the geometry of the element
+     */
+    void CalculateElementGeometry(unsigned index, ElementGeometry& rGeometry);
+
+    /**
+     * Get the cached geometry of an element, recalculating the geometry of every element first if the nodes may all
+     * have moved, or that of this element alone if only its nodes may have moved.
+     *
+     * @param index the global index of the element
+     * @return the geometry of the element
+     */
+    const ElementGeometry& rGetElementGeometry(unsigned index);
+
     /**
      * Solve node mapping method. This overridden method is required
      * as it is pure virtual in the base class.
@@ -136,6 +290,26 @@ protected:
      */
     unsigned SolveBoundaryElementMapping(unsigned index) const;
 
+    /**
+     * Redistribute the nodes of an element uniformly by arc length around its boundary, as used by RemeshElement().
+     * Nodes no longer needed by the element are not yet removed from the mesh, but are added to rRemovedNodes.
+     *
+     * @param index the global index of the element
+     * @param numNodes the number of nodes the element should have afterwards
+     * @param rRemovedNodes the nodes removed from the element, to which any further such nodes are added
+     */
+    void RedistributeElementNodes(unsigned index,
+                                  unsigned numNodes,
+                                  std::vector<Node<SPACE_DIM>*>& rRemovedNodes);
+
+    /**
+     * Remove nodes, which must belong to no element, from the mesh and renumber those that remain in their existing
+     * order.  Nodes allocated from #mNodePool are destroyed with it in Clear(); any others are deleted now.
+     *
+     * @param rRemovedNodes the nodes to remove
+     */
+    void RemoveNodes(const std::vector<Node<SPACE_DIM>*>& rRemovedNodes);
+
     /**
      * Divide an element along the axis passing through two of its nodes.
      *
@@ -155,6 +329,15 @@ protected:
                            c_vector<double, SPACE_DIM> centroid,
                            c_vector<double, SPACE_DIM> axisOfDivision);
 
+    /**
+     * Fill the node and element storage, and the velocity grids, directly from the arrays of a mesh reader that holds
+     * all its data in memory.  Helper method for ConstructFromMeshReader(), which has already set the characteristic
+     * node spacing and the staleness flags.
+     *
+     * @param rMeshReader the mesh reader, for which AreDataInMemory() must be true
+     */
+    void ConstructFromMeshReaderData(ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>& rMeshReader);
+
     /** Needed for serialization. */
     friend class boost::serialization::access;
 
@@ -219,8 +402,8 @@ public:
      * @param numGridPtsY the number of grid points in the y direction
      * @param the index of the basement membrane element
      */
-    ImmersedBoundaryMesh(std::vector<Node<SPACE_DIM>*> nodes,
-                         std::vector<ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>*> elements,
+    ImmersedBoundaryMesh(const std::vector<Node<SPACE_DIM>*>& nodes,
+                         const std::vector<ImmersedBoundaryElement<ELEMENT_DIM, SPACE_DIM>*>& elements,
                          unsigned numGridPtsX=128,
                          unsigned numGridPtsY=128,
                          unsigned membraneIndex=UINT_MAX);
@@ -266,10 +449,63 @@ public:
     double GetCharacteristicNodeSpacing() const;
 
     /**
-     * @return the spacing ratio: Characteristic Node Spacing / Fluid Grid Spacing
+     * @return the spacing ratio: Characteristic Node Spacing / Fluid Grid Spacing in the x direction
      */
     double GetSpacingRatio() const;
 
+    /**
+     * Set the size of the periodic domain, in place of the unit square.  Node locations, and the fluid grid, lie in
+     * [0, width) x [0, height), so the grid spacings are width / GetNumGridPtsX() and height / GetNumGridPtsY().  This
+     * must be called before any nodes are moved, and before the simulation is set up.
+     *
+     * @param width the size of the domain in the x direction
+     * @param height the size of the domain in the y direction
+     */
+    void SetDomainSize(double width, double height);
+
+    /**
+     * @return the size of the domain in the x direction
+     */
+    double GetDomainWidth() const;
+
+    /**
+     * @return the size of the domain in the y direction
+     */
+    double GetDomainHeight() const;
+
+    /**
+     * @return #mDomainSize
+     */
+    const c_vector<double, SPACE_DIM>& rGetDomainSize() const;
+
+    /**
+     * Bound the domain by free-slip walls, in place of periodicity, in either or both directions.  Walls normal to x
+     * lie at x = 0 and x = width, and walls normal to y at y = 0 and y = height.  In a direction bounded by walls the
+     * fluid grid points lie half a grid spacing in from the walls, at (i + 1/2) times the grid spacing, the nodes do
+     * not wrap around the domain, and the fluid is solved with real-to-real transforms.  This must be called before
+     * the simulation is set up.
+     *
+     * @param wallsNormalToX whether there are walls at x = 0 and x = width
+     * @param wallsNormalToY whether there are walls at y = 0 and y = height
+     */
+    void SetWalls(bool wallsNormalToX, bool wallsNormalToY);
+
+    /**
+     * @param dim a dimension
+     * @return whether the domain is bounded by walls in that dimension
+     */
+    bool HasWalls(unsigned dim) const;
+
+    /**
+     * @return whether the domain is bounded by walls in any dimension
+     */
+    bool HasWalls() const;
+
+    /**
+     * @return #mPeriods
+     */
+    const c_vector<double, SPACE_DIM>& rGetPeriods() const;
+
     /**
      * Overridden GetVectorFromAtoB() method.
      *
@@ -315,6 +551,180 @@ public:
      */
     std::vector<Node<SPACE_DIM>*>& rGetNodes();
 
+    /**
+     * Get the structure-of-arrays mirror of the node state, rebuilding it first if the mesh has changed.
+     *
+     * The arrays, not the Node objects, hold the authoritative applied forces during a timestep, and forces, spreading
+     * and interpolation operate on them directly.  Node locations are kept in step: SetNode() updates both, and code
+     * that moves nodes through the arrays calls SynchroniseNodeLocations() afterwards.  Anything that changes the
+     * elements, the nodes they contain, or the node attributes by other means must call InvalidateNodeArrays().
+     *
+     * @return reference to the node arrays
+     */
+    ImmersedBoundaryNodeArrays<SPACE_DIM>& rGetNodeArrays();
+
+    /**
+     * Mark the node arrays as out of date, so they are rebuilt from the nodes when next requested.
+     */
+    void InvalidateNodeArrays();
+
+    /**
+     * Get the periodic overlaps of every element, recalculating those of any element with a node that has wrapped
+     * around the domain since they were last requested.
+     *
+     * @return reference to the periodic overlaps
+     */
+    const ImmersedBoundaryPeriodicOverlaps<SPACE_DIM>& rGetPeriodicOverlaps();
+
+    /**
+     * Get the periodic overlaps without updating them, so that code moving nodes through the node arrays can mark
+     * the elements whose nodes wrap around the domain.
+     *
+     * @return reference to the periodic overlaps
+     */
+    ImmersedBoundaryPeriodicOverlaps<SPACE_DIM>& rGetModifiablePeriodicOverlaps();
+
+    /**
+     * Copy the node locations from the node arrays to the Node objects.  This also marks the element geometries as
+     * out of date.
+     */
+    void SynchroniseNodeLocations();
+
+    /**
+     * Recalculate the cached geometry (area, perimeter, centroid and moments) of every element whose nodes may have
+     * moved since it was last calculated.  GetVolumeOfElement(), GetSurfaceAreaOfElement(), GetCentroidOfElement()
+     * and CalculateMomentsOfElement() are served from this cache, and call this method as needed, so the geometry is
+     * calculated in a single pass over the elements each timestep however many of these are called.
+     *
+     * The cache is kept in step with SetNode(), SynchroniseNodeLocations() and any change to the elements made by this
+     * class.  Code that moves nodes by other means, such as Node::SetPoint(), must call InvalidateElementGeometries().
+     */
+    void UpdateElementGeometries();
+
+    /**
+     * Mark the cached geometry of every element as out of date, so it is recalculated when next requested.  This is
+     * also done by InvalidateNodeArrays().
+     */
+    void InvalidateElementGeometries();
+
+    /**
+     * @return #mNumElementGeometryUpdates
+     */
+    unsigned GetNumElementGeometryUpdates() const;
+
+    /**
+     * Set #mRefreshNodeSpacingWithGeometry.
+     *
+     * @param refreshNodeSpacingWithGeometry whether to refresh the average node spacing stored in each element whenever
+     *     its geometry is recalculated
+     */
+    void SetRefreshNodeSpacingWithGeometry(bool refreshNodeSpacingWithGeometry);
+
+    /**
+     * @return #mRefreshNodeSpacingWithGeometry
+     */
+    bool GetRefreshNodeSpacingWithGeometry() const;
+
+    /**
+     * Redistribute the nodes of an element so that they are uniformly spaced by arc length around its boundary,
+     * optionally changing how many there are.  The first node of the element and any of its corner nodes (see
+     * ImmersedBoundaryElement::rGetCornerNodes()) stay where they are, and the remaining nodes are shared between the
+     * arcs separating these in proportion to their lengths.  Each node created or moved takes the region and node
+     * attributes of the original node at the start of the boundary segment it is placed on.
+     *
+     * Nodes added are appended to the mesh, and nodes removed cause the remaining nodes to be renumbered, so any node
+     * neighbour lists must be recalculated afterwards.
+     *
+     * @param index the global index of the element
+     * @param numNodes the number of nodes the element should have afterwards, or zero to keep the current number
+     *     (defaults to zero)
+     */
+    void RemeshElement(unsigned index, unsigned numNodes=0);
+
+    /**
+     * Redistribute the nodes of every element, as in RemeshElement().  Each element other than the membrane is given
+     * the number of nodes which best achieves the target node spacing, while the membrane keeps its current number.
+     *
+     * @param targetNodeSpacing the target node spacing, or zero to keep the current number of nodes in every element
+     *     (defaults to zero)
+     */
+    void RemeshElements(double targetNodeSpacing=0.0);
+
+    /**
+     * Mark an element and its nodes as deleted, for instance when its cell dies.  They stay in the mesh, and are
+     * skipped by element iterators and the node arrays, until ReMesh() is called.  The element's fluid source is
+     * given zero strength.
+     *
+     * @param index the global index of the element
+     */
+    void DeleteElementPriorToReMesh(unsigned index);
+
+    /**
+     * @return #mNumDeletedElements
+     */
+    unsigned GetNumDeletedElements() const;
+
+    /**
+     * Remove the elements and nodes marked as deleted, together with the fluid sources of those elements, and
+     * renumber the remaining nodes, elements and element fluid sources densely in their existing order.  The
+     * containing element indices of each node, the membrane index and the fluid source associations are all updated.
+     *
+     * As with ReorderAlongSpaceFillingCurve(), any mapping from element indices held elsewhere must be updated by the
+     * caller using the returned map, and any node neighbour lists must be recalculated.
+     *
+     * @return the new index of each element, indexed by its old index, or UINT_MAX for each element removed
+     */
+    std::vector<unsigned> ReMesh();
+
+    /**
+     * @return #mNumReMeshes
+     */
+    unsigned GetNumReMeshes() const;
+
+    /**
+     * Get the record of the changes to the nodes and elements by division, death and ReMesh(), so that node neighbour
+     * lists may be updated rather than recalculated.  Renumbering along a space filling curve, remeshing elements
+     * and Clear() make the record incomplete.  The record is cleared by whoever brings its neighbour lists up to
+     * date, such as ImmersedBoundarySimulationModifier.
+     *
+     * @return #mTopologyChanges
+     */
+    ImmersedBoundaryTopologyChanges& rGetTopologyChanges();
+
+    /**
+     * Reserve storage for the nodes, elements and fluid sources created by a number of future calls to
+     * DivideElement(), so that the mesh's containers and object pools need not grow during the simulation.  Each
+     * division is assumed to create as many nodes as the current average number per element.
+     *
+     * @param numDivisions the expected number of divisions
+     */
+    void ReserveForDivisions(unsigned numDivisions);
+
+    /**
+     * Copy the applied forces from the node arrays to the Node objects, for instance so they can be written out.
+     */
+    void SynchroniseNodeAppliedForces();
+
+    /**
+     * Add the applied force held by each Node object to the node arrays.  This supports forces that add their
+     * contributions through Node::AddAppliedForceContribution().
+     */
+    void AddNodeAppliedForcesToNodeArrays();
+
+    /**
+     * Renumber the nodes, and then the elements, in order along a space filling curve, so that nodes and elements
+     * close in space are close in memory.  Nodes are ordered by location and elements by centroid.  The Node and
+     * element objects themselves are unchanged: each element keeps its nodes in the same order, and the containing
+     * element indices of each node, the membrane index and the fluid source associations are all updated.
+     *
+     * Any mapping from element indices held elsewhere, such as a cell population's cell-to-location map, must be
+     * updated by the caller using the returned permutation.
+     *
+     * @param rCurve the space filling curve to order along
+     * @return the new index of each element, indexed by its old index
+     */
+    std::vector<unsigned> ReorderAlongSpaceFillingCurve(const ImmersedBoundarySpaceFillingCurve& rCurve);
+
     /**
      * @param the new number of fluid mesh points in the x direction.
      */
@@ -360,6 +770,14 @@ public:
      */
     std::vector<FluidSource<SPACE_DIM>*>& rGetBalancingFluidSources();
 
+    /**
+     * Get the registry of fluid sources, rebuilding it first if sources have been added.  Element sources occupy the
+     * first slots of the registry, followed by the balancing sources.
+     *
+     * @return reference to the fluid source registry
+     */
+    ImmersedBoundaryFluidSourceRegistry<SPACE_DIM>& rGetFluidSourceRegistry();
+
     /**
      * @param index  the global index of a specified immersed boundary element.
      *
@@ -419,11 +837,16 @@ public:
     virtual double GetSurfaceAreaOfElement(unsigned index);
 
     /**
-     * Compute the average node spacing of an element.
+     * Compute the average node spacing of an element, the perimeter divided by the number of nodes.
+     *
+     * The spacing stored in the element is returned unless recalculate is true or it is unset, in which case it is first
+     * refreshed from the (cached) perimeter.  It is also refreshed for both daughters when an element divides, and,
+     * if #mRefreshNodeSpacingWithGeometry is set, whenever the element's geometry is recalculated.  Otherwise a
+     * spacing requested without recalculation is the one last refreshed, and does not follow the nodes as they move.
      *
      * @param index  the global index of a specified immersed boundary element
      * @param recalculate whether or not to recalculate the value
-     * @return the surface area of the element
+     * @return the average node spacing of the element
      */
     double GetAverageNodeSpacingOfElement(unsigned index, bool recalculate=true);
 
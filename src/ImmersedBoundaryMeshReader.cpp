@@ -37,19 +37,660 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Exception.hpp"
 
 #include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * Read a whole file into a buffer, followed by a null character.
+ *
+ * @param rFileName the name of the file
+ * @param rBuffer the buffer to fill
+ */
+static void ReadWholeFile(const std::string& rFileName, std::vector<char>& rBuffer)
+{
+    std::ifstream file(rFileName.c_str(), std::ios::binary);
+    if (!file.is_open())
+    {
+        EXCEPTION("Could not open data file: " + rFileName);
+    }
+
+    file.seekg(0, std::ios::end);
+    std::streamoff file_size = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    rBuffer.resize((std::size_t)file_size + 1);
+    if (file_size > 0)
+    {
+        file.read(&rBuffer[0], file_size);
+    }
+    if (!file)
+    {
+        EXCEPTION("Could not read data file: " + rFileName);
+    }
+    rBuffer[(std::size_t)file_size] = '\0';
+}
+
+/**
+ * Find the data lines of a file held in memory, skipping comments and blank lines as GetNextLineFromStream() does.
+ * Each line is terminated in place by a null character, overwriting its newline or the start of its comment, so
+ * that numbers are parsed only from within the line.
+ *
+ * @param rBuffer the file, followed by a null character
+ * @param rLineStarts filled with the start of each data line
+ */
+static void FindDataLines(std::vector<char>& rBuffer, std::vector<const char*>& rLineStarts)
+{
+    rLineStarts.clear();
+
+    char* p_char = &rBuffer[0];
+    char* p_end = p_char + rBuffer.size() - 1;
+    while (p_char < p_end)
+    {
+        char* p_line = p_char;
+        char* p_newline = static_cast<char*>(memchr(p_line, '\n', p_end - p_line));
+        char* p_line_end = p_newline ? p_newline : p_end;
+        p_char = p_newline ? p_newline + 1 : p_end;
+
+        // Get rid of any comment
+        char* p_comment = static_cast<char*>(memchr(p_line, '#', p_line_end - p_line));
+        if (p_comment)
+        {
+            p_line_end = p_comment;
+        }
+        *p_line_end = '\0';
+
+        for (const char* p_test = p_line; p_test < p_line_end; p_test++)
+        {
+            if (*p_test != ' ' && *p_test != '\t' && *p_test != '\r')
+            {
+                rLineStarts.push_back(p_line);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * Parse an unsigned integer from a null-terminated line, skipping any leading spaces.
+ *
+ * @param rpChar the position in the line, advanced past the number
+ * @param rValue set to the number
+ * @return whether a number was found
+ */
+static bool ParseUnsigned(const char*& rpChar, unsigned& rValue)
+{
+    while (*rpChar == ' ' || *rpChar == '\t' || *rpChar == '\r')
+    {
+        rpChar++;
+    }
+    if (*rpChar < '0' || *rpChar > '9')
+    {
+        return false;
+    }
+
+    unsigned value = 0;
+    while (*rpChar >= '0' && *rpChar <= '9')
+    {
+        value = 10 * value + (unsigned)(*rpChar - '0');
+        rpChar++;
+    }
+    rValue = value;
+    return true;
+}
+
+/**
+ * Parse a double from a null-terminated line, skipping any leading spaces.  Since the line is null-terminated, this
+ * never reads into the next line.
+ *
+ * @param rpChar the position in the line, advanced past the number
+ * @param rValue set to the number
+ * @return whether a number was found
+ */
+static bool ParseDouble(const char*& rpChar, double& rValue)
+{
+    char* p_number_end;
+    rValue = strtod(rpChar, &p_number_end);
+    if (p_number_end == rpChar)
+    {
+        return false;
+    }
+    rpChar = p_number_end;
+    return true;
+}
+
+/**
+ * Record a line that could not be parsed, keeping the first such line.
+ *
+ * @param rFirstBadLine the first line that could not be parsed so far, or UINT_MAX if none
+ * @param line the line that could not be parsed
+ */
+static void RecordBadLine(unsigned& rFirstBadLine, unsigned line)
+{
+#ifdef _OPENMP
+    #pragma omp critical(IBMeshReaderBadLine)
+#endif
+    {
+        if (line < rFirstBadLine)
+        {
+            rFirstBadLine = line;
+        }
+    }
+}
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::ImmersedBoundaryMeshReader(std::string pathBaseName)
+ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::ImmersedBoundaryMeshReader(std::string pathBaseName, bool readBinary)
     : mFilesBaseName(pathBaseName),
       mIndexFromZero(false), // initially assume that nodes are not numbered from zero
       mNumNodes(0),
       mNumElements(0),
       mNodesRead(0),
       mElementsRead(0),
-      mNumElementAttributes(0)
+      mNumNodeAttributes(0),
+      mNumElementAttributes(0),
+      mpBinaryData(NULL),
+      mBinaryDataSize(0),
+      mpNodeLocationData(NULL),
+      mpNodeAttributeData(NULL),
+      mpVelocityGridData(NULL),
+      mpBoundaryFlagData(NULL),
+      mpElementOffsetData(NULL),
+      mpElementNodeIndexData(NULL),
+      mpElementAttributeData(NULL),
+      mMembraneIndex(UINT_MAX),
+      mTextFilesAreParsed(false),
+      mGridRowsRead(0)
+{
+    if (readBinary)
+    {
+        OpenBinaryFile();
+    }
+    else
+    {
+        OpenFiles();
+        ReadHeaders();
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::~ImmersedBoundaryMeshReader()
+{
+    CloseBinaryFile();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::IsBinary() const
+{
+    return mpBinaryData != NULL;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::GetNumNodeAttributes() const
+{
+    return mNumNodeAttributes;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::AreDataInMemory() const
+{
+    return IsBinary() || mTextFilesAreParsed;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const double* ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::GetVelocityGridData() const
+{
+    return AreDataInMemory() ? mpVelocityGridData : NULL;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const double* ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::GetNodeLocationData() const
+{
+    return AreDataInMemory() ? mpNodeLocationData : NULL;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const double* ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::GetNodeAttributeData() const
+{
+    return AreDataInMemory() ? mpNodeAttributeData : NULL;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const unsigned* ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::GetBoundaryFlagData() const
+{
+    return AreDataInMemory() ? mpBoundaryFlagData : NULL;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const unsigned* ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::GetElementOffsetData() const
+{
+    return AreDataInMemory() ? mpElementOffsetData : NULL;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const unsigned* ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::GetElementNodeIndexData() const
+{
+    return AreDataInMemory() ? mpElementNodeIndexData : NULL;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const unsigned* ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::GetElementAttributeData() const
+{
+    return AreDataInMemory() ? mpElementAttributeData : NULL;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::GetMembraneIndex() const
+{
+    return mMembraneIndex;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::ParseTextFiles(unsigned numThreads)
+{
+    if (AreDataInMemory())
+    {
+        return;
+    }
+    CloseFiles();
+
+    std::vector<char> buffer;
+    std::vector<const char*> line_starts;
+
+    ReadWholeFile(mFilesBaseName + ".node", buffer);
+    FindDataLines(buffer, line_starts);
+    ParseNodeLines(line_starts, numThreads);
+
+    ReadWholeFile(mFilesBaseName + ".cell", buffer);
+    FindDataLines(buffer, line_starts);
+    ParseElementLines(line_starts, numThreads);
+
+    ReadWholeFile(mFilesBaseName + ".grid", buffer);
+    FindDataLines(buffer, line_starts);
+    ParseGridLines(line_starts, numThreads);
+
+    mpNodeLocationData = mParsedNodeLocations.empty() ? NULL : &mParsedNodeLocations[0];
+    mpNodeAttributeData = mParsedNodeAttributes.empty() ? NULL : &mParsedNodeAttributes[0];
+    mpVelocityGridData = mParsedVelocityGrids.empty() ? NULL : &mParsedVelocityGrids[0];
+    mpBoundaryFlagData = mParsedBoundaryFlags.empty() ? NULL : &mParsedBoundaryFlags[0];
+    mpElementOffsetData = &mParsedElementOffsets[0];
+    mpElementNodeIndexData = mParsedElementNodeIndices.empty() ? NULL : &mParsedElementNodeIndices[0];
+    mpElementAttributeData = mParsedElementAttributes.empty() ? NULL : &mParsedElementAttributes[0];
+
+    // The parsed node indices are numbered from zero, as in a binary mesh file
+    mIndexFromZero = true;
+    mTextFilesAreParsed = true;
+
+    mNodesRead = 0;
+    mElementsRead = 0;
+    mGridRowsRead = 0;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::ParseNodeLines(const std::vector<const char*>& rLineStarts, unsigned numThreads)
+{
+    std::string file_name = mFilesBaseName + ".node";
+
+    // The header gives the numbers of nodes and attributes, and the characteristic node spacing
+    const char* p_char = rLineStarts.empty() ? "" : rLineStarts[0];
+    unsigned local_space_dim;
+    if (!ParseUnsigned(p_char, mNumNodes) || !ParseUnsigned(p_char, local_space_dim) ||
+        !ParseUnsigned(p_char, mNumNodeAttributes) || !ParseDouble(p_char, mCharacteristicNodeSpacing))
+    {
+        EXCEPTION("Could not read the header of node file " + file_name);
+    }
+    if (rLineStarts.size() < (std::size_t)mNumNodes + 1)
+    {
+        EXCEPTION("Node file " + file_name + " has fewer nodes than its header describes");
+    }
+
+    // See if nodes are indexed from zero or not
+    unsigned offset = 0;
+    if (mNumNodes > 0)
+    {
+        p_char = rLineStarts[1];
+        if (!ParseUnsigned(p_char, offset) || offset > 1)
+        {
+            EXCEPTION("Nodes in node file " + file_name + " are not numbered from zero or one");
+        }
+    }
+
+    mParsedNodeLocations.resize((std::size_t)mNumNodes * SPACE_DIM);
+    mParsedNodeAttributes.resize((std::size_t)mNumNodes * mNumNodeAttributes);
+    mParsedBoundaryFlags.resize(mNumNodes);
+
+    unsigned first_bad_line = UINT_MAX;
+    int num_nodes = (int)mNumNodes;
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(numThreads)
+#endif
+    for (int node_idx = 0; node_idx < num_nodes; node_idx++)
+    {
+        const char* p_line = rLineStarts[node_idx + 1];
+        bool line_is_good = true;
+
+        unsigned index;
+        line_is_good = ParseUnsigned(p_line, index) && index == (unsigned)node_idx + offset;
+
+        double* p_location = &mParsedNodeLocations[0] + (std::size_t)node_idx * SPACE_DIM;
+        for (unsigned dim = 0; line_is_good && dim < SPACE_DIM; dim++)
+        {
+            line_is_good = ParseDouble(p_line, p_location[dim]);
+        }
+
+        double boundary_flag = 0.0;
+        line_is_good = line_is_good && ParseDouble(p_line, boundary_flag);
+        mParsedBoundaryFlags[node_idx] = (unsigned)boundary_flag;
+
+        for (unsigned attribute = 0; line_is_good && attribute < mNumNodeAttributes; attribute++)
+        {
+            line_is_good = ParseDouble(p_line, mParsedNodeAttributes[(std::size_t)node_idx * mNumNodeAttributes + attribute]);
+        }
+
+        if (!line_is_good)
+        {
+            RecordBadLine(first_bad_line, (unsigned)node_idx);
+        }
+    }
+
+    if (first_bad_line != UINT_MAX)
+    {
+        EXCEPTION("Data for node " << first_bad_line << " missing");
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::ParseElementLines(const std::vector<const char*>& rLineStarts, unsigned numThreads)
+{
+    std::string file_name = mFilesBaseName + ".cell";
+
+    // The header gives the numbers of elements and attributes
+    const char* p_char = rLineStarts.empty() ? "" : rLineStarts[0];
+    if (!ParseUnsigned(p_char, mNumElements) || !ParseUnsigned(p_char, mNumElementAttributes))
+    {
+        EXCEPTION("Could not read the header of element file " + file_name);
+    }
+    if (rLineStarts.size() < (std::size_t)mNumElements + 1)
+    {
+        EXCEPTION("Element file " + file_name + " has fewer elements than its header describes");
+    }
+    assert(mNumElementAttributes <= 1);
+
+    // Element indices are numbered as node indices are
+    unsigned offset = 0;
+    if (mNumElements > 0)
+    {
+        p_char = rLineStarts[1];
+        if (!ParseUnsigned(p_char, offset) || offset > 1)
+        {
+            EXCEPTION("Elements in element file " + file_name + " are not numbered from zero or one");
+        }
+    }
+
+    unsigned first_bad_line = UINT_MAX;
+    int num_elements = (int)mNumElements;
+
+    // First read the number of nodes in each element, so each element's node indices can be placed directly
+    std::vector<const char*> node_list_starts(mNumElements);
+    mParsedElementOffsets.assign(mNumElements + 1, 0);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(numThreads)
+#endif
+    for (int elem_idx = 0; elem_idx < num_elements; elem_idx++)
+    {
+        const char* p_line = rLineStarts[elem_idx + 1];
+
+        unsigned index;
+        unsigned num_nodes_in_element;
+        if (ParseUnsigned(p_line, index) && index == (unsigned)elem_idx + offset && ParseUnsigned(p_line, num_nodes_in_element))
+        {
+            mParsedElementOffsets[elem_idx + 1] = num_nodes_in_element;
+        }
+        else
+        {
+            RecordBadLine(first_bad_line, (unsigned)elem_idx);
+        }
+        node_list_starts[elem_idx] = p_line;
+    }
+
+    if (first_bad_line != UINT_MAX)
+    {
+        EXCEPTION("Data for element " << first_bad_line << " missing");
+    }
+
+    for (unsigned elem_idx = 0; elem_idx < mNumElements; elem_idx++)
+    {
+        mParsedElementOffsets[elem_idx + 1] += mParsedElementOffsets[elem_idx];
+    }
+
+    mParsedElementNodeIndices.resize(mParsedElementOffsets[mNumElements]);
+    mParsedElementAttributes.assign(mNumElements, 0);
+    std::vector<unsigned char> membrane_flags(mNumElements, 0);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(numThreads)
+#endif
+    for (int elem_idx = 0; elem_idx < num_elements; elem_idx++)
+    {
+        const char* p_line = node_list_starts[elem_idx];
+        bool line_is_good = true;
+
+        for (unsigned i = mParsedElementOffsets[elem_idx]; line_is_good && i < mParsedElementOffsets[elem_idx + 1]; i++)
+        {
+            unsigned node_index;
+            line_is_good = ParseUnsigned(p_line, node_index) && node_index >= offset;
+            mParsedElementNodeIndices[i] = node_index - offset;
+        }
+
+        if (line_is_good && mNumElementAttributes > 0)
+        {
+            line_is_good = ParseUnsigned(p_line, mParsedElementAttributes[elem_idx]);
+        }
+
+        unsigned membrane_flag;
+        line_is_good = line_is_good && ParseUnsigned(p_line, membrane_flag);
+        membrane_flags[elem_idx] = line_is_good && membrane_flag != 0;
+
+        if (!line_is_good)
+        {
+            RecordBadLine(first_bad_line, (unsigned)elem_idx);
+        }
+    }
+
+    if (first_bad_line != UINT_MAX)
+    {
+        EXCEPTION("Data for element " << first_bad_line << " missing");
+    }
+
+    // As when the mesh is constructed a line at a time, the last element flagged as the membrane is used
+    mMembraneIndex = UINT_MAX;
+    for (unsigned elem_idx = 0; elem_idx < mNumElements; elem_idx++)
+    {
+        if (membrane_flags[elem_idx])
+        {
+            mMembraneIndex = elem_idx;
+        }
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::ParseGridLines(const std::vector<const char*>& rLineStarts, unsigned numThreads)
+{
+    std::string file_name = mFilesBaseName + ".grid";
+
+    // The header gives the numbers of grid points
+    const char* p_char = rLineStarts.empty() ? "" : rLineStarts[0];
+    if (!ParseUnsigned(p_char, mNumGridPtsX) || !ParseUnsigned(p_char, mNumGridPtsY))
+    {
+        EXCEPTION("Could not read the header of grid file " + file_name);
+    }
+    if (rLineStarts.size() < 2 * (std::size_t)mNumGridPtsY + 1)
+    {
+        EXCEPTION("Grid file " + file_name + " has fewer rows than its header describes");
+    }
+
+    mParsedVelocityGrids.resize(2 * (std::size_t)mNumGridPtsX * mNumGridPtsY);
+
+    unsigned first_bad_line = UINT_MAX;
+    int num_rows = 2 * (int)mNumGridPtsY;
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(numThreads)
+#endif
+    for (int row = 0; row < num_rows; row++)
+    {
+        const char* p_line = rLineStarts[row + 1];
+        bool line_is_good = true;
+
+        // Rows run over x at fixed y, for the x-velocity grid and then the y-velocity grid
+        unsigned dim = (unsigned)row / mNumGridPtsY;
+        unsigned y_idx = (unsigned)row % mNumGridPtsY;
+        double* p_grid = &mParsedVelocityGrids[0] + (std::size_t)dim * mNumGridPtsX * mNumGridPtsY;
+        for (unsigned x_idx = 0; line_is_good && x_idx < mNumGridPtsX; x_idx++)
+        {
+            line_is_good = ParseDouble(p_line, p_grid[(std::size_t)x_idx * mNumGridPtsY + y_idx]);
+        }
+
+        if (!line_is_good)
+        {
+            RecordBadLine(first_bad_line, (unsigned)row);
+        }
+    }
+
+    if (first_bad_line != UINT_MAX)
+    {
+        EXCEPTION("Data for grid row " << first_bad_line << " missing");
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::OpenBinaryFile()
+{
+    namespace format = ImmersedBoundaryBinaryMeshFormat;
+
+    std::string file_name = mFilesBaseName + ".ibm";
+    int file_descriptor = open(file_name.c_str(), O_RDONLY);
+    if (file_descriptor < 0)
+    {
+        EXCEPTION("Could not open data file: " + file_name);
+    }
+
+    struct stat file_status;
+    if (fstat(file_descriptor, &file_status) != 0 || (std::size_t)file_status.st_size < format::HEADER_SIZE)
+    {
+        close(file_descriptor);
+        EXCEPTION("Binary mesh file " + file_name + " is too short to hold a header");
+    }
+    mBinaryDataSize = file_status.st_size;
+
+    void* p_mapping = mmap(NULL, mBinaryDataSize, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    close(file_descriptor);
+    if (p_mapping == MAP_FAILED)
+    {
+        EXCEPTION("Could not map data file: " + file_name);
+    }
+    mpBinaryData = static_cast<char*>(p_mapping);
+
+    // Check the header
+    if (memcmp(mpBinaryData, format::MAGIC, sizeof(format::MAGIC)) != 0)
+    {
+        CloseBinaryFile();
+        EXCEPTION("File " + file_name + " is not a binary mesh file");
+    }
+
+    unsigned header[format::NUM_HEADER_FIELDS];
+    memcpy(header, mpBinaryData + sizeof(format::MAGIC), sizeof(header));
+    if (header[format::FIELD_BYTE_ORDER_MARK] != format::BYTE_ORDER_MARK)
+    {
+        CloseBinaryFile();
+        EXCEPTION("Binary mesh file " + file_name + " was written with a different byte order");
+    }
+    if (header[format::FIELD_VERSION] != format::VERSION)
+    {
+        unsigned version = header[format::FIELD_VERSION];
+        CloseBinaryFile();
+        EXCEPTION("Binary mesh file " << file_name << " has format version " << version << ", but version " << format::VERSION << " is expected");
+    }
+    if (header[format::FIELD_SPACE_DIM] != SPACE_DIM)
+    {
+        CloseBinaryFile();
+        EXCEPTION("Binary mesh file " + file_name + " has the wrong space dimension");
+    }
+
+    mIndexFromZero = true;
+    mNumNodes = header[format::FIELD_NUM_NODES];
+    mNumNodeAttributes = header[format::FIELD_NUM_NODE_ATTRIBUTES];
+    mNumElements = header[format::FIELD_NUM_ELEMENTS];
+    mNumElementAttributes = 1;
+    mMembraneIndex = header[format::FIELD_MEMBRANE_INDEX];
+    mNumGridPtsX = header[format::FIELD_NUM_GRID_PTS_X];
+    mNumGridPtsY = header[format::FIELD_NUM_GRID_PTS_Y];
+    memcpy(&mCharacteristicNodeSpacing, mpBinaryData + sizeof(format::MAGIC) + sizeof(header), sizeof(double));
+    unsigned num_element_nodes = header[format::FIELD_NUM_ELEMENT_NODES];
+
+    // Locate each section, checking the file holds all of them
+    std::size_t num_doubles = (std::size_t)mNumNodes * (SPACE_DIM + mNumNodeAttributes) + 2 * (std::size_t)mNumGridPtsX * mNumGridPtsY;
+    std::size_t num_unsigneds = (std::size_t)mNumNodes + ((std::size_t)mNumElements + 1) + num_element_nodes + mNumElements;
+    if (mBinaryDataSize != format::HEADER_SIZE + num_doubles * sizeof(double) + num_unsigneds * sizeof(unsigned))
+    {
+        CloseBinaryFile();
+        EXCEPTION("Binary mesh file " + file_name + " does not have the size its header describes");
+    }
+
+    mpNodeLocationData = reinterpret_cast<const double*>(mpBinaryData + format::HEADER_SIZE);
+    mpNodeAttributeData = mpNodeLocationData + (std::size_t)mNumNodes * SPACE_DIM;
+    mpVelocityGridData = mpNodeAttributeData + (std::size_t)mNumNodes * mNumNodeAttributes;
+    mpBoundaryFlagData = reinterpret_cast<const unsigned*>(mpVelocityGridData + 2 * (std::size_t)mNumGridPtsX * mNumGridPtsY);
+    mpElementOffsetData = mpBoundaryFlagData + mNumNodes;
+    mpElementNodeIndexData = mpElementOffsetData + mNumElements + 1;
+    mpElementAttributeData = mpElementNodeIndexData + num_element_nodes;
+
+    // The element sections index into each other and into the nodes, so check them before anything dereferences them
+    if (mpElementOffsetData[0] != 0 || mpElementOffsetData[mNumElements] != num_element_nodes)
+    {
+        CloseBinaryFile();
+        EXCEPTION("Binary mesh file " + file_name + " has element offsets that do not span its element nodes");
+    }
+    for (unsigned elem_idx = 0; elem_idx < mNumElements; elem_idx++)
+    {
+        if (mpElementOffsetData[elem_idx] > mpElementOffsetData[elem_idx + 1])
+        {
+            CloseBinaryFile();
+            EXCEPTION("Binary mesh file " << file_name << " has a decreasing offset for element " << elem_idx);
+        }
+    }
+    for (unsigned i = 0; i < num_element_nodes; i++)
+    {
+        if (mpElementNodeIndexData[i] >= mNumNodes)
+        {
+            CloseBinaryFile();
+            EXCEPTION("Binary mesh file " << file_name << " refers to node " << mpElementNodeIndexData[i] << ", but has only " << mNumNodes << " nodes");
+        }
+    }
+    if (mMembraneIndex != UINT_MAX && mMembraneIndex >= mNumElements)
+    {
+        CloseBinaryFile();
+        EXCEPTION("Binary mesh file " + file_name + " has a membrane index beyond its elements");
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::CloseBinaryFile()
 {
-    OpenFiles();
-    ReadHeaders();
+    if (mpBinaryData)
+    {
+        munmap(mpBinaryData, mBinaryDataSize);
+        mpBinaryData = NULL;
+        mBinaryDataSize = 0;
+    }
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
@@ -91,12 +732,17 @@ double ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::GetCharacteristicNode
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 void ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::Reset()
 {
-    CloseFiles();
-    OpenFiles();
-    ReadHeaders();
+    // Data held in memory need no reopening
+    if (!AreDataInMemory())
+    {
+        CloseFiles();
+        OpenFiles();
+        ReadHeaders();
+    }
 
     mNodesRead = 0;
     mElementsRead = 0;
+    mGridRowsRead = 0;
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
@@ -104,6 +750,24 @@ std::vector<double> ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::GetNextN
 {
     std::vector<double> node_data;
 
+    if (AreDataInMemory())
+    {
+        if (mNodesRead >= mNumNodes)
+        {
+            EXCEPTION("Cannot get the next node from memory, as all have been read");
+        }
+
+        const double* p_location = mpNodeLocationData + (std::size_t)mNodesRead * SPACE_DIM;
+        const double* p_attributes = mpNodeAttributeData + (std::size_t)mNodesRead * mNumNodeAttributes;
+        node_data.reserve(SPACE_DIM + 1 + mNumNodeAttributes);
+        node_data.assign(p_location, p_location + SPACE_DIM);
+        node_data.push_back((double)mpBoundaryFlagData[mNodesRead]);
+        node_data.insert(node_data.end(), p_attributes, p_attributes + mNumNodeAttributes);
+
+        mNodesRead++;
+        return node_data;
+    }
+
     std::string buffer;
     GetNextLineFromStream(mNodesFile, buffer);
 
@@ -119,7 +783,7 @@ std::vector<double> ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::GetNextN
     }
 
     double node_value;
-    for (unsigned i=0; i<SPACE_DIM+1; i++)
+    for (unsigned i=0; i<SPACE_DIM+1+mNumNodeAttributes; i++)
     {
         buffer_stream >> node_value;
         node_data.push_back(node_value);
@@ -135,6 +799,26 @@ std::vector<double> ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::GetNextG
     std::vector<double> grid_row;
     grid_row.resize(mNumGridPtsX);
 
+    if (AreDataInMemory())
+    {
+        if (mGridRowsRead >= 2 * mNumGridPtsY)
+        {
+            EXCEPTION("Cannot get the next grid row from memory, as all have been read");
+        }
+
+        // Rows run over x at fixed y, for the x-velocity grid and then the y-velocity grid
+        unsigned dim = mGridRowsRead / mNumGridPtsY;
+        unsigned y_idx = mGridRowsRead % mNumGridPtsY;
+        const double* p_grid = mpVelocityGridData + (std::size_t)dim * mNumGridPtsX * mNumGridPtsY;
+        for (unsigned x_idx = 0; x_idx < mNumGridPtsX; x_idx++)
+        {
+            grid_row[x_idx] = p_grid[(std::size_t)x_idx * mNumGridPtsY + y_idx];
+        }
+
+        mGridRowsRead++;
+        return grid_row;
+    }
+
     std::string buffer;
     GetNextLineFromStream(mGridFile, buffer);
 
@@ -156,6 +840,22 @@ ImmersedBoundaryElementData ImmersedBoundaryMeshReader<ELEMENT_DIM, SPACE_DIM>::
     // Create data structure for this element
     ImmersedBoundaryElementData element_data;
 
+    if (AreDataInMemory())
+    {
+        if (mElementsRead >= mNumElements)
+        {
+            EXCEPTION("Cannot get the next element from memory, as all have been read");
+        }
+
+        element_data.NodeIndices.assign(mpElementNodeIndexData + mpElementOffsetData[mElementsRead],
+                                        mpElementNodeIndexData + mpElementOffsetData[mElementsRead + 1]);
+        element_data.AttributeValue = mpElementAttributeData[mElementsRead];
+        element_data.MembraneElement = (mElementsRead == mMembraneIndex);
+
+        mElementsRead++;
+        return element_data;
+    }
+
     std::string buffer;
     GetNextLineFromStream(mElementsFile, buffer);
 
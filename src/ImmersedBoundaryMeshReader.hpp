@@ -39,6 +39,8 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <string>
 #include <fstream>
 #include <cassert>
+#include <climits>
+#include <cstddef>
 #include <vector>
 
 #include "Exception.hpp"
@@ -57,8 +59,57 @@ struct ImmersedBoundaryElementData
     bool MembraneElement; /**< Whether element is the basement membrane. */
 };
 
+/**
+ * The layout of the binary immersed boundary mesh format, written by
+ * ImmersedBoundaryMeshWriter::WriteBinaryFilesUsingMesh() to a single file with extension ".ibm".
+ *
+ * The file starts with the header below, whose fields are written in order without padding.  The sections follow,
+ * each packed densely in native byte order: node locations, node attributes and the two velocity grids (as doubles,
+ * the grids in the [dim][x][y] order of the mesh's grids), then node boundary flags, element offsets into the node
+ * index list, element node indices and element attribute values (as 32-bit unsigned integers).  All doubles therefore
+ * lie at multiples of eight bytes from the start of the file, so the sections can be used in place once mapped.
+ */
+namespace ImmersedBoundaryBinaryMeshFormat
+{
+    /** The string identifying a binary immersed boundary mesh file, which starts the header. */
+    const char MAGIC[8] = {'I', 'B', 'M', 'E', 'S', 'H', '\0', '\0'};
+
+    /** The version of the format, incremented whenever the layout changes. */
+    const unsigned VERSION = 1u;
+
+    /** A fixed value stored in the header so that files written with a different byte order are detected. */
+    const unsigned BYTE_ORDER_MARK = 0x01020304u;
+
+    /**
+     * The indices of the unsigned fields of the header, which follow the magic string and precede the characteristic
+     * node spacing.
+     */
+    enum HeaderField
+    {
+        FIELD_VERSION,
+        FIELD_BYTE_ORDER_MARK,
+        FIELD_SPACE_DIM,
+        FIELD_NUM_NODES,
+        FIELD_NUM_NODE_ATTRIBUTES,
+        FIELD_NUM_ELEMENTS,
+        FIELD_NUM_ELEMENT_NODES,
+        FIELD_MEMBRANE_INDEX,
+        FIELD_NUM_GRID_PTS_X,
+        FIELD_NUM_GRID_PTS_Y,
+        NUM_HEADER_FIELDS
+    };
+
+    /** The size of the header in bytes: the magic string, the unsigned fields and the characteristic node spacing. */
+    const std::size_t HEADER_SIZE = sizeof(MAGIC) + NUM_HEADER_FIELDS * sizeof(unsigned) + sizeof(double);
+}
+
 /**
  * A mesh reader class for immersed boundary meshes.
+ *
+ * Meshes are read either from the text files ".node", ".cell" and ".grid", or from a single binary file ".ibm" (see
+ * ImmersedBoundaryBinaryMeshFormat).  A binary file is mapped into memory rather than parsed, so reading it costs
+ * little more than copying the data out, and it holds every value at full double precision.  Text files may also be
+ * parsed in one go by ParseTextFiles(), which is much faster for large meshes than reading them a line at a time.
  */
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 class ImmersedBoundaryMeshReader : public AbstractMeshReader<ELEMENT_DIM, SPACE_DIM>
@@ -107,6 +158,98 @@ private:
     /** The characteristic node spacing. */
     double mCharacteristicNodeSpacing;
 
+    /** The start of the mapped binary mesh file, or NULL if reading text files. */
+    char* mpBinaryData;
+
+    /** The size in bytes of the mapped binary mesh file. */
+    std::size_t mBinaryDataSize;
+
+    /** The node locations, in the mapped binary mesh file or in mParsedNodeLocations. */
+    const double* mpNodeLocationData;
+
+    /** The node attributes, in the mapped binary mesh file or in mParsedNodeAttributes. */
+    const double* mpNodeAttributeData;
+
+    /** The velocity grids, in the mapped binary mesh file or in mParsedVelocityGrids. */
+    const double* mpVelocityGridData;
+
+    /** The node boundary flags, in the mapped binary mesh file or in mParsedBoundaryFlags. */
+    const unsigned* mpBoundaryFlagData;
+
+    /** The offsets of each element's node indices, in the mapped binary mesh file or in mParsedElementOffsets. */
+    const unsigned* mpElementOffsetData;
+
+    /** The element node indices, in the mapped binary mesh file or in mParsedElementNodeIndices. */
+    const unsigned* mpElementNodeIndexData;
+
+    /** The element attribute values, in the mapped binary mesh file or in mParsedElementAttributes. */
+    const unsigned* mpElementAttributeData;
+
+    /** The index of the membrane element read from the binary mesh file or parsed text files, or UINT_MAX if there is none. */
+    unsigned mMembraneIndex;
+
+    /** Whether the text files have been parsed in one go by ParseTextFiles(). */
+    bool mTextFilesAreParsed;
+
+    /** The node locations parsed from the node file, in the layout of the binary mesh format. */
+    std::vector<double> mParsedNodeLocations;
+
+    /** The node attributes parsed from the node file, in the layout of the binary mesh format. */
+    std::vector<double> mParsedNodeAttributes;
+
+    /** The velocity grids parsed from the grid file, in the layout of the binary mesh format. */
+    std::vector<double> mParsedVelocityGrids;
+
+    /** The node boundary flags parsed from the node file. */
+    std::vector<unsigned> mParsedBoundaryFlags;
+
+    /** The offsets of each element's node indices in mParsedElementNodeIndices, with one extra entry at the end. */
+    std::vector<unsigned> mParsedElementOffsets;
+
+    /** The element node indices parsed from the element file, numbered from zero. */
+    std::vector<unsigned> mParsedElementNodeIndices;
+
+    /** The element attribute values parsed from the element file. */
+    std::vector<unsigned> mParsedElementAttributes;
+
+    /** Number of rows of the velocity grids read in by the reader from memory. */
+    unsigned mGridRowsRead;
+
+    /**
+     * Map the binary mesh file into memory, and check and read its header.
+     */
+    void OpenBinaryFile();
+
+    /**
+     * Unmap the binary mesh file, if it is mapped.
+     */
+    void CloseBinaryFile();
+
+    /**
+     * Parse the node file, held in memory, into mParsedNodeLocations, mParsedNodeAttributes and mParsedBoundaryFlags.
+     *
+     * @param rLineStarts the start of each data line in the file, terminated by a null character
+     * @param numThreads the number of threads with which to parse the lines
+     */
+    void ParseNodeLines(const std::vector<const char*>& rLineStarts, unsigned numThreads);
+
+    /**
+     * Parse the element file, held in memory, into mParsedElementOffsets, mParsedElementNodeIndices and
+     * mParsedElementAttributes.
+     *
+     * @param rLineStarts the start of each data line in the file, terminated by a null character
+     * @param numThreads the number of threads with which to parse the lines
+     */
+    void ParseElementLines(const std::vector<const char*>& rLineStarts, unsigned numThreads);
+
+    /**
+     * Parse the grid file, held in memory, into mParsedVelocityGrids.
+     *
+     * @param rLineStarts the start of each data line in the file, terminated by a null character
+     * @param numThreads the number of threads with which to parse the lines
+     */
+    void ParseGridLines(const std::vector<const char*>& rLineStarts, unsigned numThreads);
+
     /**
      * Open node and element files.
      */
@@ -151,14 +294,84 @@ public:
      * Constructor.
      *
      * @param pathBaseName the base name for results files
+     * @param readBinary whether to read the binary mesh file, rather than the text files (defaults to false)
      */
-    ImmersedBoundaryMeshReader(std::string pathBaseName);
+    ImmersedBoundaryMeshReader(std::string pathBaseName, bool readBinary=false);
 
     /**
      * Destructor.
      */
-    ~ImmersedBoundaryMeshReader()
-    {}
+    ~ImmersedBoundaryMeshReader();
+
+    /**
+     * @return whether the mesh is read from a binary mesh file
+     */
+    bool IsBinary() const;
+
+    /**
+     * Read each text file in one go and parse all of it, rather than a line at a time as the GetNext methods otherwise
+     * do.  The numbers are parsed in place, without allocating per line, and the lines may be shared between threads.
+     * Afterwards the data are held in memory in the layout of the binary mesh format, so ImmersedBoundaryMesh can be
+     * filled from them directly and the GetNext methods no longer read the files.  Does nothing if reading a binary
+     * mesh file, or if the files have already been parsed.
+     *
+     * @param numThreads the number of threads with which to parse each file (defaults to 1); ignored without OpenMP
+     */
+    void ParseTextFiles(unsigned numThreads=1);
+
+    /**
+     * @return whether all the mesh data are held in memory, because a binary mesh file is read or the text files
+     *     have been parsed by ParseTextFiles()
+     */
+    bool AreDataInMemory() const;
+
+    /**
+     * @return the node locations, SPACE_DIM values per node, if AreDataInMemory(), or NULL otherwise.  The data remain
+     *     valid until the reader is destroyed, as do those of the other data accessors.
+     */
+    const double* GetNodeLocationData() const;
+
+    /**
+     * @return the node attributes, GetNumNodeAttributes() values per node, if AreDataInMemory(), or NULL otherwise
+     */
+    const double* GetNodeAttributeData() const;
+
+    /**
+     * @return the boundary flag of each node if AreDataInMemory(), or NULL otherwise
+     */
+    const unsigned* GetBoundaryFlagData() const;
+
+    /**
+     * @return the offset of each element's first node index in GetElementNodeIndexData(), followed by the total number
+     *     of element node indices, if AreDataInMemory(), or NULL otherwise
+     */
+    const unsigned* GetElementOffsetData() const;
+
+    /**
+     * @return the node indices of the elements, numbered from zero, if AreDataInMemory(), or NULL otherwise
+     */
+    const unsigned* GetElementNodeIndexData() const;
+
+    /**
+     * @return the attribute value of each element if AreDataInMemory(), or NULL otherwise
+     */
+    const unsigned* GetElementAttributeData() const;
+
+    /**
+     * @return the index of the membrane element, or UINT_MAX if there is none.  Only meaningful if AreDataInMemory().
+     */
+    unsigned GetMembraneIndex() const;
+
+    /**
+     * @return the number of attributes stored at each node
+     */
+    unsigned GetNumNodeAttributes() const;
+
+    /**
+     * @return the velocity grids, in the [dim][x][y] order of the mesh's grids, if AreDataInMemory(), or NULL
+     *     otherwise.  The data remain valid until the reader is destroyed.
+     */
+    const double* GetVelocityGridData() const;
 
     /**
      * @return the number of elements in the mesh.
@@ -196,7 +409,7 @@ public:
     void Reset();
 
     /**
-     * @return the coordinates of each node in turn.
+     * @return the coordinates of each node in turn, followed by whether it is a boundary node and then its attributes.
      */
     std::vector<double> GetNextNode();
 
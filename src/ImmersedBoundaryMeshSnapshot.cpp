@@ -0,0 +1,255 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "ImmersedBoundaryMeshSnapshot.hpp"
+#include <climits>
+#include "CsvWriter.hpp"
+#include "ImmersedBoundaryMesh.hpp"
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::ImmersedBoundaryMeshSnapshot()
+    : mNumAllElements(0),
+      mMembraneIndex(UINT_MAX),
+      mTimeStep(0)
+{
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::TakeFromMesh(ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>& rMesh,
+                                                                        unsigned timeStep)
+{
+    mTimeStep = timeStep;
+    mNumAllElements = rMesh.GetNumAllElements();
+    mMembraneIndex = rMesh.GetMembraneIndex();
+    mCellDataNames.clear();
+    mCellData.clear();
+
+    // Only the elements with a node that has wrapped around the domain since the last snapshot are recalculated
+    if (SPACE_DIM == 2)
+    {
+        mPeriodicOverlaps = rMesh.rGetPeriodicOverlaps();
+    }
+
+    mNodeLocations.resize(rMesh.GetNumAllNodes());
+    for (typename AbstractMesh<ELEMENT_DIM, SPACE_DIM>::NodeIterator node_iter = rMesh.GetNodeIteratorBegin();
+         node_iter != rMesh.GetNodeIteratorEnd();
+         ++node_iter)
+    {
+        mNodeLocations[node_iter->GetIndex()] = node_iter->rGetLocation();
+    }
+
+    mElementIndices.clear();
+    mElementOffsets.assign(1, 0u);
+    mElementNodeIndices.clear();
+    for (typename ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>::ImmersedBoundaryElementIterator elem_iter = rMesh.GetElementIteratorBegin();
+         elem_iter != rMesh.GetElementIteratorEnd();
+         ++elem_iter)
+    {
+        mElementIndices.push_back(elem_iter->GetIndex());
+        for (unsigned node_idx = 0; node_idx < elem_iter->GetNumNodes(); node_idx++)
+        {
+            mElementNodeIndices.push_back(elem_iter->GetNodeGlobalIndex(node_idx));
+        }
+        mElementOffsets.push_back(mElementNodeIndices.size());
+    }
+
+    // The overlaps give the number of parts of every element, by global index
+    mNumCellParts.assign(mElementIndices.size(), 1u);
+    if (SPACE_DIM == 2)
+    {
+        const std::vector<unsigned>& r_num_cell_parts = mPeriodicOverlaps.rGetNumCellParts();
+        for (unsigned local_idx = 0; local_idx < mElementIndices.size(); local_idx++)
+        {
+            mNumCellParts[local_idx] = r_num_cell_parts[mElementIndices[local_idx]];
+        }
+    }
+
+    mCellIds.assign(mElementIndices.size(), UINT_MAX);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::SetCellDataNames(const std::vector<std::string>& rNames)
+{
+    // The storage of previous snapshots is reused, so this only allocates when the mesh or the number of items grows
+    mCellDataNames.assign(rNames.begin(), rNames.end());
+    mCellData.resize(rNames.size() * mElementIndices.size());
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::GetNumElements() const
+{
+    return mElementIndices.size();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::GetNumAllElements() const
+{
+    return mNumAllElements;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::GetElementIndex(unsigned localIndex) const
+{
+    assert(localIndex < mElementIndices.size());
+    return mElementIndices[localIndex];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::GetNumElementNodes(unsigned localIndex) const
+{
+    assert(localIndex < mElementIndices.size());
+    return mElementOffsets[localIndex + 1] - mElementOffsets[localIndex];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::GetElementNodeGlobalIndex(unsigned localIndex, unsigned nodeIndex) const
+{
+    assert(nodeIndex < GetNumElementNodes(localIndex));
+    return mElementNodeIndices[mElementOffsets[localIndex] + nodeIndex];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const c_vector<double, SPACE_DIM>& ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::rGetNodeLocation(unsigned globalIndex) const
+{
+    assert(globalIndex < mNodeLocations.size());
+    return mNodeLocations[globalIndex];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::GetMembraneIndex() const
+{
+    return mMembraneIndex;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const ImmersedBoundaryPeriodicOverlaps<SPACE_DIM>& ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::rGetPeriodicOverlaps() const
+{
+    return mPeriodicOverlaps;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::GetTimeStep() const
+{
+    return mTimeStep;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::GetNumCellParts(unsigned localIndex) const
+{
+    assert(localIndex < mNumCellParts.size());
+    return mNumCellParts[localIndex];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::GetTotalNumCellParts() const
+{
+    unsigned total = 0;
+    for (unsigned local_idx = 0; local_idx < mNumCellParts.size(); local_idx++)
+    {
+        total += mNumCellParts[local_idx];
+    }
+    return total;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::SetCellId(unsigned localIndex, unsigned cellId)
+{
+    assert(localIndex < mCellIds.size());
+    mCellIds[localIndex] = cellId;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::GetCellId(unsigned localIndex) const
+{
+    assert(localIndex < mCellIds.size());
+    return mCellIds[localIndex];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::GetNumCellDataItems() const
+{
+    return mCellDataNames.size();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const std::string& ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::rGetCellDataName(unsigned item) const
+{
+    assert(item < mCellDataNames.size());
+    return mCellDataNames[item];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+double* ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::GetCellData(unsigned item)
+{
+    assert(item < mCellDataNames.size());
+    return mCellData.empty() ? NULL : &mCellData[item * mElementIndices.size()];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const double* ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::GetCellData(unsigned item) const
+{
+    assert(item < mCellDataNames.size());
+    return mCellData.empty() ? NULL : &mCellData[item * mElementIndices.size()];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>::AppendCellDataToCsv(CsvWriter& rWriter) const
+{
+    unsigned num_elements = mElementIndices.size();
+    unsigned num_items = mCellDataNames.size();
+
+    std::vector<unsigned> unsigned_row(3);
+    std::vector<double> double_row(num_items);
+    for (unsigned local_idx = 0; local_idx < num_elements; local_idx++)
+    {
+        unsigned_row[0] = mTimeStep;
+        unsigned_row[1] = mElementIndices[local_idx];
+        unsigned_row[2] = mCellIds[local_idx];
+        for (unsigned item = 0; item < num_items; item++)
+        {
+            double_row[item] = mCellData[item * num_elements + local_idx];
+        }
+        rWriter.AppendRow(unsigned_row, double_row);
+    }
+}
+
+// Explicit instantiation
+template class ImmersedBoundaryMeshSnapshot<1,1>;
+template class ImmersedBoundaryMeshSnapshot<1,2>;
+template class ImmersedBoundaryMeshSnapshot<1,3>;
+template class ImmersedBoundaryMeshSnapshot<2,2>;
+template class ImmersedBoundaryMeshSnapshot<2,3>;
+template class ImmersedBoundaryMeshSnapshot<3,3>;
@@ -0,0 +1,224 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef IMMERSEDBOUNDARYMESHSNAPSHOT_HPP_
+#define IMMERSEDBOUNDARYMESHSNAPSHOT_HPP_
+
+#include <string>
+#include <vector>
+#include "UblasVectorInclude.hpp"
+#include "ImmersedBoundaryPeriodicOverlaps.hpp"
+
+// Forward declaration prevents circular include chain
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+class ImmersedBoundaryMesh;
+
+class CsvWriter;
+
+/**
+ * A copy of the node locations and element connectivity of an immersed boundary mesh, together with any cell data
+ * to be output with it, taken so that output can be written after the mesh has moved on.
+ *
+ * Node locations are stored by global node index, and elements in the order of the mesh's element iterator, so deleted
+ * nodes and elements are skipped as in the mesh writers.  Taking a snapshot reuses the storage of the previous one, so
+ * a snapshot that is retaken each output step does not allocate once it has reached the size of the mesh.
+ *
+ * The cell data are held as columns, with a value for each element, in a single block: first the value of each cell
+ * writer, then each item of the cells' CellData.  Together with the ID of the cell of each element and the number of
+ * parts each element is broken into for visualisation, this is everything the VTK, CSV and other outputs of a cell
+ * population need, filled in a single pass over the cells and read by each output in place.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+class ImmersedBoundaryMeshSnapshot
+{
+private:
+
+    /** The location of each node, by global index. */
+    std::vector<c_vector<double, SPACE_DIM> > mNodeLocations;
+
+    /** The index of each element in the mesh. */
+    std::vector<unsigned> mElementIndices;
+
+    /** The offset of each element's node indices in #mElementNodeIndices, followed by the total number of indices. */
+    std::vector<unsigned> mElementOffsets;
+
+    /** The global indices of the nodes of each element in turn. */
+    std::vector<unsigned> mElementNodeIndices;
+
+    /** The total number of elements in the mesh, including any deleted elements. */
+    unsigned mNumAllElements;
+
+    /** The index of the membrane element, or UINT_MAX if there is none. */
+    unsigned mMembraneIndex;
+
+    /** The time step at which the snapshot was taken, used to name output files. */
+    unsigned mTimeStep;
+
+    /** The periodic overlaps of every element, copied from the mesh in two dimensions. */
+    ImmersedBoundaryPeriodicOverlaps<SPACE_DIM> mPeriodicOverlaps;
+
+    /**
+     * The number of parts each element is broken into for visualisation, in the order of #mElementIndices.  This is
+     * one, except for an element wrapping around the boundary of a 2D domain.
+     */
+    std::vector<unsigned> mNumCellParts;
+
+    /** The ID of the cell of each element, in the order of #mElementIndices, or UINT_MAX if not set. */
+    std::vector<unsigned> mCellIds;
+
+    /** The name of each item of cell data. */
+    std::vector<std::string> mCellDataNames;
+
+    /** The values of every item of cell data in turn, each having one value per element in the order of #mElementIndices. */
+    std::vector<double> mCellData;
+
+public:
+
+    /**
+     * Constructor.
+     */
+    ImmersedBoundaryMeshSnapshot();
+
+    /**
+     * Copy the node locations and connectivity of a mesh, and clear any cell IDs and cell data.
+     *
+     * @param rMesh the mesh
+     * @param timeStep the time step at which the snapshot is taken
+     */
+    void TakeFromMesh(ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>& rMesh, unsigned timeStep=0);
+
+    /**
+     * Set the names of the items of cell data, and allocate their values, which should then be filled in through
+     * GetCellData().
+     *
+     * @param rNames the name of each item
+     */
+    void SetCellDataNames(const std::vector<std::string>& rNames);
+
+    /** @return the number of elements in the snapshot */
+    unsigned GetNumElements() const;
+
+    /** @return #mNumAllElements */
+    unsigned GetNumAllElements() const;
+
+    /**
+     * @param localIndex the position of an element in the snapshot
+     * @return the index of that element in the mesh
+     */
+    unsigned GetElementIndex(unsigned localIndex) const;
+
+    /**
+     * @param localIndex the position of an element in the snapshot
+     * @return the number of nodes in that element
+     */
+    unsigned GetNumElementNodes(unsigned localIndex) const;
+
+    /**
+     * @param localIndex the position of an element in the snapshot
+     * @param nodeIndex the local index of a node in that element
+     * @return the global index of that node
+     */
+    unsigned GetElementNodeGlobalIndex(unsigned localIndex, unsigned nodeIndex) const;
+
+    /**
+     * @param globalIndex the global index of a node
+     * @return the location of that node
+     */
+    const c_vector<double, SPACE_DIM>& rGetNodeLocation(unsigned globalIndex) const;
+
+    /** @return #mMembraneIndex */
+    unsigned GetMembraneIndex() const;
+
+    /** @return #mTimeStep */
+    unsigned GetTimeStep() const;
+
+    /** @return #mPeriodicOverlaps */
+    const ImmersedBoundaryPeriodicOverlaps<SPACE_DIM>& rGetPeriodicOverlaps() const;
+
+    /**
+     * @param localIndex the position of an element in the snapshot
+     * @return the number of parts that element is broken into for visualisation
+     */
+    unsigned GetNumCellParts(unsigned localIndex) const;
+
+    /** @return the total number of parts the elements are broken into for visualisation */
+    unsigned GetTotalNumCellParts() const;
+
+    /**
+     * Set the ID of the cell of an element.
+     *
+     * @param localIndex the position of an element in the snapshot
+     * @param cellId the ID of its cell
+     */
+    void SetCellId(unsigned localIndex, unsigned cellId);
+
+    /**
+     * @param localIndex the position of an element in the snapshot
+     * @return the ID of its cell, or UINT_MAX if not set
+     */
+    unsigned GetCellId(unsigned localIndex) const;
+
+    /** @return the number of items of cell data */
+    unsigned GetNumCellDataItems() const;
+
+    /**
+     * @param item the index of an item of cell data
+     * @return the name of that item
+     */
+    const std::string& rGetCellDataName(unsigned item) const;
+
+    /**
+     * @param item the index of an item of cell data
+     * @return pointer to the values of that item, one for each element in the order of the snapshot
+     */
+    double* GetCellData(unsigned item);
+
+    /**
+     * @param item the index of an item of cell data
+     * @return pointer to the values of that item, one for each element in the order of the snapshot
+     */
+    const double* GetCellData(unsigned item) const;
+
+    /**
+     * Append a row for each element to a CSV writer that is streaming, with the time step, element index and cell ID
+     * as its unsigned columns, and the value of each item of cell data as its double columns.
+     *
+     * @param rWriter the writer, streaming three unsigned columns and a double column for each item of cell data
+     */
+    void AppendCellDataToCsv(CsvWriter& rWriter) const;
+};
+
+#endif /*IMMERSEDBOUNDARYMESHSNAPSHOT_HPP_*/
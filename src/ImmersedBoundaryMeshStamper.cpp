@@ -0,0 +1,324 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryMeshStamper.hpp"
+#include "OutputFileHandler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+ImmersedBoundaryMeshStamper::ImmersedBoundaryMeshStamper(const std::vector<c_vector<double, 2> >& rTemplateLocations,
+                                                         unsigned numGridPtsX,
+                                                         unsigned numGridPtsY)
+    : mTemplateLocations(rTemplateLocations),
+      mWrapX(false),
+      mNumGridPtsX(numGridPtsX),
+      mNumGridPtsY(numGridPtsY),
+      mNumThreads(1u)
+{
+    assert(mTemplateLocations.size() > 2);
+}
+
+void ImmersedBoundaryMeshStamper::SetMembraneLocations(const std::vector<c_vector<double, 2> >& rMembraneLocations)
+{
+    assert(rMembraneLocations.size() > 2);
+    mMembraneLocations = rMembraneLocations;
+}
+
+void ImmersedBoundaryMeshStamper::SetCornerIndices(const std::vector<unsigned>& rCornerIndices)
+{
+    for (unsigned corner = 0; corner < rCornerIndices.size(); corner++)
+    {
+        assert(rCornerIndices[corner] < mTemplateLocations.size());
+    }
+    mCornerIndices = rCornerIndices;
+}
+
+void ImmersedBoundaryMeshStamper::SetWrapX(bool wrapX)
+{
+    mWrapX = wrapX;
+}
+
+void ImmersedBoundaryMeshStamper::SetNumThreads(unsigned numThreads)
+{
+    assert(numThreads > 0);
+    mNumThreads = numThreads;
+}
+
+unsigned ImmersedBoundaryMeshStamper::GetNumThreads() const
+{
+    return mNumThreads;
+}
+
+void ImmersedBoundaryMeshStamper::AddCell(const c_vector<double, 2>& rScale, const c_vector<double, 2>& rShift)
+{
+    mCellScales.push_back(rScale);
+    mCellShifts.push_back(rShift);
+}
+
+unsigned ImmersedBoundaryMeshStamper::GetNumCells() const
+{
+    return mCellScales.size();
+}
+
+unsigned ImmersedBoundaryMeshStamper::GetNumNodes() const
+{
+    return mMembraneLocations.size() + GetNumCells() * mTemplateLocations.size();
+}
+
+double ImmersedBoundaryMeshStamper::CalculateCellPerimeter(unsigned cellIndex) const
+{
+    unsigned num_locations = mTemplateLocations.size();
+    double perimeter = 0.0;
+
+    c_vector<double, 2> this_location = GetCellNodeLocation(cellIndex, 0);
+    for (unsigned location = 0; location < num_locations; location++)
+    {
+        c_vector<double, 2> next_location = GetCellNodeLocation(cellIndex, (location + 1) % num_locations);
+
+        // As ImmersedBoundaryMesh::GetVectorFromAtoB(), for the domain [0,1)x[0,1)
+        c_vector<double, 2> vector = next_location - this_location;
+        for (unsigned dim = 0; dim < 2; dim++)
+        {
+            if (fabs(vector[dim]) > 0.5)
+            {
+                vector[dim] = copysign(fabs(vector[dim]) - 1.0, -vector[dim]);
+            }
+        }
+        perimeter += norm_2(vector);
+
+        this_location = next_location;
+    }
+
+    return perimeter;
+}
+
+double ImmersedBoundaryMeshStamper::CalculateCharacteristicNodeSpacing() const
+{
+    int num_cells = (int)GetNumCells();
+    std::vector<double> perimeters(num_cells);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(mNumThreads)
+#endif
+    for (int cell = 0; cell < num_cells; cell++)
+    {
+        perimeters[cell] = CalculateCellPerimeter((unsigned)cell);
+    }
+
+    // The perimeters are summed in element order, so the result matches that found by ImmersedBoundaryMesh exactly
+    double total_perimeter = 0.0;
+    for (int cell = 0; cell < num_cells; cell++)
+    {
+        total_perimeter += perimeters[cell];
+    }
+
+    return total_perimeter / double(GetNumCells() * mTemplateLocations.size());
+}
+
+ImmersedBoundaryMesh<2,2>* ImmersedBoundaryMeshStamper::CreateMesh() const
+{
+    unsigned num_membrane_nodes = mMembraneLocations.size();
+    unsigned num_locations = mTemplateLocations.size();
+    unsigned first_cell_element = num_membrane_nodes > 0 ? 1 : 0;
+    int num_cells = (int)GetNumCells();
+
+    std::vector<Node<2>*> nodes(GetNumNodes());
+    std::vector<ImmersedBoundaryElement<2,2>*> elements(first_cell_element + num_cells);
+
+    // Add the membrane element, if there is one
+    if (num_membrane_nodes > 0)
+    {
+        for (unsigned mem_node_idx = 0; mem_node_idx < num_membrane_nodes; mem_node_idx++)
+        {
+            nodes[mem_node_idx] = new Node<2>(mem_node_idx, mMembraneLocations[mem_node_idx], true);
+        }
+        std::vector<Node<2>*> nodes_this_elem(nodes.begin(), nodes.begin() + num_membrane_nodes);
+        elements[0] = new ImmersedBoundaryElement<2,2>(0, nodes_this_elem);
+
+        // Pass in null corners
+        std::vector<Node<2>*>& r_elem_corners = elements[0]->rGetCornerNodes();
+        r_elem_corners.assign(mCornerIndices.size(), (Node<2>*)NULL);
+    }
+
+    // Each cell has its own nodes, so the cells are independent and each thread fills its own part of the storage
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(mNumThreads)
+#endif
+    for (int cell = 0; cell < num_cells; cell++)
+    {
+        unsigned first_node = num_membrane_nodes + (unsigned)cell * num_locations;
+
+        std::vector<Node<2>*> nodes_this_elem(num_locations);
+        for (unsigned location = 0; location < num_locations; location++)
+        {
+            nodes_this_elem[location] = new Node<2>(first_node + location, GetCellNodeLocation((unsigned)cell, location), true);
+            nodes[first_node + location] = nodes_this_elem[location];
+        }
+
+        unsigned elem_index = first_cell_element + (unsigned)cell;
+        ImmersedBoundaryElement<2,2>* p_element = new ImmersedBoundaryElement<2,2>(elem_index, nodes_this_elem);
+
+        // Pass in the correct corners
+        std::vector<Node<2>*>& r_elem_corners = p_element->rGetCornerNodes();
+        for (unsigned corner = 0; corner < mCornerIndices.size(); corner++)
+        {
+            r_elem_corners.push_back(p_element->GetNode(mCornerIndices[corner]));
+        }
+
+        elements[elem_index] = p_element;
+    }
+
+    unsigned membrane_index = num_membrane_nodes > 0 ? 0 : UINT_MAX;
+    return new ImmersedBoundaryMesh<2,2>(nodes, elements, mNumGridPtsX, mNumGridPtsY, membrane_index);
+}
+
+void ImmersedBoundaryMeshStamper::WriteBinaryMeshFile(const std::string& rDirectory, const std::string& rBaseName, bool cleanOutputDirectory) const
+{
+    namespace format = ImmersedBoundaryBinaryMeshFormat;
+
+    unsigned num_membrane_nodes = mMembraneLocations.size();
+    unsigned num_locations = mTemplateLocations.size();
+    unsigned num_cells = GetNumCells();
+    unsigned num_nodes = GetNumNodes();
+    unsigned num_elements = (num_membrane_nodes > 0 ? 1 : 0) + num_cells;
+
+    // Write the header; generated nodes have no attributes
+    unsigned header[format::NUM_HEADER_FIELDS];
+    header[format::FIELD_VERSION] = format::VERSION;
+    header[format::FIELD_BYTE_ORDER_MARK] = format::BYTE_ORDER_MARK;
+    header[format::FIELD_SPACE_DIM] = 2;
+    header[format::FIELD_NUM_NODES] = num_nodes;
+    header[format::FIELD_NUM_NODE_ATTRIBUTES] = 0;
+    header[format::FIELD_NUM_ELEMENTS] = num_elements;
+    header[format::FIELD_NUM_ELEMENT_NODES] = num_nodes;
+    header[format::FIELD_MEMBRANE_INDEX] = num_membrane_nodes > 0 ? 0 : UINT_MAX;
+    header[format::FIELD_NUM_GRID_PTS_X] = mNumGridPtsX;
+    header[format::FIELD_NUM_GRID_PTS_Y] = mNumGridPtsY;
+    double node_spacing = CalculateCharacteristicNodeSpacing();
+
+    OutputFileHandler output_file_handler(rDirectory, cleanOutputDirectory);
+    out_stream p_file = output_file_handler.OpenOutputFile(rBaseName + ".ibm", std::ios::out | std::ios::binary);
+    p_file->write(format::MAGIC, sizeof(format::MAGIC));
+    p_file->write(reinterpret_cast<const char*>(header), sizeof(header));
+    p_file->write(reinterpret_cast<const char*>(&node_spacing), sizeof(double));
+
+    // Write the node locations, stamping out a block of cells at a time
+    std::vector<double> values;
+    for (unsigned mem_node_idx = 0; mem_node_idx < num_membrane_nodes; mem_node_idx++)
+    {
+        values.push_back(mMembraneLocations[mem_node_idx][0]);
+        values.push_back(mMembraneLocations[mem_node_idx][1]);
+    }
+    if (!values.empty())
+    {
+        p_file->write(reinterpret_cast<const char*>(&values[0]), values.size() * sizeof(double));
+    }
+
+    const unsigned cells_per_block = 1024;
+    values.resize((std::size_t)cells_per_block * num_locations * 2);
+    for (unsigned first_cell = 0; first_cell < num_cells; first_cell += cells_per_block)
+    {
+        int num_block_cells = (int)std::min(cells_per_block, num_cells - first_cell);
+
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static) num_threads(mNumThreads)
+#endif
+        for (int block_cell = 0; block_cell < num_block_cells; block_cell++)
+        {
+            double* p_values = &values[0] + (std::size_t)block_cell * num_locations * 2;
+            for (unsigned location = 0; location < num_locations; location++)
+            {
+                c_vector<double, 2> node_location = GetCellNodeLocation(first_cell + (unsigned)block_cell, location);
+                p_values[2 * location] = node_location[0];
+                p_values[2 * location + 1] = node_location[1];
+            }
+        }
+
+        p_file->write(reinterpret_cast<const char*>(&values[0]), (std::size_t)num_block_cells * num_locations * 2 * sizeof(double));
+    }
+
+    // The velocity grids of a new mesh are zero
+    std::vector<double> zero_grid_column(mNumGridPtsY, 0.0);
+    for (unsigned column = 0; column < 2 * mNumGridPtsX && mNumGridPtsY > 0; column++)
+    {
+        p_file->write(reinterpret_cast<const char*>(&zero_grid_column[0]), mNumGridPtsY * sizeof(double));
+    }
+
+    // Every generated node is a boundary node
+    std::vector<unsigned> unsigned_values(std::max(num_locations, num_membrane_nodes), 1u);
+    if (num_membrane_nodes > 0)
+    {
+        p_file->write(reinterpret_cast<const char*>(&unsigned_values[0]), num_membrane_nodes * sizeof(unsigned));
+    }
+    for (unsigned cell = 0; cell < num_cells; cell++)
+    {
+        p_file->write(reinterpret_cast<const char*>(&unsigned_values[0]), num_locations * sizeof(unsigned));
+    }
+
+    // Each element's nodes are numbered consecutively, so the node index list just counts up
+    unsigned offset = 0;
+    p_file->write(reinterpret_cast<const char*>(&offset), sizeof(unsigned));
+    if (num_membrane_nodes > 0)
+    {
+        offset += num_membrane_nodes;
+        p_file->write(reinterpret_cast<const char*>(&offset), sizeof(unsigned));
+    }
+    for (unsigned cell = 0; cell < num_cells; cell++)
+    {
+        offset += num_locations;
+        p_file->write(reinterpret_cast<const char*>(&offset), sizeof(unsigned));
+    }
+
+    unsigned_values.resize(num_nodes > 0 ? std::min(num_nodes, 1u << 16) : 1u);
+    for (unsigned first_index = 0; first_index < num_nodes; first_index += unsigned_values.size())
+    {
+        unsigned num_block_indices = std::min((unsigned)unsigned_values.size(), num_nodes - first_index);
+        for (unsigned i = 0; i < num_block_indices; i++)
+        {
+            unsigned_values[i] = first_index + i;
+        }
+        p_file->write(reinterpret_cast<const char*>(&unsigned_values[0]), num_block_indices * sizeof(unsigned));
+    }
+
+    // Generated elements have no attribute
+    if (num_nodes > 0)
+    {
+        std::vector<unsigned> element_attributes(num_elements, 0u);
+        p_file->write(reinterpret_cast<const char*>(&element_attributes[0]), num_elements * sizeof(unsigned));
+    }
+
+    p_file->close();
+}
@@ -0,0 +1,208 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYMESHSTAMPER_HPP_
+#define IMMERSEDBOUNDARYMESHSTAMPER_HPP_
+
+#include <climits>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "UblasVectorInclude.hpp"
+#include "ImmersedBoundaryMesh.hpp"
+
+/**
+ * Stamps out the cells of a generated immersed boundary mesh from a single template shape.
+ *
+ * Each cell is the template with its coordinates scaled and shifted, and optionally wrapped into [0, 1) in x, so the
+ * cells are independent of one another and are stamped out in parallel.  The mesh generators set up a stamper with
+ * the template and the placement of each cell, and then either create the mesh, with its node and element storage
+ * allocated up front, or stream the generated nodes and elements straight into a binary mesh file (see
+ * ImmersedBoundaryBinaryMeshFormat) without creating any nodes or elements at all.
+ *
+ * Nodes are numbered with those of the membrane, if there is one, first, followed by those of each cell in turn.
+ */
+class ImmersedBoundaryMeshStamper
+{
+private:
+
+    /** The locations around the template shape. */
+    std::vector<c_vector<double, 2> > mTemplateLocations;
+
+    /** The node locations of the membrane element, which is empty if there is no membrane. */
+    std::vector<c_vector<double, 2> > mMembraneLocations;
+
+    /** The indices in the template of each cell's corner nodes, which is empty if the cells have no corners. */
+    std::vector<unsigned> mCornerIndices;
+
+    /** The scaling of the template in each direction for each cell. */
+    std::vector<c_vector<double, 2> > mCellScales;
+
+    /** The shift of the scaled template for each cell. */
+    std::vector<c_vector<double, 2> > mCellShifts;
+
+    /** Whether x coordinates are wrapped into [0, 1) after shifting. */
+    bool mWrapX;
+
+    /** The number of grid points in the x direction of the mesh. */
+    unsigned mNumGridPtsX;
+
+    /** The number of grid points in the y direction of the mesh. */
+    unsigned mNumGridPtsY;
+
+    /** The number of threads with which cells are stamped out.  Defaults to 1. */
+    unsigned mNumThreads;
+
+    /**
+     * @return the location of a node of a cell
+     *
+     * @param cellIndex the index of the cell
+     * @param templateIndex the index of the location in the template shape
+     */
+    inline c_vector<double, 2> GetCellNodeLocation(unsigned cellIndex, unsigned templateIndex) const
+    {
+        const c_vector<double, 2>& r_scale = mCellScales[cellIndex];
+        const c_vector<double, 2>& r_shift = mCellShifts[cellIndex];
+        const c_vector<double, 2>& r_template = mTemplateLocations[templateIndex];
+
+        c_vector<double, 2> location;
+        location[0] = r_scale[0] * r_template[0] + r_shift[0];
+        location[1] = r_scale[1] * r_template[1] + r_shift[1];
+        if (mWrapX)
+        {
+            location[0] = fmod(location[0], 1.0);
+        }
+        return location;
+    }
+
+    /**
+     * @return the perimeter of a cell, allowing for periodicity, found exactly as ImmersedBoundaryMesh finds the
+     *     surface area of an element
+     *
+     * @param cellIndex the index of the cell
+     */
+    double CalculateCellPerimeter(unsigned cellIndex) const;
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param rTemplateLocations the locations around the template shape, anticlockwise
+     * @param numGridPtsX the number of grid points in the x direction of the mesh
+     * @param numGridPtsY the number of grid points in the y direction of the mesh
+     */
+    ImmersedBoundaryMeshStamper(const std::vector<c_vector<double, 2> >& rTemplateLocations,
+                                unsigned numGridPtsX,
+                                unsigned numGridPtsY);
+
+    /**
+     * Give the mesh a membrane element, with index 0.
+     *
+     * @param rMembraneLocations the node locations of the membrane element
+     */
+    void SetMembraneLocations(const std::vector<c_vector<double, 2> >& rMembraneLocations);
+
+    /**
+     * Set the corner nodes of each cell.
+     *
+     * @param rCornerIndices the indices in the template of the corner nodes
+     */
+    void SetCornerIndices(const std::vector<unsigned>& rCornerIndices);
+
+    /**
+     * Set #mWrapX.
+     *
+     * @param wrapX whether x coordinates are wrapped into [0, 1) after shifting
+     */
+    void SetWrapX(bool wrapX);
+
+    /**
+     * Set #mNumThreads.
+     *
+     * @param numThreads the number of threads with which cells are stamped out; ignored without OpenMP
+     */
+    void SetNumThreads(unsigned numThreads);
+
+    /**
+     * @return #mNumThreads
+     */
+    unsigned GetNumThreads() const;
+
+    /**
+     * Add a cell, whose node locations are the template locations scaled and then shifted.
+     *
+     * @param rScale the scaling of the template in each direction
+     * @param rShift the shift of the scaled template
+     */
+    void AddCell(const c_vector<double, 2>& rScale, const c_vector<double, 2>& rShift);
+
+    /**
+     * @return the number of cells added, which excludes the membrane
+     */
+    unsigned GetNumCells() const;
+
+    /**
+     * @return the total number of nodes in the mesh, including those of the membrane
+     */
+    unsigned GetNumNodes() const;
+
+    /**
+     * @return the characteristic node spacing of the mesh, which is that ImmersedBoundaryMesh calculates when created
+     */
+    double CalculateCharacteristicNodeSpacing() const;
+
+    /**
+     * Create the mesh.  The nodes and elements of the cells are stamped out in parallel into storage allocated up
+     * front.  The caller takes ownership of the mesh.
+     *
+     * @return the new mesh
+     */
+    ImmersedBoundaryMesh<2,2>* CreateMesh() const;
+
+    /**
+     * Write the mesh straight to a binary mesh file, as ImmersedBoundaryMeshWriter::WriteBinaryFilesUsingMesh() would
+     * write the mesh given by CreateMesh(), but without creating it.  Node locations are stamped out in parallel a
+     * block of cells at a time, so memory use is independent of the size of the mesh.
+     *
+     * @param rDirectory the output directory, relative to where Chaste output is stored
+     * @param rBaseName the base name of the file, to which ".ibm" is appended
+     * @param cleanOutputDirectory whether to clean the output directory (defaults to false)
+     */
+    void WriteBinaryMeshFile(const std::string& rDirectory, const std::string& rBaseName, bool cleanOutputDirectory=false) const;
+};
+
+#endif /*IMMERSEDBOUNDARYMESHSTAMPER_HPP_*/
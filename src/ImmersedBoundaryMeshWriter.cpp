@@ -61,7 +61,9 @@ ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::ImmersedBoundaryMeshWriter(c
         const bool clearOutputDir)
         : AbstractMeshWriter<ELEMENT_DIM, SPACE_DIM>(rDirectory, rBaseName, clearOutputDir),
           mpMesh(NULL),
-          mpIters(new MeshWriterIterators<ELEMENT_DIM, SPACE_DIM>)
+          mpIters(new MeshWriterIterators<ELEMENT_DIM, SPACE_DIM>),
+          mWriteRawBinaryVtk(false),
+          mCompressVtk(false)
 {
     mpIters->pNodeIter = NULL;
     mpIters->pElemIter = NULL;
@@ -142,11 +144,18 @@ ImmersedBoundaryElementData ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::WriteVtkUsingMesh(ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>& rMesh, std::string stamp)
+{
+    mSnapshot.TakeFromMesh(rMesh);
+    WriteVtkUsingSnapshot(mSnapshot, stamp);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::WriteVtkUsingSnapshot(const ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>& rSnapshot, std::string stamp)
 {
 #ifdef CHASTE_VTK
     assert(SPACE_DIM == 2);
     // Create VTK mesh
-    MakeVtkMesh(rMesh);
+    MakeVtkMesh(rSnapshot);
     // Now write VTK mesh to file
     assert(mpVtkUnstructedMesh->CheckAttributes() == 0);
     vtkXMLUnstructuredGridWriter* p_writer = vtkXMLUnstructuredGridWriter::New();
@@ -157,9 +166,25 @@ void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::WriteVtkUsingMesh(Immer
 #endif
     // Uninitialised stuff arises (see #1079), but you can remove valgrind problems by removing compression:
     // **** REMOVE WITH CAUTION *****
-    p_writer->SetCompressor(NULL);
+    if (mCompressVtk)
+    {
+        vtkZLibDataCompressor* p_compressor = vtkZLibDataCompressor::New();
+        p_writer->SetCompressor(p_compressor);
+        p_compressor->Delete(); // Reference counted
+    }
+    else
+    {
+        p_writer->SetCompressor(NULL);
+    }
     // **** REMOVE WITH CAUTION *****
 
+    // Binary data is appended after the XML, optionally as raw bytes rather than base64, to save encoding time and space
+    if (mWriteRawBinaryVtk)
+    {
+        p_writer->SetDataModeToAppended();
+        p_writer->EncodeAppendedDataOff();
+    }
+
     std::string vtk_file_name = this->mpOutputFileHandler->GetOutputDirectoryFullPath() + this->mBaseName;
     if (stamp != "")
     {
@@ -176,6 +201,13 @@ void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::WriteVtkUsingMesh(Immer
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::MakeVtkMesh(ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>& rMesh)
+{
+    mSnapshot.TakeFromMesh(rMesh);
+    MakeVtkMesh(mSnapshot);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::MakeVtkMesh(const ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>& rSnapshot)
 {
     /**
      * To allow viewing in Paraview, we have to treat differently cells which overlap the boundaries, as there is no
@@ -199,12 +231,10 @@ void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::MakeVtkMesh(ImmersedBou
     p_pts->GetData()->SetName("Vertex positions");
 
     // Next, we decide how to output the VTK data depending on the type of overlap
-    for (typename ImmersedBoundaryMesh<ELEMENT_DIM,SPACE_DIM>::ImmersedBoundaryElementIterator iter = rMesh.GetElementIteratorBegin();
-            iter != rMesh.GetElementIteratorEnd();
-            ++iter)
+    for (unsigned local_idx = 0; local_idx < rSnapshot.GetNumElements(); local_idx++)
     {
-        unsigned elem_idx = iter->GetIndex();
-        unsigned num_nodes = iter->GetNumNodes();
+        unsigned elem_idx = rSnapshot.GetElementIndex(local_idx);
+        unsigned num_nodes = rSnapshot.GetNumElementNodes(local_idx);
 
         // Case 1:  no overlap at all
         if ( !mHOverlaps[elem_idx] && !mVOverlaps[elem_idx] )
@@ -214,21 +244,20 @@ void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::MakeVtkMesh(ImmersedBou
 
             vtkCell* p_cell = vtkPolygon::New();
             vtkIdList* p_cell_id_list = p_cell->GetPointIds();
-            p_cell_id_list->SetNumberOfIds(iter->GetNumNodes());
+            p_cell_id_list->SetNumberOfIds(num_nodes);
 
             for (unsigned node_idx = 0; node_idx < num_nodes; node_idx++)
             {
-                // Get node, index and location
-                Node<SPACE_DIM>* p_node = iter->GetNode(node_idx);
-                unsigned global_idx = p_node->GetIndex();
-                c_vector<double, SPACE_DIM> position = p_node->rGetLocation();
+                // Get node index and location
+                unsigned global_idx = rSnapshot.GetElementNodeGlobalIndex(local_idx, node_idx);
+                const c_vector<double, SPACE_DIM>& position = rSnapshot.rGetNodeLocation(global_idx);
 
                 p_pts->InsertPoint(global_idx, position[0], position[1], 0.0);
 
                 p_cell_id_list->SetId(node_idx, global_idx);
             }
 
-            if (elem_idx == rMesh.GetMembraneIndex())
+            if (elem_idx == rSnapshot.GetMembraneIndex())
             {
                 mpVtkUnstructedMesh->InsertNextCell(3, p_cell_id_list);
             }
@@ -263,10 +292,9 @@ void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::MakeVtkMesh(ImmersedBou
 
             for (unsigned node_idx = 0; node_idx < num_nodes_a; node_idx++)
             {
-                // Get node, index and location
-                Node<SPACE_DIM>* p_node = iter->GetNode(node_idx + overlap[0]);
-                unsigned global_idx = p_node->GetIndex();
-                c_vector<double, SPACE_DIM> position = p_node->rGetLocation();
+                // Get node index and location
+                unsigned global_idx = rSnapshot.GetElementNodeGlobalIndex(local_idx, node_idx + overlap[0]);
+                const c_vector<double, SPACE_DIM>& position = rSnapshot.rGetNodeLocation(global_idx);
 
                 p_pts->InsertPoint(global_idx, position[0], position[1], 0.0);
 
@@ -283,10 +311,9 @@ void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::MakeVtkMesh(ImmersedBou
 
             for (unsigned node_idx = 0; node_idx < num_nodes_b; node_idx++)
             {
-                // Get node, index and location
-                Node<SPACE_DIM>* p_node = iter->GetNode((node_idx + overlap[1]) % num_nodes);
-                unsigned global_idx = p_node->GetIndex();
-                c_vector<double, SPACE_DIM> position = p_node->rGetLocation();
+                // Get node index and location
+                unsigned global_idx = rSnapshot.GetElementNodeGlobalIndex(local_idx, (node_idx + overlap[1]) % num_nodes);
+                const c_vector<double, SPACE_DIM>& position = rSnapshot.rGetNodeLocation(global_idx);
 
                 p_pts->InsertPoint(global_idx, position[0], position[1], 0.0);
 
@@ -332,6 +359,37 @@ void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::AddCellData(std::string
 #endif //CHASTE_VTK
 }
 
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::AddCellData(const ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>& rSnapshot)
+{
+#ifdef CHASTE_VTK
+    unsigned num_elements = rSnapshot.GetNumElements();
+    unsigned num_vtk_cells = rSnapshot.GetTotalNumCellParts();
+
+    for (unsigned item = 0; item < rSnapshot.GetNumCellDataItems(); item++)
+    {
+        const double* p_values = rSnapshot.GetCellData(item);
+
+        vtkDoubleArray* p_scalars = vtkDoubleArray::New();
+        p_scalars->SetName(rSnapshot.rGetCellDataName(item).c_str());
+        p_scalars->SetNumberOfValues(num_vtk_cells);
+
+        vtkIdType vtk_idx = 0;
+        for (unsigned local_idx = 0; local_idx < num_elements; local_idx++)
+        {
+            for (unsigned part = 0; part < rSnapshot.GetNumCellParts(local_idx); part++)
+            {
+                p_scalars->SetValue(vtk_idx++, p_values[local_idx]);
+            }
+        }
+
+        vtkCellData* p_cell_data = mpVtkUnstructedMesh->GetCellData();
+        p_cell_data->AddArray(p_scalars);
+        p_scalars->Delete(); // Reference counted
+    }
+#endif //CHASTE_VTK
+}
+
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::AddPointData(std::string dataName, std::vector<double> dataPayload)
 {
@@ -369,6 +427,116 @@ void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::WriteFilesUsingMesh(Imm
     WriteFiles();
 }
 
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::WriteBinaryFilesUsingMesh(ImmersedBoundaryMesh<ELEMENT_DIM,SPACE_DIM>& rMesh)
+{
+    assert(SPACE_DIM == 2);
+    namespace format = ImmersedBoundaryBinaryMeshFormat;
+
+    // Gather the nodes and elements, skipping any that are deleted, and the sizes of each section
+    std::vector<Node<SPACE_DIM>*> nodes;
+    nodes.reserve(rMesh.GetNumNodes());
+    unsigned num_node_attributes = UINT_MAX;
+    for (typename AbstractMesh<ELEMENT_DIM,SPACE_DIM>::NodeIterator node_iter = rMesh.GetNodeIteratorBegin();
+         node_iter != rMesh.GetNodeIteratorEnd();
+         ++node_iter)
+    {
+        nodes.push_back(&(*node_iter));
+        num_node_attributes = std::min(num_node_attributes, node_iter->GetNumNodeAttributes());
+    }
+    if (nodes.empty())
+    {
+        num_node_attributes = 0;
+    }
+
+    std::vector<unsigned> element_offsets(1, 0u);
+    std::vector<unsigned> element_node_indices;
+    std::vector<unsigned> element_attributes;
+    element_offsets.reserve(rMesh.GetNumElements() + 1);
+    element_attributes.reserve(rMesh.GetNumElements());
+    unsigned membrane_index = UINT_MAX;
+    for (typename ImmersedBoundaryMesh<ELEMENT_DIM,SPACE_DIM>::ImmersedBoundaryElementIterator elem_iter = rMesh.GetElementIteratorBegin();
+         elem_iter != rMesh.GetElementIteratorEnd();
+         ++elem_iter)
+    {
+        if (elem_iter->GetIndex() == rMesh.GetMembraneIndex())
+        {
+            membrane_index = element_attributes.size();
+        }
+        for (unsigned j = 0; j < elem_iter->GetNumNodes(); j++)
+        {
+            element_node_indices.push_back(elem_iter->GetNodeGlobalIndex(j));
+        }
+        element_offsets.push_back(element_node_indices.size());
+        element_attributes.push_back((unsigned) elem_iter->GetAttribute());
+    }
+
+    const multi_array<double, 3>& vel_grids = rMesh.rGet2dVelocityGrids();
+
+    // Write the header
+    unsigned header[format::NUM_HEADER_FIELDS];
+    header[format::FIELD_VERSION] = format::VERSION;
+    header[format::FIELD_BYTE_ORDER_MARK] = format::BYTE_ORDER_MARK;
+    header[format::FIELD_SPACE_DIM] = SPACE_DIM;
+    header[format::FIELD_NUM_NODES] = nodes.size();
+    header[format::FIELD_NUM_NODE_ATTRIBUTES] = num_node_attributes;
+    header[format::FIELD_NUM_ELEMENTS] = element_attributes.size();
+    header[format::FIELD_NUM_ELEMENT_NODES] = element_node_indices.size();
+    header[format::FIELD_MEMBRANE_INDEX] = membrane_index;
+    header[format::FIELD_NUM_GRID_PTS_X] = rMesh.GetNumGridPtsX();
+    header[format::FIELD_NUM_GRID_PTS_Y] = rMesh.GetNumGridPtsY();
+    double node_spacing = rMesh.GetCharacteristicNodeSpacing();
+
+    std::string file_name = this->mBaseName + ".ibm";
+    out_stream p_file = this->mpOutputFileHandler->OpenOutputFile(file_name, std::ios::out | std::ios::binary);
+    p_file->write(format::MAGIC, sizeof(format::MAGIC));
+    p_file->write(reinterpret_cast<const char*>(header), sizeof(header));
+    p_file->write(reinterpret_cast<const char*>(&node_spacing), sizeof(double));
+
+    // Write the node locations and attributes
+    std::vector<double> node_values;
+    node_values.reserve(nodes.size() * std::max(SPACE_DIM, num_node_attributes));
+    for (unsigned node_idx = 0; node_idx < nodes.size(); node_idx++)
+    {
+        const c_vector<double, SPACE_DIM>& r_location = nodes[node_idx]->rGetLocation();
+        node_values.insert(node_values.end(), r_location.begin(), r_location.end());
+    }
+    p_file->write(reinterpret_cast<const char*>(&node_values[0]), node_values.size() * sizeof(double));
+
+    node_values.clear();
+    for (unsigned node_idx = 0; node_idx < nodes.size() && num_node_attributes > 0; node_idx++)
+    {
+        const std::vector<double>& r_attributes = nodes[node_idx]->rGetNodeAttributes();
+        node_values.insert(node_values.end(), r_attributes.begin(), r_attributes.begin() + num_node_attributes);
+    }
+    if (!node_values.empty())
+    {
+        p_file->write(reinterpret_cast<const char*>(&node_values[0]), node_values.size() * sizeof(double));
+    }
+
+    // The grids are contiguous in memory, in the order the format expects
+    p_file->write(reinterpret_cast<const char*>(vel_grids.data()), vel_grids.num_elements() * sizeof(double));
+
+    // Write the boundary flags and the elements
+    std::vector<unsigned> boundary_flags(nodes.size());
+    for (unsigned node_idx = 0; node_idx < nodes.size(); node_idx++)
+    {
+        boundary_flags[node_idx] = nodes[node_idx]->IsBoundaryNode() ? 1u : 0u;
+    }
+    if (!boundary_flags.empty())
+    {
+        p_file->write(reinterpret_cast<const char*>(&boundary_flags[0]), boundary_flags.size() * sizeof(unsigned));
+    }
+    p_file->write(reinterpret_cast<const char*>(&element_offsets[0]), element_offsets.size() * sizeof(unsigned));
+    if (!element_node_indices.empty())
+    {
+        p_file->write(reinterpret_cast<const char*>(&element_node_indices[0]), element_node_indices.size() * sizeof(unsigned));
+        p_file->write(reinterpret_cast<const char*>(&element_attributes[0]), element_attributes.size() * sizeof(unsigned));
+    }
+
+    p_file->close();
+}
+
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::WriteFiles()
 {
@@ -487,79 +655,58 @@ void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::WriteFiles()
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::CalculateCellOverlaps(ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>& rMesh)
+void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::SetWriteRawBinaryVtk(bool writeRawBinaryVtk)
 {
-    assert(SPACE_DIM == 2);
-
-    // Initialise all vectors to the correct length
-    unsigned num_elem = rMesh.GetNumAllElements();
-    mHOverlaps.resize(num_elem);
-    mVOverlaps.resize(num_elem);
-    mHOverlapPoints.resize(num_elem);
-    mVOverlapPoints.resize(num_elem);
-    mNumCellParts.resize(num_elem);
-
-    // Helper variables
-    c_vector<double, SPACE_DIM> prev_location;
-    c_vector<double, SPACE_DIM> curr_location;
+    mWriteRawBinaryVtk = writeRawBinaryVtk;
+}
 
-    // We loop first over each element to work out which overlap due to periodic boundaries
-    for (typename ImmersedBoundaryMesh<ELEMENT_DIM,SPACE_DIM>::ImmersedBoundaryElementIterator iter = rMesh.GetElementIteratorBegin();
-         iter != rMesh.GetElementIteratorEnd();
-         ++iter)
-    {
-        unsigned elem_idx = iter->GetIndex();
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::GetWriteRawBinaryVtk() const
+{
+    return mWriteRawBinaryVtk;
+}
 
-        // We do not want to treat the membrane as overlapping
-        if (elem_idx == rMesh.GetMembraneIndex())
-        {
-            continue;
-        }
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::SetCompressVtk(bool compressVtk)
+{
+    mCompressVtk = compressVtk;
+}
 
-        unsigned num_nodes = iter->GetNumNodes();
-        assert(num_nodes > 1);
-        prev_location = iter->GetNode(num_nodes - 1)->rGetLocation();
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::GetCompressVtk() const
+{
+    return mCompressVtk;
+}
 
-        for (unsigned node_idx = 0; node_idx < num_nodes; node_idx++)
-        {
-            // Get node, index and location
-            Node<SPACE_DIM>* p_node = iter->GetNode(node_idx);
-            c_vector<double, SPACE_DIM> curr_location = p_node->rGetLocation();
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::CalculateCellOverlaps(ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>& rMesh)
+{
+    mSnapshot.TakeFromMesh(rMesh);
+    CalculateCellOverlaps(mSnapshot);
+}
 
-            if ( fabs (curr_location[0] - prev_location[0]) > 0.5)
-            {
-                mHOverlaps[elem_idx] = true;
-                mHOverlapPoints[elem_idx].push_back(node_idx);
-            }
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ImmersedBoundaryMeshWriter<ELEMENT_DIM, SPACE_DIM>::CalculateCellOverlaps(const ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>& rSnapshot)
+{
+    assert(SPACE_DIM == 2);
 
-            if ( fabs (curr_location[1] - prev_location[1]) > 0.5)
-            {
-                mVOverlaps[elem_idx] = true;
-                mVOverlapPoints[elem_idx].push_back(node_idx);
-            }
-            prev_location = curr_location;
-        }
-    }
+    // The overlaps are maintained incrementally by the mesh, and copied into the snapshot when it is taken
+    const ImmersedBoundaryPeriodicOverlaps<SPACE_DIM>& r_overlaps = rSnapshot.rGetPeriodicOverlaps();
+    unsigned num_elem = rSnapshot.GetNumAllElements();
+    assert(r_overlaps.GetNumElements() == num_elem);
 
-    // We then loop over each element again to determine how many 'cells' we need to split each output element in to
+    mHOverlaps.resize(num_elem);
+    mVOverlaps.resize(num_elem);
+    mHOverlapPoints.resize(num_elem);
+    mVOverlapPoints.resize(num_elem);
     for (unsigned elem_idx = 0; elem_idx < num_elem; elem_idx++)
     {
-        // If no overlap, we only need one cell
-        if (!mHOverlaps[elem_idx] && !mVOverlaps[elem_idx])
-        {
-            mNumCellParts[elem_idx] = 1;
-        }
-        // If only one overlap is false, then we need two cells
-        else if ( mHOverlaps[elem_idx] * mVOverlaps[elem_idx] == 0)
-        {
-            mNumCellParts[elem_idx] = 2;
-        }
-        // The remaining case is there is horizontal and vertical overlap.  We may need either 3 or 4 cells
-        else
-        {
-            mNumCellParts[elem_idx] = 3;
-        }
+        mHOverlapPoints[elem_idx] = r_overlaps.rGetHorizontalOverlapPoints(elem_idx);
+        mVOverlapPoints[elem_idx] = r_overlaps.rGetVerticalOverlapPoints(elem_idx);
+        mHOverlaps[elem_idx] = !mHOverlapPoints[elem_idx].empty();
+        mVOverlaps[elem_idx] = !mVOverlapPoints[elem_idx].empty();
     }
+    mNumCellParts = r_overlaps.rGetNumCellParts();
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
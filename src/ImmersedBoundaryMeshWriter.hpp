@@ -52,9 +52,11 @@ class ImmersedBoundaryMesh;
 #include <vtkUnstructuredGridWriter.h>
 #include <vtkXMLUnstructuredGridWriter.h>
 #include <vtkDataCompressor.h>
+#include <vtkZLibDataCompressor.h>
 #endif //CHASTE_VTK
 
 #include "ImmersedBoundaryMesh.hpp"
+#include "ImmersedBoundaryMeshSnapshot.hpp"
 #include "AbstractMeshWriter.hpp"
 
 // Forward declaration prevents circular include chain
@@ -98,6 +100,15 @@ private:
     /** The index of the basement membrane */
     unsigned mMembraneIndex;
 
+    /** A snapshot of the mesh passed to CalculateCellOverlaps() or WriteVtkUsingMesh(). */
+    ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM> mSnapshot;
+
+    /** Whether VTK files store their data as raw binary appended after the XML.  Defaults to false. */
+    bool mWriteRawBinaryVtk;
+
+    /** Whether VTK files compress their data with zlib.  Defaults to false. */
+    bool mCompressVtk;
+
 #ifdef CHASTE_VTK
 //Requires  "sudo aptitude install libvtk5-dev" or similar
 ///\todo Merge into VtkMeshWriter (#1076)
@@ -130,6 +141,16 @@ public:
      */
     void WriteFilesUsingMesh(ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>& rMesh);
 
+    /**
+     * Write a mesh to a single binary file with extension ".ibm", in the format described by
+     * ImmersedBoundaryBinaryMeshFormat.  Unlike the text files written by WriteFilesUsingMesh(), this holds node
+     * locations, node attributes and the velocity grids at full double precision, and can be read back by an
+     * ImmersedBoundaryMeshReader constructed with readBinary set to true.
+     *
+     * @param rMesh reference to the immersed boundary mesh
+     */
+    void WriteBinaryFilesUsingMesh(ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>& rMesh);
+
     /**
      * Write VTK file using a mesh.
      *
@@ -138,6 +159,14 @@ public:
      */
     void WriteVtkUsingMesh(ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>& rMesh, std::string stamp="");
 
+    /**
+     * Write VTK file using a snapshot of a mesh.  Cell overlaps should have been calculated from the same snapshot.
+     *
+     * @param rSnapshot reference to the snapshot
+     * @param stamp is an optional stamp (like a time-stamp) to put into the name of the file
+     */
+    void WriteVtkUsingSnapshot(const ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>& rSnapshot, std::string stamp="");
+
     /**
      * Populate mpVtkUnstructedMesh using a vertex-based mesh.
      * Called by WriteVtkUsingMesh().
@@ -146,6 +175,14 @@ public:
      */
     void MakeVtkMesh(ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>& rMesh);
 
+    /**
+     * Populate mpVtkUnstructedMesh using a snapshot of a mesh.
+     * Called by WriteVtkUsingSnapshot().
+     *
+     * @param rSnapshot reference to the snapshot
+     */
+    void MakeVtkMesh(const ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>& rSnapshot);
+
     /**
      * Add data to a future VTK file.
      *
@@ -154,6 +191,14 @@ public:
      */
     void AddCellData(std::string dataName, std::vector<double> dataPayload);
 
+    /**
+     * Add every item of cell data in a snapshot to a future VTK file, read in place from the snapshot and repeated for
+     * each part of an element that is broken up for visualisation.
+     *
+     * @param rSnapshot the snapshot, whose cell overlaps have been calculated by CalculateCellOverlaps()
+     */
+    void AddCellData(const ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>& rSnapshot);
+
     /**
      * Add data to a future VTK file.
      *
@@ -178,12 +223,41 @@ public:
      */
     void WriteFiles();
 
+    /**
+     * Set whether VTK files store their data as raw binary appended after the XML, rather than inline as base64 text.
+     * Raw binary files are smaller and faster to write, but are not valid XML.
+     *
+     * @param writeRawBinaryVtk whether to write raw binary
+     */
+    void SetWriteRawBinaryVtk(bool writeRawBinaryVtk);
+
+    /** @return #mWriteRawBinaryVtk */
+    bool GetWriteRawBinaryVtk() const;
+
+    /**
+     * Set whether VTK files compress their data with zlib.
+     *
+     * @param compressVtk whether to compress
+     */
+    void SetCompressVtk(bool compressVtk);
+
+    /** @return #mCompressVtk */
+    bool GetCompressVtk() const;
+
     /**
      * Analyses the mesh to determine which cells overlap due to the periodic boundaries, which is information
      * needed when outputting the mesh.
      */
     void CalculateCellOverlaps(ImmersedBoundaryMesh<ELEMENT_DIM, SPACE_DIM>& rMesh);
 
+    /**
+     * Copy which cells overlap due to the periodic boundaries from a snapshot of a mesh, where they were stored by
+     * ImmersedBoundaryMesh::rGetPeriodicOverlaps() when the snapshot was taken.
+     *
+     * @param rSnapshot reference to the snapshot
+     */
+    void CalculateCellOverlaps(const ImmersedBoundaryMeshSnapshot<ELEMENT_DIM, SPACE_DIM>& rSnapshot);
+
     /**
      * Return a reference to the vector detailing how many cell parts are needed for each element
      */
@@ -0,0 +1,145 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryNodeArrays.hpp"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+
+template<unsigned DIM>
+ImmersedBoundaryNodeArrays<DIM>::ImmersedBoundaryNodeArrays()
+    : mNumAttributes(0),
+      mCurrentElement(UINT_MAX),
+      mPeriods(scalar_vector<double>(DIM, 1.0))
+{
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryNodeArrays<DIM>::SetPeriods(const c_vector<double, DIM>& rPeriods)
+{
+    mPeriods = rPeriods;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryNodeArrays<DIM>::Reset(unsigned numNodes, unsigned numElements, unsigned numAttributes)
+{
+    mNumAttributes = numAttributes;
+    mCurrentElement = UINT_MAX;
+
+    mLocations.clear();
+    mAppliedForces.clear();
+    mAttributes.clear();
+    mNodeIndices.clear();
+    mElementIndices.clear();
+
+    mLocations.reserve(DIM * numNodes);
+    mAppliedForces.reserve(DIM * numNodes);
+    mAttributes.reserve(numAttributes * numNodes);
+    mNodeIndices.reserve(numNodes);
+    mElementIndices.reserve(numNodes);
+
+    mSlotsOfNodes.assign(numNodes, UINT_MAX);
+
+    // Elements not added, such as deleted elements, have no slots
+    mElementBegin.assign(numElements, 0u);
+    mElementEnd.assign(numElements, 0u);
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryNodeArrays<DIM>::BeginElement(unsigned elementIndex)
+{
+    assert(elementIndex < mElementBegin.size());
+    assert(mCurrentElement == UINT_MAX || mCurrentElement < elementIndex);
+
+    mCurrentElement = elementIndex;
+    mElementBegin[elementIndex] = mNodeIndices.size();
+    mElementEnd[elementIndex] = mNodeIndices.size();
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryNodeArrays<DIM>::AddNode(unsigned nodeIndex,
+                                              const c_vector<double, DIM>& rLocation,
+                                              const c_vector<double, DIM>& rAppliedForce,
+                                              const std::vector<double>& rAttributes)
+{
+    // Each node is in exactly one element
+    assert(nodeIndex < mSlotsOfNodes.size());
+    assert(mSlotsOfNodes[nodeIndex] == UINT_MAX);
+    assert(rAttributes.size() >= mNumAttributes);
+
+    assert(mCurrentElement != UINT_MAX);
+
+    mSlotsOfNodes[nodeIndex] = mNodeIndices.size();
+    mNodeIndices.push_back(nodeIndex);
+    mElementIndices.push_back(mCurrentElement);
+    mElementEnd[mCurrentElement]++;
+
+    for (unsigned dim = 0; dim < DIM; dim++)
+    {
+        mLocations.push_back(rLocation[dim]);
+        mAppliedForces.push_back(rAppliedForce[dim]);
+    }
+
+    mAttributes.insert(mAttributes.end(), rAttributes.begin(), rAttributes.begin() + mNumAttributes);
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryNodeArrays<DIM>::ClearAppliedForces()
+{
+    std::fill(mAppliedForces.begin(), mAppliedForces.end(), 0.0);
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryNodeArrays<DIM>::SetNumAttributes(unsigned numAttributes)
+{
+    unsigned num_slots = mNodeIndices.size();
+    unsigned num_kept = std::min(numAttributes, mNumAttributes);
+
+    std::vector<double> attributes(numAttributes * num_slots, 0.0);
+    for (unsigned slot = 0; slot < num_slots; slot++)
+    {
+        std::copy(mAttributes.begin() + mNumAttributes * slot,
+                  mAttributes.begin() + mNumAttributes * slot + num_kept,
+                  attributes.begin() + numAttributes * slot);
+    }
+
+    mAttributes.swap(attributes);
+    mNumAttributes = numAttributes;
+}
+
+// Explicit instantiation
+template class ImmersedBoundaryNodeArrays<1>;
+template class ImmersedBoundaryNodeArrays<2>;
+template class ImmersedBoundaryNodeArrays<3>;
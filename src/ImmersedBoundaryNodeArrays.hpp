@@ -0,0 +1,328 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYNODEARRAYS_HPP_
+#define IMMERSEDBOUNDARYNODEARRAYS_HPP_
+
+#include <cmath>
+#include <vector>
+#include "UblasVectorInclude.hpp"
+#include "ImmersedBoundaryPeriodicGeometry.hpp"
+
+/**
+ * A structure-of-arrays mirror of the Lagrangian state of the nodes in an ImmersedBoundaryMesh, used by the hot loops
+ * (forces, spreading and interpolation) in place of chasing Node pointers.
+ *
+ * Nodes are stored in slots, ordered element by element and, within each element, in the element's node order.  Each
+ * slot holds the node's location, applied force, containing element index, and node attributes.  The mesh builds and
+ * owns the arrays; see ImmersedBoundaryMesh::rGetNodeArrays() for how they are kept consistent with the Node objects.
+ */
+template<unsigned DIM>
+class ImmersedBoundaryNodeArrays
+{
+private:
+
+    /** The node locations, DIM per slot. */
+    std::vector<double> mLocations;
+
+    /** The applied forces, DIM per slot. */
+    std::vector<double> mAppliedForces;
+
+    /** The node attributes, mNumAttributes per slot. */
+    std::vector<double> mAttributes;
+
+    /** The number of attributes stored per node. */
+    unsigned mNumAttributes;
+
+    /** The global index of the node in each slot. */
+    std::vector<unsigned> mNodeIndices;
+
+    /** The global index of the element containing the node in each slot. */
+    std::vector<unsigned> mElementIndices;
+
+    /** The slot of each node, indexed by global node index, or UINT_MAX for a node in no element. */
+    std::vector<unsigned> mSlotsOfNodes;
+
+    /** The first slot of each element, indexed by global element index. */
+    std::vector<unsigned> mElementBegin;
+
+    /** One past the last slot of each element, indexed by global element index. */
+    std::vector<unsigned> mElementEnd;
+
+    /** The element most recently begun with BeginElement(), or UINT_MAX after Reset(). */
+    unsigned mCurrentElement;
+
+    /**
+     * The period of the domain in each dimension, set by the mesh (defaults to the unit square).  This is the domain
+     * size, except in a direction bounded by walls, where it is twice the domain size so that no vector is wrapped.
+     */
+    c_vector<double, DIM> mPeriods;
+
+public:
+
+    /**
+     * Constructor.
+     */
+    ImmersedBoundaryNodeArrays();
+
+    /**
+     * Empty the arrays, ready to add elements in order of their index.
+     *
+     * @param numNodes the number of nodes in the mesh
+     * @param numElements the number of elements in the mesh, including any deleted
+     * @param numAttributes the number of attributes stored per node
+     */
+    void Reset(unsigned numNodes, unsigned numElements, unsigned numAttributes);
+
+    /**
+     * Begin adding the nodes of an element.  Elements must be added in increasing order of index.
+     *
+     * @param elementIndex the global index of the element
+     */
+    void BeginElement(unsigned elementIndex);
+
+    /**
+     * Add a node to the element most recently begun.
+     *
+     * @param nodeIndex the global index of the node
+     * @param rLocation the node location
+     * @param rAppliedForce the applied force on the node
+     * @param rAttributes the node attributes, of which the first mNumAttributes are stored
+     */
+    void AddNode(unsigned nodeIndex,
+                 const c_vector<double, DIM>& rLocation,
+                 const c_vector<double, DIM>& rAppliedForce,
+                 const std::vector<double>& rAttributes);
+
+    /**
+     * Set every applied force to zero.
+     */
+    void ClearAppliedForces();
+
+    /**
+     * Change the number of attributes stored per node, keeping the locations and applied forces.  Attributes already
+     * stored are kept, and any new ones are zero until set through GetAttributes().
+     *
+     * @param numAttributes the number of attributes stored per node
+     */
+    void SetNumAttributes(unsigned numAttributes);
+
+    /**
+     * Set #mPeriods.
+     *
+     * @param rPeriods the period of the domain in each dimension
+     */
+    void SetPeriods(const c_vector<double, DIM>& rPeriods);
+
+    /**
+     * @param dim a dimension
+     * @return the period of the domain in that dimension
+     */
+    double GetPeriod(unsigned dim) const
+    {
+        return mPeriods[dim];
+    }
+
+    /** @return the number of slots */
+    unsigned GetNumSlots() const
+    {
+        return mNodeIndices.size();
+    }
+
+    /** @return the number of nodes, including any without slots */
+    unsigned GetNumNodes() const
+    {
+        return mSlotsOfNodes.size();
+    }
+
+    /** @return the number of elements, including any without slots */
+    unsigned GetNumElements() const
+    {
+        return mElementBegin.size();
+    }
+
+    /** @return #mNumAttributes */
+    unsigned GetNumAttributes() const
+    {
+        return mNumAttributes;
+    }
+
+    /**
+     * @param elementIndex the global index of an element
+     * @return the first slot of the element
+     */
+    unsigned GetElementBegin(unsigned elementIndex) const
+    {
+        return mElementBegin[elementIndex];
+    }
+
+    /**
+     * @param elementIndex the global index of an element
+     * @return one past the last slot of the element
+     */
+    unsigned GetElementEnd(unsigned elementIndex) const
+    {
+        return mElementEnd[elementIndex];
+    }
+
+    /**
+     * @param nodeIndex the global index of a node
+     * @return the slot of the node, or UINT_MAX if it is in no element
+     */
+    unsigned GetSlotOfNode(unsigned nodeIndex) const
+    {
+        return mSlotsOfNodes[nodeIndex];
+    }
+
+    /**
+     * @param slot a slot
+     * @return the global index of the node in the slot
+     */
+    unsigned GetNodeIndex(unsigned slot) const
+    {
+        return mNodeIndices[slot];
+    }
+
+    /**
+     * @param slot a slot
+     * @return the global index of the element containing the node in the slot
+     */
+    unsigned GetElementIndex(unsigned slot) const
+    {
+        return mElementIndices[slot];
+    }
+
+    /**
+     * @param slot a slot
+     * @return pointer to the DIM components of the location in the slot
+     */
+    double* GetLocation(unsigned slot)
+    {
+        return &mLocations[DIM * slot];
+    }
+
+    /**
+     * @param slot a slot
+     * @return const pointer to the DIM components of the location in the slot
+     */
+    const double* GetLocation(unsigned slot) const
+    {
+        return &mLocations[DIM * slot];
+    }
+
+    /**
+     * @param slot a slot
+     * @return the location in the slot, as a vector
+     */
+    c_vector<double, DIM> GetLocationVector(unsigned slot) const
+    {
+        c_vector<double, DIM> location;
+        for (unsigned dim = 0; dim < DIM; dim++)
+        {
+            location[dim] = mLocations[DIM * slot + dim];
+        }
+        return location;
+    }
+
+    /**
+     * Calculate the vector between the nodes in two slots, accounting for periodicity in the same way as
+     * ImmersedBoundaryMesh::GetVectorFromAtoB().
+     *
+     * @param slotA the slot of the first node
+     * @param slotB the slot of the second node
+     * @param pVector filled with the DIM components of the vector from the first node to the second
+     */
+    void GetVectorFromAtoB(unsigned slotA, unsigned slotB, double* pVector) const
+    {
+        const double* p_location_a = &mLocations[DIM * slotA];
+        const double* p_location_b = &mLocations[DIM * slotB];
+        for (unsigned dim = 0; dim < DIM; dim++)
+        {
+            pVector[dim] = ImmersedBoundaryPeriodicGeometry::MinimumImage(p_location_b[dim] - p_location_a[dim], mPeriods[dim]);
+        }
+    }
+
+    /**
+     * @param slot a slot
+     * @return pointer to the DIM components of the applied force in the slot
+     */
+    double* GetAppliedForce(unsigned slot)
+    {
+        return &mAppliedForces[DIM * slot];
+    }
+
+    /**
+     * @param slot a slot
+     * @return const pointer to the DIM components of the applied force in the slot
+     */
+    const double* GetAppliedForce(unsigned slot) const
+    {
+        return &mAppliedForces[DIM * slot];
+    }
+
+    /**
+     * Add a contribution to the applied force in a slot.
+     *
+     * @param slot a slot
+     * @param rForceContribution the contribution
+     */
+    void AddAppliedForceContribution(unsigned slot, const c_vector<double, DIM>& rForceContribution)
+    {
+        for (unsigned dim = 0; dim < DIM; dim++)
+        {
+            mAppliedForces[DIM * slot + dim] += rForceContribution[dim];
+        }
+    }
+
+    /**
+     * @param slot a slot
+     * @return pointer to the attributes of the node in the slot
+     */
+    double* GetAttributes(unsigned slot)
+    {
+        return &mAttributes[mNumAttributes * slot];
+    }
+
+    /**
+     * @param slot a slot
+     * @return const pointer to the attributes of the node in the slot
+     */
+    const double* GetAttributes(unsigned slot) const
+    {
+        return &mAttributes[mNumAttributes * slot];
+    }
+};
+
+#endif /*IMMERSEDBOUNDARYNODEARRAYS_HPP_*/
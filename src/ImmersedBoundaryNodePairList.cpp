@@ -0,0 +1,480 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryNodePairList.hpp"
+#include <cassert>
+#include <algorithm>
+#include <cmath>
+#include <climits>
+
+template<unsigned DIM>
+ImmersedBoundaryNodePairList<DIM>::ImmersedBoundaryNodePairList(double cutoff, double domainWidth, double domainHeight)
+    : mCutoff(cutoff),
+      mDomainSize(scalar_vector<double>(DIM, 1.0)),
+      mNumBuilds(0)
+{
+    assert(cutoff > 0.0);
+    assert(domainWidth > 0.0 && domainHeight > 0.0);
+
+    mDomainSize[0] = domainWidth;
+    if (DIM > 1)
+    {
+        mDomainSize[1] = domainHeight;
+    }
+
+    /*
+     * Comparing each box with half its neighbours finds every pair exactly once, provided the neighbours of a box are
+     * distinct.  With fewer than three boxes along a dimension they wrap onto each other, so a single box is used
+     * along that dimension instead.
+     */
+    mNumBoxesX = cutoff < domainWidth / 3.0 ? (unsigned) floor(domainWidth / cutoff) : 1;
+    mNumBoxesY = (DIM > 1 && cutoff < domainHeight / 3.0) ? (unsigned) floor(domainHeight / cutoff) : 1;
+
+    const int full_half_stencil[4][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}};
+    for (unsigned neighbour = 0; neighbour < 4; neighbour++)
+    {
+        int offset_x = full_half_stencil[neighbour][0];
+        int offset_y = full_half_stencil[neighbour][1];
+        if ((offset_x == 0 || mNumBoxesX > 1) && (offset_y == 0 || mNumBoxesY > 1))
+        {
+            mHalfStencil.push_back(std::make_pair(offset_x, offset_y));
+        }
+    }
+
+    mBoxOffsets.resize(mNumBoxesX * mNumBoxesY + 1);
+    mPairsByBox.resize(mNumBoxesX * mNumBoxesY);
+    mNodesByBox.resize(mNumBoxesX * mNumBoxesY);
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryNodePairList<DIM>::Build(const ImmersedBoundaryNodeArrays<DIM>& rArrays, unsigned numThreads)
+{
+    assert(numThreads > 0);
+    assert(rArrays.GetPeriod(0) == mDomainSize[0]);
+    mNumBuilds++;
+
+    // The bins used by Update() are filled afresh on its next call
+    mBoxOfNode.clear();
+
+    unsigned num_slots = rArrays.GetNumSlots();
+    unsigned num_boxes = mNumBoxesX * mNumBoxesY;
+
+    /*
+     * Two nodes within the cutoff lie in elements whose boxes, inflated by half the cutoff, overlap, and each lies
+     * within the cutoff of the other's element box.  Only nodes satisfying this for some other element are binned.
+     */
+    mBroadPhase.Update(rArrays, 0.5 * mCutoff);
+
+    mSlotIsCandidate.assign(num_slots, false);
+    for (unsigned pair = 0; pair < mBroadPhase.GetNumOverlappingPairs(); pair++)
+    {
+        const std::pair<unsigned, unsigned>& r_elem_pair = mBroadPhase.rGetOverlappingPair(pair);
+        MarkCandidateSlots(rArrays, r_elem_pair.first, r_elem_pair.second);
+        MarkCandidateSlots(rArrays, r_elem_pair.second, r_elem_pair.first);
+    }
+
+    // Bin the candidate slots into boxes with a counting sort, keeping slots within each box in order
+    mBoxOfSlot.resize(num_slots);
+    std::fill(mBoxOffsets.begin(), mBoxOffsets.end(), 0u);
+
+    unsigned num_candidates = 0;
+    for (unsigned slot = 0; slot < num_slots; slot++)
+    {
+        if (!mSlotIsCandidate[slot])
+        {
+            continue;
+        }
+        num_candidates++;
+
+        mBoxOfSlot[slot] = GetBoxOfLocation(rArrays.GetLocation(slot));
+        mBoxOffsets[mBoxOfSlot[slot] + 1]++;
+    }
+
+    for (unsigned box = 0; box < num_boxes; box++)
+    {
+        mBoxOffsets[box + 1] += mBoxOffsets[box];
+    }
+
+    mSlotsByBox.resize(num_candidates);
+    std::vector<unsigned> next_position(mBoxOffsets.begin(), mBoxOffsets.end() - 1);
+    for (unsigned slot = 0; slot < num_slots; slot++)
+    {
+        if (mSlotIsCandidate[slot])
+        {
+            mSlotsByBox[next_position[mBoxOfSlot[slot]]++] = slot;
+        }
+    }
+
+    // Compare each box with itself and, to find each pair once, with the neighbours to its right and above
+    const int num_boxes_x = (int) mNumBoxesX;
+    const int num_boxes_y = (int) mNumBoxesY;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic)
+#endif
+    for (int box = 0; box < (int) num_boxes; box++)
+    {
+        mPairsByBox[box].clear();
+        AddPairsBetweenBoxes(rArrays, box, box);
+
+        int box_x = box / num_boxes_y;
+        int box_y = box % num_boxes_y;
+        for (unsigned neighbour = 0; neighbour < mHalfStencil.size(); neighbour++)
+        {
+            int other_x = (box_x + mHalfStencil[neighbour].first + num_boxes_x) % num_boxes_x;
+            int other_y = (box_y + mHalfStencil[neighbour].second + num_boxes_y) % num_boxes_y;
+            AddPairsBetweenBoxes(rArrays, box, other_x * num_boxes_y + other_y);
+        }
+    }
+
+    mPairs.clear();
+    for (unsigned box = 0; box < num_boxes; box++)
+    {
+        mPairs.insert(mPairs.end(), mPairsByBox[box].begin(), mPairsByBox[box].end());
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryNodePairList<DIM>::Update(const ImmersedBoundaryNodeArrays<DIM>& rArrays,
+                                               const ImmersedBoundaryTopologyChanges& rChanges)
+{
+    assert(rChanges.IsComplete());
+    mNumBuilds++;
+
+    const double squared_cutoff = mCutoff * mCutoff;
+    unsigned num_boxes = mNumBoxesX * mNumBoxesY;
+
+    // Renumber the pairs and bins, dropping any removed nodes
+    const std::vector<unsigned>& r_new_node_indices = rChanges.rGetNewNodeIndices();
+    const std::vector<unsigned>& r_new_element_indices = rChanges.rGetNewElementIndices();
+    if (!r_new_node_indices.empty())
+    {
+        unsigned num_kept = 0;
+        for (unsigned pair = 0; pair < mPairs.size(); pair++)
+        {
+            NodePair renumbered = mPairs[pair];
+            renumbered.mNodeA = r_new_node_indices[renumbered.mNodeA];
+            renumbered.mNodeB = r_new_node_indices[renumbered.mNodeB];
+            renumbered.mElementA = r_new_element_indices[renumbered.mElementA];
+            renumbered.mElementB = r_new_element_indices[renumbered.mElementB];
+
+            if (renumbered.mNodeA != UINT_MAX && renumbered.mNodeB != UINT_MAX)
+            {
+                mPairs[num_kept++] = renumbered;
+            }
+        }
+        mPairs.resize(num_kept);
+
+        if (!mBoxOfNode.empty())
+        {
+            mBoxOfNode.assign(rArrays.GetNumNodes(), UINT_MAX);
+            for (unsigned box = 0; box < num_boxes; box++)
+            {
+                std::vector<unsigned>& r_nodes = mNodesByBox[box];
+                unsigned num_kept_nodes = 0;
+                for (unsigned i = 0; i < r_nodes.size(); i++)
+                {
+                    unsigned new_index = r_new_node_indices[r_nodes[i]];
+                    if (new_index != UINT_MAX)
+                    {
+                        if (new_index >= mBoxOfNode.size())
+                        {
+                            mBoxOfNode.resize(new_index + 1, UINT_MAX);
+                        }
+                        mBoxOfNode[new_index] = box;
+                        r_nodes[num_kept_nodes++] = new_index;
+                    }
+                }
+                r_nodes.resize(num_kept_nodes);
+            }
+        }
+    }
+
+    // Drop the pairs of the changed elements, which are found again below, and of nodes marked as deleted
+    const std::vector<unsigned>& r_changed_elements = rChanges.rGetChangedElements();
+    std::vector<bool> is_changed(rArrays.GetNumElements(), false);
+    for (unsigned i = 0; i < r_changed_elements.size(); i++)
+    {
+        assert(r_changed_elements[i] < rArrays.GetNumElements());
+        is_changed[r_changed_elements[i]] = true;
+    }
+
+    unsigned num_kept = 0;
+    for (unsigned pair = 0; pair < mPairs.size(); pair++)
+    {
+        const NodePair& r_pair = mPairs[pair];
+        bool element_changed = (r_pair.mElementA < is_changed.size() && is_changed[r_pair.mElementA])
+                               || (r_pair.mElementB < is_changed.size() && is_changed[r_pair.mElementB]);
+
+        if (!element_changed
+            && rArrays.GetSlotOfNode(r_pair.mNodeA) != UINT_MAX
+            && rArrays.GetSlotOfNode(r_pair.mNodeB) != UINT_MAX)
+        {
+            mPairs[num_kept++] = r_pair;
+        }
+    }
+    mPairs.resize(num_kept);
+
+    // Bring the bins up to date, moving only the nodes that have changed box
+    if (mBoxOfNode.empty())
+    {
+        for (unsigned box = 0; box < num_boxes; box++)
+        {
+            mNodesByBox[box].clear();
+        }
+    }
+    for (unsigned node_index = 0; node_index < mBoxOfNode.size(); node_index++)
+    {
+        if (mBoxOfNode[node_index] != UINT_MAX
+            && (node_index >= rArrays.GetNumNodes() || rArrays.GetSlotOfNode(node_index) == UINT_MAX))
+        {
+            MoveNodeToBox(node_index, UINT_MAX);
+        }
+    }
+    for (unsigned slot = 0; slot < rArrays.GetNumSlots(); slot++)
+    {
+        MoveNodeToBox(rArrays.GetNodeIndex(slot), GetBoxOfLocation(rArrays.GetLocation(slot)));
+    }
+
+    // Compare the nodes of each changed element with the nodes binned in and around their boxes
+    const int num_boxes_x = (int) mNumBoxesX;
+    const int num_boxes_y = (int) mNumBoxesY;
+    const int num_offsets_x = num_boxes_x > 1 ? 3 : 1;
+    const int num_offsets_y = num_boxes_y > 1 ? 3 : 1;
+    const int first_offset_x = num_boxes_x > 1 ? -1 : 0;
+    const int first_offset_y = num_boxes_y > 1 ? -1 : 0;
+
+    for (unsigned i = 0; i < r_changed_elements.size(); i++)
+    {
+        unsigned elem_a = r_changed_elements[i];
+        for (unsigned slot_a = rArrays.GetElementBegin(elem_a); slot_a < rArrays.GetElementEnd(elem_a); slot_a++)
+        {
+            const double* p_location_a = rArrays.GetLocation(slot_a);
+            int box_x = (int) (mBoxOfNode[rArrays.GetNodeIndex(slot_a)] / mNumBoxesY);
+            int box_y = (int) (mBoxOfNode[rArrays.GetNodeIndex(slot_a)] % mNumBoxesY);
+
+            for (int offset_x = first_offset_x; offset_x < first_offset_x + num_offsets_x; offset_x++)
+            {
+                for (int offset_y = first_offset_y; offset_y < first_offset_y + num_offsets_y; offset_y++)
+                {
+                    int other_x = (box_x + offset_x + num_boxes_x) % num_boxes_x;
+                    int other_y = (box_y + offset_y + num_boxes_y) % num_boxes_y;
+                    const std::vector<unsigned>& r_nodes = mNodesByBox[other_x * num_boxes_y + other_y];
+
+                    for (unsigned j = 0; j < r_nodes.size(); j++)
+                    {
+                        unsigned slot_b = rArrays.GetSlotOfNode(r_nodes[j]);
+                        unsigned elem_b = rArrays.GetElementIndex(slot_b);
+
+                        // Nodes in the same element never interact, and pairs of two changed elements are found once
+                        if (elem_a == elem_b || (is_changed[elem_b] && slot_b < slot_a))
+                        {
+                            continue;
+                        }
+
+                        const double* p_location_b = rArrays.GetLocation(slot_b);
+                        double squared_distance = 0.0;
+                        for (unsigned dim = 0; dim < DIM; dim++)
+                        {
+                            double difference = p_location_b[dim] - p_location_a[dim];
+                            difference -= mDomainSize[dim] * floor(difference / mDomainSize[dim] + 0.5);
+                            squared_distance += difference * difference;
+                        }
+
+                        if (squared_distance < squared_cutoff)
+                        {
+                            NodePair pair;
+                            pair.mNodeA = rArrays.GetNodeIndex(slot_a);
+                            pair.mNodeB = r_nodes[j];
+                            pair.mElementA = elem_a;
+                            pair.mElementB = elem_b;
+                            pair.mSquaredDistance = squared_distance;
+                            mPairs.push_back(pair);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundaryNodePairList<DIM>::GetBoxOfLocation(const double* pLocation) const
+{
+    // The location as a fraction of the domain size, wrapped into [0, 1)
+    double x = pLocation[0] / mDomainSize[0];
+    x -= floor(x);
+    double y = DIM > 1 ? pLocation[1] / mDomainSize[1] : 0.0;
+    y -= floor(y);
+
+    unsigned box_x = std::min((unsigned) (x * mNumBoxesX), mNumBoxesX - 1);
+    unsigned box_y = std::min((unsigned) (y * mNumBoxesY), mNumBoxesY - 1);
+
+    return box_x * mNumBoxesY + box_y;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryNodePairList<DIM>::MoveNodeToBox(unsigned nodeIndex, unsigned box)
+{
+    if (nodeIndex >= mBoxOfNode.size())
+    {
+        mBoxOfNode.resize(nodeIndex + 1, UINT_MAX);
+    }
+
+    unsigned old_box = mBoxOfNode[nodeIndex];
+    if (old_box == box)
+    {
+        return;
+    }
+
+    if (old_box != UINT_MAX)
+    {
+        std::vector<unsigned>& r_old_nodes = mNodesByBox[old_box];
+        std::vector<unsigned>::iterator it = std::find(r_old_nodes.begin(), r_old_nodes.end(), nodeIndex);
+        assert(it != r_old_nodes.end());
+        *it = r_old_nodes.back();
+        r_old_nodes.pop_back();
+    }
+
+    if (box != UINT_MAX)
+    {
+        mNodesByBox[box].push_back(nodeIndex);
+    }
+    mBoxOfNode[nodeIndex] = box;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryNodePairList<DIM>::AddPairsBetweenBoxes(const ImmersedBoundaryNodeArrays<DIM>& rArrays,
+                                                             unsigned boxA,
+                                                             unsigned boxB)
+{
+    const double squared_cutoff = mCutoff * mCutoff;
+    std::vector<NodePair>& r_pairs = mPairsByBox[boxA];
+
+    for (unsigned offset_a = mBoxOffsets[boxA]; offset_a < mBoxOffsets[boxA + 1]; offset_a++)
+    {
+        unsigned slot_a = mSlotsByBox[offset_a];
+        unsigned elem_a = rArrays.GetElementIndex(slot_a);
+        const double* p_location_a = rArrays.GetLocation(slot_a);
+
+        // Within a single box, each pair is considered once
+        unsigned first_offset_b = boxA == boxB ? offset_a + 1 : mBoxOffsets[boxB];
+
+        for (unsigned offset_b = first_offset_b; offset_b < mBoxOffsets[boxB + 1]; offset_b++)
+        {
+            unsigned slot_b = mSlotsByBox[offset_b];
+            unsigned elem_b = rArrays.GetElementIndex(slot_b);
+
+            // Nodes in the same element never interact
+            if (elem_a == elem_b)
+            {
+                continue;
+            }
+
+            // Find the squared distance between the nodes, accounting for periodicity
+            const double* p_location_b = rArrays.GetLocation(slot_b);
+            double squared_distance = 0.0;
+            for (unsigned dim = 0; dim < DIM; dim++)
+            {
+                double difference = p_location_b[dim] - p_location_a[dim];
+                difference -= mDomainSize[dim] * floor(difference / mDomainSize[dim] + 0.5);
+                squared_distance += difference * difference;
+            }
+
+            if (squared_distance < squared_cutoff)
+            {
+                NodePair pair;
+                pair.mNodeA = rArrays.GetNodeIndex(slot_a);
+                pair.mNodeB = rArrays.GetNodeIndex(slot_b);
+                pair.mElementA = elem_a;
+                pair.mElementB = elem_b;
+                pair.mSquaredDistance = squared_distance;
+                r_pairs.push_back(pair);
+            }
+        }
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryNodePairList<DIM>::MarkCandidateSlots(const ImmersedBoundaryNodeArrays<DIM>& rArrays,
+                                                           unsigned elemA,
+                                                           unsigned elemB)
+{
+    for (unsigned slot = rArrays.GetElementBegin(elemA); slot < rArrays.GetElementEnd(elemA); slot++)
+    {
+        // The box of element B is already inflated by half the cutoff
+        if (!mSlotIsCandidate[slot] && mBroadPhase.Contains(elemB, rArrays.GetLocation(slot), 0.5 * mCutoff))
+        {
+            mSlotIsCandidate[slot] = true;
+        }
+    }
+}
+
+template<unsigned DIM>
+double ImmersedBoundaryNodePairList<DIM>::GetCutoff() const
+{
+    return mCutoff;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundaryNodePairList<DIM>::GetNumBoxesX() const
+{
+    return mNumBoxesX;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundaryNodePairList<DIM>::GetNumBoxesY() const
+{
+    return mNumBoxesY;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryNodePairList<DIM>::Restore(const std::vector<NodePair>& rPairs)
+{
+    mNumBuilds++;
+    mPairs = rPairs;
+    mBoxOfNode.clear();
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundaryNodePairList<DIM>::GetNumBuilds() const
+{
+    return mNumBuilds;
+}
+
+// Explicit instantiation
+template class ImmersedBoundaryNodePairList<1>;
+template class ImmersedBoundaryNodePairList<2>;
+template class ImmersedBoundaryNodePairList<3>;
@@ -0,0 +1,254 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYNODEPAIRLIST_HPP_
+#define IMMERSEDBOUNDARYNODEPAIRLIST_HPP_
+
+#include <utility>
+#include <vector>
+#include "ImmersedBoundaryElementBroadPhase.hpp"
+#include "ImmersedBoundaryNodeArrays.hpp"
+#include "ImmersedBoundaryTopologyChanges.hpp"
+
+/**
+ * A compact list of the pairs of nodes, in different elements, lying within a cutoff distance of each other in the
+ * periodic domain, the unit square unless otherwise specified.  This is used in place of the node pairs of a box collection: pairs of nodes in the same
+ * element, which never interact, and pairs further apart than the cutoff are excluded when the list is built, rather
+ * than by each force on every timestep.
+ *
+ * Only nodes lying near the bounding box of some other element are considered.  The bounding boxes of elements,
+ * inflated by half the cutoff, are first compared using an ImmersedBoundaryElementBroadPhase; for each pair of
+ * overlapping boxes, the nodes of each element within the cutoff of the other element's box are marked as
+ * candidates.  Candidate nodes are then binned into boxes at least as wide as the cutoff in each dimension, and each
+ * box is compared with itself and half of its neighbours.  Boxes are processed in parallel, each into its own list, and the lists are concatenated in box
+ * order, so the pairs and their order are the same for any number of threads.
+ *
+ * After division or death the list may instead be updated, using the changes recorded by the mesh.  Every node is
+ * then kept binned by its index, and only the nodes that have changed box are moved between bins; the pairs of the
+ * changed elements are found afresh by comparing their nodes with the bins around them.
+ */
+template<unsigned DIM>
+class ImmersedBoundaryNodePairList
+{
+public:
+
+    /** A pair of nodes in different elements. */
+    struct NodePair
+    {
+        /** The global index of the first node. */
+        unsigned mNodeA;
+
+        /** The global index of the second node. */
+        unsigned mNodeB;
+
+        /** The global index of the element containing the first node. */
+        unsigned mElementA;
+
+        /** The global index of the element containing the second node. */
+        unsigned mElementB;
+
+        /** The squared distance between the nodes when the list was built. */
+        double mSquaredDistance;
+    };
+
+private:
+
+    /** The distance within which pairs of nodes are listed. */
+    double mCutoff;
+
+    /** The period of the domain in each dimension, as for ImmersedBoundaryNodeArrays::GetPeriod(). */
+    c_vector<double, DIM> mDomainSize;
+
+    /** The number of boxes in the x direction; either at least 3, or 1. */
+    unsigned mNumBoxesX;
+
+    /** The number of boxes in the y direction; either at least 3, or 1. */
+    unsigned mNumBoxesY;
+
+    /**
+     * The offsets, in boxes, of the neighbours each box is compared with in Build(), so that every pair of neighbouring
+     * boxes is compared once.  The offsets along a dimension with a single box are zero, and are omitted.
+     */
+    std::vector<std::pair<int, int> > mHalfStencil;
+
+    /** The number of times the list has been built. */
+    unsigned mNumBuilds;
+
+    /** The broad phase used to find which pairs of elements may interact. */
+    ImmersedBoundaryElementBroadPhase<DIM> mBroadPhase;
+
+    /** Whether each slot lies near the bounding box of an element it may interact with. */
+    std::vector<bool> mSlotIsCandidate;
+
+    /** Offsets into #mSlotsByBox of the start of each box, with a final entry of the number of slots. */
+    std::vector<unsigned> mBoxOffsets;
+
+    /** The candidate node array slots, ordered by box. */
+    std::vector<unsigned> mSlotsByBox;
+
+    /** Scratch space recording the box of each slot, stored to avoid reallocation. */
+    std::vector<unsigned> mBoxOfSlot;
+
+    /** The pairs found from each box, stored to avoid reallocation. */
+    std::vector<std::vector<NodePair> > mPairsByBox;
+
+    /** The pairs, in box order. */
+    std::vector<NodePair> mPairs;
+
+    /** The global indices of the nodes binned into each box, used by Update(). */
+    std::vector<std::vector<unsigned> > mNodesByBox;
+
+    /**
+     * The box each node is binned into, indexed by global node index, or UINT_MAX if it is not binned.  Empty until
+     * the first call to Update() after each call to Build().
+     */
+    std::vector<unsigned> mBoxOfNode;
+
+    /**
+     * @param pLocation a location
+     * @return the box containing the location, accounting for periodicity
+     */
+    unsigned GetBoxOfLocation(const double* pLocation) const;
+
+    /**
+     * Helper method for Update().  Move a node from the bin it is in, if any, to another.
+     *
+     * @param nodeIndex the global index of the node
+     * @param box the box to bin the node into, or UINT_MAX to remove it from the bins
+     */
+    void MoveNodeToBox(unsigned nodeIndex, unsigned box);
+
+    /**
+     * Add the pairs between the nodes in two boxes to the list of the first box.
+     *
+     * @param rArrays the node arrays the list is being built from
+     * @param boxA the first box
+     * @param boxB the second box, which may equal the first
+     */
+    void AddPairsBetweenBoxes(const ImmersedBoundaryNodeArrays<DIM>& rArrays, unsigned boxA, unsigned boxB);
+
+    /**
+     * Mark as candidates the nodes of one element lying within the cutoff of the bounding box of another.
+     *
+     * @param rArrays the node arrays the list is being built from
+     * @param elemA the element whose nodes are marked
+     * @param elemB the element whose bounding box is tested
+     */
+    void MarkCandidateSlots(const ImmersedBoundaryNodeArrays<DIM>& rArrays, unsigned elemA, unsigned elemB);
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param cutoff the distance within which pairs of nodes are listed
+     * @param domainWidth the period of the domain in the x direction, which is twice the domain width if the domain is
+     *     bounded by walls in x (defaults to 1.0)
+     * @param domainHeight the period of the domain in the y direction, which is twice the domain height if the domain
+     *     is bounded by walls in y (defaults to 1.0)
+     */
+    ImmersedBoundaryNodePairList(double cutoff, double domainWidth=1.0, double domainHeight=1.0);
+
+    /**
+     * Find all pairs of nodes in different elements within the cutoff distance of each other.
+     *
+     * @param rArrays the node arrays of the mesh
+     * @param numThreads the number of threads to use, which has an effect only when built with OpenMP (defaults to 1)
+     */
+    void Build(const ImmersedBoundaryNodeArrays<DIM>& rArrays, unsigned numThreads=1);
+
+    /**
+     * Update the list after division or death, rather than building it again, and count this as a build.  The pairs
+     * are renumbered, pairs involving a removed node or a changed element are dropped, and the pairs of each changed
+     * element are found from the nodes binned near it.  Since Build() only excludes nodes that cannot lie within the
+     * cutoff of another element, the pairs of the changed elements are exactly those Build() would find; the pairs of
+     * the other elements are kept as they were, as though none of their nodes had moved.  The pairs are no longer in box
+     * order, and GetNumCandidateSlots() and rGetElementBroadPhase() still refer to the last call to Build().
+     *
+     * @param rArrays the node arrays of the mesh, filled since the changes
+     * @param rChanges the changes to the mesh since the list was last built or updated, which must be complete
+     */
+    void Update(const ImmersedBoundaryNodeArrays<DIM>& rArrays, const ImmersedBoundaryTopologyChanges& rChanges);
+
+    /**
+     * Replace the pairs with those of a list built earlier, for instance when restarting from a checkpoint, and count
+     * this as a build.  The boxes and broad phase are left as they were, so GetNumCandidateSlots() and
+     * rGetElementBroadPhase() are only meaningful after the next call to Build().
+     *
+     * @param rPairs the pairs
+     */
+    void Restore(const std::vector<NodePair>& rPairs);
+
+    /** @return #mCutoff */
+    double GetCutoff() const;
+
+    /** @return #mNumBoxesX */
+    unsigned GetNumBoxesX() const;
+
+    /** @return #mNumBoxesY */
+    unsigned GetNumBoxesY() const;
+
+    /** @return #mNumBuilds, counting updates, which forces may use to tell when quantities cached per pair must be recalculated */
+    unsigned GetNumBuilds() const;
+
+    /** @return the number of slots considered when the list was last built */
+    unsigned GetNumCandidateSlots() const
+    {
+        return mSlotsByBox.size();
+    }
+
+    /** @return the broad phase used when the list was last built */
+    const ImmersedBoundaryElementBroadPhase<DIM>& rGetElementBroadPhase() const
+    {
+        return mBroadPhase;
+    }
+
+    /** @return the number of pairs */
+    unsigned GetNumPairs() const
+    {
+        return mPairs.size();
+    }
+
+    /**
+     * @param index the index of a pair
+     * @return the pair
+     */
+    const NodePair& rGetPair(unsigned index) const
+    {
+        return mPairs[index];
+    }
+};
+
+#endif /*IMMERSEDBOUNDARYNODEPAIRLIST_HPP_*/
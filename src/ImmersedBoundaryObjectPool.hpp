@@ -0,0 +1,289 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYOBJECTPOOL_HPP_
+#define IMMERSEDBOUNDARYOBJECTPOOL_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+#include <vector>
+
+/**
+ * An arena from which objects (nodes and elements) are created in large contiguous blocks rather than individually on
+ * the heap.  An object released with Release() is destroyed and its storage kept on a free list, from which the next
+ * object is created, so nodes and elements removed by cell death make room for those created by cell division.  The
+ * storage itself is freed only when the pool is cleared or destroyed.
+ *
+ * Each new block holds at least as many objects as all previous blocks together, so the number of allocations grows
+ * only logarithmically with the number of objects, and Reserve() allows the capacity to be set up front when the
+ * expected growth is known.  Objects never move once created, so pointers to them remain valid.
+ */
+template<class T>
+class ImmersedBoundaryObjectPool
+{
+private:
+
+    /** The blocks of storage. */
+    std::vector<T*> mBlocks;
+
+    /** The number of objects each block can hold. */
+    std::vector<unsigned> mBlockCapacities;
+
+    /** The number of objects created in each block; objects are created in order within each block. */
+    std::vector<unsigned> mBlockSizes;
+
+    /** Storage within the blocks whose objects have been released, reused before any new storage. */
+    std::vector<T*> mFreeList;
+
+    /** The smallest number of objects a new block can hold. */
+    unsigned mMinBlockCapacity;
+
+    /** The total number of objects that the blocks can hold. */
+    unsigned mCapacity;
+
+    /** The total number of objects created. */
+    unsigned mNumObjects;
+
+    /** The pool owns its objects, so is not copyable. */
+    ImmersedBoundaryObjectPool(const ImmersedBoundaryObjectPool&);
+
+    /**
+     * The pool owns its objects, so is not assignable.
+     *
+     * @return a reference to this pool
+     */
+    ImmersedBoundaryObjectPool& operator=(const ImmersedBoundaryObjectPool&);
+
+    /**
+     * Allocate a new block of storage.
+     *
+     * @param capacity the number of objects the block can hold
+     */
+    void AddBlock(unsigned capacity)
+    {
+        mBlocks.push_back(static_cast<T*>(::operator new(capacity * sizeof(T))));
+        mBlockCapacities.push_back(capacity);
+        mBlockSizes.push_back(0u);
+        mCapacity += capacity;
+    }
+
+    /**
+     * @return storage for the next object: released storage if there is any, else the next slot of the last block,
+     *     allocating a new block if the last is full
+     */
+    void* GetNextStorage()
+    {
+        if (!mFreeList.empty())
+        {
+            return mFreeList.back();
+        }
+        if (mBlocks.empty() || mBlockSizes.back() == mBlockCapacities.back())
+        {
+            AddBlock(mCapacity > mMinBlockCapacity ? mCapacity : mMinBlockCapacity);
+        }
+        return mBlocks.back() + mBlockSizes.back();
+    }
+
+    /**
+     * Record that an object has been created in the storage returned by GetNextStorage().
+     *
+     * @param pObject the object
+     * @return pObject
+     */
+    T* Commit(T* pObject)
+    {
+        // The storage is only taken once the constructor has succeeded
+        if (!mFreeList.empty() && pObject == mFreeList.back())
+        {
+            mFreeList.pop_back();
+        }
+        else
+        {
+            mBlockSizes.back()++;
+        }
+        mNumObjects++;
+        return pObject;
+    }
+
+public:
+
+    /**
+     * Constructor.  No storage is allocated until needed.
+     *
+     * @param minBlockCapacity the smallest number of objects a block can hold (defaults to 256)
+     */
+    ImmersedBoundaryObjectPool(unsigned minBlockCapacity=256)
+        : mMinBlockCapacity(minBlockCapacity),
+          mCapacity(0u),
+          mNumObjects(0u)
+    {
+        assert(minBlockCapacity > 0);
+    }
+
+    /**
+     * Destructor.  Destroys every object created by the pool.
+     */
+    ~ImmersedBoundaryObjectPool()
+    {
+        Clear();
+    }
+
+    /**
+     * Create an object using a constructor taking two arguments.
+     *
+     * @param rArg1 the first argument to the constructor
+     * @param rArg2 the second argument to the constructor
+     * @return the new object, owned by the pool
+     */
+    template<typename ARG1, typename ARG2>
+    T* Create(const ARG1& rArg1, const ARG2& rArg2)
+    {
+        return Commit(new (GetNextStorage()) T(rArg1, rArg2));
+    }
+
+    /**
+     * Create an object using a constructor taking three arguments.
+     *
+     * @param rArg1 the first argument to the constructor
+     * @param rArg2 the second argument to the constructor
+     * @param rArg3 the third argument to the constructor
+     * @return the new object, owned by the pool
+     */
+    template<typename ARG1, typename ARG2, typename ARG3>
+    T* Create(const ARG1& rArg1, const ARG2& rArg2, const ARG3& rArg3)
+    {
+        return Commit(new (GetNextStorage()) T(rArg1, rArg2, rArg3));
+    }
+
+    /**
+     * Ensure that a number of further objects can be created without allocating.
+     *
+     * @param numObjects the number of further objects
+     */
+    void Reserve(unsigned numObjects)
+    {
+        unsigned available = mFreeList.size() + (mBlocks.empty() ? 0u : mBlockCapacities.back() - mBlockSizes.back());
+        if (available < numObjects)
+        {
+            unsigned capacity = numObjects > mMinBlockCapacity ? numObjects : mMinBlockCapacity;
+            AddBlock(capacity > mCapacity ? capacity : mCapacity);
+        }
+    }
+
+    /**
+     * Destroy an object created by the pool, keeping its storage for the next object created.
+     *
+     * @param pObject the object, which must be owned by the pool and not already released
+     */
+    void Release(T* pObject)
+    {
+        assert(Owns(pObject));
+        assert(std::find(mFreeList.begin(), mFreeList.end(), pObject) == mFreeList.end());
+
+        pObject->~T();
+        mFreeList.push_back(pObject);
+        mNumObjects--;
+    }
+
+    /**
+     * @param pObject pointer to an object
+     * @return whether the object was created by this pool, whether or not it has since been released
+     */
+    bool Owns(const T* pObject) const
+    {
+        for (unsigned block = 0; block < mBlocks.size(); block++)
+        {
+            if (pObject >= mBlocks[block] && pObject < mBlocks[block] + mBlockSizes[block])
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Destroy every object created by the pool, and free its storage.
+     */
+    void Clear()
+    {
+        // Released objects have already been destroyed
+        std::sort(mFreeList.begin(), mFreeList.end());
+        for (unsigned block = 0; block < mBlocks.size(); block++)
+        {
+            for (unsigned idx = 0; idx < mBlockSizes[block]; idx++)
+            {
+                if (!std::binary_search(mFreeList.begin(), mFreeList.end(), mBlocks[block] + idx))
+                {
+                    mBlocks[block][idx].~T();
+                }
+            }
+            ::operator delete(mBlocks[block]);
+        }
+
+        mBlocks.clear();
+        mBlockCapacities.clear();
+        mBlockSizes.clear();
+        mFreeList.clear();
+        mCapacity = 0u;
+        mNumObjects = 0u;
+    }
+
+    /** @return the number of objects created by the pool and not yet released */
+    unsigned GetNumObjects() const
+    {
+        return mNumObjects;
+    }
+
+    /** @return the number of objects whose storage has been released and awaits reuse */
+    unsigned GetNumFree() const
+    {
+        return mFreeList.size();
+    }
+
+    /** @return the number of objects the pool can hold without allocating further storage */
+    unsigned GetCapacity() const
+    {
+        return mCapacity;
+    }
+
+    /** @return the number of blocks of storage allocated */
+    unsigned GetNumBlocks() const
+    {
+        return mBlocks.size();
+    }
+};
+
+#endif /*IMMERSEDBOUNDARYOBJECTPOOL_HPP_*/
@@ -39,6 +39,7 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 ImmersedBoundaryPalisadeMeshGenerator::ImmersedBoundaryPalisadeMeshGenerator(unsigned numCellsWide, unsigned numNodesPerCell, double ellipseExponent, double cellAspectRatio, double randomYMult, bool membrane)
     : mpMesh(NULL),
+      mpStamper(NULL),
       mNumCellsWide(numCellsWide),
       mNumNodesPerCell(numNodesPerCell),
       mEllipseExponent(ellipseExponent),
@@ -68,11 +69,11 @@ ImmersedBoundaryPalisadeMeshGenerator::ImmersedBoundaryPalisadeMeshGenerator(uns
     }
 
     // Generate a reference superellipse
-    SuperellipseGenerator* p_gen = new SuperellipseGenerator(mNumNodesPerCell, mEllipseExponent, cell_width, cell_height, 0.0, 0.0);
-    std::vector<c_vector<double, 2> > locations = p_gen->GetPointsAsVectors();
+    SuperellipseGenerator gen(mNumNodesPerCell, mEllipseExponent, cell_width, cell_height, 0.0, 0.0);
+    std::vector<c_vector<double, 2> > locations = gen.GetPointsAsVectors();
 
     // Calculate which locations will be the element corners
-    double top_height = p_gen->GetHeightOfTopSurface();
+    double top_height = gen.GetHeightOfTopSurface();
     double bot_height = cell_height - top_height;
 
     if (top_height < 0.5 * cell_height || top_height > cell_height)
@@ -143,9 +144,16 @@ ImmersedBoundaryPalisadeMeshGenerator::ImmersedBoundaryPalisadeMeshGenerator(uns
         EXCEPTION("Apical and basal surfaces are different sizes");
     }
 
-    // Create a vector of immersed boundary elements and vector of nodes
-    std::vector<ImmersedBoundaryElement<2,2>*> ib_elements;
-    std::vector<Node<2>*> nodes;
+    // Each cell is the reference superellipse, shrunk slightly so that neighbouring cells do not touch
+    std::vector<c_vector<double, 2> > template_locations(locations.size());
+    for (unsigned location = 0; location < locations.size(); location++)
+    {
+        template_locations[location] = 0.95 * locations[location];
+    }
+
+    mpStamper = new ImmersedBoundaryMeshStamper(template_locations, 256, 256);
+    mpStamper->SetCornerIndices(corner_indices);
+    mpStamper->SetWrapX(true);
 
     // Helper c_vector for offsets in x and y
     c_vector<double, 2> x_offset = x_unit * cell_width;
@@ -160,80 +168,60 @@ ImmersedBoundaryPalisadeMeshGenerator::ImmersedBoundaryPalisadeMeshGenerator(uns
 
         unsigned num_membrane_nodes = (unsigned)floor(1.0 / node_spacing);
 
-        std::vector<Node<2>*> nodes_this_elem;
-
+        std::vector<c_vector<double, 2> > membrane_locations(num_membrane_nodes);
         for (unsigned mem_node_idx = 0; mem_node_idx < num_membrane_nodes; mem_node_idx++)
         {
-            // Calculate location of node
-            c_vector<double, 2> location = 0.97 * y_offset + ( 0.5 / num_membrane_nodes + double(mem_node_idx) / num_membrane_nodes ) * x_unit;
-
-            // Create the new node
-            nodes.push_back(new Node<2>(mem_node_idx, location, true));
-            nodes_this_elem.push_back(nodes.back());
-        }
-
-        // Create the membrane element
-        ib_elements.push_back(new ImmersedBoundaryElement<2,2>(0, nodes_this_elem));
-
-        // Pass in null corners
-        std::vector<Node<2>*>& r_elem_corners = ib_elements.back()->rGetCornerNodes();
-        for (unsigned corner = 0; corner < 4; corner++)
-        {
-            r_elem_corners.push_back(NULL);
+            membrane_locations[mem_node_idx] = 0.97 * y_offset + ( 0.5 / num_membrane_nodes + double(mem_node_idx) / num_membrane_nodes ) * x_unit;
         }
+        mpStamper->SetMembraneLocations(membrane_locations);
     }
 
+    // The random variation in height is drawn here, in cell order, so the mesh does not depend on the number of threads
     RandomNumberGenerator* p_rand_gen = RandomNumberGenerator::Instance();
 
     for (unsigned cell_idx = 0; cell_idx < mNumCellsWide; cell_idx++)
     {
-        std::vector<Node<2>*> nodes_this_elem;
         double temp_rand = p_rand_gen->ranf();
 
-        for (unsigned location = 0; location < locations.size(); location++)
-        {
-            unsigned node_index = nodes.size();
-            c_vector<double, 2> scaled_location = 0.95 * locations[location] + x_offset * (cell_idx + 0.5);
-
-            scaled_location[0] = fmod(scaled_location[0], 1.0);
-            scaled_location[1] *= (1.0 + temp_rand * mRandomYMult);
-            scaled_location[1] += y_offset[1];
-
-            nodes.push_back(new Node<2>(node_index, scaled_location, true));
-            nodes_this_elem.push_back(nodes.back());
-        }
-
-        ib_elements.push_back(new ImmersedBoundaryElement<2,2>(ib_elements.size(), nodes_this_elem));
+        c_vector<double, 2> scale;
+        scale[0] = 1.0;
+        scale[1] = 1.0 + temp_rand * mRandomYMult;
 
-        // Pass in the correct corners
-        std::vector<Node<2>*>& r_elem_corners = ib_elements.back()->rGetCornerNodes();
-        for (unsigned corner = 0; corner < 4; corner++)
-        {
-            r_elem_corners.push_back(ib_elements.back()->GetNode(corner_indices[corner]));
-        }
-    }
+        c_vector<double, 2> shift;
+        shift[0] = x_offset[0] * (cell_idx + 0.5);
+        shift[1] = y_offset[1];
 
-    // Create a mesh with the nodes and elements vectors
-    if (mMembrane)
-    {
-        mpMesh = new ImmersedBoundaryMesh<2,2>(nodes, ib_elements, 256, 256, 0);
-    }
-    else
-    {
-        mpMesh = new ImmersedBoundaryMesh<2,2>(nodes, ib_elements, 256, 256);
+        mpStamper->AddCell(scale, shift);
     }
 }
 
 ImmersedBoundaryPalisadeMeshGenerator::~ImmersedBoundaryPalisadeMeshGenerator()
 {
     delete mpMesh;
+    delete mpStamper;
 }
 
 ImmersedBoundaryMesh<2,2>* ImmersedBoundaryPalisadeMeshGenerator::GetMesh()
 {
+    if (mpMesh == NULL && mpStamper != NULL)
+    {
+        mpMesh = mpStamper->CreateMesh();
+    }
     return mpMesh;
 }
 
+void ImmersedBoundaryPalisadeMeshGenerator::SetNumThreads(unsigned numThreads)
+{
+    assert(mpStamper != NULL);
+    mpStamper->SetNumThreads(numThreads);
+}
+
+void ImmersedBoundaryPalisadeMeshGenerator::WriteBinaryMeshFile(const std::string& rDirectory, const std::string& rBaseName, bool cleanOutputDirectory)
+{
+    assert(mpStamper != NULL);
+    mpStamper->WriteBinaryMeshFile(rDirectory, rBaseName, cleanOutputDirectory);
+}
+
 void ImmersedBoundaryPalisadeMeshGenerator::SetRandomYMult(double mult)
 {
     assert(fabs(mult) < 1.0);
@@ -0,0 +1,252 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryPerformanceBaseline.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+#include <sys/resource.h>
+#include "CsvWriter.hpp"
+#include "Exception.hpp"
+
+ImmersedBoundaryPerformanceBaseline::ImmersedBoundaryPerformanceBaseline(double throughputTolerance,
+                                                                         double memoryTolerance)
+    : mThroughputTolerance(throughputTolerance),
+      mMemoryTolerance(memoryTolerance)
+{
+    if (throughputTolerance < 0.0 || memoryTolerance < 0.0)
+    {
+        EXCEPTION("Performance tolerances must be non-negative");
+    }
+}
+
+void ImmersedBoundaryPerformanceBaseline::ReadBaselinesFromFile(const std::string& rFileName)
+{
+    std::ifstream file(rFileName.c_str());
+    if (!file.is_open())
+    {
+        EXCEPTION("Could not open baseline file " << rFileName);
+    }
+
+    // Skip the header row
+    std::string line;
+    std::getline(file, line);
+
+    unsigned line_number = 1;
+    while (std::getline(file, line))
+    {
+        line_number++;
+        if (line.empty())
+        {
+            continue;
+        }
+
+        // Each row is the steps per second, then the peak resident set size, then the name of the run
+        std::string::size_type first_comma = line.find(',');
+        std::string::size_type second_comma = line.find(',', first_comma + 1);
+        if (first_comma == std::string::npos || second_comma == std::string::npos || second_comma + 1 == line.size())
+        {
+            EXCEPTION("Line " << line_number << " of baseline file " << rFileName << " does not have three columns");
+        }
+
+        char* p_end;
+        double steps_per_second = strtod(line.c_str(), &p_end);
+        bool valid = (p_end == line.c_str() + first_comma);
+        double peak_rss = strtod(line.c_str() + first_comma + 1, &p_end);
+        valid = valid && (p_end == line.c_str() + second_comma);
+
+        if (!valid)
+        {
+            EXCEPTION("Line " << line_number << " of baseline file " << rFileName << " does not begin with two numbers");
+        }
+
+        SetBaseline(line.substr(second_comma + 1), steps_per_second, peak_rss);
+    }
+}
+
+void ImmersedBoundaryPerformanceBaseline::WriteBaselinesToFile(const std::string& directoryName,
+                                                               const std::string& fileName) const
+{
+    if (mBaselines.empty())
+    {
+        EXCEPTION("There are no baselines to write");
+    }
+
+    std::vector<double> steps_per_second;
+    std::vector<double> peak_rss;
+    std::vector<std::string> names;
+
+    for (std::map<std::string, std::pair<double, double> >::const_iterator it = mBaselines.begin();
+         it != mBaselines.end();
+         ++it)
+    {
+        steps_per_second.push_back(it->second.first);
+        peak_rss.push_back(it->second.second);
+        names.push_back(it->first);
+    }
+
+    // CsvWriter writes the double columns before the string columns
+    std::vector<std::string> headers;
+    headers.push_back("steps_per_second");
+    headers.push_back("peak_rss_mb");
+    headers.push_back("run");
+
+    CsvWriter writer;
+    writer.SetDirectoryName(directoryName);
+    writer.SetFileName(fileName);
+    writer.AddHeaders(headers);
+    writer.AddData(steps_per_second);
+    writer.AddData(peak_rss);
+    writer.AddData(names);
+    writer.WriteDataToFile();
+}
+
+void ImmersedBoundaryPerformanceBaseline::SetBaseline(const std::string& rName, double stepsPerSecond, double peakRss)
+{
+    if (rName.empty() || rName.find(',') != std::string::npos)
+    {
+        EXCEPTION("The name of a run must be non-empty and contain no commas");
+    }
+    if (stepsPerSecond <= 0.0 || peakRss < 0.0)
+    {
+        EXCEPTION("The baseline of run " << rName << " must have positive throughput and non-negative memory use");
+    }
+
+    mBaselines[rName] = std::make_pair(stepsPerSecond, peakRss);
+}
+
+bool ImmersedBoundaryPerformanceBaseline::HasBaseline(const std::string& rName) const
+{
+    return mBaselines.find(rName) != mBaselines.end();
+}
+
+unsigned ImmersedBoundaryPerformanceBaseline::GetNumBaselines() const
+{
+    return mBaselines.size();
+}
+
+double ImmersedBoundaryPerformanceBaseline::GetBaselineStepsPerSecond(const std::string& rName) const
+{
+    std::map<std::string, std::pair<double, double> >::const_iterator it = mBaselines.find(rName);
+    if (it == mBaselines.end())
+    {
+        EXCEPTION("There is no baseline for run " << rName);
+    }
+    return it->second.first;
+}
+
+double ImmersedBoundaryPerformanceBaseline::GetBaselinePeakRss(const std::string& rName) const
+{
+    std::map<std::string, std::pair<double, double> >::const_iterator it = mBaselines.find(rName);
+    if (it == mBaselines.end())
+    {
+        EXCEPTION("There is no baseline for run " << rName);
+    }
+    return it->second.second;
+}
+
+void ImmersedBoundaryPerformanceBaseline::CheckRun(const std::string& rName, double stepsPerSecond, double peakRss) const
+{
+    std::map<std::string, std::pair<double, double> >::const_iterator it = mBaselines.find(rName);
+    if (it == mBaselines.end())
+    {
+        EXCEPTION("There is no baseline for run " << rName << " to check it against; record one on the reference "
+                  << "machine by copying its measured baseline into the stored baselines");
+    }
+
+    if (stepsPerSecond < (1.0 - mThroughputTolerance) * it->second.first)
+    {
+        EXCEPTION("Run " << rName << " simulated " << stepsPerSecond << " steps per second, below its baseline of "
+                  << it->second.first << " by more than " << 100.0 * mThroughputTolerance << "%");
+    }
+
+    // A peak resident set size of zero could not be measured, so is not checked
+    if (peakRss > 0.0 && it->second.second > 0.0 && peakRss > (1.0 + mMemoryTolerance) * it->second.second)
+    {
+        EXCEPTION("Run " << rName << " had a peak resident set size of " << peakRss << " MB, above its baseline of "
+                  << it->second.second << " MB by more than " << 100.0 * mMemoryTolerance << "%");
+    }
+}
+
+double ImmersedBoundaryPerformanceBaseline::GetThroughputTolerance() const
+{
+    return mThroughputTolerance;
+}
+
+double ImmersedBoundaryPerformanceBaseline::GetMemoryTolerance() const
+{
+    return mMemoryTolerance;
+}
+
+bool ImmersedBoundaryPerformanceBaseline::ResetPeakResidentSetSize()
+{
+#ifdef __linux__
+    // Writing 5 to clear_refs sets the peak resident set size, VmHWM, to the current resident set size
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5" << std::flush;
+    return clear_refs.good();
+#else
+    return false;
+#endif
+}
+
+double ImmersedBoundaryPerformanceBaseline::GetPeakResidentSetSize()
+{
+#ifdef __linux__
+    // Unlike the maximum resident set size given by getrusage(), VmHWM is reset by ResetPeakResidentSetSize()
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+        {
+            return strtod(line.c_str() + 6, NULL) / 1024.0;
+        }
+    }
+#endif
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0.0;
+    }
+
+    // Linux reports the peak resident set size in kB, and Mac OS in bytes
+#ifdef __APPLE__
+    return (double) usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return (double) usage.ru_maxrss / 1024.0;
+#endif
+}
@@ -0,0 +1,155 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYPERFORMANCEBASELINE_HPP_
+#define IMMERSEDBOUNDARYPERFORMANCEBASELINE_HPP_
+
+#include <map>
+#include <string>
+#include <utility>
+
+/**
+ * Stored baselines of the throughput and memory use of named simulation runs, against which later runs are checked
+ * for performance regressions.
+ *
+ * Each baseline holds the number of timesteps per second and the peak resident set size of a run.  A run regresses if
+ * its throughput falls below its baseline by more than the throughput tolerance, or its peak resident set size
+ * exceeds its baseline by more than the memory tolerance, each a proportion of the baseline.  Baselines are read
+ * from, and written to, CSV files with a header row and one run per row: steps per second, peak RSS in MB, name.
+ */
+class ImmersedBoundaryPerformanceBaseline
+{
+private:
+
+    /** The steps per second and peak resident set size, in MB, of each run, by name. */
+    std::map<std::string, std::pair<double, double> > mBaselines;
+
+    /** The proportion by which the throughput of a run may fall below its baseline. */
+    double mThroughputTolerance;
+
+    /** The proportion by which the peak resident set size of a run may exceed its baseline. */
+    double mMemoryTolerance;
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param throughputTolerance the proportion by which the throughput of a run may fall below its baseline
+     *     (defaults to 0.2)
+     * @param memoryTolerance the proportion by which the peak resident set size of a run may exceed its baseline
+     *     (defaults to 0.2)
+     */
+    ImmersedBoundaryPerformanceBaseline(double throughputTolerance=0.2, double memoryTolerance=0.2);
+
+    /**
+     * Read baselines from a CSV file, replacing any baselines of the same names.
+     *
+     * @param rFileName the path of the file, relative to the Chaste root directory or absolute
+     */
+    void ReadBaselinesFromFile(const std::string& rFileName);
+
+    /**
+     * Write all the baselines to a CSV file, in the format read by ReadBaselinesFromFile().  Writing the results of
+     * runs on a reference machine to file is how the stored baselines are refreshed.
+     *
+     * @param directoryName the output directory, relative to the test output directory
+     * @param fileName the output file name
+     */
+    void WriteBaselinesToFile(const std::string& directoryName, const std::string& fileName) const;
+
+    /**
+     * Set the baseline of a run, replacing any baseline of the same name.
+     *
+     * @param rName the name of the run
+     * @param stepsPerSecond the number of timesteps simulated per second of wall time
+     * @param peakRss the peak resident set size, in MB
+     */
+    void SetBaseline(const std::string& rName, double stepsPerSecond, double peakRss);
+
+    /**
+     * @param rName the name of the run
+     * @return whether there is a baseline of this name
+     */
+    bool HasBaseline(const std::string& rName) const;
+
+    /** @return the number of baselines */
+    unsigned GetNumBaselines() const;
+
+    /**
+     * @param rName the name of the run
+     * @return the baseline number of timesteps simulated per second of wall time
+     */
+    double GetBaselineStepsPerSecond(const std::string& rName) const;
+
+    /**
+     * @param rName the name of the run
+     * @return the baseline peak resident set size, in MB
+     */
+    double GetBaselinePeakRss(const std::string& rName) const;
+
+    /**
+     * Check a run against its baseline, throwing an exception describing the regression if either its throughput or
+     * its peak resident set size is worse than its baseline by more than the tolerance.  A run without a baseline also
+     * throws, so that a missing baseline cannot pass unnoticed.
+     *
+     * @param rName the name of the run
+     * @param stepsPerSecond the number of timesteps simulated per second of wall time
+     * @param peakRss the peak resident set size, in MB, or zero if it could not be measured, when it is not checked
+     */
+    void CheckRun(const std::string& rName, double stepsPerSecond, double peakRss) const;
+
+    /** @return #mThroughputTolerance */
+    double GetThroughputTolerance() const;
+
+    /** @return #mMemoryTolerance */
+    double GetMemoryTolerance() const;
+
+    /**
+     * Reset the peak resident set size of this process to its current resident set size, so that the peak of a run
+     * can be measured on its own.  This is only possible on Linux.
+     *
+     * @return whether the peak was reset
+     */
+    static bool ResetPeakResidentSetSize();
+
+    /**
+     * @return the peak resident set size of this process since it started or since ResetPeakResidentSetSize() was
+     *     last called, in MB, or zero if it cannot be measured
+     */
+    static double GetPeakResidentSetSize();
+};
+
+#endif /*IMMERSEDBOUNDARYPERFORMANCEBASELINE_HPP_*/
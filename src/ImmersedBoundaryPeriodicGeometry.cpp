@@ -0,0 +1,173 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryPeriodicGeometry.hpp"
+#include "ImmersedBoundaryNodeArrays.hpp"
+
+void ImmersedBoundaryPeriodicGeometry::CalculateEdgeVectors(const double* pLocations,
+                                                            unsigned numNodes,
+                                                            const double* pPeriods,
+                                                            double* pEdgeVectors)
+{
+    if (numNodes == 0)
+    {
+        return;
+    }
+
+    const double period_x = pPeriods[0];
+    const double period_y = pPeriods[1];
+
+    for (unsigned i = 0; i + 1 < numNodes; i++)
+    {
+        pEdgeVectors[2*i] = MinimumImage(pLocations[2*i + 2] - pLocations[2*i], period_x);
+        pEdgeVectors[2*i + 1] = MinimumImage(pLocations[2*i + 3] - pLocations[2*i + 1], period_y);
+    }
+
+    // The last edge closes the polygon
+    unsigned last = numNodes - 1;
+    pEdgeVectors[2*last] = MinimumImage(pLocations[0] - pLocations[2*last], period_x);
+    pEdgeVectors[2*last + 1] = MinimumImage(pLocations[1] - pLocations[2*last + 1], period_y);
+}
+
+void ImmersedBoundaryPeriodicGeometry::CalculateRelativeLocations(const double* pLocations,
+                                                                  unsigned numNodes,
+                                                                  const double* pPeriods,
+                                                                  double* pRelativeLocations)
+{
+    if (numNodes == 0)
+    {
+        return;
+    }
+
+    // The origin is copied, as it is overwritten if the output is the input
+    const double first[2] = {pLocations[0], pLocations[1]};
+    CalculateLocationsRelativeTo(pLocations, numNodes, first, pPeriods, pRelativeLocations);
+}
+
+void ImmersedBoundaryPeriodicGeometry::CalculateLocationsRelativeTo(const double* pLocations,
+                                                                    unsigned numNodes,
+                                                                    const double* pOrigin,
+                                                                    const double* pPeriods,
+                                                                    double* pRelativeLocations)
+{
+    const double period_x = pPeriods[0];
+    const double period_y = pPeriods[1];
+    const double origin_x = pOrigin[0];
+    const double origin_y = pOrigin[1];
+
+    for (unsigned i = 0; i < numNodes; i++)
+    {
+        pRelativeLocations[2*i] = MinimumImage(pLocations[2*i] - origin_x, period_x);
+        pRelativeLocations[2*i + 1] = MinimumImage(pLocations[2*i + 1] - origin_y, period_y);
+    }
+}
+
+void ImmersedBoundaryPeriodicGeometry::CalculateEdgeLengths(const double* pEdgeVectors, unsigned numEdges, double* pEdgeLengths)
+{
+    for (unsigned i = 0; i < numEdges; i++)
+    {
+        pEdgeLengths[i] = sqrt(pEdgeVectors[2*i] * pEdgeVectors[2*i] + pEdgeVectors[2*i + 1] * pEdgeVectors[2*i + 1]);
+    }
+}
+
+double ImmersedBoundaryPeriodicGeometry::CalculateSignedArea(const double* pRelativeLocations, unsigned numNodes)
+{
+    // The first node is at the origin, so the edges to and from it contribute nothing
+    double signed_area = 0.0;
+    for (unsigned i = 0; i + 1 < numNodes; i++)
+    {
+        double signed_area_term = pRelativeLocations[2*i] * pRelativeLocations[2*i + 3]
+                                  - pRelativeLocations[2*i + 1] * pRelativeLocations[2*i + 2];
+        signed_area += 0.5 * signed_area_term;
+    }
+    return signed_area;
+}
+
+double ImmersedBoundaryPeriodicGeometry::CalculatePerimeter(const double* pEdgeLengths, unsigned numEdges)
+{
+    double perimeter = 0.0;
+    for (unsigned i = 0; i < numEdges; i++)
+    {
+        perimeter += pEdgeLengths[i];
+    }
+    return perimeter;
+}
+
+void ImmersedBoundaryPeriodicGeometry::CalculateAreasAndPerimeters(const ImmersedBoundaryNodeArrays<2>& rArrays)
+{
+    unsigned num_elements = rArrays.GetNumElements();
+    mAreas.assign(num_elements, 0.0);
+    mPerimeters.assign(num_elements, 0.0);
+
+    const double periods[2] = {rArrays.GetPeriod(0), rArrays.GetPeriod(1)};
+
+    for (unsigned elem_idx = 0; elem_idx < num_elements; elem_idx++)
+    {
+        unsigned begin = rArrays.GetElementBegin(elem_idx);
+        unsigned num_nodes = rArrays.GetElementEnd(elem_idx) - begin;
+        if (num_nodes == 0)
+        {
+            continue;
+        }
+
+        if (mEdgeLengths.size() < num_nodes)
+        {
+            mRelativeLocations.resize(2 * num_nodes);
+            mEdgeVectors.resize(2 * num_nodes);
+            mEdgeLengths.resize(num_nodes);
+        }
+
+        // The slots of an element are contiguous, so its locations are a single interleaved run
+        const double* p_locations = rArrays.GetLocation(begin);
+
+        CalculateRelativeLocations(p_locations, num_nodes, periods, &mRelativeLocations[0]);
+        CalculateEdgeVectors(p_locations, num_nodes, periods, &mEdgeVectors[0]);
+        CalculateEdgeLengths(&mEdgeVectors[0], num_nodes, &mEdgeLengths[0]);
+
+        // We take the absolute value just in case the nodes were really oriented clockwise
+        mAreas[elem_idx] = fabs(CalculateSignedArea(&mRelativeLocations[0], num_nodes));
+        mPerimeters[elem_idx] = CalculatePerimeter(&mEdgeLengths[0], num_nodes);
+    }
+}
+
+const std::vector<double>& ImmersedBoundaryPeriodicGeometry::rGetAreas() const
+{
+    return mAreas;
+}
+
+const std::vector<double>& ImmersedBoundaryPeriodicGeometry::rGetPerimeters() const
+{
+    return mPerimeters;
+}
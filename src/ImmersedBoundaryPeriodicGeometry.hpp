@@ -0,0 +1,173 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYPERIODICGEOMETRY_HPP_
+#define IMMERSEDBOUNDARYPERIODICGEOMETRY_HPP_
+
+#include <cmath>
+#include <vector>
+
+template<unsigned DIM> class ImmersedBoundaryNodeArrays;
+
+/**
+ * Geometry of closed polygons in a periodic domain, calculated for a whole element, or every element, at once.
+ *
+ * Node locations are read as interleaved (x, y) pairs, as stored by ImmersedBoundaryNodeArrays, so the nodes of an
+ * element are a contiguous run.  Each kernel is a loop over that run with no branches in its body: the minimum image
+ * of a difference is chosen by a select in MinimumImage() rather than by an if, which the compiler can vectorise.
+ * Sums are accumulated in node order, so results do not depend on how the loops are vectorised, and the area and
+ * perimeter of an element are the same whether calculated for one element or for every element at once.
+ *
+ * ImmersedBoundaryMesh::CalculateElementGeometry() gathers the locations of an element's nodes and calculates its
+ * geometry with these kernels.  ImmersedBoundaryMesh::GetVectorFromAtoB() and
+ * ImmersedBoundaryNodeArrays::GetVectorFromAtoB() are thin wrappers around MinimumImage().
+ */
+class ImmersedBoundaryPeriodicGeometry
+{
+private:
+
+    /** The location of each node of the current element relative to its first node, interleaved. */
+    std::vector<double> mRelativeLocations;
+
+    /** The vector along each edge of the current element, interleaved. */
+    std::vector<double> mEdgeVectors;
+
+    /** The length of each edge of the current element. */
+    std::vector<double> mEdgeLengths;
+
+    /** The area of each element, indexed by global element index. */
+    std::vector<double> mAreas;
+
+    /** The perimeter of each element, indexed by global element index. */
+    std::vector<double> mPerimeters;
+
+public:
+
+    /**
+     * The minimum image of the difference between two coordinates in a periodic direction.  If the difference is
+     * more than half the period in magnitude, the period is subtracted from its magnitude.  For coordinates less than
+     * a period apart, this is bitwise the same as the result of the original branching form,
+     * copysign(fabs(difference) - period, -difference).
+     *
+     * @param difference the difference between two coordinates
+     * @param period the period of the domain in that direction
+     * @return the minimum image of the difference
+     */
+    static inline double MinimumImage(double difference, double period)
+    {
+        double wrap = fabs(difference) > 0.5 * period ? period : 0.0;
+        return difference - copysign(wrap, difference);
+    }
+
+    /**
+     * Calculate the vector along each edge of a closed polygon, from each node to the next, with the last edge
+     * joining the last node to the first.
+     *
+     * @param pLocations the interleaved locations of the nodes
+     * @param numNodes the number of nodes
+     * @param pPeriods the period of the domain in each direction
+     * @param pEdgeVectors filled with the interleaved edge vectors, one per node
+     */
+    static void CalculateEdgeVectors(const double* pLocations,
+                                     unsigned numNodes,
+                                     const double* pPeriods,
+                                     double* pEdgeVectors);
+
+    /**
+     * Calculate the location of each node of a polygon relative to its first node.
+     *
+     * @param pLocations the interleaved locations of the nodes
+     * @param numNodes the number of nodes
+     * @param pPeriods the period of the domain in each direction
+     * @param pRelativeLocations filled with the interleaved relative locations
+     */
+    static void CalculateRelativeLocations(const double* pLocations,
+                                           unsigned numNodes,
+                                           const double* pPeriods,
+                                           double* pRelativeLocations);
+
+    /**
+     * Calculate the location of each node of a polygon relative to a given point, such as its centroid.
+     *
+     * @param pLocations the interleaved locations of the nodes
+     * @param numNodes the number of nodes
+     * @param pOrigin the point the locations are taken relative to
+     * @param pPeriods the period of the domain in each direction
+     * @param pRelativeLocations filled with the interleaved relative locations
+     */
+    static void CalculateLocationsRelativeTo(const double* pLocations,
+                                             unsigned numNodes,
+                                             const double* pOrigin,
+                                             const double* pPeriods,
+                                             double* pRelativeLocations);
+
+    /**
+     * @param pEdgeVectors the interleaved edge vectors
+     * @param numEdges the number of edges
+     * @param pEdgeLengths filled with the length of each edge
+     */
+    static void CalculateEdgeLengths(const double* pEdgeVectors, unsigned numEdges, double* pEdgeLengths);
+
+    /**
+     * @param pRelativeLocations the interleaved locations of the nodes of a polygon relative to its first node
+     * @param numNodes the number of nodes
+     * @return the shoelace area of the polygon, positive if the nodes are ordered anticlockwise
+     */
+    static double CalculateSignedArea(const double* pRelativeLocations, unsigned numNodes);
+
+    /**
+     * @param pEdgeLengths the length of each edge of a polygon
+     * @param numEdges the number of edges
+     * @return the perimeter of the polygon
+     */
+    static double CalculatePerimeter(const double* pEdgeLengths, unsigned numEdges);
+
+    /**
+     * Calculate the area and perimeter of every element of a mesh from its node arrays.  Elements without slots,
+     * such as deleted elements, are given zero area and perimeter.  Scratch space is reused from one call to the
+     * next, so no memory is allocated unless elements grow.
+     *
+     * @param rArrays the node arrays
+     */
+    void CalculateAreasAndPerimeters(const ImmersedBoundaryNodeArrays<2>& rArrays);
+
+    /** @return #mAreas */
+    const std::vector<double>& rGetAreas() const;
+
+    /** @return #mPerimeters */
+    const std::vector<double>& rGetPerimeters() const;
+};
+
+#endif /*IMMERSEDBOUNDARYPERIODICGEOMETRY_HPP_*/
@@ -0,0 +1,163 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "ImmersedBoundaryPeriodicOverlaps.hpp"
+#include <cmath>
+
+template<unsigned DIM>
+ImmersedBoundaryPeriodicOverlaps<DIM>::ImmersedBoundaryPeriodicOverlaps()
+    : mAnyElementIsStale(false),
+      mNumElementsLastUpdated(0)
+{
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryPeriodicOverlaps<DIM>::MarkAllStale(unsigned numElements)
+{
+    mElementIsStale.assign(numElements, 1);
+    mHorizontalOverlapPoints.resize(numElements);
+    mVerticalOverlapPoints.resize(numElements);
+    mNumCellParts.resize(numElements);
+    mAnyElementIsStale = true;
+}
+
+template<unsigned DIM>
+void ImmersedBoundaryPeriodicOverlaps<DIM>::Update(const ImmersedBoundaryNodeArrays<DIM>& rNodeArrays, unsigned membraneIndex)
+{
+    mNumElementsLastUpdated = 0;
+    if (!mAnyElementIsStale)
+    {
+        return;
+    }
+
+    assert(DIM == 2);
+    assert(rNodeArrays.GetNumElements() == mElementIsStale.size());
+
+    // Consecutive nodes more than half the period apart lie either side of the periodic boundary
+    const double half_width = 0.5 * rNodeArrays.GetPeriod(0);
+    const double half_height = 0.5 * rNodeArrays.GetPeriod(1);
+
+    for (unsigned elem_idx = 0; elem_idx < mElementIsStale.size(); elem_idx++)
+    {
+        if (!mElementIsStale[elem_idx])
+        {
+            continue;
+        }
+        mElementIsStale[elem_idx] = 0;
+        mNumElementsLastUpdated++;
+
+        std::vector<unsigned>& r_h_points = mHorizontalOverlapPoints[elem_idx];
+        std::vector<unsigned>& r_v_points = mVerticalOverlapPoints[elem_idx];
+        r_h_points.clear();
+        r_v_points.clear();
+
+        // We do not want to treat the membrane (or deleted elements, which have no slots) as overlapping
+        unsigned begin = rNodeArrays.GetElementBegin(elem_idx);
+        unsigned end = rNodeArrays.GetElementEnd(elem_idx);
+        if (elem_idx != membraneIndex && end > begin)
+        {
+            assert(end - begin > 1);
+            const double* p_prev_location = rNodeArrays.GetLocation(end - 1);
+
+            for (unsigned slot = begin; slot < end; slot++)
+            {
+                const double* p_curr_location = rNodeArrays.GetLocation(slot);
+                if (fabs(p_curr_location[0] - p_prev_location[0]) > half_width)
+                {
+                    r_h_points.push_back(slot - begin);
+                }
+                if (fabs(p_curr_location[1] - p_prev_location[1]) > half_height)
+                {
+                    r_v_points.push_back(slot - begin);
+                }
+                p_prev_location = p_curr_location;
+            }
+        }
+
+        // No overlap needs one cell, overlap in one direction two, and overlap in both directions three or four
+        if (r_h_points.empty() && r_v_points.empty())
+        {
+            mNumCellParts[elem_idx] = 1;
+        }
+        else if (r_h_points.empty() || r_v_points.empty())
+        {
+            mNumCellParts[elem_idx] = 2;
+        }
+        else
+        {
+            mNumCellParts[elem_idx] = 3;
+        }
+    }
+
+    mAnyElementIsStale = false;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundaryPeriodicOverlaps<DIM>::GetNumElements() const
+{
+    return mNumCellParts.size();
+}
+
+template<unsigned DIM>
+const std::vector<unsigned>& ImmersedBoundaryPeriodicOverlaps<DIM>::rGetHorizontalOverlapPoints(unsigned elementIndex) const
+{
+    assert(elementIndex < mHorizontalOverlapPoints.size());
+    return mHorizontalOverlapPoints[elementIndex];
+}
+
+template<unsigned DIM>
+const std::vector<unsigned>& ImmersedBoundaryPeriodicOverlaps<DIM>::rGetVerticalOverlapPoints(unsigned elementIndex) const
+{
+    assert(elementIndex < mVerticalOverlapPoints.size());
+    return mVerticalOverlapPoints[elementIndex];
+}
+
+template<unsigned DIM>
+const std::vector<unsigned>& ImmersedBoundaryPeriodicOverlaps<DIM>::rGetNumCellParts() const
+{
+    return mNumCellParts;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundaryPeriodicOverlaps<DIM>::GetNumElementsLastUpdated() const
+{
+    return mNumElementsLastUpdated;
+}
+
+// Explicit instantiation
+template class ImmersedBoundaryPeriodicOverlaps<1>;
+template class ImmersedBoundaryPeriodicOverlaps<2>;
+template class ImmersedBoundaryPeriodicOverlaps<3>;
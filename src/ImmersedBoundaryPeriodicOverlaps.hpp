@@ -0,0 +1,139 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef IMMERSEDBOUNDARYPERIODICOVERLAPS_HPP_
+#define IMMERSEDBOUNDARYPERIODICOVERLAPS_HPP_
+
+#include <vector>
+#include "ImmersedBoundaryNodeArrays.hpp"
+
+/**
+ * A class to record which elements of an immersed boundary mesh overlap the periodic boundaries, and where, so that
+ * each element can be broken into contiguous pieces for visualisation.
+ *
+ * An element overlaps a boundary between two consecutive nodes when they are more than half the domain apart in that
+ * direction.  Whether that is so can only change when one of the element's nodes is wrapped around the domain by
+ * ImmersedBoundaryCellPopulation::UpdateNodeLocations(), which marks the element as stale; Update() then recalculates
+ * only the stale elements.  Any other change to the mesh invalidates the node arrays, which marks every element as
+ * stale when they are rebuilt.
+ */
+template<unsigned DIM>
+class ImmersedBoundaryPeriodicOverlaps
+{
+private:
+
+    /** Whether each element must be recalculated, by element index. */
+    std::vector<unsigned char> mElementIsStale;
+
+    /** Whether any element is stale. */
+    bool mAnyElementIsStale;
+
+    /** The local indices of the nodes at which each element overlaps the left and right boundaries. */
+    std::vector<std::vector<unsigned> > mHorizontalOverlapPoints;
+
+    /** The local indices of the nodes at which each element overlaps the top and bottom boundaries. */
+    std::vector<std::vector<unsigned> > mVerticalOverlapPoints;
+
+    /** The number of pieces each element is broken into for visualisation. */
+    std::vector<unsigned> mNumCellParts;
+
+    /** The number of elements recalculated by the most recent call to Update(). */
+    unsigned mNumElementsLastUpdated;
+
+public:
+
+    /**
+     * Constructor.
+     */
+    ImmersedBoundaryPeriodicOverlaps();
+
+    /**
+     * Mark every element as stale.
+     *
+     * @param numElements the number of elements in the mesh, including any deleted
+     */
+    void MarkAllStale(unsigned numElements);
+
+    /**
+     * Mark one element as stale, because one of its nodes has been wrapped around the domain.  This may be called
+     * from several threads at once.
+     *
+     * @param elementIndex the index of the element
+     */
+    void MarkElementStale(unsigned elementIndex)
+    {
+        assert(elementIndex < mElementIsStale.size());
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+        mElementIsStale[elementIndex] = 1;
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+        mAnyElementIsStale = true;
+    }
+
+    /**
+     * Recalculate the overlaps of every stale element.
+     *
+     * @param rNodeArrays the node arrays of the mesh, which must be up to date
+     * @param membraneIndex the index of the membrane element, which is never treated as overlapping
+     */
+    void Update(const ImmersedBoundaryNodeArrays<DIM>& rNodeArrays, unsigned membraneIndex);
+
+    /** @return the number of elements, including any deleted */
+    unsigned GetNumElements() const;
+
+    /**
+     * @param elementIndex the index of an element
+     * @return the local indices of the nodes at which the element overlaps the left and right boundaries
+     */
+    const std::vector<unsigned>& rGetHorizontalOverlapPoints(unsigned elementIndex) const;
+
+    /**
+     * @param elementIndex the index of an element
+     * @return the local indices of the nodes at which the element overlaps the top and bottom boundaries
+     */
+    const std::vector<unsigned>& rGetVerticalOverlapPoints(unsigned elementIndex) const;
+
+    /** @return the number of pieces each element is broken into for visualisation, by element index */
+    const std::vector<unsigned>& rGetNumCellParts() const;
+
+    /** @return #mNumElementsLastUpdated */
+    unsigned GetNumElementsLastUpdated() const;
+};
+
+#endif /*IMMERSEDBOUNDARYPERIODICOVERLAPS_HPP_*/
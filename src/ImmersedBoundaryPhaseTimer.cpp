@@ -0,0 +1,150 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryPhaseTimer.hpp"
+#include <cassert>
+#include <time.h>
+#include "CsvWriter.hpp"
+#include "Exception.hpp"
+
+ImmersedBoundaryPhaseTimer::ImmersedBoundaryPhaseTimer()
+{
+}
+
+unsigned ImmersedBoundaryPhaseTimer::AddPhase(const std::string& rName)
+{
+    std::map<std::string, unsigned>::iterator it = mPhaseIndices.find(rName);
+    if (it != mPhaseIndices.end())
+    {
+        return it->second;
+    }
+
+    unsigned phase = mPhaseNames.size();
+    mPhaseIndices[rName] = phase;
+    mPhaseNames.push_back(rName);
+    mTotalTimes.push_back(0.0);
+    mNumCalls.push_back(0u);
+    mStartTimes.push_back(0.0);
+    mTraceNames.push_back(ImmersedBoundaryTracer::InternName(rName));
+
+    return phase;
+}
+
+void ImmersedBoundaryPhaseTimer::Reset()
+{
+    for (unsigned phase = 0; phase < mPhaseNames.size(); phase++)
+    {
+        mTotalTimes[phase] = 0.0;
+        mNumCalls[phase] = 0u;
+    }
+}
+
+unsigned ImmersedBoundaryPhaseTimer::GetNumPhases() const
+{
+    return mPhaseNames.size();
+}
+
+unsigned ImmersedBoundaryPhaseTimer::GetPhaseIndex(const std::string& rName) const
+{
+    std::map<std::string, unsigned>::const_iterator it = mPhaseIndices.find(rName);
+    if (it == mPhaseIndices.end())
+    {
+        EXCEPTION("No phase named " + rName + " has been registered");
+    }
+    return it->second;
+}
+
+const std::string& ImmersedBoundaryPhaseTimer::rGetPhaseName(unsigned phase) const
+{
+    assert(phase < mPhaseNames.size());
+    return mPhaseNames[phase];
+}
+
+double ImmersedBoundaryPhaseTimer::GetTotalTime(unsigned phase) const
+{
+    assert(phase < mTotalTimes.size());
+    return mTotalTimes[phase];
+}
+
+unsigned ImmersedBoundaryPhaseTimer::GetNumCalls(unsigned phase) const
+{
+    assert(phase < mNumCalls.size());
+    return mNumCalls[phase];
+}
+
+void ImmersedBoundaryPhaseTimer::WriteDataToFile(const std::string& directoryName, const std::string& fileName) const
+{
+    if (mPhaseNames.empty())
+    {
+        EXCEPTION("No phases have been registered");
+    }
+
+    std::vector<unsigned> num_calls(mNumCalls);
+    std::vector<double> total_times(mTotalTimes);
+    std::vector<double> mean_times(mPhaseNames.size(), 0.0);
+    std::vector<std::string> names(mPhaseNames);
+
+    for (unsigned phase = 0; phase < mPhaseNames.size(); phase++)
+    {
+        if (mNumCalls[phase] > 0)
+        {
+            mean_times[phase] = mTotalTimes[phase] / (double) mNumCalls[phase];
+        }
+    }
+
+    // CsvWriter writes the unsigned columns, then the double columns, then the string columns
+    std::vector<std::string> headers;
+    headers.push_back("calls");
+    headers.push_back("total_time");
+    headers.push_back("mean_time");
+    headers.push_back("phase");
+
+    CsvWriter writer;
+    writer.SetDirectoryName(directoryName);
+    writer.SetFileName(fileName);
+    writer.AddHeaders(headers);
+    writer.AddData(num_calls);
+    writer.AddData(total_times);
+    writer.AddData(mean_times);
+    writer.AddData(names);
+    writer.WriteDataToFile();
+}
+
+double ImmersedBoundaryPhaseTimer::GetWallTime()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + 1e-9 * (double) now.tv_nsec;
+}
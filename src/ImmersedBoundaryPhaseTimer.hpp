@@ -0,0 +1,164 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYPHASETIMER_HPP_
+#define IMMERSEDBOUNDARYPHASETIMER_HPP_
+
+#include <map>
+#include <string>
+#include <vector>
+#include "ImmersedBoundaryTracer.hpp"
+
+/**
+ * Accumulates the wall time spent in, and the number of calls to, each of a number of named phases of a simulation,
+ * such as the steps of the immersed boundary algorithm carried out by ImmersedBoundarySimulationModifier.
+ *
+ * Phases are registered once with AddPhase(), and thereafter referred to by index, so that starting and stopping a
+ * phase costs little more than reading the clock.  A phase may be started while another is running, so sub-phases may
+ * be timed within a phase, but a phase must be stopped before it is started again.
+ *
+ * While ImmersedBoundaryTracer is enabled, each phase timed is also recorded as a span, on the thread that stops it.
+ */
+class ImmersedBoundaryPhaseTimer
+{
+private:
+
+    /** The name of each phase, by index. */
+    std::vector<std::string> mPhaseNames;
+
+    /** The index of each phase, by name. */
+    std::map<std::string, unsigned> mPhaseIndices;
+
+    /** The total wall time, in seconds, spent in each phase. */
+    std::vector<double> mTotalTimes;
+
+    /** The number of times each phase has been stopped. */
+    std::vector<unsigned> mNumCalls;
+
+    /** The wall time at which each phase was last started. */
+    std::vector<double> mStartTimes;
+
+    /** The name of each phase, interned by ImmersedBoundaryTracer. */
+    std::vector<const char*> mTraceNames;
+
+public:
+
+    /**
+     * Default constructor.
+     */
+    ImmersedBoundaryPhaseTimer();
+
+    /**
+     * Register a phase, if no phase of this name has yet been registered.
+     *
+     * @param rName the name of the phase
+     * @return the index of the phase of this name
+     */
+    unsigned AddPhase(const std::string& rName);
+
+    /**
+     * Start timing a phase.
+     *
+     * @param phase the index of the phase
+     */
+    void StartPhase(unsigned phase)
+    {
+        mStartTimes[phase] = GetWallTime();
+    }
+
+    /**
+     * Stop timing a phase, adding the time since it was started to its total.
+     *
+     * @param phase the index of the phase
+     */
+    void StopPhase(unsigned phase)
+    {
+        double stop_time = GetWallTime();
+        mTotalTimes[phase] += stop_time - mStartTimes[phase];
+        mNumCalls[phase]++;
+
+        if (ImmersedBoundaryTracer::IsEnabled())
+        {
+            ImmersedBoundaryTracer::RecordSpan(mTraceNames[phase], "phase", mStartTimes[phase], stop_time);
+        }
+    }
+
+    /**
+     * Reset the total time and number of calls of every phase to zero.  The phases remain registered.
+     */
+    void Reset();
+
+    /** @return the number of phases registered */
+    unsigned GetNumPhases() const;
+
+    /**
+     * @param rName the name of the phase
+     * @return the index of the phase of this name
+     */
+    unsigned GetPhaseIndex(const std::string& rName) const;
+
+    /**
+     * @param phase the index of the phase
+     * @return the name of the phase
+     */
+    const std::string& rGetPhaseName(unsigned phase) const;
+
+    /**
+     * @param phase the index of the phase
+     * @return the total wall time, in seconds, spent in the phase
+     */
+    double GetTotalTime(unsigned phase) const;
+
+    /**
+     * @param phase the index of the phase
+     * @return the number of times the phase has been timed
+     */
+    unsigned GetNumCalls(unsigned phase) const;
+
+    /**
+     * Write the number of calls, total time and mean time per call of every phase to a CSV file, one phase per row.
+     *
+     * @param directoryName the output directory, relative to the test output directory
+     * @param fileName the output file name
+     */
+    void WriteDataToFile(const std::string& directoryName, const std::string& fileName) const;
+
+    /**
+     * @return the current wall time, in seconds, from a monotonic clock
+     */
+    static double GetWallTime();
+};
+
+#endif /*IMMERSEDBOUNDARYPHASETIMER_HPP_*/
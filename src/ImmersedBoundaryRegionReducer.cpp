@@ -0,0 +1,117 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryRegionReducer.hpp"
+#include "Exception.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+ImmersedBoundaryRegionReducer::ImmersedBoundaryRegionReducer(double minX,
+                                                             double maxX,
+                                                             double minY,
+                                                             double maxY,
+                                                             const std::string& rFileName)
+    : AbstractImmersedBoundaryFluidReducer(rFileName),
+      mMinX(minX),
+      mMaxX(maxX),
+      mMinY(minY),
+      mMaxY(maxY),
+      mFirstX(0u),
+      mEndX(0u),
+      mFirstY(0u),
+      mEndY(0u)
+{
+    if (minX > maxX || minY > maxY)
+    {
+        EXCEPTION("The lower bounds of the region must not exceed its upper bounds");
+    }
+}
+
+void ImmersedBoundaryRegionReducer::StartStreaming()
+{
+    if (mMinX < 0.0 || mMaxX > mDomainWidth || mMinY < 0.0 || mMaxY > mDomainHeight)
+    {
+        EXCEPTION("The region must lie in the domain");
+    }
+
+    // Grid point i lies at i h, so the region covers the indices from ceil(min / h) to floor(max / h), excluding N
+    const double recip_spacing_x = mNumGridPtsX / mDomainWidth;
+    const double recip_spacing_y = mNumGridPtsY / mDomainHeight;
+    mFirstX = static_cast<unsigned>(ceil(mMinX * recip_spacing_x));
+    mEndX = std::min(static_cast<unsigned>(floor(mMaxX * recip_spacing_x)) + 1, mNumGridPtsX);
+    mFirstY = static_cast<unsigned>(ceil(mMinY * recip_spacing_y));
+    mEndY = std::min(static_cast<unsigned>(floor(mMaxY * recip_spacing_y)) + 1, mNumGridPtsY);
+    mEndX = std::max(mEndX, mFirstX);
+    mEndY = std::max(mEndY, mFirstY);
+
+    std::vector<std::string> headers;
+    headers.push_back("step");
+    headers.push_back("grid_x");
+    headers.push_back("grid_y");
+    headers.push_back("time");
+    headers.push_back("velocity_x");
+    headers.push_back("velocity_y");
+    mWriter.AddHeaders(headers);
+
+    mWriter.StartStreaming(3, 3, 0, 100, mBinaryOutput);
+}
+
+void ImmersedBoundaryRegionReducer::Reduce(unsigned step, double time, const multi_array<double, 3>& rVelocityGrids)
+{
+    assert(rVelocityGrids.shape()[1] == mNumGridPtsX && rVelocityGrids.shape()[2] == mNumGridPtsY);
+
+    std::vector<unsigned> unsigned_values(3);
+    std::vector<double> double_values(3);
+    unsigned_values[0] = step;
+    double_values[0] = time;
+
+    for (unsigned x = mFirstX; x < mEndX; x++)
+    {
+        unsigned_values[1] = x;
+        for (unsigned y = mFirstY; y < mEndY; y++)
+        {
+            unsigned_values[2] = y;
+            double_values[1] = rVelocityGrids[0][x][y];
+            double_values[2] = rVelocityGrids[1][x][y];
+            mWriter.AppendRow(unsigned_values, double_values);
+        }
+    }
+}
+
+unsigned ImmersedBoundaryRegionReducer::GetNumGridPtsInRegion() const
+{
+    return (mEndX - mFirstX) * (mEndY - mFirstY);
+}
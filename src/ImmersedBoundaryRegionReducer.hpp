@@ -0,0 +1,111 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYREGIONREDUCER_HPP_
+#define IMMERSEDBOUNDARYREGIONREDUCER_HPP_
+
+#include "AbstractImmersedBoundaryFluidReducer.hpp"
+
+/**
+ * A fluid reducer streaming the velocity at the grid points inside a rectangular region of interest of the
+ * domain.  Each row holds the step, the x and y indices of the grid point, the time and the two velocity components.
+ */
+class ImmersedBoundaryRegionReducer : public AbstractImmersedBoundaryFluidReducer
+{
+private:
+
+    /** The lower x bound of the region. */
+    double mMinX;
+
+    /** The upper x bound of the region. */
+    double mMaxX;
+
+    /** The lower y bound of the region. */
+    double mMinY;
+
+    /** The upper y bound of the region. */
+    double mMaxY;
+
+    /** The first grid index inside the region in the x direction, computed by StartStreaming(). */
+    unsigned mFirstX;
+
+    /** One past the last grid index inside the region in the x direction. */
+    unsigned mEndX;
+
+    /** The first grid index inside the region in the y direction. */
+    unsigned mFirstY;
+
+    /** One past the last grid index inside the region in the y direction. */
+    unsigned mEndY;
+
+    /**
+     * Overridden StartStreaming() method.
+     */
+    void StartStreaming();
+
+public:
+
+    /**
+     * Constructor.  The region is the closed rectangle [minX, maxX] x [minY, maxY], which must lie in the domain passed
+     * to Setup().
+     *
+     * @param minX the lower x bound of the region
+     * @param maxX the upper x bound of the region
+     * @param minY the lower y bound of the region
+     * @param maxY the upper y bound of the region
+     * @param rFileName the name of the file the results are streamed to (defaults to "region_velocity.csv")
+     */
+    ImmersedBoundaryRegionReducer(double minX,
+                                  double maxX,
+                                  double minY,
+                                  double maxY,
+                                  const std::string& rFileName="region_velocity.csv");
+
+    /**
+     * Overridden Reduce() method.
+     *
+     * @param step the number of timesteps elapsed
+     * @param time the simulation time
+     * @param rVelocityGrids the velocity grids
+     */
+    void Reduce(unsigned step, double time, const multi_array<double, 3>& rVelocityGrids);
+
+    /**
+     * @return the number of grid points inside the region, once Setup() has been called
+     */
+    unsigned GetNumGridPtsInRegion() const;
+};
+
+#endif /*IMMERSEDBOUNDARYREGIONREDUCER_HPP_*/
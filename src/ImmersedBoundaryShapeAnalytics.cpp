@@ -0,0 +1,360 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryShapeAnalytics.hpp"
+#include "Warnings.hpp"
+
+#include <algorithm>
+#include <cmath>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+ImmersedBoundaryShapeAnalytics::ImmersedBoundaryShapeAnalytics()
+    : mNumThreads(1u),
+      mTortuosity(0.0)
+{
+    mSkewnessAxis[0] = 0.0;
+    mSkewnessAxis[1] = 1.0;
+}
+
+void ImmersedBoundaryShapeAnalytics::Compute(ImmersedBoundaryMesh<2,2>& rMesh)
+{
+    // Bring the node arrays and cached geometry up to date once, so the pass below only reads them
+    const ImmersedBoundaryNodeArrays<2>& r_arrays = rMesh.rGetNodeArrays();
+    rMesh.UpdateElementGeometries();
+
+    ImmersedBoundaryElement<2,2>* p_membrane = rMesh.GetMembraneElement();
+
+    mElementIndices.clear();
+    for (unsigned elem_idx = 0; elem_idx < rMesh.GetNumElements(); elem_idx++)
+    {
+        ImmersedBoundaryElement<2,2>* p_element = rMesh.GetElement(elem_idx);
+        if (!p_element->IsDeleted() && p_element != p_membrane)
+        {
+            mElementIndices.push_back(elem_idx);
+        }
+    }
+
+    unsigned num_rows = mElementIndices.size();
+    mAreas.resize(num_rows);
+    mPerimeters.resize(num_rows);
+    mElongationShapeFactors.resize(num_rows);
+    mSkewnesses.resize(num_rows);
+
+    std::vector<c_vector<double, 2> > centroids(num_rows);
+    for (unsigned row = 0; row < num_rows; row++)
+    {
+        centroids[row] = rMesh.GetCentroidOfElement(mElementIndices[row]);
+    }
+
+    if (mScratch.size() < mNumThreads)
+    {
+        mScratch.resize(mNumThreads);
+    }
+
+    unsigned num_concave_nodes = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(mNumThreads) schedule(dynamic, 16) reduction(+:num_concave_nodes)
+#endif
+    for (int row = 0; row < (int) num_rows; row++)
+    {
+#ifdef _OPENMP
+        SkewnessScratch& r_scratch = mScratch[omp_get_thread_num()];
+#else
+        SkewnessScratch& r_scratch = mScratch[0];
+#endif
+        unsigned elem_idx = mElementIndices[row];
+
+        mAreas[row] = rMesh.GetVolumeOfElement(elem_idx);
+        mPerimeters[row] = rMesh.GetSurfaceAreaOfElement(elem_idx);
+
+        // As in ImmersedBoundaryMesh::GetElongationShapeFactorOfElement()
+        c_vector<double, 3> moments = rMesh.CalculateMomentsOfElement(elem_idx);
+        double discriminant = sqrt((moments(0) - moments(1))*(moments(0) - moments(1)) + 4.0*moments(2)*moments(2));
+        double largest_eigenvalue = (moments(0) + moments(1) + discriminant)*0.5;
+        double smallest_eigenvalue = (moments(0) + moments(1) - discriminant)*0.5;
+        mElongationShapeFactors[row] = sqrt(largest_eigenvalue/smallest_eigenvalue);
+
+        mSkewnesses[row] = CalculateSkewness(r_arrays, elem_idx, mAreas[row], centroids[row], r_scratch, num_concave_nodes);
+    }
+
+    // As in ImmersedBoundaryMesh::GetSkewnessOfElementMassDistributionAboutAxis(), the warning is serialised
+    if (num_concave_nodes > 0)
+    {
+#ifdef _OPENMP
+#pragma omp critical(ImmersedBoundaryWarnings)
+#endif
+        {
+            WARN_ONCE_ONLY("Axis intersects polygon more than 2 times (concavity) - check element is fairly convex.");
+        }
+    }
+
+    // As in ImmersedBoundaryMesh::GetTortuosityOfMesh(), from the centroids of successive elements
+    mTortuosity = 0.0;
+    if (num_rows > 0)
+    {
+        double total_length = 0.0;
+        for (unsigned row = 1; row < num_rows; row++)
+        {
+            total_length += norm_2(rMesh.GetVectorFromAtoB(centroids[row - 1], centroids[row]));
+        }
+
+        double straight_line_length = norm_2(rMesh.GetVectorFromAtoB(centroids[0], centroids[num_rows - 1]));
+        // The elements span the periodic domain in x, so the line between the end elements may instead wrap around
+        straight_line_length = std::max(straight_line_length, rMesh.GetDomainWidth() - straight_line_length);
+
+        mTortuosity = total_length / straight_line_length;
+    }
+}
+
+double ImmersedBoundaryShapeAnalytics::CalculateSkewness(const ImmersedBoundaryNodeArrays<2>& rArrays,
+                                                         unsigned elementIndex,
+                                                         double area,
+                                                         const c_vector<double, 2>& rCentroid,
+                                                         SkewnessScratch& rScratch,
+                                                         unsigned& rNumConcaveNodes) const
+{
+    unsigned begin = rArrays.GetElementBegin(elementIndex);
+    unsigned num_nodes = rArrays.GetElementEnd(elementIndex) - begin;
+
+    std::vector<c_vector<double, 2> >& r_rotated = rScratch.mRotatedLocations;
+    std::vector<std::pair<double, unsigned> >& r_ordered = rScratch.mOrderedNodes;
+    std::vector<double>& r_mass_contributions = rScratch.mMassContributions;
+    r_rotated.resize(num_nodes);
+    r_ordered.resize(num_nodes);
+    r_mass_contributions.resize(num_nodes);
+
+    // Translate the centroid to the origin and rotate so the axis is vertical
+    c_vector<double, 2> unit_axis = mSkewnessAxis / norm_2(mSkewnessAxis);
+    double sin_theta = unit_axis[0];
+    double cos_theta = unit_axis[1];
+
+    for (unsigned local_idx = 0; local_idx < num_nodes; local_idx++)
+    {
+        const double* p_location = rArrays.GetLocation(begin + local_idx);
+
+        double displacement[2];
+        for (unsigned dim = 0; dim < 2; dim++)
+        {
+            double period = rArrays.GetPeriod(dim);
+            displacement[dim] = p_location[dim] - rCentroid[dim];
+            if (fabs(displacement[dim]) > 0.5 * period)
+            {
+                displacement[dim] = copysign(fabs(displacement[dim]) - period, -displacement[dim]);
+            }
+        }
+
+        r_rotated[local_idx][0] = cos_theta * displacement[0] - sin_theta * displacement[1];
+        r_rotated[local_idx][1] = sin_theta * displacement[0] + cos_theta * displacement[1];
+        r_ordered[local_idx] = std::make_pair(r_rotated[local_idx][0], local_idx);
+    }
+
+    std::sort(r_ordered.begin(), r_ordered.end());
+
+    /*
+     * The mass at each ordered node is the length of the intersection of the vertical through it with the element,
+     * which only needs the lowest and highest points where the vertical meets the boundary, so these are tracked in
+     * place of the list of every intersection.
+     */
+    for (unsigned location = 0; location < num_nodes; location++)
+    {
+        unsigned this_idx = r_ordered[location].second;
+        const c_vector<double, 2>& r_this_location = r_rotated[this_idx];
+
+        unsigned num_knots = 1;
+        double lowest_knot = r_this_location[1];
+        double highest_knot = r_this_location[1];
+
+        c_vector<double, 2> to_previous = r_rotated[(this_idx + 1) % num_nodes] - r_this_location;
+        for (unsigned node_idx = this_idx + 2; node_idx < this_idx + num_nodes; node_idx++)
+        {
+            c_vector<double, 2> to_next = r_rotated[node_idx % num_nodes] - r_this_location;
+
+            if (to_previous[0] * to_next[0] <= 0.0)
+            {
+                double interp = to_previous[0] / (to_previous[0] - to_next[0]);
+                assert(interp >= 0.0 && interp <= 1.0);
+
+                double new_intersection = r_this_location[1] + to_previous[1] + interp * (to_next[1] - to_previous[1]);
+                lowest_knot = std::min(lowest_knot, new_intersection);
+                highest_knot = std::max(highest_knot, new_intersection);
+                num_knots++;
+            }
+
+            to_previous = to_next;
+        }
+
+        if (num_knots > 2)
+        {
+            rNumConcaveNodes++;
+        }
+
+        // Normalise, so that these lengths define a pdf
+        r_mass_contributions[location] = num_knots > 1 ? (highest_knot - lowest_knot) / area : 0.0;
+    }
+
+    // The pdf is piecewise linear, so its moments are integrated exactly
+    double e_x0 = 0.0;
+    double e_x1 = 0.0;
+    double e_x2 = 0.0;
+    double e_x3 = 0.0;
+
+    for (unsigned i = 1; i < num_nodes; i++)
+    {
+        double x0 = r_ordered[i-1].first;
+        double x1 = r_ordered[i].first;
+
+        if (x1 - x0 > 0)
+        {
+            double fx0 = r_mass_contributions[i-1];
+            double fx1 = r_mass_contributions[i];
+
+            double x0_2 = x0 * x0;
+            double x0_3 = x0_2 * x0;
+            double x0_4 = x0_3 * x0;
+            double x0_5 = x0_4 * x0;
+
+            double x1_2 = x1 * x1;
+            double x1_3 = x1_2 * x1;
+            double x1_4 = x1_3 * x1;
+            double x1_5 = x1_4 * x1;
+
+            // Calculate y = mx + c for this section of the pdf
+            double m = (fx1 - fx0) / (x1 - x0);
+            double c = fx0 - m * x0;
+
+            e_x0 += m * (x1_2 - x0_2) / 2.0 + c * (x1 - x0);
+            e_x1 += m * (x1_3 - x0_3) / 3.0 + c * (x1_2 - x0_2) / 2.0;
+            e_x2 += m * (x1_4 - x0_4) / 4.0 + c * (x1_3 - x0_3) / 3.0;
+            e_x3 += m * (x1_5 - x0_5) / 5.0 + c * (x1_4 - x0_4) / 4.0;
+        }
+    }
+
+    // Check that we have correctly defined a pdf
+    assert(fabs(e_x0 - 1.0) < 1e-6);
+
+    double sd = sqrt(e_x2 - e_x1 * e_x1);
+    return (e_x3 - 3.0 * e_x1 * sd * sd - e_x1 * e_x1 * e_x1) / (sd * sd * sd);
+}
+
+void ImmersedBoundaryShapeAnalytics::StartStreaming(CsvWriter& rWriter, bool binary) const
+{
+    std::vector<std::string> headers;
+    headers.push_back("step");
+    headers.push_back("element");
+    headers.push_back("area");
+    headers.push_back("perimeter");
+    headers.push_back("elongation_shape_factor");
+    headers.push_back("skewness");
+    rWriter.AddHeaders(headers);
+
+    rWriter.StartStreaming(2, 4, 0, 100, binary);
+}
+
+void ImmersedBoundaryShapeAnalytics::AppendRows(CsvWriter& rWriter, unsigned step) const
+{
+    std::vector<unsigned> unsigned_values(2);
+    std::vector<double> double_values(4);
+
+    unsigned_values[0] = step;
+    for (unsigned row = 0; row < mElementIndices.size(); row++)
+    {
+        unsigned_values[1] = mElementIndices[row];
+        double_values[0] = mAreas[row];
+        double_values[1] = mPerimeters[row];
+        double_values[2] = mElongationShapeFactors[row];
+        double_values[3] = mSkewnesses[row];
+        rWriter.AppendRow(unsigned_values, double_values);
+    }
+}
+
+void ImmersedBoundaryShapeAnalytics::SetSkewnessAxis(const c_vector<double, 2>& rSkewnessAxis)
+{
+    assert(norm_2(rSkewnessAxis) > 0.0);
+    mSkewnessAxis = rSkewnessAxis;
+}
+
+const c_vector<double, 2>& ImmersedBoundaryShapeAnalytics::rGetSkewnessAxis() const
+{
+    return mSkewnessAxis;
+}
+
+void ImmersedBoundaryShapeAnalytics::SetNumThreads(unsigned numThreads)
+{
+    assert(numThreads > 0);
+    mNumThreads = numThreads;
+}
+
+unsigned ImmersedBoundaryShapeAnalytics::GetNumThreads() const
+{
+    return mNumThreads;
+}
+
+unsigned ImmersedBoundaryShapeAnalytics::GetNumRows() const
+{
+    return mElementIndices.size();
+}
+
+const std::vector<unsigned>& ImmersedBoundaryShapeAnalytics::rGetElementIndices() const
+{
+    return mElementIndices;
+}
+
+const std::vector<double>& ImmersedBoundaryShapeAnalytics::rGetAreas() const
+{
+    return mAreas;
+}
+
+const std::vector<double>& ImmersedBoundaryShapeAnalytics::rGetPerimeters() const
+{
+    return mPerimeters;
+}
+
+const std::vector<double>& ImmersedBoundaryShapeAnalytics::rGetElongationShapeFactors() const
+{
+    return mElongationShapeFactors;
+}
+
+const std::vector<double>& ImmersedBoundaryShapeAnalytics::rGetSkewnesses() const
+{
+    return mSkewnesses;
+}
+
+double ImmersedBoundaryShapeAnalytics::GetTortuosity() const
+{
+    return mTortuosity;
+}
@@ -0,0 +1,202 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYSHAPEANALYTICS_HPP_
+#define IMMERSEDBOUNDARYSHAPEANALYTICS_HPP_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "UblasVectorInclude.hpp"
+#include "CsvWriter.hpp"
+#include "ImmersedBoundaryMesh.hpp"
+
+/**
+ * Computes the shape metrics of every element of a 2D immersed boundary mesh in a single pass, as a table with a row
+ * per element, for output alongside a simulation.
+ *
+ * The metrics are those of ImmersedBoundaryMesh::GetVolumeOfElement(), GetSurfaceAreaOfElement(),
+ * GetElongationShapeFactorOfElement() and GetSkewnessOfElementMassDistributionAboutAxis(), together with the
+ * tortuosity of the mesh as given by GetTortuosityOfMesh().  The areas, perimeters, centroids and moments are read
+ * from the mesh's cached element geometry, which is brought up to date once before the pass, and node locations are
+ * read from its node arrays.  Elements are processed in parallel, each thread reusing its own scratch space from one
+ * call to the next, so that after the first call no memory is allocated unless elements grow.
+ *
+ * Deleted elements, and the membrane element, have no row.
+ */
+class ImmersedBoundaryShapeAnalytics
+{
+private:
+
+    /** Scratch space used by one thread to calculate the skewness of an element, stored to avoid reallocation. */
+    struct SkewnessScratch
+    {
+        /** The node locations of the element relative to its centroid, rotated so the axis is vertical. */
+        std::vector<c_vector<double, 2> > mRotatedLocations;
+
+        /** The rotated x-coordinate and local index of each node, in ascending order of x-coordinate. */
+        std::vector<std::pair<double, unsigned> > mOrderedNodes;
+
+        /** The length of the intersection of the vertical through each ordered node with the element. */
+        std::vector<double> mMassContributions;
+    };
+
+    /** The axis the skewness of each element is calculated about.  Initialised to the y axis in the constructor. */
+    c_vector<double, 2> mSkewnessAxis;
+
+    /** The number of threads used to compute the metrics.  Initialised to 1 in the constructor. */
+    unsigned mNumThreads;
+
+    /** The scratch space of each thread. */
+    std::vector<SkewnessScratch> mScratch;
+
+    /** The index of the element of each row. */
+    std::vector<unsigned> mElementIndices;
+
+    /** The area of the element of each row. */
+    std::vector<double> mAreas;
+
+    /** The perimeter of the element of each row. */
+    std::vector<double> mPerimeters;
+
+    /** The elongation shape factor of the element of each row. */
+    std::vector<double> mElongationShapeFactors;
+
+    /** The skewness of the mass distribution of the element of each row about #mSkewnessAxis. */
+    std::vector<double> mSkewnesses;
+
+    /** The tortuosity of the mesh. */
+    double mTortuosity;
+
+    /**
+     * Calculate the skewness of the mass distribution of an element about #mSkewnessAxis, exactly as
+     * ImmersedBoundaryMesh::GetSkewnessOfElementMassDistributionAboutAxis() does.
+     *
+     * @param rArrays the node arrays of the mesh
+     * @param elementIndex the index of the element
+     * @param area the area of the element
+     * @param rCentroid the centroid of the element
+     * @param rScratch the scratch space of the calling thread
+     * @param rNumConcaveNodes incremented by the number of nodes whose vertical meets the element more than twice
+     * @return the skewness
+     */
+    double CalculateSkewness(const ImmersedBoundaryNodeArrays<2>& rArrays,
+                             unsigned elementIndex,
+                             double area,
+                             const c_vector<double, 2>& rCentroid,
+                             SkewnessScratch& rScratch,
+                             unsigned& rNumConcaveNodes) const;
+
+public:
+
+    /**
+     * Constructor.
+     */
+    ImmersedBoundaryShapeAnalytics();
+
+    /**
+     * Compute the metrics of every element of a mesh, replacing those computed before.
+     *
+     * @param rMesh the mesh
+     */
+    void Compute(ImmersedBoundaryMesh<2,2>& rMesh);
+
+    /**
+     * Start streaming the table to a CSV writer, whose directory and file name must have been set.  Each row holds the
+     * output step, the element index, then the area, perimeter, elongation shape factor and skewness.
+     *
+     * @param rWriter the writer
+     * @param binary whether to stream to a binary file (see CsvWriter::StartStreaming()) (defaults to false)
+     */
+    void StartStreaming(CsvWriter& rWriter, bool binary=false) const;
+
+    /**
+     * Append the rows of the table to a writer set up with StartStreaming().
+     *
+     * @param rWriter the writer
+     * @param step the output step, written in the first column of each row
+     */
+    void AppendRows(CsvWriter& rWriter, unsigned step) const;
+
+    /**
+     * Set #mSkewnessAxis.
+     *
+     * @param rSkewnessAxis the axis the skewness of each element is calculated about
+     */
+    void SetSkewnessAxis(const c_vector<double, 2>& rSkewnessAxis);
+
+    /**
+     * @return #mSkewnessAxis
+     */
+    const c_vector<double, 2>& rGetSkewnessAxis() const;
+
+    /**
+     * Set #mNumThreads.  The metrics are identical whatever the number of threads.
+     *
+     * @param numThreads the number of threads used to compute the metrics
+     */
+    void SetNumThreads(unsigned numThreads);
+
+    /**
+     * @return #mNumThreads
+     */
+    unsigned GetNumThreads() const;
+
+    /**
+     * @return the number of rows of the table
+     */
+    unsigned GetNumRows() const;
+
+    /** @return #mElementIndices */
+    const std::vector<unsigned>& rGetElementIndices() const;
+
+    /** @return #mAreas */
+    const std::vector<double>& rGetAreas() const;
+
+    /** @return #mPerimeters */
+    const std::vector<double>& rGetPerimeters() const;
+
+    /** @return #mElongationShapeFactors */
+    const std::vector<double>& rGetElongationShapeFactors() const;
+
+    /** @return #mSkewnesses */
+    const std::vector<double>& rGetSkewnesses() const;
+
+    /** @return #mTortuosity */
+    double GetTortuosity() const;
+};
+
+#endif /*IMMERSEDBOUNDARYSHAPEANALYTICS_HPP_*/
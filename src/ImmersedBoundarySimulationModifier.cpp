@@ -42,7 +42,21 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //#include "FileFinder.hpp"
 //#include <fftw3.h>
 //#include <boost/thread.hpp>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <map>
+#include <sstream>
 #include "FluidSource.hpp"
+#include "PetscTools.hpp"
+#include "ImmersedBoundaryStripPartition.hpp"
+#include "ImmersedBoundaryTracer.hpp"
+
+template<unsigned DIM>
+const double ImmersedBoundarySimulationModifier<DIM>::mTimestepGrowthLimit = 1.5;
+
+template<unsigned DIM>
+const double ImmersedBoundarySimulationModifier<DIM>::mTimestepChangeThreshold = 0.1;
 
 template<unsigned DIM>
 ImmersedBoundarySimulationModifier<DIM>::ImmersedBoundarySimulationModifier()
@@ -50,569 +64,2393 @@ ImmersedBoundarySimulationModifier<DIM>::ImmersedBoundarySimulationModifier()
       mpMesh(NULL),
       mpCellPopulation(NULL),
       mNodeNeighbourUpdateFrequency(1u),
+      mNeighbourSkin(0.0),
+      mNumNodePairCalculations(0u),
+      mNumNodesAtLastNodePairCalculation(0u),
+      mNumElementsAtLastNodePairCalculation(0u),
+      mNumReMeshesAtLastNodePairCalculation(0u),
+      mNumNeighbourThreads(1u),
+      mUseIncrementalNodePairUpdates(false),
+      mNumIncrementalNodePairUpdates(0u),
       mNumGridPtsX(0u),
       mNumGridPtsY(0u),
       mGridSpacingX(0.0),
       mGridSpacingY(0.0),
       mFftNorm(0.0),
-      mpBoxCollection(NULL),
+      mWallsX(false),
+      mWallsY(false),
+      mpNodePairList(NULL),
       mReynoldsNumber(1e-4),
       mI(0.0, 1.0),
       mpArrays(NULL),
-      mpFftInterface(NULL)
+      mpSinglePrecisionArrays(NULL),
+      mpFftInterface(NULL),
+      mNumFftThreads(1u),
+      mpSharedFftInterface(NULL),
+      mUseFastStartFftPlanning(false),
+      mNumSpreadingThreads(1u),
+      mNumTaskGraphThreads(1u),
+      mTaskGraphReady(false),
+      mReorderFrequency(0u),
+      mReorderAlongHilbertCurve(true),
+      mRemeshFrequency(0u),
+      mRemeshTargetNodeSpacing(0.0),
+      mStorePressureGrid(false),
+      mUseSinglePrecisionFluid(false),
+      mUseLowMemoryGrids(false),
+      mUseAdaptiveTimestep(false),
+      mCflNumber(0.25),
+      mMinTimestep(0.0),
+      mMaxTimestep(0.0),
+      mTimestepAdaptationInterval(1u),
+      mTimeStepsElapsedOffset(0u),
+      mTimingOutputFrequency(0u),
+      mOutputDirectory(""),
+      mGridOutputFrequency(0u),
+      mpGridWriter(NULL),
+      mWriteFluidGridsThisStep(false),
+      mFluidReducerOutputFrequency(0u),
+      mReduceFourierGridsThisStep(false),
+      mCheckpointFrequency(0u),
+      mRestartCheckpointPath(""),
+      mWarmStartNumSteps(0u),
+      mWarmStartCoarseningFactor(2u),
+      mWarmStartNodeSpacingMultiplier(1.0),
+      mUseSemiImplicitMembraneUpdate(false),
+      mSemiImplicitSafetyFactor(2.0)
 {
+    mpPhaseTimer.reset(new ImmersedBoundaryPhaseTimer);
+
+    // Register the timed phases in the order of TimedPhase, so each phase's index is its enumerator
+    mpPhaseTimer->AddPhase("ClearForcesAndSources");
+    mpPhaseTimer->AddPhase("AddImmersedBoundaryForceContributions");
+    mpPhaseTimer->AddPhase("PropagateForcesToFluidGrid");
+    mpPhaseTimer->AddPhase("PropagateFluidSourcesToGrid");
+    mpPhaseTimer->AddPhase("SolveNavierStokesSpectral");
+    mpPhaseTimer->AddPhase("AssembleRightHandSide2d");
+    mpPhaseTimer->AddPhase("FftExecuteForward");
+    mpPhaseTimer->AddPhase("SolveInFourierDomain");
+    mpPhaseTimer->AddPhase("FftExecuteInverse");
+    mpPhaseTimer->AddPhase("CalculateNodePairs");
+    mpPhaseTimer->AddPhase("ReduceFluidGrids");
+    assert(mpPhaseTimer->GetNumPhases() == REDUCE_FLUID_GRIDS + 1);
 }
 
 template<unsigned DIM>
 ImmersedBoundarySimulationModifier<DIM>::~ImmersedBoundarySimulationModifier()
 {
-    if (mpBoxCollection)
+    if (mpNodePairList)
     {
-        delete(mpBoxCollection);
+        delete(mpNodePairList);
     }
     if (mpArrays)
     {
         delete(mpArrays);
     }
+    if (mpSinglePrecisionArrays)
+    {
+        delete(mpSinglePrecisionArrays);
+    }
     if (mpFftInterface)
     {
         delete(mpFftInterface);
     }
-}
-
-template<unsigned DIM>
-void ImmersedBoundarySimulationModifier<DIM>::UpdateAtEndOfTimeStep(AbstractCellPopulation<DIM,DIM>& rCellPopulation)
-{
-    // We need to update node neighbours occasionally, but not necessarily each timestep
-    if (SimulationTime::Instance()->GetTimeStepsElapsed() % mNodeNeighbourUpdateFrequency == 0)
+    if (mpGridWriter)
     {
-        mpBoxCollection->CalculateNodePairs(mpMesh->rGetNodes(), mNodePairs);
+        delete(mpGridWriter);
     }
-
-    // This will solve the fluid problem for all timesteps after the first, which is handled in SetupSolve()
-    this->UpdateFluidVelocityGrids(rCellPopulation);
 }
 
 template<unsigned DIM>
-void ImmersedBoundarySimulationModifier<DIM>::SetupSolve(AbstractCellPopulation<DIM,DIM>& rCellPopulation, std::string outputDirectory)
+void ImmersedBoundarySimulationModifier<DIM>::UpdateAtEndOfTimeStep(AbstractCellPopulation<DIM,DIM>& rCellPopulation)
 {
-    // We can set up some helper variables here which need only be set up once for the entire simulation
-    this->SetupConstantMemberVariables(rCellPopulation);
+    ImmersedBoundaryTraceSpan span("Timestep", "step");
 
-    // This will solve the fluid problem based on the initial mesh setup
-    this->UpdateFluidVelocityGrids(rCellPopulation);
-}
+    unsigned time_steps_elapsed = this->GetTimeStepsElapsed();
 
-template<unsigned DIM>
-void ImmersedBoundarySimulationModifier<DIM>::OutputSimulationModifierParameters(out_stream& rParamsFile)
-{
-    // No parameters to output, so just call method on direct parent class
-    AbstractCellBasedSimulationModifier<DIM>::OutputSimulationModifierParameters(rParamsFile);
-}
+    // Periodically redistribute the nodes of each element, which must happen before renumbering so it is followed
+    bool remeshed = mRemeshFrequency > 0 && time_steps_elapsed % mRemeshFrequency == 0;
+    if (remeshed)
+    {
+        mpCellPopulation->RemeshElements(mRemeshTargetNodeSpacing);
+    }
 
-template<unsigned DIM>
-void ImmersedBoundarySimulationModifier<DIM>::UpdateFluidVelocityGrids(AbstractCellPopulation<DIM,DIM>& rCellPopulation)
-{
-    this->ClearForcesAndSources();
-    this->AddImmersedBoundaryForceContributions();
-    this->PropagateForcesToFluidGrid();
+    // Periodically renumber nodes and elements so that those close in space are close in memory
+    bool reordered = mReorderFrequency > 0 && time_steps_elapsed % mReorderFrequency == 0;
+    if (reordered)
+    {
+        mpCellPopulation->ReorderAlongSpaceFillingCurve(mReorderAlongHilbertCurve);
+    }
 
-    // If sources are active, we must propagate them from their nodes to the grid
-    if (mpCellPopulation->DoesPopulationHaveActiveSources())
+    /*
+     * We need to update node neighbours occasionally, but not necessarily each timestep.  With a skin, the node pairs
+     * remain valid until some node may have moved more than half the skin, as two nodes approaching each other then
+     * close by at most the skin.  They are also recalculated after remeshing or renumbering, so that they refer to the
+     * current nodes in the new order, and whenever the mesh has been compacted after cell death, unless they can be
+     * updated from the changes recorded by the mesh instead.
+     */
+    const ImmersedBoundaryTopologyChanges& r_changes = mpMesh->rGetTopologyChanges();
+    bool update_incrementally = mUseIncrementalNodePairUpdates && r_changes.IsComplete() && r_changes.HasChanges();
+
+    bool update_neighbours;
+    if (mNeighbourSkin > 0.0)
     {
-        this->PropagateFluidSourcesToGrid();
+        update_neighbours = mpCellPopulation->GetNodeDisplacementBound() > 0.5 * mNeighbourSkin ||
+                            (!update_incrementally && mpMesh->GetNumNodes() != mNumNodesAtLastNodePairCalculation) ||
+                            (!update_incrementally && mpMesh->GetNumElements() != mNumElementsAtLastNodePairCalculation);
     }
+    else
+    {
+        update_neighbours = time_steps_elapsed % mNodeNeighbourUpdateFrequency == 0;
+    }
+    update_neighbours = update_neighbours ||
+                        (!update_incrementally && mpMesh->GetNumReMeshes() != mNumReMeshesAtLastNodePairCalculation);
 
-    this->SolveNavierStokesSpectral();
-}
+    // With a task graph, the node pairs are recalculated alongside the forces not using them
+    bool calculate_node_pairs = remeshed || reordered || update_neighbours;
+    bool use_task_graph = this->UsesTaskGraph();
+    if (calculate_node_pairs && !use_task_graph)
+    {
+        this->CalculateNodePairs();
+    }
+    else if (!calculate_node_pairs && update_incrementally)
+    {
+        this->UpdateNodePairsAfterTopologyChanges();
+    }
 
-template<unsigned DIM>
-void ImmersedBoundarySimulationModifier<DIM>::SetupConstantMemberVariables(AbstractCellPopulation<DIM,DIM>& rCellPopulation)
-{
-    if (dynamic_cast<ImmersedBoundaryCellPopulation<DIM> *>(&rCellPopulation) == NULL)
+    // Choose the timestep for the next fluid solve and node update, based on the node speeds from the last update
+    if (mUseAdaptiveTimestep)
     {
-        EXCEPTION("Cell population must be immersed boundary");
+        this->AdaptTimestep();
     }
 
-    mpCellPopulation = static_cast<ImmersedBoundaryCellPopulation<DIM> *>(&rCellPopulation);
-    mpMesh = &(mpCellPopulation->rGetMesh());
+    // The Fourier grids are only available to the reducers during the solve
+    bool reduce_fluid = mFluidReducerOutputFrequency > 0 && time_steps_elapsed % mFluidReducerOutputFrequency == 0;
+    mReduceFourierGridsThisStep = reduce_fluid;
 
-    // Get the size of the mesh
-    mNumGridPtsX = mpMesh->GetNumGridPtsX();
-    mNumGridPtsY = mpMesh->GetNumGridPtsY();
+    // Likewise the force grids are only available to the writer during the solve
+    bool write_grids = mpGridWriter && time_steps_elapsed % mGridOutputFrequency == 0;
+    mWriteFluidGridsThisStep = write_grids;
 
-    // Get the grid spacing
-    mGridSpacingX = 1.0 / (double) mNumGridPtsX;
-    mGridSpacingY = 1.0 / (double) mNumGridPtsY;
+    // This will solve the fluid problem for all timesteps after the first, which is handled in SetupSolve()
+    if (use_task_graph)
+    {
+        this->UpdateFluidVelocityGridsWithTaskGraph(calculate_node_pairs);
+    }
+    else
+    {
+        this->UpdateFluidVelocityGrids(rCellPopulation);
+    }
 
-    // Set up the box collection
-    c_vector<double, 2 * 2> domain_size;
-    domain_size(0) = 0.0;
-    domain_size(1) = 1.0;
-    domain_size(2) = 0.0;
-    domain_size(3) = 1.0;
-    mpBoxCollection = new ObsoleteBoxCollection<DIM>(mpCellPopulation->GetInteractionDistance(), domain_size, true, true);
-    mpBoxCollection->SetupLocalBoxesHalfOnly();
-    mpBoxCollection->CalculateNodePairs(mpMesh->rGetNodes(), mNodePairs);
+    // Periodically write the phase timings accumulated so far
+    if (mTimingOutputFrequency > 0 && time_steps_elapsed % mTimingOutputFrequency == 0)
+    {
+        ImmersedBoundaryTraceSpan timings_span("WritePhaseTimings", "output");
+        std::stringstream file_name;
+        file_name << "phase_timings_" << time_steps_elapsed << ".csv";
+        mpPhaseTimer->WriteDataToFile(mOutputDirectory, file_name.str());
+    }
 
-    bool multi_thread_fft = false;
+    // Periodically append the fluid grids to the time series
+    if (write_grids)
+    {
+        this->WriteFluidGrids();
+    }
 
-    // Set up dimension-dependent variables
-    switch (DIM)
+    // Periodically run the in-situ reducers of the fluid velocity
+    if (reduce_fluid)
     {
-        case 2:
-        {
-            mpArrays = new ImmersedBoundary2dArrays<DIM>(mpMesh, SimulationTime::Instance()->GetTimeStep(), mReynoldsNumber, mpCellPopulation->DoesPopulationHaveActiveSources());
-            mpFftInterface = new ImmersedBoundaryFftInterface<DIM>(mpMesh,
-                                                                   &(mpArrays->rGetModifiableRightHandSideGrids()[0][0][0]),
-                                                                   &(mpArrays->rGetModifiableFourierGrids()[0][0][0]),
-                                                                   &(mpMesh->rGetModifiable2dVelocityGrids()[0][0][0]),
-                                                                   multi_thread_fft,
-                                                                   mpCellPopulation->DoesPopulationHaveActiveSources());
+        this->ReduceFluidGrids();
+    }
 
-            mFftNorm = (double) mNumGridPtsX * (double) mNumGridPtsY;
-            break;
-        }
-        default:
-            NEVER_REACHED; // Not yet implemented in 3D
+    // Periodically save a checkpoint, replacing the last
+    if (mCheckpointFrequency > 0 && time_steps_elapsed % mCheckpointFrequency == 0)
+    {
+        this->SaveCheckpoint(mOutputDirectory);
     }
 }
 
 template<unsigned DIM>
-void ImmersedBoundarySimulationModifier<DIM>::ClearForcesAndSources()
+void ImmersedBoundarySimulationModifier<DIM>::SetupSolve(AbstractCellPopulation<DIM,DIM>& rCellPopulation, std::string outputDirectory)
 {
-    // Clear applied forces on each node
-    for (typename ImmersedBoundaryMesh<DIM, DIM>::NodeIterator node_iter = mpMesh->GetNodeIteratorBegin(false);
-         node_iter != mpMesh->GetNodeIteratorEnd();
-         ++node_iter)
+    ImmersedBoundaryTraceSpan span("SetupSolve", "step");
+
+    mOutputDirectory = outputDirectory;
+
+    // Relax the initial mesh on a coarse grid first, unless restarting from a checkpoint
+    bool warm_start = mWarmStartNumSteps > 0 && mRestartCheckpointPath == "";
+    multi_array<double, 3> coarse_velocity_grids;
+    if (warm_start)
     {
-        node_iter->ClearAppliedForce();
+        this->RunWarmStart(rCellPopulation, coarse_velocity_grids);
     }
 
-    // Reset force grids to 0 everywhere
-    multi_array<double, 3>& r_force_grids = mpArrays->rGetModifiableForceGrids();
+    // We can set up some helper variables here which need only be set up once for the entire simulation
+    this->SetupConstantMemberVariables(rCellPopulation);
 
-    for (unsigned dim = 0; dim < 2; dim++)
+    if (mRestartCheckpointPath != "")
+    {
+        // The fluid velocity solved for before the checkpoint was saved is restored instead
+        this->RestoreCheckpoint();
+    }
+    else
     {
-        for (unsigned x = 0; x < mNumGridPtsX; x++)
+        // The warm start's fluid velocity is prolonged once the transforms are planned, as planning may use the grids
+        if (warm_start)
         {
-            for (unsigned y = 0; y < mNumGridPtsY; y++)
-            {
-                r_force_grids[dim][x][y] = 0.0;
-            }
+            ImmersedBoundaryFftInterface<DIM>::ProlongSpectrally(coarse_velocity_grids, mpMesh->rGetModifiable2dVelocityGrids());
         }
+
+        // This will solve the fluid problem based on the initial mesh setup
+        mReduceFourierGridsThisStep = mFluidReducerOutputFrequency > 0;
+        mWriteFluidGridsThisStep = mGridOutputFrequency > 0;
+        this->UpdateFluidVelocityGrids(rCellPopulation);
     }
 
-    // If there are active sources, the relevant grid needs to be reset to zero everywhere
-    if (mpCellPopulation->DoesPopulationHaveActiveSources())
+    // The time series starts with the initial solution
+    if (mGridOutputFrequency > 0)
     {
-        multi_array<double, 3> &r_rhs_grid = mpArrays->rGetModifiableRightHandSideGrids();
-
-        for (unsigned x = 0; x < mNumGridPtsX; x++)
+        if (mpGridWriter)
         {
-            for (unsigned y = 0; y < mNumGridPtsY; y++)
-            {
-                r_rhs_grid[2][x][y] = 0.0;
-            }
+            delete(mpGridWriter);
         }
+        mpGridWriter = new ImmersedBoundaryHdf5GridWriter(mOutputDirectory, "fluid_grids", mNumGridPtsX, mNumGridPtsY,
+                                                          true, mStorePressureGrid);
+        this->WriteFluidGrids();
     }
-}
 
-template<unsigned DIM>
-void ImmersedBoundarySimulationModifier<DIM>::AddImmersedBoundaryForceContributions()
-{
-    // Add contributions from each immersed boundary force
-    for (typename std::vector<boost::shared_ptr<AbstractImmersedBoundaryForce<DIM> > >::iterator iter = mForceCollection.begin();
-         iter != mForceCollection.end();
-         ++iter)
+    // The reduced time series also starts with the initial solution, though it has no spectrum after a restart
+    if (mFluidReducerOutputFrequency > 0)
     {
-        (*iter)->AddImmersedBoundaryForceContribution(mNodePairs, *mpCellPopulation);
+        for (unsigned i = 0; i < mFluidReducers.size(); i++)
+        {
+            mFluidReducers[i]->Setup(mOutputDirectory, mNumGridPtsX, mNumGridPtsY,
+                                     mpMesh->GetDomainWidth(), mpMesh->GetDomainHeight());
+        }
+        this->ReduceFluidGrids();
     }
 }
 
 template<unsigned DIM>
-void ImmersedBoundarySimulationModifier<DIM>::PropagateForcesToFluidGrid()
+void ImmersedBoundarySimulationModifier<DIM>::RunWarmStart(AbstractCellPopulation<DIM,DIM>& rCellPopulation,
+                                                           multi_array<double, 3>& rCoarseVelocityGrids)
 {
-    // Helper variables, pre-defined for efficiency
-    double dl;
-    double weight;
+    ImmersedBoundaryTraceSpan span("WarmStart", "step");
 
-    unsigned first_idx_x;
-    unsigned first_idx_y;
+    ImmersedBoundaryCellPopulation<DIM>* p_population = dynamic_cast<ImmersedBoundaryCellPopulation<DIM>*>(&rCellPopulation);
+    if (p_population == NULL)
+    {
+        EXCEPTION("Cell population must be immersed boundary");
+    }
+    ImmersedBoundaryMesh<DIM,DIM>& r_mesh = p_population->rGetMesh();
+    if (r_mesh.HasWalls())
+    {
+        EXCEPTION("The warm start is only supported in periodic domains");
+    }
 
-    std::vector<unsigned> x_indices(4);
-    std::vector<unsigned> y_indices(4);
+    unsigned num_grid_pts_x = r_mesh.GetNumGridPtsX();
+    unsigned num_grid_pts_y = r_mesh.GetNumGridPtsY();
+    unsigned coarse_x = num_grid_pts_x / mWarmStartCoarseningFactor;
+    unsigned coarse_y = num_grid_pts_y / mWarmStartCoarseningFactor;
+    if (coarse_x * mWarmStartCoarseningFactor != num_grid_pts_x || coarse_y * mWarmStartCoarseningFactor != num_grid_pts_y
+        || coarse_x % 2 != 0 || coarse_y % 2 != 0)
+    {
+        EXCEPTION("The warm start coarsening factor must divide the number of grid points in each direction, leaving an even number");
+    }
 
-    std::vector<double> x_deltas(4);
-    std::vector<double> y_deltas(4);
+    // Relax elements with fewer nodes if asked to
+    double node_spacing = r_mesh.GetCharacteristicNodeSpacing();
+    if (mWarmStartNodeSpacingMultiplier != 1.0)
+    {
+        p_population->RemeshElements(mWarmStartNodeSpacingMultiplier * node_spacing);
+    }
 
-    c_vector<double, DIM> node_location;
-    c_vector<double, DIM> applied_force;
+    // Set up the solver on the coarse grid; shared plans are for the production grid, so are not used
+    const ImmersedBoundaryFftInterface<DIM>* p_shared_fft_interface = mpSharedFftInterface;
+    mpSharedFftInterface = NULL;
+    r_mesh.SetNumGridPtsX(coarse_x);
+    r_mesh.SetNumGridPtsY(coarse_y);
+    this->SetupConstantMemberVariables(rCellPopulation);
 
-    // Get a reference to the force grids which we spread the applied forces to
-    multi_array<double, 3>& force_grids = mpArrays->rGetModifiableForceGrids();
+    // Planning the transforms may have used the velocity grids, so the relaxation starts from rest
+    multi_array<double, 3>& r_vel_grids = mpMesh->rGetModifiable2dVelocityGrids();
+    std::fill(r_vel_grids.data(), r_vel_grids.data() + r_vel_grids.num_elements(), 0.0);
 
-    // Here, we loop over elements and then nodes as the length scale dl varies per element
-    for (typename ImmersedBoundaryMesh<DIM, DIM>::ImmersedBoundaryElementIterator elem_iter = mpMesh->GetElementIteratorBegin(false);
-         elem_iter != mpMesh->GetElementIteratorEnd();
-         ++elem_iter)
+    // The usual fluid solve and node update, with the node pairs recalculated as in UpdateAtEndOfTimeStep()
+    mReduceFourierGridsThisStep = false;
+    double dt = SimulationTime::Instance()->GetTimeStep();
+    for (unsigned step = 0; step < mWarmStartNumSteps; step++)
     {
-        dl = mpMesh->GetAverageNodeSpacingOfElement(elem_iter->GetIndex(), false);
-
-        for (unsigned node_idx = 0; node_idx < elem_iter->GetNumNodes(); node_idx++)
+        if (step > 0)
         {
-            Node<DIM> *p_node = elem_iter->GetNode(node_idx);
-
-            // Get location and applied force contribution of current node
-            node_location = p_node->rGetLocation();
-            applied_force = p_node->rGetAppliedForce();
-
-            // Get first grid index in each dimension, taking account of possible wrap-around
-            first_idx_x = unsigned(floor(node_location[0] / mGridSpacingX)) + mNumGridPtsX - 1;
-            first_idx_y = unsigned(floor(node_location[1] / mGridSpacingY)) + mNumGridPtsY - 1;
-
-            // Calculate all four indices and deltas in each dimension
-            for (unsigned i = 0; i < 4; i++)
+            bool update_neighbours = (mNeighbourSkin > 0.0) ? mpCellPopulation->GetNodeDisplacementBound() > 0.5 * mNeighbourSkin
+                                                            : step % mNodeNeighbourUpdateFrequency == 0;
+            if (update_neighbours)
             {
-                x_indices[i] = (first_idx_x + i) % mNumGridPtsX;
-                y_indices[i] = (first_idx_y + i) % mNumGridPtsY;
-
-                x_deltas[i] = Delta1D(fabs(x_indices[i] * mGridSpacingX - node_location[0]), mGridSpacingX);
-                y_deltas[i] = Delta1D(fabs(y_indices[i] * mGridSpacingY - node_location[1]), mGridSpacingY);
+                this->CalculateNodePairs();
             }
+        }
 
-            // Loop over the 4x4 grid used to spread the force on the nodes to the fluid grid
-            for (unsigned x_idx = 0; x_idx < 4; x_idx++)
-            {
-                for (unsigned y_idx = 0; y_idx < 4; y_idx++)
-                {
-                    // The applied force is weighted by the delta function
-                    weight = x_deltas[x_idx] * y_deltas[y_idx] * dl / (mGridSpacingX * mGridSpacingY);
+        this->UpdateFluidVelocityGrids(rCellPopulation);
+        mpCellPopulation->UpdateNodeLocations(dt);
+    }
 
-                    force_grids[0][x_indices[x_idx]][y_indices[y_idx]] += applied_force[0] * weight;
-                    force_grids[1][x_indices[x_idx]][y_indices[y_idx]] += applied_force[1] * weight;
-                }
-            }
-        }
+    rCoarseVelocityGrids.resize(extents[2][coarse_x][coarse_y]);
+    rCoarseVelocityGrids = r_vel_grids;
+
+    // Release the coarse solver, and restore the production grid and node spacing
+    delete mpNodePairList;
+    mpNodePairList = NULL;
+    delete mpArrays;
+    mpArrays = NULL;
+    delete mpSinglePrecisionArrays;
+    mpSinglePrecisionArrays = NULL;
+    delete mpFftInterface;
+    mpFftInterface = NULL;
+    mpSharedFftInterface = p_shared_fft_interface;
+    mTaskGraphReady = false;
+
+    r_mesh.SetNumGridPtsX(num_grid_pts_x);
+    r_mesh.SetNumGridPtsY(num_grid_pts_y);
+    if (mWarmStartNodeSpacingMultiplier != 1.0)
+    {
+        p_population->RemeshElements(node_spacing);
     }
 }
 
 template<unsigned DIM>
-void ImmersedBoundarySimulationModifier<DIM>::PropagateFluidSourcesToGrid()
+void ImmersedBoundarySimulationModifier<DIM>::ReduceFluidGrids()
 {
-    // Helper variables, pre-defined for efficiency
-    double weight;
-
-    unsigned first_idx_x;
-    unsigned first_idx_y;
-
-    std::vector<unsigned> x_indices(4);
-    std::vector<unsigned> y_indices(4);
-
-    std::vector<double> x_deltas(4);
-    std::vector<double> y_deltas(4);
+    mpPhaseTimer->StartPhase(REDUCE_FLUID_GRIDS);
+    unsigned time_steps_elapsed = this->GetTimeStepsElapsed();
+    double time = SimulationTime::Instance()->GetTime();
+    for (unsigned i = 0; i < mFluidReducers.size(); i++)
+    {
+        mFluidReducers[i]->Reduce(time_steps_elapsed, time, mpMesh->rGet2dVelocityGrids());
+    }
+    mpPhaseTimer->StopPhase(REDUCE_FLUID_GRIDS);
+}
 
-    // Currently the fluid source grid is the final part of the right hand side grid, as having all three grids
-    // contiguous helps improve the Fourier transform performance.
-    //\todo could make this nicer by using boost multiarray 'slice'?
-    multi_array<double, 3>& rhs_grids = mpArrays->rGetModifiableRightHandSideGrids();
+template<unsigned DIM>
+template<typename SCALAR>
+void ImmersedBoundarySimulationModifier<DIM>::ReduceFourierGrids(const multi_array<std::complex<SCALAR>, 3>& rFourierGrids)
+{
+    mpPhaseTimer->StartPhase(REDUCE_FLUID_GRIDS);
+    for (unsigned i = 0; i < mFluidReducers.size(); i++)
+    {
+        if (mFluidReducers[i]->UsesFourierGrids())
+        {
+            mFluidReducers[i]->ReduceFourierGrids(rFourierGrids);
+        }
+    }
+    mpPhaseTimer->StopPhase(REDUCE_FLUID_GRIDS);
+    mReduceFourierGridsThisStep = false;
+}
 
-    std::vector<FluidSource<DIM>*>& r_element_sources = mpMesh->rGetElementFluidSources();
-    std::vector<FluidSource<DIM>*>& r_balance_sources = mpMesh->rGetBalancingFluidSources();
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::WriteFluidGrids()
+{
+    ImmersedBoundaryTraceSpan span("WriteFluidGrids", "output");
 
-    // Construct a vector of all sources combined
-    std::vector<FluidSource<DIM>*> combined_sources;
-    combined_sources.insert(combined_sources.end(), r_element_sources.begin(), r_element_sources.end());
-    combined_sources.insert(combined_sources.end(), r_balance_sources.begin(), r_balance_sources.end());
+    assert(mpGridWriter);
 
-    // Find the combined element source strength
-    double cumulative_strength = 0.0;
-    for (unsigned source_idx = 0; source_idx < r_element_sources.size(); source_idx++)
+    // After a restart there has been no solve to copy the force grids from, so they are written as zero
+    if (mOutputForceGrids.num_elements() == 0)
     {
-        cumulative_strength += r_element_sources[source_idx]->GetStrength();
+        mOutputForceGrids.resize(extents[2][mNumGridPtsX][mNumGridPtsY]);
     }
 
-    // Calculate the required balancing strength, and apply it to all balancing sources
-    double balance_strength = -1.0 * cumulative_strength / (double)r_balance_sources.size();
-    for (unsigned source_idx = 0; source_idx < r_balance_sources.size(); source_idx++)
+    const multi_array_ref<std::complex<double>, 2>* p_pressure_grid = NULL;
+    if (mStorePressureGrid && mpSinglePrecisionArrays)
+    {
+        // The writer takes the pressure in double precision
+        const multi_array_ref<std::complex<float>, 2>& r_pressure = mpSinglePrecisionArrays->rGetModifiablePressureGrid();
+        mOutputPressureGrid.resize(extents[r_pressure.shape()[0]][r_pressure.shape()[1]]);
+        std::copy(r_pressure.data(), r_pressure.data() + r_pressure.num_elements(), mOutputPressureGrid.data());
+        p_pressure_grid = &mOutputPressureGrid;
+    }
+    else if (mStorePressureGrid)
     {
-        r_balance_sources[source_idx]->SetStrength(balance_strength);
+        p_pressure_grid = &(mpArrays->rGetModifiablePressureGrid());
     }
+    mpGridWriter->WriteStep(SimulationTime::Instance()->GetTime(), mpMesh->rGet2dVelocityGrids(), &mOutputForceGrids,
+                            p_pressure_grid);
+    mWriteFluidGridsThisStep = false;
+}
 
-    // Iterate over all sources and propagate their effects to the source grid
-    for (unsigned source_idx = 0; source_idx < combined_sources.size(); source_idx++)
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SaveCheckpoint(const std::string& rDirectory, const std::string& rFileName)
+{
+    ImmersedBoundaryTraceSpan span("SaveCheckpoint", "output");
+
+    if (mpArrays == NULL && mpSinglePrecisionArrays == NULL)
     {
-        FluidSource<DIM>* this_source = combined_sources[source_idx];
+        EXCEPTION("A checkpoint can only be saved once SetupSolve() has been called");
+    }
 
-        // Get location and strength of this source
-        c_vector<double, DIM> source_location = this_source->rGetLocation();
-        double source_strength = this_source->GetStrength();
+    ImmersedBoundaryCheckpoint<DIM> checkpoint;
+    checkpoint.SetTime(SimulationTime::Instance()->GetTime());
+    checkpoint.SetTimeStepsElapsed(this->GetTimeStepsElapsed());
 
-        // Get first grid index in each dimension, taking account of possible wrap-around
-        first_idx_x = unsigned(floor(source_location[0] / mGridSpacingX)) + mNumGridPtsX - 1;
-        first_idx_y = unsigned(floor(source_location[1] / mGridSpacingY)) + mNumGridPtsY - 1;
+    multi_array<double, 3>& r_grids = checkpoint.rGetVelocityGrids();
+    r_grids.resize(boost::extents[2][mNumGridPtsX][mNumGridPtsY]);
+    r_grids = mpMesh->rGet2dVelocityGrids();
 
-        // Calculate all four indices and deltas in each dimension
-        for (unsigned i = 0; i < 4; i ++)
+    // Deleted nodes and elements keep their places, so indices are unchanged on restart
+    std::vector<double>& r_node_locations = checkpoint.rGetNodeLocations();
+    r_node_locations.assign(DIM * mpMesh->GetNumAllNodes(), 0.0);
+    for (typename AbstractMesh<DIM, DIM>::NodeIterator node_iter = mpMesh->GetNodeIteratorBegin();
+         node_iter != mpMesh->GetNodeIteratorEnd();
+         ++node_iter)
+    {
+        for (unsigned dim = 0; dim < DIM; dim++)
         {
-            x_indices[i] = (first_idx_x + i) % mNumGridPtsX;
-            y_indices[i] = (first_idx_y + i) % mNumGridPtsY;
-
-            x_deltas[i] = Delta1D(fabs(x_indices[i] * mGridSpacingX - source_location[0]), mGridSpacingX);
-            y_deltas[i] = Delta1D(fabs(y_indices[i] * mGridSpacingY - source_location[1]), mGridSpacingY);
+            r_node_locations[DIM * node_iter->GetIndex() + dim] = node_iter->rGetLocation()[dim];
         }
+    }
 
-        // Loop over the 4x4 grid needed to spread the source strength to the source grid
-        for (unsigned x_idx = 0; x_idx < 4; x_idx ++)
+    std::vector<double>& r_spacings = checkpoint.rGetElementNodeSpacings();
+    r_spacings.assign(mpMesh->GetNumAllElements(), 0.0);
+    for (typename ImmersedBoundaryMesh<DIM, DIM>::ImmersedBoundaryElementIterator elem_iter = mpMesh->GetElementIteratorBegin();
+         elem_iter != mpMesh->GetElementIteratorEnd();
+         ++elem_iter)
+    {
+        r_spacings[elem_iter->GetIndex()] = elem_iter->GetAverageNodeSpacing();
+    }
+    checkpoint.SetCharacteristicNodeSpacing(mpMesh->GetCharacteristicNodeSpacing());
+    GetElementTopology(checkpoint.rGetElementTopology());
+
+    ImmersedBoundaryFluidSourceRegistry<DIM>& r_registry = mpMesh->rGetFluidSourceRegistry();
+    std::vector<double>& r_source_locations = checkpoint.rGetSourceLocations();
+    std::vector<double>& r_source_strengths = checkpoint.rGetSourceStrengths();
+    r_source_locations.resize(DIM * r_registry.GetNumSources());
+    r_source_strengths.resize(r_registry.GetNumSources());
+    for (unsigned slot = 0; slot < r_registry.GetNumSources(); slot++)
+    {
+        for (unsigned dim = 0; dim < DIM; dim++)
         {
-            for (unsigned y_idx = 0; y_idx < 4; y_idx ++)
-            {
-                // The strength is weighted by the delta function
-                weight = x_deltas[x_idx] * y_deltas[y_idx] / (mGridSpacingX * mGridSpacingY);
-
-                rhs_grids[2][x_indices[x_idx]][y_indices[y_idx]] += source_strength * weight;
-            }
+            r_source_locations[DIM * slot + dim] = r_registry.GetLocation(slot)[dim];
         }
+        r_source_strengths[slot] = r_registry.GetStrength(slot);
     }
-}
-#include "Debug.hpp"
-template<unsigned DIM>
-void ImmersedBoundarySimulationModifier<DIM>::SolveNavierStokesSpectral()
-{
-    double dt = SimulationTime::Instance()->GetTimeStep();
-    unsigned reduced_size = 1 + (mNumGridPtsY/2);
 
-    // Get references to all the necessary grids
-    multi_array<double, 3>& vel_grids   = mpMesh->rGetModifiable2dVelocityGrids();
-    multi_array<double, 3>& force_grids = mpArrays->rGetModifiableForceGrids();
-    multi_array<double, 3>& rhs_grids   = mpArrays->rGetModifiableRightHandSideGrids();
-    multi_array<double, 3>& source_gradient_grids   = mpArrays->rGetModifiableSourceGradientGrids();
+    std::vector<typename ImmersedBoundaryNodePairList<DIM>::NodePair>& r_pairs = checkpoint.rGetNodePairs();
+    r_pairs.resize(mpNodePairList->GetNumPairs());
+    for (unsigned pair = 0; pair < r_pairs.size(); pair++)
+    {
+        r_pairs[pair] = mpNodePairList->rGetPair(pair);
+    }
+    checkpoint.SetNodeDisplacementBound(mpCellPopulation->GetNodeDisplacementBound());
 
-    const multi_array<double, 2>& op_1  = mpArrays->rGetOperator1();
-    const multi_array<double, 2>& op_2  = mpArrays->rGetOperator2();
-    const std::vector<double>& sin_2x   = mpArrays->rGetSin2x();
-    const std::vector<double>& sin_2y   = mpArrays->rGetSin2y();
+    std::vector<std::string>& r_force_names = checkpoint.rGetForceNames();
+    for (unsigned force_idx = 0; force_idx < mForceCollection.size(); force_idx++)
+    {
+        r_force_names.push_back(mForceCollection[force_idx]->GetIdentifier());
+    }
 
-    multi_array<std::complex<double>, 3>& fourier_grids = mpArrays->rGetModifiableFourierGrids();
-    multi_array<std::complex<double>, 2>& pressure_grid = mpArrays->rGetModifiablePressureGrid();
+    // Every process holds the whole state, so only the master writes it
+    OutputFileHandler output_file_handler(rDirectory, false);
+    if (PetscTools::AmMaster())
+    {
+        checkpoint.Write(output_file_handler.GetOutputDirectoryFullPath() + rFileName);
+    }
+}
 
-    // Perform upwind differencing and create RHS of linear system
-    Upwind2d(vel_grids, rhs_grids);
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::RestoreCheckpoint()
+{
+    ImmersedBoundaryCheckpoint<DIM> checkpoint;
+    checkpoint.Read(mRestartCheckpointPath);
 
-    // If the population has active sources, the Right Hand Side grids are calculated differently.
-    if (mpCellPopulation->DoesPopulationHaveActiveSources())
+    // Check the simulation has been set up as the one that saved the checkpoint
+    double time = SimulationTime::Instance()->GetTime();
+    if (fabs(checkpoint.GetTime() - time) > 1e-9 * std::max(1.0, fabs(time)))
     {
-        double factor = 1.0 / (3.0 * mReynoldsNumber);
-
-        CalculateSourceGradients(rhs_grids, source_gradient_grids);
+        EXCEPTION("The checkpoint was saved at time " << checkpoint.GetTime() << " but the simulation is at time " << time);
+    }
 
-        for (unsigned dim = 0; dim < 2; dim++)
-        {
-            for (unsigned x = 0; x < mNumGridPtsX; x++)
-            {
-                for (unsigned y = 0; y < mNumGridPtsY; y++)
-                {
-                    rhs_grids[dim][x][y] = vel_grids[dim][x][y] + dt * (force_grids[dim][x][y] + factor * source_gradient_grids[dim][x][y] - rhs_grids[dim][x][y]);
-                }
-            }
-        }
+    multi_array<double, 3>& r_grids = checkpoint.rGetVelocityGrids();
+    if (r_grids.shape()[1] != mNumGridPtsX || r_grids.shape()[2] != mNumGridPtsY)
+    {
+        EXCEPTION("The checkpoint was saved with a fluid grid of a different size");
     }
-    else
+
+    // The mesh is not restored, so must match the one that saved the checkpoint
+    ImmersedBoundaryFluidSourceRegistry<DIM>& r_registry = mpMesh->rGetFluidSourceRegistry();
+    if (checkpoint.rGetNodeLocations().size() != DIM * mpMesh->GetNumAllNodes() ||
+        checkpoint.rGetElementNodeSpacings().size() != mpMesh->GetNumAllElements() ||
+        checkpoint.rGetSourceStrengths().size() != r_registry.GetNumSources())
     {
-        for (unsigned dim = 0; dim < 2; dim++)
-        {
-            for (unsigned x = 0; x < mNumGridPtsX; x++)
-            {
-                for (unsigned y = 0; y < mNumGridPtsY; y++)
-                {
-                    rhs_grids[dim][x][y] = (vel_grids[dim][x][y] + dt * (force_grids[dim][x][y] - rhs_grids[dim][x][y]));
-                }
-            }
-        }
+        EXCEPTION("The checkpoint was saved with " << checkpoint.rGetNodeLocations().size() / DIM << " nodes, "
+                  << checkpoint.rGetElementNodeSpacings().size() << " elements and "
+                  << checkpoint.rGetSourceStrengths().size() << " fluid sources, but the mesh has "
+                  << mpMesh->GetNumAllNodes() << " nodes, " << mpMesh->GetNumAllElements() << " elements and "
+                  << r_registry.GetNumSources() << " fluid sources; a checkpoint can only be restored to the mesh it "
+                  << "was saved from, before any cell has divided or died");
     }
 
-    // Perform fft on rhs_grids; results go to fourier_grids
-    mpFftInterface->FftExecuteForward();
+    std::vector<unsigned> topology;
+    GetElementTopology(topology);
+    if (topology != checkpoint.rGetElementTopology())
+    {
+        EXCEPTION("The checkpoint was saved with elements made of different nodes; a checkpoint can only be restored "
+                  << "to the mesh it was saved from, before any cell has divided or died");
+    }
 
-    /*
-     * The result of a DFT of n real datapoints is n/2 + 1 complex values, due to redundancy: element n-1 is conj(2),
-     * etc.  A similar pattern of redundancy occurs in a 2D transform.  Calculations in the Fourier domain preserve this
-     * redundancy, and so all calculations need only be done on reduced-size arrays, saving memory and computation.
-     */
+    std::vector<std::string>& r_force_names = checkpoint.rGetForceNames();
+    bool forces_match = r_force_names.size() == mForceCollection.size();
+    for (unsigned force_idx = 0; forces_match && force_idx < mForceCollection.size(); force_idx++)
+    {
+        forces_match = r_force_names[force_idx] == mForceCollection[force_idx]->GetIdentifier();
+    }
+    if (!forces_match)
+    {
+        EXCEPTION("The checkpoint was saved with different forces");
+    }
 
-    // If the population has active fluid sources, the computation is slightly more complicated
-    if (mpCellPopulation->DoesPopulationHaveActiveSources())
+    // Restore the nodes, which invalidates the node arrays and element geometries
+    const std::vector<double>& r_node_locations = checkpoint.rGetNodeLocations();
+    for (typename AbstractMesh<DIM, DIM>::NodeIterator node_iter = mpMesh->GetNodeIteratorBegin();
+         node_iter != mpMesh->GetNodeIteratorEnd();
+         ++node_iter)
     {
-        for (unsigned x = 0; x < mNumGridPtsX; x++)
+        c_vector<double, DIM>& r_location = node_iter->rGetModifiableLocation();
+        for (unsigned dim = 0; dim < DIM; dim++)
         {
-            for (unsigned y = 0; y < reduced_size; y++)
-            {
-                pressure_grid[x][y] = (op_2[x][y] * fourier_grids[2][x][y] - mI * (sin_2x[x] * fourier_grids[0][x][y] / mGridSpacingX +
-                                                                                   sin_2y[y] * fourier_grids[1][x][y] / mGridSpacingY)) / op_1[x][y];
-            }
+            r_location[dim] = r_node_locations[DIM * node_iter->GetIndex() + dim];
         }
     }
-    else // no active fluid sources
+    mpMesh->InvalidateNodeArrays();
+
+    const std::vector<double>& r_spacings = checkpoint.rGetElementNodeSpacings();
+    for (typename ImmersedBoundaryMesh<DIM, DIM>::ImmersedBoundaryElementIterator elem_iter = mpMesh->GetElementIteratorBegin();
+         elem_iter != mpMesh->GetElementIteratorEnd();
+         ++elem_iter)
+    {
+        elem_iter->SetAverageNodeSpacing(r_spacings[elem_iter->GetIndex()]);
+    }
+    mpMesh->SetCharacteristicNodeSpacing(checkpoint.GetCharacteristicNodeSpacing());
+
+    // Sources are moved in both the registry and the sources themselves
+    const std::vector<double>& r_source_locations = checkpoint.rGetSourceLocations();
+    const std::vector<double>& r_source_strengths = checkpoint.rGetSourceStrengths();
+    for (unsigned slot = 0; slot < r_registry.GetNumSources(); slot++)
     {
-        for (unsigned x = 0; x < mNumGridPtsX; x++)
+        FluidSource<DIM>* p_source = r_registry.GetSource(slot);
+        c_vector<double, DIM>& r_location = p_source->rGetModifiableLocation();
+        double* p_location = r_registry.GetLocation(slot);
+        for (unsigned dim = 0; dim < DIM; dim++)
         {
-            for (unsigned y = 0; y < reduced_size; y++)
-            {
-                pressure_grid[x][y] = -mI * (sin_2x[x] * fourier_grids[0][x][y] / mGridSpacingX +
-                                             sin_2y[y] * fourier_grids[1][x][y] / mGridSpacingY) / op_1[x][y];
-            }
+            p_location[dim] = r_source_locations[DIM * slot + dim];
+            r_location[dim] = p_location[dim];
         }
+        p_source->SetStrength(r_source_strengths[slot]);
     }
 
-    // Set some values to zero
-    pressure_grid[0][0] = 0.0;
-    pressure_grid[mNumGridPtsX/2][0] = 0.0;
-    pressure_grid[mNumGridPtsX/2][mNumGridPtsY/2] = 0.0;
-    pressure_grid[0][mNumGridPtsY/2] = 0.0;
+    mpMesh->rGetModifiable2dVelocityGrids() = r_grids;
 
-    /*
-     * Do final stage of computation before inverse FFT.  We do the necessary DFT scaling at this stage so the output
-     * from the inverse DFT is correct.
-     */
-    for (unsigned x = 0; x < mNumGridPtsX; x++)
+    // The node pairs stay valid while the displacement bound is within the skin, as if they had just been calculated
+    mpNodePairList->Restore(checkpoint.rGetNodePairs());
+    mNumNodesAtLastNodePairCalculation = mpMesh->GetNumNodes();
+    mNumElementsAtLastNodePairCalculation = mpMesh->GetNumElements();
+    mNumReMeshesAtLastNodePairCalculation = mpMesh->GetNumReMeshes();
+    mpCellPopulation->SetNodeDisplacementBound(checkpoint.GetNodeDisplacementBound());
+    mpMesh->rGetTopologyChanges().Clear();
+
+    // SimulationTime counts the timesteps since the restart, so output continues from the count at the checkpoint
+    mTimeStepsElapsedOffset = checkpoint.GetTimeStepsElapsed();
+    mpCellPopulation->SetTimeStepsElapsedOffset(mTimeStepsElapsedOffset);
+
+    // A later call to SetupSolve() continues from the current state
+    mRestartCheckpointPath = "";
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::GetElementTopology(std::vector<unsigned>& rTopology)
+{
+    // Deleted elements keep their places, with no nodes
+    std::vector<std::vector<unsigned> > element_nodes(mpMesh->GetNumAllElements());
+    for (typename ImmersedBoundaryMesh<DIM, DIM>::ImmersedBoundaryElementIterator elem_iter = mpMesh->GetElementIteratorBegin();
+         elem_iter != mpMesh->GetElementIteratorEnd();
+         ++elem_iter)
     {
-        for (unsigned y = 0; y < reduced_size; y++)
+        std::vector<unsigned>& r_nodes = element_nodes[elem_iter->GetIndex()];
+        for (unsigned local_idx = 0; local_idx < elem_iter->GetNumNodes(); local_idx++)
         {
-            fourier_grids[0][x][y] = (fourier_grids[0][x][y] - (mI * dt / (mReynoldsNumber * mGridSpacingX)) * sin_2x[x] * pressure_grid[x][y]) / (op_2[x][y]);
-            fourier_grids[1][x][y] = (fourier_grids[1][x][y] - (mI * dt / (mReynoldsNumber * mGridSpacingY)) * sin_2y[y] * pressure_grid[x][y]) / (op_2[x][y]);
+            r_nodes.push_back(elem_iter->GetNodeGlobalIndex(local_idx));
         }
     }
 
-    // Perform inverse fft on fourier_grids; results are in vel_grids.  Then, normalise the DFT.
-    mpFftInterface->FftExecuteInverse();
-    for (unsigned dim = 0; dim < 2; dim++)
+    rTopology.clear();
+    for (unsigned elem_idx = 0; elem_idx < element_nodes.size(); elem_idx++)
     {
-        for (unsigned x = 0; x < mNumGridPtsX; x++)
-        {
-            for (unsigned y = 0; y < mNumGridPtsY; y++)
-            {
-                vel_grids[dim][x][y] /= mFftNorm;
-            }
-        }
+        rTopology.push_back(element_nodes[elem_idx].size());
+        rTopology.insert(rTopology.end(), element_nodes[elem_idx].begin(), element_nodes[elem_idx].end());
     }
 }
 
 template<unsigned DIM>
-double ImmersedBoundarySimulationModifier<DIM>::Delta1D(double dist, double spacing)
+void ImmersedBoundarySimulationModifier<DIM>::OutputSimulationModifierParameters(out_stream& rParamsFile)
 {
-    return (0.25 * (1.0 + cos(M_PI * dist / (2 * spacing))));
+    // No parameters to output, so just call method on direct parent class
+    AbstractCellBasedSimulationModifier<DIM>::OutputSimulationModifierParameters(rParamsFile);
 }
 
 template<unsigned DIM>
-void ImmersedBoundarySimulationModifier<DIM>::Upwind2d(const multi_array<double, 3>& input, multi_array<double, 3>& output)
+void ImmersedBoundarySimulationModifier<DIM>::UpdateFluidVelocityGrids(AbstractCellPopulation<DIM,DIM>& rCellPopulation)
 {
-    unsigned prev_x = mNumGridPtsX - 1;
-    unsigned prev_y = mNumGridPtsY - 1;
+    mpPhaseTimer->StartPhase(CLEAR_FORCES_AND_SOURCES);
+    this->ClearForcesAndSources();
+    mpPhaseTimer->StopPhase(CLEAR_FORCES_AND_SOURCES);
 
-    unsigned next_x = 1;
-    unsigned next_y = 1;
+    mpPhaseTimer->StartPhase(ADD_FORCE_CONTRIBUTIONS);
+    this->AddImmersedBoundaryForceContributions();
+    mpPhaseTimer->StopPhase(ADD_FORCE_CONTRIBUTIONS);
 
-    for (unsigned x = 0; x < mNumGridPtsX; x++)
+    if (mUseSemiImplicitMembraneUpdate)
     {
-        for (unsigned y = 0; y < mNumGridPtsY; y++)
+        this->UpdateImplicitMembraneCoefficients();
+    }
+    else if (!mpCellPopulation->rGetImplicitMembraneCoefficients().empty())
+    {
+        // The population corrects displacements whenever it holds coefficients, so stale ones must not linger
+        mpCellPopulation->SetImplicitMembraneCoefficients(std::vector<double>());
+    }
+
+    mpPhaseTimer->StartPhase(PROPAGATE_FORCES_TO_FLUID_GRID);
+    this->PropagateForcesToFluidGrid();
+    mpPhaseTimer->StopPhase(PROPAGATE_FORCES_TO_FLUID_GRID);
+
+    // If sources are active, we must propagate them from their nodes to the grid
+    if (mpCellPopulation->DoesPopulationHaveActiveSources())
+    {
+        mpPhaseTimer->StartPhase(PROPAGATE_FLUID_SOURCES_TO_GRID);
+        this->PropagateFluidSourcesToGrid();
+        mpPhaseTimer->StopPhase(PROPAGATE_FLUID_SOURCES_TO_GRID);
+    }
+
+    mpPhaseTimer->StartPhase(SOLVE_NAVIER_STOKES);
+    this->SolveNavierStokesSpectral();
+    mpPhaseTimer->StopPhase(SOLVE_NAVIER_STOKES);
+
+    // Each force has now had its first call, so may subsequently be calculated alongside the others
+    mTaskGraphReady = true;
+}
+
+template<unsigned DIM>
+bool ImmersedBoundarySimulationModifier<DIM>::UsesTaskGraph()
+{
+    return mNumTaskGraphThreads > 1 && mTaskGraphReady && !HasForcesNotUsingNodeArrays();
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::UpdateFluidVelocityGridsWithTaskGraph(bool calculateNodePairs)
+{
+    /*
+     * The node arrays are rebuilt on first access after they are invalidated, and the average node spacing of each
+     * element is cached on first access, so both are brought up to date here rather than by concurrent tasks.
+     */
+    mpMesh->rGetNodeArrays();
+    for (typename ImmersedBoundaryMesh<DIM, DIM>::ImmersedBoundaryElementIterator elem_iter = mpMesh->GetElementIteratorBegin();
+         elem_iter != mpMesh->GetElementIteratorEnd();
+         ++elem_iter)
+    {
+        mpMesh->GetAverageNodeSpacingOfElement(elem_iter->GetIndex(), false);
+    }
+
+    unsigned num_forces = mForceCollection.size();
+    mForceBuffers.resize(num_forces > 1 ? num_forces : 0);
+
+    mTaskGraph.Clear();
+    unsigned clear_task = mTaskGraph.AddTask(ExecuteTimestepTask, this, CLEAR_FORCES_AND_SOURCES_TASK);
+    unsigned node_pairs_task = UINT_MAX;
+    if (calculateNodePairs)
+    {
+        node_pairs_task = mTaskGraph.AddTask(ExecuteTimestepTask, this, CALCULATE_NODE_PAIRS_TASK);
+    }
+
+    // Forces of the same class share a timed phase, so are calculated in turn
+    unsigned gather_task = mTaskGraph.AddTask(ExecuteTimestepTask, this, GATHER_FORCES_TASK);
+    std::map<unsigned, unsigned> last_task_of_phase;
+    for (unsigned force_idx = 0; force_idx < num_forces; force_idx++)
+    {
+        unsigned force_task = mTaskGraph.AddTask(ExecuteTimestepTask, this, CALCULATE_FORCE_TASK + force_idx);
+        mTaskGraph.AddDependency(clear_task, force_task);
+        if (calculateNodePairs && mForceCollection[force_idx]->UsesNodePairs())
         {
-            // Set values for output from conditional on x grid
-            if (input[0][x][y] > 0)
-            {
-                output[0][x][y] = input[0][x][y] * (input[0][x][y] - input[0][prev_x][y]) / mGridSpacingX;
-                output[1][x][y] = input[0][x][y] * (input[1][x][y] - input[1][prev_x][y]) / mGridSpacingX;
-            }
-            else
+            mTaskGraph.AddDependency(node_pairs_task, force_task);
+        }
+
+        std::map<unsigned, unsigned>::iterator it = last_task_of_phase.find(mForcePhases[force_idx]);
+        if (it != last_task_of_phase.end())
+        {
+            mTaskGraph.AddDependency(it->second, force_task);
+        }
+        last_task_of_phase[mForcePhases[force_idx]] = force_task;
+
+        mTaskGraph.AddDependency(force_task, gather_task);
+    }
+    if (num_forces == 0)
+    {
+        mTaskGraph.AddDependency(clear_task, gather_task);
+    }
+
+    unsigned spread_forces_task = mTaskGraph.AddTask(ExecuteTimestepTask, this, SPREAD_FORCES_TASK);
+    mTaskGraph.AddDependency(gather_task, spread_forces_task);
+
+    // If sources are active, they are spread to their grid, which is cleared with the forces, alongside the forces
+    if (mpCellPopulation->DoesPopulationHaveActiveSources())
+    {
+        unsigned balance_task = mTaskGraph.AddTask(ExecuteTimestepTask, this, BALANCE_FLUID_SOURCES_TASK);
+        unsigned spread_sources_task = mTaskGraph.AddTask(ExecuteTimestepTask, this, SPREAD_FLUID_SOURCES_TASK);
+        mTaskGraph.AddDependency(balance_task, spread_sources_task);
+        mTaskGraph.AddDependency(clear_task, spread_sources_task);
+    }
+
+    mTaskGraph.Run(mNumTaskGraphThreads);
+
+    if (mUseSemiImplicitMembraneUpdate)
+    {
+        this->UpdateImplicitMembraneCoefficients();
+    }
+    else if (!mpCellPopulation->rGetImplicitMembraneCoefficients().empty())
+    {
+        // The population corrects displacements whenever it holds coefficients, so stale ones must not linger
+        mpCellPopulation->SetImplicitMembraneCoefficients(std::vector<double>());
+    }
+
+    mpPhaseTimer->StartPhase(SOLVE_NAVIER_STOKES);
+    this->SolveNavierStokesSpectral();
+    mpPhaseTimer->StopPhase(SOLVE_NAVIER_STOKES);
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::UpdateImplicitMembraneCoefficients()
+{
+    std::vector<double> spring_constants(mpMesh->GetNumAllElements(), 0.0);
+    for (unsigned force_idx = 0; force_idx < mForceCollection.size(); force_idx++)
+    {
+        mForceCollection[force_idx]->AddElementSpringConstants(spring_constants);
+    }
+
+    // The stencil determines how finely the fluid resolves a wavy membrane
+    std::vector<double> offsets;
+    std::vector<double> weights;
+    switch (mpCellPopulation->GetStencilWidth())
+    {
+        case 3:
+            SampleStencilWeights<3>(offsets, weights);
+            break;
+        case 4:
+            SampleStencilWeights<4>(offsets, weights);
+            break;
+        case 6:
+            SampleStencilWeights<6>(offsets, weights);
+            break;
+        default:
+            NEVER_REACHED;
+    }
+
+    double dt = SimulationTime::Instance()->GetTimeStep();
+    double grid_spacing = sqrt(mGridSpacingX * mGridSpacingY);
+
+    /*
+     * A sheet of nodes a distance dl apart, displaced by a small sinusoid exp(i theta n) along the sheet, is pulled
+     * back by its springs with a force of 2k(1 - cos(theta)) times the displacement.  Spread to the grid, this is a
+     * line force density of wavenumber kappa = theta / dl, and over one step the fluid's velocity response is that
+     * of the semi-discrete Stokes operator, Re / (2 sqrt(Re / dt + kappa^2)) per unit force density, filtered twice by
+     * the stencil: on spreading the force and interpolating the velocity.  Wavenumbers the grid cannot resolve are not
+     * moved at all.  The coefficient takes the mobility of the wavelength relaxing fastest.
+     */
+    const unsigned num_samples = 32;
+    std::vector<double> coefficients(spring_constants.size(), 0.0);
+    for (typename ImmersedBoundaryMesh<DIM, DIM>::ImmersedBoundaryElementIterator elem_iter = mpMesh->GetElementIteratorBegin();
+         elem_iter != mpMesh->GetElementIteratorEnd();
+         ++elem_iter)
+    {
+        unsigned elem_idx = elem_iter->GetIndex();
+        if (spring_constants[elem_idx] <= 0.0)
+        {
+            continue;
+        }
+
+        double node_spacing = mpMesh->GetAverageNodeSpacingOfElement(elem_idx, false);
+
+        double max_rate = 0.0;
+        double mobility = 0.0;
+        for (unsigned sample = 1; sample <= num_samples; sample++)
+        {
+            double theta = M_PI * sample / num_samples;
+            double wavenumber = theta / node_spacing;
+            if (wavenumber * grid_spacing >= M_PI)
             {
-                output[0][x][y] = input[0][x][y] * (input[0][next_x][y] - input[0][x][y]) / mGridSpacingX;
-                output[1][x][y] = input[0][x][y] * (input[1][next_x][y] - input[1][x][y]) / mGridSpacingX;
+                break;
             }
 
-            // Then add values from conditional on y grid
-            if (input[1][x][y] > 0)
+            double transform = 0.0;
+            for (unsigned i = 0; i < weights.size(); i++)
             {
-                output[0][x][y] += input[1][x][y] * (input[0][x][y] - input[0][x][prev_y]) / mGridSpacingY;
-                output[1][x][y] += input[1][x][y] * (input[1][x][y] - input[1][x][prev_y]) / mGridSpacingY;
+                transform += weights[i] * cos(wavenumber * grid_spacing * offsets[i]);
             }
-            else
+
+            double sample_mobility = mReynoldsNumber / (2.0 * sqrt(mReynoldsNumber / dt + wavenumber * wavenumber)) * transform * transform;
+            double rate = sample_mobility * (2.0 - 2.0 * cos(theta));
+            if (rate > max_rate)
             {
-                output[0][x][y] += input[1][x][y] * (input[0][x][next_y] - input[0][x][y]) / mGridSpacingY;
-                output[1][x][y] += input[1][x][y] * (input[1][x][next_y] - input[1][x][y]) / mGridSpacingY;
+                max_rate = rate;
+                mobility = sample_mobility;
             }
-
-            prev_y = (prev_y + 1) % mNumGridPtsY;
-            next_y = (next_y + 1) % mNumGridPtsY;
         }
 
-        prev_x = (prev_x + 1) % mNumGridPtsX;
-        next_x = (next_x + 1) % mNumGridPtsX;
+        coefficients[elem_idx] = mSemiImplicitSafetyFactor * dt * spring_constants[elem_idx] * mobility;
     }
+
+    mpCellPopulation->SetImplicitMembraneCoefficients(coefficients);
 }
 
 template<unsigned DIM>
-void ImmersedBoundarySimulationModifier<DIM>::CalculateSourceGradients(const multi_array<double, 3>& rhs, multi_array<double, 3>& gradients)
+template<unsigned WIDTH>
+void ImmersedBoundarySimulationModifier<DIM>::SampleStencilWeights(std::vector<double>& rOffsets, std::vector<double>& rWeights)
 {
-    // \todo: this assumes mGridSpacingX = mGridSpacingY (fine for the foreseeable future)
-    double factor = 1.0 / (2.0 * mGridSpacingX);
-
-    // The fluid sources are stored in the third slice of the rhs grids
-    for (unsigned x = 0; x < mNumGridPtsX; x++)
+    // A point on a grid point in the middle of the domain, whose stencil is summed over y to give its weights in x
+    unsigned centre_x = mNumGridPtsX / 2;
+    unsigned centre_y = mNumGridPtsY / 2;
+    ImmersedBoundaryStencil<WIDTH> stencil(mNumGridPtsX, mNumGridPtsY, mpMesh->GetDomainWidth(), mpMesh->GetDomainHeight(),
+                                           false, false);
+    stencil.Update(centre_x * mGridSpacingX, centre_y * mGridSpacingY);
+
+    rOffsets.resize(WIDTH);
+    rWeights.resize(WIDTH);
+    for (unsigned x_idx = 0; x_idx < WIDTH; x_idx++)
     {
-        unsigned next_x = (x + 1) % mNumGridPtsX;
-        unsigned prev_x = (x + mNumGridPtsX - 1) % mNumGridPtsX;
-
-        for (unsigned y = 0; y < mNumGridPtsY; y++)
+        rOffsets[x_idx] = (double) stencil.GetIndexX(x_idx) - (double) centre_x;
+        rWeights[x_idx] = 0.0;
+        for (unsigned y_idx = 0; y_idx < WIDTH; y_idx++)
         {
-            unsigned next_y = (y + 1) % mNumGridPtsY;
-            unsigned prev_y = (y + mNumGridPtsY - 1) % mNumGridPtsY;
-
-            gradients[0][x][y] = factor * (rhs[2][next_x][y] - rhs[2][prev_x][y]);
-            gradients[1][x][y] = factor * (rhs[2][x][next_y] - rhs[2][x][prev_y]);
+            rWeights[x_idx] += stencil.GetWeight(x_idx, y_idx);
         }
     }
 }
 
 template<unsigned DIM>
-void ImmersedBoundarySimulationModifier<DIM>::SetMemberVariablesForTesting(unsigned numGridPtsY, unsigned numGridPtsX)
+void ImmersedBoundarySimulationModifier<DIM>::ExecuteTimestepTask(void* pModifier, unsigned task)
 {
-    mNumGridPtsY = numGridPtsY;
-    mNumGridPtsX = numGridPtsX;
-    mFftNorm = sqrt(numGridPtsX * numGridPtsY);
-
-    mGridSpacingY = 1.0 / (double)mNumGridPtsY;
-    mGridSpacingX = 1.0 / (double)mNumGridPtsX;
+    static_cast<ImmersedBoundarySimulationModifier<DIM>*>(pModifier)->RunTimestepTask(task);
 }
 
 template<unsigned DIM>
-void ImmersedBoundarySimulationModifier<DIM>::SetNodeNeighbourUpdateFrequency(unsigned newFrequency)
+void ImmersedBoundarySimulationModifier<DIM>::RunTimestepTask(unsigned task)
 {
-    assert(newFrequency > 0);
-    mNodeNeighbourUpdateFrequency = newFrequency;
+    ImmersedBoundaryNodeArrays<DIM>& r_node_arrays = mpMesh->rGetNodeArrays();
+
+    if (task >= CALCULATE_FORCE_TASK)
+    {
+        // With more than one force, each is calculated into its own copy of the node arrays, whose forces are clear
+        unsigned force_idx = task - CALCULATE_FORCE_TASK;
+        ImmersedBoundaryNodeArrays<DIM>* p_arrays = &r_node_arrays;
+        if (!mForceBuffers.empty())
+        {
+            p_arrays = &(mForceBuffers[force_idx]);
+            *p_arrays = r_node_arrays;
+        }
+
+        mpPhaseTimer->StartPhase(mForcePhases[force_idx]);
+        mForceCollection[force_idx]->AddForceContributionsToNodeArrays(*mpNodePairList, *p_arrays, *mpCellPopulation);
+        mpPhaseTimer->StopPhase(mForcePhases[force_idx]);
+        return;
+    }
+
+    switch (task)
+    {
+        case CLEAR_FORCES_AND_SOURCES_TASK:
+        {
+            mpPhaseTimer->StartPhase(CLEAR_FORCES_AND_SOURCES);
+            this->ClearForcesAndSources();
+            mpPhaseTimer->StopPhase(CLEAR_FORCES_AND_SOURCES);
+
+            // Timed from here until the contributions of every force have been gathered
+            mpPhaseTimer->StartPhase(ADD_FORCE_CONTRIBUTIONS);
+            break;
+        }
+        case CALCULATE_NODE_PAIRS_TASK:
+        {
+            this->CalculateNodePairs();
+            break;
+        }
+        case GATHER_FORCES_TASK:
+        {
+            for (unsigned buffer_idx = 0; buffer_idx < mForceBuffers.size(); buffer_idx++)
+            {
+                const ImmersedBoundaryNodeArrays<DIM>& r_buffer = mForceBuffers[buffer_idx];
+                for (unsigned slot = 0; slot < r_node_arrays.GetNumSlots(); slot++)
+                {
+                    double* p_force = r_node_arrays.GetAppliedForce(slot);
+                    const double* p_contribution = r_buffer.GetAppliedForce(slot);
+                    for (unsigned dim = 0; dim < DIM; dim++)
+                    {
+                        p_force[dim] += p_contribution[dim];
+                    }
+                }
+            }
+            mpPhaseTimer->StopPhase(ADD_FORCE_CONTRIBUTIONS);
+            break;
+        }
+        case SPREAD_FORCES_TASK:
+        {
+            mpPhaseTimer->StartPhase(PROPAGATE_FORCES_TO_FLUID_GRID);
+            this->PropagateForcesToFluidGrid();
+            mpPhaseTimer->StopPhase(PROPAGATE_FORCES_TO_FLUID_GRID);
+            break;
+        }
+        case BALANCE_FLUID_SOURCES_TASK:
+        {
+            // Timed until the sources have been spread
+            mpPhaseTimer->StartPhase(PROPAGATE_FLUID_SOURCES_TO_GRID);
+            mpMesh->rGetFluidSourceRegistry().ApplyBalancingStrength();
+            break;
+        }
+        case SPREAD_FLUID_SOURCES_TASK:
+        {
+            this->SpreadFluidSourcesToGrid();
+            mpPhaseTimer->StopPhase(PROPAGATE_FLUID_SOURCES_TO_GRID);
+            break;
+        }
+        default:
+            NEVER_REACHED;
+    }
 }
 
 template<unsigned DIM>
-unsigned ImmersedBoundarySimulationModifier<DIM>::GetNodeNeighbourUpdateFrequency()
+void ImmersedBoundarySimulationModifier<DIM>::SetupConstantMemberVariables(AbstractCellPopulation<DIM,DIM>& rCellPopulation)
 {
-    return mNodeNeighbourUpdateFrequency;
+    if (dynamic_cast<ImmersedBoundaryCellPopulation<DIM> *>(&rCellPopulation) == NULL)
+    {
+        EXCEPTION("Cell population must be immersed boundary");
+    }
+
+    mpCellPopulation = static_cast<ImmersedBoundaryCellPopulation<DIM> *>(&rCellPopulation);
+    mpMesh = &(mpCellPopulation->rGetMesh());
+
+    // Get the size of the mesh
+    mNumGridPtsX = mpMesh->GetNumGridPtsX();
+    mNumGridPtsY = mpMesh->GetNumGridPtsY();
+
+    // Get the grid spacing, which may differ between dimensions in a rectangular domain
+    mGridSpacingX = mpMesh->GetDomainWidth() / (double) mNumGridPtsX;
+    mGridSpacingY = mpMesh->GetDomainHeight() / (double) mNumGridPtsY;
+
+    // Walls replace periodicity in either direction
+    mWallsX = mpMesh->HasWalls(0);
+    mWallsY = mpMesh->HasWalls(1);
+
+    // Set up the node pair list, which wraps around the period of the domain, which is doubled between walls
+    double cutoff = mpCellPopulation->GetInteractionDistance() + mNeighbourSkin;
+    mpNodePairList = new ImmersedBoundaryNodePairList<DIM>(cutoff, mpMesh->rGetPeriods()[0], mpMesh->rGetPeriods()[1]);
+    if (mRestartCheckpointPath == "")
+    {
+        this->CalculateNodePairs();
+    }
+
+    // The cell population times its node updates alongside the phases timed here
+    mpCellPopulation->SetPhaseTimer(mpPhaseTimer);
+
+    // The number of FFT threads may be overridden from the environment, for instance by a cluster job script
+    const char* p_num_threads = std::getenv("IB_NUM_FFT_THREADS");
+    if (p_num_threads != NULL)
+    {
+        int num_threads = std::atoi(p_num_threads);
+        if (num_threads < 1)
+        {
+            EXCEPTION("IB_NUM_FFT_THREADS must be a positive integer");
+        }
+        mNumFftThreads = (unsigned) num_threads;
+    }
+
+    // Set default bounds for adaptive timestepping, and tell the population to use the adapted timestep
+    if (mUseAdaptiveTimestep)
+    {
+        double dt = SimulationTime::Instance()->GetTimeStep();
+        if (mMinTimestep == 0.0)
+        {
+            mMinTimestep = 0.01 * dt;
+        }
+        if (mMaxTimestep == 0.0)
+        {
+            mMaxTimestep = 100.0 * dt;
+        }
+        mpCellPopulation->SetUseSimulationTimeStep(true);
+    }
+
+    // Set up dimension-dependent variables
+    switch (DIM)
+    {
+        case 2:
+        {
+            // The grids are allocated in the precision of the solve; walls are only supported in double precision
+            if (mUseSinglePrecisionFluid)
+            {
+                mpSinglePrecisionArrays = new ImmersedBoundary2dArrays<DIM, float>(mpMesh,
+                                                                                   SimulationTime::Instance()->GetTimeStep(),
+                                                                                   mReynoldsNumber,
+                                                                                   mpCellPopulation->DoesPopulationHaveActiveSources(),
+                                                                                   mUseLowMemoryGrids,
+                                                                                   mNumFftThreads);
+            }
+            else
+            {
+                mpArrays = new ImmersedBoundary2dArrays<DIM>(mpMesh,
+                                                             SimulationTime::Instance()->GetTimeStep(),
+                                                             mReynoldsNumber,
+                                                             mpCellPopulation->DoesPopulationHaveActiveSources(),
+                                                             mUseLowMemoryGrids,
+                                                             mNumFftThreads);
+            }
+
+            if (mpFftInterfaceFactory && (mpMesh->HasWalls() || mpSharedFftInterface || mUseSinglePrecisionFluid))
+            {
+                EXCEPTION("An FFT interface factory may only be used for periodic transforms in double precision, without a shared FFT interface");
+            }
+
+            if (mpMesh->HasWalls())
+            {
+                // The pressure has no complex Fourier grid, and the velocity no Fourier transform, between walls
+                if (mpSharedFftInterface || mStorePressureGrid)
+                {
+                    EXCEPTION("A domain bounded by walls cannot share FFT plans or store the pressure grid");
+                }
+                for (unsigned i = 0; i < mFluidReducers.size(); i++)
+                {
+                    if (mFluidReducers[i]->UsesFourierGrids())
+                    {
+                        EXCEPTION("Fluid reducers using the Fourier grids are not supported in a domain bounded by walls");
+                    }
+                }
+
+                mpFftInterface = new ImmersedBoundaryFftInterface<DIM>(mNumGridPtsX,
+                                                                       mNumGridPtsY,
+                                                                       mWallsX,
+                                                                       mWallsY,
+                                                                       &(mpArrays->rGetModifiableRightHandSideGrids()[0][0][0]),
+                                                                       &(mpMesh->rGetModifiable2dVelocityGrids()[0][0][0]),
+                                                                       mNumFftThreads,
+                                                                       mpCellPopulation->DoesPopulationHaveActiveSources());
+            }
+            else if (mpFftInterfaceFactory)
+            {
+                mpFftInterface = mpFftInterfaceFactory->CreateFftInterface(mpMesh,
+                                                                           &(mpArrays->rGetModifiableRightHandSideGrids()[0][0][0]),
+                                                                           &(mpArrays->rGetModifiableFourierGrids()[0][0][0]),
+                                                                           &(mpMesh->rGetModifiable2dVelocityGrids()[0][0][0]),
+                                                                           mpCellPopulation->DoesPopulationHaveActiveSources());
+            }
+            else if (mpSharedFftInterface)
+            {
+                if (mUseSinglePrecisionFluid)
+                {
+                    EXCEPTION("A shared FFT interface may only be used with a fluid solved in double precision");
+                }
+                mpFftInterface = new ImmersedBoundaryFftInterface<DIM>(*mpSharedFftInterface,
+                                                                       &(mpArrays->rGetModifiableRightHandSideGrids()[0][0][0]),
+                                                                       &(mpArrays->rGetModifiableFourierGrids()[0][0][0]),
+                                                                       &(mpMesh->rGetModifiable2dVelocityGrids()[0][0][0]),
+                                                                       mpCellPopulation->DoesPopulationHaveActiveSources());
+            }
+            else if (mUseSinglePrecisionFluid)
+            {
+                mpFftInterface = new ImmersedBoundaryFftInterface<DIM, float>(mpMesh,
+                                                                              &(mpSinglePrecisionArrays->rGetModifiableRightHandSideGrids()[0][0][0]),
+                                                                              &(mpSinglePrecisionArrays->rGetModifiableFourierGrids()[0][0][0]),
+                                                                              &(mpSinglePrecisionArrays->rGetModifiableOutputGrids()[0][0][0]),
+                                                                              mNumFftThreads,
+                                                                              mpCellPopulation->DoesPopulationHaveActiveSources(),
+                                                                              mUseFastStartFftPlanning);
+            }
+            else
+            {
+                mpFftInterface = new ImmersedBoundaryFftInterface<DIM>(mpMesh,
+                                                                       &(mpArrays->rGetModifiableRightHandSideGrids()[0][0][0]),
+                                                                       &(mpArrays->rGetModifiableFourierGrids()[0][0][0]),
+                                                                       &(mpMesh->rGetModifiable2dVelocityGrids()[0][0][0]),
+                                                                       mNumFftThreads,
+                                                                       mpCellPopulation->DoesPopulationHaveActiveSources(),
+                                                                       mUseFastStartFftPlanning);
+            }
+
+            // Each sine or cosine transform between walls has twice the normalising constant of a periodic one
+            mFftNorm = (mWallsX ? 2.0 : 1.0) * (double) mNumGridPtsX * (mWallsY ? 2.0 : 1.0) * (double) mNumGridPtsY;
+            break;
+        }
+        default:
+            NEVER_REACHED; // Not yet implemented in 3D
+    }
 }
 
 template<unsigned DIM>
-void ImmersedBoundarySimulationModifier<DIM>::AddImmersedBoundaryForce(boost::shared_ptr<AbstractImmersedBoundaryForce<DIM> > pForce)
+void ImmersedBoundarySimulationModifier<DIM>::AdaptTimestep()
 {
-    mForceCollection.push_back(pForce);
+    SimulationTime* p_simulation_time = SimulationTime::Instance();
+
+    double dt = p_simulation_time->GetTimeStep();
+    unsigned remaining_steps = p_simulation_time->GetTotalNumberOfTimeSteps() - p_simulation_time->GetTimeStepsElapsed();
+    if (remaining_steps == 0)
+    {
+        return;
+    }
+
+    // The sampling timestep multiple of the simulation counts from each change, so changes are kept to whole intervals
+    if (this->GetTimeStepsElapsed() % mTimestepAdaptationInterval != 0)
+    {
+        return;
+    }
+
+    // The CFL condition, based on the fastest node in the last call to UpdateNodeLocations()
+    double max_speed = mpCellPopulation->GetMaxNodeSpeed();
+    double min_spacing = std::min(mGridSpacingX, mGridSpacingY);
+    double target_dt = (max_speed > 0.0) ? mCflNumber * min_spacing / max_speed : mMaxTimestep;
+
+    // Limit the rate of growth, and keep within the bounds
+    target_dt = std::min(target_dt, mTimestepGrowthLimit * dt);
+    target_dt = std::max(mMinTimestep, std::min(mMaxTimestep, target_dt));
+
+    // Only act if the timestep must shrink, or can grow appreciably
+    bool must_shrink = target_dt < dt;
+    bool can_grow = target_dt > (1.0 + mTimestepChangeThreshold) * dt;
+    if (!must_shrink && !can_grow)
+    {
+        return;
+    }
+
+    // Choose a whole number of timesteps that reaches the end time exactly
+    double remaining_time = remaining_steps * dt;
+    unsigned num_steps = std::max(1u, (unsigned) ceil(remaining_time / target_dt));
+    double end_time = p_simulation_time->GetTime() + remaining_time;
+
+    // Resetting SimulationTime restarts its count of timesteps elapsed, so the count so far is kept in the offset
+    mTimeStepsElapsedOffset += p_simulation_time->GetTimeStepsElapsed();
+    mpCellPopulation->SetTimeStepsElapsedOffset(mTimeStepsElapsedOffset);
+    p_simulation_time->ResetEndTimeAndNumberOfTimeSteps(end_time, num_steps);
+    if (mpSinglePrecisionArrays)
+    {
+        mpSinglePrecisionArrays->UpdateTimeStep(p_simulation_time->GetTimeStep());
+    }
+    else
+    {
+        mpArrays->UpdateTimeStep(p_simulation_time->GetTimeStep());
+    }
 }
 
 template<unsigned DIM>
-void ImmersedBoundarySimulationModifier<DIM>::SetReynoldsNumber(double reynoldsNumber)
+void ImmersedBoundarySimulationModifier<DIM>::ClearForcesAndSources()
 {
-    assert(reynoldsNumber > 0.0);
-    mReynoldsNumber = reynoldsNumber;
+    // Clear applied forces, which are held in the node arrays
+    mpMesh->rGetNodeArrays().ClearAppliedForces();
+
+    // Forces which add their contributions through the Node objects also need the nodes' applied forces cleared
+    if (HasForcesNotUsingNodeArrays())
+    {
+        for (typename ImmersedBoundaryMesh<DIM, DIM>::NodeIterator node_iter = mpMesh->GetNodeIteratorBegin(false);
+             node_iter != mpMesh->GetNodeIteratorEnd();
+             ++node_iter)
+        {
+            node_iter->ClearAppliedForce();
+        }
+    }
+
+    /*
+     * The force grids need not be reset here: they are zero on construction, and are cleared as they are consumed in
+     * AssembleRightHandSide2d().
+     */
+
+    // If there are active sources, the relevant grid needs to be reset to zero everywhere
+    if (mpCellPopulation->DoesPopulationHaveActiveSources())
+    {
+        if (mpSinglePrecisionArrays)
+        {
+            ClearFluidSourceGrid(mpSinglePrecisionArrays->rGetModifiableRightHandSideGrids());
+        }
+        else
+        {
+            ClearFluidSourceGrid(mpArrays->rGetModifiableRightHandSideGrids());
+        }
+    }
 }
 
 template<unsigned DIM>
-double ImmersedBoundarySimulationModifier<DIM>::GetReynoldsNumber()
+template<typename SCALAR>
+void ImmersedBoundarySimulationModifier<DIM>::ClearFluidSourceGrid(multi_array<SCALAR, 3>& rRhsGrids)
 {
-    return mReynoldsNumber;
+    for (unsigned x = 0; x < mNumGridPtsX; x++)
+    {
+        for (unsigned y = 0; y < mNumGridPtsY; y++)
+        {
+            rRhsGrids[2][x][y] = 0.0;
+        }
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::AddImmersedBoundaryForceContributions()
+{
+    // Add contributions from each immersed boundary force, timing each class of force separately
+    for (unsigned force_idx = 0; force_idx < mForceCollection.size(); force_idx++)
+    {
+        mpPhaseTimer->StartPhase(mForcePhases[force_idx]);
+        mForceCollection[force_idx]->AddForceContributionsToNodeArrays(*mpNodePairList, mpMesh->rGetNodeArrays(), *mpCellPopulation);
+        mpPhaseTimer->StopPhase(mForcePhases[force_idx]);
+    }
+
+    // Gather any contributions added through the Node objects
+    if (HasForcesNotUsingNodeArrays())
+    {
+        mpMesh->AddNodeAppliedForcesToNodeArrays();
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::CalculateNodePairs()
+{
+    mpPhaseTimer->StartPhase(CALCULATE_NODE_PAIRS);
+    mpNodePairList->Build(mpMesh->rGetNodeArrays(), mNumNeighbourThreads);
+    mpPhaseTimer->StopPhase(CALCULATE_NODE_PAIRS);
+
+    mNumNodePairCalculations++;
+    mNumNodesAtLastNodePairCalculation = mpMesh->GetNumNodes();
+    mNumElementsAtLastNodePairCalculation = mpMesh->GetNumElements();
+    mNumReMeshesAtLastNodePairCalculation = mpMesh->GetNumReMeshes();
+    mpCellPopulation->ResetNodeDisplacementBound();
+    mpMesh->rGetTopologyChanges().Clear();
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::UpdateNodePairsAfterTopologyChanges()
+{
+    ImmersedBoundaryTraceSpan span("UpdateNodePairsAfterTopologyChanges", "mesh");
+
+    mpPhaseTimer->StartPhase(CALCULATE_NODE_PAIRS);
+    mpNodePairList->Update(mpMesh->rGetNodeArrays(), mpMesh->rGetTopologyChanges());
+    mpPhaseTimer->StopPhase(CALCULATE_NODE_PAIRS);
+
+    mNumIncrementalNodePairUpdates++;
+    mNumNodesAtLastNodePairCalculation = mpMesh->GetNumNodes();
+    mNumElementsAtLastNodePairCalculation = mpMesh->GetNumElements();
+    mNumReMeshesAtLastNodePairCalculation = mpMesh->GetNumReMeshes();
+    mpMesh->rGetTopologyChanges().Clear();
+}
+
+template<unsigned DIM>
+bool ImmersedBoundarySimulationModifier<DIM>::HasForcesNotUsingNodeArrays()
+{
+    for (unsigned force_idx = 0; force_idx < mForceCollection.size(); force_idx++)
+    {
+        if (!mForceCollection[force_idx]->UsesNodeArrays())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::PropagateForcesToFluidGrid()
+{
+    // The stencil width is a compile-time parameter of the spreading, so dispatch on it here
+    switch (mpCellPopulation->GetStencilWidth())
+    {
+        case 3:
+            PropagateForcesToFluidGridWithStencil<3>();
+            break;
+        case 4:
+            PropagateForcesToFluidGridWithStencil<4>();
+            break;
+        case 6:
+            PropagateForcesToFluidGridWithStencil<6>();
+            break;
+        default:
+            NEVER_REACHED;
+    }
+}
+
+template<unsigned DIM>
+multi_array<double, 3>& ImmersedBoundarySimulationModifier<DIM>::rGetModifiableForceGrids()
+{
+    if (mpSinglePrecisionArrays)
+    {
+        return mpSinglePrecisionArrays->rGetModifiableForceGrids();
+    }
+    return mpArrays->rGetModifiableForceGrids();
+}
+
+template<unsigned DIM>
+template<unsigned WIDTH>
+void ImmersedBoundarySimulationModifier<DIM>::PropagateForcesToFluidGridWithStencil()
+{
+    // The delta function weights are scaled by the reciprocal of the grid cell area
+    const double recip_area = 1.0 / (mGridSpacingX * mGridSpacingY);
+
+    // Get a reference to the force grids which we spread the applied forces to
+    multi_array<double, 3>& force_grids = rGetModifiableForceGrids();
+
+    const ImmersedBoundaryNodeArrays<DIM>& r_node_arrays = mpMesh->rGetNodeArrays();
+    unsigned num_slots = r_node_arrays.GetNumSlots();
+
+    // Store each node's stencil, by slot, for reuse when the fluid velocity is interpolated back to the unmoved nodes
+    ImmersedBoundaryStencilCache& r_cache = mpCellPopulation->rGetNodeStencilCache();
+    r_cache.Reset(WIDTH, num_slots);
+
+    // The force on each node is scaled by the length scale dl, which varies per element
+    std::vector<double> scale_factors(num_slots);
+    std::vector<double> x_coordinates(num_slots);
+
+    for (typename ImmersedBoundaryMesh<DIM, DIM>::ImmersedBoundaryElementIterator elem_iter = mpMesh->GetElementIteratorBegin();
+         elem_iter != mpMesh->GetElementIteratorEnd();
+         ++elem_iter)
+    {
+        unsigned elem_idx = elem_iter->GetIndex();
+        double scale_factor = mpMesh->GetAverageNodeSpacingOfElement(elem_idx, false) * recip_area;
+
+        for (unsigned slot = r_node_arrays.GetElementBegin(elem_idx); slot < r_node_arrays.GetElementEnd(elem_idx); slot++)
+        {
+            scale_factors[slot] = scale_factor;
+            x_coordinates[slot] = r_node_arrays.GetLocation(slot)[0];
+        }
+    }
+
+    // Partition the nodes so that threads spreading different strips never write to the same grid point
+    ImmersedBoundaryStripPartition partition(mNumGridPtsX, WIDTH);
+    partition.Partition(x_coordinates);
+
+    int num_strips = (int) partition.GetNumStrips();
+    for (int phase = 0; phase < 2; phase++)
+    {
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(mNumSpreadingThreads) schedule(dynamic)
+#endif
+        for (int strip = phase; strip < num_strips; strip += 2)
+        {
+            ImmersedBoundaryStencil<WIDTH> stencil(mNumGridPtsX, mNumGridPtsY, mpMesh->GetDomainWidth(), mpMesh->GetDomainHeight(),
+                                                   mWallsX, mWallsY);
+
+            for (unsigned offset = partition.GetStripBegin(strip); offset < partition.GetStripEnd(strip); offset++)
+            {
+                unsigned slot = partition.GetPoint(offset);
+
+                // Get location and applied force contribution of current node
+                const double* p_location = r_node_arrays.GetLocation(slot);
+                const double* p_applied_force = r_node_arrays.GetAppliedForce(slot);
+
+                stencil.Update(p_location[0], p_location[1]);
+                stencil.Store(r_cache, slot);
+
+                // Loop over the grid points used to spread the force on the nodes to the fluid grid
+                double force_x = p_applied_force[0] * scale_factors[slot];
+                double force_y = p_applied_force[1] * scale_factors[slot];
+
+                for (unsigned x_idx = 0; x_idx < WIDTH; x_idx++)
+                {
+                    unsigned x = stencil.GetIndexX(x_idx);
+                    for (unsigned y_idx = 0; y_idx < WIDTH; y_idx++)
+                    {
+                        unsigned y = stencil.GetIndexY(y_idx);
+
+                        // The applied force is weighted by the delta function, and its normal component is odd about a wall
+                        double weight = stencil.GetWeight(x_idx, y_idx);
+
+                        force_grids[0][x][y] += force_x * weight * stencil.GetSignX(x_idx);
+                        force_grids[1][x][y] += force_y * weight * stencil.GetSignY(y_idx);
+                    }
+                }
+            }
+        }
+    }
+
+    r_cache.SetValid();
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::PropagateFluidSourcesToGrid()
+{
+    /*
+     * The registry keeps the total element source strength up to date as strengths are set, so the balancing sources
+     * need only be given their new strength, and only if it has changed.
+     */
+    mpMesh->rGetFluidSourceRegistry().ApplyBalancingStrength();
+
+    this->SpreadFluidSourcesToGrid();
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SpreadFluidSourcesToGrid()
+{
+    if (mpSinglePrecisionArrays)
+    {
+        SpreadFluidSourcesToGrid(mpSinglePrecisionArrays->rGetModifiableRightHandSideGrids());
+    }
+    else
+    {
+        SpreadFluidSourcesToGrid(mpArrays->rGetModifiableRightHandSideGrids());
+    }
+}
+
+template<unsigned DIM>
+template<typename SCALAR>
+void ImmersedBoundarySimulationModifier<DIM>::SpreadFluidSourcesToGrid(multi_array<SCALAR, 3>& rRhsGrids)
+{
+    const ImmersedBoundaryFluidSourceRegistry<DIM>& r_registry = mpMesh->rGetFluidSourceRegistry();
+
+    // Iterate over all sources and propagate their effects to the source grid
+    switch (mpCellPopulation->GetStencilWidth())
+    {
+        case 3:
+            PropagateFluidSourcesToGridWithStencil<3>(r_registry, rRhsGrids);
+            break;
+        case 4:
+            PropagateFluidSourcesToGridWithStencil<4>(r_registry, rRhsGrids);
+            break;
+        case 6:
+            PropagateFluidSourcesToGridWithStencil<6>(r_registry, rRhsGrids);
+            break;
+        default:
+            NEVER_REACHED;
+    }
+}
+
+template<unsigned DIM>
+template<unsigned WIDTH, typename SCALAR>
+void ImmersedBoundarySimulationModifier<DIM>::PropagateFluidSourcesToGridWithStencil(const ImmersedBoundaryFluidSourceRegistry<DIM>& rRegistry,
+                                                                                     multi_array<SCALAR, 3>& rRhsGrids)
+{
+    // The delta function weights are scaled by the reciprocal of the grid cell area
+    const double recip_area = 1.0 / (mGridSpacingX * mGridSpacingY);
+
+    // Currently the fluid source grid is the final part of the right hand side grid, as having all three grids
+    // contiguous helps improve the Fourier transform performance.
+    //\todo could make this nicer by using boost multiarray 'slice'?
+
+    // Store each source's stencil for reuse when the fluid velocity is interpolated back to the unmoved sources
+    ImmersedBoundaryStencilCache& r_cache = mpCellPopulation->rGetSourceStencilCache();
+    unsigned num_sources = rRegistry.GetNumSources();
+    r_cache.Reset(WIDTH, num_sources);
+
+    // Partition the sources so that threads spreading different strips never write to the same grid point
+    std::vector<double> x_coordinates(num_sources);
+    for (unsigned source_idx = 0; source_idx < num_sources; source_idx++)
+    {
+        x_coordinates[source_idx] = rRegistry.GetLocation(source_idx)[0];
+    }
+
+    ImmersedBoundaryStripPartition partition(mNumGridPtsX, WIDTH);
+    partition.Partition(x_coordinates);
+
+    int num_strips = (int) partition.GetNumStrips();
+    for (int phase = 0; phase < 2; phase++)
+    {
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(mNumSpreadingThreads) schedule(dynamic)
+#endif
+        for (int strip = phase; strip < num_strips; strip += 2)
+        {
+            ImmersedBoundaryStencil<WIDTH> stencil(mNumGridPtsX, mNumGridPtsY, mpMesh->GetDomainWidth(), mpMesh->GetDomainHeight(),
+                                                   mWallsX, mWallsY);
+
+            for (unsigned offset = partition.GetStripBegin(strip); offset < partition.GetStripEnd(strip); offset++)
+            {
+                unsigned source_idx = partition.GetPoint(offset);
+
+                // Get location and strength of this source
+                const double* p_location = rRegistry.GetLocation(source_idx);
+                double source_strength = rRegistry.GetStrength(source_idx) * recip_area;
+
+                stencil.Update(p_location[0], p_location[1]);
+                stencil.Store(r_cache, source_idx);
+
+                // Loop over the grid points needed to spread the source strength to the source grid
+                for (unsigned x_idx = 0; x_idx < WIDTH; x_idx++)
+                {
+                    unsigned x = stencil.GetIndexX(x_idx);
+                    for (unsigned y_idx = 0; y_idx < WIDTH; y_idx++)
+                    {
+                        // The strength is weighted by the delta function
+                        rRhsGrids[2][x][stencil.GetIndexY(y_idx)] += source_strength * stencil.GetWeight(x_idx, y_idx);
+                    }
+                }
+            }
+        }
+    }
+
+    r_cache.SetValid();
+}
+
+#include "Debug.hpp"
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SolveNavierStokesSpectral()
+{
+    if (mpSinglePrecisionArrays)
+    {
+        SolveNavierStokesSpectral(*mpSinglePrecisionArrays);
+    }
+    else
+    {
+        SolveNavierStokesSpectral(*mpArrays);
+    }
+}
+
+template<unsigned DIM>
+template<typename SCALAR>
+void ImmersedBoundarySimulationModifier<DIM>::SolveNavierStokesSpectral(ImmersedBoundary2dArrays<DIM, SCALAR>& rArrays)
+{
+    // Get references to all the necessary grids
+    multi_array<double, 3>& vel_grids   = mpMesh->rGetModifiable2dVelocityGrids();
+    multi_array<double, 3>& force_grids = rArrays.rGetModifiableForceGrids();
+    multi_array<SCALAR, 3>& rhs_grids   = rArrays.rGetModifiableRightHandSideGrids();
+
+    // The force grids are written after the solve, which clears them
+    if (mWriteFluidGridsThisStep)
+    {
+        mOutputForceGrids.resize(extents[2][mNumGridPtsX][mNumGridPtsY]);
+        std::copy(force_grids.data(), force_grids.data() + mOutputForceGrids.num_elements(), mOutputForceGrids.data());
+    }
+
+    // Perform upwind differencing and create RHS of linear system, in a single pass which also clears the force grids
+    mpPhaseTimer->StartPhase(ASSEMBLE_RIGHT_HAND_SIDE);
+    if (mpCellPopulation->DoesPopulationHaveActiveSources())
+    {
+        AssembleRightHandSide2d<true>(vel_grids, force_grids, rhs_grids);
+    }
+    else
+    {
+        AssembleRightHandSide2d<false>(vel_grids, force_grids, rhs_grids);
+    }
+    mpPhaseTimer->StopPhase(ASSEMBLE_RIGHT_HAND_SIDE);
+
+    /*
+     * Between walls, which are only supported in double precision, the real-to-real DFTs are done in place on the
+     * right hand side grids, and the inverse DFTs output to vel_grids.
+     */
+    if (rArrays.HasWalls())
+    {
+        mpPhaseTimer->StartPhase(FORWARD_FFT);
+        mpFftInterface->FftExecuteForward();
+        mpPhaseTimer->StopPhase(FORWARD_FFT);
+
+        mpPhaseTimer->StartPhase(SOLVE_IN_FOURIER_DOMAIN);
+        SolveWithRealTransforms(mpArrays->rGetModifiableRightHandSideGrids());
+        mpPhaseTimer->StopPhase(SOLVE_IN_FOURIER_DOMAIN);
+
+        mpPhaseTimer->StartPhase(INVERSE_FFT);
+        mpFftInterface->FftExecuteInverse();
+        mpPhaseTimer->StopPhase(INVERSE_FFT);
+        return;
+    }
+
+    /*
+     * The result of a DFT of n real datapoints is n/2 + 1 complex values, due to redundancy: element n-1 is conj(2),
+     * etc.  A similar pattern of redundancy occurs in a 2D transform.  Calculations in the Fourier domain preserve this
+     * redundancy, and so all calculations need only be done on reduced-size arrays, saving memory and computation.
+     */
+
+    // Perform fft on rhs_grids; results go to fourier_grids
+    mpPhaseTimer->StartPhase(FORWARD_FFT);
+    mpFftInterface->FftExecuteForward();
+    mpPhaseTimer->StopPhase(FORWARD_FFT);
+
+    mpPhaseTimer->StartPhase(SOLVE_IN_FOURIER_DOMAIN);
+    SolveInFourierDomain(rArrays.rGetModifiableFourierGrids(),
+                         rArrays.rGetOperator2(),
+                         rArrays.rGetReciprocalOperator1(),
+                         rArrays.rGetNormalisedReciprocalOperator2(),
+                         rArrays.rGetImagSin2xOverSpacing(),
+                         rArrays.rGetImagSin2yOverSpacing(),
+                         rArrays.rGetModifiablePressureGrid());
+    mpPhaseTimer->StopPhase(SOLVE_IN_FOURIER_DOMAIN);
+
+    // The inverse transform overwrites the Fourier grids, so the reducers using them are run first
+    if (mReduceFourierGridsThisStep)
+    {
+        ReduceFourierGrids(rArrays.rGetModifiableFourierGrids());
+    }
+
+    // Perform inverse fft on fourier_grids; results are in vel_grids, or in the output grids in single precision
+    mpPhaseTimer->StartPhase(INVERSE_FFT);
+    mpFftInterface->FftExecuteInverse();
+
+    // The copy to the velocity grids is timed with the transform
+    multi_array_ref<SCALAR, 3>& output_grids = rArrays.rGetModifiableOutputGrids();
+    if (output_grids.num_elements() > 0)
+    {
+        std::copy(output_grids.data(), output_grids.data() + vel_grids.num_elements(), vel_grids.data());
+    }
+    mpPhaseTimer->StopPhase(INVERSE_FFT);
+}
+
+template<unsigned DIM>
+template<typename SCALAR>
+void ImmersedBoundarySimulationModifier<DIM>::SolveInFourierDomain(multi_array<std::complex<SCALAR>, 3>& rFourierGrids,
+                                                                   const multi_array<SCALAR, 2>& rOperator2,
+                                                                   const multi_array<SCALAR, 2>& rReciprocalOperator1,
+                                                                   const multi_array<SCALAR, 2>& rNormalisedReciprocalOperator2,
+                                                                   const std::vector<std::complex<SCALAR> >& rImagSin2x,
+                                                                   const std::vector<std::complex<SCALAR> >& rImagSin2y,
+                                                                   multi_array_ref<std::complex<SCALAR>, 2>& rPressureGrid)
+{
+    unsigned reduced_size = 1 + (mNumGridPtsY/2);
+
+    /*
+     * The pressure and the updated velocities are calculated in a single pass over the Fourier grids.  The pressure is
+     * fixed to be zero at four locations, which is accounted for by the reciprocal of the first operator being zero
+     * there.  The DFT normalisation is folded into the (reciprocal) second operator, so the output from the inverse
+     * DFT is correct without further scaling.
+     */
+    const bool active_sources = mpCellPopulation->DoesPopulationHaveActiveSources();
+    const SCALAR dt_over_re = (SCALAR) (SimulationTime::Instance()->GetTimeStep() / mReynoldsNumber);
+
+    for (unsigned x = 0; x < mNumGridPtsX; x++)
+    {
+        for (unsigned y = 0; y < reduced_size; y++)
+        {
+            std::complex<SCALAR> divergence = rImagSin2x[x] * rFourierGrids[0][x][y] + rImagSin2y[y] * rFourierGrids[1][x][y];
+
+            // If the population has active fluid sources, the pressure calculation is slightly more complicated
+            std::complex<SCALAR> pressure = active_sources ?
+                    (rOperator2[x][y] * rFourierGrids[2][x][y] - divergence) * rReciprocalOperator1[x][y] :
+                    -divergence * rReciprocalOperator1[x][y];
+
+            if (mStorePressureGrid)
+            {
+                rPressureGrid[x][y] = pressure;
+            }
+
+            rFourierGrids[0][x][y] = (rFourierGrids[0][x][y] - dt_over_re * rImagSin2x[x] * pressure) * rNormalisedReciprocalOperator2[x][y];
+            rFourierGrids[1][x][y] = (rFourierGrids[1][x][y] - dt_over_re * rImagSin2y[y] * pressure) * rNormalisedReciprocalOperator2[x][y];
+        }
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SolveWithRealTransforms(multi_array<double, 3>& rCoefficientGrids)
+{
+    const std::vector<unsigned>& r_gradient_indices_x = mpArrays->rGetGradientIndices(0);
+    const std::vector<unsigned>& r_gradient_indices_y = mpArrays->rGetGradientIndices(1);
+    const std::vector<double>& r_gradient_factors_x = mpArrays->rGetGradientFactors(0);
+    const std::vector<double>& r_gradient_factors_y = mpArrays->rGetGradientFactors(1);
+    const std::vector<unsigned>& r_divergence_indices_x = mpArrays->rGetDivergenceIndices(0);
+    const std::vector<unsigned>& r_divergence_indices_y = mpArrays->rGetDivergenceIndices(1);
+    const std::vector<double>& r_divergence_factors_x = mpArrays->rGetDivergenceFactors(0);
+    const std::vector<double>& r_divergence_factors_y = mpArrays->rGetDivergenceFactors(1);
+
+    const multi_array<double, 2>& r_operator_2 = mpArrays->rGetRealOperator2();
+    const multi_array<double, 2>& r_reciprocal_operator_1 = mpArrays->rGetRealReciprocalOperator1();
+    const multi_array<double, 3>& r_normalised_reciprocal_operator_2 = mpArrays->rGetRealNormalisedReciprocalOperator2();
+
+    const bool active_sources = mpCellPopulation->DoesPopulationHaveActiveSources();
+    const double dt_over_re = SimulationTime::Instance()->GetTimeStep() / mReynoldsNumber;
+
+    // The pressure, which is even in both directions, replaces the sources in the third slice
+    for (unsigned x = 0; x < mNumGridPtsX; x++)
+    {
+        for (unsigned y = 0; y < mNumGridPtsY; y++)
+        {
+            double divergence = r_divergence_factors_x[x] * rCoefficientGrids[0][r_divergence_indices_x[x]][y] +
+                                r_divergence_factors_y[y] * rCoefficientGrids[1][x][r_divergence_indices_y[y]];
+
+            rCoefficientGrids[2][x][y] = active_sources ?
+                    (r_operator_2[x][y] * rCoefficientGrids[2][x][y] - divergence) * r_reciprocal_operator_1[x][y] :
+                    -divergence * r_reciprocal_operator_1[x][y];
+        }
+    }
+
+    // Each velocity component is odd in its own direction, so takes the gradient of the pressure from even coefficients
+    for (unsigned x = 0; x < mNumGridPtsX; x++)
+    {
+        unsigned gradient_x = r_gradient_indices_x[x];
+        double factor_x = dt_over_re * r_gradient_factors_x[x];
+
+        for (unsigned y = 0; y < mNumGridPtsY; y++)
+        {
+            double gradient_y = dt_over_re * r_gradient_factors_y[y] * rCoefficientGrids[2][x][r_gradient_indices_y[y]];
+
+            rCoefficientGrids[0][x][y] = (rCoefficientGrids[0][x][y] - factor_x * rCoefficientGrids[2][gradient_x][y]) *
+                                         r_normalised_reciprocal_operator_2[0][x][y];
+            rCoefficientGrids[1][x][y] = (rCoefficientGrids[1][x][y] - gradient_y) * r_normalised_reciprocal_operator_2[1][x][y];
+        }
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::Upwind2dPoint(const double* pRows[2][3],
+                                                            unsigned y,
+                                                            unsigned prevY,
+                                                            unsigned nextY,
+                                                            const double pWallSigns[4],
+                                                            double recipSpacingX,
+                                                            double recipSpacingY,
+                                                            double& rUpwind0,
+                                                            double& rUpwind1)
+{
+    const double vel_x = pRows[0][1][y];
+    const double vel_y = pRows[1][1][y];
+
+    const bool positive_x = vel_x > 0;
+    const bool positive_y = vel_y > 0;
+
+    /*
+     * Both one-sided differences are computed, and the upwind one selected, so the choice compiles to a blend.  A
+     * neighbour reflected in a wall has the opposite sign in the velocity component normal to that wall.
+     */
+    const double here_0 = pRows[0][1][y];
+    const double diff_x_0 = positive_x ? here_0 - pWallSigns[0] * pRows[0][0][y] : pWallSigns[1] * pRows[0][2][y] - here_0;
+    const double diff_y_0 = positive_y ? here_0 - pRows[0][1][prevY] : pRows[0][1][nextY] - here_0;
+
+    const double here_1 = pRows[1][1][y];
+    const double diff_x_1 = positive_x ? here_1 - pRows[1][0][y] : pRows[1][2][y] - here_1;
+    const double diff_y_1 = positive_y ? here_1 - pWallSigns[2] * pRows[1][1][prevY] : pWallSigns[3] * pRows[1][1][nextY] - here_1;
+
+    rUpwind0 = vel_x * diff_x_0 * recipSpacingX + vel_y * diff_y_0 * recipSpacingY;
+    rUpwind1 = vel_x * diff_x_1 * recipSpacingX + vel_y * diff_y_1 * recipSpacingY;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::GetWallSigns(unsigned x, double signs[3][4])
+{
+    // The x neighbours are reflected only at the first and last rows, and the y neighbours at the first and last points
+    double sign_prev_x = (mWallsX && x == 0) ? -1.0 : 1.0;
+    double sign_next_x = (mWallsX && x == mNumGridPtsX - 1) ? -1.0 : 1.0;
+    double sign_wall_y = mWallsY ? -1.0 : 1.0;
+
+    for (unsigned point = 0; point < 3; point++)
+    {
+        signs[point][0] = sign_prev_x;
+        signs[point][1] = sign_next_x;
+        signs[point][2] = (point == 0 || (point == 1 && mNumGridPtsY == 1)) ? sign_wall_y : 1.0;
+        signs[point][3] = (point == 2 || (point == 1 && mNumGridPtsY == 1)) ? sign_wall_y : 1.0;
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::Upwind2d(const multi_array<double, 3>& input, multi_array<double, 3>& output)
+{
+    const double recip_spacing_x = 1.0 / mGridSpacingX;
+    const double recip_spacing_y = 1.0 / mGridSpacingY;
+
+    /*
+     * Each grid is traversed a row (fixed x) at a time using raw pointers into the contiguous multi_array storage.
+     * Periodic wrap-around in x only affects which rows are used, and wrap-around in y is confined to the first and
+     * last point of each row, so the interior loop has no modular arithmetic or data-dependent branches.  At a wall,
+     * the neighbour beyond it is the reflection of the point itself, with signs as given by GetWallSigns().
+     */
+    for (unsigned x = 0; x < mNumGridPtsX; x++)
+    {
+        unsigned prev_x = (x == 0) ? (mWallsX ? 0 : mNumGridPtsX - 1) : x - 1;
+        unsigned next_x = (x == mNumGridPtsX - 1) ? (mWallsX ? x : 0) : x + 1;
+
+        double signs[3][4];
+        GetWallSigns(x, signs);
+
+        const double* p_rows[2][3];
+        for (unsigned dim = 0; dim < 2; dim++)
+        {
+            p_rows[dim][0] = &input[dim][prev_x][0];
+            p_rows[dim][1] = &input[dim][x][0];
+            p_rows[dim][2] = &input[dim][next_x][0];
+        }
+
+        double* p_out_0 = &output[0][x][0];
+        double* p_out_1 = &output[1][x][0];
+
+        if (mNumGridPtsY == 1)
+        {
+            Upwind2dPoint(p_rows, 0, 0, 0, signs[1], recip_spacing_x, recip_spacing_y, p_out_0[0], p_out_1[0]);
+            continue;
+        }
+
+        unsigned last_y = mNumGridPtsY - 1;
+        Upwind2dPoint(p_rows, 0, mWallsY ? 0 : last_y, 1, signs[0], recip_spacing_x, recip_spacing_y, p_out_0[0], p_out_1[0]);
+
+        for (unsigned y = 1; y < last_y; y++)
+        {
+            Upwind2dPoint(p_rows, y, y - 1, y + 1, signs[1], recip_spacing_x, recip_spacing_y, p_out_0[y], p_out_1[y]);
+        }
+
+        Upwind2dPoint(p_rows, last_y, last_y - 1, mWallsY ? last_y : 0, signs[2], recip_spacing_x, recip_spacing_y,
+                      p_out_0[last_y], p_out_1[last_y]);
+    }
+}
+
+template<unsigned DIM>
+template<bool ACTIVE_SOURCES, typename SCALAR>
+void ImmersedBoundarySimulationModifier<DIM>::AssembleRightHandSide2dPoint(const double* pRows[2][3],
+                                                                           const SCALAR* pSourceRows[3],
+                                                                           double* pForces[2],
+                                                                           SCALAR* pRhs[2],
+                                                                           unsigned y,
+                                                                           unsigned prevY,
+                                                                           unsigned nextY,
+                                                                           const double pWallSigns[4],
+                                                                           const double constants[5])
+{
+    double upwind_0;
+    double upwind_1;
+    Upwind2dPoint(pRows, y, prevY, nextY, pWallSigns, constants[0], constants[1], upwind_0, upwind_1);
+
+    const double dt = constants[2];
+    double rhs_0 = pForces[0][y] - upwind_0;
+    double rhs_1 = pForces[1][y] - upwind_1;
+
+    // Central differences of the fluid source strengths, which are even about any wall
+    if (ACTIVE_SOURCES)
+    {
+        rhs_0 += constants[3] * (pSourceRows[2][y] - pSourceRows[0][y]);
+        rhs_1 += constants[4] * (pSourceRows[1][nextY] - pSourceRows[1][prevY]);
+    }
+
+    pRhs[0][y] = (SCALAR) (pRows[0][1][y] + dt * rhs_0);
+    pRhs[1][y] = (SCALAR) (pRows[1][1][y] + dt * rhs_1);
+
+    // The forces have now been consumed, so the force grids are cleared ready for the next timestep
+    pForces[0][y] = 0.0;
+    pForces[1][y] = 0.0;
+}
+
+template<unsigned DIM>
+template<bool ACTIVE_SOURCES, typename SCALAR>
+void ImmersedBoundarySimulationModifier<DIM>::AssembleRightHandSide2d(const multi_array<double, 3>& rVelGrids,
+                                                                      multi_array<double, 3>& rForceGrids,
+                                                                      multi_array<SCALAR, 3>& rRhsGrids)
+{
+    /*
+     * The constants used at each grid point: the reciprocal grid spacings, the timestep, and the factors multiplying
+     * the central differences of the source strengths, which combine 1/(2h) with the 1/(3Re) source coefficient.
+     */
+    const double source_factor = 1.0 / (3.0 * mReynoldsNumber);
+
+    double constants[5];
+    constants[0] = 1.0 / mGridSpacingX;
+    constants[1] = 1.0 / mGridSpacingY;
+    constants[2] = SimulationTime::Instance()->GetTimeStep();
+    constants[3] = source_factor / (2.0 * mGridSpacingX);
+    constants[4] = source_factor / (2.0 * mGridSpacingY);
+
+    // The grid traversal follows Upwind2d(); the fluid sources are stored in the third slice of the rhs grids
+    for (unsigned x = 0; x < mNumGridPtsX; x++)
+    {
+        unsigned prev_x = (x == 0) ? (mWallsX ? 0 : mNumGridPtsX - 1) : x - 1;
+        unsigned next_x = (x == mNumGridPtsX - 1) ? (mWallsX ? x : 0) : x + 1;
+
+        double signs[3][4];
+        GetWallSigns(x, signs);
+
+        const double* p_rows[2][3];
+        double* p_forces[2];
+        SCALAR* p_rhs[2];
+        for (unsigned dim = 0; dim < 2; dim++)
+        {
+            p_rows[dim][0] = &rVelGrids[dim][prev_x][0];
+            p_rows[dim][1] = &rVelGrids[dim][x][0];
+            p_rows[dim][2] = &rVelGrids[dim][next_x][0];
+
+            p_forces[dim] = &rForceGrids[dim][x][0];
+            p_rhs[dim] = &rRhsGrids[dim][x][0];
+        }
+
+        const SCALAR* p_source_rows[3] = {NULL, NULL, NULL};
+        if (ACTIVE_SOURCES)
+        {
+            p_source_rows[0] = &rRhsGrids[2][prev_x][0];
+            p_source_rows[1] = &rRhsGrids[2][x][0];
+            p_source_rows[2] = &rRhsGrids[2][next_x][0];
+        }
+
+        if (mNumGridPtsY == 1)
+        {
+            AssembleRightHandSide2dPoint<ACTIVE_SOURCES>(p_rows, p_source_rows, p_forces, p_rhs, 0, 0, 0, signs[1], constants);
+            continue;
+        }
+
+        unsigned last_y = mNumGridPtsY - 1;
+        AssembleRightHandSide2dPoint<ACTIVE_SOURCES>(p_rows, p_source_rows, p_forces, p_rhs,
+                                                     0, mWallsY ? 0 : last_y, 1, signs[0], constants);
+
+        for (unsigned y = 1; y < last_y; y++)
+        {
+            AssembleRightHandSide2dPoint<ACTIVE_SOURCES>(p_rows, p_source_rows, p_forces, p_rhs,
+                                                         y, y - 1, y + 1, signs[1], constants);
+        }
+
+        AssembleRightHandSide2dPoint<ACTIVE_SOURCES>(p_rows, p_source_rows, p_forces, p_rhs,
+                                                     last_y, last_y - 1, mWallsY ? last_y : 0, signs[2], constants);
+    }
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetMemberVariablesForTesting(unsigned numGridPtsY, unsigned numGridPtsX)
+{
+    mNumGridPtsY = numGridPtsY;
+    mNumGridPtsX = numGridPtsX;
+    mFftNorm = sqrt(numGridPtsX * numGridPtsY);
+
+    mGridSpacingY = 1.0 / (double)mNumGridPtsY;
+    mGridSpacingX = 1.0 / (double)mNumGridPtsX;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetNodeNeighbourUpdateFrequency(unsigned newFrequency)
+{
+    assert(newFrequency > 0);
+    mNodeNeighbourUpdateFrequency = newFrequency;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundarySimulationModifier<DIM>::GetNodeNeighbourUpdateFrequency()
+{
+    return mNodeNeighbourUpdateFrequency;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetNeighbourSkin(double neighbourSkin)
+{
+    assert(neighbourSkin >= 0.0);
+    mNeighbourSkin = neighbourSkin;
+}
+
+template<unsigned DIM>
+double ImmersedBoundarySimulationModifier<DIM>::GetNeighbourSkin()
+{
+    return mNeighbourSkin;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundarySimulationModifier<DIM>::GetNumNodePairCalculations()
+{
+    return mNumNodePairCalculations;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetNumNeighbourThreads(unsigned numNeighbourThreads)
+{
+    assert(numNeighbourThreads > 0);
+    mNumNeighbourThreads = numNeighbourThreads;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundarySimulationModifier<DIM>::GetNumNeighbourThreads()
+{
+    return mNumNeighbourThreads;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetUseIncrementalNodePairUpdates(bool useIncrementalNodePairUpdates)
+{
+    mUseIncrementalNodePairUpdates = useIncrementalNodePairUpdates;
+}
+
+template<unsigned DIM>
+bool ImmersedBoundarySimulationModifier<DIM>::GetUseIncrementalNodePairUpdates()
+{
+    return mUseIncrementalNodePairUpdates;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundarySimulationModifier<DIM>::GetNumIncrementalNodePairUpdates()
+{
+    return mNumIncrementalNodePairUpdates;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::AddImmersedBoundaryForce(boost::shared_ptr<AbstractImmersedBoundaryForce<DIM> > pForce)
+{
+    mForceCollection.push_back(pForce);
+    mForcePhases.push_back(mpPhaseTimer->AddPhase(pForce->GetIdentifier()));
+
+    // The new force's first call must not be concurrent with the others
+    mTaskGraphReady = false;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetReynoldsNumber(double reynoldsNumber)
+{
+    assert(reynoldsNumber > 0.0);
+    mReynoldsNumber = reynoldsNumber;
+}
+
+template<unsigned DIM>
+double ImmersedBoundarySimulationModifier<DIM>::GetReynoldsNumber()
+{
+    return mReynoldsNumber;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetNumFftThreads(unsigned numFftThreads)
+{
+    assert(numFftThreads > 0);
+    mNumFftThreads = numFftThreads;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundarySimulationModifier<DIM>::GetNumFftThreads()
+{
+    return mNumFftThreads;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetSharedFftInterface(const ImmersedBoundaryFftInterface<DIM>* pSharedFftInterface)
+{
+    mpSharedFftInterface = pSharedFftInterface;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetUseFastStartFftPlanning(bool useFastStartFftPlanning)
+{
+    mUseFastStartFftPlanning = useFastStartFftPlanning;
+}
+
+template<unsigned DIM>
+bool ImmersedBoundarySimulationModifier<DIM>::GetUseFastStartFftPlanning()
+{
+    return mUseFastStartFftPlanning;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetFftInterfaceFactory(boost::shared_ptr<AbstractImmersedBoundaryFftInterfaceFactory<DIM> > pFftInterfaceFactory)
+{
+    mpFftInterfaceFactory = pFftInterfaceFactory;
+}
+
+template<unsigned DIM>
+boost::shared_ptr<AbstractImmersedBoundaryFftInterfaceFactory<DIM> > ImmersedBoundarySimulationModifier<DIM>::GetFftInterfaceFactory()
+{
+    return mpFftInterfaceFactory;
+}
+
+template<unsigned DIM>
+AbstractImmersedBoundaryFftInterface<DIM>* ImmersedBoundarySimulationModifier<DIM>::GetFftInterface()
+{
+    return mpFftInterface;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetNumSpreadingThreads(unsigned numSpreadingThreads)
+{
+    assert(numSpreadingThreads > 0);
+    mNumSpreadingThreads = numSpreadingThreads;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundarySimulationModifier<DIM>::GetNumSpreadingThreads()
+{
+    return mNumSpreadingThreads;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetNumTaskGraphThreads(unsigned numTaskGraphThreads)
+{
+    assert(numTaskGraphThreads > 0);
+    mNumTaskGraphThreads = numTaskGraphThreads;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundarySimulationModifier<DIM>::GetNumTaskGraphThreads()
+{
+    return mNumTaskGraphThreads;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetReorderFrequency(unsigned reorderFrequency)
+{
+    mReorderFrequency = reorderFrequency;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundarySimulationModifier<DIM>::GetReorderFrequency()
+{
+    return mReorderFrequency;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetReorderAlongHilbertCurve(bool reorderAlongHilbertCurve)
+{
+    mReorderAlongHilbertCurve = reorderAlongHilbertCurve;
+}
+
+template<unsigned DIM>
+bool ImmersedBoundarySimulationModifier<DIM>::GetReorderAlongHilbertCurve()
+{
+    return mReorderAlongHilbertCurve;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetRemeshFrequency(unsigned remeshFrequency)
+{
+    mRemeshFrequency = remeshFrequency;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundarySimulationModifier<DIM>::GetRemeshFrequency()
+{
+    return mRemeshFrequency;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetRemeshTargetNodeSpacing(double remeshTargetNodeSpacing)
+{
+    assert(remeshTargetNodeSpacing >= 0.0);
+    mRemeshTargetNodeSpacing = remeshTargetNodeSpacing;
+}
+
+template<unsigned DIM>
+double ImmersedBoundarySimulationModifier<DIM>::GetRemeshTargetNodeSpacing()
+{
+    return mRemeshTargetNodeSpacing;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetStorePressureGrid(bool storePressureGrid)
+{
+    mStorePressureGrid = storePressureGrid;
+}
+
+template<unsigned DIM>
+bool ImmersedBoundarySimulationModifier<DIM>::GetStorePressureGrid()
+{
+    return mStorePressureGrid;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetUseSinglePrecisionFluid(bool useSinglePrecisionFluid)
+{
+    mUseSinglePrecisionFluid = useSinglePrecisionFluid;
+}
+
+template<unsigned DIM>
+bool ImmersedBoundarySimulationModifier<DIM>::GetUseSinglePrecisionFluid()
+{
+    return mUseSinglePrecisionFluid;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetUseLowMemoryGrids(bool useLowMemoryGrids)
+{
+    mUseLowMemoryGrids = useLowMemoryGrids;
+}
+
+template<unsigned DIM>
+bool ImmersedBoundarySimulationModifier<DIM>::GetUseLowMemoryGrids()
+{
+    return mUseLowMemoryGrids;
+}
+
+template<unsigned DIM>
+ImmersedBoundary2dArrays<DIM>* ImmersedBoundarySimulationModifier<DIM>::GetArrays()
+{
+    return mpArrays;
+}
+
+template<unsigned DIM>
+ImmersedBoundary2dArrays<DIM, float>* ImmersedBoundarySimulationModifier<DIM>::GetSinglePrecisionArrays()
+{
+    return mpSinglePrecisionArrays;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetUseAdaptiveTimestep(bool useAdaptiveTimestep)
+{
+    mUseAdaptiveTimestep = useAdaptiveTimestep;
+}
+
+template<unsigned DIM>
+bool ImmersedBoundarySimulationModifier<DIM>::GetUseAdaptiveTimestep()
+{
+    return mUseAdaptiveTimestep;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetCflNumber(double cflNumber)
+{
+    assert(cflNumber > 0.0);
+    mCflNumber = cflNumber;
+}
+
+template<unsigned DIM>
+double ImmersedBoundarySimulationModifier<DIM>::GetCflNumber()
+{
+    return mCflNumber;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetAdaptiveTimestepBounds(double minTimestep, double maxTimestep)
+{
+    if (minTimestep <= 0.0 || maxTimestep < minTimestep)
+    {
+        EXCEPTION("Adaptive timestep bounds must satisfy 0 < minTimestep <= maxTimestep");
+    }
+    mMinTimestep = minTimestep;
+    mMaxTimestep = maxTimestep;
+}
+
+template<unsigned DIM>
+double ImmersedBoundarySimulationModifier<DIM>::GetMinTimestep()
+{
+    return mMinTimestep;
+}
+
+template<unsigned DIM>
+double ImmersedBoundarySimulationModifier<DIM>::GetMaxTimestep()
+{
+    return mMaxTimestep;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetTimestepAdaptationInterval(unsigned timestepAdaptationInterval)
+{
+    assert(timestepAdaptationInterval > 0);
+    mTimestepAdaptationInterval = timestepAdaptationInterval;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundarySimulationModifier<DIM>::GetTimestepAdaptationInterval()
+{
+    return mTimestepAdaptationInterval;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundarySimulationModifier<DIM>::GetTimeStepsElapsed() const
+{
+    return mTimeStepsElapsedOffset + SimulationTime::Instance()->GetTimeStepsElapsed();
+}
+
+template<unsigned DIM>
+const ImmersedBoundaryPhaseTimer& ImmersedBoundarySimulationModifier<DIM>::rGetPhaseTimer() const
+{
+    return *mpPhaseTimer;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetTimingOutputFrequency(unsigned timingOutputFrequency)
+{
+    mTimingOutputFrequency = timingOutputFrequency;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundarySimulationModifier<DIM>::GetTimingOutputFrequency()
+{
+    return mTimingOutputFrequency;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetGridOutputFrequency(unsigned gridOutputFrequency)
+{
+    mGridOutputFrequency = gridOutputFrequency;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundarySimulationModifier<DIM>::GetGridOutputFrequency()
+{
+    return mGridOutputFrequency;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::AddFluidReducer(boost::shared_ptr<AbstractImmersedBoundaryFluidReducer> pReducer)
+{
+    mFluidReducers.push_back(pReducer);
+}
+
+template<unsigned DIM>
+const std::vector<boost::shared_ptr<AbstractImmersedBoundaryFluidReducer> >& ImmersedBoundarySimulationModifier<DIM>::rGetFluidReducers() const
+{
+    return mFluidReducers;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetFluidReducerOutputFrequency(unsigned fluidReducerOutputFrequency)
+{
+    mFluidReducerOutputFrequency = fluidReducerOutputFrequency;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundarySimulationModifier<DIM>::GetFluidReducerOutputFrequency()
+{
+    return mFluidReducerOutputFrequency;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetCheckpointFrequency(unsigned checkpointFrequency)
+{
+    mCheckpointFrequency = checkpointFrequency;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundarySimulationModifier<DIM>::GetCheckpointFrequency()
+{
+    return mCheckpointFrequency;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetRestartCheckpoint(const FileFinder& rCheckpointFile)
+{
+    if (!rCheckpointFile.IsFile())
+    {
+        EXCEPTION("Checkpoint file " << rCheckpointFile.GetAbsolutePath() << " does not exist");
+    }
+    mRestartCheckpointPath = rCheckpointFile.GetAbsolutePath();
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetWarmStart(unsigned numSteps, unsigned coarseningFactor, double nodeSpacingMultiplier)
+{
+    if (coarseningFactor < 1 || nodeSpacingMultiplier < 1.0)
+    {
+        EXCEPTION("The warm start coarsening factor and node spacing multiplier must be at least one");
+    }
+    mWarmStartNumSteps = numSteps;
+    mWarmStartCoarseningFactor = coarseningFactor;
+    mWarmStartNodeSpacingMultiplier = nodeSpacingMultiplier;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundarySimulationModifier<DIM>::GetWarmStartNumSteps()
+{
+    return mWarmStartNumSteps;
+}
+
+template<unsigned DIM>
+unsigned ImmersedBoundarySimulationModifier<DIM>::GetWarmStartCoarseningFactor()
+{
+    return mWarmStartCoarseningFactor;
+}
+
+template<unsigned DIM>
+double ImmersedBoundarySimulationModifier<DIM>::GetWarmStartNodeSpacingMultiplier()
+{
+    return mWarmStartNodeSpacingMultiplier;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetUseSemiImplicitMembraneUpdate(bool useSemiImplicitMembraneUpdate)
+{
+    mUseSemiImplicitMembraneUpdate = useSemiImplicitMembraneUpdate;
+
+    // Stop correcting displacements straight away, rather than at the next solve
+    if (!mUseSemiImplicitMembraneUpdate && mpCellPopulation)
+    {
+        mpCellPopulation->SetImplicitMembraneCoefficients(std::vector<double>());
+    }
+}
+
+template<unsigned DIM>
+bool ImmersedBoundarySimulationModifier<DIM>::GetUseSemiImplicitMembraneUpdate()
+{
+    return mUseSemiImplicitMembraneUpdate;
+}
+
+template<unsigned DIM>
+void ImmersedBoundarySimulationModifier<DIM>::SetSemiImplicitSafetyFactor(double semiImplicitSafetyFactor)
+{
+    assert(semiImplicitSafetyFactor > 0.0);
+    mSemiImplicitSafetyFactor = semiImplicitSafetyFactor;
+}
+
+template<unsigned DIM>
+double ImmersedBoundarySimulationModifier<DIM>::GetSemiImplicitSafetyFactor()
+{
+    return mSemiImplicitSafetyFactor;
 }
 
 // Explicit instantiation
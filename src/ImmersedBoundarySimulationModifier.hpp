@@ -38,20 +38,29 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 // Chaste includes
 #include "AbstractCellBasedSimulationModifier.hpp"
-#include "ObsoleteBoxCollection.hpp"
 #include "ChasteSerialization.hpp"
+#include "FileFinder.hpp"
 
 // Immersed boundary includes
+#include "AbstractImmersedBoundaryFftInterfaceFactory.hpp"
+#include "AbstractImmersedBoundaryFluidReducer.hpp"
 #include "AbstractImmersedBoundaryForce.hpp"
 #include "ImmersedBoundaryCellPopulation.hpp"
 #include "ImmersedBoundaryMesh.hpp"
+#include "ImmersedBoundaryNodePairList.hpp"
+#include "ImmersedBoundaryPhaseTimer.hpp"
 #include "ImmersedBoundary2dArrays.hpp"
 #include "ImmersedBoundaryFftInterface.hpp"
+#include "ImmersedBoundaryHdf5GridWriter.hpp"
+#include "ImmersedBoundaryCheckpoint.hpp"
+#include "ImmersedBoundaryStencil.hpp"
+#include "ImmersedBoundaryTaskGraph.hpp"
 
 // Other includes
 #include <complex>
 #include <boost/serialization/base_object.hpp>
 #include <boost/multi_array.hpp>
+#include <boost/shared_ptr.hpp>
 
 /**
  * A modifier class which at each simulation time step implements the immersed
@@ -65,6 +74,7 @@ class ImmersedBoundarySimulationModifier : public AbstractCellBasedSimulationMod
 private:
 
     /** To allow tests to directly access solver methods */
+    friend class TestImmersedBoundaryBenchmarks;
     friend class TestImmersedBoundaryPdeSolveMethods;
     friend class TestImmersedBoundarySimulationModifier;
 
@@ -92,6 +102,40 @@ private:
     /** How often we calculate which cells are neighbours */
     unsigned mNodeNeighbourUpdateFrequency;
 
+    /**
+     * The skin added to the interaction distance when finding node pairs.  If positive, node pairs are recalculated
+     * only once some node may have moved more than half the skin since they were last calculated, or the number of
+     * nodes or elements has changed, and #mNodeNeighbourUpdateFrequency is ignored.  This must be set before SetupSolve().
+     *
+     * Initialised to 0 in the constructor, so node pairs are recalculated at a fixed frequency.
+     */
+    double mNeighbourSkin;
+
+    /** The number of times node pairs have been calculated, including when the simulation is set up. */
+    unsigned mNumNodePairCalculations;
+
+    /** The number of nodes when node pairs were last calculated. */
+    unsigned mNumNodesAtLastNodePairCalculation;
+
+    /** The number of elements when node pairs were last calculated. */
+    unsigned mNumElementsAtLastNodePairCalculation;
+
+    /** The number of times the mesh had been compacted (see ImmersedBoundaryMesh::ReMesh()) when node pairs were last calculated. */
+    unsigned mNumReMeshesAtLastNodePairCalculation;
+
+    /** The number of threads used to calculate node pairs.  Initialised to 1 in the constructor. */
+    unsigned mNumNeighbourThreads;
+
+    /**
+     * Whether the node pairs are updated after division and death, using the changes recorded by the mesh, rather
+     * than recalculated.  Pairs are still recalculated after remeshing or renumbering, and whenever they would be
+     * otherwise.  Initialised to false in the constructor.
+     */
+    bool mUseIncrementalNodePairUpdates;
+
+    /** The number of times node pairs have been updated after division or death rather than recalculated. */
+    unsigned mNumIncrementalNodePairUpdates;
+
     /**
      * Number of grid points in the x direction.
      *
@@ -115,11 +159,14 @@ private:
     /** Normalising constant needed for FFT */
     double mFftNorm;
 
-    /** A box collection to efficiently keep track of node neighbours */
-    ObsoleteBoxCollection<DIM>* mpBoxCollection;
+    /** Whether the domain is bounded by walls normal to the x direction, taken from the mesh. */
+    bool mWallsX;
+
+    /** Whether the domain is bounded by walls normal to the y direction, taken from the mesh. */
+    bool mWallsY;
 
-    /** A vector of pairs of pointers to nodes, representing all possible node-node interactions */
-    std::vector<std::pair<Node<DIM>*, Node<DIM>*> > mNodePairs;
+    /** The pairs of nodes in different elements that are close enough to interact, found using a box partition */
+    ImmersedBoundaryNodePairList<DIM>* mpNodePairList;
 
     /** A map between node indices and a set of their possible neighbours, used calculating cell-cell interactions */
     std::map<unsigned, std::set<unsigned> > mNodeNeighbours;
@@ -137,11 +184,381 @@ private:
     /** A list of force laws to determine the force applied to each node */
     std::vector<boost::shared_ptr<AbstractImmersedBoundaryForce<DIM> > > mForceCollection;
 
-    /** Pointer to structure storing all necessary arrays */
+    /** Pointer to structure storing all necessary arrays, for a fluid solved in double precision; otherwise NULL. */
     ImmersedBoundary2dArrays<DIM>* mpArrays;
 
-    ///\todo Document class member
-    ImmersedBoundaryFftInterface<DIM>* mpFftInterface;
+    /** Pointer to structure storing all necessary arrays, for a fluid solved in single precision; otherwise NULL. */
+    ImmersedBoundary2dArrays<DIM, float>* mpSinglePrecisionArrays;
+
+    /**
+     * Pointer to the backend performing the discrete Fourier transforms, created in SetupConstantMemberVariables().
+     * This is made by #mpFftInterfaceFactory if one is set, and is otherwise an fftw backend of the appropriate
+     * precision.
+     */
+    AbstractImmersedBoundaryFftInterface<DIM>* mpFftInterface;
+
+    /**
+     * The number of threads used to compute the discrete Fourier transforms.
+     *
+     * Initialised to 1 in the constructor.  If the environment variable IB_NUM_FFT_THREADS is set, its value takes
+     * precedence over this member in SetupConstantMemberVariables().
+     */
+    unsigned mNumFftThreads;
+
+    /**
+     * The interface whose fftw plans are shared, or NULL if this modifier plans its own transforms.  This is set by
+     * ImmersedBoundaryEnsemble, so that the simulations of an ensemble plan their transforms only once.
+     */
+    const ImmersedBoundaryFftInterface<DIM>* mpSharedFftInterface;
+
+    /**
+     * The factory making the backend for the discrete Fourier transforms, or NULL for an fftw backend.  This is not
+     * archived, so must be set again after a simulation is loaded.
+     */
+    boost::shared_ptr<AbstractImmersedBoundaryFftInterfaceFactory<DIM> > mpFftInterfaceFactory;
+
+    /**
+     * Whether, if no fftw wisdom is cached, the transforms are first planned quickly and upgraded in the background,
+     * so that a large simulation starts without waiting for FFTW_PATIENT planning.  Defaults to false.
+     */
+    bool mUseFastStartFftPlanning;
+
+    /**
+     * The number of threads used to spread forces and fluid sources to the fluid grid.  This has an effect only when
+     * built with OpenMP, and the results are identical for any number of threads.
+     *
+     * Initialised to 1 in the constructor.
+     */
+    unsigned mNumSpreadingThreads;
+
+    /**
+     * The number of threads on which the phases of each timestep before the fluid solve are run as a task graph, so
+     * that independent phases overlap: each force, the recalculation of the node pairs for forces not using them, and
+     * the spreading of forces and of fluid sources.  With one thread, or without OpenMP, the phases run in turn.
+     *
+     * Initialised to 1 in the constructor.
+     */
+    unsigned mNumTaskGraphThreads;
+
+    /**
+     * Whether the forces have been calculated once, in turn, so that any set up they do on their first call (such as
+     * adding node attributes) is done before they may be calculated concurrently.
+     */
+    bool mTaskGraphReady;
+
+    /**
+     * When more than one force is calculated in the task graph, each adds its contributions to its own copy of the
+     * mesh's node arrays, and these are then summed into the mesh's node arrays.
+     */
+    std::vector<ImmersedBoundaryNodeArrays<DIM> > mForceBuffers;
+
+    /** The task graph used in UpdateFluidVelocityGridsWithTaskGraph(), rebuilt each timestep. */
+    ImmersedBoundaryTaskGraph mTaskGraph;
+
+    /**
+     * The number of time steps after which the nodes and elements are renumbered along a space filling curve, to
+     * restore memory locality lost as cells divide and move.  A value of zero means they are never renumbered.
+     *
+     * Initialised to 0 in the constructor.
+     */
+    unsigned mReorderFrequency;
+
+    /**
+     * Whether renumbering orders along a Hilbert curve, rather than a Morton curve.
+     *
+     * Initialised to true in the constructor.
+     */
+    bool mReorderAlongHilbertCurve;
+
+    /**
+     * The number of time steps after which the nodes of each element are redistributed uniformly along its boundary
+     * (see ImmersedBoundaryMesh::RemeshElements()).  A value of zero means they are never redistributed.
+     *
+     * Initialised to 0 in the constructor.
+     */
+    unsigned mRemeshFrequency;
+
+    /**
+     * The node spacing that remeshing aims for, by changing the number of nodes in each element.  A value of zero
+     * means remeshing keeps the number of nodes in each element.
+     *
+     * Initialised to 0.0 in the constructor.
+     */
+    double mRemeshTargetNodeSpacing;
+
+    /**
+     * Whether to store the pressure in the Fourier domain each timestep.  If false, the pressure is calculated on the
+     * fly and never written to memory.
+     *
+     * Initialised to false in the constructor.
+     */
+    bool mStorePressureGrid;
+
+    /**
+     * Whether to perform the discrete Fourier transforms and Fourier-domain calculations in single precision.  The
+     * right hand side is assembled directly in single precision, while the velocity and force grids and all Lagrangian
+     * quantities remain in double precision.
+     *
+     * Initialised to false in the constructor.
+     */
+    bool mUseSinglePrecisionFluid;
+
+    /**
+     * Whether the fluid grids use the low-memory layout of ImmersedBoundary2dArrays, in which transient grids share
+     * storage.
+     *
+     * Initialised to false in the constructor.
+     */
+    bool mUseLowMemoryGrids;
+
+    /**
+     * Whether to adapt the timestep each timestep, subject to a CFL condition based on the fastest node.
+     *
+     * Initialised to false in the constructor.
+     */
+    bool mUseAdaptiveTimestep;
+
+    /**
+     * The CFL number used for adaptive timestepping: the timestep is chosen so that the fastest node moves at most this
+     * fraction of a grid spacing per timestep.
+     *
+     * Initialised to 0.25 in the constructor.
+     */
+    double mCflNumber;
+
+    /**
+     * The smallest timestep allowed by adaptive timestepping.  If not set, this defaults to the initial timestep divided
+     * by 100 in SetupConstantMemberVariables().
+     */
+    double mMinTimestep;
+
+    /**
+     * The largest timestep allowed by adaptive timestepping.  If not set, this defaults to the initial timestep
+     * multiplied by 100 in SetupConstantMemberVariables().
+     */
+    double mMaxTimestep;
+
+    /**
+     * The number of timesteps between the timesteps at which AdaptTimestep() may change the timestep.
+     *
+     * Initialised to 1 in the constructor.
+     */
+    unsigned mTimestepAdaptationInterval;
+
+    /**
+     * The number of timesteps elapsed before SimulationTime last restarted its count, either when AdaptTimestep()
+     * changed the timestep or, after a restart, when the checkpoint was saved.  GetTimeStepsElapsed() adds it to the
+     * count in SimulationTime.
+     *
+     * Initialised to 0 in the constructor.
+     */
+    unsigned mTimeStepsElapsedOffset;
+
+    /** The phases of each timestep timed in #mpPhaseTimer, registered in this order in the constructor. */
+    enum TimedPhase
+    {
+        CLEAR_FORCES_AND_SOURCES,
+        ADD_FORCE_CONTRIBUTIONS,
+        PROPAGATE_FORCES_TO_FLUID_GRID,
+        PROPAGATE_FLUID_SOURCES_TO_GRID,
+        SOLVE_NAVIER_STOKES,
+        ASSEMBLE_RIGHT_HAND_SIDE,
+        FORWARD_FFT,
+        SOLVE_IN_FOURIER_DOMAIN,
+        INVERSE_FFT,
+        CALCULATE_NODE_PAIRS,
+        REDUCE_FLUID_GRIDS
+    };
+
+    /**
+     * Accumulates the wall time spent in, and number of calls to, each phase of the timestep.  Besides the phases
+     * in TimedPhase, there is a phase for each class of force in #mForceCollection, named by its identifier, and
+     * UpdateNodeLocations() is timed by the cell population, which shares ownership of the timer so that it never
+     * outlives it.
+     */
+    boost::shared_ptr<ImmersedBoundaryPhaseTimer> mpPhaseTimer;
+
+    /** The phase of #mpPhaseTimer timing each force in #mForceCollection. */
+    std::vector<unsigned> mForcePhases;
+
+    /**
+     * The tasks of the graph run in UpdateFluidVelocityGridsWithTaskGraph().  The force at index i in
+     * #mForceCollection is calculated by the task CALCULATE_FORCE + i.
+     */
+    enum TimestepTask
+    {
+        CLEAR_FORCES_AND_SOURCES_TASK,
+        CALCULATE_NODE_PAIRS_TASK,
+        GATHER_FORCES_TASK,
+        SPREAD_FORCES_TASK,
+        BALANCE_FLUID_SOURCES_TASK,
+        SPREAD_FLUID_SOURCES_TASK,
+        CALCULATE_FORCE_TASK
+    };
+
+    /**
+     * The number of time steps after which the phase timings are written to file, in the output directory passed to
+     * SetupSolve().  A value of zero means they are never written.
+     *
+     * Initialised to 0 in the constructor.
+     */
+    unsigned mTimingOutputFrequency;
+
+    /** The output directory passed to SetupSolve(). */
+    std::string mOutputDirectory;
+
+    /**
+     * The number of time steps after which the fluid grids are appended to the file fluid_grids.h5, in the output
+     * directory passed to SetupSolve().  A value of zero means they are never written.  The velocity and force grids
+     * are always written, and the pressure spectrum also if #mStorePressureGrid is set.
+     *
+     * Initialised to 0 in the constructor.
+     */
+    unsigned mGridOutputFrequency;
+
+    /** The writer for the fluid grid time series, created in SetupSolve() if #mGridOutputFrequency is nonzero. */
+    ImmersedBoundaryHdf5GridWriter* mpGridWriter;
+
+    /** Whether the force grids are copied to #mOutputForceGrids during the current fluid solve. */
+    bool mWriteFluidGridsThisStep;
+
+    /**
+     * The force grids spread for the last fluid solve before an output step.  The solve clears the force grids as it
+     * consumes them, so they are kept here for WriteFluidGrids().
+     */
+    multi_array<double, 3> mOutputForceGrids;
+
+    /** The pressure grid of a single precision solve, converted to double precision for WriteFluidGrids(). */
+    multi_array<std::complex<double>, 2> mOutputPressureGrid;
+
+    /**
+     * Helper method to append the current fluid grids to the time series written by #mpGridWriter.
+     */
+    void WriteFluidGrids();
+
+    /** The in-situ reducers of the fluid velocity, run every #mFluidReducerOutputFrequency time steps. */
+    std::vector<boost::shared_ptr<AbstractImmersedBoundaryFluidReducer> > mFluidReducers;
+
+    /**
+     * The number of time steps after which each reducer in #mFluidReducers is run, streaming its results to a file in
+     * the output directory passed to SetupSolve().  A value of zero means the reducers are never run.
+     *
+     * Initialised to 0 in the constructor.
+     */
+    unsigned mFluidReducerOutputFrequency;
+
+    /** Whether the reducers using the Fourier grids are passed them during the current fluid solve. */
+    bool mReduceFourierGridsThisStep;
+
+    /**
+     * Helper method to run each reducer in #mFluidReducers on the current velocity grids.
+     */
+    void ReduceFluidGrids();
+
+    /**
+     * Helper method to pass the Fourier grids, once the velocity has been updated in the Fourier domain, to each
+     * reducer using them.
+     *
+     * @param rFourierGrids the normalised Fourier coefficients of the velocity
+     */
+    template<typename SCALAR>
+    void ReduceFourierGrids(const multi_array<std::complex<SCALAR>, 3>& rFourierGrids);
+
+    /**
+     * The number of time steps after which a checkpoint is saved to the file checkpoint.ibc, in the output directory
+     * passed to SetupSolve(), replacing the previous checkpoint.  A value of zero means checkpoints are only saved by
+     * calling SaveCheckpoint().
+     *
+     * Initialised to 0 in the constructor.
+     */
+    unsigned mCheckpointFrequency;
+
+    /** The absolute path of the checkpoint to restore in SetupSolve(), or empty if the simulation is not a restart. */
+    std::string mRestartCheckpointPath;
+
+    /**
+     * Helper method for SetupSolve() to restore the state saved in the checkpoint at #mRestartCheckpointPath, in place
+     * of calculating the node pairs and solving for the fluid velocity from scratch.
+     */
+    void RestoreCheckpoint();
+
+    /**
+     * Helper method for SaveCheckpoint() and RestoreCheckpoint().  Lists the nodes of each element, in the layout of
+     * ImmersedBoundaryCheckpoint::rGetElementTopology().
+     *
+     * @param rTopology the vector to fill
+     */
+    void GetElementTopology(std::vector<unsigned>& rTopology);
+
+    /**
+     * The number of time steps of the warm start run by SetupSolve() before the simulation, to relax the initial mesh
+     * on a coarser fluid grid.  A value of zero means there is no warm start.
+     *
+     * Initialised to 0 in the constructor.
+     */
+    unsigned mWarmStartNumSteps;
+
+    /**
+     * The factor by which the number of fluid grid points in each direction is divided for the warm start.
+     *
+     * Initialised to 2 in the constructor.
+     */
+    unsigned mWarmStartCoarseningFactor;
+
+    /**
+     * The factor by which the characteristic node spacing of the mesh is multiplied for the warm start, so that a
+     * factor greater than one relaxes elements with fewer nodes.  A factor of one leaves the nodes alone.
+     *
+     * Initialised to 1 in the constructor.
+     */
+    double mWarmStartNodeSpacingMultiplier;
+
+    /**
+     * Helper method for SetupSolve() to run the warm start.  The fluid grid of the mesh is coarsened, and optionally
+     * its elements remeshed with fewer nodes, and #mWarmStartNumSteps steps of the usual fluid solve and node update
+     * are taken without advancing the simulation time.  The fluid grid and node spacing of the mesh are then restored,
+     * and the solver members released so that SetupSolve() can set them up for the production grid.
+     *
+     * @param rCellPopulation reference to the cell population
+     * @param rCoarseVelocityGrids filled with the fluid velocity at the end of the warm start, on the coarse grid
+     */
+    void RunWarmStart(AbstractCellPopulation<DIM,DIM>& rCellPopulation, multi_array<double, 3>& rCoarseVelocityGrids);
+
+    /**
+     * Whether the membrane springs are treated semi-implicitly when the nodes are moved, so that a stiff membrane does
+     * not limit the timestep.
+     *
+     * Initialised to false in the constructor.
+     */
+    bool mUseSemiImplicitMembraneUpdate;
+
+    /**
+     * The factor by which the implicit membrane coefficient of each element overestimates its linearised value, which
+     * must exceed one for the semi-implicit update to remain stable when the mobility of the membrane is uneven.
+     *
+     * Initialised to 2 in the constructor.
+     */
+    double mSemiImplicitSafetyFactor;
+
+    /**
+     * Helper method to set the implicit membrane coefficient of each element of the cell population, from the spring
+     * constants of the forces just calculated.  The coefficient of an element is its spring constant times the
+     * timestep times the mobility of its membrane: the displacement in one timestep of a sinusoidal sheet of nodes
+     * per unit of force on each node, for the fluid solve of this class and the delta function of the population.
+     * The mobility is that of the wavelength whose explicit relaxation rate is largest, so which first makes an
+     * explicit update unstable, and the coefficient is multiplied by #mSemiImplicitSafetyFactor.
+     */
+    void UpdateImplicitMembraneCoefficients();
+
+    /**
+     * Helper method for UpdateImplicitMembraneCoefficients()
+     * Samples, in the x direction, the delta function stencil of a point on a grid point away from any wall.
+     *
+     * @param rOffsets filled with the offset, in grid points, of each point of the stencil from its centre
+     * @param rWeights filled with the weight of each point of the stencil, summing to one
+     */
+    template<unsigned WIDTH>
+    void SampleStencilWeights(std::vector<double>& rOffsets, std::vector<double>& rWeights);
 
     /**
      * Helper method to calculate elastic forces, propagate these to the fluid grid
@@ -151,6 +568,43 @@ private:
      */
     void UpdateFluidVelocityGrids(AbstractCellPopulation<DIM,DIM>& rCellPopulation);
 
+    /**
+     * Helper method for UpdateAtEndOfTimeStep().
+     *
+     * @return whether UpdateFluidVelocityGridsWithTaskGraph() is used in place of UpdateFluidVelocityGrids(), which
+     *     requires more than one task graph thread, and every force to use the mesh's node arrays
+     */
+    bool UsesTaskGraph();
+
+    /**
+     * Helper method for UpdateAtEndOfTimeStep().  Does the same as UpdateFluidVelocityGrids(), and recalculates the
+     * node pairs if asked to, with the phases before the fluid solve run as tasks on #mNumTaskGraphThreads threads.
+     *
+     * The forces not using the node pairs are calculated while the node pairs are recalculated, and every force is
+     * calculated at once, into its own buffer in #mForceBuffers, other than forces of the same class, which share a
+     * timed phase and so are calculated in turn.  The fluid sources are balanced and spread while the forces are
+     * calculated and spread.  Threaded loops within a phase run on a single thread unless OpenMP nested parallelism
+     * is enabled, so the threads of each force and of spreading are best left at one.
+     *
+     * @param calculateNodePairs whether to recalculate the node pairs
+     */
+    void UpdateFluidVelocityGridsWithTaskGraph(bool calculateNodePairs);
+
+    /**
+     * Run a task of the graph built in UpdateFluidVelocityGridsWithTaskGraph().
+     *
+     * @param pModifier the modifier
+     * @param task the task, a value of TimestepTask or CALCULATE_FORCE_TASK plus the index of a force
+     */
+    static void ExecuteTimestepTask(void* pModifier, unsigned task);
+
+    /**
+     * Helper method for ExecuteTimestepTask().
+     *
+     * @param task the task, a value of TimestepTask or CALCULATE_FORCE_TASK plus the index of a force
+     */
+    void RunTimestepTask(unsigned task);
+
     /**
      * Helper method for SetupSolve()
      * Sets up all variables which need not change throughout the simulation
@@ -159,30 +613,112 @@ private:
      */
     void SetupConstantMemberVariables(AbstractCellPopulation<DIM,DIM>& rCellPopulation);
 
+    /**
+     * Helper method for UpdateAtEndOfTimeStep()
+     * Chooses a new timestep from the CFL condition, within the bounds #mMinTimestep and #mMaxTimestep.  If the timestep
+     * changes, SimulationTime is reset to the new timestep and the timestep-dependent operators are recalculated.
+     *
+     * The timestep may shrink by any amount, but grows by at most a factor of #mTimestepGrowthLimit per timestep, and is
+     * not grown at all unless by more than #mTimestepChangeThreshold, to avoid recalculating the operators every
+     * timestep.  It is only changed at multiples of #mTimestepAdaptationInterval timesteps, and the timesteps elapsed
+     * before SimulationTime is reset are added to #mTimeStepsElapsedOffset.
+     */
+    void AdaptTimestep();
+
+    /** The largest factor by which AdaptTimestep() will grow the timestep in a single timestep. */
+    static const double mTimestepGrowthLimit;
+
+    /** The smallest relative increase in the timestep that AdaptTimestep() will act on. */
+    static const double mTimestepChangeThreshold;
+
     /**
      * Helper method for UpdateFluidVelocityGrids()
      * Ensures force applied to each node is reset to zero
-     * Ensures fluid force grids and source grid are reset
+     * Ensures the fluid source grid is reset (the fluid force grids are cleared in AssembleRightHandSide2d())
      */
     void ClearForcesAndSources();
 
     /**
-     * Loops over each immersed boundary force and invokes AddImmersedBoundaryForceContribution()
+     * Helper method for ClearForcesAndSources()
+     * Resets the fluid source grid, the third slice of the right hand side grids, to zero.
+     *
+     * @param rRhsGrids the right hand side grids
+     */
+    template<typename SCALAR>
+    void ClearFluidSourceGrid(multi_array<SCALAR, 3>& rRhsGrids);
+
+    /**
+     * Loops over each immersed boundary force and invokes AddForceContributionsToNodeArrays()
      */
     void AddImmersedBoundaryForceContributions();
 
+    /**
+     * Recalculate the node pairs which may interact, and reset the cell population's node displacement bound.
+     */
+    void CalculateNodePairs();
+
+    /**
+     * Update the node pairs after division or death, using the changes recorded by the mesh.  The cell population's
+     * node displacement bound is left as it is, as the pairs of unchanged elements are not recalculated.
+     */
+    void UpdateNodePairsAfterTopologyChanges();
+
+    /**
+     * Helper method for ClearForcesAndSources() and AddImmersedBoundaryForceContributions().
+     *
+     * @return whether any force in #mForceCollection adds its contributions through the Node objects rather than the
+     *     mesh's node arrays
+     */
+    bool HasForcesNotUsingNodeArrays();
+
     /**
      * Helper method for UpdateFluidVelocityGrids()
      * Propagates elastic forces to fluid grid
      */
     void PropagateForcesToFluidGrid();
 
+    /** @return reference to the force grids, which are in double precision whatever the precision of the solve */
+    multi_array<double, 3>& rGetModifiableForceGrids();
+
+    /**
+     * Helper method for PropagateForcesToFluidGrid()
+     * Propagates elastic forces to fluid grid using a delta function stencil of the given width
+     */
+    template<unsigned WIDTH>
+    void PropagateForcesToFluidGridWithStencil();
+
     /**
      * Helper method for UpdateFluidVelocityGrids()
      * Propagates fluid sources to grid
      */
     void PropagateFluidSourcesToGrid();
 
+    /**
+     * Helper method for PropagateFluidSourcesToGrid()
+     * Propagates fluid sources to grid, once their balancing strengths have been applied
+     */
+    void SpreadFluidSourcesToGrid();
+
+    /**
+     * Helper method for SpreadFluidSourcesToGrid()
+     * Propagates fluid sources to the right hand side grids of the precision being solved in
+     *
+     * @param rRhsGrids the right hand side grids, whose third slice holds the fluid sources
+     */
+    template<typename SCALAR>
+    void SpreadFluidSourcesToGrid(multi_array<SCALAR, 3>& rRhsGrids);
+
+    /**
+     * Helper method for PropagateFluidSourcesToGrid()
+     * Propagates fluid sources to grid using a delta function stencil of the given width
+     *
+     * @param rRegistry the registry of fluid sources, with their balancing strengths already applied
+     * @param rRhsGrids the right hand side grids, whose third slice holds the fluid sources
+     */
+    template<unsigned WIDTH, typename SCALAR>
+    void PropagateFluidSourcesToGridWithStencil(const ImmersedBoundaryFluidSourceRegistry<DIM>& rRegistry,
+                                                multi_array<SCALAR, 3>& rRhsGrids);
+
     /**
      * Helper method for UpdateFluidVelocityGrids()
      * Updates fluid velocity grids by solving Navier-Stokes
@@ -190,13 +726,45 @@ private:
     void SolveNavierStokesSpectral();
 
     /**
-     * Helper method for PropagateForcesToFluidGrid()
-     * Calculates the discrete delta approximation based on distance and grid spacing
+     * Helper method for SolveNavierStokesSpectral()
+     * Updates fluid velocity grids by solving Navier-Stokes, with the arrays of the precision being solved in
      *
-     * @param dist absolute 1-D distance between boundary-node and fluid-node
-     * @param spacing the grid spacing
+     * @param rArrays the arrays
      */
-    double Delta1D(double dist, double spacing);
+    template<typename SCALAR>
+    void SolveNavierStokesSpectral(ImmersedBoundary2dArrays<DIM, SCALAR>& rArrays);
+
+    /**
+     * Helper method for SolveNavierStokesSpectral()
+     * Calculates the pressure and updated velocities in the Fourier domain, in a single pass over the Fourier grids.
+     *
+     * @param rFourierGrids the Fourier grids, overwritten by the updated (normalised) velocities
+     * @param rOperator2 the second operator
+     * @param rReciprocalOperator1 the reciprocal of the first operator
+     * @param rNormalisedReciprocalOperator2 the reciprocal of the second operator, including the DFT normalisation
+     * @param rImagSin2x the values of i * sin(2x) / (x grid spacing)
+     * @param rImagSin2y the values of i * sin(2y) / (y grid spacing)
+     * @param rPressureGrid the pressure grid, written if #mStorePressureGrid
+     */
+    template<typename SCALAR>
+    void SolveInFourierDomain(multi_array<std::complex<SCALAR>, 3>& rFourierGrids,
+                              const multi_array<SCALAR, 2>& rOperator2,
+                              const multi_array<SCALAR, 2>& rReciprocalOperator1,
+                              const multi_array<SCALAR, 2>& rNormalisedReciprocalOperator2,
+                              const std::vector<std::complex<SCALAR> >& rImagSin2x,
+                              const std::vector<std::complex<SCALAR> >& rImagSin2y,
+                              multi_array_ref<std::complex<SCALAR>, 2>& rPressureGrid);
+
+    /**
+     * Helper method for SolveNavierStokesSpectral(), for a domain bounded by walls.  Calculates the pressure and the
+     * updated velocities from the coefficients of the real-to-real DFTs, laid out as described in
+     * ImmersedBoundary2dArrays.  The pressure is calculated in a first pass, overwriting the third slice of the grids,
+     * since each coefficient of its divergence depends on coefficients of the velocity at other indices.
+     *
+     * @param rCoefficientGrids the right hand side grids after the forward DFTs, overwritten by the updated
+     *     (normalised) velocity coefficients and the pressure coefficients
+     */
+    void SolveWithRealTransforms(multi_array<double, 3>& rCoefficientGrids);
 
     /**
      * Calculates upwind difference of fluid velocity grids
@@ -207,12 +775,81 @@ private:
     void Upwind2d(const multi_array<double, 3>& input, multi_array<double, 3>& output);
 
     /**
-     * Calculates the vector of central differences of the fluid source grid
+     * Helper method for Upwind2d() and AssembleRightHandSide2d()
+     * Calculates the signs passed to Upwind2dPoint() for a row of the grids: those for the first point, the interior
+     * points and the last point of the row, in turn.  Every sign is 1 in a periodic domain.
      *
-     * @param rhs const reference to rhs grids which contain the fluid source strengths
-     * @param gradients reference to grids storing the graidents
+     * @param x the x index of the row
+     * @param signs filled in with the signs for the first, interior and last points of the row
      */
-    void CalculateSourceGradients(const multi_array<double, 3>& rhs, multi_array<double, 3>& gradients);
+    void GetWallSigns(unsigned x, double signs[3][4]);
+
+    /**
+     * Helper method for Upwind2d() and AssembleRightHandSide2d()
+     * Calculates the upwind difference of both velocity components at a single grid point.
+     *
+     * @param pRows pointers to the rows of each velocity component at x-1, x and x+1 (periodically, or reflected in a
+     *     wall)
+     * @param y the y index of the grid point
+     * @param prevY the y index of the previous grid point, taking periodicity or a wall into account
+     * @param nextY the y index of the next grid point, taking periodicity or a wall into account
+     * @param pWallSigns the signs of the velocity component normal to the walls at x-1, x+1, y-1 and y+1; each is -1
+     *     where that neighbour is reflected in a wall, and 1 otherwise
+     * @param recipSpacingX the reciprocal of the x grid spacing
+     * @param recipSpacingY the reciprocal of the y grid spacing
+     * @param rUpwind0 filled in with the upwind difference of the first velocity component
+     * @param rUpwind1 filled in with the upwind difference of the second velocity component
+     */
+    void Upwind2dPoint(const double* pRows[2][3],
+                       unsigned y,
+                       unsigned prevY,
+                       unsigned nextY,
+                       const double pWallSigns[4],
+                       double recipSpacingX,
+                       double recipSpacingY,
+                       double& rUpwind0,
+                       double& rUpwind1);
+
+    /**
+     * Helper method for SolveNavierStokesSpectral()
+     * Assembles the right hand side of the linear system, vel + dt * (force + source gradient term - upwind), in a
+     * single pass over the real space grids.  The force grids are reset to zero as they are consumed.
+     *
+     * @param rVelGrids the fluid velocity grids
+     * @param rForceGrids the force grids, which are cleared
+     * @param rRhsGrids the right hand side grids, in the precision being solved in; the first two slices are written,
+     *     and the third slice holds the fluid source strengths if ACTIVE_SOURCES
+     */
+    template<bool ACTIVE_SOURCES, typename SCALAR>
+    void AssembleRightHandSide2d(const multi_array<double, 3>& rVelGrids,
+                                 multi_array<double, 3>& rForceGrids,
+                                 multi_array<SCALAR, 3>& rRhsGrids);
+
+    /**
+     * Helper method for AssembleRightHandSide2d()
+     * Assembles the right hand side at a single grid point.
+     *
+     * @param pRows pointers to the rows of each velocity component at x-1, x and x+1 (periodically, or reflected in a
+     *     wall)
+     * @param pSourceRows pointers to the rows of the source strengths at x-1, x and x+1 (unused unless ACTIVE_SOURCES)
+     * @param pForces pointers to the rows of each force grid
+     * @param pRhs pointers to the rows of the first two right hand side grids
+     * @param y the y index of the grid point
+     * @param prevY the y index of the previous grid point, taking periodicity or a wall into account
+     * @param nextY the y index of the next grid point, taking periodicity or a wall into account
+     * @param pWallSigns the signs of the velocity component normal to the walls, as for Upwind2dPoint()
+     * @param constants the reciprocal grid spacings, timestep and source gradient factors
+     */
+    template<bool ACTIVE_SOURCES, typename SCALAR>
+    void AssembleRightHandSide2dPoint(const double* pRows[2][3],
+                                      const SCALAR* pSourceRows[3],
+                                      double* pForces[2],
+                                      SCALAR* pRhs[2],
+                                      unsigned y,
+                                      unsigned prevY,
+                                      unsigned nextY,
+                                      const double pWallSigns[4],
+                                      const double constants[5]);
 
     /**
      * Helper method to set member variables for testing purposes
@@ -271,6 +908,53 @@ public:
      */
     unsigned GetNodeNeighbourUpdateFrequency();
 
+    /**
+     * Set #mNeighbourSkin.  This must be called before SetupSolve() to have any effect.
+     *
+     * @param neighbourSkin the skin added to the interaction distance when finding node pairs, or zero to recalculate
+     *     node pairs at a fixed frequency
+     */
+    void SetNeighbourSkin(double neighbourSkin);
+
+    /**
+     * @return #mNeighbourSkin
+     */
+    double GetNeighbourSkin();
+
+    /**
+     * @return #mNumNodePairCalculations, which may be used to tune the neighbour skin
+     */
+    unsigned GetNumNodePairCalculations();
+
+    /**
+     * Set #mNumNeighbourThreads.  Node pairs are identical whatever the number of threads.
+     *
+     * @param numNeighbourThreads the number of threads used to calculate node pairs
+     */
+    void SetNumNeighbourThreads(unsigned numNeighbourThreads);
+
+    /**
+     * @return #mNumNeighbourThreads
+     */
+    unsigned GetNumNeighbourThreads();
+
+    /**
+     * Set #mUseIncrementalNodePairUpdates.
+     *
+     * @param useIncrementalNodePairUpdates whether to update the node pairs after division and death
+     */
+    void SetUseIncrementalNodePairUpdates(bool useIncrementalNodePairUpdates);
+
+    /**
+     * @return #mUseIncrementalNodePairUpdates
+     */
+    bool GetUseIncrementalNodePairUpdates();
+
+    /**
+     * @return #mNumIncrementalNodePairUpdates
+     */
+    unsigned GetNumIncrementalNodePairUpdates();
+
     /**
      * Add an immersed boundary force to be used in this modifier.
      *
@@ -289,6 +973,409 @@ public:
      * @return #mReynoldsNumber
      */
     double GetReynoldsNumber();
+
+    /**
+     * Set #mNumFftThreads.  This must be called before SetupSolve() to have any effect.
+     *
+     * @param numFftThreads the number of threads to use for the discrete Fourier transforms
+     */
+    void SetNumFftThreads(unsigned numFftThreads);
+
+    /**
+     * @return #mNumFftThreads
+     */
+    unsigned GetNumFftThreads();
+
+    /**
+     * Set #mpSharedFftInterface.  This must be called before SetupSolve() to have any effect, and the fluid must be
+     * solved in double precision.  #mNumFftThreads is then ignored, as the transforms are executed with the plans of
+     * the shared interface.
+     *
+     * @param pSharedFftInterface an interface planned for the same grid size and source mode, which must outlive this
+     *     modifier, or NULL for this modifier to plan its own transforms
+     */
+    void SetSharedFftInterface(const ImmersedBoundaryFftInterface<DIM>* pSharedFftInterface);
+
+    /**
+     * Set #mUseFastStartFftPlanning.  This must be called before SetupSolve() to have any effect, and has none if a
+     * shared FFT interface is used.
+     *
+     * @param useFastStartFftPlanning whether to plan the transforms quickly and upgrade them in the background
+     */
+    void SetUseFastStartFftPlanning(bool useFastStartFftPlanning);
+
+    /**
+     * @return #mUseFastStartFftPlanning
+     */
+    bool GetUseFastStartFftPlanning();
+
+    /**
+     * Set #mpFftInterfaceFactory.  This must be called before SetupSolve() to have any effect.  A backend made by a
+     * factory is only supported for periodic transforms of a fluid solved in double precision, and is not combined
+     * with a shared FFT interface.
+     *
+     * @param pFftInterfaceFactory the factory making the backend, or an empty pointer for an fftw backend
+     */
+    void SetFftInterfaceFactory(boost::shared_ptr<AbstractImmersedBoundaryFftInterfaceFactory<DIM> > pFftInterfaceFactory);
+
+    /**
+     * @return #mpFftInterfaceFactory
+     */
+    boost::shared_ptr<AbstractImmersedBoundaryFftInterfaceFactory<DIM> > GetFftInterfaceFactory();
+
+    /**
+     * @return #mpFftInterface, or NULL before SetupSolve() has been called
+     */
+    AbstractImmersedBoundaryFftInterface<DIM>* GetFftInterface();
+
+    /**
+     * Set #mNumSpreadingThreads.  The nodes and sources are spread in strips whose layout and order do not depend on
+     * the number of threads, so the force and source grids are identical for any number of threads.
+     *
+     * @param numSpreadingThreads the number of threads to use when spreading to the fluid grid
+     */
+    void SetNumSpreadingThreads(unsigned numSpreadingThreads);
+
+    /**
+     * @return #mNumSpreadingThreads
+     */
+    unsigned GetNumSpreadingThreads();
+
+    /**
+     * Set #mNumTaskGraphThreads.
+     *
+     * @param numTaskGraphThreads the number of threads on which to run the phases of each timestep as a task graph
+     */
+    void SetNumTaskGraphThreads(unsigned numTaskGraphThreads);
+
+    /**
+     * @return #mNumTaskGraphThreads
+     */
+    unsigned GetNumTaskGraphThreads();
+
+    /**
+     * Set #mReorderFrequency.
+     *
+     * @param reorderFrequency the number of time steps after which nodes and elements are renumbered, or zero never
+     *     to renumber them
+     */
+    void SetReorderFrequency(unsigned reorderFrequency);
+
+    /**
+     * @return #mReorderFrequency
+     */
+    unsigned GetReorderFrequency();
+
+    /**
+     * Set #mReorderAlongHilbertCurve.
+     *
+     * @param reorderAlongHilbertCurve whether to renumber along a Hilbert curve, rather than a Morton curve
+     */
+    void SetReorderAlongHilbertCurve(bool reorderAlongHilbertCurve);
+
+    /**
+     * @return #mReorderAlongHilbertCurve
+     */
+    bool GetReorderAlongHilbertCurve();
+
+    /**
+     * Set #mRemeshFrequency.
+     *
+     * @param remeshFrequency the number of time steps after which the nodes of each element are redistributed, or zero
+     *     never to redistribute them
+     */
+    void SetRemeshFrequency(unsigned remeshFrequency);
+
+    /**
+     * @return #mRemeshFrequency
+     */
+    unsigned GetRemeshFrequency();
+
+    /**
+     * Set #mRemeshTargetNodeSpacing.
+     *
+     * @param remeshTargetNodeSpacing the node spacing remeshing aims for, or zero to keep the number of nodes in each
+     *     element
+     */
+    void SetRemeshTargetNodeSpacing(double remeshTargetNodeSpacing);
+
+    /**
+     * @return #mRemeshTargetNodeSpacing
+     */
+    double GetRemeshTargetNodeSpacing();
+
+    /**
+     * Set #mStorePressureGrid.
+     *
+     * @param storePressureGrid whether to store the pressure grid each timestep
+     */
+    void SetStorePressureGrid(bool storePressureGrid);
+
+    /**
+     * @return #mStorePressureGrid
+     */
+    bool GetStorePressureGrid();
+
+    /**
+     * Set #mUseSinglePrecisionFluid.  This must be called before SetupSolve() to have any effect.
+     *
+     * @param useSinglePrecisionFluid whether to solve the fluid problem in the Fourier domain in single precision
+     */
+    void SetUseSinglePrecisionFluid(bool useSinglePrecisionFluid);
+
+    /**
+     * @return #mUseSinglePrecisionFluid
+     */
+    bool GetUseSinglePrecisionFluid();
+
+    /**
+     * Set #mUseLowMemoryGrids.  This must be called before SetupSolve() to have any effect.
+     *
+     * @param useLowMemoryGrids whether the fluid grids should use the low-memory layout, in which transient grids
+     *     share storage
+     */
+    void SetUseLowMemoryGrids(bool useLowMemoryGrids);
+
+    /**
+     * @return #mUseLowMemoryGrids
+     */
+    bool GetUseLowMemoryGrids();
+
+    /**
+     * @return the fluid grids, whose memory use is listed by ImmersedBoundary2dArrays::GetMemoryReport(), or NULL
+     *     before SetupSolve() has been called or if the fluid is solved in single precision
+     */
+    ImmersedBoundary2dArrays<DIM>* GetArrays();
+
+    /**
+     * @return the fluid grids of a single precision solve, or NULL before SetupSolve() has been called or if the fluid
+     *     is solved in double precision
+     */
+    ImmersedBoundary2dArrays<DIM, float>* GetSinglePrecisionArrays();
+
+    /**
+     * Set #mUseAdaptiveTimestep.  This must be called before SetupSolve() to have any effect.
+     *
+     * Note that behaviour tied to a number of timesteps (such as output) no longer corresponds to a fixed time interval.
+     * SimulationTime restarts its count of timesteps elapsed each time the timestep changes, so the frequencies set on
+     * this class count the timesteps given by GetTimeStepsElapsed() instead.
+     *
+     * @param useAdaptiveTimestep whether to adapt the timestep during the simulation
+     */
+    void SetUseAdaptiveTimestep(bool useAdaptiveTimestep);
+
+    /**
+     * @return #mUseAdaptiveTimestep
+     */
+    bool GetUseAdaptiveTimestep();
+
+    /**
+     * Set #mCflNumber.
+     *
+     * @param cflNumber the new CFL number, which must be positive
+     */
+    void SetCflNumber(double cflNumber);
+
+    /**
+     * @return #mCflNumber
+     */
+    double GetCflNumber();
+
+    /**
+     * Set #mMinTimestep and #mMaxTimestep.
+     *
+     * @param minTimestep the smallest timestep allowed
+     * @param maxTimestep the largest timestep allowed
+     */
+    void SetAdaptiveTimestepBounds(double minTimestep, double maxTimestep);
+
+    /**
+     * @return #mMinTimestep
+     */
+    double GetMinTimestep();
+
+    /**
+     * @return #mMaxTimestep
+     */
+    double GetMaxTimestep();
+
+    /**
+     * Set #mTimestepAdaptationInterval.  The sampling timestep multiple of the simulation counts the timesteps in
+     * SimulationTime, which restarts when the timestep changes; if the interval is a multiple of the sampling timestep
+     * multiple, results are still written at multiples of it in GetTimeStepsElapsed().  A longer interval is slower to
+     * shrink the timestep when the nodes speed up.
+     *
+     * @param timestepAdaptationInterval the number of timesteps between the timesteps at which the timestep may change,
+     *     which must be positive
+     */
+    void SetTimestepAdaptationInterval(unsigned timestepAdaptationInterval);
+
+    /**
+     * @return #mTimestepAdaptationInterval
+     */
+    unsigned GetTimestepAdaptationInterval();
+
+    /**
+     * @return the number of timesteps elapsed since the start of the simulation.  Unlike the count in SimulationTime,
+     *     this carries on when AdaptTimestep() changes the timestep, and from the count saved in a restored checkpoint.
+     */
+    unsigned GetTimeStepsElapsed() const;
+
+    /**
+     * @return #mpPhaseTimer, holding the wall time spent in each phase of the timestep so far
+     */
+    const ImmersedBoundaryPhaseTimer& rGetPhaseTimer() const;
+
+    /**
+     * Set #mTimingOutputFrequency.  The timings are written to a file named phase_timings_<time step>.csv.
+     *
+     * @param timingOutputFrequency the number of time steps after which the phase timings are written to file, or
+     *     zero never to write them
+     */
+    void SetTimingOutputFrequency(unsigned timingOutputFrequency);
+
+    /**
+     * @return #mTimingOutputFrequency
+     */
+    unsigned GetTimingOutputFrequency();
+
+    /**
+     * Set #mGridOutputFrequency.  This must be set before SetupSolve().
+     *
+     * @param gridOutputFrequency the number of time steps after which the fluid grids are written to file, or zero
+     *     never to write them
+     */
+    void SetGridOutputFrequency(unsigned gridOutputFrequency);
+
+    /**
+     * @return #mGridOutputFrequency
+     */
+    unsigned GetGridOutputFrequency();
+
+    /**
+     * Add an in-situ reducer of the fluid velocity.  This must be called before SetupSolve().
+     *
+     * @param pReducer pointer to the reducer
+     */
+    void AddFluidReducer(boost::shared_ptr<AbstractImmersedBoundaryFluidReducer> pReducer);
+
+    /**
+     * @return #mFluidReducers
+     */
+    const std::vector<boost::shared_ptr<AbstractImmersedBoundaryFluidReducer> >& rGetFluidReducers() const;
+
+    /**
+     * Set #mFluidReducerOutputFrequency.  This must be set before SetupSolve().
+     *
+     * @param fluidReducerOutputFrequency the number of time steps after which the fluid reducers are run, or zero
+     *     never to run them
+     */
+    void SetFluidReducerOutputFrequency(unsigned fluidReducerOutputFrequency);
+
+    /**
+     * @return #mFluidReducerOutputFrequency
+     */
+    unsigned GetFluidReducerOutputFrequency();
+
+    /**
+     * Save a checkpoint of the state that is not cheaply rebuilt on restart: the fluid velocity grids, the node and
+     * fluid source locations, the node pairs, the element node spacings and the names of the forces.  This may only be
+     * called once SetupSolve() has been called.
+     *
+     * @param rDirectory the output directory, relative to where Chaste output is stored
+     * @param rFileName the name of the checkpoint file (defaults to checkpoint.ibc)
+     */
+    void SaveCheckpoint(const std::string& rDirectory, const std::string& rFileName="checkpoint.ibc");
+
+    /**
+     * Set #mCheckpointFrequency.
+     *
+     * @param checkpointFrequency the number of time steps after which a checkpoint is saved, or zero never to save one
+     *     automatically
+     */
+    void SetCheckpointFrequency(unsigned checkpointFrequency);
+
+    /**
+     * @return #mCheckpointFrequency
+     */
+    unsigned GetCheckpointFrequency();
+
+    /**
+     * Restart from a checkpoint saved by SaveCheckpoint().  The simulation must be set up as the one that saved it,
+     * with the same mesh, forces and fluid grid, and with the simulation time at which it was saved; SetupSolve() then
+     * restores the checkpoint in place of calculating the node pairs and the initial fluid velocity.  The checkpoint
+     * holds the node locations but not the mesh, so the mesh set up for the restart must have the same elements, made
+     * of the same nodes, as when the checkpoint was saved: a simulation in which cells have divided or died since the
+     * mesh was generated cannot be restarted, and SetupSolve() throws if the elements differ.  The fluid
+     * transforms are planned as usual, which is quick when the wisdom cache holds their plans.  This must be set
+     * before SetupSolve(), and the checkpoint is restored only once.
+     *
+     * @param rCheckpointFile the checkpoint file
+     */
+    void SetRestartCheckpoint(const FileFinder& rCheckpointFile);
+
+    /**
+     * Relax the initial mesh on a coarser fluid grid before the simulation starts.  SetupSolve() then runs a number of
+     * steps of the fluid solve and node update with the number of fluid grid points in each direction divided by a
+     * coarsening factor, which costs roughly the square of that factor less per step, without advancing the
+     * simulation time.  The elements may also be remeshed with a larger node spacing for the warm start, and are then
+     * remeshed back to the characteristic node spacing of the mesh.  The fluid velocity at the end of the warm start
+     * is prolonged spectrally onto the production grid, as the velocity from which the first step is solved.
+     *
+     * The warm start is only supported in periodic domains, and is skipped on a restart from a checkpoint.  This must
+     * be set before SetupSolve().
+     *
+     * @param numSteps the number of steps of the warm start, or zero for none
+     * @param coarseningFactor the factor by which the number of grid points in each direction is divided, which must
+     *     leave an even number of grid points in each direction (defaults to 2)
+     * @param nodeSpacingMultiplier the factor by which the node spacing is multiplied for the warm start, at least one
+     *     (defaults to 1, which leaves the nodes alone)
+     */
+    void SetWarmStart(unsigned numSteps, unsigned coarseningFactor=2, double nodeSpacingMultiplier=1.0);
+
+    /**
+     * @return #mWarmStartNumSteps
+     */
+    unsigned GetWarmStartNumSteps();
+
+    /**
+     * @return #mWarmStartCoarseningFactor
+     */
+    unsigned GetWarmStartCoarseningFactor();
+
+    /**
+     * @return #mWarmStartNodeSpacingMultiplier
+     */
+    double GetWarmStartNodeSpacingMultiplier();
+
+    /**
+     * Set #mUseSemiImplicitMembraneUpdate.  If set, each element's nodes move with the fluid velocity corrected for
+     * the change, over the timestep, in the force of its membrane springs (see
+     * ImmersedBoundaryMembraneElasticityForce), linearised and with the fluid's response to it approximated by that
+     * of a sinusoidal membrane.  The fluid itself is still solved explicitly, so forces other than the membrane springs
+     * still limit the timestep.  Unsetting it clears the coefficients held by the population, so that its nodes move
+     * with the fluid velocity alone.
+     *
+     * @param useSemiImplicitMembraneUpdate whether to treat the membrane springs semi-implicitly
+     */
+    void SetUseSemiImplicitMembraneUpdate(bool useSemiImplicitMembraneUpdate);
+
+    /**
+     * @return #mUseSemiImplicitMembraneUpdate
+     */
+    bool GetUseSemiImplicitMembraneUpdate();
+
+    /**
+     * Set #mSemiImplicitSafetyFactor.
+     *
+     * @param semiImplicitSafetyFactor the factor, which must be positive
+     */
+    void SetSemiImplicitSafetyFactor(double semiImplicitSafetyFactor);
+
+    /**
+     * @return #mSemiImplicitSafetyFactor
+     */
+    double GetSemiImplicitSafetyFactor();
 };
 
 #include "SerializationExportWrapper.hpp"
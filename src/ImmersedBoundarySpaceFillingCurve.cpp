@@ -0,0 +1,131 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundarySpaceFillingCurve.hpp"
+#include <cassert>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+ImmersedBoundarySpaceFillingCurve::ImmersedBoundarySpaceFillingCurve(bool useHilbertCurve, unsigned order)
+    : mUseHilbertCurve(useHilbertCurve),
+      mOrder(order)
+{
+    // Keys of up to 2 * 16 bits fit in an unsigned
+    assert(order > 0 && order <= 16);
+    mNumCellsPerSide = 1u << order;
+}
+
+bool ImmersedBoundarySpaceFillingCurve::GetUseHilbertCurve() const
+{
+    return mUseHilbertCurve;
+}
+
+unsigned ImmersedBoundarySpaceFillingCurve::GetOrder() const
+{
+    return mOrder;
+}
+
+unsigned ImmersedBoundarySpaceFillingCurve::GetKey(double x, double y) const
+{
+    // Wrap each coordinate to the unit interval, and find the cell containing it
+    double wrapped_x = x - floor(x);
+    double wrapped_y = y - floor(y);
+
+    unsigned cell_x = std::min((unsigned) (wrapped_x * mNumCellsPerSide), mNumCellsPerSide - 1);
+    unsigned cell_y = std::min((unsigned) (wrapped_y * mNumCellsPerSide), mNumCellsPerSide - 1);
+
+    return mUseHilbertCurve ? GetHilbertKey(cell_x, cell_y) : GetMortonKey(cell_x, cell_y);
+}
+
+unsigned ImmersedBoundarySpaceFillingCurve::GetHilbertKey(unsigned x, unsigned y) const
+{
+    unsigned key = 0;
+
+    // Descend through the quadrants, rotating and reflecting so that each sub-curve joins the next
+    for (unsigned side = mNumCellsPerSide / 2; side > 0; side /= 2)
+    {
+        unsigned rx = (x & side) > 0 ? 1 : 0;
+        unsigned ry = (y & side) > 0 ? 1 : 0;
+        key += side * side * ((3 * rx) ^ ry);
+
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = mNumCellsPerSide - 1 - x;
+                y = mNumCellsPerSide - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+
+    return key;
+}
+
+unsigned ImmersedBoundarySpaceFillingCurve::GetMortonKey(unsigned x, unsigned y) const
+{
+    unsigned key = 0;
+
+    for (unsigned bit = 0; bit < mOrder; bit++)
+    {
+        key |= ((x >> bit) & 1u) << (2 * bit);
+        key |= ((y >> bit) & 1u) << (2 * bit + 1);
+    }
+
+    return key;
+}
+
+void ImmersedBoundarySpaceFillingCurve::Sort(const std::vector<double>& rXCoordinates,
+                                             const std::vector<double>& rYCoordinates,
+                                             std::vector<unsigned>& rOrder) const
+{
+    assert(rXCoordinates.size() == rYCoordinates.size());
+    unsigned num_points = rXCoordinates.size();
+
+    // Sorting (key, index) pairs breaks ties by original index, so equal keys keep their relative order
+    std::vector<std::pair<unsigned, unsigned> > keys(num_points);
+    for (unsigned point = 0; point < num_points; point++)
+    {
+        keys[point] = std::make_pair(GetKey(rXCoordinates[point], rYCoordinates[point]), point);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    rOrder.resize(num_points);
+    for (unsigned point = 0; point < num_points; point++)
+    {
+        rOrder[point] = keys[point].second;
+    }
+}
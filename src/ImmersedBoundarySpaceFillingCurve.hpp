@@ -0,0 +1,111 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYSPACEFILLINGCURVE_HPP_
+#define IMMERSEDBOUNDARYSPACEFILLINGCURVE_HPP_
+
+#include <vector>
+
+/**
+ * A space filling curve over the unit square, used to order nodes and elements so that those close in space are
+ * close in memory.
+ *
+ * The square is divided into 2^order cells along each side, and each point is given the position (key) along the
+ * curve of the cell containing it.  A Hilbert curve keeps consecutive cells adjacent, which gives slightly better
+ * locality; a Morton (Z-order) curve simply interleaves the bits of the cell indices and is cheaper to evaluate.
+ */
+class ImmersedBoundarySpaceFillingCurve
+{
+private:
+
+    /** Whether to use a Hilbert curve, rather than a Morton curve. */
+    bool mUseHilbertCurve;
+
+    /** The order of the curve: the unit square is divided into 2^order cells along each side. */
+    unsigned mOrder;
+
+    /** The number of cells along each side of the unit square, 2^order. */
+    unsigned mNumCellsPerSide;
+
+    /**
+     * @param x the x index of a cell
+     * @param y the y index of a cell
+     * @return the position of the cell along a Hilbert curve
+     */
+    unsigned GetHilbertKey(unsigned x, unsigned y) const;
+
+    /**
+     * @param x the x index of a cell
+     * @param y the y index of a cell
+     * @return the position of the cell along a Morton curve
+     */
+    unsigned GetMortonKey(unsigned x, unsigned y) const;
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param useHilbertCurve whether to use a Hilbert curve, rather than a Morton curve (defaults to true)
+     * @param order the order of the curve, between 1 and 16 (defaults to 16)
+     */
+    ImmersedBoundarySpaceFillingCurve(bool useHilbertCurve=true, unsigned order=16);
+
+    /** @return #mUseHilbertCurve */
+    bool GetUseHilbertCurve() const;
+
+    /** @return #mOrder */
+    unsigned GetOrder() const;
+
+    /**
+     * @param x the x coordinate of a point, wrapped to the unit interval if necessary
+     * @param y the y coordinate of a point, wrapped to the unit interval if necessary
+     * @return the position along the curve of the cell containing the point
+     */
+    unsigned GetKey(double x, double y) const;
+
+    /**
+     * Order points along the curve.  Points with equal keys keep their original relative order.
+     *
+     * @param rXCoordinates the x coordinate of each point
+     * @param rYCoordinates the y coordinate of each point
+     * @param rOrder filled with the indices of the points, in order along the curve
+     */
+    void Sort(const std::vector<double>& rXCoordinates,
+              const std::vector<double>& rYCoordinates,
+              std::vector<unsigned>& rOrder) const;
+};
+
+#endif /*IMMERSEDBOUNDARYSPACEFILLINGCURVE_HPP_*/
@@ -0,0 +1,209 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryStencil.hpp"
+#include <cassert>
+#include <cmath>
+
+template<unsigned WIDTH>
+ImmersedBoundaryStencil<WIDTH>::ImmersedBoundaryStencil(unsigned numGridPtsX,
+                                                        unsigned numGridPtsY,
+                                                        double domainWidth,
+                                                        double domainHeight,
+                                                        bool wallsX,
+                                                        bool wallsY)
+    : mNumGridPtsX(numGridPtsX),
+      mNumGridPtsY(numGridPtsY),
+      mRecipSpacingX((double) numGridPtsX / domainWidth),
+      mRecipSpacingY((double) numGridPtsY / domainHeight),
+      mCosStep(cos(2.0 * M_PI / (double) WIDTH)),
+      mSinStep(sin(2.0 * M_PI / (double) WIDTH)),
+      mWallsX(wallsX),
+      mWallsY(wallsY),
+      mBaseIndexX(0u),
+      mBaseIndexY(0u)
+{
+    assert(WIDTH == 3 || WIDTH == 4 || WIDTH == 6);
+    assert(numGridPtsX >= WIDTH && numGridPtsY >= WIDTH);
+    assert(domainWidth > 0.0 && domainHeight > 0.0);
+}
+
+template<unsigned WIDTH>
+void ImmersedBoundaryStencil<WIDTH>::Update(double x, double y)
+{
+    // Between walls, the grid points are offset by half a spacing so that they lie symmetrically about each wall
+    Update1d(x * mRecipSpacingX - (mWallsX ? 0.5 : 0.0), mNumGridPtsX, mWallsX, mBaseIndexX, mIndicesX, mSignsX, mDeltasX);
+    Update1d(y * mRecipSpacingY - (mWallsY ? 0.5 : 0.0), mNumGridPtsY, mWallsY, mBaseIndexY, mIndicesY, mSignsY, mDeltasY);
+}
+
+template<unsigned WIDTH>
+void ImmersedBoundaryStencil<WIDTH>::FillIndices(unsigned baseIndex,
+                                                 unsigned numGridPts,
+                                                 bool walls,
+                                                 unsigned* pIndices,
+                                                 double* pSigns)
+{
+    for (unsigned i = 0; i < WIDTH; i++)
+    {
+        if (!walls)
+        {
+            pIndices[i] = (baseIndex + i) % numGridPts;
+            pSigns[i] = 1.0;
+        }
+        else
+        {
+            // Reflect a grid point beyond either wall onto its mirror image; the stencil is too narrow to reach both
+            int unfolded_idx = (int) (baseIndex + i) - (int) numGridPts;
+            if (unfolded_idx < 0)
+            {
+                pIndices[i] = (unsigned) (-1 - unfolded_idx);
+                pSigns[i] = -1.0;
+            }
+            else if (unfolded_idx >= (int) numGridPts)
+            {
+                pIndices[i] = (unsigned) (2 * (int) numGridPts - 1 - unfolded_idx);
+                pSigns[i] = -1.0;
+            }
+            else
+            {
+                pIndices[i] = (unsigned) unfolded_idx;
+                pSigns[i] = 1.0;
+            }
+        }
+    }
+}
+
+template<unsigned WIDTH>
+void ImmersedBoundaryStencil<WIDTH>::Update1d(double gridCoordinate,
+                                              unsigned numGridPts,
+                                              bool walls,
+                                              unsigned& rBaseIndex,
+                                              unsigned* pIndices,
+                                              double* pSigns,
+                                              double* pDeltas)
+{
+    // The first grid point in the stencil, before accounting for periodicity
+    int first_idx = (int) floor(gridCoordinate - 0.5 * WIDTH + 1.0);
+
+    // The signed distance, in grid spacings, from the point to the first grid point in the stencil
+    double r = (double) first_idx - gridCoordinate;
+
+    // Shift the first index to be non-negative, so that the unsigned indices wrap correctly
+    rBaseIndex = (unsigned) (first_idx + (int) numGridPts);
+    FillIndices(rBaseIndex, numGridPts, walls, pIndices, pSigns);
+
+    if (WIDTH == 3)
+    {
+        // The kernel of Roma et al. is piecewise: the central point is within half a spacing, the two others are not
+        for (unsigned i = 0; i < 3; i++)
+        {
+            double abs_r = fabs(r + (double) i);
+            if (abs_r <= 0.5)
+            {
+                pDeltas[i] = (1.0 + sqrt(1.0 - 3.0 * abs_r * abs_r)) / 3.0;
+            }
+            else
+            {
+                double one_minus_r = 1.0 - abs_r;
+                pDeltas[i] = (5.0 - 3.0 * abs_r - sqrt(1.0 - 3.0 * one_minus_r * one_minus_r)) / 6.0;
+            }
+        }
+    }
+    else
+    {
+        // Successive grid points are a fixed angle apart, so the cosine can be found by rotation
+        const double angle_step = 2.0 * M_PI / (double) WIDTH;
+
+        double cos_angle = cos(angle_step * r);
+        double sin_angle = sin(angle_step * r);
+
+        for (unsigned i = 0; i < WIDTH; i++)
+        {
+            pDeltas[i] = (1.0 + cos_angle) / (double) WIDTH;
+
+            double next_cos = cos_angle * mCosStep - sin_angle * mSinStep;
+            sin_angle = sin_angle * mCosStep + cos_angle * mSinStep;
+            cos_angle = next_cos;
+        }
+    }
+}
+
+template<unsigned WIDTH>
+void ImmersedBoundaryStencil<WIDTH>::Store(ImmersedBoundaryStencilCache& rCache, unsigned pointIndex) const
+{
+    unsigned* p_base_indices = rCache.GetBaseIndices(pointIndex);
+    double* p_deltas = rCache.GetDeltas(pointIndex);
+
+    // The shifted first indices are stored unreduced, so that reflections at a wall can be reconstructed
+    p_base_indices[0] = mBaseIndexX;
+    p_base_indices[1] = mBaseIndexY;
+
+    for (unsigned i = 0; i < WIDTH; i++)
+    {
+        p_deltas[i] = mDeltasX[i];
+        p_deltas[WIDTH + i] = mDeltasY[i];
+    }
+}
+
+template<unsigned WIDTH>
+bool ImmersedBoundaryStencil<WIDTH>::Load(const ImmersedBoundaryStencilCache& rCache, unsigned pointIndex)
+{
+    const unsigned* p_base_indices = rCache.GetBaseIndices(pointIndex);
+    if (p_base_indices[0] == ImmersedBoundaryStencilCache::UNSET)
+    {
+        return false;
+    }
+
+    const double* p_deltas = rCache.GetDeltas(pointIndex);
+
+    // Only the first index is stored; the rest follow, wrapping around the periodic boundary or reflecting at a wall
+    mBaseIndexX = p_base_indices[0];
+    mBaseIndexY = p_base_indices[1];
+    FillIndices(mBaseIndexX, mNumGridPtsX, mWallsX, mIndicesX, mSignsX);
+    FillIndices(mBaseIndexY, mNumGridPtsY, mWallsY, mIndicesY, mSignsY);
+
+    for (unsigned i = 0; i < WIDTH; i++)
+    {
+        mDeltasX[i] = p_deltas[i];
+        mDeltasY[i] = p_deltas[WIDTH + i];
+    }
+
+    return true;
+}
+
+// Explicit instantiation
+template class ImmersedBoundaryStencil<3>;
+template class ImmersedBoundaryStencil<4>;
+template class ImmersedBoundaryStencil<6>;
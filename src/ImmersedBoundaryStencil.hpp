@@ -0,0 +1,232 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYSTENCIL_HPP_
+#define IMMERSEDBOUNDARYSTENCIL_HPP_
+
+#include "ImmersedBoundaryStencilCache.hpp"
+
+/**
+ * The discrete delta function stencil used to couple a point (a node or fluid source) to the fluid grid, both when
+ * spreading quantities to the grid and when interpolating velocities from it.
+ *
+ * The stencil covers WIDTH grid points in each dimension.  A 3-point stencil uses the kernel of Roma et al. (1999);
+ * 4- and 6-point stencils use the cosine kernel (1 + cos(2 pi r / WIDTH)) / WIDTH.  The cosine weights are evaluated
+ * with a single sine and cosine per dimension, rotating through the remaining grid points, rather than one cosine per
+ * grid point.
+ *
+ * In a direction bounded by free-slip walls the grid points lie at (i + 1/2) times the grid spacing, and any part of
+ * the stencil beyond a wall is reflected back into the domain, onto the mirror image grid point.  Quantities that are
+ * odd about the wall, namely the velocity or force component normal to it, then take the sign given by GetSignX() or
+ * GetSignY(); all others are even, and ignore it.
+ *
+ * All storage is fixed-size, so a stencil may be declared once outside a loop and updated for each point at no cost.
+ */
+template<unsigned WIDTH>
+class ImmersedBoundaryStencil
+{
+private:
+
+    /** The number of grid points in the x direction. */
+    unsigned mNumGridPtsX;
+
+    /** The number of grid points in the y direction. */
+    unsigned mNumGridPtsY;
+
+    /** The reciprocal of the grid spacing in the x direction. */
+    double mRecipSpacingX;
+
+    /** The reciprocal of the grid spacing in the y direction. */
+    double mRecipSpacingY;
+
+    /** The cosine of the angle between successive grid points in the cosine kernel. */
+    double mCosStep;
+
+    /** The sine of the angle between successive grid points in the cosine kernel. */
+    double mSinStep;
+
+    /** Whether the domain is bounded by walls normal to the x direction. */
+    bool mWallsX;
+
+    /** Whether the domain is bounded by walls normal to the y direction. */
+    bool mWallsY;
+
+    /** The first grid index covered in the x direction, before reduction, shifted by the number of grid points. */
+    unsigned mBaseIndexX;
+
+    /** The first grid index covered in the y direction, before reduction, shifted by the number of grid points. */
+    unsigned mBaseIndexY;
+
+    /** The grid indices covered by the stencil in the x direction, taking account of periodicity. */
+    unsigned mIndicesX[WIDTH];
+
+    /** The grid indices covered by the stencil in the y direction, taking account of periodicity. */
+    unsigned mIndicesY[WIDTH];
+
+    /** The delta function weights in the x direction; these sum to 1. */
+    double mDeltasX[WIDTH];
+
+    /** The delta function weights in the y direction; these sum to 1. */
+    double mDeltasY[WIDTH];
+
+    /** The sign, in the x direction, of each grid point's contribution to quantities odd about the x walls. */
+    double mSignsX[WIDTH];
+
+    /** The sign, in the y direction, of each grid point's contribution to quantities odd about the y walls. */
+    double mSignsY[WIDTH];
+
+    /**
+     * Helper method for Update().  Calculates the indices and weights in one dimension.
+     *
+     * @param gridCoordinate the location in units of the grid spacing, relative to the first grid point
+     * @param numGridPts the number of grid points in this dimension
+     * @param walls whether this dimension is bounded by walls
+     * @param rBaseIndex the shifted first index to fill in
+     * @param pIndices the indices to fill in
+     * @param pSigns the signs to fill in
+     * @param pDeltas the weights to fill in
+     */
+    void Update1d(double gridCoordinate,
+                  unsigned numGridPts,
+                  bool walls,
+                  unsigned& rBaseIndex,
+                  unsigned* pIndices,
+                  double* pSigns,
+                  double* pDeltas);
+
+    /**
+     * Helper method for Update1d() and Load().  Calculates the indices and signs in one dimension from the shifted
+     * first index, wrapping around a periodic boundary or reflecting at a wall.
+     *
+     * @param baseIndex the first index, shifted by the number of grid points
+     * @param numGridPts the number of grid points in this dimension
+     * @param walls whether this dimension is bounded by walls
+     * @param pIndices the indices to fill in
+     * @param pSigns the signs to fill in
+     */
+    void FillIndices(unsigned baseIndex, unsigned numGridPts, bool walls, unsigned* pIndices, double* pSigns);
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param numGridPtsX the number of grid points in the x direction
+     * @param numGridPtsY the number of grid points in the y direction
+     * @param domainWidth the size of the periodic domain in the x direction (defaults to 1.0)
+     * @param domainHeight the size of the periodic domain in the y direction (defaults to 1.0)
+     * @param wallsX whether the domain is bounded by walls normal to x rather than periodic (defaults to false)
+     * @param wallsY whether the domain is bounded by walls normal to y rather than periodic (defaults to false)
+     */
+    ImmersedBoundaryStencil(unsigned numGridPtsX,
+                            unsigned numGridPtsY,
+                            double domainWidth=1.0,
+                            double domainHeight=1.0,
+                            bool wallsX=false,
+                            bool wallsY=false);
+
+    /**
+     * Calculate the grid indices and weights for a point in the domain.
+     *
+     * @param x the x coordinate of the point
+     * @param y the y coordinate of the point
+     */
+    void Update(double x, double y);
+
+    /**
+     * Store the current indices and weights in a cache, so they can be reused by Load() while the point is unmoved.
+     *
+     * @param rCache the cache, which must have been reset with this stencil width
+     * @param pointIndex the index of the point in the cache
+     */
+    void Store(ImmersedBoundaryStencilCache& rCache, unsigned pointIndex) const;
+
+    /**
+     * Restore the indices and weights of a point from a cache, as an alternative to Update().
+     *
+     * @param rCache the cache, which must be valid for this stencil width
+     * @param pointIndex the index of the point in the cache
+     * @return whether a stencil was stored for this point; if not, the stencil is unchanged
+     */
+    bool Load(const ImmersedBoundaryStencilCache& rCache, unsigned pointIndex);
+
+    /**
+     * @param i the stencil index, less than WIDTH
+     * @return the grid index in the x direction
+     */
+    unsigned GetIndexX(unsigned i) const
+    {
+        return mIndicesX[i];
+    }
+
+    /**
+     * @param j the stencil index, less than WIDTH
+     * @return the grid index in the y direction
+     */
+    unsigned GetIndexY(unsigned j) const
+    {
+        return mIndicesY[j];
+    }
+
+    /**
+     * @param i the stencil index, less than WIDTH
+     * @return -1 if the grid point is the mirror image of one beyond an x wall, and 1 otherwise
+     */
+    double GetSignX(unsigned i) const
+    {
+        return mSignsX[i];
+    }
+
+    /**
+     * @param j the stencil index, less than WIDTH
+     * @return -1 if the grid point is the mirror image of one beyond a y wall, and 1 otherwise
+     */
+    double GetSignY(unsigned j) const
+    {
+        return mSignsY[j];
+    }
+
+    /**
+     * @param i the stencil index in the x direction, less than WIDTH
+     * @param j the stencil index in the y direction, less than WIDTH
+     * @return the delta function weight at that grid point, without the 1/(grid area) factor
+     */
+    double GetWeight(unsigned i, unsigned j) const
+    {
+        return mDeltasX[i] * mDeltasY[j];
+    }
+};
+
+#endif /*IMMERSEDBOUNDARYSTENCIL_HPP_*/
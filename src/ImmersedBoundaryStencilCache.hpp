@@ -0,0 +1,138 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYSTENCILCACHE_HPP_
+#define IMMERSEDBOUNDARYSTENCILCACHE_HPP_
+
+#include <vector>
+
+/**
+ * Storage for the delta function stencils of a set of points (nodes or fluid sources), so that stencils calculated
+ * when spreading forces to the fluid grid can be reused when interpolating the fluid velocity back to the same,
+ * unmoved, points.
+ *
+ * For each point the cache holds the first grid index in each dimension and the WIDTH weights in each dimension.
+ * The cache is only valid between being filled and the points next moving; it is the responsibility of whoever moves
+ * the points to call Invalidate().
+ */
+class ImmersedBoundaryStencilCache
+{
+private:
+
+    /** The width of the stencils currently stored. */
+    unsigned mStencilWidth;
+
+    /** Whether the cache has been filled since it was last invalidated. */
+    bool mIsValid;
+
+    /** The first grid index in each dimension, two per point. */
+    std::vector<unsigned> mBaseIndices;
+
+    /** The weights in each dimension, 2*mStencilWidth per point. */
+    std::vector<double> mDeltas;
+
+public:
+
+    /** Sentinel base index marking a point whose stencil has not been stored. */
+    static const unsigned UNSET;
+
+    /**
+     * Constructor.
+     */
+    ImmersedBoundaryStencilCache();
+
+    /**
+     * Resize the cache for a number of points and stencil width, marking every point as unset and the cache invalid.
+     *
+     * @param stencilWidth the width of the stencils to be stored
+     * @param numPoints the number of points
+     */
+    void Reset(unsigned stencilWidth, unsigned numPoints);
+
+    /**
+     * Mark the cache as valid, once all stencils have been stored.
+     */
+    void SetValid();
+
+    /**
+     * Mark the cache as invalid, for instance because the points have moved.
+     */
+    void Invalidate();
+
+    /**
+     * @param stencilWidth the stencil width the caller will use
+     * @param numPoints the number of points the caller will look up
+     * @return whether the cache is valid and was filled for this width and number of points
+     */
+    bool IsValid(unsigned stencilWidth, unsigned numPoints) const;
+
+    /**
+     * @param pointIndex the index of the point
+     * @return pointer to the two base indices of the point
+     */
+    unsigned* GetBaseIndices(unsigned pointIndex)
+    {
+        return &mBaseIndices[2 * pointIndex];
+    }
+
+    /**
+     * @param pointIndex the index of the point
+     * @return const pointer to the two base indices of the point
+     */
+    const unsigned* GetBaseIndices(unsigned pointIndex) const
+    {
+        return &mBaseIndices[2 * pointIndex];
+    }
+
+    /**
+     * @param pointIndex the index of the point
+     * @return pointer to the x weights of the point, followed immediately by the y weights
+     */
+    double* GetDeltas(unsigned pointIndex)
+    {
+        return &mDeltas[2 * mStencilWidth * pointIndex];
+    }
+
+    /**
+     * @param pointIndex the index of the point
+     * @return const pointer to the x weights of the point, followed immediately by the y weights
+     */
+    const double* GetDeltas(unsigned pointIndex) const
+    {
+        return &mDeltas[2 * mStencilWidth * pointIndex];
+    }
+};
+
+#endif /*IMMERSEDBOUNDARYSTENCILCACHE_HPP_*/
@@ -0,0 +1,112 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryStripPartition.hpp"
+#include <cassert>
+#include <algorithm>
+#include <cmath>
+
+ImmersedBoundaryStripPartition::ImmersedBoundaryStripPartition(unsigned numGridPtsX, unsigned stencilWidth)
+    : mNumGridPtsX(numGridPtsX),
+      mStencilWidth(stencilWidth)
+{
+    assert(stencilWidth > 0 && numGridPtsX >= stencilWidth);
+
+    /*
+     * Strips twice the stencil width comfortably contain a stencil even if rounding places a point one grid point
+     * away from the strip its stencil is calculated in.  Dividing into 32 strips per even/odd phase, where possible,
+     * gives enough independent work to balance the load across threads.
+     */
+    mStripWidth = std::max(2 * stencilWidth, numGridPtsX / 64);
+    mNumStrips = 2 * (numGridPtsX / (2 * mStripWidth));
+
+    if (mNumStrips < 2)
+    {
+        mNumStrips = 1;
+        mStripWidth = numGridPtsX;
+    }
+
+    mStripOffsets.resize(mNumStrips + 1);
+}
+
+void ImmersedBoundaryStripPartition::Partition(const std::vector<double>& rXCoordinates)
+{
+    unsigned num_points = rXCoordinates.size();
+
+    mOrder.resize(num_points);
+    mStripOfPoint.resize(num_points);
+    std::fill(mStripOffsets.begin(), mStripOffsets.end(), 0u);
+
+    // Find the strip containing the first x index of each point's stencil, and count the points in each strip
+    for (unsigned point = 0; point < num_points; point++)
+    {
+        int first_idx = (int) floor(rXCoordinates[point] * mNumGridPtsX - 0.5 * mStencilWidth + 1.0);
+        unsigned wrapped_idx = (unsigned) (first_idx + (int) mNumGridPtsX) % mNumGridPtsX;
+
+        unsigned strip = std::min(wrapped_idx / mStripWidth, mNumStrips - 1);
+
+        mStripOfPoint[point] = strip;
+        mStripOffsets[strip + 1]++;
+    }
+
+    // Convert the counts to offsets, then place each point, preserving the original order within each strip
+    for (unsigned strip = 0; strip < mNumStrips; strip++)
+    {
+        mStripOffsets[strip + 1] += mStripOffsets[strip];
+    }
+
+    std::vector<unsigned> next_offset(mStripOffsets.begin(), mStripOffsets.end() - 1);
+    for (unsigned point = 0; point < num_points; point++)
+    {
+        mOrder[next_offset[mStripOfPoint[point]]++] = point;
+    }
+}
+
+unsigned ImmersedBoundaryStripPartition::GetNumStrips() const
+{
+    return mNumStrips;
+}
+
+unsigned ImmersedBoundaryStripPartition::GetStripBegin(unsigned stripIndex) const
+{
+    assert(stripIndex < mNumStrips);
+    return mStripOffsets[stripIndex];
+}
+
+unsigned ImmersedBoundaryStripPartition::GetStripEnd(unsigned stripIndex) const
+{
+    assert(stripIndex < mNumStrips);
+    return mStripOffsets[stripIndex + 1];
+}
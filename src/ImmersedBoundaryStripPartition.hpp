@@ -0,0 +1,121 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYSTRIPPARTITION_HPP_
+#define IMMERSEDBOUNDARYSTRIPPARTITION_HPP_
+
+#include <vector>
+
+/**
+ * Partitions points (nodes or fluid sources) into vertical strips of the fluid grid, so that spreading to the grid
+ * can be carried out by several threads without two threads writing to the same grid point.
+ *
+ * The strips are at least twice the stencil width, and there is an even number of them.  A point is assigned to the
+ * strip containing the first x index of its stencil, so its stencil can only reach into the next strip (wrapping
+ * from the last strip to the first).  It is therefore safe to process all even strips concurrently, and then all odd
+ * strips concurrently.
+ *
+ * The layout depends only on the grid and stencil width, and each strip is processed in the original point order, so
+ * the order in which contributions are summed at any grid point is the same however many threads are used.  The
+ * results of spreading are therefore identical for any number of threads.
+ */
+class ImmersedBoundaryStripPartition
+{
+private:
+
+    /** The number of grid points in the x direction. */
+    unsigned mNumGridPtsX;
+
+    /** The stencil width the partition is built for. */
+    unsigned mStencilWidth;
+
+    /** The width, in grid points, of every strip but the last, which also takes any remainder. */
+    unsigned mStripWidth;
+
+    /** The number of strips; either an even number, or 1 if the grid is too small to partition. */
+    unsigned mNumStrips;
+
+    /** Offsets into #mOrder of the start of each strip, with a final entry of the number of points. */
+    std::vector<unsigned> mStripOffsets;
+
+    /** The point indices, ordered by strip and, within each strip, in their original order. */
+    std::vector<unsigned> mOrder;
+
+    /** Scratch space recording the strip of each point, stored to avoid reallocation. */
+    std::vector<unsigned> mStripOfPoint;
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param numGridPtsX the number of grid points in the x direction
+     * @param stencilWidth the width of the stencil used for spreading
+     */
+    ImmersedBoundaryStripPartition(unsigned numGridPtsX, unsigned stencilWidth);
+
+    /**
+     * Assign points to strips.
+     *
+     * @param rXCoordinates the x coordinate, in the unit interval, of each point
+     */
+    void Partition(const std::vector<double>& rXCoordinates);
+
+    /** @return #mNumStrips */
+    unsigned GetNumStrips() const;
+
+    /**
+     * @param stripIndex the strip
+     * @return the offset into the ordering of the first point in the strip
+     */
+    unsigned GetStripBegin(unsigned stripIndex) const;
+
+    /**
+     * @param stripIndex the strip
+     * @return the offset into the ordering one past the last point in the strip
+     */
+    unsigned GetStripEnd(unsigned stripIndex) const;
+
+    /**
+     * @param offset the offset into the ordering
+     * @return the index of the point at that offset
+     */
+    unsigned GetPoint(unsigned offset) const
+    {
+        return mOrder[offset];
+    }
+};
+
+#endif /*IMMERSEDBOUNDARYSTRIPPARTITION_HPP_*/
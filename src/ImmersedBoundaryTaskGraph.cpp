@@ -0,0 +1,225 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryTaskGraph.hpp"
+#include <cassert>
+#include "Exception.hpp"
+
+unsigned ImmersedBoundaryTaskGraph::AddTask(TaskFunction function, void* pData, unsigned argument)
+{
+    assert(function != NULL);
+
+    mFunctions.push_back(function);
+    mData.push_back(pData);
+    mArguments.push_back(argument);
+    mSuccessors.push_back(std::vector<unsigned>());
+    mNumPredecessors.push_back(0);
+
+    return mFunctions.size() - 1;
+}
+
+void ImmersedBoundaryTaskGraph::AddDependency(unsigned before, unsigned after)
+{
+    assert(before < mFunctions.size());
+    assert(after < mFunctions.size());
+
+    mSuccessors[before].push_back(after);
+    mNumPredecessors[after]++;
+}
+
+void ImmersedBoundaryTaskGraph::Clear()
+{
+    mFunctions.clear();
+    mData.clear();
+    mArguments.clear();
+    mSuccessors.clear();
+    mNumPredecessors.clear();
+}
+
+unsigned ImmersedBoundaryTaskGraph::GetNumTasks() const
+{
+    return mFunctions.size();
+}
+
+std::vector<unsigned> ImmersedBoundaryTaskGraph::GetTopologicalOrder() const
+{
+    std::vector<unsigned> num_waiting(mNumPredecessors);
+    std::vector<unsigned> order;
+    order.reserve(mFunctions.size());
+
+    // Each task is taken as soon as the last task it depends on has been, earliest added first
+    std::vector<unsigned> ready;
+    for (unsigned task = mFunctions.size(); task-- > 0; )
+    {
+        if (num_waiting[task] == 0)
+        {
+            ready.push_back(task);
+        }
+    }
+
+    while (!ready.empty())
+    {
+        unsigned task = ready.back();
+        ready.pop_back();
+        order.push_back(task);
+
+        const std::vector<unsigned>& r_successors = mSuccessors[task];
+        for (unsigned idx = r_successors.size(); idx-- > 0; )
+        {
+            if (--num_waiting[r_successors[idx]] == 0)
+            {
+                ready.push_back(r_successors[idx]);
+            }
+        }
+    }
+
+    return order;
+}
+
+void ImmersedBoundaryTaskGraph::RunTask(unsigned task)
+{
+    try
+    {
+        mFunctions[task](mData[task], mArguments[task]);
+    }
+    catch (Exception& e)
+    {
+#ifdef _OPENMP
+#pragma omp critical(ImmersedBoundaryTaskGraphError)
+#endif
+        {
+            if (mErrorMessage.empty())
+            {
+                mErrorMessage = e.GetShortMessage();
+            }
+        }
+        return;
+    }
+
+    // The last task to finish of those another depends on starts it
+    const std::vector<unsigned>& r_successors = mSuccessors[task];
+    for (unsigned idx = 0; idx < r_successors.size(); idx++)
+    {
+        unsigned successor = r_successors[idx];
+
+        int num_waiting;
+#ifdef _OPENMP
+#pragma omp atomic capture
+#endif
+        num_waiting = --mNumWaiting[successor];
+
+        if (num_waiting == 0)
+        {
+#ifdef _OPENMP
+#pragma omp task firstprivate(successor)
+#endif
+            RunTask(successor);
+        }
+    }
+}
+
+void ImmersedBoundaryTaskGraph::Run(unsigned numThreads)
+{
+    assert(numThreads > 0);
+
+    std::vector<unsigned> order = GetTopologicalOrder();
+    if (order.size() != mFunctions.size())
+    {
+        EXCEPTION("The dependencies of the task graph have a cycle");
+    }
+
+    mErrorMessage = "";
+
+#ifdef _OPENMP
+    if (numThreads > 1)
+    {
+        mNumWaiting.assign(mNumPredecessors.begin(), mNumPredecessors.end());
+
+        // Every task is started from another, other than those depending on none, which are started here
+#pragma omp parallel num_threads(numThreads)
+        {
+#pragma omp single
+            {
+                for (unsigned task = 0; task < mFunctions.size(); task++)
+                {
+                    if (mNumPredecessors[task] == 0)
+                    {
+#pragma omp task firstprivate(task)
+                        RunTask(task);
+                    }
+                }
+            }
+        }
+    }
+    else
+#endif
+    {
+        // The tasks depending on one that throws are not run, and neither are those depending on them
+        std::vector<bool> is_cancelled(mFunctions.size(), false);
+        for (unsigned idx = 0; idx < order.size(); idx++)
+        {
+            unsigned task = order[idx];
+            if (is_cancelled[task])
+            {
+                for (unsigned succ_idx = 0; succ_idx < mSuccessors[task].size(); succ_idx++)
+                {
+                    is_cancelled[mSuccessors[task][succ_idx]] = true;
+                }
+                continue;
+            }
+
+            try
+            {
+                mFunctions[task](mData[task], mArguments[task]);
+            }
+            catch (Exception& e)
+            {
+                if (mErrorMessage.empty())
+                {
+                    mErrorMessage = e.GetShortMessage();
+                }
+                for (unsigned succ_idx = 0; succ_idx < mSuccessors[task].size(); succ_idx++)
+                {
+                    is_cancelled[mSuccessors[task][succ_idx]] = true;
+                }
+            }
+        }
+    }
+
+    if (!mErrorMessage.empty())
+    {
+        EXCEPTION(mErrorMessage);
+    }
+}
@@ -0,0 +1,137 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYTASKGRAPH_HPP_
+#define IMMERSEDBOUNDARYTASKGRAPH_HPP_
+
+#include <string>
+#include <vector>
+
+/**
+ * A graph of tasks with dependencies between them, such as the phases of an immersed boundary timestep, which is run
+ * with as many tasks in flight at once as the dependencies allow.
+ *
+ * Each task is a function called with a data pointer and an argument, in the manner of a thread entry point.  A task
+ * is started only once every task it depends on has finished.  When built with OpenMP, and run on more than one
+ * thread, each task is an OpenMP task: those with no dependencies are started at once, and the last task to finish
+ * before another starts it, so the runtime's work-stealing scheduler keeps every thread busy for as long as any task
+ * is ready.  Otherwise, the tasks are run in turn, in an order in which each follows every task it depends on.
+ *
+ * Tasks run concurrently must not write to the same data.  Any threaded loops within a task run on one thread
+ * unless OpenMP nested parallelism is enabled.  An exception thrown by a task is rethrown by Run() once every task
+ * not depending on it has finished, and the tasks depending on it are not run.
+ */
+class ImmersedBoundaryTaskGraph
+{
+public:
+
+    /** The function run by a task, which is given the data and argument the task was added with. */
+    typedef void (*TaskFunction)(void* pData, unsigned argument);
+
+private:
+
+    /** The function of each task. */
+    std::vector<TaskFunction> mFunctions;
+
+    /** The data passed to the function of each task. */
+    std::vector<void*> mData;
+
+    /** The argument passed to the function of each task. */
+    std::vector<unsigned> mArguments;
+
+    /** The tasks depending on each task. */
+    std::vector<std::vector<unsigned> > mSuccessors;
+
+    /** The number of tasks each task depends on. */
+    std::vector<unsigned> mNumPredecessors;
+
+    /** The number of unfinished tasks each task is waiting for, while the graph is run. */
+    std::vector<int> mNumWaiting;
+
+    /** The message of the first exception thrown by a task while the graph is run, or empty if none has been. */
+    std::string mErrorMessage;
+
+    /**
+     * Helper method for Run().  Run a task and, unless it throws, start each task that was waiting only for it.
+     *
+     * @param task the task
+     */
+    void RunTask(unsigned task);
+
+    /**
+     * Helper method for Run().
+     *
+     * @return the tasks in an order in which each follows every task it depends on, which is shorter than the number
+     *     of tasks if the dependencies have a cycle
+     */
+    std::vector<unsigned> GetTopologicalOrder() const;
+
+public:
+
+    /**
+     * Add a task.
+     *
+     * @param function the function to run
+     * @param pData the data to pass to the function
+     * @param argument the argument to pass to the function
+     * @return the index of the task
+     */
+    unsigned AddTask(TaskFunction function, void* pData, unsigned argument);
+
+    /**
+     * Make one task depend on another, so it starts only once the other has finished.
+     *
+     * @param before the task to finish first
+     * @param after the task depending on it
+     */
+    void AddDependency(unsigned before, unsigned after);
+
+    /**
+     * Remove every task.
+     */
+    void Clear();
+
+    /** @return the number of tasks */
+    unsigned GetNumTasks() const;
+
+    /**
+     * Run every task, once, respecting the dependencies.
+     *
+     * @param numThreads the number of threads to run the tasks on
+     */
+    void Run(unsigned numThreads);
+};
+
+#endif /*IMMERSEDBOUNDARYTASKGRAPH_HPP_*/
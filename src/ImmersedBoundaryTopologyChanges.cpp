@@ -0,0 +1,141 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryTopologyChanges.hpp"
+#include <algorithm>
+#include <climits>
+
+ImmersedBoundaryTopologyChanges::ImmersedBoundaryTopologyChanges()
+{
+    Clear();
+}
+
+void ImmersedBoundaryTopologyChanges::RecordChangedElement(unsigned elementIndex)
+{
+    if (std::find(mChangedElements.begin(), mChangedElements.end(), elementIndex) == mChangedElements.end())
+    {
+        mChangedElements.push_back(elementIndex);
+    }
+}
+
+void ImmersedBoundaryTopologyChanges::RecordDeletedElement()
+{
+    mNumDeletedElements++;
+}
+
+void ImmersedBoundaryTopologyChanges::RecordRenumbering(const std::vector<unsigned>& rNewNodeIndices,
+                                                        const std::vector<unsigned>& rNewElementIndices)
+{
+    ComposeRenumbering(mNewNodeIndices, rNewNodeIndices);
+    ComposeRenumbering(mNewElementIndices, rNewElementIndices);
+
+    // The changed elements are referred to by their current indices, and any since removed are forgotten
+    unsigned num_kept = 0;
+    for (unsigned idx = 0; idx < mChangedElements.size(); idx++)
+    {
+        unsigned new_index = rNewElementIndices[mChangedElements[idx]];
+        if (new_index != UINT_MAX)
+        {
+            mChangedElements[num_kept++] = new_index;
+        }
+    }
+    mChangedElements.resize(num_kept);
+}
+
+void ImmersedBoundaryTopologyChanges::ComposeRenumbering(std::vector<unsigned>& rNewIndices,
+                                                         const std::vector<unsigned>& rRenumbering)
+{
+    if (rNewIndices.empty())
+    {
+        rNewIndices = rRenumbering;
+        return;
+    }
+
+    /*
+     * Indices created since the last renumbering, for instance by division, are not in the renumbering so far, which
+     * starts from the indices when the record was cleared.
+     */
+    for (unsigned idx = 0; idx < rNewIndices.size(); idx++)
+    {
+        if (rNewIndices[idx] != UINT_MAX)
+        {
+            rNewIndices[idx] = rRenumbering[rNewIndices[idx]];
+        }
+    }
+}
+
+void ImmersedBoundaryTopologyChanges::MarkIncomplete()
+{
+    mIsComplete = false;
+}
+
+void ImmersedBoundaryTopologyChanges::Clear()
+{
+    mChangedElements.clear();
+    mNumDeletedElements = 0;
+    mNewNodeIndices.clear();
+    mNewElementIndices.clear();
+    mIsComplete = true;
+}
+
+bool ImmersedBoundaryTopologyChanges::HasChanges() const
+{
+    return !mIsComplete || !mChangedElements.empty() || mNumDeletedElements > 0 || !mNewNodeIndices.empty();
+}
+
+bool ImmersedBoundaryTopologyChanges::IsComplete() const
+{
+    return mIsComplete;
+}
+
+const std::vector<unsigned>& ImmersedBoundaryTopologyChanges::rGetChangedElements() const
+{
+    return mChangedElements;
+}
+
+unsigned ImmersedBoundaryTopologyChanges::GetNumDeletedElements() const
+{
+    return mNumDeletedElements;
+}
+
+const std::vector<unsigned>& ImmersedBoundaryTopologyChanges::rGetNewNodeIndices() const
+{
+    return mNewNodeIndices;
+}
+
+const std::vector<unsigned>& ImmersedBoundaryTopologyChanges::rGetNewElementIndices() const
+{
+    return mNewElementIndices;
+}
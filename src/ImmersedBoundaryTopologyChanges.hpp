@@ -0,0 +1,140 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYTOPOLOGYCHANGES_HPP_
+#define IMMERSEDBOUNDARYTOPOLOGYCHANGES_HPP_
+
+#include <vector>
+
+/**
+ * A record, kept by ImmersedBoundaryMesh, of the changes to its nodes and elements since the record was last cleared,
+ * so that structures built from the nodes, such as an ImmersedBoundaryNodePairList, can be updated to match rather
+ * than rebuilt.
+ *
+ * Division changes the nodes of two elements: those of the dividing element are moved, and those of the new element
+ * are created.  Death marks the nodes of an element as deleted, and ReMesh() then removes them and renumbers the
+ * remaining nodes and elements.  Any other renumbering, such as along a space filling curve, is not recorded in
+ * detail, and instead makes the record incomplete, so that such structures must be rebuilt.
+ */
+class ImmersedBoundaryTopologyChanges
+{
+private:
+
+    /**
+     * The current indices of the elements whose nodes have been created or moved by division, in the order they
+     * were recorded, without repeats.
+     */
+    std::vector<unsigned> mChangedElements;
+
+    /** The number of elements deleted. */
+    unsigned mNumDeletedElements;
+
+    /**
+     * The current index of each node, indexed by its index when the record was cleared, or UINT_MAX if it has been
+     * removed.  Empty if the nodes have not been renumbered.
+     */
+    std::vector<unsigned> mNewNodeIndices;
+
+    /** As #mNewNodeIndices, for the elements. */
+    std::vector<unsigned> mNewElementIndices;
+
+    /** Whether every change has been recorded in detail. */
+    bool mIsComplete;
+
+    /**
+     * Helper method for RecordRenumbering().  Compose a renumbering with the renumbering so far.
+     *
+     * @param rNewIndices the renumbering so far, replaced by the composition
+     * @param rRenumbering the new index of each current index, or UINT_MAX if removed
+     */
+    static void ComposeRenumbering(std::vector<unsigned>& rNewIndices, const std::vector<unsigned>& rRenumbering);
+
+public:
+
+    /**
+     * Constructor.  The record starts cleared.
+     */
+    ImmersedBoundaryTopologyChanges();
+
+    /**
+     * Record that the nodes of an element have been created or moved.
+     *
+     * @param elementIndex the current index of the element
+     */
+    void RecordChangedElement(unsigned elementIndex);
+
+    /**
+     * Record that an element, and its nodes, have been marked as deleted.
+     */
+    void RecordDeletedElement();
+
+    /**
+     * Record that the nodes and elements have been renumbered, and any that were deleted removed.
+     *
+     * @param rNewNodeIndices the new index of each node, indexed by its old index, or UINT_MAX if removed
+     * @param rNewElementIndices the new index of each element, indexed by its old index, or UINT_MAX if removed
+     */
+    void RecordRenumbering(const std::vector<unsigned>& rNewNodeIndices, const std::vector<unsigned>& rNewElementIndices);
+
+    /**
+     * Record that the nodes or elements have changed in a way not recorded in detail.
+     */
+    void MarkIncomplete();
+
+    /**
+     * Clear the record, once the structures built from the nodes are up to date.
+     */
+    void Clear();
+
+    /** @return whether anything has changed since the record was cleared */
+    bool HasChanges() const;
+
+    /** @return #mIsComplete */
+    bool IsComplete() const;
+
+    /** @return #mChangedElements */
+    const std::vector<unsigned>& rGetChangedElements() const;
+
+    /** @return #mNumDeletedElements */
+    unsigned GetNumDeletedElements() const;
+
+    /** @return #mNewNodeIndices */
+    const std::vector<unsigned>& rGetNewNodeIndices() const;
+
+    /** @return #mNewElementIndices */
+    const std::vector<unsigned>& rGetNewElementIndices() const;
+};
+
+#endif /*IMMERSEDBOUNDARYTOPOLOGYCHANGES_HPP_*/
@@ -0,0 +1,382 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryTracer.hpp"
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <pthread.h>
+#include <set>
+#include <vector>
+#include "Exception.hpp"
+#include "ImmersedBoundaryPhaseTimer.hpp"
+#include "OutputFileHandler.hpp"
+
+bool ImmersedBoundaryTracer::msEnabled = false;
+
+namespace
+{
+
+/** A span recorded by a thread. */
+struct TraceSpanRecord
+{
+    /** The name of the span. */
+    const char* mpName;
+
+    /** The category of the span. */
+    const char* mpCategory;
+
+    /** The wall time at which the span started. */
+    double mStartTime;
+
+    /** The wall time at which the span ended. */
+    double mEndTime;
+};
+
+/** The spans recorded by a thread, only ever written by that thread. */
+struct TraceThreadBuffer
+{
+    /**
+     * The ring buffer of spans, in which span n is stored at n modulo its size.  It is sized only by its own thread,
+     * with #trace_mutex held, as another thread would race with the spans being recorded.
+     */
+    std::vector<TraceSpanRecord> mSpans;
+
+    /** The number of spans recorded, only incremented once the newest span has been stored. */
+    volatile unsigned long long mNumRecorded;
+
+    /** The number of spans recorded before tracing was last enabled, which are discarded.  Guarded by the mutex. */
+    unsigned long long mNumDiscarded;
+
+    /** The order in which the thread first recorded a span, which identifies it in the trace. */
+    unsigned mThreadIndex;
+
+    /** The name of the thread, or NULL if it has not been named. */
+    const char* volatile mpThreadName;
+
+    /** Whether the thread has finished, so the buffer may be discarded once its spans are no longer wanted. */
+    bool mThreadHasFinished;
+};
+
+/** Guards the names, the list of buffers and their sizes, but is not taken to record a span. */
+pthread_mutex_t trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** Holds the buffer of each thread. */
+pthread_key_t trace_buffer_key;
+
+/** Ensures #trace_buffer_key is created once. */
+pthread_once_t trace_buffer_key_once = PTHREAD_ONCE_INIT;
+
+/** The buffer of every thread that has recorded a span since tracing was last enabled. */
+std::vector<TraceThreadBuffer*> trace_buffers;
+
+/** The number of threads that have ever recorded a span. */
+unsigned trace_num_threads = 0;
+
+/** The number of spans kept for each thread. */
+unsigned trace_num_spans_per_thread = 0;
+
+/** The wall time at which tracing was last enabled, from which the spans are timed in the trace. */
+double trace_start_time = 0.0;
+
+/** The names interned so far. */
+std::set<std::string> trace_names;
+
+/**
+ * Called as a thread finishes.  Its spans are kept, as the thread may have been a background writer.
+ *
+ * @param pBuffer the buffer of the thread
+ */
+void MarkTraceThreadFinished(void* pBuffer)
+{
+    pthread_mutex_lock(&trace_mutex);
+    static_cast<TraceThreadBuffer*>(pBuffer)->mThreadHasFinished = true;
+    pthread_mutex_unlock(&trace_mutex);
+}
+
+/** Create #trace_buffer_key. */
+void CreateTraceBufferKey()
+{
+    pthread_key_create(&trace_buffer_key, MarkTraceThreadFinished);
+}
+
+/**
+ * @return the buffer of the calling thread, created the first time it is needed
+ */
+TraceThreadBuffer* GetTraceThreadBuffer()
+{
+    pthread_once(&trace_buffer_key_once, CreateTraceBufferKey);
+    TraceThreadBuffer* p_buffer = static_cast<TraceThreadBuffer*>(pthread_getspecific(trace_buffer_key));
+    if (p_buffer == NULL)
+    {
+        p_buffer = new TraceThreadBuffer;
+        p_buffer->mNumRecorded = 0;
+        p_buffer->mNumDiscarded = 0;
+        p_buffer->mpThreadName = NULL;
+        p_buffer->mThreadHasFinished = false;
+
+        pthread_mutex_lock(&trace_mutex);
+        p_buffer->mSpans.resize(trace_num_spans_per_thread);
+        p_buffer->mThreadIndex = trace_num_threads++;
+        trace_buffers.push_back(p_buffer);
+        pthread_mutex_unlock(&trace_mutex);
+
+        pthread_setspecific(trace_buffer_key, p_buffer);
+    }
+    return p_buffer;
+}
+
+/**
+ * Write a string to a JSON file, quoted and escaped.
+ *
+ * @param rFile the file
+ * @param pString the string
+ */
+void WriteJsonString(std::ostream& rFile, const char* pString)
+{
+    rFile << '"';
+    for (const char* p_char = pString; *p_char != '\0'; p_char++)
+    {
+        if (*p_char == '"' || *p_char == '\\')
+        {
+            rFile << '\\' << *p_char;
+        }
+        else if ((unsigned char)*p_char < 0x20)
+        {
+            rFile << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (unsigned)*p_char
+                  << std::dec << std::setfill(' ');
+        }
+        else
+        {
+            rFile << *p_char;
+        }
+    }
+    rFile << '"';
+}
+
+} // namespace
+
+void ImmersedBoundaryTracer::Enable(unsigned numSpansPerThread)
+{
+    assert(numSpansPerThread > 0);
+
+    pthread_once(&trace_buffer_key_once, CreateTraceBufferKey);
+    TraceThreadBuffer* p_own_buffer = static_cast<TraceThreadBuffer*>(pthread_getspecific(trace_buffer_key));
+
+    pthread_mutex_lock(&trace_mutex);
+
+    // Other running threads may be recording into their buffers, so those cannot be resized
+    for (unsigned i = 0; i < trace_buffers.size(); i++)
+    {
+        TraceThreadBuffer* p_buffer = trace_buffers[i];
+        if (p_buffer != p_own_buffer && !p_buffer->mThreadHasFinished &&
+            !p_buffer->mSpans.empty() && p_buffer->mSpans.size() != numSpansPerThread)
+        {
+            unsigned num_spans = p_buffer->mSpans.size();
+            pthread_mutex_unlock(&trace_mutex);
+            EXCEPTION("Tracing cannot be enabled with " << numSpansPerThread << " spans per thread while another "
+                      << "running thread keeps " << num_spans << " spans");
+        }
+    }
+
+    // Discard the buffers of finished threads, and the spans of the rest
+    std::vector<TraceThreadBuffer*> buffers;
+    for (unsigned i = 0; i < trace_buffers.size(); i++)
+    {
+        if (trace_buffers[i]->mThreadHasFinished)
+        {
+            delete trace_buffers[i];
+        }
+        else
+        {
+            if (trace_buffers[i] == p_own_buffer)
+            {
+                p_own_buffer->mSpans.resize(numSpansPerThread);
+            }
+            trace_buffers[i]->mNumDiscarded = trace_buffers[i]->mNumRecorded;
+            buffers.push_back(trace_buffers[i]);
+        }
+    }
+    trace_buffers.swap(buffers);
+    trace_num_spans_per_thread = numSpansPerThread;
+    trace_start_time = ImmersedBoundaryPhaseTimer::GetWallTime();
+    msEnabled = true;
+
+    pthread_mutex_unlock(&trace_mutex);
+}
+
+void ImmersedBoundaryTracer::Disable()
+{
+    msEnabled = false;
+}
+
+const char* ImmersedBoundaryTracer::InternName(const std::string& rName)
+{
+    pthread_mutex_lock(&trace_mutex);
+    const char* p_name = trace_names.insert(rName).first->c_str();
+    pthread_mutex_unlock(&trace_mutex);
+    return p_name;
+}
+
+void ImmersedBoundaryTracer::SetThreadName(const std::string& rName)
+{
+    GetTraceThreadBuffer()->mpThreadName = InternName(rName);
+}
+
+void ImmersedBoundaryTracer::RecordSpan(const char* pName, const char* pCategory, double startTime, double endTime)
+{
+    if (!msEnabled)
+    {
+        return;
+    }
+
+    TraceThreadBuffer* p_buffer = GetTraceThreadBuffer();
+
+    // A thread that first recorded nothing while tracing was disabled sizes its buffer now
+    if (p_buffer->mSpans.empty())
+    {
+        pthread_mutex_lock(&trace_mutex);
+        p_buffer->mSpans.resize(trace_num_spans_per_thread);
+        pthread_mutex_unlock(&trace_mutex);
+        if (p_buffer->mSpans.empty())
+        {
+            return;
+        }
+    }
+
+    unsigned long long num_recorded = p_buffer->mNumRecorded;
+
+    TraceSpanRecord& r_span = p_buffer->mSpans[num_recorded % p_buffer->mSpans.size()];
+    r_span.mpName = pName;
+    r_span.mpCategory = pCategory;
+    r_span.mStartTime = startTime;
+    r_span.mEndTime = endTime;
+
+    // The span must be stored before it is counted, as the trace may be written by another thread meanwhile
+    __sync_synchronize();
+    p_buffer->mNumRecorded = num_recorded + 1;
+}
+
+unsigned ImmersedBoundaryTracer::GetNumSpans()
+{
+    unsigned num_spans = 0;
+
+    pthread_mutex_lock(&trace_mutex);
+    for (unsigned i = 0; i < trace_buffers.size(); i++)
+    {
+        unsigned long long num_recorded = trace_buffers[i]->mNumRecorded - trace_buffers[i]->mNumDiscarded;
+        num_spans += std::min(num_recorded, (unsigned long long)trace_buffers[i]->mSpans.size());
+    }
+    pthread_mutex_unlock(&trace_mutex);
+
+    return num_spans;
+}
+
+void ImmersedBoundaryTracer::WriteChromeTrace(const std::string& directoryName, const std::string& fileName)
+{
+    OutputFileHandler output_file_handler(directoryName, false);
+    out_stream p_file = output_file_handler.OpenOutputFile(fileName);
+    *p_file << std::fixed << std::setprecision(3);
+    *p_file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    pthread_mutex_lock(&trace_mutex);
+    bool first_event = true;
+    for (unsigned i = 0; i < trace_buffers.size(); i++)
+    {
+        const TraceThreadBuffer& r_buffer = *(trace_buffers[i]);
+        unsigned long long capacity = r_buffer.mSpans.size();
+
+        // Copy the spans held, then leave out any the thread has overwritten meanwhile
+        unsigned long long num_recorded = r_buffer.mNumRecorded;
+        __sync_synchronize();
+        unsigned long long first_span = num_recorded > capacity ? num_recorded - capacity : 0;
+        first_span = std::max(first_span, r_buffer.mNumDiscarded);
+        std::vector<TraceSpanRecord> spans;
+        for (unsigned long long span = first_span; span < num_recorded; span++)
+        {
+            spans.push_back(r_buffer.mSpans[span % capacity]);
+        }
+        __sync_synchronize();
+        unsigned long long num_recorded_after = r_buffer.mNumRecorded;
+        unsigned long long num_overwritten = 0;
+        if (num_recorded_after > capacity && num_recorded_after - capacity > first_span)
+        {
+            num_overwritten = std::min(num_recorded_after - capacity - first_span, (unsigned long long)spans.size());
+        }
+
+        // Chrome nests spans on a thread by time, with timestamps and durations in microseconds
+        for (unsigned span = num_overwritten; span < spans.size(); span++)
+        {
+            *p_file << (first_event ? "\n" : ",\n");
+            first_event = false;
+            *p_file << "{\"name\":";
+            WriteJsonString(*p_file, spans[span].mpName);
+            *p_file << ",\"cat\":";
+            WriteJsonString(*p_file, spans[span].mpCategory);
+            *p_file << ",\"ph\":\"X\",\"ts\":" << 1e6 * (spans[span].mStartTime - trace_start_time)
+                    << ",\"dur\":" << 1e6 * (spans[span].mEndTime - spans[span].mStartTime)
+                    << ",\"pid\":0,\"tid\":" << r_buffer.mThreadIndex << "}";
+        }
+
+        if (r_buffer.mpThreadName != NULL)
+        {
+            *p_file << (first_event ? "\n" : ",\n");
+            first_event = false;
+            *p_file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << r_buffer.mThreadIndex
+                    << ",\"args\":{\"name\":";
+            WriteJsonString(*p_file, r_buffer.mpThreadName);
+            *p_file << "}}";
+        }
+    }
+    pthread_mutex_unlock(&trace_mutex);
+
+    *p_file << "\n]}\n";
+    p_file->close();
+}
+
+ImmersedBoundaryTraceSpan::ImmersedBoundaryTraceSpan(const char* pName, const char* pCategory)
+    : mpName(ImmersedBoundaryTracer::IsEnabled() ? pName : NULL),
+      mpCategory(pCategory),
+      mStartTime(mpName != NULL ? ImmersedBoundaryPhaseTimer::GetWallTime() : 0.0)
+{
+}
+
+ImmersedBoundaryTraceSpan::~ImmersedBoundaryTraceSpan()
+{
+    if (mpName != NULL)
+    {
+        ImmersedBoundaryTracer::RecordSpan(mpName, mpCategory, mStartTime, ImmersedBoundaryPhaseTimer::GetWallTime());
+    }
+}
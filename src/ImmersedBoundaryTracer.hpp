@@ -0,0 +1,149 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYTRACER_HPP_
+#define IMMERSEDBOUNDARYTRACER_HPP_
+
+#include <string>
+
+/**
+ * An optional, process-wide record of when each thread entered and left each of a number of named spans, such as the
+ * phases timed by ImmersedBoundaryPhaseTimer, the calculation of each force, the writing of output (including by the
+ * background VTK writer) and operations on the mesh.  Unlike the aggregate timings, the record shows how these
+ * interact from step to step, and may be written as a Chrome trace for viewing in Perfetto or chrome://tracing.
+ *
+ * Each thread records its spans in its own ring buffer, which holds its most recent spans, so recording takes no lock
+ * and a long simulation keeps only its last few hundred steps.  Spans recorded by one thread nest by time, so a span
+ * may be recorded within another.  Tracing is off until Enable() is called, when recording a span costs only a check.
+ */
+class ImmersedBoundaryTracer
+{
+private:
+
+    /** Whether spans are being recorded. */
+    static bool msEnabled;
+
+public:
+
+    /**
+     * Start recording spans, discarding any recorded so far.  The buffer of a thread is only ever resized by the thread
+     * itself, so this may be called while other threads are recording spans, such as a background writer, but throws
+     * if any of them keeps a different number of spans from numSpansPerThread.
+     *
+     * @param numSpansPerThread the number of most recent spans kept for each thread (defaults to 65536)
+     */
+    static void Enable(unsigned numSpansPerThread=65536u);
+
+    /**
+     * Stop recording spans.  Those recorded so far are kept, so may still be written.
+     */
+    static void Disable();
+
+    /** @return whether spans are being recorded */
+    static bool IsEnabled()
+    {
+        return msEnabled;
+    }
+
+    /**
+     * @param rName a name, such as of a span or thread
+     * @return a copy of the name that lasts as long as the program, so may be recorded with each span
+     */
+    static const char* InternName(const std::string& rName);
+
+    /**
+     * Name the calling thread in the trace.  Threads not named are labelled by the order they first recorded a span.
+     *
+     * @param rName the name of the thread
+     */
+    static void SetThreadName(const std::string& rName);
+
+    /**
+     * Record a span on the calling thread, if tracing is enabled.
+     *
+     * @param pName the name of the span, which must last as long as the program, such as a literal or InternName()
+     * @param pCategory the category of the span, which must last as long as the program
+     * @param startTime the wall time, from ImmersedBoundaryPhaseTimer::GetWallTime(), at which the span started
+     * @param endTime the wall time at which the span ended
+     */
+    static void RecordSpan(const char* pName, const char* pCategory, double startTime, double endTime);
+
+    /** @return the number of spans currently held, over all threads */
+    static unsigned GetNumSpans();
+
+    /**
+     * Write the spans held to a file in the Chrome trace event format, with one track per thread.  Spans may continue
+     * to be recorded while this is called; any overwritten while being copied are left out.
+     *
+     * @param directoryName the output directory, relative to the test output directory
+     * @param fileName the output file name, usually ending .json
+     */
+    static void WriteChromeTrace(const std::string& directoryName, const std::string& fileName);
+};
+
+/**
+ * Records a span of ImmersedBoundaryTracer from its construction until its destruction, if tracing is enabled when it
+ * is constructed, so a scope may be traced by declaring one at its start.
+ */
+class ImmersedBoundaryTraceSpan
+{
+private:
+
+    /** The name of the span, or NULL if tracing was not enabled when it started. */
+    const char* mpName;
+
+    /** The category of the span. */
+    const char* mpCategory;
+
+    /** The wall time at which the span started. */
+    double mStartTime;
+
+public:
+
+    /**
+     * Constructor.  Starts the span.
+     *
+     * @param pName the name of the span, which must last as long as the program
+     * @param pCategory the category of the span, which must last as long as the program
+     */
+    ImmersedBoundaryTraceSpan(const char* pName, const char* pCategory);
+
+    /**
+     * Destructor.  Ends and records the span.
+     */
+    ~ImmersedBoundaryTraceSpan();
+};
+
+#endif /*IMMERSEDBOUNDARYTRACER_HPP_*/
@@ -0,0 +1,121 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ImmersedBoundaryVorticityReducer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+ImmersedBoundaryVorticityReducer::ImmersedBoundaryVorticityReducer(const std::string& rFileName)
+    : AbstractImmersedBoundaryFluidReducer(rFileName),
+      mMaxVorticity(0.0),
+      mMeanVorticity(0.0),
+      mRmsVorticity(0.0)
+{
+}
+
+void ImmersedBoundaryVorticityReducer::StartStreaming()
+{
+    std::vector<std::string> headers;
+    headers.push_back("step");
+    headers.push_back("time");
+    headers.push_back("max_vorticity");
+    headers.push_back("mean_vorticity");
+    headers.push_back("rms_vorticity");
+    mWriter.AddHeaders(headers);
+
+    mWriter.StartStreaming(1, 4, 0, 100, mBinaryOutput);
+}
+
+void ImmersedBoundaryVorticityReducer::Reduce(unsigned step, double time, const multi_array<double, 3>& rVelocityGrids)
+{
+    assert(rVelocityGrids.shape()[1] == mNumGridPtsX && rVelocityGrids.shape()[2] == mNumGridPtsY);
+
+    // The grid spacing in each direction is the domain size over the number of grid points
+    const double half_recip_dx = 0.5 * mNumGridPtsX / mDomainWidth;
+    const double half_recip_dy = 0.5 * mNumGridPtsY / mDomainHeight;
+
+    double max_abs = 0.0;
+    double sum_abs = 0.0;
+    double sum_sq = 0.0;
+
+    for (unsigned x = 0; x < mNumGridPtsX; x++)
+    {
+        unsigned x_prev = (x + mNumGridPtsX - 1) % mNumGridPtsX;
+        unsigned x_next = (x + 1) % mNumGridPtsX;
+
+        for (unsigned y = 0; y < mNumGridPtsY; y++)
+        {
+            unsigned y_prev = (y + mNumGridPtsY - 1) % mNumGridPtsY;
+            unsigned y_next = (y + 1) % mNumGridPtsY;
+
+            double dv_dx = half_recip_dx * (rVelocityGrids[1][x_next][y] - rVelocityGrids[1][x_prev][y]);
+            double du_dy = half_recip_dy * (rVelocityGrids[0][x][y_next] - rVelocityGrids[0][x][y_prev]);
+            double vorticity = dv_dx - du_dy;
+
+            max_abs = std::max(max_abs, fabs(vorticity));
+            sum_abs += fabs(vorticity);
+            sum_sq += vorticity * vorticity;
+        }
+    }
+
+    const double recip_num_pts = 1.0 / (mNumGridPtsX * mNumGridPtsY);
+    mMaxVorticity = max_abs;
+    mMeanVorticity = sum_abs * recip_num_pts;
+    mRmsVorticity = sqrt(sum_sq * recip_num_pts);
+
+    std::vector<unsigned> unsigned_values(1, step);
+    std::vector<double> double_values(4);
+    double_values[0] = time;
+    double_values[1] = mMaxVorticity;
+    double_values[2] = mMeanVorticity;
+    double_values[3] = mRmsVorticity;
+    mWriter.AppendRow(unsigned_values, double_values);
+}
+
+double ImmersedBoundaryVorticityReducer::GetMaxVorticity() const
+{
+    return mMaxVorticity;
+}
+
+double ImmersedBoundaryVorticityReducer::GetMeanVorticity() const
+{
+    return mMeanVorticity;
+}
+
+double ImmersedBoundaryVorticityReducer::GetRmsVorticity() const
+{
+    return mRmsVorticity;
+}
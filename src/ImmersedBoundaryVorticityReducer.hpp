@@ -0,0 +1,98 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef IMMERSEDBOUNDARYVORTICITYREDUCER_HPP_
+#define IMMERSEDBOUNDARYVORTICITYREDUCER_HPP_
+
+#include "AbstractImmersedBoundaryFluidReducer.hpp"
+
+/**
+ * A fluid reducer streaming summaries of the vorticity dv/dx - du/dy over the periodic domain, computed by
+ * second order central differences.  Each row holds the step, the time, and the maximum, mean and root mean square
+ * of the vorticity magnitude.
+ */
+class ImmersedBoundaryVorticityReducer : public AbstractImmersedBoundaryFluidReducer
+{
+private:
+
+    /** The maximum vorticity magnitude at the last call to Reduce(). */
+    double mMaxVorticity;
+
+    /** The mean vorticity magnitude at the last call to Reduce(). */
+    double mMeanVorticity;
+
+    /** The root mean square vorticity at the last call to Reduce(). */
+    double mRmsVorticity;
+
+    /**
+     * Overridden StartStreaming() method.
+     */
+    void StartStreaming();
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param rFileName the name of the file the results are streamed to (defaults to "vorticity.csv")
+     */
+    ImmersedBoundaryVorticityReducer(const std::string& rFileName="vorticity.csv");
+
+    /**
+     * Overridden Reduce() method.
+     *
+     * @param step the number of timesteps elapsed
+     * @param time the simulation time
+     * @param rVelocityGrids the velocity grids
+     */
+    void Reduce(unsigned step, double time, const multi_array<double, 3>& rVelocityGrids);
+
+    /**
+     * @return #mMaxVorticity
+     */
+    double GetMaxVorticity() const;
+
+    /**
+     * @return #mMeanVorticity
+     */
+    double GetMeanVorticity() const;
+
+    /**
+     * @return #mRmsVorticity
+     */
+    double GetRmsVorticity() const;
+};
+
+#endif /*IMMERSEDBOUNDARYVORTICITYREDUCER_HPP_*/
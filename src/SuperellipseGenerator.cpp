@@ -35,6 +35,83 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "SuperellipseGenerator.hpp"
 
+#include <algorithm>
+
+/** The number of equal parameter intervals that the adaptive pass around a quadrant of a superellipse starts from. */
+static const unsigned NUM_INITIAL_INTERVALS = 16;
+
+/** The number of times a parameter interval may be halved in the adaptive pass around a superellipse. */
+static const unsigned MAX_REFINEMENT_DEPTH = 32;
+
+/**
+ * @return the location on a superellipse of unit width, centred on the origin, at a given parameter value
+ *
+ * @param theta the parameter value, in [0, 2 pi]
+ * @param ellipseExponent the exponent of the superellipse
+ * @param aspectRatio the height of the superellipse
+ */
+static c_vector<double, 2> GetUnitSuperellipseLocation(double theta, double ellipseExponent, double aspectRatio)
+{
+    double temp_cos = cos(theta);
+    double temp_sin = sin(theta);
+
+    // x and y are powers of cos and sin, with the sign of cos and sin
+    c_vector<double, 2> location;
+    location[0] = copysign(pow(fabs(temp_cos), ellipseExponent), temp_cos) * 0.5;
+    location[1] = copysign(pow(fabs(temp_sin), ellipseExponent), temp_sin) * aspectRatio * 0.5;
+
+    // Check that the new point created lies within [-1/2, 1/2] x [-aspectRatio/2, aspectRatio/2]
+    assert(fabs(location[0]) < 0.5 + 1e-10);
+    assert(fabs(location[1]) < aspectRatio * 0.5 + 1e-10);
+
+    return location;
+}
+
+/**
+ * Append the dense locations along a parameter interval of a superellipse, halving the interval until the location
+ * at its midpoint lies within a tolerance of the chord.  The location at the start of the interval is not appended.
+ *
+ * @param thetaA the parameter value at the start of the interval
+ * @param rLocationA the location at the start of the interval
+ * @param thetaB the parameter value at the end of the interval
+ * @param rLocationB the location at the end of the interval
+ * @param depth the number of times the interval has been halved
+ * @param tolerance the largest distance allowed between the midpoint location and the chord
+ * @param ellipseExponent the exponent of the superellipse
+ * @param aspectRatio the height of the superellipse
+ * @param rLocations the dense locations to append to
+ */
+static void RefineSuperellipseInterval(double thetaA,
+                                       const c_vector<double, 2>& rLocationA,
+                                       double thetaB,
+                                       const c_vector<double, 2>& rLocationB,
+                                       unsigned depth,
+                                       double tolerance,
+                                       double ellipseExponent,
+                                       double aspectRatio,
+                                       std::vector<c_vector<double, 2> >& rLocations)
+{
+    double theta_mid = 0.5 * (thetaA + thetaB);
+    c_vector<double, 2> location_mid = GetUnitSuperellipseLocation(theta_mid, ellipseExponent, aspectRatio);
+
+    // The distance of the midpoint location from the chord, or from the start of a chord of zero length
+    c_vector<double, 2> chord = rLocationB - rLocationA;
+    c_vector<double, 2> to_mid = location_mid - rLocationA;
+    double chord_length = norm_2(chord);
+    double distance = chord_length > 0.0 ? fabs(chord[0] * to_mid[1] - chord[1] * to_mid[0]) / chord_length : norm_2(to_mid);
+
+    if (distance > tolerance && depth < MAX_REFINEMENT_DEPTH)
+    {
+        RefineSuperellipseInterval(thetaA, rLocationA, theta_mid, location_mid, depth + 1, tolerance, ellipseExponent, aspectRatio, rLocations);
+        RefineSuperellipseInterval(theta_mid, location_mid, thetaB, rLocationB, depth + 1, tolerance, ellipseExponent, aspectRatio, rLocations);
+    }
+    else
+    {
+        rLocations.push_back(location_mid);
+        rLocations.push_back(rLocationB);
+    }
+}
+
 SuperellipseGenerator::SuperellipseGenerator(unsigned numPoints,
                                              double ellipseExponent,
                                              double width,
@@ -48,75 +125,136 @@ SuperellipseGenerator::SuperellipseGenerator(unsigned numPoints,
     assert(width > 0.0);
     assert(height > 0.0);
 
-    // Set up member variables
-    mPoints.resize(numPoints);
+    // Find the shape with unit width, generating it if it has not been generated before
+    UnitShapeKey key(numPoints, std::make_pair(ellipseExponent, height / width));
+    UnitShape unit_shape;
+
+#ifdef _OPENMP
+    #pragma omp critical(SuperellipseGeneratorCache)
+#endif
+    {
+        std::map<UnitShapeKey, UnitShape>& r_cache = rGetUnitShapeCache();
+        std::map<UnitShapeKey, UnitShape>::iterator it = r_cache.find(key);
+        if (it == r_cache.end())
+        {
+            if (r_cache.size() >= MAX_CACHED_SHAPES)
+            {
+                r_cache.clear();
+            }
+            it = r_cache.insert(std::make_pair(key, UnitShape())).first;
+            GenerateUnitShape(numPoints, ellipseExponent, key.second.second, it->second);
+        }
+        unit_shape = it->second;
+    }
 
     /*
-     * Run a high-density pass around the parametric curve first
+     * Rescale all points to match parameters
      */
-    unsigned dense_pts = 50000;
-
-    // Vectors to store information from the loop
-    std::vector<double> cumulative_arc_length(dense_pts);
-    std::vector<c_vector<double, 2> > dense_locations(dense_pts);
 
-    // Helper variables for the loop
-    double dense_spacing = (2.0 * M_PI) / (double)dense_pts;
-    double cumulative_dist = 0.0;
-    double temp_sin, temp_cos;
+    // Move perimeter from [-width/2, width/2] x [-height/2, height/2] to correct location
+    c_vector<double, 2> offset;
+    offset[0] = width * 0.5 + botLeftX;
+    offset[1] = height * 0.5 + botLeftY;
 
-    // Fill in first location by hand
-    cumulative_arc_length[0] = 0.0;
-    dense_locations[0][0] = width * 0.5;
-    dense_locations[0][1] = 0.0;
+    mTargetNodeSpacing = width * unit_shape.mTargetNodeSpacing;
+    mHeightOfTopSurface = width * unit_shape.mHeightOfTopSurface + offset[1];
 
-    // Fill in all other locations
-    for (unsigned point = 1; point < dense_pts; point++)
+    mPoints.resize(numPoints);
+    for (unsigned point = 0; point < numPoints; point++)
     {
-        // Update cumulative distance
-        cumulative_dist += dense_spacing;
+        // Reposition all points
+        mPoints[point] = width * unit_shape.mPoints[point] + offset;
 
-        // Get the current sin and cos values
-        temp_cos = cos(cumulative_dist);
-        temp_sin = sin(cumulative_dist);
+        // Check we're in the right place
+        assert( (mPoints[point][0] > botLeftX - 1e-10) && (mPoints[point][0] < botLeftX + width + 1e-10) );
+        assert( (mPoints[point][1] > botLeftY - 1e-10) && (mPoints[point][1] < botLeftY + height + 1e-10) );
+    }
+}
 
-        // x and y are powers of cos and sin, with the sign of sin and cos
-        dense_locations[point][0] = copysign(pow(fabs(temp_cos), ellipseExponent), temp_cos) * width * 0.5;
-        dense_locations[point][1] = copysign(pow(fabs(temp_sin), ellipseExponent), temp_sin) * height * 0.5;
+std::map<SuperellipseGenerator::UnitShapeKey, SuperellipseGenerator::UnitShape>& SuperellipseGenerator::rGetUnitShapeCache()
+{
+    static std::map<UnitShapeKey, UnitShape> cache;
+    return cache;
+}
 
-        // Check that the new point created lies within [-width/2, width/2] x [-height/2, height/2]
-        assert(fabs(dense_locations[point][0]) < width * 0.5 + 1e-10);
-        assert(fabs(dense_locations[point][1]) < height * 0.5 + 1e-10);
+void SuperellipseGenerator::GenerateUnitShape(unsigned numPoints, double ellipseExponent, double aspectRatio, UnitShape& rShape)
+{
+    /*
+     * Run an adaptive high-density pass around the first quadrant of the parametric curve first.  The superellipse is
+     * symmetric about both axes, so the other quadrants are reflections of it.
+     */
+    std::vector<c_vector<double, 2> > quadrant_locations;
+    double tolerance = 1e-8 * std::max(1.0, aspectRatio);
+
+    // Fill in the ends of the quadrant by hand
+    c_vector<double, 2> first_location;
+    first_location[0] = 0.5;
+    first_location[1] = 0.0;
+    c_vector<double, 2> last_location;
+    last_location[0] = 0.0;
+    last_location[1] = 0.5 * aspectRatio;
+    quadrant_locations.push_back(first_location);
+
+    double interval = (0.5 * M_PI) / (double)NUM_INITIAL_INTERVALS;
+    c_vector<double, 2> start_location = first_location;
+    for (unsigned i = 0; i < NUM_INITIAL_INTERVALS; i++)
+    {
+        double theta_start = interval * i;
+        double theta_end = interval * (i + 1);
+        c_vector<double, 2> end_location = (i + 1 == NUM_INITIAL_INTERVALS) ? last_location
+                                         : GetUnitSuperellipseLocation(theta_end, ellipseExponent, aspectRatio);
 
-        // Fill in arc length property
-        cumulative_arc_length[point] = cumulative_arc_length[point - 1] + norm_2(dense_locations[point] - dense_locations[point - 1]);
+        RefineSuperellipseInterval(theta_start, start_location, theta_end, end_location, 0, tolerance, ellipseExponent, aspectRatio, quadrant_locations);
+        start_location = end_location;
     }
 
-    double total_arc_length = cumulative_arc_length[dense_pts - 1] + norm_2(dense_locations[dense_pts - 1] - dense_locations[0]);
+    // Reflect the quadrant into the other three, anticlockwise; since our perimeter is periodic, we get back to the start
+    unsigned num_quadrant_pts = quadrant_locations.size() - 1;
+    std::vector<c_vector<double, 2> > dense_locations(4 * num_quadrant_pts + 1);
+    for (unsigned point = 0; point < num_quadrant_pts; point++)
+    {
+        const c_vector<double, 2>& r_forward = quadrant_locations[point];
+        const c_vector<double, 2>& r_backward = quadrant_locations[num_quadrant_pts - point];
+
+        dense_locations[point] = r_forward;
+        dense_locations[num_quadrant_pts + point][0] = -r_backward[0];
+        dense_locations[num_quadrant_pts + point][1] = r_backward[1];
+        dense_locations[2 * num_quadrant_pts + point] = -r_forward;
+        dense_locations[3 * num_quadrant_pts + point][0] = r_backward[0];
+        dense_locations[3 * num_quadrant_pts + point][1] = -r_backward[1];
+    }
+    dense_locations[4 * num_quadrant_pts] = first_location;
 
-    // Since our perimeter is periodic, we get back to the start
-    cumulative_arc_length.push_back(total_arc_length);
-    dense_locations.push_back(dense_locations[0]);
+    unsigned dense_pts = dense_locations.size() - 1;
+    std::vector<double> cumulative_arc_length(dense_pts + 1);
+    cumulative_arc_length[0] = 0.0;
+    for (unsigned point = 1; point <= dense_pts; point++)
+    {
+        cumulative_arc_length[point] = cumulative_arc_length[point - 1] + norm_2(dense_locations[point] - dense_locations[point - 1]);
+    }
+    double total_arc_length = cumulative_arc_length[dense_pts];
 
     /*
      * Decide on the best place to put the actual boundary points
      */
+    std::vector<c_vector<double, 2> >& r_points = rShape.mPoints;
+    r_points.resize(numPoints);
 
     // Helper variables for loop
     unsigned dense_it = 0;
 
-    mTargetNodeSpacing = total_arc_length / double(numPoints);
+    rShape.mTargetNodeSpacing = total_arc_length / double(numPoints);
 
     double target_arclength = 0.0;
     double interpolant;
 
     // Fill in first point by hand
-    mPoints[0] = dense_locations[0];
+    r_points[0] = dense_locations[0];
 
     // Fill in all other locations
     for (unsigned point = 1; point < numPoints; point++)
     {
-        target_arclength = double(point) * mTargetNodeSpacing;
+        target_arclength = double(point) * rShape.mTargetNodeSpacing;
 
         while (cumulative_arc_length[dense_it] < target_arclength && dense_it < dense_pts)
         {
@@ -131,7 +269,7 @@ SuperellipseGenerator::SuperellipseGenerator(unsigned numPoints,
         interpolant = (target_arclength - cumulative_arc_length[dense_it - 1]) / (cumulative_arc_length[dense_it] - cumulative_arc_length[dense_it - 1]);
 
         // Calculate the location of the new point
-        mPoints[point] = (1.0 - interpolant) * dense_locations[dense_it - 1] + interpolant * dense_locations[dense_it];
+        r_points[point] = (1.0 - interpolant) * dense_locations[dense_it - 1] + interpolant * dense_locations[dense_it];
     }
 
     /*
@@ -139,8 +277,8 @@ SuperellipseGenerator::SuperellipseGenerator(unsigned numPoints,
      * from the previous point.  The first difference in which the absolute change in x is greater than the absolute
      * change in y will be the point with maximal curvature.
      */
-    double delta_x = fabs(mPoints[0][0] - mPoints[1][0]);
-    double delta_y = fabs(mPoints[0][1] - mPoints[1][1]);
+    double delta_x = fabs(r_points[0][0] - r_points[1][0]);
+    double delta_y = fabs(r_points[0][1] - r_points[1][1]);
 
     // The following should always hold, for an exponent less than 1.0
     if (delta_x > delta_y)
@@ -150,12 +288,12 @@ SuperellipseGenerator::SuperellipseGenerator(unsigned numPoints,
 
     for (unsigned i = 1; i < numPoints; i++)
     {
-        delta_x = fabs(mPoints[i][0] - mPoints[i-1][0]);
-        delta_y = fabs(mPoints[i][1] - mPoints[i-1][1]);
+        delta_x = fabs(r_points[i][0] - r_points[i-1][0]);
+        delta_y = fabs(r_points[i][1] - r_points[i-1][1]);
 
         if (delta_x > delta_y)
         {
-            mHeightOfTopSurface = 0.5 * (mPoints[i][1] + mPoints[i-1][1]);
+            rShape.mHeightOfTopSurface = 0.5 * (r_points[i][1] + r_points[i-1][1]);
 
             break;
         }
@@ -166,30 +304,23 @@ SuperellipseGenerator::SuperellipseGenerator(unsigned numPoints,
             NEVER_REACHED;
         }
     }
+}
 
-    /*
-     * Rescale all points to match parameters
-     */
-
-    // Move perimeter from [-width/2, width/2] x [-height/2, height/2] to correct location
-    c_vector<double, 2> offset;
-    offset[0] = width * 0.5 + botLeftX;
-    offset[1] = height * 0.5 + botLeftY;
-
-    // Reposition the height of the top surface
-    mHeightOfTopSurface += offset[1];
-
-    for (unsigned point = 0; point < numPoints; point++)
+void SuperellipseGenerator::ClearCache()
+{
+#ifdef _OPENMP
+    #pragma omp critical(SuperellipseGeneratorCache)
+#endif
     {
-        // Reposition all points
-        mPoints[point] += offset;
-
-        // Check we're in the right place
-        assert( (mPoints[point][0] > botLeftX - 1e-10) && (mPoints[point][0] < botLeftX + width + 1e-10) );
-        assert( (mPoints[point][1] > botLeftY - 1e-10) && (mPoints[point][1] < botLeftY + height + 1e-10) );
+        rGetUnitShapeCache().clear();
     }
 }
 
+unsigned SuperellipseGenerator::GetNumCachedShapes()
+{
+    return rGetUnitShapeCache().size();
+}
+
 SuperellipseGenerator::~SuperellipseGenerator()
 {
     mPoints.clear();
@@ -37,6 +37,7 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define SUPERELLIPSEGENERATOR_HPP_
 
 #include <cmath>
+#include <map>
 #include <vector>
 
 #include "ChastePoint.hpp"
@@ -47,6 +48,11 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  * Class to generate roughly equally spaced points around a 2D superellipse.
  * This shape is described by the equation (x/a)^n + (y/b)^n = 1, where n, a
  * and b are positive numbers.
+ *
+ * The points depend on the width and height only through their ratio, up to scaling, so the points around a
+ * superellipse of unit width are generated once for each number of points, exponent and aspect ratio and cached.
+ * Later superellipses with the same shape are then just scaled and translated copies, so the many identical cells of
+ * a generated mesh cost no more to place than one.
  */
 class SuperellipseGenerator
 {
@@ -64,6 +70,44 @@ private:
     /** Vector to store the points. */
     std::vector<c_vector<double, 2> > mPoints;
 
+    /** The points, node spacing and top surface height of a superellipse of unit width, centred on the origin. */
+    struct UnitShape
+    {
+        /** The points around the superellipse. */
+        std::vector<c_vector<double, 2> > mPoints;
+
+        /** The target spacing between points. */
+        double mTargetNodeSpacing;
+
+        /** The height of the point of maximal curvature in the top right-hand corner. */
+        double mHeightOfTopSurface;
+    };
+
+    /** The key identifying a unit shape: the number of points, the exponent and the aspect ratio. */
+    typedef std::pair<unsigned, std::pair<double, double> > UnitShapeKey;
+
+    /** The maximum number of unit shapes cached, beyond which the cache is emptied before adding another. */
+    static const unsigned MAX_CACHED_SHAPES = 64;
+
+    /**
+     * @return the cache of unit shapes
+     */
+    static std::map<UnitShapeKey, UnitShape>& rGetUnitShapeCache();
+
+    /**
+     * Generate the points around a superellipse of unit width, centred on the origin.
+     *
+     * The points are placed at equal arc lengths along a dense piecewise linear approximation of the curve.  The
+     * approximation is refined adaptively, halving each parameter interval until its midpoint lies within a small
+     * tolerance of the chord, so it is dense only where the curve bends sharply.
+     *
+     * @param numPoints the number of points
+     * @param ellipseExponent the exponent of the superellipse
+     * @param aspectRatio the height of the superellipse
+     * @param rShape the shape to fill
+     */
+    static void GenerateUnitShape(unsigned numPoints, double ellipseExponent, double aspectRatio, UnitShape& rShape);
+
 public:
 
     /**
@@ -111,6 +155,16 @@ public:
      * @return #mPoints as a vector of ChastePoint objects
      */
     const std::vector<ChastePoint<2> > GetPointsAsChastePoints() const;
+
+    /**
+     * Empty the cache of superellipses of unit width.
+     */
+    static void ClearCache();
+
+    /**
+     * @return the number of superellipses of unit width in the cache
+     */
+    static unsigned GetNumCachedShapes();
 };
 
 #endif /*SUPERELLIPSEGENERATOR_HPP_*/
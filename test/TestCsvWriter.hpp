@@ -121,6 +121,133 @@ public:
                 "projects/ImmersedBoundary/test/data/TestCsvWriter/file.csv").CompareFiles();
     }
 
+    void TestStreaming() throw(Exception)
+    {
+        CsvWriter writer;
+        writer.SetDirectoryName("TestCsvWriter");
+        writer.SetFileName("streamed.csv");
+
+        std::vector<std::string> headers;
+        headers.push_back("Step");
+        headers.push_back("Value");
+        headers.push_back("Label");
+        writer.AddHeaders(headers);
+
+        // Rows are written every two rows, so the header and the first two rows are in the file before it is closed
+        writer.StartStreaming(1, 1, 1, 2);
+        TS_ASSERT(writer.IsStreaming());
+
+        std::vector<unsigned> unsigned_row(1);
+        std::vector<double> double_row(1);
+        std::vector<std::string> string_row(1);
+        for (unsigned row = 0; row < 3; row++)
+        {
+            unsigned_row[0] = 10 * row;
+            double_row[0] = -1.25 + row;
+            string_row[0] = (row % 2 == 0) ? "even" : "odd";
+            writer.AppendRow(unsigned_row, double_row, string_row);
+        }
+        TS_ASSERT_EQUALS(writer.GetNumRowsStreamed(), 3u);
+
+        OutputFileHandler output_file_handler("TestCsvWriter", false);
+        std::string results_directory = output_file_handler.GetOutputDirectoryFullPath();
+        {
+            std::ifstream file((results_directory + "streamed.csv").c_str());
+            std::string line;
+            unsigned num_lines = 0;
+            while (std::getline(file, line))
+            {
+                num_lines++;
+            }
+            TS_ASSERT_EQUALS(num_lines, 3u);
+        }
+
+        // Streamed numbers are formatted as the columns written by WriteDataToFile()
+        writer.StopStreaming();
+        TS_ASSERT(!writer.IsStreaming());
+        {
+            std::ifstream file((results_directory + "streamed.csv").c_str());
+            std::string line;
+            std::getline(file, line);
+            TS_ASSERT_EQUALS(line, "Step,Value,Label");
+            std::getline(file, line);
+            TS_ASSERT_EQUALS(line, "0,-1.250000e+00,even");
+            std::getline(file, line);
+            TS_ASSERT_EQUALS(line, "10,-2.500000e-01,odd");
+            std::getline(file, line);
+            TS_ASSERT_EQUALS(line, "20,7.500000e-01,even");
+        }
+
+        // Rows streamed to a binary file are stored column by column in blocks
+        std::vector<std::string> binary_headers(headers.begin(), headers.begin() + 2);
+        writer.AddHeaders(binary_headers);
+        writer.StartStreaming(1, 1, 0, 2, true);
+        std::vector<std::string> no_strings;
+        for (unsigned row = 0; row < 3; row++)
+        {
+            unsigned_row[0] = 10 * row;
+            double_row[0] = -1.25 + row;
+            writer.AppendRow(unsigned_row, double_row, no_strings);
+        }
+        writer.StopStreaming();
+
+        std::ifstream file((results_directory + "streamed.csvb").c_str(), std::ios::binary);
+        unsigned header[6];
+        file.read(reinterpret_cast<char*>(header), sizeof(header));
+        TS_ASSERT_EQUALS(header[0], CsvWriterBinaryFormat::MAGIC);
+        TS_ASSERT_EQUALS(header[1], CsvWriterBinaryFormat::VERSION);
+        TS_ASSERT_EQUALS(header[2], CsvWriterBinaryFormat::BYTE_ORDER_MARK);
+        TS_ASSERT_EQUALS(header[3], 1u);
+        TS_ASSERT_EQUALS(header[4], 1u);
+        TS_ASSERT_EQUALS(header[5], 2u);
+
+        for (unsigned header_idx = 0; header_idx < 2; header_idx++)
+        {
+            unsigned length;
+            file.read(reinterpret_cast<char*>(&length), sizeof(length));
+            std::string name(length, ' ');
+            file.read(&name[0], length);
+            TS_ASSERT_EQUALS(name, binary_headers[header_idx]);
+        }
+
+        unsigned block_sizes[2] = {2, 1};
+        unsigned first_row = 0;
+        for (unsigned block = 0; block < 2; block++)
+        {
+            unsigned num_rows;
+            file.read(reinterpret_cast<char*>(&num_rows), sizeof(num_rows));
+            TS_ASSERT_EQUALS(num_rows, block_sizes[block]);
+
+            std::vector<unsigned> unsigned_column(num_rows);
+            std::vector<double> double_column(num_rows);
+            file.read(reinterpret_cast<char*>(&unsigned_column[0]), num_rows * sizeof(unsigned));
+            file.read(reinterpret_cast<char*>(&double_column[0]), num_rows * sizeof(double));
+            for (unsigned row = 0; row < num_rows; row++)
+            {
+                TS_ASSERT_EQUALS(unsigned_column[row], 10 * (first_row + row));
+                TS_ASSERT_DELTA(double_column[row], -1.25 + first_row + row, 1e-12);
+            }
+            first_row += num_rows;
+        }
+        TS_ASSERT(file.good());
+        file.peek();
+        TS_ASSERT(file.eof());
+
+        // Streaming is checked for consistency
+        TS_ASSERT_THROWS_THIS(writer.AppendRow(unsigned_row, double_row, no_strings),
+                "Rows are not being streamed to file");
+        TS_ASSERT_THROWS_THIS(writer.StartStreaming(1, 1, 1, 2, true),
+                "String columns cannot be streamed to a binary file");
+        TS_ASSERT_THROWS_THIS(writer.StartStreaming(1, 2),
+                "Expecting to write a header row, but header length does not match number of data rows");
+
+        writer.StartStreaming(1, 1);
+        TS_ASSERT_THROWS_THIS(writer.AppendRow(unsigned_row, std::vector<double>()),
+                "Streamed rows must have the number of columns given when streaming was started");
+        TS_ASSERT_THROWS_THIS(writer.StartStreaming(1, 1),
+                "Rows are already being streamed to file");
+    }
+
     void TestExceptions() throw(Exception)
     {
         CsvWriter writer;
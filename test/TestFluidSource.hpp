@@ -39,6 +39,7 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 // Includes from projects/ImmersedBoundary
 #include "FluidSource.hpp"
+#include "ImmersedBoundaryFluidSourceRegistry.hpp"
 
 // This test is never run in parallel
 #include "FakePetscSetup.hpp"
@@ -132,4 +133,54 @@ public:
         TS_ASSERT_EQUALS(source.IsSourceAssociatedWithElement(), true);
         TS_ASSERT_EQUALS(source.GetAssociatedElementIndex(), 15u);
     }
+
+    void TestFluidSourceRegistry() throw(Exception)
+    {
+        FluidSource<2> element_source_0(0, 0.1, 0.2);
+        FluidSource<2> element_source_1(1, 0.3, 0.4);
+        FluidSource<2> balancing_source_0(0, 0.5, 0.0);
+        FluidSource<2> balancing_source_1(1, 0.6, 0.0);
+
+        element_source_0.SetStrength(1.0);
+
+        std::vector<FluidSource<2>*> element_sources;
+        element_sources.push_back(&element_source_0);
+        element_sources.push_back(&element_source_1);
+
+        std::vector<FluidSource<2>*> balancing_sources;
+        balancing_sources.push_back(&balancing_source_0);
+        balancing_sources.push_back(&balancing_source_1);
+
+        {
+            ImmersedBoundaryFluidSourceRegistry<2> registry;
+            registry.Reset(element_sources, balancing_sources);
+
+            // Element sources come first, followed by balancing sources
+            TS_ASSERT_EQUALS(registry.GetNumSources(), 4u);
+            TS_ASSERT_EQUALS(registry.GetNumElementSources(), 2u);
+            TS_ASSERT_EQUALS(registry.GetSource(1), &element_source_1);
+            TS_ASSERT_EQUALS(registry.GetSource(2), &balancing_source_0);
+            TS_ASSERT_DELTA(registry.GetLocation(1)[0], 0.3, 1e-12);
+            TS_ASSERT_DELTA(registry.GetLocation(1)[1], 0.4, 1e-12);
+            TS_ASSERT_DELTA(registry.GetStrength(0), 1.0, 1e-12);
+
+            // Setting the strength of a source updates the total element strength incrementally
+            TS_ASSERT_DELTA(registry.GetTotalElementStrength(), 1.0, 1e-12);
+            element_source_1.SetStrength(3.0);
+            element_source_0.SetStrength(-0.5);
+            TS_ASSERT_DELTA(registry.GetStrength(1), 3.0, 1e-12);
+            TS_ASSERT_DELTA(registry.GetTotalElementStrength(), 2.5, 1e-12);
+
+            // The balancing sources share the strength which balances the element sources
+            TS_ASSERT_DELTA(registry.GetBalancingStrength(), -1.25, 1e-12);
+            registry.ApplyBalancingStrength();
+            TS_ASSERT_DELTA(balancing_source_1.GetStrength(), -1.25, 1e-12);
+            TS_ASSERT_DELTA(registry.GetStrength(3), -1.25, 1e-12);
+            TS_ASSERT_DELTA(registry.GetTotalElementStrength(), 2.5, 1e-12);
+        }
+
+        // Sources outliving the registry are detached from it
+        element_source_0.SetStrength(7.0);
+        TS_ASSERT_DELTA(element_source_0.GetStrength(), 7.0, 1e-12);
+    }
 };
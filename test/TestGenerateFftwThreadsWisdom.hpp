@@ -69,7 +69,7 @@ public:
         int thread_flag = fftw_init_threads();
         TS_ASSERT_EQUALS(thread_flag, 1);
 
-        std::string multi_thread_file_name  = "fftw_threads.wisdom";
+        std::string multi_thread_file_name  = "fftw_threads_2.wisdom";
 
         // Set up the file finder and get the absolute path
         FileFinder file_finder(multi_thread_file_name, RelativeTo::ChasteTestOutput);
@@ -81,7 +81,7 @@ public:
         // If it doesn't exists, create it with blank wisdom file
         if (!wisdom_exists)
         {
-            void fftw_forget_wisdom();
+            fftw_forget_wisdom();
             fftw_export_wisdom_to_filename(mWisdomThreadsFilename.c_str());
         }
 
@@ -106,7 +106,7 @@ public:
         fftw_plan_with_nthreads(2);
 
         // We first forget all wisdom and re-load, as threaded wisdom doesn't play well with un-threaded
-        void fftw_forget_wisdom();
+        fftw_forget_wisdom();
         int wisdom_flag = fftw_import_wisdom_from_filename(mWisdomThreadsFilename.c_str());
 
         // 1 means it's read correctly, 0 indicates a failure
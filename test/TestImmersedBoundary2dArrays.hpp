@@ -110,6 +110,43 @@ public:
             }
         }
 
+        // Test the pre-computed reciprocal operators and imaginary sine tables used by the spectral solver
+        TS_ASSERT_EQUALS(arrays.rGetReciprocalOperator1().shape()[0], 256u);
+        TS_ASSERT_EQUALS(arrays.rGetReciprocalOperator1().shape()[1], 129u);
+        TS_ASSERT_EQUALS(arrays.rGetNormalisedReciprocalOperator2().shape()[0], 256u);
+        TS_ASSERT_EQUALS(arrays.rGetNormalisedReciprocalOperator2().shape()[1], 129u);
+        TS_ASSERT_EQUALS(arrays.rGetImagSin2xOverSpacing().size(), 256u);
+        TS_ASSERT_EQUALS(arrays.rGetImagSin2yOverSpacing().size(), 129u);
+
+        for (unsigned i=0; i<256; i++)
+        {
+            TS_ASSERT_DELTA(arrays.rGetImagSin2xOverSpacing()[i].real(), 0.0, 1e-12);
+            TS_ASSERT_DELTA(arrays.rGetImagSin2xOverSpacing()[i].imag(), 256.0 * sin_2x[i], 1e-4);
+        }
+        for (unsigned j=0; j<129; j++)
+        {
+            TS_ASSERT_DELTA(arrays.rGetImagSin2yOverSpacing()[j].real(), 0.0, 1e-12);
+            TS_ASSERT_DELTA(arrays.rGetImagSin2yOverSpacing()[j].imag(), 256.0 * sin_2x[j], 1e-4);
+        }
+
+        for (unsigned i=0; i<256; i++)
+        {
+            for (unsigned j=0; j<129; j++)
+            {
+                TS_ASSERT_DELTA(arrays.rGetNormalisedReciprocalOperator2()[i][j] * arrays.rGetOperator2()[i][j] * 65536.0, 1.0, 1e-10);
+
+                bool is_pressure_zeroed = (i == 0 || i == 128) && (j == 0 || j == 128);
+                if (is_pressure_zeroed)
+                {
+                    TS_ASSERT_DELTA(arrays.rGetReciprocalOperator1()[i][j], 0.0, 1e-12);
+                }
+                else
+                {
+                    TS_ASSERT_DELTA(arrays.rGetReciprocalOperator1()[i][j] * arrays.rGetOperator1()[i][j], 1.0, 1e-10);
+                }
+            }
+        }
+
         // Test that these methods can be used to modify the respective members
         arrays.rGetModifiableForceGrids().resize(extents[23][1][1]);
         TS_ASSERT_EQUALS(arrays.rGetModifiableForceGrids().shape()[0], 23u);
@@ -126,8 +163,283 @@ public:
         TS_ASSERT_EQUALS(arrays.rGetModifiableFourierGrids().shape()[1], 2u);
         TS_ASSERT_EQUALS(arrays.rGetModifiableFourierGrids().shape()[2], 1u);
 
-        arrays.rGetModifiablePressureGrid().resize(extents[7][4]);
-        TS_ASSERT_EQUALS(arrays.rGetModifiablePressureGrid().shape()[0], 7u);
-        TS_ASSERT_EQUALS(arrays.rGetModifiablePressureGrid().shape()[1], 4u);
+        // The pressure grid may share storage, so is modified in place rather than resized
+        arrays.rGetModifiablePressureGrid()[7][4] = std::complex<double>(1.5, -2.5);
+        TS_ASSERT_DELTA(arrays.rGetModifiablePressureGrid()[7][4].real(), 1.5, 1e-12);
+        TS_ASSERT_DELTA(arrays.rGetModifiablePressureGrid()[7][4].imag(), -2.5, 1e-12);
+    }
+
+    void TestLowMemoryLayout() throw(Exception)
+    {
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+
+        ImmersedBoundary2dArrays<2> arrays(p_mesh, 0.123, 0.246, true);
+        ImmersedBoundary2dArrays<2> low_memory_arrays(p_mesh, 0.123, 0.246, true, true);
+        TS_ASSERT_EQUALS(arrays.IsLowMemory(), false);
+        TS_ASSERT_EQUALS(low_memory_arrays.IsLowMemory(), true);
+
+        // In the low-memory layout, the pressure grid shares the storage of the right-hand-side grids
+        TS_ASSERT_EQUALS(reinterpret_cast<double*>(low_memory_arrays.rGetModifiablePressureGrid().data()),
+                         low_memory_arrays.rGetModifiableRightHandSideGrids().data());
+        TS_ASSERT_DIFFERS(reinterpret_cast<double*>(arrays.rGetModifiablePressureGrid().data()),
+                          arrays.rGetModifiableRightHandSideGrids().data());
+
+        // The shared grid has the same shape as in the default layout
+        for (unsigned dim = 0; dim < 2; dim++)
+        {
+            TS_ASSERT_EQUALS(low_memory_arrays.rGetModifiablePressureGrid().shape()[dim],
+                             arrays.rGetModifiablePressureGrid().shape()[dim]);
+        }
+
+        // In double precision the inverse DFT outputs to the velocity grids, so there are no output grids
+        TS_ASSERT_EQUALS(arrays.rGetModifiableOutputGrids().num_elements(), 0u);
+        TS_ASSERT_EQUALS(low_memory_arrays.rGetModifiableOutputGrids().num_elements(), 0u);
+
+        // Grids not needed by the solver are not allocated, but the operators it uses are unchanged
+        TS_ASSERT_EQUALS(low_memory_arrays.rGetModifiableSourceGradientGrids().num_elements(), 0u);
+        TS_ASSERT_EQUALS(low_memory_arrays.rGetOperator1().num_elements(), 0u);
+
+        for (unsigned i=0; i<256; i++)
+        {
+            for (unsigned j=0; j<129; j++)
+            {
+                TS_ASSERT_DELTA(low_memory_arrays.rGetReciprocalOperator1()[i][j], arrays.rGetReciprocalOperator1()[i][j], 1e-15);
+            }
+        }
+
+        // The memory report lists every grid, in the same order for each layout
+        std::vector<std::pair<std::string, std::size_t> > report = arrays.GetMemoryReport();
+        std::vector<std::pair<std::string, std::size_t> > low_memory_report = low_memory_arrays.GetMemoryReport();
+        TS_ASSERT_EQUALS(report.size(), 13u);
+        TS_ASSERT_EQUALS(low_memory_report.size(), 13u);
+
+        std::size_t total = 0;
+        std::size_t grid_size = 256 * 256;
+        std::size_t reduced_size = 256 * 129;
+        for (unsigned grid = 0; grid < report.size(); grid++)
+        {
+            TS_ASSERT_EQUALS(report[grid].first, low_memory_report[grid].first);
+            total += report[grid].second;
+
+            if (report[grid].first == "VelocityGrids")
+            {
+                TS_ASSERT_EQUALS(report[grid].second, 2 * grid_size * sizeof(double));
+            }
+            else if (report[grid].first == "RightHandSideGrids")
+            {
+                TS_ASSERT_EQUALS(report[grid].second, 3 * grid_size * sizeof(double));
+                TS_ASSERT_EQUALS(low_memory_report[grid].second, 3 * grid_size * sizeof(double));
+            }
+            else if (report[grid].first == "PressureGrid")
+            {
+                TS_ASSERT_EQUALS(report[grid].second, reduced_size * sizeof(std::complex<double>));
+                TS_ASSERT_EQUALS(low_memory_report[grid].second, 0u);
+            }
+            else if (report[grid].first == "OutputGrids")
+            {
+                TS_ASSERT_EQUALS(report[grid].second, 0u);
+                TS_ASSERT_EQUALS(low_memory_report[grid].second, 0u);
+            }
+        }
+        TS_ASSERT_EQUALS(arrays.GetNumBytes(), total);
+
+        // The saving is the pressure, source gradient and first operator grids
+        std::size_t saving = reduced_size * sizeof(std::complex<double>) + 2 * grid_size * sizeof(double)
+                             + reduced_size * sizeof(double);
+        TS_ASSERT_EQUALS(arrays.GetNumBytes() - low_memory_arrays.GetNumBytes(), saving);
+
+        // In single precision the output grids share the storage of the right-hand-side grids instead
+        ImmersedBoundary2dArrays<2, float> single_arrays(p_mesh, 0.123, 0.246, true);
+        ImmersedBoundary2dArrays<2, float> low_memory_single_arrays(p_mesh, 0.123, 0.246, true, true);
+
+        TS_ASSERT_EQUALS(low_memory_single_arrays.rGetModifiableOutputGrids().data(),
+                         low_memory_single_arrays.rGetModifiableRightHandSideGrids().data());
+        TS_ASSERT_DIFFERS(single_arrays.rGetModifiableOutputGrids().data(),
+                          single_arrays.rGetModifiableRightHandSideGrids().data());
+        TS_ASSERT_DIFFERS(reinterpret_cast<float*>(low_memory_single_arrays.rGetModifiablePressureGrid().data()),
+                          low_memory_single_arrays.rGetModifiableRightHandSideGrids().data());
+        for (unsigned dim = 0; dim < 3; dim++)
+        {
+            TS_ASSERT_EQUALS(low_memory_single_arrays.rGetModifiableOutputGrids().shape()[dim],
+                             single_arrays.rGetModifiableOutputGrids().shape()[dim]);
+        }
+
+        // The saving is the output, source gradient and first operator grids
+        std::size_t single_saving = 2 * grid_size * sizeof(float) + 2 * grid_size * sizeof(double)
+                                    + reduced_size * sizeof(float);
+        TS_ASSERT_EQUALS(single_arrays.GetNumBytes() - low_memory_single_arrays.GetNumBytes(), single_saving);
+    }
+
+    void TestSinglePrecisionGrids() throw(Exception)
+    {
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+
+        ImmersedBoundary2dArrays<2> double_arrays(p_mesh, 0.123, 0.246, false);
+        ImmersedBoundary2dArrays<2, float> arrays(p_mesh, 0.123, 0.246, false);
+
+        // Without sources there are two right-hand-side grids, which are transformed directly
+        TS_ASSERT_EQUALS(arrays.rGetModifiableRightHandSideGrids().shape()[0], 2u);
+        TS_ASSERT_EQUALS(arrays.rGetModifiableRightHandSideGrids().shape()[1], 256u);
+        TS_ASSERT_EQUALS(arrays.rGetModifiableRightHandSideGrids().shape()[2], 256u);
+
+        TS_ASSERT_EQUALS(arrays.rGetModifiableFourierGrids().shape()[0], 2u);
+        TS_ASSERT_EQUALS(arrays.rGetModifiableFourierGrids().shape()[1], 256u);
+        TS_ASSERT_EQUALS(arrays.rGetModifiableFourierGrids().shape()[2], 129u);
+
+        TS_ASSERT_EQUALS(arrays.rGetModifiableOutputGrids().shape()[0], 2u);
+        TS_ASSERT_EQUALS(arrays.rGetModifiableOutputGrids().shape()[1], 256u);
+        TS_ASSERT_EQUALS(arrays.rGetModifiableOutputGrids().shape()[2], 256u);
+
+        TS_ASSERT_EQUALS(arrays.rGetImagSin2xOverSpacing().size(), 256u);
+        TS_ASSERT_EQUALS(arrays.rGetImagSin2yOverSpacing().size(), 129u);
+
+        // The force grids, which forces are spread to in double precision, are the same in either precision
+        TS_ASSERT_EQUALS(arrays.rGetModifiableForceGrids().num_elements(),
+                         double_arrays.rGetModifiableForceGrids().num_elements());
+
+        // Every grid that undergoes a DFT is half the size of the double precision one
+        std::vector<std::pair<std::string, std::size_t> > report = arrays.GetMemoryReport();
+        std::vector<std::pair<std::string, std::size_t> > double_report = double_arrays.GetMemoryReport();
+        TS_ASSERT_EQUALS(report.size(), double_report.size());
+        for (unsigned grid = 0; grid < report.size(); grid++)
+        {
+            if (report[grid].first == "RightHandSideGrids" || report[grid].first == "FourierGrids"
+                || report[grid].first == "PressureGrid")
+            {
+                TS_ASSERT_EQUALS(2 * report[grid].second, double_report[grid].second);
+            }
+        }
+
+        // The single precision constants should agree with the double precision ones to single precision accuracy
+        for (unsigned i=0; i<256; i++)
+        {
+            TS_ASSERT_DELTA(arrays.rGetImagSin2xOverSpacing()[i].imag(),
+                            double_arrays.rGetImagSin2xOverSpacing()[i].imag(), 1e-4);
+
+            for (unsigned j=0; j<129; j++)
+            {
+                double op_2 = double_arrays.rGetOperator2()[i][j];
+                TS_ASSERT_DELTA(arrays.rGetOperator2()[i][j] / op_2, 1.0, 1e-6);
+                TS_ASSERT_DELTA(arrays.rGetNormalisedReciprocalOperator2()[i][j] * op_2 * 65536.0, 1.0, 1e-6);
+                TS_ASSERT_DELTA(arrays.rGetReciprocalOperator1()[i][j] * double_arrays.rGetOperator1()[i][j],
+                                double_arrays.rGetReciprocalOperator1()[i][j] * double_arrays.rGetOperator1()[i][j], 1e-6);
+            }
+        }
+    }
+
+    void TestUpdateTimeStep() throw(Exception)
+    {
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+
+        ImmersedBoundary2dArrays<2> arrays(p_mesh, 0.123, 0.246, false);
+        ImmersedBoundary2dArrays<2, float> single_arrays(p_mesh, 0.123, 0.246, false);
+        TS_ASSERT_DELTA(arrays.GetTimeStep(), 0.123, 1e-12);
+
+        // Changing the timestep should give the same operators as constructing afresh with that timestep
+        arrays.UpdateTimeStep(0.05);
+        single_arrays.UpdateTimeStep(0.05);
+        TS_ASSERT_DELTA(arrays.GetTimeStep(), 0.05, 1e-12);
+        TS_ASSERT_DELTA(single_arrays.GetTimeStep(), 0.05, 1e-12);
+
+        ImmersedBoundary2dArrays<2> fresh_arrays(p_mesh, 0.05, 0.246, false);
+
+        for (unsigned i=0; i<256; i++)
+        {
+            for (unsigned j=0; j<129; j++)
+            {
+                TS_ASSERT_DELTA(arrays.rGetOperator1()[i][j], fresh_arrays.rGetOperator1()[i][j], 1e-8);
+                TS_ASSERT_DELTA(arrays.rGetOperator2()[i][j], fresh_arrays.rGetOperator2()[i][j], 1e-8);
+                TS_ASSERT_DELTA(arrays.rGetReciprocalOperator1()[i][j], fresh_arrays.rGetReciprocalOperator1()[i][j], 1e-12);
+                TS_ASSERT_DELTA(arrays.rGetNormalisedReciprocalOperator2()[i][j],
+                                fresh_arrays.rGetNormalisedReciprocalOperator2()[i][j], 1e-12);
+                TS_ASSERT_DELTA(single_arrays.rGetOperator2()[i][j], fresh_arrays.rGetOperator2()[i][j], 1e-3);
+            }
+        }
+    }
+
+    void TestGridsWithWalls() throw(Exception)
+    {
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        p_mesh->SetWalls(false, true);
+
+        // Single precision and the low-memory layout are not supported between walls
+        TS_ASSERT_THROWS_THIS((ImmersedBoundary2dArrays<2, float>(p_mesh, 0.123, 0.246, false)),
+                              "A domain bounded by walls is only supported in double precision with the default grid layout");
+
+        // The right-hand-side grids hold the pressure, even without sources, and no Fourier grids are allocated
+        ImmersedBoundary2dArrays<2> arrays(p_mesh, 0.123, 0.246, false);
+        TS_ASSERT_EQUALS(arrays.HasWalls(), true);
+        TS_ASSERT_EQUALS(arrays.rGetModifiableRightHandSideGrids().shape()[0], 3u);
+        TS_ASSERT_EQUALS(arrays.rGetModifiableFourierGrids().num_elements(), 0u);
+        TS_ASSERT_EQUALS(arrays.rGetRealOperator2().shape()[0], 256u);
+        TS_ASSERT_EQUALS(arrays.rGetRealOperator2().shape()[1], 256u);
+
+        // Between the walls, cosine mode k and sine index k - 1 are paired by the central differences
+        TS_ASSERT_EQUALS(arrays.rGetDivergenceIndices(1)[5], 4u);
+        TS_ASSERT_EQUALS(arrays.rGetGradientIndices(1)[4], 5u);
+        TS_ASSERT_DELTA(arrays.rGetDivergenceFactors(1)[5], 256.0 * sin(5.0 * M_PI / 256.0), 1e-9);
+        TS_ASSERT_DELTA(arrays.rGetGradientFactors(1)[4], -256.0 * sin(5.0 * M_PI / 256.0), 1e-9);
+        TS_ASSERT_DELTA(arrays.rGetDivergenceFactors(1)[0], 0.0, 1e-15);
+        TS_ASSERT_DELTA(arrays.rGetGradientFactors(1)[255], 0.0, 1e-15);
+
+        // In the periodic direction, the real and imaginary parts of each wavenumber are paired
+        TS_ASSERT_EQUALS(arrays.rGetGradientIndices(0)[3], 253u);
+        TS_ASSERT_EQUALS(arrays.rGetGradientIndices(0)[253], 3u);
+        TS_ASSERT_DELTA(arrays.rGetGradientFactors(0)[3], -256.0 * sin(6.0 * M_PI / 256.0), 1e-9);
+        TS_ASSERT_DELTA(arrays.rGetGradientFactors(0)[253], 256.0 * sin(6.0 * M_PI / 256.0), 1e-9);
+        TS_ASSERT_DELTA(arrays.rGetGradientFactors(0)[128], 0.0, 1e-15);
+
+        // The first operator is minus the composition of the central differences, and vanishes where the pressure is fixed
+        double dt_over_re = 0.123 / 0.246;
+        double expected = dt_over_re * 256.0 * 256.0 * (pow(sin(6.0 * M_PI / 256.0), 2) + pow(sin(5.0 * M_PI / 256.0), 2));
+        TS_ASSERT_DELTA(arrays.rGetRealReciprocalOperator1()[3][5] * expected, 1.0, 1e-12);
+        TS_ASSERT_DELTA(arrays.rGetRealReciprocalOperator1()[0][0], 0.0, 1e-15);
+        TS_ASSERT_DELTA(arrays.rGetRealReciprocalOperator1()[128][0], 0.0, 1e-15);
+        TS_ASSERT_LESS_THAN(0.0, arrays.rGetRealReciprocalOperator1()[0][1]);
+
+        // The second operator uses the Laplacian eigenvalue of the sine or cosine mode of each velocity component
+        double lap_x = 4.0 * 256.0 * 256.0 * pow(sin(3.0 * M_PI / 256.0), 2);
+        double lap_y_even = 4.0 * 256.0 * 256.0 * pow(sin(2.5 * M_PI / 256.0), 2);
+        double lap_y_odd = 4.0 * 256.0 * 256.0 * pow(sin(3.0 * M_PI / 256.0), 2);
+        double fft_norm = 256.0 * 512.0;
+        TS_ASSERT_DELTA(arrays.rGetRealOperator2()[3][5], 1.0 + dt_over_re * (lap_x + lap_y_even), 1e-8);
+        TS_ASSERT_DELTA(arrays.rGetRealNormalisedReciprocalOperator2()[0][3][5] * fft_norm
+                        * (1.0 + dt_over_re * (lap_x + lap_y_even)), 1.0, 1e-12);
+        TS_ASSERT_DELTA(arrays.rGetRealNormalisedReciprocalOperator2()[1][3][5] * fft_norm
+                        * (1.0 + dt_over_re * (lap_x + lap_y_odd)), 1.0, 1e-12);
+    }
+
+    void TestGridsAreAligned() throw(Exception)
+    {
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+
+        // The grids are first touched by four threads, with each component split between them
+        ImmersedBoundary2dArrays<2> arrays(p_mesh, 0.123, 0.246, true, false, 4);
+
+        const std::size_t alignment = ImmersedBoundaryAlignedAllocator<double>::ALIGNMENT;
+        TS_ASSERT_EQUALS((std::size_t) arrays.rGetModifiableForceGrids().data() % alignment, 0u);
+        TS_ASSERT_EQUALS((std::size_t) arrays.rGetModifiableRightHandSideGrids().data() % alignment, 0u);
+        TS_ASSERT_EQUALS((std::size_t) arrays.rGetModifiableFourierGrids().data() % alignment, 0u);
+        TS_ASSERT_EQUALS((std::size_t) arrays.rGetModifiablePressureGrid().data() % alignment, 0u);
+        TS_ASSERT_EQUALS((std::size_t) p_mesh->rGetModifiable2dVelocityGrids().data() % alignment, 0u);
+
+        // The grids are zeroed, and resizing keeps both the alignment and the contents
+        multi_array<double, 3>& r_force_grids = arrays.rGetModifiableForceGrids();
+        TS_ASSERT_DELTA(r_force_grids[1][255][255], 0.0, 1e-15);
+        r_force_grids[1][10][20] = 1.5;
+        r_force_grids.resize(extents[2][256][300]);
+        TS_ASSERT_EQUALS((std::size_t) r_force_grids.data() % alignment, 0u);
+        TS_ASSERT_DELTA(r_force_grids[1][10][20], 1.5, 1e-15);
+        TS_ASSERT_DELTA(r_force_grids[1][255][299], 0.0, 1e-15);
+
+        // Copies are aligned too
+        multi_array<double, 3> copied_grids = r_force_grids;
+        TS_ASSERT_EQUALS((std::size_t) copied_grids.data() % alignment, 0u);
+        TS_ASSERT_DELTA(copied_grids[1][10][20], 1.5, 1e-15);
     }
 };
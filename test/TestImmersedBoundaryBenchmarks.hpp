@@ -0,0 +1,402 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TESTIMMERSEDBOUNDARYBENCHMARKS_HPP_
+#define TESTIMMERSEDBOUNDARYBENCHMARKS_HPP_
+
+// Needed for test framework
+#include <cxxtest/TestSuite.h>
+
+// Includes from trunk
+#include "AbstractCellBasedTestSuite.hpp"
+#include "CellsGenerator.hpp"
+#include "DifferentiatedCellProliferativeType.hpp"
+#include "SmartPointers.hpp"
+#include "Timer.hpp"
+#include "UniformlyDistributedCellCycleModel.hpp"
+
+// Includes from projects/ImmersedBoundary
+#include "CsvWriter.hpp"
+#include "ImmersedBoundaryCellCellInteractionForce.hpp"
+#include "ImmersedBoundaryCellPopulation.hpp"
+#include "ImmersedBoundaryMembraneElasticityForce.hpp"
+#include "ImmersedBoundaryPalisadeMeshGenerator.hpp"
+#include "ImmersedBoundarySimulationModifier.hpp"
+
+// This test is never run in parallel
+#include "FakePetscSetup.hpp"
+
+/**
+ * Microbenchmarks for the performance-critical kernels of an immersed boundary simulation, run from the Benchmark
+ * test pack rather than with the correctness tests.  Each kernel is timed in isolation over a sweep of grid sizes,
+ * node counts and with fluid sources on and off.  The time per call, per grid point and per node of each kernel is
+ * written as a row of a CSV file in the output directory TestImmersedBoundaryBenchmarks, and printed.
+ */
+class TestImmersedBoundaryBenchmarks : public AbstractCellBasedTestSuite
+{
+private:
+
+    /**
+     * Start streaming benchmark results to a CSV file in the output directory TestImmersedBoundaryBenchmarks.
+     *
+     * @param rWriter the writer to stream the results with
+     * @param fileName the name of the CSV file
+     */
+    void StartResults(CsvWriter& rWriter, std::string fileName)
+    {
+        std::vector<std::string> headers;
+        headers.push_back("grid_pts");
+        headers.push_back("num_nodes");
+        headers.push_back("sources");
+        headers.push_back("num_reps");
+        headers.push_back("s_per_call");
+        headers.push_back("ns_per_point");
+        headers.push_back("ns_per_node");
+        headers.push_back("kernel");
+
+        rWriter.SetDirectoryName("TestImmersedBoundaryBenchmarks");
+        rWriter.SetFileName(fileName);
+        rWriter.AddHeaders(headers);
+        rWriter.StartStreaming(4, 3, 1, 1);
+    }
+
+    /**
+     * Record the time taken by repeated calls to a kernel, as a row of results and on standard output.
+     *
+     * @param rWriter the writer streaming the results
+     * @param kernel the name of the kernel
+     * @param numGridPts the number of grid points in each dimension of the fluid grid
+     * @param numNodes the number of nodes in the mesh
+     * @param sources whether the population has active fluid sources
+     * @param numReps the number of calls to the kernel
+     * @param totalTime the wall time taken by all the calls
+     */
+    void RecordResult(CsvWriter& rWriter,
+                      std::string kernel,
+                      unsigned numGridPts,
+                      unsigned numNodes,
+                      bool sources,
+                      unsigned numReps,
+                      double totalTime)
+    {
+        double time_per_call = totalTime / (double) numReps;
+        double ns_per_point = 1e9 * time_per_call / ((double) numGridPts * (double) numGridPts);
+        double ns_per_node = numNodes > 0 ? 1e9 * time_per_call / (double) numNodes : 0.0;
+
+        std::vector<unsigned> unsigned_data;
+        unsigned_data.push_back(numGridPts);
+        unsigned_data.push_back(numNodes);
+        unsigned_data.push_back(sources ? 1u : 0u);
+        unsigned_data.push_back(numReps);
+
+        std::vector<double> double_data;
+        double_data.push_back(time_per_call);
+        double_data.push_back(ns_per_point);
+        double_data.push_back(ns_per_node);
+
+        rWriter.AppendRow(unsigned_data, double_data, std::vector<std::string>(1, kernel));
+
+        std::cout << "BENCHMARK kernel=" << kernel << " grid_pts=" << numGridPts << " num_nodes=" << numNodes
+                  << " sources=" << sources << " num_reps=" << numReps << " s_per_call=" << time_per_call
+                  << " ns_per_point=" << ns_per_point << " ns_per_node=" << ns_per_node << "\n";
+    }
+
+    /**
+     * Set up a palisade of cells in a fluid grid, then time each kernel of the timestep in isolation.
+     *
+     * The fluid kernels (spreading, the fluid solve and interpolation) are repeated in proportion to the number of
+     * grid points, and the node kernels (the node pairs and each force) in proportion to the number of nodes, so
+     * that each takes a similar total time.
+     *
+     * @param rWriter the writer streaming the results
+     * @param numGridPts the number of grid points in each dimension of the fluid grid
+     * @param numCellsWide the number of cells in the palisade
+     * @param numNodesPerCell the number of nodes in each cell
+     * @param sources whether the population has active fluid sources
+     */
+    void BenchmarkTimestepKernels(CsvWriter& rWriter,
+                                  unsigned numGridPts,
+                                  unsigned numCellsWide,
+                                  unsigned numNodesPerCell,
+                                  bool sources)
+    {
+        // Reset SimulationTime, as SetupConstantMemberVariables() needs its timestep
+        SimulationTime::Destroy();
+        SimulationTime::Instance()->SetStartTime(0.0);
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(2.0, 2);
+
+        ImmersedBoundaryPalisadeMeshGenerator gen(numCellsWide, numNodesPerCell, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        p_mesh->SetNumGridPtsXAndY(numGridPts);
+
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+        cell_population.SetIfPopulationHasActiveSources(sources);
+
+        ImmersedBoundarySimulationModifier<2> modifier;
+        MAKE_PTR(ImmersedBoundaryMembraneElasticityForce<2>, p_boundary_force);
+        modifier.AddImmersedBoundaryForce(p_boundary_force);
+        MAKE_PTR(ImmersedBoundaryCellCellInteractionForce<2>, p_cell_cell_force);
+        modifier.AddImmersedBoundaryForce(p_cell_cell_force);
+
+        // Setting up the simulation calculates the node pairs and solves the fluid problem once
+        modifier.SetupSolve(cell_population, "TestImmersedBoundaryBenchmarks");
+
+        unsigned num_nodes = p_mesh->GetNumNodes();
+        unsigned grid_reps = std::max(1u, (1u << 22) / (numGridPts * numGridPts));
+        unsigned node_reps = std::max(1u, (1u << 20) / num_nodes);
+
+        Timer::Reset();
+        for (unsigned rep = 0; rep < node_reps; rep++)
+        {
+            modifier.CalculateNodePairs();
+        }
+        RecordResult(rWriter, "CalculateNodePairs", numGridPts, num_nodes, sources, node_reps,
+                     Timer::GetElapsedTime());
+
+        // Each class of force is timed separately by the modifier, within adding all force contributions
+        const ImmersedBoundaryPhaseTimer& r_timer = modifier.rGetPhaseTimer();
+        unsigned membrane_phase = r_timer.GetPhaseIndex("ImmersedBoundaryMembraneElasticityForce-2");
+        unsigned cell_cell_phase = r_timer.GetPhaseIndex("ImmersedBoundaryCellCellInteractionForce-2");
+        double membrane_time = r_timer.GetTotalTime(membrane_phase);
+        double cell_cell_time = r_timer.GetTotalTime(cell_cell_phase);
+
+        for (unsigned rep = 0; rep < node_reps; rep++)
+        {
+            modifier.AddImmersedBoundaryForceContributions();
+        }
+        RecordResult(rWriter, "ImmersedBoundaryMembraneElasticityForce", numGridPts, num_nodes, sources, node_reps,
+                     r_timer.GetTotalTime(membrane_phase) - membrane_time);
+        RecordResult(rWriter, "ImmersedBoundaryCellCellInteractionForce", numGridPts, num_nodes, sources, node_reps,
+                     r_timer.GetTotalTime(cell_cell_phase) - cell_cell_time);
+
+        Timer::Reset();
+        for (unsigned rep = 0; rep < grid_reps; rep++)
+        {
+            modifier.PropagateForcesToFluidGrid();
+        }
+        RecordResult(rWriter, "PropagateForcesToFluidGrid", numGridPts, num_nodes, sources, grid_reps,
+                     Timer::GetElapsedTime());
+
+        if (sources)
+        {
+            Timer::Reset();
+            for (unsigned rep = 0; rep < grid_reps; rep++)
+            {
+                modifier.PropagateFluidSourcesToGrid();
+            }
+            RecordResult(rWriter, "PropagateFluidSourcesToGrid", numGridPts, num_nodes, sources, grid_reps,
+                         Timer::GetElapsedTime());
+        }
+
+        Timer::Reset();
+        for (unsigned rep = 0; rep < grid_reps; rep++)
+        {
+            modifier.SolveNavierStokesSpectral();
+        }
+        RecordResult(rWriter, "SolveNavierStokesSpectral", numGridPts, num_nodes, sources, grid_reps,
+                     Timer::GetElapsedTime());
+
+        // Interpolation moves the nodes, so is timed last, with a small timestep to keep the nodes near the grid
+        Timer::Reset();
+        for (unsigned rep = 0; rep < node_reps; rep++)
+        {
+            cell_population.UpdateNodeLocations(1e-6);
+        }
+        RecordResult(rWriter, "UpdateNodeLocations", numGridPts, num_nodes, sources, node_reps,
+                     Timer::GetElapsedTime());
+    }
+
+    /**
+     * Reference implementation of the upwind difference, with a branch per grid point and modular index updates.
+     *
+     * @param input the velocity grids
+     * @param output the upwind differences
+     */
+    void ReferenceUpwind2d(const multi_array<double, 3>& input, multi_array<double, 3>& output)
+    {
+        unsigned num_x = input.shape()[1];
+        unsigned num_y = input.shape()[2];
+        double spacing_x = 1.0 / (double) num_x;
+        double spacing_y = 1.0 / (double) num_y;
+
+        unsigned prev_x = num_x - 1;
+        unsigned prev_y = num_y - 1;
+        unsigned next_x = 1;
+        unsigned next_y = 1;
+
+        for (unsigned x = 0; x < num_x; x++)
+        {
+            for (unsigned y = 0; y < num_y; y++)
+            {
+                if (input[0][x][y] > 0)
+                {
+                    output[0][x][y] = input[0][x][y] * (input[0][x][y] - input[0][prev_x][y]) / spacing_x;
+                    output[1][x][y] = input[0][x][y] * (input[1][x][y] - input[1][prev_x][y]) / spacing_x;
+                }
+                else
+                {
+                    output[0][x][y] = input[0][x][y] * (input[0][next_x][y] - input[0][x][y]) / spacing_x;
+                    output[1][x][y] = input[0][x][y] * (input[1][next_x][y] - input[1][x][y]) / spacing_x;
+                }
+
+                if (input[1][x][y] > 0)
+                {
+                    output[0][x][y] += input[1][x][y] * (input[0][x][y] - input[0][x][prev_y]) / spacing_y;
+                    output[1][x][y] += input[1][x][y] * (input[1][x][y] - input[1][x][prev_y]) / spacing_y;
+                }
+                else
+                {
+                    output[0][x][y] += input[1][x][y] * (input[0][x][next_y] - input[0][x][y]) / spacing_y;
+                    output[1][x][y] += input[1][x][y] * (input[1][x][next_y] - input[1][x][y]) / spacing_y;
+                }
+
+                prev_y = (prev_y + 1) % num_y;
+                next_y = (next_y + 1) % num_y;
+            }
+
+            prev_x = (prev_x + 1) % num_x;
+            next_x = (next_x + 1) % num_x;
+        }
+    }
+
+public:
+
+    void TestUpwind2dBenchmark() throw(Exception)
+    {
+        CsvWriter writer;
+        StartResults(writer, "upwind2d.csv");
+
+        unsigned grid_sizes[5] = {64, 256, 1024, 2048, 4096};
+
+        for (unsigned size_idx = 0; size_idx < 5; size_idx++)
+        {
+            unsigned num_pts = grid_sizes[size_idx];
+
+            // Keep the total work roughly constant across grid sizes
+            unsigned num_reps = std::max(1u, (1u << 24) / (num_pts * num_pts));
+
+            ImmersedBoundarySimulationModifier<2> modifier;
+            modifier.SetMemberVariablesForTesting(num_pts, num_pts);
+
+            // A velocity field with many sign changes, so the upwind direction is unpredictable
+            multi_array<double, 3> input(extents[2][num_pts][num_pts]);
+            for (unsigned x = 0; x < num_pts; x++)
+            {
+                for (unsigned y = 0; y < num_pts; y++)
+                {
+                    input[0][x][y] = sin(0.37 * x * x + 1.3 * y) + 0.1 * cos(17.0 * y);
+                    input[1][x][y] = cos(0.71 * y * y + 2.9 * x) - 0.1 * sin(13.0 * x);
+                }
+            }
+
+            multi_array<double, 3> output(extents[2][num_pts][num_pts]);
+
+            Timer::Reset();
+            for (unsigned rep = 0; rep < num_reps; rep++)
+            {
+                modifier.Upwind2d(input, output);
+            }
+            RecordResult(writer, "Upwind2d", num_pts, 0, false, num_reps, Timer::GetElapsedTime());
+
+            // The reference is only compared with up to 2048x2048, to bound the memory used by the largest grid
+            if (num_pts > 2048)
+            {
+                continue;
+            }
+
+            multi_array<double, 3> reference_output(extents[2][num_pts][num_pts]);
+
+            Timer::Reset();
+            for (unsigned rep = 0; rep < num_reps; rep++)
+            {
+                ReferenceUpwind2d(input, reference_output);
+            }
+            RecordResult(writer, "ReferenceUpwind2d", num_pts, 0, false, num_reps, Timer::GetElapsedTime());
+
+            for (unsigned dim = 0; dim < 2; dim++)
+            {
+                for (unsigned x = 0; x < num_pts; x++)
+                {
+                    for (unsigned y = 0; y < num_pts; y++)
+                    {
+                        TS_ASSERT_DELTA(output[dim][x][y], reference_output[dim][x][y],
+                                        1e-12 * num_pts * (1.0 + fabs(reference_output[dim][x][y])));
+                    }
+                }
+            }
+        }
+    }
+
+    void TestGridSizeSweep() throw(Exception)
+    {
+        CsvWriter writer;
+        StartResults(writer, "grid_size_sweep.csv");
+
+        // A fixed palisade of cells in fluid grids from 64x64 to 4096x4096, with and without fluid sources
+        unsigned grid_sizes[4] = {64, 256, 1024, 4096};
+
+        for (unsigned size_idx = 0; size_idx < 4; size_idx++)
+        {
+            BenchmarkTimestepKernels(writer, grid_sizes[size_idx], 5, 100, false);
+            BenchmarkTimestepKernels(writer, grid_sizes[size_idx], 5, 100, true);
+        }
+
+        TS_ASSERT_EQUALS(writer.GetNumRowsStreamed(), 52u);
+    }
+
+    void TestNodeCountSweep() throw(Exception)
+    {
+        CsvWriter writer;
+        StartResults(writer, "node_count_sweep.csv");
+
+        // Palisades of increasing numbers of nodes in a fixed fluid grid, with and without fluid sources
+        unsigned num_cells_wide[4] = {5, 10, 20, 40};
+        unsigned num_nodes_per_cell[4] = {100, 200, 400, 800};
+
+        for (unsigned mesh_idx = 0; mesh_idx < 4; mesh_idx++)
+        {
+            BenchmarkTimestepKernels(writer, 256, num_cells_wide[mesh_idx], num_nodes_per_cell[mesh_idx], false);
+            BenchmarkTimestepKernels(writer, 256, num_cells_wide[mesh_idx], num_nodes_per_cell[mesh_idx], true);
+        }
+
+        TS_ASSERT_EQUALS(writer.GetNumRowsStreamed(), 52u);
+    }
+};
+
+#endif /*TESTIMMERSEDBOUNDARYBENCHMARKS_HPP_*/
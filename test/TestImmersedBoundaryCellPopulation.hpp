@@ -37,6 +37,9 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <cxxtest/TestSuite.h>
 #include "AbstractCellBasedTestSuite.hpp"
 
+#include <algorithm>
+#include <climits>
+
 // Includes from trunk
 #include "ApcOneHitCellMutationState.hpp"
 #include "ApcTwoHitCellMutationState.hpp"
@@ -57,6 +60,7 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "CellsGenerator.hpp"
 #include "CellVolumesWriter.hpp"
 #include "CheckpointArchiveTypes.hpp"
+#include "CsvWriter.hpp"
 #include "DiagonalVertexBasedDivisionRule.hpp"
 #include "DifferentiatedCellProliferativeType.hpp"
 #include "FileComparison.hpp"
@@ -113,6 +117,36 @@ public:
 
         cell_population.SetIfPopulationHasActiveSources(true);
         TS_ASSERT_EQUALS(cell_population.DoesPopulationHaveActiveSources(), true);
+
+        // Test GetUseSimulationTimeStep() and SetUseSimulationTimeStep() work correctly
+        TS_ASSERT_EQUALS(cell_population.GetUseSimulationTimeStep(), false);
+        cell_population.SetUseSimulationTimeStep(true);
+        TS_ASSERT_EQUALS(cell_population.GetUseSimulationTimeStep(), true);
+
+        // No nodes have moved yet
+        TS_ASSERT_DELTA(cell_population.GetMaxNodeSpeed(), 0.0, 1e-12);
+        TS_ASSERT_DELTA(cell_population.GetNodeDisplacementBound(), 0.0, 1e-12);
+        cell_population.ResetNodeDisplacementBound();
+        TS_ASSERT_DELTA(cell_population.GetNodeDisplacementBound(), 0.0, 1e-12);
+
+        // Test GetStencilWidth() and SetStencilWidth() work correctly
+        TS_ASSERT_EQUALS(cell_population.GetStencilWidth(), 4u);
+        cell_population.SetStencilWidth(3);
+        TS_ASSERT_EQUALS(cell_population.GetStencilWidth(), 3u);
+        cell_population.SetStencilWidth(6);
+        TS_ASSERT_EQUALS(cell_population.GetStencilWidth(), 6u);
+
+        TS_ASSERT_THROWS_THIS(cell_population.SetStencilWidth(5), "The delta function stencil width must be 3, 4 or 6");
+
+        // Test GetNumInterpolationThreads() and SetNumInterpolationThreads() work correctly
+        TS_ASSERT_EQUALS(cell_population.GetNumInterpolationThreads(), 1u);
+        cell_population.SetNumInterpolationThreads(4);
+        TS_ASSERT_EQUALS(cell_population.GetNumInterpolationThreads(), 4u);
+
+        // Test GetLimitNodeDisplacements() and SetLimitNodeDisplacements() work correctly
+        TS_ASSERT_EQUALS(cell_population.GetLimitNodeDisplacements(), true);
+        cell_population.SetLimitNodeDisplacements(false);
+        TS_ASSERT_EQUALS(cell_population.GetLimitNodeDisplacements(), false);
     }
 
     void TestMeshMethods() throw(Exception)
@@ -187,7 +221,470 @@ public:
         TS_ASSERT_DELTA(cell_population.GetNode(0)->rGetLocation()[1], new_location[1], 1e-12);
     }
 
-    ///\todo Test AddNode(), UpdateNodeLocations(), AddCell(), RemoveDeadCells(), IsCellAssociatedWithADeletedLocation() and Update()
+    void TestReorderAlongSpaceFillingCurve() throw(Exception)
+    {
+        // Create an immersed boundary cell population object
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+
+        // Record the element, and the first node of the element, corresponding to each cell
+        std::map<Cell*, ImmersedBoundaryElement<2,2>*> elements_of_cells;
+        std::map<Cell*, Node<2>*> first_nodes_of_cells;
+        for (AbstractCellPopulation<2>::Iterator cell_iter = cell_population.Begin();
+             cell_iter != cell_population.End();
+             ++cell_iter)
+        {
+            ImmersedBoundaryElement<2,2>* p_element = cell_population.GetElementCorrespondingToCell(*cell_iter);
+            elements_of_cells[cell_iter->get()] = p_element;
+            first_nodes_of_cells[cell_iter->get()] = p_element->GetNode(0);
+        }
+        ImmersedBoundaryElement<2,2>* p_membrane = p_mesh->GetMembraneElement();
+
+        cell_population.ReorderAlongSpaceFillingCurve();
+
+        // Nodes are now in order along the curve, and each knows its new index
+        ImmersedBoundarySpaceFillingCurve curve;
+        for (unsigned node_idx = 0; node_idx < p_mesh->GetNumNodes(); node_idx++)
+        {
+            Node<2>* p_node = p_mesh->GetNode(node_idx);
+            TS_ASSERT_EQUALS(p_node->GetIndex(), node_idx);
+
+            if (node_idx > 0)
+            {
+                const c_vector<double, 2>& r_prev = p_mesh->GetNode(node_idx - 1)->rGetLocation();
+                TS_ASSERT_LESS_THAN_EQUALS(curve.GetKey(r_prev[0], r_prev[1]),
+                                           curve.GetKey(p_node->rGetLocation()[0], p_node->rGetLocation()[1]));
+            }
+        }
+
+        // Each element knows its new index, as do its nodes, and it has kept its nodes in the same order
+        for (unsigned elem_idx = 0; elem_idx < p_mesh->GetNumElements(); elem_idx++)
+        {
+            ImmersedBoundaryElement<2,2>* p_element = p_mesh->GetElement(elem_idx);
+            TS_ASSERT_EQUALS(p_element->GetIndex(), elem_idx);
+
+            for (unsigned node_idx = 0; node_idx < p_element->GetNumNodes(); node_idx++)
+            {
+                std::set<unsigned>& r_containing_elements = p_element->GetNode(node_idx)->rGetContainingElementIndices();
+                TS_ASSERT_EQUALS(r_containing_elements.size(), 1u);
+                TS_ASSERT_EQUALS(*(r_containing_elements.begin()), elem_idx);
+            }
+        }
+        TS_ASSERT_EQUALS(p_mesh->GetMembraneElement(), p_membrane);
+
+        // Each cell still corresponds to the same element
+        for (AbstractCellPopulation<2>::Iterator cell_iter = cell_population.Begin();
+             cell_iter != cell_population.End();
+             ++cell_iter)
+        {
+            ImmersedBoundaryElement<2,2>* p_element = cell_population.GetElementCorrespondingToCell(*cell_iter);
+            TS_ASSERT_EQUALS(p_element, elements_of_cells[cell_iter->get()]);
+            TS_ASSERT_EQUALS(p_element->GetNode(0), first_nodes_of_cells[cell_iter->get()]);
+            TS_ASSERT_EQUALS(cell_population.GetLocationIndexUsingCell(*cell_iter), p_element->GetIndex());
+        }
+        TS_ASSERT_THROWS_NOTHING(cell_population.Validate());
+
+        // The node arrays are rebuilt in the new order
+        ImmersedBoundaryNodeArrays<2>& r_node_arrays = p_mesh->rGetNodeArrays();
+        for (unsigned slot = 0; slot < r_node_arrays.GetNumSlots(); slot++)
+        {
+            Node<2>* p_node = p_mesh->GetNode(r_node_arrays.GetNodeIndex(slot));
+            TS_ASSERT_EQUALS(r_node_arrays.GetElementIndex(slot), *(p_node->rGetContainingElementIndices().begin()));
+        }
+    }
+
+    void TestRemoveDeadCellsAndReMesh() throw(Exception)
+    {
+        // Create an immersed boundary cell population object
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+        TS_ASSERT_EQUALS(cell_population.GetReMeshThreshold(), 1u);
+
+        unsigned num_elements = p_mesh->GetNumElements();
+        unsigned num_nodes = p_mesh->GetNumNodes();
+        unsigned num_sources = p_mesh->rGetElementFluidSources().size();
+        ImmersedBoundaryElement<2,2>* p_membrane = p_mesh->GetMembraneElement();
+
+        // Kill the cell of the first element other than the membrane
+        CellPtr p_dead_cell;
+        for (AbstractCellPopulation<2>::Iterator cell_iter = cell_population.Begin();
+             cell_iter != cell_population.End();
+             ++cell_iter)
+        {
+            if (cell_population.GetElementCorrespondingToCell(*cell_iter) != p_membrane)
+            {
+                p_dead_cell = *cell_iter;
+                break;
+            }
+        }
+        unsigned dead_elem_idx = cell_population.GetLocationIndexUsingCell(p_dead_cell);
+        unsigned num_dead_nodes = p_mesh->GetElement(dead_elem_idx)->GetNumNodes();
+        p_dead_cell->Kill();
+        p_mesh->rGetTopologyChanges().Clear();
+
+        // Record the element corresponding to each surviving cell
+        std::map<Cell*, ImmersedBoundaryElement<2,2>*> elements_of_cells;
+        for (AbstractCellPopulation<2>::Iterator cell_iter = cell_population.Begin();
+             cell_iter != cell_population.End();
+             ++cell_iter)
+        {
+            if (*cell_iter != p_dead_cell)
+            {
+                elements_of_cells[cell_iter->get()] = cell_population.GetElementCorrespondingToCell(*cell_iter);
+            }
+        }
+
+        // Removing the dead cell marks its element and nodes as deleted, leaving them in the mesh
+        TS_ASSERT_EQUALS(cell_population.RemoveDeadCells(), 1u);
+        TS_ASSERT_EQUALS(cell_population.GetNumRealCells(), num_elements - 1);
+        TS_ASSERT_EQUALS(p_mesh->GetNumDeletedElements(), 1u);
+        TS_ASSERT_EQUALS(p_mesh->GetNumElements(), num_elements);
+        TS_ASSERT(p_mesh->GetElement(dead_elem_idx)->IsDeleted());
+        TS_ASSERT_THROWS_NOTHING(cell_population.Validate());
+        TS_ASSERT_EQUALS(p_mesh->rGetTopologyChanges().GetNumDeletedElements(), 1u);
+        TS_ASSERT(p_mesh->rGetTopologyChanges().rGetNewNodeIndices().empty());
+
+        // Updating the population compacts the mesh, as the threshold has been reached
+        cell_population.Update();
+        TS_ASSERT_EQUALS(p_mesh->GetNumDeletedElements(), 0u);
+        TS_ASSERT_EQUALS(p_mesh->GetNumReMeshes(), 1u);
+        TS_ASSERT_EQUALS(p_mesh->GetNumElements(), num_elements - 1);
+        TS_ASSERT_EQUALS(p_mesh->GetNumNodes(), num_nodes - num_dead_nodes);
+        TS_ASSERT_EQUALS(p_mesh->rGetElementFluidSources().size(), num_sources - 1);
+        TS_ASSERT_EQUALS(p_mesh->GetMembraneElement(), p_membrane);
+
+        // The mesh records how the nodes and elements were renumbered
+        const ImmersedBoundaryTopologyChanges& r_changes = p_mesh->rGetTopologyChanges();
+        TS_ASSERT(r_changes.IsComplete());
+        TS_ASSERT_EQUALS(r_changes.rGetNewNodeIndices().size(), num_nodes);
+        TS_ASSERT_EQUALS(r_changes.rGetNewElementIndices().size(), num_elements);
+        TS_ASSERT_EQUALS(r_changes.rGetNewElementIndices()[dead_elem_idx], UINT_MAX);
+        TS_ASSERT_EQUALS(std::count(r_changes.rGetNewNodeIndices().begin(), r_changes.rGetNewNodeIndices().end(), UINT_MAX),
+                         (int) num_dead_nodes);
+
+        // Nodes, elements and fluid sources are numbered densely
+        for (unsigned node_idx = 0; node_idx < p_mesh->GetNumNodes(); node_idx++)
+        {
+            TS_ASSERT_EQUALS(p_mesh->GetNode(node_idx)->GetIndex(), node_idx);
+        }
+        for (unsigned elem_idx = 0; elem_idx < p_mesh->GetNumElements(); elem_idx++)
+        {
+            ImmersedBoundaryElement<2,2>* p_element = p_mesh->GetElement(elem_idx);
+            TS_ASSERT_EQUALS(p_element->GetIndex(), elem_idx);
+            TS_ASSERT(!p_element->IsDeleted());
+            TS_ASSERT_EQUALS(*(p_element->GetNode(0)->rGetContainingElementIndices().begin()), elem_idx);
+
+            if (p_element->GetFluidSource())
+            {
+                TS_ASSERT_EQUALS(p_element->GetFluidSource()->GetAssociatedElementIndex(), elem_idx);
+            }
+        }
+        for (unsigned source_idx = 0; source_idx < p_mesh->rGetElementFluidSources().size(); source_idx++)
+        {
+            TS_ASSERT_EQUALS(p_mesh->rGetElementFluidSources()[source_idx]->GetIndex(), source_idx);
+        }
+
+        // Each surviving cell still corresponds to the same element
+        for (AbstractCellPopulation<2>::Iterator cell_iter = cell_population.Begin();
+             cell_iter != cell_population.End();
+             ++cell_iter)
+        {
+            ImmersedBoundaryElement<2,2>* p_element = cell_population.GetElementCorrespondingToCell(*cell_iter);
+            TS_ASSERT_EQUALS(p_element, elements_of_cells[cell_iter->get()]);
+            TS_ASSERT_EQUALS(cell_population.GetLocationIndexUsingCell(*cell_iter), p_element->GetIndex());
+        }
+        TS_ASSERT_THROWS_NOTHING(cell_population.Validate());
+
+        // Automatic compaction can be switched off
+        cell_population.SetReMeshThreshold(0);
+        TS_ASSERT_EQUALS(cell_population.GetReMeshThreshold(), 0u);
+    }
+
+    void TestReMeshWithRegisteredFluidSources() throw(Exception)
+    {
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+        cell_population.SetIfPopulationHasActiveSources(true);
+
+        // Register the sources, as a fluid solve with active sources does
+        unsigned num_sources = p_mesh->rGetElementFluidSources().size();
+        unsigned num_balancing_sources = p_mesh->rGetBalancingFluidSources().size();
+        TS_ASSERT_EQUALS(p_mesh->rGetFluidSourceRegistry().GetNumSources(), num_sources + num_balancing_sources);
+
+        // Kill a cell other than the membrane, whose element has a source
+        ImmersedBoundaryElement<2,2>* p_membrane = p_mesh->GetMembraneElement();
+        for (AbstractCellPopulation<2>::Iterator cell_iter = cell_population.Begin();
+             cell_iter != cell_population.End();
+             ++cell_iter)
+        {
+            ImmersedBoundaryElement<2,2>* p_element = cell_population.GetElementCorrespondingToCell(*cell_iter);
+            if (p_element != p_membrane && p_element->GetFluidSource())
+            {
+                cell_iter->Kill();
+                break;
+            }
+        }
+
+        // Compacting the mesh deletes the dead element's source, which the registry must no longer refer to
+        TS_ASSERT_EQUALS(cell_population.RemoveDeadCells(), 1u);
+        cell_population.Update();
+        TS_ASSERT_EQUALS(p_mesh->GetNumReMeshes(), 1u);
+        TS_ASSERT_EQUALS(p_mesh->rGetElementFluidSources().size(), num_sources - 1);
+
+        // Re-registering the surviving sources touches only them
+        ImmersedBoundaryFluidSourceRegistry<2>& r_registry = p_mesh->rGetFluidSourceRegistry();
+        TS_ASSERT_EQUALS(r_registry.GetNumSources(), num_sources - 1 + num_balancing_sources);
+        TS_ASSERT_EQUALS(r_registry.GetNumElementSources(), num_sources - 1);
+        for (unsigned slot = 0; slot < r_registry.GetNumElementSources(); slot++)
+        {
+            TS_ASSERT_EQUALS(r_registry.GetSource(slot), p_mesh->rGetElementFluidSources()[slot]);
+        }
+
+        // The surviving sources still report their strengths to the registry
+        double total_strength = r_registry.GetTotalElementStrength();
+        p_mesh->rGetElementFluidSources()[0]->SetStrength(p_mesh->rGetElementFluidSources()[0]->GetStrength() + 1.0);
+        TS_ASSERT_DELTA(r_registry.GetTotalElementStrength(), total_strength + 1.0, 1e-12);
+    }
+
+    void TestImplicitMembraneCoefficients() throw(Exception)
+    {
+        // Two identical populations, the second with its membranes treated semi-implicitly
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryPalisadeMeshGenerator implicit_gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        ImmersedBoundaryMesh<2,2>* p_implicit_mesh = implicit_gen.GetMesh();
+
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        std::vector<CellPtr> cells;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        std::vector<CellPtr> implicit_cells;
+        cells_generator.GenerateBasicRandom(implicit_cells, p_implicit_mesh->GetNumElements(), p_diff_type);
+
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+        ImmersedBoundaryCellPopulation<2> implicit_population(*p_implicit_mesh, implicit_cells);
+        cell_population.SetLimitNodeDisplacements(false);
+        implicit_population.SetLimitNodeDisplacements(false);
+
+        TS_ASSERT(implicit_population.rGetImplicitMembraneCoefficients().empty());
+        implicit_population.SetImplicitMembraneCoefficients(std::vector<double>(p_implicit_mesh->GetNumAllElements(), 1e3));
+        TS_ASSERT_EQUALS(implicit_population.rGetImplicitMembraneCoefficients().size(), p_implicit_mesh->GetNumAllElements());
+
+        // A uniform fluid velocity translates every element unchanged, as it does without the semi-implicit update
+        multi_array<double, 3>& r_grids = p_mesh->rGetModifiable2dVelocityGrids();
+        multi_array<double, 3>& r_implicit_grids = p_implicit_mesh->rGetModifiable2dVelocityGrids();
+        for (unsigned x = 0; x < r_grids.shape()[1]; x++)
+        {
+            for (unsigned y = 0; y < r_grids.shape()[2]; y++)
+            {
+                r_grids[0][x][y] = 0.1;
+                r_grids[1][x][y] = -0.2;
+                r_implicit_grids[0][x][y] = 0.1;
+                r_implicit_grids[1][x][y] = -0.2;
+            }
+        }
+
+        std::vector<c_vector<double, 2> > old_locations;
+        for (unsigned node_idx = 0; node_idx < p_implicit_mesh->GetNumNodes(); node_idx++)
+        {
+            old_locations.push_back(p_implicit_mesh->GetNode(node_idx)->rGetLocation());
+        }
+        cell_population.UpdateNodeLocations(0.01);
+        implicit_population.UpdateNodeLocations(0.01);
+        for (unsigned node_idx = 0; node_idx < p_implicit_mesh->GetNumNodes(); node_idx++)
+        {
+            c_vector<double, 2> displacement = p_implicit_mesh->GetVectorFromAtoB(old_locations[node_idx],
+                                                                                  p_implicit_mesh->GetNode(node_idx)->rGetLocation());
+            TS_ASSERT_DELTA(displacement[0], 0.001, 1e-9);
+            TS_ASSERT_DELTA(displacement[1], -0.002, 1e-9);
+        }
+
+        // With very stiff membranes, each node of an element moves by the average displacement of the element's nodes
+        implicit_population.SetImplicitMembraneCoefficients(std::vector<double>(p_implicit_mesh->GetNumAllElements(), 1e10));
+        for (unsigned x = 0; x < r_grids.shape()[1]; x++)
+        {
+            for (unsigned y = 0; y < r_grids.shape()[2]; y++)
+            {
+                r_grids[0][x][y] = 0.1 * sin(12.0 * M_PI * x / r_grids.shape()[1]);
+                r_grids[1][x][y] = 0.1 * cos(12.0 * M_PI * y / r_grids.shape()[2]);
+                r_implicit_grids[0][x][y] = r_grids[0][x][y];
+                r_implicit_grids[1][x][y] = r_grids[1][x][y];
+            }
+        }
+
+        // Both meshes have been translated alike, so start from the same locations
+        old_locations.clear();
+        for (unsigned node_idx = 0; node_idx < p_mesh->GetNumNodes(); node_idx++)
+        {
+            old_locations.push_back(p_mesh->GetNode(node_idx)->rGetLocation());
+        }
+        cell_population.UpdateNodeLocations(0.01);
+        implicit_population.UpdateNodeLocations(0.01);
+
+        for (unsigned elem_idx = 0; elem_idx < p_mesh->GetNumElements(); elem_idx++)
+        {
+            ImmersedBoundaryElement<2,2>* p_element = p_mesh->GetElement(elem_idx);
+            c_vector<double, 2> average_displacement = zero_vector<double>(2);
+            for (unsigned local_idx = 0; local_idx < p_element->GetNumNodes(); local_idx++)
+            {
+                unsigned node_idx = p_element->GetNodeGlobalIndex(local_idx);
+                average_displacement += p_mesh->GetVectorFromAtoB(old_locations[node_idx], p_mesh->GetNode(node_idx)->rGetLocation());
+            }
+            average_displacement /= (double) p_element->GetNumNodes();
+
+            for (unsigned local_idx = 0; local_idx < p_element->GetNumNodes(); local_idx++)
+            {
+                unsigned node_idx = p_element->GetNodeGlobalIndex(local_idx);
+                c_vector<double, 2> displacement = p_implicit_mesh->GetVectorFromAtoB(old_locations[node_idx],
+                                                                                      p_implicit_mesh->GetNode(node_idx)->rGetLocation());
+                TS_ASSERT_DELTA(displacement[0], average_displacement[0], 1e-7);
+                TS_ASSERT_DELTA(displacement[1], average_displacement[1], 1e-7);
+            }
+        }
+
+        // The coefficients follow their elements when the mesh is renumbered
+        std::vector<double> coefficients(p_implicit_mesh->GetNumAllElements());
+        for (unsigned elem_idx = 0; elem_idx < coefficients.size(); elem_idx++)
+        {
+            coefficients[elem_idx] = elem_idx + 1.0;
+        }
+        implicit_population.SetImplicitMembraneCoefficients(coefficients);
+
+        std::map<Cell*, double> coefficients_of_cells;
+        for (AbstractCellPopulation<2>::Iterator cell_iter = implicit_population.Begin();
+             cell_iter != implicit_population.End();
+             ++cell_iter)
+        {
+            coefficients_of_cells[cell_iter->get()] = coefficients[implicit_population.GetLocationIndexUsingCell(*cell_iter)];
+        }
+
+        implicit_population.ReorderAlongSpaceFillingCurve();
+
+        for (AbstractCellPopulation<2>::Iterator cell_iter = implicit_population.Begin();
+             cell_iter != implicit_population.End();
+             ++cell_iter)
+        {
+            unsigned elem_idx = implicit_population.GetLocationIndexUsingCell(*cell_iter);
+            TS_ASSERT_DELTA(implicit_population.rGetImplicitMembraneCoefficients()[elem_idx],
+                            coefficients_of_cells[cell_iter->get()], 1e-12);
+        }
+    }
+
+    void TestMultithreadedUpdateNodeLocations() throw(Exception)
+    {
+        // Two identical populations with active sources, the second interpolating and moving its nodes on four threads
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryPalisadeMeshGenerator threaded_gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        ImmersedBoundaryMesh<2,2>* p_threaded_mesh = threaded_gen.GetMesh();
+
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        std::vector<CellPtr> cells;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        std::vector<CellPtr> threaded_cells;
+        cells_generator.GenerateBasicRandom(threaded_cells, p_threaded_mesh->GetNumElements(), p_diff_type);
+
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+        ImmersedBoundaryCellPopulation<2> threaded_population(*p_threaded_mesh, threaded_cells);
+        cell_population.SetIfPopulationHasActiveSources(true);
+        threaded_population.SetIfPopulationHasActiveSources(true);
+        threaded_population.SetNumInterpolationThreads(4);
+
+        ImmersedBoundaryFluidSourceRegistry<2>& r_registry = p_mesh->rGetFluidSourceRegistry();
+        ImmersedBoundaryFluidSourceRegistry<2>& r_threaded_registry = p_threaded_mesh->rGetFluidSourceRegistry();
+        TS_ASSERT_LESS_THAN(0u, r_registry.GetNumSources());
+        TS_ASSERT_EQUALS(r_threaded_registry.GetNumSources(), r_registry.GetNumSources());
+
+        // A fluid velocity that varies across the domain, fast enough in places that some displacements are limited
+        multi_array<double, 3>& r_grids = p_mesh->rGetModifiable2dVelocityGrids();
+        multi_array<double, 3>& r_threaded_grids = p_threaded_mesh->rGetModifiable2dVelocityGrids();
+        for (unsigned x = 0; x < r_grids.shape()[1]; x++)
+        {
+            for (unsigned y = 0; y < r_grids.shape()[2]; y++)
+            {
+                r_grids[0][x][y] = 0.5 * sin(2.0 * M_PI * y / r_grids.shape()[2]) + 0.1 * x / r_grids.shape()[1];
+                r_grids[1][x][y] = 0.3 * cos(4.0 * M_PI * x / r_grids.shape()[1]);
+                r_threaded_grids[0][x][y] = r_grids[0][x][y];
+                r_threaded_grids[1][x][y] = r_grids[1][x][y];
+            }
+        }
+
+        double characteristic_spacing = p_mesh->GetCharacteristicNodeSpacing();
+        double dts[3] = {0.001, 0.01, 0.05};
+        for (unsigned step = 0; step < 3; step++)
+        {
+            std::vector<c_vector<double, 2> > old_locations;
+            for (unsigned node_idx = 0; node_idx < p_mesh->GetNumNodes(); node_idx++)
+            {
+                old_locations.push_back(p_mesh->GetNode(node_idx)->rGetLocation());
+            }
+
+            cell_population.UpdateNodeLocations(dts[step]);
+            threaded_population.UpdateNodeLocations(dts[step]);
+
+            // Each node is interpolated and moved independently, so the results are the same on any number of threads
+            for (unsigned node_idx = 0; node_idx < p_mesh->GetNumNodes(); node_idx++)
+            {
+                const c_vector<double, 2>& r_location = p_mesh->GetNode(node_idx)->rGetLocation();
+                const c_vector<double, 2>& r_threaded_location = p_threaded_mesh->GetNode(node_idx)->rGetLocation();
+                TS_ASSERT_EQUALS(r_threaded_location[0], r_location[0]);
+                TS_ASSERT_EQUALS(r_threaded_location[1], r_location[1]);
+
+                // The nodes stay in the domain, and no node moves further than the characteristic spacing
+                TS_ASSERT(r_location[0] >= 0.0 && r_location[0] < 1.0);
+                TS_ASSERT(r_location[1] >= 0.0 && r_location[1] < 1.0);
+                TS_ASSERT_LESS_THAN_EQUALS(norm_2(p_mesh->GetVectorFromAtoB(old_locations[node_idx], r_location)),
+                                           characteristic_spacing * (1.0 + 1e-12));
+            }
+
+            for (unsigned source_idx = 0; source_idx < r_registry.GetNumSources(); source_idx++)
+            {
+                const c_vector<double, 2>& r_location = r_registry.GetSource(source_idx)->rGetLocation();
+                const c_vector<double, 2>& r_threaded_location = r_threaded_registry.GetSource(source_idx)->rGetLocation();
+                TS_ASSERT_EQUALS(r_threaded_location[0], r_location[0]);
+                TS_ASSERT_EQUALS(r_threaded_location[1], r_location[1]);
+
+                // The registry's copy of each location is kept in step with the source
+                TS_ASSERT_EQUALS(r_threaded_registry.GetLocation(source_idx)[0], r_threaded_location[0]);
+                TS_ASSERT_EQUALS(r_threaded_registry.GetLocation(source_idx)[1], r_threaded_location[1]);
+            }
+
+            // The reductions over threads agree with the serial results
+            TS_ASSERT_LESS_THAN(0.0, cell_population.GetMaxNodeSpeed());
+            TS_ASSERT_EQUALS(threaded_population.GetMaxNodeSpeed(), cell_population.GetMaxNodeSpeed());
+            TS_ASSERT_EQUALS(threaded_population.GetNodeDisplacementBound(), cell_population.GetNodeDisplacementBound());
+        }
+
+        // The cached geometry of each element follows its moved nodes
+        for (unsigned elem_idx = 0; elem_idx < p_mesh->GetNumElements(); elem_idx++)
+        {
+            TS_ASSERT_EQUALS(p_threaded_mesh->GetVolumeOfElement(elem_idx), p_mesh->GetVolumeOfElement(elem_idx));
+        }
+    }
+
+    ///\todo Test AddNode(), AddCell(), IsCellAssociatedWithADeletedLocation() and Update()
 
     void TestVertexBasedDivisionRuleMethods() throw (Exception)
     {
@@ -398,5 +895,123 @@ public:
  #endif //CHASTE_VTK
     }
 
+    void TestAsyncVtkOutput() throw (Exception)
+    {
+        // Set up SimulationTime (needed if VTK is used)
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(2.0, 2);
+
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+        cell_population.AddCellWriter<CellIdWriter>();
+        cell_population.AddCellWriter<CellVolumesWriter>();
+        for (AbstractCellPopulation<2>::Iterator cell_iter = cell_population.Begin();
+             cell_iter != cell_population.End();
+             ++cell_iter)
+        {
+            cell_iter->GetCellData()->SetItem("var", cell_population.GetLocationIndexUsingCell(*cell_iter) + 0.5);
+        }
+
+        TS_ASSERT_EQUALS(cell_population.GetAsyncVtkOutputQueueDepth(), 0u);
+
+        // Write the results synchronously
+        std::string sync_directory = "TestImmersedBoundaryVtkOutputSync";
+        OutputFileHandler sync_handler(sync_directory, false);
+        cell_population.OpenWritersFiles(sync_handler);
+        cell_population.WriteResultsToFiles(sync_directory);
+        cell_population.CloseWritersFiles();
+
+        // Write the same results on the background thread, with a single staging snapshot so each output waits for
+        // the previous one to be written
+        cell_population.SetAsyncVtkOutputQueueDepth(1);
+        TS_ASSERT_EQUALS(cell_population.GetAsyncVtkOutputQueueDepth(), 1u);
+
+        std::string async_directory = "TestImmersedBoundaryVtkOutputAsync";
+        OutputFileHandler async_handler(async_directory, false);
+        cell_population.OpenWritersFiles(async_handler);
+        cell_population.WriteResultsToFiles(async_directory);
+        SimulationTime::Instance()->IncrementTimeOneStep();
+        cell_population.WriteResultsToFiles(async_directory);
+
+        // Closing the writers' files waits for the background thread
+        cell_population.CloseWritersFiles();
+
+#ifdef CHASTE_VTK
+        FileComparison(async_handler.GetOutputDirectoryFullPath() + "results_0.vtu",
+                       sync_handler.GetOutputDirectoryFullPath() + "results_0.vtu").CompareFiles();
+
+        FileFinder vtk_file(async_handler.GetOutputDirectoryFullPath() + "results_1.vtu", RelativeTo::Absolute);
+        TS_ASSERT(vtk_file.Exists());
+#endif //CHASTE_VTK
+    }
+
+    void TestOutputSnapshot() throw (Exception)
+    {
+        // Set up SimulationTime (needed if VTK is used)
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(1.0, 1);
+
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+        cell_population.AddCellWriter<CellIdWriter>();
+        cell_population.AddCellWriter<CellVolumesWriter>();
+        for (AbstractCellPopulation<2>::Iterator cell_iter = cell_population.Begin();
+             cell_iter != cell_population.End();
+             ++cell_iter)
+        {
+            cell_iter->GetCellData()->SetItem("var", cell_population.GetLocationIndexUsingCell(*cell_iter) + 0.5);
+        }
+
+        // The writers' columns come first, then the cell data
+        ImmersedBoundaryMeshSnapshot<2,2> snapshot;
+        cell_population.TakeOutputSnapshot(snapshot, 7);
+        TS_ASSERT_EQUALS(snapshot.GetTimeStep(), 7u);
+        TS_ASSERT_EQUALS(snapshot.GetNumElements(), p_mesh->GetNumElements());
+        TS_ASSERT_EQUALS(snapshot.GetNumCellDataItems(), 3u);
+        TS_ASSERT_EQUALS(snapshot.rGetCellDataName(0), "Cell IDs");
+        TS_ASSERT_EQUALS(snapshot.rGetCellDataName(1), "Cell volumes");
+        TS_ASSERT_EQUALS(snapshot.rGetCellDataName(2), "var");
+
+        unsigned total_num_parts = 0;
+        for (unsigned local_idx = 0; local_idx < snapshot.GetNumElements(); local_idx++)
+        {
+            unsigned elem_idx = snapshot.GetElementIndex(local_idx);
+            CellPtr p_cell = cell_population.GetCellUsingLocationIndex(elem_idx);
+
+            TS_ASSERT_EQUALS(snapshot.GetCellId(local_idx), p_cell->GetCellId());
+            TS_ASSERT_DELTA(snapshot.GetCellData(0)[local_idx], p_cell->GetCellId(), 1e-12);
+            TS_ASSERT_DELTA(snapshot.GetCellData(1)[local_idx], p_mesh->GetVolumeOfElement(elem_idx), 1e-12);
+            TS_ASSERT_DELTA(snapshot.GetCellData(2)[local_idx], elem_idx + 0.5, 1e-12);
+            TS_ASSERT_EQUALS(snapshot.GetNumCellParts(local_idx),
+                             p_mesh->rGetPeriodicOverlaps().rGetNumCellParts()[elem_idx]);
+            total_num_parts += snapshot.GetNumCellParts(local_idx);
+        }
+        TS_ASSERT_EQUALS(snapshot.GetTotalNumCellParts(), total_num_parts);
+
+        // The same columns are streamed to CSV, one row per element
+        CsvWriter writer;
+        writer.SetDirectoryName("TestImmersedBoundaryOutputSnapshot");
+        writer.SetFileName("cell_data.csv");
+        writer.StartStreaming(3, snapshot.GetNumCellDataItems());
+        snapshot.AppendCellDataToCsv(writer);
+        TS_ASSERT_EQUALS(writer.GetNumRowsStreamed(), snapshot.GetNumElements());
+        writer.StopStreaming();
+
+        // Retaking the snapshot clears its cell data
+        snapshot.TakeFromMesh(*p_mesh, 8);
+        TS_ASSERT_EQUALS(snapshot.GetNumCellDataItems(), 0u);
+        TS_ASSERT_EQUALS(snapshot.GetCellId(0), UINT_MAX);
+    }
+
     ///\todo Test archiving?
 };
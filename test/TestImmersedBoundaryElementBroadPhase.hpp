@@ -0,0 +1,228 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TESTIMMERSEDBOUNDARYELEMENTBROADPHASE_HPP_
+#define TESTIMMERSEDBOUNDARYELEMENTBROADPHASE_HPP_
+
+// Needed for test framework
+#include <cxxtest/TestSuite.h>
+
+#include <set>
+
+// Includes from projects/ImmersedBoundary
+#include "ImmersedBoundaryElementBroadPhase.hpp"
+#include "RandomNumberGenerator.hpp"
+
+// This test is never run in parallel
+#include "FakePetscSetup.hpp"
+
+class TestImmersedBoundaryElementBroadPhase : public CxxTest::TestSuite
+{
+private:
+
+    /**
+     * Fill node arrays with square elements of four nodes, given their bottom left corners and side lengths.
+     */
+    void FillArrays(ImmersedBoundaryNodeArrays<2>& rArrays,
+                    const std::vector<double>& rCornersX,
+                    const std::vector<double>& rCornersY,
+                    const std::vector<double>& rSides)
+    {
+        rArrays.Reset(4 * rSides.size(), rSides.size(), 0);
+
+        c_vector<double, 2> zero_force = zero_vector<double>(2);
+        std::vector<double> no_attributes;
+
+        for (unsigned elem_idx = 0; elem_idx < rSides.size(); elem_idx++)
+        {
+            rArrays.BeginElement(elem_idx);
+            for (unsigned corner = 0; corner < 4; corner++)
+            {
+                c_vector<double, 2> location;
+                location[0] = rCornersX[elem_idx] + (corner % 2) * rSides[elem_idx];
+                location[1] = rCornersY[elem_idx] + (corner / 2) * rSides[elem_idx];
+
+                // Nodes outside the unit square are wrapped, as in the mesh
+                location[0] -= floor(location[0]);
+                location[1] -= floor(location[1]);
+
+                rArrays.AddNode(4 * elem_idx + corner, location, zero_force, no_attributes);
+            }
+        }
+    }
+
+    /**
+     * @return the set of overlapping pairs found by the broad phase
+     */
+    std::set<std::pair<unsigned, unsigned> > GetPairs(const ImmersedBoundaryElementBroadPhase<2>& rBroadPhase)
+    {
+        std::set<std::pair<unsigned, unsigned> > pairs;
+        for (unsigned pair = 0; pair < rBroadPhase.GetNumOverlappingPairs(); pair++)
+        {
+            TS_ASSERT_LESS_THAN(rBroadPhase.rGetOverlappingPair(pair).first, rBroadPhase.rGetOverlappingPair(pair).second);
+            pairs.insert(rBroadPhase.rGetOverlappingPair(pair));
+        }
+
+        // No pair is found twice
+        TS_ASSERT_EQUALS(pairs.size(), rBroadPhase.GetNumOverlappingPairs());
+        return pairs;
+    }
+
+public:
+
+    void TestBoxesAndPeriodicOverlaps() throw(Exception)
+    {
+        std::vector<double> corners_x;
+        std::vector<double> corners_y;
+        std::vector<double> sides;
+
+        // Element 0 straddles the corner of the domain; element 1 overlaps it across the left boundary
+        corners_x.push_back(0.95);
+        corners_y.push_back(0.95);
+        sides.push_back(0.1);
+
+        corners_x.push_back(0.02);
+        corners_y.push_back(0.55);
+        sides.push_back(0.4);
+
+        // Element 2 is isolated, and element 3 is just close enough to element 1 once inflated
+        corners_x.push_back(0.7);
+        corners_y.push_back(0.4);
+        sides.push_back(0.05);
+
+        corners_x.push_back(0.435);
+        corners_y.push_back(0.5);
+        sides.push_back(0.1);
+
+        ImmersedBoundaryNodeArrays<2> arrays;
+        FillArrays(arrays, corners_x, corners_y, sides);
+
+        ImmersedBoundaryElementBroadPhase<2> broad_phase;
+        broad_phase.Update(arrays, 0.01);
+
+        // The box of element 0 is found relative to its first node, and wrapped into the unit square
+        TS_ASSERT_DELTA(broad_phase.GetLowerCorner(0, 0), 0.94, 1e-12);
+        TS_ASSERT_DELTA(broad_phase.GetLowerCorner(0, 1), 0.94, 1e-12);
+        TS_ASSERT_DELTA(broad_phase.GetWidth(0, 0), 0.12, 1e-12);
+        TS_ASSERT_DELTA(broad_phase.GetWidth(3, 1), 0.12, 1e-12);
+
+        std::set<std::pair<unsigned, unsigned> > pairs = GetPairs(broad_phase);
+        TS_ASSERT_EQUALS(pairs.size(), 2u);
+        TS_ASSERT_EQUALS(pairs.count(std::make_pair(0u, 1u)), 1u);
+        TS_ASSERT_EQUALS(pairs.count(std::make_pair(1u, 3u)), 1u);
+
+        // Locations are tested against the boxes with a further margin, accounting for periodicity
+        double near_element_0[2] = {0.05, 0.05};
+        double far_from_element_0[2] = {0.5, 0.07};
+        TS_ASSERT(broad_phase.Contains(0, near_element_0, 0.0));
+        TS_ASSERT(!broad_phase.Contains(0, far_from_element_0, 0.0));
+        TS_ASSERT(!broad_phase.Contains(2, near_element_0, 0.0));
+
+        double near_element_2[2] = {0.78, 0.4};
+        TS_ASSERT(!broad_phase.Contains(2, near_element_2, 0.0));
+        TS_ASSERT(broad_phase.Contains(2, near_element_2, 0.03));
+
+        // Moving element 2 between elements 1 and 3 reorders the sweep and adds two pairs
+        for (unsigned slot = arrays.GetElementBegin(2); slot < arrays.GetElementEnd(2); slot++)
+        {
+            arrays.GetLocation(slot)[0] -= 0.3;
+            arrays.GetLocation(slot)[1] += 0.2;
+        }
+        broad_phase.Update(arrays, 0.01);
+
+        pairs = GetPairs(broad_phase);
+        TS_ASSERT_EQUALS(pairs.size(), 4u);
+        TS_ASSERT_EQUALS(pairs.count(std::make_pair(1u, 2u)), 1u);
+        TS_ASSERT_EQUALS(pairs.count(std::make_pair(2u, 3u)), 1u);
+    }
+
+    void TestAgainstAllPairs() throw(Exception)
+    {
+        // Many elements of varied size, including some wider than the domain once inflated
+        RandomNumberGenerator* p_gen = RandomNumberGenerator::Instance();
+        p_gen->Reseed(0);
+
+        std::vector<double> corners_x;
+        std::vector<double> corners_y;
+        std::vector<double> sides;
+        for (unsigned elem_idx = 0; elem_idx < 100; elem_idx++)
+        {
+            corners_x.push_back(p_gen->ranf());
+            corners_y.push_back(p_gen->ranf());
+            sides.push_back(elem_idx % 20 == 0 ? 0.45 : 0.1 * p_gen->ranf());
+        }
+
+        ImmersedBoundaryNodeArrays<2> arrays;
+        ImmersedBoundaryElementBroadPhase<2> broad_phase;
+
+        // Update repeatedly, as the elements drift, so that the sweep order is restored from the previous one
+        for (unsigned update = 0; update < 3; update++)
+        {
+            for (unsigned elem_idx = 0; elem_idx < corners_x.size(); elem_idx++)
+            {
+                corners_x[elem_idx] += 0.05 * (p_gen->ranf() - 0.5);
+                corners_y[elem_idx] += 0.05 * (p_gen->ranf() - 0.5);
+            }
+            FillArrays(arrays, corners_x, corners_y, sides);
+            broad_phase.Update(arrays, 0.02);
+
+            // Compare against testing the overlap of every pair of boxes directly
+            std::set<std::pair<unsigned, unsigned> > expected;
+            for (unsigned elem_a = 0; elem_a < sides.size(); elem_a++)
+            {
+                for (unsigned elem_b = elem_a + 1; elem_b < sides.size(); elem_b++)
+                {
+                    bool overlap = true;
+                    for (unsigned dim = 0; dim < 2; dim++)
+                    {
+                        double forward = broad_phase.GetLowerCorner(elem_b, dim) - broad_phase.GetLowerCorner(elem_a, dim);
+                        forward -= floor(forward);
+                        overlap = overlap && (forward < broad_phase.GetWidth(elem_a, dim) ||
+                                              1.0 - forward < broad_phase.GetWidth(elem_b, dim));
+                    }
+                    if (overlap)
+                    {
+                        expected.insert(std::make_pair(elem_a, elem_b));
+                    }
+                }
+            }
+
+            TS_ASSERT_LESS_THAN(0u, expected.size());
+            TS_ASSERT(GetPairs(broad_phase) == expected);
+        }
+    }
+};
+
+#endif /*TESTIMMERSEDBOUNDARYELEMENTBROADPHASE_HPP_*/
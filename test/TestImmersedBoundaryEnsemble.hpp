@@ -0,0 +1,293 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TESTIMMERSEDBOUNDARYENSEMBLE_HPP_
+#define TESTIMMERSEDBOUNDARYENSEMBLE_HPP_
+
+// Needed for the test environment
+#include <cxxtest/TestSuite.h>
+#include "AbstractCellBasedTestSuite.hpp"
+
+#include <boost/shared_ptr.hpp>
+
+// Includes from trunk
+#include "CellsGenerator.hpp"
+#include "DifferentiatedCellProliferativeType.hpp"
+#include "SmartPointers.hpp"
+#include "UniformlyDistributedCellCycleModel.hpp"
+#include "Warnings.hpp"
+
+// Includes from Immersed Boundary
+#include "ImmersedBoundaryCellPopulation.hpp"
+#include "ImmersedBoundaryEnsemble.hpp"
+#include "ImmersedBoundaryMembraneElasticityForce.hpp"
+#include "ImmersedBoundaryPalisadeMeshGenerator.hpp"
+#include "ImmersedBoundarySimulationModifier.hpp"
+
+// This test is never run in parallel
+#include "FakePetscSetup.hpp"
+
+class TestImmersedBoundaryEnsemble : public AbstractCellBasedTestSuite
+{
+private:
+
+    /**
+     * @return a palisade of cells on a 64 by 64 fluid grid
+     *
+     * @param rGenerators the generators owning the meshes, to which the generator of this mesh is added
+     */
+    ImmersedBoundaryMesh<2,2>* MakeMesh(std::vector<boost::shared_ptr<ImmersedBoundaryPalisadeMeshGenerator> >& rGenerators)
+    {
+        boost::shared_ptr<ImmersedBoundaryPalisadeMeshGenerator> p_gen(
+                new ImmersedBoundaryPalisadeMeshGenerator(5, 100, 0.2, 2.0, 0.15, true));
+        rGenerators.push_back(p_gen);
+
+        ImmersedBoundaryMesh<2,2>* p_mesh = p_gen->GetMesh();
+        p_mesh->SetNumGridPtsXAndY(64);
+        return p_mesh;
+    }
+
+    /**
+     * @return a cell population of differentiated cells on a mesh
+     *
+     * @param pMesh the mesh
+     */
+    boost::shared_ptr<ImmersedBoundaryCellPopulation<2> > MakeCellPopulation(ImmersedBoundaryMesh<2,2>* pMesh)
+    {
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, pMesh->GetNumElements(), p_diff_type);
+
+        boost::shared_ptr<ImmersedBoundaryCellPopulation<2> > p_population(new ImmersedBoundaryCellPopulation<2>(*pMesh, cells));
+        p_population->SetIfPopulationHasActiveSources(false);
+        return p_population;
+    }
+
+    /**
+     * @return a simulation modifier with a membrane elasticity force
+     *
+     * @param springConstant the spring constant of the force
+     */
+    boost::shared_ptr<ImmersedBoundarySimulationModifier<2> > MakeModifier(double springConstant)
+    {
+        MAKE_PTR(ImmersedBoundarySimulationModifier<2>, p_modifier);
+        MAKE_PTR(ImmersedBoundaryMembraneElasticityForce<2>, p_boundary_force);
+        p_boundary_force->SetSpringConstant(springConstant);
+        p_modifier->AddImmersedBoundaryForce(p_boundary_force);
+        return p_modifier;
+    }
+
+public:
+
+    void TestGetAndSetMethods() throw(Exception)
+    {
+        ImmersedBoundaryEnsemble<2> ensemble;
+
+        TS_ASSERT_EQUALS(ensemble.GetNumMembers(), 0u);
+        TS_ASSERT_EQUALS(ensemble.GetNumThreads(), 1u);
+        TS_ASSERT_DELTA(ensemble.GetDt(), 0.01, 1e-12);
+        TS_ASSERT_DELTA(ensemble.GetEndTime(), 0.0, 1e-12);
+        TS_ASSERT(ensemble.GetFftInterface() == NULL);
+
+        ensemble.SetNumThreads(4);
+        TS_ASSERT_EQUALS(ensemble.GetNumThreads(), 4u);
+        ensemble.SetDt(0.05);
+        TS_ASSERT_DELTA(ensemble.GetDt(), 0.05, 1e-12);
+        ensemble.SetEndTime(1.0);
+        TS_ASSERT_DELTA(ensemble.GetEndTime(), 1.0, 1e-12);
+        ensemble.SetOutputDirectory("TestImmersedBoundaryEnsemble");
+        TS_ASSERT_EQUALS(ensemble.rGetOutputDirectory(), "TestImmersedBoundaryEnsemble");
+        TS_ASSERT_EQUALS(ensemble.GetMemberOutputDirectory(3), "TestImmersedBoundaryEnsemble/member_3");
+
+        TS_ASSERT_THROWS_THIS(ensemble.Solve(), "An ensemble must have at least one member to be solved");
+    }
+
+    void TestAddMemberExceptions() throw(Exception)
+    {
+        std::vector<boost::shared_ptr<ImmersedBoundaryPalisadeMeshGenerator> > generators;
+        ImmersedBoundaryMesh<2,2>* p_mesh = MakeMesh(generators);
+        ImmersedBoundaryMesh<2,2>* p_other_mesh = MakeMesh(generators);
+
+        boost::shared_ptr<ImmersedBoundaryCellPopulation<2> > p_population = MakeCellPopulation(p_mesh);
+        boost::shared_ptr<ImmersedBoundaryCellPopulation<2> > p_other_population = MakeCellPopulation(p_other_mesh);
+
+        ImmersedBoundaryEnsemble<2> ensemble;
+        ensemble.AddMember(*p_population, MakeModifier(1e7));
+        TS_ASSERT_EQUALS(ensemble.GetNumMembers(), 1u);
+        TS_ASSERT_EQUALS(&(ensemble.rGetCellPopulation(0)), p_population.get());
+
+        // Each member must have the same grid size and source mode as the first
+        p_other_mesh->SetNumGridPtsXAndY(128);
+        TS_ASSERT_THROWS_THIS(ensemble.AddMember(*p_other_population, MakeModifier(1e7)),
+                              "Each member of an ensemble must have the same fluid grid size");
+
+        p_other_mesh->SetNumGridPtsXAndY(64);
+        p_other_population->SetIfPopulationHasActiveSources(true);
+        TS_ASSERT_THROWS_THIS(ensemble.AddMember(*p_other_population, MakeModifier(1e7)),
+                              "Either every member of an ensemble or none must have active fluid sources");
+
+        // The members share the timestep and solve the fluid in double precision
+        p_other_population->SetIfPopulationHasActiveSources(false);
+        boost::shared_ptr<ImmersedBoundarySimulationModifier<2> > p_modifier = MakeModifier(1e7);
+        ensemble.AddMember(*p_other_population, p_modifier);
+        TS_ASSERT_EQUALS(ensemble.GetNumMembers(), 2u);
+        TS_ASSERT_EQUALS(ensemble.GetModifier(1), p_modifier);
+
+        TS_ASSERT_THROWS_THIS(ensemble.Solve(), "SetEndTime has not yet been called.");
+        ensemble.SetEndTime(0.1);
+        TS_ASSERT_THROWS_THIS(ensemble.Solve(), "OutputDirectory not set");
+        ensemble.SetOutputDirectory("TestImmersedBoundaryEnsemble");
+
+        p_modifier->SetUseSinglePrecisionFluid(true);
+        TS_ASSERT_THROWS_THIS(ensemble.Solve(), "Member 1 of the ensemble solves the fluid in single precision");
+        p_modifier->SetUseSinglePrecisionFluid(false);
+
+        p_modifier->SetUseAdaptiveTimestep(true);
+        TS_ASSERT_THROWS_THIS(ensemble.Solve(),
+                              "Member 1 of the ensemble adapts its timestep, which the members must share");
+    }
+
+    void TestEnsembleMatchesSeparateSimulations() throw(Exception)
+    {
+        const unsigned num_members = 3;
+        const unsigned num_time_steps = 10;
+        double dt = 0.05;
+        double spring_constants[num_members] = {1e7, 2e7, 4e7};
+
+        std::vector<boost::shared_ptr<ImmersedBoundaryPalisadeMeshGenerator> > generators;
+        std::vector<boost::shared_ptr<ImmersedBoundaryCellPopulation<2> > > populations;
+
+        // The members differ only in the spring constant of their membranes
+        ImmersedBoundaryEnsemble<2> ensemble;
+        for (unsigned member = 0; member < num_members; member++)
+        {
+            populations.push_back(MakeCellPopulation(MakeMesh(generators)));
+            ensemble.AddMember(*(populations[member]), MakeModifier(spring_constants[member]));
+        }
+
+        ensemble.SetNumThreads(2);
+        ensemble.SetDt(dt);
+        ensemble.SetEndTime(num_time_steps * dt);
+        ensemble.SetOutputDirectory("TestImmersedBoundaryEnsemble");
+        ensemble.Solve();
+
+        TS_ASSERT_EQUALS(SimulationTime::Instance()->GetTimeStepsElapsed(), num_time_steps);
+
+        // The transforms are planned once, by the ensemble, and every member executes the same plans
+        TS_ASSERT(ensemble.GetFftInterface() != NULL);
+        TS_ASSERT(ensemble.GetFftInterface()->OwnsPlans());
+
+        // Each member ends up where the same simulation, run on its own, does
+        for (unsigned member = 0; member < num_members; member++)
+        {
+            SimulationTime::Destroy();
+            SimulationTime::Instance()->SetStartTime(0.0);
+            SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(num_time_steps * dt, num_time_steps);
+
+            ImmersedBoundaryMesh<2,2>* p_mesh = MakeMesh(generators);
+            boost::shared_ptr<ImmersedBoundaryCellPopulation<2> > p_population = MakeCellPopulation(p_mesh);
+            boost::shared_ptr<ImmersedBoundarySimulationModifier<2> > p_modifier = MakeModifier(spring_constants[member]);
+
+            p_modifier->SetupSolve(*p_population, "TestImmersedBoundaryEnsemble/separate");
+            while (!SimulationTime::Instance()->IsFinished())
+            {
+                p_population->UpdateNodeLocations(dt);
+                SimulationTime::Instance()->IncrementTimeOneStep();
+                p_modifier->UpdateAtEndOfTimeStep(*p_population);
+            }
+
+            ImmersedBoundaryMesh<2,2>& r_member_mesh = ensemble.rGetCellPopulation(member).rGetMesh();
+            TS_ASSERT_EQUALS(r_member_mesh.GetNumNodes(), p_mesh->GetNumNodes());
+            for (unsigned node_idx = 0; node_idx < p_mesh->GetNumNodes(); node_idx++)
+            {
+                const c_vector<double, 2>& r_location = p_mesh->GetNode(node_idx)->rGetLocation();
+                const c_vector<double, 2>& r_member_location = r_member_mesh.GetNode(node_idx)->rGetLocation();
+                TS_ASSERT_DELTA(r_member_location[0], r_location[0], 1e-10);
+                TS_ASSERT_DELTA(r_member_location[1], r_location[1], 1e-10);
+            }
+        }
+
+        // The members moved differently, so the ensemble did not just advance one simulation
+        const c_vector<double, 2>& r_first = ensemble.rGetCellPopulation(0).rGetMesh().GetNode(0)->rGetLocation();
+        const c_vector<double, 2>& r_last = ensemble.rGetCellPopulation(2).rGetMesh().GetNode(0)->rGetLocation();
+        TS_ASSERT_DIFFERS(r_first[0], r_last[0]);
+    }
+
+    void TestClampingWarningInSeveralMembers() throw(Exception)
+    {
+        const unsigned num_members = 4;
+        const unsigned num_time_steps = 2;
+        double dt = 0.05;
+        double node_spacing = 1e-9;
+
+        std::vector<boost::shared_ptr<ImmersedBoundaryPalisadeMeshGenerator> > generators;
+        std::vector<boost::shared_ptr<ImmersedBoundaryCellPopulation<2> > > populations;
+        std::vector<c_vector<double, 2> > initial_locations;
+
+        // With a tiny node spacing, the motion of every member is restricted, so each raises the warning at once
+        ImmersedBoundaryEnsemble<2> ensemble;
+        for (unsigned member = 0; member < num_members; member++)
+        {
+            ImmersedBoundaryMesh<2,2>* p_mesh = MakeMesh(generators);
+            p_mesh->SetCharacteristicNodeSpacing(node_spacing);
+            initial_locations.push_back(p_mesh->GetNode(0)->rGetLocation());
+
+            populations.push_back(MakeCellPopulation(p_mesh));
+            ensemble.AddMember(*(populations[member]), MakeModifier(1e7));
+        }
+
+        ensemble.SetNumThreads(num_members);
+        ensemble.SetDt(dt);
+        ensemble.SetEndTime(num_time_steps * dt);
+        ensemble.SetOutputDirectory("TestImmersedBoundaryEnsemble");
+        ensemble.Solve();
+
+        // The warning is recorded once, however many members raised it
+        TS_ASSERT_EQUALS(Warnings::Instance()->GetNumWarnings(), 1u);
+        TS_ASSERT_EQUALS(Warnings::Instance()->GetNextWarningMessage(),
+                         "Nodes are moving more than half the CharacteristicNodeSpacing. This could cause elements to become inverted so the motion has been restricted. Use a smaller timestep to avoid these warnings.");
+        Warnings::QuietDestroy();
+
+        // Every member had its motion restricted
+        for (unsigned member = 0; member < num_members; member++)
+        {
+            const c_vector<double, 2>& r_location = ensemble.rGetCellPopulation(member).rGetMesh().GetNode(0)->rGetLocation();
+            TS_ASSERT_LESS_THAN_EQUALS(norm_2(r_location - initial_locations[member]), num_time_steps * node_spacing + 1e-15);
+        }
+    }
+};
+
+#endif /*TESTIMMERSEDBOUNDARYENSEMBLE_HPP_*/
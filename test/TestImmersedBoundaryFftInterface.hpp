@@ -36,8 +36,15 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // Needed for test framework
 #include <cxxtest/TestSuite.h>
 
+#include <cmath>
+#include <complex>
+
+// Includes from trunk
+#include "FileFinder.hpp"
+
 // Includes from projects/ImmersedBoundary
 #include "ImmersedBoundaryFftInterface.hpp"
+#include "ImmersedBoundaryPalisadeMeshGenerator.hpp"
 
 // This test is never run in parallel
 #include "FakePetscSetup.hpp"
@@ -60,4 +67,298 @@ public:
     {
         ///\todo Test this method
     }
+
+    void TestSharedPlans() throw(Exception)
+    {
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        p_mesh->SetNumGridPtsXAndY(32);
+
+        // Two sets of arrays, the second transformed with the plans made for the first
+        multi_array<double, 3> input(extents[2][32][32]);
+        multi_array<std::complex<double>, 3> fourier(extents[2][32][17]);
+        multi_array<double, 3> output(extents[2][32][32]);
+        multi_array<double, 3> shared_input(extents[2][32][32]);
+        multi_array<std::complex<double>, 3> shared_fourier(extents[2][32][17]);
+        multi_array<double, 3> shared_output(extents[2][32][32]);
+
+        ImmersedBoundaryFftInterface<2> fft_interface(p_mesh, &input[0][0][0], &fourier[0][0][0], &output[0][0][0], 1, false);
+        ImmersedBoundaryFftInterface<2> shared_interface(fft_interface, &shared_input[0][0][0], &shared_fourier[0][0][0],
+                                                         &shared_output[0][0][0], false);
+
+        TS_ASSERT(fft_interface.OwnsPlans());
+        TS_ASSERT_EQUALS(shared_interface.GetNumThreads(), 1u);
+
+        // Planning overwrites the arrays, so they are filled once both interfaces have been constructed
+        for (unsigned dim = 0; dim < 2; dim++)
+        {
+            for (unsigned x = 0; x < 32; x++)
+            {
+                for (unsigned y = 0; y < 32; y++)
+                {
+                    input[dim][x][y] = sin(0.3 * x + 0.1 * y + dim) + 0.01 * x * y;
+                    shared_input[dim][x][y] = input[dim][x][y];
+                }
+            }
+        }
+
+        fft_interface.FftExecuteForward();
+        shared_interface.FftExecuteForward();
+        fft_interface.FftExecuteInverse();
+        shared_interface.FftExecuteInverse();
+
+        // The shared plans transform the arrays of the sharing interface just as they transform those planned for
+        for (unsigned dim = 0; dim < 2; dim++)
+        {
+            for (unsigned x = 0; x < 32; x++)
+            {
+                for (unsigned y = 0; y < 32; y++)
+                {
+                    TS_ASSERT_DELTA(shared_output[dim][x][y], output[dim][x][y], 1e-10);
+                    TS_ASSERT_DELTA(shared_output[dim][x][y], 1024.0 * shared_input[dim][x][y], 1e-8);
+                }
+            }
+        }
+    }
+
+    void TestFastStartPlanning() throw(Exception)
+    {
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        p_mesh->SetNumGridPtsXAndY(48);
+
+        // Remove any wisdom cached by an earlier run, so that the plans are upgraded in the background
+        FileFinder cache_file(ImmersedBoundaryFftInterface<2>::GetWisdomCacheDirectory() + "/" +
+                              ImmersedBoundaryFftInterface<2>::GetWisdomCacheFilename(48, 48, 1, false),
+                              RelativeTo::ChasteTestOutput);
+        if (cache_file.IsFile())
+        {
+            cache_file.Remove();
+        }
+
+        multi_array<double, 3> input(extents[2][48][48]);
+        multi_array<std::complex<double>, 3> fourier(extents[2][48][25]);
+        multi_array<double, 3> output(extents[2][48][48]);
+
+        {
+            ImmersedBoundaryFftInterface<2> fft_interface(p_mesh, &input[0][0][0], &fourier[0][0][0], &output[0][0][0],
+                                                          1, false, true);
+            TS_ASSERT_EQUALS(fft_interface.WasWisdomImportedFromCache(), false);
+
+            // The transforms may be executed while the plans are upgraded, and keep giving the same results afterwards
+            for (unsigned step = 0; step < 2; step++)
+            {
+                for (unsigned dim = 0; dim < 2; dim++)
+                {
+                    for (unsigned x = 0; x < 48; x++)
+                    {
+                        for (unsigned y = 0; y < 48; y++)
+                        {
+                            input[dim][x][y] = cos(0.2 * x - 0.3 * y + dim);
+                        }
+                    }
+                }
+
+                fft_interface.FftExecuteForward();
+                fft_interface.FftExecuteInverse();
+
+                for (unsigned dim = 0; dim < 2; dim++)
+                {
+                    for (unsigned x = 0; x < 48; x++)
+                    {
+                        for (unsigned y = 0; y < 48; y++)
+                        {
+                            TS_ASSERT_DELTA(output[dim][x][y], 2304.0 * input[dim][x][y], 1e-8);
+                        }
+                    }
+                }
+
+                fft_interface.WaitForPlanUpgrade();
+                TS_ASSERT_EQUALS(fft_interface.IsUpgradingPlans(), false);
+                TS_ASSERT_EQUALS(fft_interface.WerePlansUpgraded(), true);
+            }
+        }
+
+        // The upgraded wisdom is cached, so the next interface plans with FFTW_PATIENT straight away
+        TS_ASSERT(cache_file.IsFile());
+        ImmersedBoundaryFftInterface<2> cached_interface(p_mesh, &input[0][0][0], &fourier[0][0][0], &output[0][0][0],
+                                                         1, false, true);
+        TS_ASSERT_EQUALS(cached_interface.WasWisdomImportedFromCache(), true);
+        TS_ASSERT_EQUALS(cached_interface.IsUpgradingPlans(), false);
+    }
+
+    void TestFastStartPlanningInLowMemoryLayout() throw(Exception)
+    {
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        p_mesh->SetNumGridPtsXAndY(56);
+
+        // Remove any wisdom cached by an earlier run, so that the plans of both interfaces are upgraded
+        std::string cache_directory = ImmersedBoundaryFftInterface<2, float>::GetWisdomCacheDirectory() + "/";
+        FileFinder cache_files[2] = {
+            FileFinder(cache_directory + ImmersedBoundaryFftInterface<2, float>::GetWisdomCacheFilename(56, 56, 1, true),
+                       RelativeTo::ChasteTestOutput),
+            FileFinder(cache_directory + ImmersedBoundaryFftInterface<2, float>::GetWisdomCacheFilename(24, 24, 1, false),
+                       RelativeTo::ChasteTestOutput)};
+        for (unsigned i = 0; i < 2; i++)
+        {
+            if (cache_files[i].IsFile())
+            {
+                cache_files[i].Remove();
+            }
+        }
+
+        // As in the low-memory layout, the output grids share the storage of the input grids
+        multi_array<float, 3> input(extents[3][56][56]);
+        multi_array<std::complex<float>, 3> fourier(extents[3][56][29]);
+        float* p_output = &input[0][0][0];
+
+        ImmersedBoundaryFftInterface<2, float> fft_interface(p_mesh, &input[0][0][0], &fourier[0][0][0], p_output,
+                                                             1, true, true);
+        TS_ASSERT_EQUALS(fft_interface.IsUpgradingPlans(), true);
+
+        // Another interface forgets all wisdom while planning, which must not stop the upgraded plans being swapped in
+        p_mesh->SetNumGridPtsXAndY(24);
+        multi_array<float, 3> other_input(extents[2][24][24]);
+        multi_array<std::complex<float>, 3> other_fourier(extents[2][24][13]);
+        multi_array<float, 3> other_output(extents[2][24][24]);
+        ImmersedBoundaryFftInterface<2, float> other_interface(p_mesh, &other_input[0][0][0], &other_fourier[0][0][0],
+                                                               &other_output[0][0][0], 1, false, true);
+
+        // The upgraded plans are made for the real layout, so are swapped in
+        fft_interface.WaitForPlanUpgrade();
+        TS_ASSERT_EQUALS(fft_interface.WerePlansUpgraded(), true);
+        other_interface.WaitForPlanUpgrade();
+        TS_ASSERT_EQUALS(other_interface.WerePlansUpgraded(), true);
+
+        // The transforms are unnormalised, so a round trip scales the velocity grids by the number of grid points
+        multi_array<float, 3> expected(extents[2][56][56]);
+        for (unsigned dim = 0; dim < 3; dim++)
+        {
+            for (unsigned x = 0; x < 56; x++)
+            {
+                for (unsigned y = 0; y < 56; y++)
+                {
+                    input[dim][x][y] = (float) cos(0.2 * x - 0.3 * y + dim);
+                    if (dim < 2)
+                    {
+                        expected[dim][x][y] = 3136.0f * input[dim][x][y];
+                    }
+                }
+            }
+        }
+
+        fft_interface.FftExecuteForward();
+        fft_interface.FftExecuteInverse();
+
+        for (unsigned dim = 0; dim < 2; dim++)
+        {
+            for (unsigned x = 0; x < 56; x++)
+            {
+                for (unsigned y = 0; y < 56; y++)
+                {
+                    TS_ASSERT_DELTA(input[dim][x][y], expected[dim][x][y], 1e-2);
+                }
+            }
+        }
+    }
+
+    void TestWisdomIsCachedAfterPatientPlanning() throw(Exception)
+    {
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        p_mesh->SetNumGridPtsXAndY(40);
+
+        FileFinder cache_file(ImmersedBoundaryFftInterface<2>::GetWisdomCacheDirectory() + "/" +
+                              ImmersedBoundaryFftInterface<2>::GetWisdomCacheFilename(40, 40, 1, false),
+                              RelativeTo::ChasteTestOutput);
+        if (cache_file.IsFile())
+        {
+            cache_file.Remove();
+        }
+
+        multi_array<double, 3> input(extents[2][40][40]);
+        multi_array<std::complex<double>, 3> fourier(extents[2][40][21]);
+        multi_array<double, 3> output(extents[2][40][40]);
+
+        // Without fast start, a cache miss plans with FFTW_PATIENT straight away and writes the wisdom it found
+        {
+            ImmersedBoundaryFftInterface<2> fft_interface(p_mesh, &input[0][0][0], &fourier[0][0][0], &output[0][0][0],
+                                                          1, false, false);
+            TS_ASSERT_EQUALS(fft_interface.WasWisdomImportedFromCache(), false);
+        }
+        TS_ASSERT(cache_file.IsFile());
+
+        ImmersedBoundaryFftInterface<2> cached_interface(p_mesh, &input[0][0][0], &fourier[0][0][0], &output[0][0][0],
+                                                         1, false, false);
+        TS_ASSERT_EQUALS(cached_interface.WasWisdomImportedFromCache(), true);
+    }
+
+    void TestGetWisdomFilename() throw(Exception)
+    {
+        TS_ASSERT_EQUALS(ImmersedBoundaryFftInterface<2>::GetWisdomFilename(1), "fftw.wisdom");
+        TS_ASSERT_EQUALS(ImmersedBoundaryFftInterface<2>::GetWisdomFilename(2), "fftw_threads_2.wisdom");
+        TS_ASSERT_EQUALS(ImmersedBoundaryFftInterface<2>::GetWisdomFilename(32), "fftw_threads_32.wisdom");
+    }
+
+    void TestGetWisdomCacheFilename() throw(Exception)
+    {
+        TS_ASSERT_EQUALS(ImmersedBoundaryFftInterface<2>::GetWisdomCacheDirectory(), "ImmersedBoundaryFftwWisdom");
+
+        TS_ASSERT_EQUALS(ImmersedBoundaryFftInterface<2>::GetWisdomCacheFilename(256, 256, 1, false),
+                         "fftw_256x256_threads_1_howmany_2_nosources.wisdom");
+        TS_ASSERT_EQUALS(ImmersedBoundaryFftInterface<2>::GetWisdomCacheFilename(1024, 512, 8, true),
+                         "fftw_1024x512_threads_8_howmany_3_sources.wisdom");
+
+        // Single precision plans are cached separately from double precision plans
+        TS_ASSERT_EQUALS((ImmersedBoundaryFftInterface<2, float>::GetWisdomCacheFilename(256, 256, 1, false)),
+                         "fftwf_256x256_threads_1_howmany_2_nosources.wisdom");
+    }
+
+    void TestProlongSpectrally() throw(Exception)
+    {
+        // Periodic grids resolved on a coarse grid, including a Nyquist mode in x
+        const unsigned coarse_x = 8;
+        const unsigned coarse_y = 16;
+        const unsigned fine_x = 32;
+        const unsigned fine_y = 48;
+
+        multi_array<double, 3> coarse_grids(extents[2][coarse_x][coarse_y]);
+        for (unsigned x = 0; x < coarse_x; x++)
+        {
+            for (unsigned y = 0; y < coarse_y; y++)
+            {
+                double pos_x = (double) x / coarse_x;
+                double pos_y = (double) y / coarse_y;
+                coarse_grids[0][x][y] = 0.5 + cos(2.0 * M_PI * pos_x) * sin(6.0 * M_PI * pos_y);
+                coarse_grids[1][x][y] = sin(4.0 * M_PI * pos_x + 2.0 * M_PI * pos_y) + cos(8.0 * M_PI * pos_x);
+            }
+        }
+
+        multi_array<double, 3> fine_grids(extents[2][fine_x][fine_y]);
+        ImmersedBoundaryFftInterface<2>::ProlongSpectrally(coarse_grids, fine_grids);
+
+        // Every resolved mode is reproduced exactly, and the Nyquist mode is split between plus and minus frequencies
+        for (unsigned x = 0; x < fine_x; x++)
+        {
+            for (unsigned y = 0; y < fine_y; y++)
+            {
+                double pos_x = (double) x / fine_x;
+                double pos_y = (double) y / fine_y;
+                TS_ASSERT_DELTA(fine_grids[0][x][y], 0.5 + cos(2.0 * M_PI * pos_x) * sin(6.0 * M_PI * pos_y), 1e-12);
+                TS_ASSERT_DELTA(fine_grids[1][x][y], sin(4.0 * M_PI * pos_x + 2.0 * M_PI * pos_y) + cos(8.0 * M_PI * pos_x), 1e-12);
+            }
+        }
+
+        // The coarse grids are left alone
+        TS_ASSERT_DELTA(coarse_grids[0][0][0], 0.5, 1e-15);
+
+        // The fine grids must be at least as large, and as many
+        multi_array<double, 3> small_grids(extents[2][4][4]);
+        TS_ASSERT_THROWS_THIS(ImmersedBoundaryFftInterface<2>::ProlongSpectrally(coarse_grids, small_grids),
+                "Grids can only be prolonged onto as many grids with at least as many points in each direction, from an even number of points");
+        multi_array<double, 3> one_grid(extents[1][fine_x][fine_y]);
+        TS_ASSERT_THROWS_THIS(ImmersedBoundaryFftInterface<2>::ProlongSpectrally(coarse_grids, one_grid),
+                "Grids can only be prolonged onto as many grids with at least as many points in each direction, from an even number of points");
+    }
 };
@@ -0,0 +1,261 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TESTIMMERSEDBOUNDARYFLUIDREDUCERS_HPP_
+#define TESTIMMERSEDBOUNDARYFLUIDREDUCERS_HPP_
+
+// Needed for test framework
+#include <cxxtest/TestSuite.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Includes from trunk
+#include "OutputFileHandler.hpp"
+
+// Includes from projects/ImmersedBoundary
+#include "ImmersedBoundaryBlockAverageReducer.hpp"
+#include "ImmersedBoundaryEnergySpectrumReducer.hpp"
+#include "ImmersedBoundaryRegionReducer.hpp"
+#include "ImmersedBoundaryVorticityReducer.hpp"
+
+// This test is never run in parallel
+#include "FakePetscSetup.hpp"
+
+class TestImmersedBoundaryFluidReducers : public CxxTest::TestSuite
+{
+private:
+
+    /**
+     * Read the rows below the header of a file written by a reducer.
+     *
+     * @param rFileName the name of the file in the output directory of this test
+     * @return the values of each row
+     */
+    std::vector<std::vector<double> > ReadRows(const std::string& rFileName)
+    {
+        OutputFileHandler output_file_handler("TestImmersedBoundaryFluidReducers", false);
+        std::ifstream file((output_file_handler.GetOutputDirectoryFullPath() + rFileName).c_str());
+
+        std::vector<std::vector<double> > rows;
+        std::string line;
+        std::getline(file, line);
+        while (std::getline(file, line))
+        {
+            std::vector<double> row;
+            std::stringstream line_stream(line);
+            std::string value;
+            while (std::getline(line_stream, value, ','))
+            {
+                row.push_back(atof(value.c_str()));
+            }
+            rows.push_back(row);
+        }
+        return rows;
+    }
+
+public:
+
+    void TestBlockAverageReducer() throw(Exception)
+    {
+        TS_ASSERT_THROWS_THIS(ImmersedBoundaryBlockAverageReducer reducer(0), "The block size must be positive");
+
+        ImmersedBoundaryBlockAverageReducer reducer(4, "block.csv");
+        TS_ASSERT_EQUALS(reducer.GetBlockSize(), 4u);
+        TS_ASSERT_EQUALS(reducer.rGetFileName(), "block.csv");
+        TS_ASSERT_EQUALS(reducer.UsesFourierGrids(), false);
+
+        TS_ASSERT_THROWS_THIS(reducer.Setup("TestImmersedBoundaryFluidReducers", 8, 6),
+                              "The block size must divide the number of grid points in each direction");
+
+        // The x velocity increases with the x index, and the y velocity is uniform
+        multi_array<double, 3> vel_grids(extents[2][8][8]);
+        for (unsigned x = 0; x < 8; x++)
+        {
+            for (unsigned y = 0; y < 8; y++)
+            {
+                vel_grids[0][x][y] = double(x);
+                vel_grids[1][x][y] = 1.0;
+            }
+        }
+
+        reducer.Setup("TestImmersedBoundaryFluidReducers", 8, 8);
+        reducer.Reduce(3, 0.5, vel_grids);
+        TS_ASSERT_EQUALS(reducer.rGetWriter().GetNumRowsStreamed(), 4u);
+        reducer.Finish();
+
+        std::vector<std::vector<double> > rows = ReadRows("block.csv");
+        TS_ASSERT_EQUALS(rows.size(), 4u);
+        for (unsigned i = 0; i < rows.size(); i++)
+        {
+            TS_ASSERT_EQUALS(rows[i].size(), 6u);
+            TS_ASSERT_DELTA(rows[i][0], 3.0, 1e-12);
+            TS_ASSERT_DELTA(rows[i][3], 0.5, 1e-12);
+            TS_ASSERT_DELTA(rows[i][4], 4.0 * rows[i][1] + 1.5, 1e-9);
+            TS_ASSERT_DELTA(rows[i][5], 1.0, 1e-9);
+        }
+    }
+
+    void TestRegionReducer() throw(Exception)
+    {
+        TS_ASSERT_THROWS_THIS(ImmersedBoundaryRegionReducer reducer(0.5, 0.25, 0.0, 1.0),
+                              "The lower bounds of the region must not exceed its upper bounds");
+
+        // The region covers x indices 4 to 8 and y indices 0 to 2 of a 16 by 16 grid
+        ImmersedBoundaryRegionReducer reducer(0.25, 0.5, 0.0, 0.125);
+        reducer.Setup("TestImmersedBoundaryFluidReducers", 16, 16);
+        TS_ASSERT_EQUALS(reducer.GetNumGridPtsInRegion(), 15u);
+
+        multi_array<double, 3> vel_grids(extents[2][16][16]);
+        for (unsigned x = 0; x < 16; x++)
+        {
+            for (unsigned y = 0; y < 16; y++)
+            {
+                vel_grids[0][x][y] = double(x);
+                vel_grids[1][x][y] = double(y);
+            }
+        }
+
+        reducer.Reduce(0, 0.0, vel_grids);
+        reducer.Finish();
+
+        std::vector<std::vector<double> > rows = ReadRows("region_velocity.csv");
+        TS_ASSERT_EQUALS(rows.size(), 15u);
+        for (unsigned i = 0; i < rows.size(); i++)
+        {
+            TS_ASSERT_LESS_THAN_EQUALS(4.0, rows[i][1]);
+            TS_ASSERT_LESS_THAN_EQUALS(rows[i][1], 8.0);
+            TS_ASSERT_LESS_THAN_EQUALS(rows[i][2], 2.0);
+            TS_ASSERT_DELTA(rows[i][4], rows[i][1], 1e-12);
+            TS_ASSERT_DELTA(rows[i][5], rows[i][2], 1e-12);
+        }
+
+        // The region must lie in the domain, which may be rectangular
+        ImmersedBoundaryRegionReducer wide_reducer(0.0, 1.5, 0.0, 1.0, "wide.csv");
+        TS_ASSERT_THROWS_THIS(wide_reducer.Setup("TestImmersedBoundaryFluidReducers", 16, 8),
+                              "The region must lie in the domain");
+        wide_reducer.Setup("TestImmersedBoundaryFluidReducers", 32, 16, 2.0, 1.0);
+        TS_ASSERT_EQUALS(wide_reducer.GetNumGridPtsInRegion(), 25u * 16u);
+
+        // The whole unit square covers every grid point once
+        ImmersedBoundaryRegionReducer whole_reducer(0.0, 1.0, 0.0, 1.0, "whole.csv");
+        whole_reducer.Setup("TestImmersedBoundaryFluidReducers", 16, 8);
+        TS_ASSERT_EQUALS(whole_reducer.GetNumGridPtsInRegion(), 128u);
+    }
+
+    void TestVorticityReducer() throw(Exception)
+    {
+        // A shear flow u = sin(2 pi y) has vorticity -2 pi cos(2 pi y), up to the error of the central differences
+        const unsigned num_gridpts = 32;
+        const double spacing = 1.0 / num_gridpts;
+        multi_array<double, 3> vel_grids(extents[2][num_gridpts][num_gridpts]);
+        for (unsigned x = 0; x < num_gridpts; x++)
+        {
+            for (unsigned y = 0; y < num_gridpts; y++)
+            {
+                vel_grids[0][x][y] = sin(2.0 * M_PI * y * spacing);
+                vel_grids[1][x][y] = 0.0;
+            }
+        }
+
+        ImmersedBoundaryVorticityReducer reducer;
+        reducer.Setup("TestImmersedBoundaryFluidReducers", num_gridpts, num_gridpts);
+        reducer.Reduce(0, 0.0, vel_grids);
+
+        double amplitude = sin(2.0 * M_PI * spacing) / spacing;
+        TS_ASSERT_DELTA(reducer.GetMaxVorticity(), amplitude, 1e-9);
+        TS_ASSERT_DELTA(reducer.GetRmsVorticity(), amplitude / sqrt(2.0), 1e-9);
+        TS_ASSERT_LESS_THAN(reducer.GetMeanVorticity(), reducer.GetRmsVorticity());
+        TS_ASSERT_DELTA(reducer.GetMaxVorticity(), 2.0 * M_PI, 0.1);
+        TS_ASSERT_EQUALS(reducer.rGetWriter().GetNumRowsStreamed(), 1u);
+    }
+
+    void TestEnergySpectrumReducer() throw(Exception)
+    {
+        ImmersedBoundaryEnergySpectrumReducer reducer;
+        TS_ASSERT_EQUALS(reducer.UsesFourierGrids(), true);
+        reducer.Setup("TestImmersedBoundaryFluidReducers", 16, 16);
+
+        // The shells reach the corner mode, of wavenumber magnitude 8 root 2
+        TS_ASSERT_EQUALS(reducer.rGetShellEnergies().size(), 12u);
+
+        // Nothing is written until the Fourier grids have been reduced
+        multi_array<double, 3> vel_grids(extents[2][16][16]);
+        reducer.Reduce(0, 0.0, vel_grids);
+        TS_ASSERT_EQUALS(reducer.rGetWriter().GetNumRowsStreamed(), 0u);
+
+        // The coefficients of u = cos(2 pi 3 x), which is stored at both x = 3 and its negative, and v = sin(2 pi 4 y)
+        multi_array<std::complex<double>, 3> fourier_grids(extents[3][16][9]);
+        std::fill(fourier_grids.data(), fourier_grids.data() + fourier_grids.num_elements(), std::complex<double>(0.0, 0.0));
+        fourier_grids[0][3][0] = std::complex<double>(0.5, 0.0);
+        fourier_grids[0][13][0] = std::complex<double>(0.5, 0.0);
+        fourier_grids[1][0][4] = std::complex<double>(0.0, -0.5);
+
+        // Each component has mean kinetic energy 0.25, all in the shell of its wavenumber
+        reducer.ReduceFourierGrids(fourier_grids);
+        for (unsigned shell = 0; shell < reducer.rGetShellEnergies().size(); shell++)
+        {
+            double expected = (shell == 3 || shell == 4) ? 0.25 : 0.0;
+            TS_ASSERT_DELTA(reducer.rGetShellEnergies()[shell], expected, 1e-12);
+        }
+
+        reducer.Reduce(1, 0.1, vel_grids);
+        TS_ASSERT_EQUALS(reducer.rGetWriter().GetNumRowsStreamed(), 12u);
+
+        // The single precision grids give the same spectrum
+        multi_array<std::complex<float>, 3> float_grids(extents[3][16][9]);
+        std::fill(float_grids.data(), float_grids.data() + float_grids.num_elements(), std::complex<float>(0.0f, 0.0f));
+        float_grids[0][3][0] = std::complex<float>(0.5f, 0.0f);
+        float_grids[0][13][0] = std::complex<float>(0.5f, 0.0f);
+        float_grids[1][0][4] = std::complex<float>(0.0f, -0.5f);
+
+        reducer.ReduceFourierGrids(float_grids);
+        TS_ASSERT_DELTA(reducer.rGetShellEnergies()[3], 0.25, 1e-6);
+        TS_ASSERT_DELTA(reducer.rGetShellEnergies()[4], 0.25, 1e-6);
+        reducer.Finish();
+
+        std::vector<std::vector<double> > rows = ReadRows("energy_spectrum.csv");
+        TS_ASSERT_EQUALS(rows.size(), 12u);
+        TS_ASSERT_DELTA(rows[3][1], 3.0, 1e-12);
+        TS_ASSERT_DELTA(rows[3][3], 0.25, 1e-9);
+    }
+};
+
+#endif /*TESTIMMERSEDBOUNDARYFLUIDREDUCERS_HPP_*/
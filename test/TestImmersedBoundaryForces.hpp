@@ -39,6 +39,8 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "CheckpointArchiveTypes.hpp"
 #include "FileComparison.hpp"
 #include "CellsGenerator.hpp"
+#include "DifferentiatedCellProliferativeType.hpp"
+#include "SmartPointers.hpp"
 #include "UniformlyDistributedCellCycleModel.hpp"
 
 // Includes from projects/ImmersedBoundary
@@ -49,13 +51,254 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // This test is never run in parallel
 #include "FakePetscSetup.hpp"
 
+/**
+ * A force written node by node, against the overload of AddImmersedBoundaryForceContribution() taking Node pointers,
+ * used to test the adapter for such forces.
+ */
+class PerNodeTestForce : public AbstractImmersedBoundaryForce<2>
+{
+public:
+
+    using AbstractImmersedBoundaryForce<2>::AddImmersedBoundaryForceContribution;
+
+    /**
+     * Add a unit force in the x direction to each node.
+     *
+     * @param rNodePairs unused
+     * @param rCellPopulation the cell population
+     */
+    void AddImmersedBoundaryForceContribution(std::vector<std::pair<Node<2>*, Node<2>*> >& rNodePairs,
+                                              ImmersedBoundaryCellPopulation<2>& rCellPopulation)
+    {
+        c_vector<double, 2> force;
+        force[0] = 1.0;
+        force[1] = 0.0;
+        for (unsigned node_idx = 0; node_idx < rCellPopulation.GetNumNodes(); node_idx++)
+        {
+            rCellPopulation.GetNode(node_idx)->AddAppliedForceContribution(force);
+        }
+    }
+
+    /**
+     * Output force parameters (there are none).
+     *
+     * @param rParamsFile the file stream to which the parameters are output
+     */
+    void OutputImmersedBoundaryForceParameters(out_stream& rParamsFile)
+    {
+    }
+};
+
 class TestImmersedBoundaryForces : public CxxTest::TestSuite
 {
 public:
 
+    void TestPerNodeForceAdapter() throw (Exception)
+    {
+        ImmersedBoundaryPalisadeMeshGenerator gen(3, 50, 0.2, 2.0, 0.15, false);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+
+        for (unsigned node_idx = 0; node_idx < p_mesh->GetNumNodes(); node_idx++)
+        {
+            p_mesh->GetNode(node_idx)->ClearAppliedForce();
+        }
+        ImmersedBoundaryNodeArrays<2>& r_arrays = p_mesh->rGetNodeArrays();
+        r_arrays.ClearAppliedForces();
+
+        // By default, the bulk interface calls the per-node one, which adds contributions through the Node objects
+        PerNodeTestForce force;
+        TS_ASSERT_EQUALS(force.UsesNodeArrays(), false);
+        TS_ASSERT_EQUALS(force.UsesNodePairs(), true);
+
+        ImmersedBoundaryNodePairList<2> node_pairs(cell_population.GetInteractionDistance());
+        node_pairs.Build(r_arrays);
+        force.AddForceContributionsToNodeArrays(node_pairs, r_arrays, cell_population);
+
+        TS_ASSERT_DELTA(p_mesh->GetNode(0)->rGetAppliedForce()[0], 1.0, 1e-12);
+        TS_ASSERT_DELTA(r_arrays.GetAppliedForce(0)[0], 0.0, 1e-12);
+
+        // These contributions are then gathered into the node arrays
+        p_mesh->AddNodeAppliedForcesToNodeArrays();
+        for (unsigned slot = 0; slot < r_arrays.GetNumSlots(); slot++)
+        {
+            TS_ASSERT_DELTA(r_arrays.GetAppliedForce(slot)[0], 1.0, 1e-12);
+            TS_ASSERT_DELTA(r_arrays.GetAppliedForce(slot)[1], 0.0, 1e-12);
+        }
+    }
+
     void TestImmersedBoundaryCellCellInteractionForceMethods() throw (Exception)
     {
-        ///\todo Test this class
+        // Test GetNumThreads() and SetNumThreads()
+        ImmersedBoundaryCellCellInteractionForce<2> force;
+        TS_ASSERT_EQUALS(force.GetNumThreads(), 1u);
+        force.SetNumThreads(4);
+        TS_ASSERT_EQUALS(force.GetNumThreads(), 4u);
+        TS_ASSERT_EQUALS(force.UsesNodePairs(), true);
+
+        // Create a palisade of cells close enough to interact
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+        cell_population.SetInteractionDistance(0.02);
+
+        // Calculate the force with a single thread; the first call adds the protein attributes to each node
+        ImmersedBoundaryCellCellInteractionForce<2> serial_force;
+        ImmersedBoundaryNodePairList<2> node_pairs(cell_population.GetInteractionDistance());
+        node_pairs.Build(p_mesh->rGetNodeArrays());
+        TS_ASSERT_LESS_THAN(0u, node_pairs.GetNumPairs());
+
+        serial_force.AddImmersedBoundaryForceContribution(node_pairs, cell_population);
+        ImmersedBoundaryNodeArrays<2>& r_arrays = p_mesh->rGetNodeArrays();
+
+        r_arrays.ClearAppliedForces();
+        serial_force.AddImmersedBoundaryForceContribution(node_pairs, cell_population);
+
+        std::vector<double> serial_forces(2 * r_arrays.GetNumSlots());
+        double max_force = 0.0;
+        for (unsigned slot = 0; slot < r_arrays.GetNumSlots(); slot++)
+        {
+            serial_forces[2 * slot] = r_arrays.GetAppliedForce(slot)[0];
+            serial_forces[2 * slot + 1] = r_arrays.GetAppliedForce(slot)[1];
+            max_force = std::max(max_force, fabs(serial_forces[2 * slot]) + fabs(serial_forces[2 * slot + 1]));
+        }
+        TS_ASSERT_LESS_THAN(0.0, max_force);
+
+        // The constants cached for each pair are reused while the pair list is unchanged
+        r_arrays.ClearAppliedForces();
+        serial_force.AddImmersedBoundaryForceContribution(node_pairs, cell_population);
+        for (unsigned slot = 0; slot < r_arrays.GetNumSlots(); slot++)
+        {
+            TS_ASSERT_EQUALS(r_arrays.GetAppliedForce(slot)[0], serial_forces[2 * slot]);
+            TS_ASSERT_EQUALS(r_arrays.GetAppliedForce(slot)[1], serial_forces[2 * slot + 1]);
+        }
+
+        // The force on several threads differs only by rounding
+        force.AddImmersedBoundaryForceContribution(node_pairs, cell_population);
+        r_arrays.ClearAppliedForces();
+        force.AddImmersedBoundaryForceContribution(node_pairs, cell_population);
+        for (unsigned slot = 0; slot < r_arrays.GetNumSlots(); slot++)
+        {
+            TS_ASSERT_DELTA(r_arrays.GetAppliedForce(slot)[0], serial_forces[2 * slot], 1e-12 * max_force);
+            TS_ASSERT_DELTA(r_arrays.GetAppliedForce(slot)[1], serial_forces[2 * slot + 1], 1e-12 * max_force);
+        }
+
+        // With the deterministic reduction, the force is identical to that on one thread for any number of threads
+        TS_ASSERT_EQUALS(force.GetDeterministicReduction(), false);
+        force.SetDeterministicReduction(true);
+        TS_ASSERT_EQUALS(force.GetDeterministicReduction(), true);
+
+        force.SetNumThreads(1);
+        r_arrays.ClearAppliedForces();
+        force.AddImmersedBoundaryForceContribution(node_pairs, cell_population);
+        std::vector<double> single_thread_forces(2 * r_arrays.GetNumSlots());
+        for (unsigned slot = 0; slot < r_arrays.GetNumSlots(); slot++)
+        {
+            single_thread_forces[2 * slot] = r_arrays.GetAppliedForce(slot)[0];
+            single_thread_forces[2 * slot + 1] = r_arrays.GetAppliedForce(slot)[1];
+        }
+
+        for (unsigned num_threads = 2; num_threads <= 4; num_threads++)
+        {
+            force.SetNumThreads(num_threads);
+            r_arrays.ClearAppliedForces();
+            force.AddImmersedBoundaryForceContribution(node_pairs, cell_population);
+            for (unsigned slot = 0; slot < r_arrays.GetNumSlots(); slot++)
+            {
+                TS_ASSERT_EQUALS(r_arrays.GetAppliedForce(slot)[0], single_thread_forces[2 * slot]);
+                TS_ASSERT_EQUALS(r_arrays.GetAppliedForce(slot)[1], single_thread_forces[2 * slot + 1]);
+            }
+        }
+
+        // Changing the spring constant is taken into account, even though the pair list is unchanged
+        serial_force.SetSpringConstant(2.0 * serial_force.GetSpringConstant());
+        r_arrays.ClearAppliedForces();
+        serial_force.AddImmersedBoundaryForceContribution(node_pairs, cell_population);
+        for (unsigned slot = 0; slot < r_arrays.GetNumSlots(); slot++)
+        {
+            TS_ASSERT_DELTA(r_arrays.GetAppliedForce(slot)[0], 2.0 * serial_forces[2 * slot], 1e-12 * max_force);
+        }
+
+        // The overload taking Node pointers gives the same force, ignoring pairs of nodes in the same element
+        std::vector<std::pair<Node<2>*, Node<2>*> > pointer_pairs;
+        for (unsigned pair = 0; pair < node_pairs.GetNumPairs(); pair++)
+        {
+            pointer_pairs.push_back(std::make_pair(p_mesh->GetNode(node_pairs.rGetPair(pair).mNodeA),
+                                                   p_mesh->GetNode(node_pairs.rGetPair(pair).mNodeB)));
+        }
+        pointer_pairs.push_back(std::make_pair(p_mesh->GetElement(1)->GetNode(0), p_mesh->GetElement(1)->GetNode(1)));
+
+        r_arrays.ClearAppliedForces();
+        serial_force.AddImmersedBoundaryForceContribution(pointer_pairs, cell_population);
+        for (unsigned slot = 0; slot < r_arrays.GetNumSlots(); slot++)
+        {
+            TS_ASSERT_DELTA(r_arrays.GetAppliedForce(slot)[0], 2.0 * serial_forces[2 * slot], 1e-12 * max_force);
+            TS_ASSERT_DELTA(r_arrays.GetAppliedForce(slot)[1], 2.0 * serial_forces[2 * slot + 1], 1e-12 * max_force);
+        }
+    }
+
+    void TestCellCellInteractionForceKeepsEarlierForces() throw (Exception)
+    {
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+        cell_population.SetInteractionDistance(0.02);
+
+        ImmersedBoundaryNodePairList<2> node_pairs(cell_population.GetInteractionDistance());
+        node_pairs.Build(p_mesh->rGetNodeArrays());
+
+        // Forces calculated earlier in the timestep are already in the node arrays
+        ImmersedBoundaryNodeArrays<2>& r_arrays = p_mesh->rGetNodeArrays();
+        for (unsigned slot = 0; slot < r_arrays.GetNumSlots(); slot++)
+        {
+            r_arrays.GetAppliedForce(slot)[0] = 1.0;
+            r_arrays.GetAppliedForce(slot)[1] = (double) slot;
+        }
+
+        // The first call adds the protein attributes, which are mirrored without rebuilding the arrays
+        ImmersedBoundaryCellCellInteractionForce<2> force;
+        force.AddForceContributionsToNodeArrays(node_pairs, r_arrays, cell_population);
+        TS_ASSERT_EQUALS(&(p_mesh->rGetNodeArrays()), &r_arrays);
+        TS_ASSERT_EQUALS(r_arrays.GetNumAttributes(), p_mesh->GetNode(0)->GetNumNodeAttributes());
+        for (unsigned slot = 0; slot < r_arrays.GetNumSlots(); slot++)
+        {
+            Node<2>* p_node = p_mesh->GetNode(r_arrays.GetNodeIndex(slot));
+            for (unsigned attribute = 0; attribute < r_arrays.GetNumAttributes(); attribute++)
+            {
+                TS_ASSERT_EQUALS(r_arrays.GetAttributes(slot)[attribute], p_node->rGetNodeAttributes()[attribute]);
+            }
+        }
+
+        std::vector<double> total_forces(2 * r_arrays.GetNumSlots());
+        for (unsigned slot = 0; slot < r_arrays.GetNumSlots(); slot++)
+        {
+            total_forces[2 * slot] = r_arrays.GetAppliedForce(slot)[0];
+            total_forces[2 * slot + 1] = r_arrays.GetAppliedForce(slot)[1];
+        }
+
+        // The earlier forces were kept, and the interaction force added to them
+        r_arrays.ClearAppliedForces();
+        force.AddForceContributionsToNodeArrays(node_pairs, r_arrays, cell_population);
+        double max_force = 0.0;
+        for (unsigned slot = 0; slot < r_arrays.GetNumSlots(); slot++)
+        {
+            TS_ASSERT_DELTA(total_forces[2 * slot], 1.0 + r_arrays.GetAppliedForce(slot)[0], 1e-9);
+            TS_ASSERT_DELTA(total_forces[2 * slot + 1], slot + r_arrays.GetAppliedForce(slot)[1], 1e-9);
+            max_force = std::max(max_force, fabs(r_arrays.GetAppliedForce(slot)[0]));
+        }
+        TS_ASSERT_LESS_THAN(0.0, max_force);
     }
 
     void TestArchivingOfImmersedBoundaryCellCellInteractionForce() throw (Exception)
@@ -103,7 +346,69 @@ public:
 
     void TestImmersedBoundaryMembraneElasticityForce() throw (Exception)
     {
-        ///\todo Test this class
+        // Test GetNumThreads() and SetNumThreads()
+        ImmersedBoundaryMembraneElasticityForce<2> force;
+        TS_ASSERT_EQUALS(force.GetNumThreads(), 1u);
+        force.SetNumThreads(4);
+        TS_ASSERT_EQUALS(force.GetNumThreads(), 4u);
+
+        // The membrane force may be calculated while the node pairs are recalculated
+        TS_ASSERT_EQUALS(force.UsesNodePairs(), false);
+
+        // Create a palisade of cells above a basement lamina, which has many more nodes than any cell
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+
+        ImmersedBoundaryNodeArrays<2>& r_arrays = p_mesh->rGetNodeArrays();
+        ImmersedBoundaryNodePairList<2> node_pairs(cell_population.GetInteractionDistance());
+
+        // Calculate the force with a single thread
+        ImmersedBoundaryMembraneElasticityForce<2> serial_force;
+        r_arrays.ClearAppliedForces();
+        serial_force.AddForceContributionsToNodeArrays(node_pairs, r_arrays, cell_population);
+
+        std::vector<double> serial_forces(2 * r_arrays.GetNumSlots());
+        for (unsigned slot = 0; slot < r_arrays.GetNumSlots(); slot++)
+        {
+            serial_forces[2 * slot] = r_arrays.GetAppliedForce(slot)[0];
+            serial_forces[2 * slot + 1] = r_arrays.GetAppliedForce(slot)[1];
+        }
+
+        // The springs within each element exert no net force on it
+        for (unsigned elem_idx = 0; elem_idx < p_mesh->GetNumElements(); elem_idx++)
+        {
+            c_vector<double, 2> total_force = zero_vector<double>(2);
+            for (unsigned slot = r_arrays.GetElementBegin(elem_idx); slot < r_arrays.GetElementEnd(elem_idx); slot++)
+            {
+                total_force[0] += serial_forces[2 * slot];
+                total_force[1] += serial_forces[2 * slot + 1];
+            }
+            TS_ASSERT_DELTA(total_force[0], 0.0, 1e-6);
+            TS_ASSERT_DELTA(total_force[1], 0.0, 1e-6);
+        }
+
+        // The force is identical with several threads
+        r_arrays.ClearAppliedForces();
+        force.AddForceContributionsToNodeArrays(node_pairs, r_arrays, cell_population);
+        for (unsigned slot = 0; slot < r_arrays.GetNumSlots(); slot++)
+        {
+            TS_ASSERT_EQUALS(r_arrays.GetAppliedForce(slot)[0], serial_forces[2 * slot]);
+            TS_ASSERT_EQUALS(r_arrays.GetAppliedForce(slot)[1], serial_forces[2 * slot + 1]);
+        }
+
+        // Changing a parameter is taken into account, even though the element spacings are unchanged
+        force.SetSpringConstant(2.0 * force.GetSpringConstant());
+        r_arrays.ClearAppliedForces();
+        force.AddForceContributionsToNodeArrays(node_pairs, r_arrays, cell_population);
+        for (unsigned slot = 0; slot < r_arrays.GetNumSlots(); slot++)
+        {
+            TS_ASSERT_DELTA(r_arrays.GetAppliedForce(slot)[0], 2.0 * serial_forces[2 * slot], 1e-6 * fabs(serial_forces[2 * slot]) + 1e-9);
+        }
     }
 
     void TestArchivingOfImmersedBoundaryMembraneElasticityForce() throw (Exception)
@@ -0,0 +1,166 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef TESTIMMERSEDBOUNDARYHDF5GRIDWRITER_HPP_
+#define TESTIMMERSEDBOUNDARYHDF5GRIDWRITER_HPP_
+
+// Needed for test framework
+#include <cxxtest/TestSuite.h>
+
+// Includes from trunk
+#include "OutputFileHandler.hpp"
+
+// Includes from projects/ImmersedBoundary
+#include "ImmersedBoundaryHdf5GridWriter.hpp"
+
+// This test is never run in parallel
+#include "FakePetscSetup.hpp"
+
+class TestImmersedBoundaryHdf5GridWriter : public CxxTest::TestSuite
+{
+private:
+
+    /**
+     * Read a whole dataset of doubles from a file.
+     *
+     * @param rFileName the full path of the file
+     * @param rName the name of the dataset
+     * @param rDims filled with the extent of each dimension of the dataset
+     * @return the values in the dataset
+     */
+    std::vector<double> ReadDataset(const std::string& rFileName, const std::string& rName, std::vector<hsize_t>& rDims)
+    {
+        hid_t file = H5Fopen(rFileName.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+        hid_t dataset = H5Dopen2(file, rName.c_str(), H5P_DEFAULT);
+        hid_t space = H5Dget_space(dataset);
+
+        rDims.resize(H5Sget_simple_extent_ndims(space));
+        H5Sget_simple_extent_dims(space, &rDims[0], NULL);
+        std::vector<double> values(H5Sget_simple_extent_npoints(space));
+        H5Dread(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, &values[0]);
+
+        H5Sclose(space);
+        H5Dclose(dataset);
+        H5Fclose(file);
+        return values;
+    }
+
+public:
+
+    void TestWriteVelocityPressureAndForceSeries() throw(Exception)
+    {
+        unsigned num_x = 8;
+        unsigned num_y = 6;
+        unsigned reduced_y = num_y / 2 + 1;
+
+        multi_array<double, 3> vel_grids(extents[2][num_x][num_y]);
+        multi_array<double, 3> force_grids(extents[2][num_x][num_y]);
+        multi_array<std::complex<double>, 2> pressure_grid(extents[num_x][reduced_y]);
+
+        {
+            ImmersedBoundaryHdf5GridWriter writer("TestImmersedBoundaryHdf5GridWriter", "grids", num_x, num_y, true, true);
+            TS_ASSERT_EQUALS(writer.GetNumStepsWritten(), 0u);
+
+            for (unsigned step = 0; step < 3; step++)
+            {
+                for (unsigned dim = 0; dim < 2; dim++)
+                {
+                    for (unsigned x = 0; x < num_x; x++)
+                    {
+                        for (unsigned y = 0; y < num_y; y++)
+                        {
+                            vel_grids[dim][x][y] = 1000.0 * step + 100.0 * dim + 10.0 * x + y;
+                            force_grids[dim][x][y] = -vel_grids[dim][x][y];
+                        }
+                    }
+                }
+                for (unsigned x = 0; x < num_x; x++)
+                {
+                    for (unsigned y = 0; y < reduced_y; y++)
+                    {
+                        pressure_grid[x][y] = std::complex<double>(step + 0.1 * x, 0.01 * y);
+                    }
+                }
+
+                writer.WriteStep(0.5 * step, vel_grids, &force_grids, &pressure_grid);
+            }
+            TS_ASSERT_EQUALS(writer.GetNumStepsWritten(), 3u);
+
+            // Closing twice, here and in the destructor, is harmless
+            writer.Close();
+        }
+
+        OutputFileHandler handler("TestImmersedBoundaryHdf5GridWriter", false);
+        std::string file_name = handler.GetOutputDirectoryFullPath() + "grids.h5";
+
+        std::vector<hsize_t> dims;
+        std::vector<double> times = ReadDataset(file_name, "Time", dims);
+        TS_ASSERT_EQUALS(dims.size(), 1u);
+        TS_ASSERT_EQUALS(dims[0], 3u);
+        TS_ASSERT_DELTA(times[2], 1.0, 1e-12);
+
+        // Each step holds both velocity components, in the order of the grids
+        std::vector<double> velocities = ReadDataset(file_name, "Velocity", dims);
+        TS_ASSERT_EQUALS(dims.size(), 4u);
+        TS_ASSERT_EQUALS(dims[0], 3u);
+        TS_ASSERT_EQUALS(dims[1], 2u);
+        TS_ASSERT_EQUALS(dims[2], num_x);
+        TS_ASSERT_EQUALS(dims[3], num_y);
+        TS_ASSERT_DELTA(velocities[((1 * 2 + 1) * num_x + 3) * num_y + 4], 1134.0, 1e-12);
+        TS_ASSERT_DELTA(velocities[((2 * 2 + 0) * num_x + 7) * num_y + 5], 2075.0, 1e-12);
+
+        std::vector<double> forces = ReadDataset(file_name, "Force", dims);
+        TS_ASSERT_EQUALS(dims[0], 3u);
+        TS_ASSERT_DELTA(forces[((0 * 2 + 1) * num_x + 2) * num_y + 1], -121.0, 1e-12);
+
+        // The pressure is stored as the real and imaginary parts of each Fourier coefficient, and labelled as such
+        std::vector<double> pressures = ReadDataset(file_name, "PressureSpectrum", dims);
+        TS_ASSERT_EQUALS(dims.size(), 4u);
+        TS_ASSERT_EQUALS(dims[1], num_x);
+        TS_ASSERT_EQUALS(dims[2], reduced_y);
+        TS_ASSERT_EQUALS(dims[3], 2u);
+        TS_ASSERT_DELTA(pressures[((2 * num_x + 5) * reduced_y + 3) * 2 + 0], 2.5, 1e-12);
+        TS_ASSERT_DELTA(pressures[((2 * num_x + 5) * reduced_y + 3) * 2 + 1], 0.03, 1e-12);
+
+        hid_t file = H5Fopen(file_name.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+        hid_t dataset = H5Dopen2(file, "PressureSpectrum", H5P_DEFAULT);
+        TS_ASSERT(H5Aexists(dataset, "Description") > 0);
+        H5Dclose(dataset);
+        H5Fclose(file);
+    }
+};
+
+#endif /*TESTIMMERSEDBOUNDARYHDF5GRIDWRITER_HPP_*/
@@ -76,7 +76,55 @@ public:
 
     void TestGetVectorFromAtoB() throw(Exception)
     {
-
+        std::vector<Node<2>*> nodes;
+        nodes.push_back(new Node<2>(0, true, 0.1, 0.1));
+        nodes.push_back(new Node<2>(1, true, 0.2, 0.1));
+        nodes.push_back(new Node<2>(2, true, 0.2, 0.2));
+
+        std::vector<ImmersedBoundaryElement<2, 2>*> elems;
+        elems.push_back(new ImmersedBoundaryElement<2, 2>(0, nodes));
+
+        ImmersedBoundaryMesh<2, 2> mesh(nodes, elems);
+
+        c_vector<double, 2> location_a;
+        location_a[0] = 0.05;
+        location_a[1] = 0.05;
+
+        c_vector<double, 2> location_b;
+        location_b[0] = 0.95;
+        location_b[1] = 0.4;
+
+        // By default the domain is the periodic unit square
+        TS_ASSERT_DELTA(mesh.GetDomainWidth(), 1.0, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetDomainHeight(), 1.0, 1e-12);
+
+        c_vector<double, 2> vec = mesh.GetVectorFromAtoB(location_a, location_b);
+        TS_ASSERT_DELTA(vec[0], -0.1, 1e-12);
+        TS_ASSERT_DELTA(vec[1], 0.35, 1e-12);
+
+        // In a 2 x 0.5 domain, the x separation no longer wraps but the y separation does
+        mesh.SetDomainSize(2.0, 0.5);
+        TS_ASSERT_DELTA(mesh.GetDomainWidth(), 2.0, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetDomainHeight(), 0.5, 1e-12);
+
+        vec = mesh.GetVectorFromAtoB(location_a, location_b);
+        TS_ASSERT_DELTA(vec[0], 0.9, 1e-12);
+        TS_ASSERT_DELTA(vec[1], -0.15, 1e-12);
+
+        TS_ASSERT_THROWS_THIS(mesh.SetDomainSize(0.0, 1.0), "The domain width and height must be positive");
+
+        // Between walls normal to y the y separation no longer wraps, as the period is twice the domain height
+        TS_ASSERT_EQUALS(mesh.HasWalls(), false);
+        mesh.SetWalls(false, true);
+        TS_ASSERT_EQUALS(mesh.HasWalls(), true);
+        TS_ASSERT_EQUALS(mesh.HasWalls(0), false);
+        TS_ASSERT_EQUALS(mesh.HasWalls(1), true);
+        TS_ASSERT_DELTA(mesh.rGetPeriods()[0], 2.0, 1e-12);
+        TS_ASSERT_DELTA(mesh.rGetPeriods()[1], 1.0, 1e-12);
+
+        vec = mesh.GetVectorFromAtoB(location_a, location_b);
+        TS_ASSERT_DELTA(vec[0], 0.9, 1e-12);
+        TS_ASSERT_DELTA(vec[1], 0.35, 1e-12);
     }
 
     void TestGetSkewnessOfElementMassDistributionAboutAxis() throw(Exception)
@@ -136,4 +184,304 @@ public:
                             0.0, 1e-9);
         }
     }
+
+    void TestNodeArrays() throw(Exception)
+    {
+        // Two elements, whose nodes are not numbered in element order
+        std::vector<Node<2>*> nodes;
+        nodes.push_back(new Node<2>(0, true, 0.1, 0.1));
+        nodes.push_back(new Node<2>(1, true, 0.6, 0.1));
+        nodes.push_back(new Node<2>(2, true, 0.2, 0.1));
+        nodes.push_back(new Node<2>(3, true, 0.7, 0.1));
+        nodes.push_back(new Node<2>(4, true, 0.2, 0.2));
+        nodes.push_back(new Node<2>(5, true, 0.7, 0.2));
+
+        std::vector<Node<2>*> nodes_elem_0;
+        nodes_elem_0.push_back(nodes[0]);
+        nodes_elem_0.push_back(nodes[2]);
+        nodes_elem_0.push_back(nodes[4]);
+
+        std::vector<Node<2>*> nodes_elem_1;
+        nodes_elem_1.push_back(nodes[5]);
+        nodes_elem_1.push_back(nodes[3]);
+        nodes_elem_1.push_back(nodes[1]);
+
+        std::vector<ImmersedBoundaryElement<2,2>*> elems;
+        elems.push_back(new ImmersedBoundaryElement<2,2>(0, nodes_elem_0));
+        elems.push_back(new ImmersedBoundaryElement<2,2>(1, nodes_elem_1));
+
+        ImmersedBoundaryMesh<2,2> mesh(nodes, elems);
+
+        // Each element's nodes are stored contiguously and in order
+        ImmersedBoundaryNodeArrays<2>& r_arrays = mesh.rGetNodeArrays();
+        TS_ASSERT_EQUALS(r_arrays.GetNumSlots(), 6u);
+        TS_ASSERT_EQUALS(r_arrays.GetNumAttributes(), 0u);
+
+        for (unsigned elem_idx = 0; elem_idx < 2; elem_idx++)
+        {
+            ImmersedBoundaryElement<2,2>* p_elem = mesh.GetElement(elem_idx);
+            TS_ASSERT_EQUALS(r_arrays.GetElementEnd(elem_idx) - r_arrays.GetElementBegin(elem_idx), 3u);
+
+            for (unsigned node_idx = 0; node_idx < 3; node_idx++)
+            {
+                unsigned slot = r_arrays.GetElementBegin(elem_idx) + node_idx;
+                unsigned global_idx = p_elem->GetNodeGlobalIndex(node_idx);
+
+                TS_ASSERT_EQUALS(r_arrays.GetNodeIndex(slot), global_idx);
+                TS_ASSERT_EQUALS(r_arrays.GetSlotOfNode(global_idx), slot);
+                TS_ASSERT_EQUALS(r_arrays.GetElementIndex(slot), elem_idx);
+                TS_ASSERT_DELTA(r_arrays.GetLocation(slot)[0], p_elem->GetNode(node_idx)->rGetLocation()[0], 1e-12);
+                TS_ASSERT_DELTA(r_arrays.GetLocation(slot)[1], p_elem->GetNode(node_idx)->rGetLocation()[1], 1e-12);
+            }
+        }
+
+        // SetNode() updates the arrays as well as the node
+        ChastePoint<2> new_location(0.3, 0.4);
+        mesh.SetNode(3, new_location);
+        TS_ASSERT_DELTA(mesh.rGetNodeArrays().GetLocation(r_arrays.GetSlotOfNode(3))[0], 0.3, 1e-12);
+        TS_ASSERT_DELTA(mesh.rGetNodeArrays().GetLocation(r_arrays.GetSlotOfNode(3))[1], 0.4, 1e-12);
+
+        // Locations and forces changed through the arrays are copied back to the nodes on request
+        unsigned slot = r_arrays.GetSlotOfNode(4);
+        r_arrays.GetLocation(slot)[0] = 0.25;
+
+        c_vector<double, 2> force;
+        force[0] = 1.0;
+        force[1] = -2.0;
+        r_arrays.AddAppliedForceContribution(slot, force);
+        r_arrays.AddAppliedForceContribution(slot, force);
+
+        mesh.SynchroniseNodeLocations();
+        mesh.SynchroniseNodeAppliedForces();
+
+        TS_ASSERT_DELTA(mesh.GetNode(4)->rGetLocation()[0], 0.25, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetNode(4)->rGetAppliedForce()[0], 2.0, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetNode(4)->rGetAppliedForce()[1], -4.0, 1e-12);
+
+        // Forces added to the nodes are gathered into the arrays
+        r_arrays.ClearAppliedForces();
+        mesh.GetNode(1)->AddAppliedForceContribution(force);
+        mesh.AddNodeAppliedForcesToNodeArrays();
+        TS_ASSERT_DELTA(r_arrays.GetAppliedForce(r_arrays.GetSlotOfNode(1))[1], -2.0, 1e-12);
+        TS_ASSERT_DELTA(r_arrays.GetAppliedForce(r_arrays.GetSlotOfNode(0))[1], 0.0, 1e-12);
+    }
+
+    void TestElementGeometryCache() throw(Exception)
+    {
+        // Two anticlockwise squares, of side 0.2 and 0.1
+        std::vector<Node<2>*> nodes;
+        nodes.push_back(new Node<2>(0, true, 0.1, 0.1));
+        nodes.push_back(new Node<2>(1, true, 0.3, 0.1));
+        nodes.push_back(new Node<2>(2, true, 0.3, 0.3));
+        nodes.push_back(new Node<2>(3, true, 0.1, 0.3));
+        nodes.push_back(new Node<2>(4, true, 0.6, 0.6));
+        nodes.push_back(new Node<2>(5, true, 0.7, 0.6));
+        nodes.push_back(new Node<2>(6, true, 0.7, 0.7));
+        nodes.push_back(new Node<2>(7, true, 0.6, 0.7));
+
+        std::vector<Node<2>*> nodes_elem_0(nodes.begin(), nodes.begin() + 4);
+        std::vector<Node<2>*> nodes_elem_1(nodes.begin() + 4, nodes.end());
+
+        std::vector<ImmersedBoundaryElement<2,2>*> elems;
+        elems.push_back(new ImmersedBoundaryElement<2,2>(0, nodes_elem_0));
+        elems.push_back(new ImmersedBoundaryElement<2,2>(1, nodes_elem_1));
+
+        ImmersedBoundaryMesh<2,2> mesh(nodes, elems);
+
+        // The constructor uses the geometry of every element, which is calculated in a single pass
+        TS_ASSERT_EQUALS(mesh.GetNumElementGeometryUpdates(), 1u);
+
+        TS_ASSERT_DELTA(mesh.GetVolumeOfElement(0), 0.04, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetSurfaceAreaOfElement(0), 0.8, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetCentroidOfElement(0)[0], 0.2, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetCentroidOfElement(0)[1], 0.2, 1e-12);
+        TS_ASSERT_DELTA(mesh.CalculateMomentsOfElement(0)[0], 0.0016 / 12.0, 1e-12);
+        TS_ASSERT_DELTA(mesh.CalculateMomentsOfElement(0)[1], 0.0016 / 12.0, 1e-12);
+        TS_ASSERT_DELTA(mesh.CalculateMomentsOfElement(0)[2], 0.0, 1e-12);
+
+        TS_ASSERT_DELTA(mesh.GetVolumeOfElement(1), 0.01, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetCentroidOfElement(1)[0], 0.65, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetAverageNodeSpacingOfElement(0, false), 0.2, 1e-12);
+
+        // Requesting the geometry again does not recalculate it
+        TS_ASSERT_EQUALS(mesh.GetNumElementGeometryUpdates(), 1u);
+
+        // Moving a node with SetNode() recalculates only the elements containing it
+        ChastePoint<2> new_location(0.3, 0.5);
+        mesh.SetNode(2, new_location);
+        double new_perimeter = 0.2 + 0.4 + sqrt(0.08) + 0.2;
+        TS_ASSERT_DELTA(mesh.GetSurfaceAreaOfElement(0), new_perimeter, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetVolumeOfElement(0), 0.06, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetVolumeOfElement(1), 0.01, 1e-12);
+        TS_ASSERT_EQUALS(mesh.GetNumElementGeometryUpdates(), 1u);
+
+        // By default, the stored node spacing is not refreshed as the nodes move
+        TS_ASSERT_EQUALS(mesh.GetRefreshNodeSpacingWithGeometry(), false);
+        TS_ASSERT_DELTA(mesh.GetAverageNodeSpacingOfElement(0, false), 0.2, 1e-12);
+
+        // With this set, the stored node spacing is refreshed whenever the geometry is recalculated
+        mesh.SetRefreshNodeSpacingWithGeometry(true);
+        TS_ASSERT_EQUALS(mesh.GetRefreshNodeSpacingWithGeometry(), true);
+        TS_ASSERT_DELTA(mesh.GetVolumeOfElement(1), 0.01, 1e-12);
+        TS_ASSERT_EQUALS(mesh.GetNumElementGeometryUpdates(), 2u);
+        TS_ASSERT_DELTA(mesh.GetAverageNodeSpacingOfElement(0, false), 0.25 * new_perimeter, 1e-12);
+
+        // Moving nodes by other means requires the geometry to be invalidated
+        mesh.GetNode(6)->SetPoint(ChastePoint<2>(0.8, 0.7));
+        mesh.InvalidateElementGeometries();
+        TS_ASSERT_DELTA(mesh.GetVolumeOfElement(1), 0.015, 1e-12);
+        TS_ASSERT_EQUALS(mesh.GetNumElementGeometryUpdates(), 3u);
+    }
+
+    void TestPeriodicOverlaps() throw(Exception)
+    {
+        // A square straddling the left and right boundaries, and a square in the middle of the domain
+        std::vector<Node<2>*> nodes;
+        nodes.push_back(new Node<2>(0, true, 0.95, 0.1));
+        nodes.push_back(new Node<2>(1, true, 0.05, 0.1));
+        nodes.push_back(new Node<2>(2, true, 0.05, 0.2));
+        nodes.push_back(new Node<2>(3, true, 0.95, 0.2));
+        nodes.push_back(new Node<2>(4, true, 0.6, 0.6));
+        nodes.push_back(new Node<2>(5, true, 0.7, 0.6));
+        nodes.push_back(new Node<2>(6, true, 0.7, 0.7));
+        nodes.push_back(new Node<2>(7, true, 0.6, 0.7));
+
+        std::vector<Node<2>*> nodes_elem_0(nodes.begin(), nodes.begin() + 4);
+        std::vector<Node<2>*> nodes_elem_1(nodes.begin() + 4, nodes.end());
+
+        std::vector<ImmersedBoundaryElement<2,2>*> elems;
+        elems.push_back(new ImmersedBoundaryElement<2,2>(0, nodes_elem_0));
+        elems.push_back(new ImmersedBoundaryElement<2,2>(1, nodes_elem_1));
+
+        ImmersedBoundaryMesh<2,2> mesh(nodes, elems);
+
+        // Every element is calculated the first time
+        const ImmersedBoundaryPeriodicOverlaps<2>& r_overlaps = mesh.rGetPeriodicOverlaps();
+        TS_ASSERT_EQUALS(r_overlaps.GetNumElementsLastUpdated(), 2u);
+        TS_ASSERT_EQUALS(r_overlaps.GetNumElements(), 2u);
+
+        TS_ASSERT_EQUALS(r_overlaps.rGetHorizontalOverlapPoints(0).size(), 2u);
+        TS_ASSERT_EQUALS(r_overlaps.rGetHorizontalOverlapPoints(0)[0], 1u);
+        TS_ASSERT_EQUALS(r_overlaps.rGetHorizontalOverlapPoints(0)[1], 3u);
+        TS_ASSERT_EQUALS(r_overlaps.rGetVerticalOverlapPoints(0).size(), 0u);
+        TS_ASSERT_EQUALS(r_overlaps.rGetNumCellParts()[0], 2u);
+
+        TS_ASSERT_EQUALS(r_overlaps.rGetHorizontalOverlapPoints(1).size(), 0u);
+        TS_ASSERT_EQUALS(r_overlaps.rGetVerticalOverlapPoints(1).size(), 0u);
+        TS_ASSERT_EQUALS(r_overlaps.rGetNumCellParts()[1], 1u);
+
+        // Nothing is recalculated if no node has moved
+        mesh.rGetPeriodicOverlaps();
+        TS_ASSERT_EQUALS(r_overlaps.GetNumElementsLastUpdated(), 0u);
+
+        // Moving nodes with SetNode() recalculates only the element containing them
+        ChastePoint<2> location_6(0.7, 0.05);
+        ChastePoint<2> location_7(0.6, 0.05);
+        mesh.SetNode(6, location_6);
+        mesh.SetNode(7, location_7);
+        mesh.rGetPeriodicOverlaps();
+        TS_ASSERT_EQUALS(r_overlaps.GetNumElementsLastUpdated(), 1u);
+
+        TS_ASSERT_EQUALS(r_overlaps.rGetVerticalOverlapPoints(1).size(), 2u);
+        TS_ASSERT_EQUALS(r_overlaps.rGetVerticalOverlapPoints(1)[0], 0u);
+        TS_ASSERT_EQUALS(r_overlaps.rGetVerticalOverlapPoints(1)[1], 2u);
+        TS_ASSERT_EQUALS(r_overlaps.rGetNumCellParts()[1], 2u);
+        TS_ASSERT_EQUALS(r_overlaps.rGetNumCellParts()[0], 2u);
+
+        // Elements marked as stale, as by the cell population when a node wraps around, are recalculated
+        mesh.rGetModifiablePeriodicOverlaps().MarkElementStale(0);
+        mesh.rGetPeriodicOverlaps();
+        TS_ASSERT_EQUALS(r_overlaps.GetNumElementsLastUpdated(), 1u);
+        TS_ASSERT_EQUALS(r_overlaps.rGetNumCellParts()[0], 2u);
+
+        // The membrane never overlaps, and changing it recalculates every element
+        mesh.SetMembraneIndex(0);
+        mesh.rGetPeriodicOverlaps();
+        TS_ASSERT_EQUALS(r_overlaps.GetNumElementsLastUpdated(), 2u);
+        TS_ASSERT_EQUALS(r_overlaps.rGetHorizontalOverlapPoints(0).size(), 0u);
+        TS_ASSERT_EQUALS(r_overlaps.rGetNumCellParts()[0], 1u);
+        TS_ASSERT_EQUALS(r_overlaps.rGetNumCellParts()[1], 2u);
+    }
+
+    void TestRemeshElement() throw(Exception)
+    {
+        // An anticlockwise square of side 0.2 whose nodes are bunched together, and a small square of four nodes
+        std::vector<Node<2>*> nodes;
+        nodes.push_back(new Node<2>(0, true, 0.1, 0.1));
+        nodes.push_back(new Node<2>(1, true, 0.15, 0.1));
+        nodes.push_back(new Node<2>(2, true, 0.3, 0.1));
+        nodes.push_back(new Node<2>(3, true, 0.3, 0.3));
+        nodes.push_back(new Node<2>(4, true, 0.25, 0.3));
+        nodes.push_back(new Node<2>(5, true, 0.2, 0.3));
+        nodes.push_back(new Node<2>(6, true, 0.15, 0.3));
+        nodes.push_back(new Node<2>(7, true, 0.1, 0.3));
+        nodes.push_back(new Node<2>(8, true, 0.6, 0.6));
+        nodes.push_back(new Node<2>(9, true, 0.7, 0.6));
+        nodes.push_back(new Node<2>(10, true, 0.7, 0.7));
+        nodes.push_back(new Node<2>(11, true, 0.6, 0.7));
+        nodes[0]->SetRegion(7);
+
+        std::vector<Node<2>*> nodes_elem_0(nodes.begin(), nodes.begin() + 8);
+        std::vector<Node<2>*> nodes_elem_1(nodes.begin() + 8, nodes.end());
+
+        std::vector<ImmersedBoundaryElement<2,2>*> elems;
+        elems.push_back(new ImmersedBoundaryElement<2,2>(0, nodes_elem_0));
+        elems.push_back(new ImmersedBoundaryElement<2,2>(1, nodes_elem_1));
+
+        ImmersedBoundaryMesh<2,2> mesh(nodes, elems);
+
+        // Keeping the number of nodes spaces them evenly around the square, leaving the first where it is
+        mesh.RemeshElement(0);
+        TS_ASSERT_EQUALS(mesh.GetElement(0)->GetNumNodes(), 8u);
+        TS_ASSERT_EQUALS(mesh.GetNumNodes(), 12u);
+        TS_ASSERT_DELTA(mesh.GetElement(0)->GetNode(0)->rGetLocation()[0], 0.1, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetElement(0)->GetNode(1)->rGetLocation()[0], 0.2, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetElement(0)->GetNode(3)->rGetLocation()[0], 0.3, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetElement(0)->GetNode(3)->rGetLocation()[1], 0.2, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetElement(0)->GetNode(7)->rGetLocation()[0], 0.1, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetElement(0)->GetNode(7)->rGetLocation()[1], 0.2, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetSurfaceAreaOfElement(0), 0.8, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetAverageNodeSpacingOfElement(0, false), 0.1, 1e-12);
+
+        // Refining adds nodes to the end of the mesh, which take the region of the node preceding them
+        mesh.RemeshElement(0, 16);
+        TS_ASSERT_EQUALS(mesh.GetElement(0)->GetNumNodes(), 16u);
+        TS_ASSERT_EQUALS(mesh.GetNumNodes(), 20u);
+        TS_ASSERT_DELTA(mesh.GetElement(0)->GetNode(1)->rGetLocation()[0], 0.15, 1e-12);
+        TS_ASSERT_EQUALS(mesh.GetElement(0)->GetNode(1)->GetRegion(), 7u);
+        TS_ASSERT_EQUALS(mesh.GetElement(0)->GetNode(15)->GetIndex(), 19u);
+        TS_ASSERT_EQUALS(mesh.GetElement(0)->GetNode(15)->GetNumContainingElements(), 1u);
+        TS_ASSERT_DELTA(mesh.GetAverageNodeSpacingOfElement(0, false), 0.05, 1e-12);
+
+        // Coarsening removes nodes, and the remaining nodes are renumbered in order
+        mesh.RemeshElement(0, 4);
+        TS_ASSERT_EQUALS(mesh.GetElement(0)->GetNumNodes(), 4u);
+        TS_ASSERT_EQUALS(mesh.GetNumNodes(), 8u);
+        for (unsigned node_idx = 0; node_idx < mesh.GetNumNodes(); node_idx++)
+        {
+            TS_ASSERT_EQUALS(mesh.GetNode(node_idx)->GetIndex(), node_idx);
+        }
+        TS_ASSERT_DELTA(mesh.GetElement(1)->GetNode(0)->rGetLocation()[0], 0.6, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetElement(0)->GetNode(2)->rGetLocation()[0], 0.3, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetElement(0)->GetNode(2)->rGetLocation()[1], 0.3, 1e-12);
+        TS_ASSERT_DELTA(mesh.GetVolumeOfElement(0), 0.04, 1e-12);
+
+        // Remeshing every element to a target spacing
+        mesh.RemeshElements(0.05);
+        TS_ASSERT_EQUALS(mesh.GetElement(0)->GetNumNodes(), 16u);
+        TS_ASSERT_EQUALS(mesh.GetElement(1)->GetNumNodes(), 8u);
+        TS_ASSERT_EQUALS(mesh.GetNumNodes(), 24u);
+        TS_ASSERT_DELTA(mesh.GetAverageNodeSpacingOfElement(1, false), 0.05, 1e-12);
+
+        // Corner nodes stay where they are, and the other nodes are shared between the arcs either side of them
+        Node<2>* p_corner = mesh.GetElement(0)->GetNode(8);
+        mesh.GetElement(0)->rGetCornerNodes().push_back(p_corner);
+        mesh.RemeshElement(0, 6);
+        TS_ASSERT_EQUALS(mesh.GetElement(0)->GetNode(3), p_corner);
+        TS_ASSERT_DELTA(p_corner->rGetLocation()[0], 0.3, 1e-12);
+        TS_ASSERT_DELTA(p_corner->rGetLocation()[1], 0.3, 1e-12);
+
+        // An element cannot have fewer than three nodes
+        TS_ASSERT_THROWS_THIS(mesh.RemeshElement(1, 2), "Cannot remesh element 1 with 2 nodes");
+    }
 };
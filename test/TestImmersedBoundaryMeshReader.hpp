@@ -39,6 +39,9 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 // Needed for immersed boundary simulations
 #include <fftw3.h>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 
 // Includes from trunk
 #include "CellsGenerator.hpp"
@@ -55,6 +58,7 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "ImmersedBoundarySimulationModifier.hpp"
 #include "ImmersedBoundaryPalisadeMeshGenerator.hpp"
 #include "SuperellipseGenerator.hpp"
+#include "OutputFileHandler.hpp"
 
 // This test is never run in parallel
 #include "FakePetscSetup.hpp"
@@ -67,4 +71,236 @@ public:
     void TestNothingMuch() throw(Exception)
     {
     }
+
+    void TestBinaryMeshFormat() throw(Exception)
+    {
+        // Set up a mesh with a membrane and a non-trivial velocity grid
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        p_mesh->SetNumGridPtsXAndY(16);
+        multi_array<double, 3>& r_grids = p_mesh->rGetModifiable2dVelocityGrids();
+        for (unsigned i = 0; i < 16; i++)
+        {
+            for (unsigned j = 0; j < 16; j++)
+            {
+                r_grids[0][i][j] = sin(0.1 * i + 0.37 * j);
+                r_grids[1][i][j] = cos(0.23 * i - 0.19 * j);
+            }
+        }
+
+        // Only node 0 has an attribute, so no attributes are common to all nodes and none are written
+        p_mesh->GetNode(0)->AddNodeAttribute(1.0 / 3.0);
+
+        // Write the mesh in both formats
+        std::string output_directory = "TestBinaryMeshFormat";
+        ImmersedBoundaryMeshWriter<2,2> mesh_writer(output_directory, "palisade");
+        mesh_writer.WriteFilesUsingMesh(*p_mesh);
+        mesh_writer.WriteBinaryFilesUsingMesh(*p_mesh);
+
+        OutputFileHandler handler(output_directory, false);
+        std::string base_name = handler.GetOutputDirectoryFullPath() + "palisade";
+
+        // Read the binary file back, which should reproduce the mesh exactly
+        ImmersedBoundaryMeshReader<2,2> binary_reader(base_name, true);
+        TS_ASSERT(binary_reader.IsBinary());
+        TS_ASSERT_EQUALS(binary_reader.GetNumNodes(), p_mesh->GetNumNodes());
+        TS_ASSERT_EQUALS(binary_reader.GetNumElements(), p_mesh->GetNumElements());
+        TS_ASSERT_EQUALS(binary_reader.GetNumNodeAttributes(), 0u);
+
+        ImmersedBoundaryMesh<2,2> binary_mesh;
+        binary_mesh.ConstructFromMeshReader(binary_reader);
+
+        TS_ASSERT_EQUALS(binary_mesh.GetNumNodes(), p_mesh->GetNumNodes());
+        TS_ASSERT_EQUALS(binary_mesh.GetMembraneIndex(), p_mesh->GetMembraneIndex());
+        TS_ASSERT_EQUALS(binary_mesh.GetCharacteristicNodeSpacing(), p_mesh->GetCharacteristicNodeSpacing());
+        for (unsigned node_idx = 0; node_idx < p_mesh->GetNumNodes(); node_idx++)
+        {
+            TS_ASSERT_EQUALS(binary_mesh.GetNode(node_idx)->rGetLocation()[0], p_mesh->GetNode(node_idx)->rGetLocation()[0]);
+            TS_ASSERT_EQUALS(binary_mesh.GetNode(node_idx)->rGetLocation()[1], p_mesh->GetNode(node_idx)->rGetLocation()[1]);
+            TS_ASSERT_EQUALS(binary_mesh.GetNode(node_idx)->IsBoundaryNode(), p_mesh->GetNode(node_idx)->IsBoundaryNode());
+        }
+        for (unsigned elem_idx = 0; elem_idx < p_mesh->GetNumElements(); elem_idx++)
+        {
+            TS_ASSERT_EQUALS(binary_mesh.GetElement(elem_idx)->GetNumNodes(), p_mesh->GetElement(elem_idx)->GetNumNodes());
+            TS_ASSERT_EQUALS(binary_mesh.GetElement(elem_idx)->GetNodeGlobalIndex(3), p_mesh->GetElement(elem_idx)->GetNodeGlobalIndex(3));
+        }
+        TS_ASSERT_EQUALS(binary_mesh.GetNumGridPtsX(), 16u);
+        TS_ASSERT_EQUALS(binary_mesh.rGet2dVelocityGrids()[0][3][7], r_grids[0][3][7]);
+        TS_ASSERT_EQUALS(binary_mesh.rGet2dVelocityGrids()[1][11][2], r_grids[1][11][2]);
+
+        // Grid rows read from the binary file match those read from the text files
+        ImmersedBoundaryMeshReader<2,2> text_reader(base_name);
+        TS_ASSERT(!text_reader.IsBinary());
+        TS_ASSERT(text_reader.GetVelocityGridData() == NULL);
+        for (unsigned row = 0; row < 32; row++)
+        {
+            std::vector<double> binary_row = binary_reader.GetNextGridRow();
+            std::vector<double> text_row = text_reader.GetNextGridRow();
+            TS_ASSERT_EQUALS(binary_row.size(), text_row.size());
+            TS_ASSERT_DELTA(binary_row[5], text_row[5], 1e-5);
+        }
+
+        // Convert the binary file back to text files through a mesh
+        ImmersedBoundaryMeshWriter<2,2> text_writer(output_directory, "converted", false);
+        text_writer.WriteFilesUsingMesh(binary_mesh);
+
+        ImmersedBoundaryMeshReader<2,2> converted_reader(handler.GetOutputDirectoryFullPath() + "converted");
+        ImmersedBoundaryMesh<2,2> converted_mesh;
+        converted_mesh.ConstructFromMeshReader(converted_reader);
+        TS_ASSERT_EQUALS(converted_mesh.GetNumElements(), p_mesh->GetNumElements());
+        TS_ASSERT_DELTA(converted_mesh.GetNode(17)->rGetLocation()[0], p_mesh->GetNode(17)->rGetLocation()[0], 1e-5);
+
+        // A missing or malformed binary file is reported
+        TS_ASSERT_THROWS_CONTAINS(ImmersedBoundaryMeshReader<2,2> missing_reader(base_name + "_missing", true),
+                                  "Could not open data file");
+        {
+            out_stream p_file = handler.OpenOutputFile("not_a_mesh.ibm", std::ios::out | std::ios::binary);
+            std::string junk(ImmersedBoundaryBinaryMeshFormat::HEADER_SIZE, 'x');
+            p_file->write(junk.c_str(), junk.size());
+            p_file->close();
+        }
+        TS_ASSERT_THROWS_CONTAINS(ImmersedBoundaryMeshReader<2,2> junk_reader(handler.GetOutputDirectoryFullPath() + "not_a_mesh", true),
+                                  "is not a binary mesh file");
+
+        // A file of the right size whose element sections are corrupt is also reported, rather than read out of bounds
+        std::string contents;
+        {
+            std::ifstream in_file((base_name + ".ibm").c_str(), std::ios::in | std::ios::binary);
+            contents.assign((std::istreambuf_iterator<char>(in_file)), std::istreambuf_iterator<char>());
+        }
+        std::size_t num_doubles = 2 * (std::size_t)p_mesh->GetNumNodes() + 2 * 16 * 16;
+        std::size_t offsets_start = ImmersedBoundaryBinaryMeshFormat::HEADER_SIZE + num_doubles * sizeof(double)
+                                    + p_mesh->GetNumNodes() * sizeof(unsigned);
+        std::size_t node_indices_start = offsets_start + (p_mesh->GetNumElements() + 1) * sizeof(unsigned);
+
+        const unsigned bad_value = 1000000u;
+        std::string bad_index = contents;
+        memcpy(&bad_index[node_indices_start], &bad_value, sizeof(unsigned));
+        std::string bad_offset = contents;
+        memcpy(&bad_offset[offsets_start + sizeof(unsigned)], &bad_value, sizeof(unsigned));
+        {
+            out_stream p_file = handler.OpenOutputFile("bad_index.ibm", std::ios::out | std::ios::binary);
+            p_file->write(bad_index.c_str(), bad_index.size());
+            p_file->close();
+            p_file = handler.OpenOutputFile("bad_offset.ibm", std::ios::out | std::ios::binary);
+            p_file->write(bad_offset.c_str(), bad_offset.size());
+            p_file->close();
+        }
+        TS_ASSERT_THROWS_CONTAINS(ImmersedBoundaryMeshReader<2,2> bad_index_reader(handler.GetOutputDirectoryFullPath() + "bad_index", true),
+                                  "refers to node 1000000");
+        TS_ASSERT_THROWS_CONTAINS(ImmersedBoundaryMeshReader<2,2> bad_offset_reader(handler.GetOutputDirectoryFullPath() + "bad_offset", true),
+                                  "has a decreasing offset for element 1");
+    }
+
+    void TestParseTextFiles() throw(Exception)
+    {
+        // Set up a mesh with a membrane, a non-trivial velocity grid and node attributes
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        p_mesh->SetNumGridPtsXAndY(16);
+        multi_array<double, 3>& r_grids = p_mesh->rGetModifiable2dVelocityGrids();
+        for (unsigned i = 0; i < 16; i++)
+        {
+            for (unsigned j = 0; j < 16; j++)
+            {
+                r_grids[0][i][j] = sin(0.1 * i + 0.37 * j);
+                r_grids[1][i][j] = cos(0.23 * i - 0.19 * j);
+            }
+        }
+        for (unsigned node_idx = 0; node_idx < p_mesh->GetNumNodes(); node_idx++)
+        {
+            p_mesh->GetNode(node_idx)->AddNodeAttribute(0.5 * node_idx);
+        }
+
+        std::string output_directory = "TestParseTextFiles";
+        ImmersedBoundaryMeshWriter<2,2> mesh_writer(output_directory, "palisade");
+        mesh_writer.WriteFilesUsingMesh(*p_mesh);
+
+        OutputFileHandler handler(output_directory, false);
+        std::string base_name = handler.GetOutputDirectoryFullPath() + "palisade";
+
+        // Read the files a line at a time, and in one go with several threads
+        ImmersedBoundaryMeshReader<2,2> line_reader(base_name);
+        ImmersedBoundaryMeshReader<2,2> parsing_reader(base_name);
+        TS_ASSERT(!parsing_reader.AreDataInMemory());
+        TS_ASSERT(parsing_reader.GetNodeLocationData() == NULL);
+        parsing_reader.ParseTextFiles(4);
+        TS_ASSERT(parsing_reader.AreDataInMemory());
+        TS_ASSERT(!parsing_reader.IsBinary());
+        TS_ASSERT_EQUALS(parsing_reader.GetNumNodes(), line_reader.GetNumNodes());
+        TS_ASSERT_EQUALS(parsing_reader.GetNumElements(), line_reader.GetNumElements());
+        TS_ASSERT_EQUALS(parsing_reader.GetNumNodeAttributes(), 1u);
+        TS_ASSERT_EQUALS(parsing_reader.GetMembraneIndex(), p_mesh->GetMembraneIndex());
+
+        // The GetNext methods give the same data either way
+        for (unsigned node_idx = 0; node_idx < line_reader.GetNumNodes(); node_idx++)
+        {
+            std::vector<double> line_node = line_reader.GetNextNode();
+            std::vector<double> parsed_node = parsing_reader.GetNextNode();
+            TS_ASSERT_EQUALS(parsed_node.size(), line_node.size());
+            for (unsigned i = 0; i < line_node.size(); i++)
+            {
+                TS_ASSERT_EQUALS(parsed_node[i], line_node[i]);
+            }
+        }
+        for (unsigned elem_idx = 0; elem_idx < line_reader.GetNumElements(); elem_idx++)
+        {
+            ImmersedBoundaryElementData line_element = line_reader.GetNextImmersedBoundaryElementData();
+            ImmersedBoundaryElementData parsed_element = parsing_reader.GetNextImmersedBoundaryElementData();
+            TS_ASSERT(parsed_element.NodeIndices == line_element.NodeIndices);
+            TS_ASSERT_EQUALS(parsed_element.MembraneElement, line_element.MembraneElement);
+        }
+        for (unsigned row = 0; row < 32; row++)
+        {
+            std::vector<double> line_row = line_reader.GetNextGridRow();
+            std::vector<double> parsed_row = parsing_reader.GetNextGridRow();
+            TS_ASSERT_EQUALS(parsed_row.size(), line_row.size());
+            TS_ASSERT_EQUALS(parsed_row[5], line_row[5]);
+        }
+        TS_ASSERT_THROWS_CONTAINS(parsing_reader.GetNextNode(), "as all have been read");
+
+        // The mesh filled directly from the parsed data matches that constructed a line at a time
+        ImmersedBoundaryMesh<2,2> line_mesh;
+        line_mesh.ConstructFromMeshReader(line_reader);
+        ImmersedBoundaryMesh<2,2> parsed_mesh;
+        parsed_mesh.ConstructFromMeshReader(parsing_reader);
+
+        TS_ASSERT_EQUALS(parsed_mesh.GetNumNodes(), line_mesh.GetNumNodes());
+        TS_ASSERT_EQUALS(parsed_mesh.GetNumElements(), line_mesh.GetNumElements());
+        TS_ASSERT_EQUALS(parsed_mesh.GetMembraneIndex(), line_mesh.GetMembraneIndex());
+        TS_ASSERT_EQUALS(parsed_mesh.GetCharacteristicNodeSpacing(), line_mesh.GetCharacteristicNodeSpacing());
+        for (unsigned node_idx = 0; node_idx < line_mesh.GetNumNodes(); node_idx++)
+        {
+            TS_ASSERT_EQUALS(parsed_mesh.GetNode(node_idx)->rGetLocation()[0], line_mesh.GetNode(node_idx)->rGetLocation()[0]);
+            TS_ASSERT_EQUALS(parsed_mesh.GetNode(node_idx)->rGetLocation()[1], line_mesh.GetNode(node_idx)->rGetLocation()[1]);
+            TS_ASSERT_EQUALS(parsed_mesh.GetNode(node_idx)->IsBoundaryNode(), line_mesh.GetNode(node_idx)->IsBoundaryNode());
+            TS_ASSERT_EQUALS(parsed_mesh.GetNode(node_idx)->rGetNodeAttributes()[0], line_mesh.GetNode(node_idx)->rGetNodeAttributes()[0]);
+        }
+        for (unsigned elem_idx = 0; elem_idx < line_mesh.GetNumElements(); elem_idx++)
+        {
+            TS_ASSERT_EQUALS(parsed_mesh.GetElement(elem_idx)->GetNumNodes(), line_mesh.GetElement(elem_idx)->GetNumNodes());
+            TS_ASSERT_EQUALS(parsed_mesh.GetElement(elem_idx)->GetNodeGlobalIndex(3), line_mesh.GetElement(elem_idx)->GetNodeGlobalIndex(3));
+        }
+        TS_ASSERT_EQUALS(parsed_mesh.rGet2dVelocityGrids()[0][3][7], line_mesh.rGet2dVelocityGrids()[0][3][7]);
+        TS_ASSERT_EQUALS(parsed_mesh.rGet2dVelocityGrids()[1][11][2], line_mesh.rGet2dVelocityGrids()[1][11][2]);
+
+        // A node file with fewer nodes than its header describes is reported
+        {
+            out_stream p_file = handler.OpenOutputFile("truncated.node");
+            *p_file << "3 2 0 0.1\n0 0.1 0.2 0 # a comment\n\n1 0.3 0.4 1\n";
+            p_file->close();
+        }
+        {
+            out_stream p_file = handler.OpenOutputFile("truncated.cell");
+            *p_file << "0 0\n";
+            p_file->close();
+        }
+        {
+            out_stream p_file = handler.OpenOutputFile("truncated.grid");
+            *p_file << "0 0\n";
+            p_file->close();
+        }
+        ImmersedBoundaryMeshReader<2,2> truncated_reader(handler.GetOutputDirectoryFullPath() + "truncated");
+        TS_ASSERT_THROWS_CONTAINS(truncated_reader.ParseTextFiles(), "has fewer nodes than its header describes");
+    }
 };
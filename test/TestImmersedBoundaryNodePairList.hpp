@@ -0,0 +1,369 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TESTIMMERSEDBOUNDARYNODEPAIRLIST_HPP_
+#define TESTIMMERSEDBOUNDARYNODEPAIRLIST_HPP_
+
+// Needed for test framework
+#include <cxxtest/TestSuite.h>
+
+#include <climits>
+#include <cstdlib>
+#include <set>
+
+// Includes from projects/ImmersedBoundary
+#include "ImmersedBoundaryNodePairList.hpp"
+#include "RandomNumberGenerator.hpp"
+
+// This test is never run in parallel
+#include "FakePetscSetup.hpp"
+
+class TestImmersedBoundaryNodePairList : public CxxTest::TestSuite
+{
+private:
+
+    /**
+     * Fill node arrays with the given elements, each a list of consecutively numbered nodes.
+     */
+    void FillArrays(ImmersedBoundaryNodeArrays<2>& rArrays,
+                    const std::vector<std::vector<c_vector<double, 2> > >& rElements)
+    {
+        unsigned num_nodes = 0;
+        for (unsigned elem_idx = 0; elem_idx < rElements.size(); elem_idx++)
+        {
+            num_nodes += rElements[elem_idx].size();
+        }
+
+        rArrays.Reset(num_nodes, rElements.size(), 0);
+
+        c_vector<double, 2> zero_force = zero_vector<double>(2);
+        std::vector<double> no_attributes;
+
+        unsigned node_idx = 0;
+        for (unsigned elem_idx = 0; elem_idx < rElements.size(); elem_idx++)
+        {
+            rArrays.BeginElement(elem_idx);
+            for (unsigned local_idx = 0; local_idx < rElements[elem_idx].size(); local_idx++)
+            {
+                rArrays.AddNode(node_idx++, rElements[elem_idx][local_idx], zero_force, no_attributes);
+            }
+        }
+    }
+
+    /**
+     * @return a location with the given coordinates
+     */
+    c_vector<double, 2> Location(double x, double y)
+    {
+        c_vector<double, 2> location;
+        location[0] = x;
+        location[1] = y;
+        return location;
+    }
+
+    /**
+     * @return the pairs of nodes in a list, each ordered by node index, checking the elements of each pair
+     */
+    std::set<std::pair<unsigned, unsigned> > GetPairSet(const ImmersedBoundaryNodePairList<2>& rList,
+                                                        const ImmersedBoundaryNodeArrays<2>& rArrays)
+    {
+        std::set<std::pair<unsigned, unsigned> > pairs;
+        for (unsigned pair = 0; pair < rList.GetNumPairs(); pair++)
+        {
+            const ImmersedBoundaryNodePairList<2>::NodePair& r_pair = rList.rGetPair(pair);
+            TS_ASSERT_EQUALS(r_pair.mElementA, rArrays.GetElementIndex(rArrays.GetSlotOfNode(r_pair.mNodeA)));
+            TS_ASSERT_EQUALS(r_pair.mElementB, rArrays.GetElementIndex(rArrays.GetSlotOfNode(r_pair.mNodeB)));
+            pairs.insert(std::make_pair(std::min(r_pair.mNodeA, r_pair.mNodeB), std::max(r_pair.mNodeA, r_pair.mNodeB)));
+        }
+        return pairs;
+    }
+
+public:
+
+    void TestConstructorAndBoxes() throw(Exception)
+    {
+        ImmersedBoundaryNodePairList<2> small_cutoff(0.1);
+        TS_ASSERT_DELTA(small_cutoff.GetCutoff(), 0.1, 1e-12);
+        TS_ASSERT_EQUALS(small_cutoff.GetNumBoxesX(), 10u);
+        TS_ASSERT_EQUALS(small_cutoff.GetNumBoxesY(), 10u);
+        TS_ASSERT_EQUALS(small_cutoff.GetNumPairs(), 0u);
+
+        // Boxes are never narrower than the cutoff
+        ImmersedBoundaryNodePairList<2> awkward_cutoff(0.3);
+        TS_ASSERT_EQUALS(awkward_cutoff.GetNumBoxesX(), 3u);
+
+        // With fewer than three boxes per side, a single box is used instead
+        ImmersedBoundaryNodePairList<2> large_cutoff(0.4);
+        TS_ASSERT_EQUALS(large_cutoff.GetNumBoxesX(), 1u);
+        TS_ASSERT_EQUALS(large_cutoff.GetNumBoxesY(), 1u);
+
+        // In a rectangular domain the number of boxes is chosen separately along each axis
+        ImmersedBoundaryNodePairList<2> rectangular(0.1, 2.0, 0.25);
+        TS_ASSERT_EQUALS(rectangular.GetNumBoxesX(), 20u);
+        TS_ASSERT_EQUALS(rectangular.GetNumBoxesY(), 1u);
+    }
+
+    void TestPairsAreBetweenElementsAndWithinCutoff() throw(Exception)
+    {
+        // Element 0 has two close nodes; element 1 has one node close to each of them, and one far away
+        std::vector<std::vector<c_vector<double, 2> > > elements(2);
+        elements[0].push_back(Location(0.50, 0.50));
+        elements[0].push_back(Location(0.52, 0.50));
+        elements[1].push_back(Location(0.50, 0.55));
+        elements[1].push_back(Location(0.565, 0.50));
+        elements[1].push_back(Location(0.90, 0.90));
+
+        ImmersedBoundaryNodeArrays<2> arrays;
+        FillArrays(arrays, elements);
+
+        ImmersedBoundaryNodePairList<2> pair_list(0.06);
+        pair_list.Build(arrays);
+
+        // Pairs within the same element, and the far node, are excluded; node 1 to node 2 is 0.054 apart
+        std::set<std::pair<unsigned, unsigned> > found;
+        for (unsigned pair = 0; pair < pair_list.GetNumPairs(); pair++)
+        {
+            const ImmersedBoundaryNodePairList<2>::NodePair& r_pair = pair_list.rGetPair(pair);
+            TS_ASSERT_DIFFERS(r_pair.mElementA, r_pair.mElementB);
+            TS_ASSERT_LESS_THAN(r_pair.mSquaredDistance, 0.06 * 0.06);
+            found.insert(std::make_pair(std::min(r_pair.mNodeA, r_pair.mNodeB), std::max(r_pair.mNodeA, r_pair.mNodeB)));
+        }
+
+        TS_ASSERT_EQUALS(pair_list.GetNumPairs(), 3u);
+        TS_ASSERT_EQUALS(found.size(), 3u);
+        TS_ASSERT_EQUALS(found.count(std::make_pair(0u, 2u)), 1u);
+        TS_ASSERT_EQUALS(found.count(std::make_pair(0u, 3u)), 0u);
+        TS_ASSERT_EQUALS(found.count(std::make_pair(1u, 2u)), 1u);
+        TS_ASSERT_EQUALS(found.count(std::make_pair(1u, 3u)), 1u);
+        TS_ASSERT_EQUALS(found.count(std::make_pair(0u, 1u)), 0u);
+
+        // The far node lies away from the bounding box of element 0, so is never binned
+        TS_ASSERT_EQUALS(pair_list.rGetElementBroadPhase().GetNumOverlappingPairs(), 1u);
+        TS_ASSERT_EQUALS(pair_list.GetNumCandidateSlots(), 4u);
+
+        // Shrinking the cutoff removes the pairs further apart than it
+        ImmersedBoundaryNodePairList<2> small_list(0.052);
+        small_list.Build(arrays);
+        TS_ASSERT_EQUALS(small_list.GetNumPairs(), 2u);
+    }
+
+    void TestPeriodicPairs() throw(Exception)
+    {
+        // Pairs of nodes close across each boundary, and across the corner
+        std::vector<std::vector<c_vector<double, 2> > > elements(4);
+        elements[0].push_back(Location(0.01, 0.01));
+        elements[1].push_back(Location(0.99, 0.01));
+        elements[2].push_back(Location(0.01, 0.99));
+        elements[3].push_back(Location(0.99, 0.99));
+
+        ImmersedBoundaryNodeArrays<2> arrays;
+        FillArrays(arrays, elements);
+
+        // Every pair is within the cutoff, whether there are many boxes or just one
+        for (unsigned i = 0; i < 2; i++)
+        {
+            ImmersedBoundaryNodePairList<2> pair_list(i == 0 ? 0.05 : 0.5);
+            pair_list.Build(arrays);
+            TS_ASSERT_EQUALS(pair_list.GetNumPairs(), 6u);
+        }
+    }
+
+    void TestPeriodicPairsInRectangularDomain() throw(Exception)
+    {
+        // In a 2 x 0.5 domain, the nodes at x = 0.01 and x = 1.99 are close across the boundary, while the nodes at
+        // x = 0.99 and x = 1.01 are close across the middle of the domain, where the unit square would wrap
+        std::vector<std::vector<c_vector<double, 2> > > elements(4);
+        elements[0].push_back(Location(0.01, 0.01));
+        elements[1].push_back(Location(1.99, 0.49));
+        elements[2].push_back(Location(0.99, 0.25));
+        elements[3].push_back(Location(1.01, 0.25));
+
+        ImmersedBoundaryNodeArrays<2> arrays;
+        FillArrays(arrays, elements);
+        arrays.SetPeriods(Location(2.0, 0.5));
+
+        double vec[2];
+        arrays.GetVectorFromAtoB(arrays.GetSlotOfNode(0), arrays.GetSlotOfNode(1), vec);
+        TS_ASSERT_DELTA(vec[0], -0.02, 1e-12);
+        TS_ASSERT_DELTA(vec[1], -0.02, 1e-12);
+
+        // The same pairs are found whether there are many boxes or just one
+        for (unsigned i = 0; i < 2; i++)
+        {
+            ImmersedBoundaryNodePairList<2> pair_list(i == 0 ? 0.05 : 0.5, 2.0, 0.5);
+            pair_list.Build(arrays);
+
+            std::set<std::pair<unsigned, unsigned> > pairs = GetPairSet(pair_list, arrays);
+            TS_ASSERT_EQUALS(pairs.size(), 2u);
+            TS_ASSERT_EQUALS(pairs.count(std::make_pair(0u, 1u)), 1u);
+            TS_ASSERT_EQUALS(pairs.count(std::make_pair(2u, 3u)), 1u);
+        }
+    }
+
+    void TestPairsAreIndependentOfThreads() throw(Exception)
+    {
+        // Many small elements scattered at random
+        RandomNumberGenerator* p_gen = RandomNumberGenerator::Instance();
+        p_gen->Reseed(0);
+
+        std::vector<std::vector<c_vector<double, 2> > > elements(50);
+        for (unsigned elem_idx = 0; elem_idx < elements.size(); elem_idx++)
+        {
+            double centre_x = p_gen->ranf();
+            double centre_y = p_gen->ranf();
+            for (unsigned node_idx = 0; node_idx < 10; node_idx++)
+            {
+                elements[elem_idx].push_back(Location(centre_x + 0.05 * p_gen->ranf(), centre_y + 0.05 * p_gen->ranf()));
+            }
+        }
+
+        ImmersedBoundaryNodeArrays<2> arrays;
+        FillArrays(arrays, elements);
+
+        ImmersedBoundaryNodePairList<2> serial_list(0.03);
+        serial_list.Build(arrays, 1);
+
+        ImmersedBoundaryNodePairList<2> threaded_list(0.03);
+        threaded_list.Build(arrays, 4);
+
+        // Compare against checking every pair directly
+        unsigned num_expected = 0;
+        for (unsigned slot_a = 0; slot_a < arrays.GetNumSlots(); slot_a++)
+        {
+            for (unsigned slot_b = slot_a + 1; slot_b < arrays.GetNumSlots(); slot_b++)
+            {
+                double squared_distance = 0.0;
+                for (unsigned dim = 0; dim < 2; dim++)
+                {
+                    double difference = arrays.GetLocation(slot_b)[dim] - arrays.GetLocation(slot_a)[dim];
+                    difference -= floor(difference + 0.5);
+                    squared_distance += difference * difference;
+                }
+                if (arrays.GetElementIndex(slot_a) != arrays.GetElementIndex(slot_b) && squared_distance < 0.03 * 0.03)
+                {
+                    num_expected++;
+                }
+            }
+        }
+
+        TS_ASSERT_LESS_THAN(0u, num_expected);
+        TS_ASSERT_EQUALS(serial_list.GetNumPairs(), num_expected);
+        TS_ASSERT_EQUALS(threaded_list.GetNumPairs(), num_expected);
+
+        // The order of pairs is the same too
+        for (unsigned pair = 0; pair < serial_list.GetNumPairs(); pair++)
+        {
+            TS_ASSERT_EQUALS(serial_list.rGetPair(pair).mNodeA, threaded_list.rGetPair(pair).mNodeA);
+            TS_ASSERT_EQUALS(serial_list.rGetPair(pair).mNodeB, threaded_list.rGetPair(pair).mNodeB);
+        }
+    }
+
+    void TestIncrementalUpdate() throw(Exception)
+    {
+        // With many boxes, and with just one
+        for (unsigned i = 0; i < 2; i++)
+        {
+            double cutoff = i == 0 ? 0.03 : 0.4;
+
+            RandomNumberGenerator* p_gen = RandomNumberGenerator::Instance();
+            p_gen->Reseed(0);
+
+            std::vector<std::vector<c_vector<double, 2> > > elements(30);
+            for (unsigned elem_idx = 0; elem_idx < elements.size(); elem_idx++)
+            {
+                double centre_x = p_gen->ranf();
+                double centre_y = p_gen->ranf();
+                for (unsigned node_idx = 0; node_idx < 10; node_idx++)
+                {
+                    elements[elem_idx].push_back(Location(centre_x + 0.05 * p_gen->ranf(), centre_y + 0.05 * p_gen->ranf()));
+                }
+            }
+
+            ImmersedBoundaryNodeArrays<2> arrays;
+            FillArrays(arrays, elements);
+
+            ImmersedBoundaryNodePairList<2> pair_list(cutoff);
+            pair_list.Build(arrays);
+
+            // Divide element 3: its nodes move to one side, and a new element with new nodes appears on the other
+            std::vector<c_vector<double, 2> > daughter;
+            for (unsigned node_idx = 0; node_idx < 10; node_idx++)
+            {
+                c_vector<double, 2> location = elements[3][node_idx];
+                elements[3][node_idx] = Location(location[0] - 0.01, location[1]);
+                daughter.push_back(Location(location[0] + 0.01, location[1]));
+            }
+            elements.push_back(daughter);
+            FillArrays(arrays, elements);
+
+            ImmersedBoundaryTopologyChanges changes;
+            changes.RecordChangedElement(3);
+            changes.RecordChangedElement(30);
+            pair_list.Update(arrays, changes);
+            TS_ASSERT_EQUALS(pair_list.GetNumBuilds(), 2u);
+
+            ImmersedBoundaryNodePairList<2> built_list(cutoff);
+            built_list.Build(arrays);
+            TS_ASSERT_LESS_THAN(0u, built_list.GetNumPairs());
+            TS_ASSERT_EQUALS(pair_list.GetNumPairs(), built_list.GetNumPairs());
+            TS_ASSERT(GetPairSet(pair_list, arrays) == GetPairSet(built_list, arrays));
+
+            // Remove element 0, so that every other node and element is renumbered
+            std::vector<unsigned> new_node_indices(arrays.GetNumNodes());
+            for (unsigned node_idx = 0; node_idx < new_node_indices.size(); node_idx++)
+            {
+                new_node_indices[node_idx] = node_idx < 10 ? UINT_MAX : node_idx - 10;
+            }
+            std::vector<unsigned> new_element_indices(elements.size());
+            for (unsigned elem_idx = 0; elem_idx < new_element_indices.size(); elem_idx++)
+            {
+                new_element_indices[elem_idx] = elem_idx == 0 ? UINT_MAX : elem_idx - 1;
+            }
+            elements.erase(elements.begin());
+            FillArrays(arrays, elements);
+
+            changes.Clear();
+            changes.RecordDeletedElement();
+            changes.RecordRenumbering(new_node_indices, new_element_indices);
+            pair_list.Update(arrays, changes);
+
+            built_list.Build(arrays);
+            TS_ASSERT_EQUALS(pair_list.GetNumPairs(), built_list.GetNumPairs());
+            TS_ASSERT(GetPairSet(pair_list, arrays) == GetPairSet(built_list, arrays));
+        }
+    }
+};
+
+#endif /*TESTIMMERSEDBOUNDARYNODEPAIRLIST_HPP_*/
@@ -0,0 +1,195 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TESTIMMERSEDBOUNDARYOBJECTPOOL_HPP_
+#define TESTIMMERSEDBOUNDARYOBJECTPOOL_HPP_
+
+// Needed for test framework
+#include <cxxtest/TestSuite.h>
+
+// Includes from projects/ImmersedBoundary
+#include "ImmersedBoundaryObjectPool.hpp"
+
+// This test is never run in parallel
+#include "FakePetscSetup.hpp"
+
+/** A simple class recording how many of its objects have been destroyed. */
+class PooledTestObject
+{
+public:
+
+    /** The index of the object. */
+    unsigned mIndex;
+
+    /** The value of the object. */
+    double mValue;
+
+    /** Pointer to the count of destroyed objects. */
+    unsigned* mpNumDestroyed;
+
+    /**
+     * Constructor.
+     *
+     * @param index the index of the object
+     * @param value the value of the object
+     * @param pNumDestroyed pointer to the count of destroyed objects
+     */
+    PooledTestObject(unsigned index, double value, unsigned* pNumDestroyed)
+        : mIndex(index),
+          mValue(value),
+          mpNumDestroyed(pNumDestroyed)
+    {
+    }
+
+    /**
+     * Destructor.
+     */
+    ~PooledTestObject()
+    {
+        (*mpNumDestroyed)++;
+    }
+};
+
+class TestImmersedBoundaryObjectPool : public CxxTest::TestSuite
+{
+public:
+
+    void TestCreateAndClear() throw(Exception)
+    {
+        unsigned num_destroyed = 0;
+        ImmersedBoundaryObjectPool<PooledTestObject> pool(4);
+
+        TS_ASSERT_EQUALS(pool.GetNumObjects(), 0u);
+        TS_ASSERT_EQUALS(pool.GetCapacity(), 0u);
+        TS_ASSERT_EQUALS(pool.GetNumBlocks(), 0u);
+
+        std::vector<PooledTestObject*> objects;
+        for (unsigned i = 0; i < 10; i++)
+        {
+            objects.push_back(pool.Create(i, 0.5 * i, &num_destroyed));
+        }
+
+        // Blocks of 4, 4 and 8 objects are needed, and objects never move
+        TS_ASSERT_EQUALS(pool.GetNumObjects(), 10u);
+        TS_ASSERT_EQUALS(pool.GetNumBlocks(), 3u);
+        TS_ASSERT_EQUALS(pool.GetCapacity(), 16u);
+        for (unsigned i = 0; i < 10; i++)
+        {
+            TS_ASSERT_EQUALS(objects[i]->mIndex, i);
+            TS_ASSERT_DELTA(objects[i]->mValue, 0.5 * i, 1e-12);
+            TS_ASSERT(pool.Owns(objects[i]));
+        }
+
+        PooledTestObject not_pooled(10, 0.0, &num_destroyed);
+        TS_ASSERT(!pool.Owns(&not_pooled));
+
+        pool.Clear();
+        TS_ASSERT_EQUALS(num_destroyed, 10u);
+        TS_ASSERT_EQUALS(pool.GetNumObjects(), 0u);
+        TS_ASSERT_EQUALS(pool.GetCapacity(), 0u);
+        TS_ASSERT(!pool.Owns(objects[0]));
+    }
+
+    void TestReserve() throw(Exception)
+    {
+        unsigned num_destroyed = 0;
+        {
+            ImmersedBoundaryObjectPool<PooledTestObject> pool(4);
+            pool.Reserve(100);
+            TS_ASSERT_EQUALS(pool.GetNumBlocks(), 1u);
+            TS_ASSERT_EQUALS(pool.GetCapacity(), 100u);
+
+            // Creating the reserved objects needs no further blocks
+            for (unsigned i = 0; i < 100; i++)
+            {
+                pool.Create(i, 1.0, &num_destroyed);
+            }
+            TS_ASSERT_EQUALS(pool.GetNumBlocks(), 1u);
+
+            // A reservation that fits in the existing capacity allocates nothing
+            pool.Create(100u, 1.0, &num_destroyed);
+            pool.Reserve(10);
+            TS_ASSERT_EQUALS(pool.GetNumBlocks(), 2u);
+            pool.Reserve(10);
+            TS_ASSERT_EQUALS(pool.GetNumBlocks(), 2u);
+        }
+
+        // Objects are destroyed with the pool
+        TS_ASSERT_EQUALS(num_destroyed, 101u);
+    }
+
+    void TestReleaseAndReuse() throw(Exception)
+    {
+        unsigned num_destroyed = 0;
+        {
+            ImmersedBoundaryObjectPool<PooledTestObject> pool(4);
+            std::vector<PooledTestObject*> objects;
+            for (unsigned i = 0; i < 4; i++)
+            {
+                objects.push_back(pool.Create(i, 1.0, &num_destroyed));
+            }
+
+            // Releasing an object destroys it straight away, but keeps its storage
+            pool.Release(objects[1]);
+            pool.Release(objects[2]);
+            TS_ASSERT_EQUALS(num_destroyed, 2u);
+            TS_ASSERT_EQUALS(pool.GetNumObjects(), 2u);
+            TS_ASSERT_EQUALS(pool.GetNumFree(), 2u);
+            TS_ASSERT(pool.Owns(objects[1]));
+
+            // The released storage is reused, most recently released first, before any new block is allocated
+            PooledTestObject* p_first = pool.Create(4u, 2.0, &num_destroyed);
+            PooledTestObject* p_second = pool.Create(5u, 3.0, &num_destroyed);
+            TS_ASSERT_EQUALS(p_first, objects[2]);
+            TS_ASSERT_EQUALS(p_second, objects[1]);
+            TS_ASSERT_EQUALS(p_first->mIndex, 4u);
+            TS_ASSERT_EQUALS(pool.GetNumFree(), 0u);
+            TS_ASSERT_EQUALS(pool.GetNumBlocks(), 1u);
+            TS_ASSERT_EQUALS(pool.GetNumObjects(), 4u);
+
+            // Released storage counts towards a reservation
+            pool.Release(objects[0]);
+            pool.Reserve(1);
+            TS_ASSERT_EQUALS(pool.GetNumBlocks(), 1u);
+            pool.Release(objects[3]);
+            TS_ASSERT_EQUALS(num_destroyed, 4u);
+        }
+
+        // Clearing the pool destroys only the objects not already released
+        TS_ASSERT_EQUALS(num_destroyed, 6u);
+    }
+};
+
+#endif /*TESTIMMERSEDBOUNDARYOBJECTPOOL_HPP_*/
@@ -54,7 +54,12 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "ImmersedBoundaryMeshReader.hpp"
 #include "ImmersedBoundarySimulationModifier.hpp"
 #include "ImmersedBoundaryPalisadeMeshGenerator.hpp"
+#include "ImmersedBoundaryHoneycombMeshGenerator.hpp"
 #include "SuperellipseGenerator.hpp"
+#include "OutputFileHandler.hpp"
+
+#include <fstream>
+#include <iterator>
 
 // This test is never run in parallel
 #include "FakePetscSetup.hpp"
@@ -67,4 +72,66 @@ public:
     void TestNothingMuch() throw(Exception)
     {
     }
+
+    void TestStreamingToBinaryMeshFile() throw(Exception)
+    {
+        std::string output_directory = "TestStreamingToBinaryMeshFile";
+
+        // Stream the mesh straight to a binary file, and then create it, stamping out the cells on several threads
+        ImmersedBoundaryPalisadeMeshGenerator gen(7, 100, 0.2, 2.0, 0.15, true);
+        gen.SetNumThreads(3);
+        gen.WriteBinaryMeshFile(output_directory, "streamed", true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        TS_ASSERT_EQUALS(gen.GetMesh(), p_mesh);
+
+        TS_ASSERT_EQUALS(p_mesh->GetNumElements(), 8u);
+        TS_ASSERT_EQUALS(p_mesh->GetMembraneIndex(), 0u);
+        TS_ASSERT_EQUALS(p_mesh->GetNumGridPtsX(), 256u);
+        for (unsigned elem_idx = 1; elem_idx < p_mesh->GetNumElements(); elem_idx++)
+        {
+            TS_ASSERT_EQUALS(p_mesh->GetElement(elem_idx)->GetNumNodes(), 100u);
+            TS_ASSERT_EQUALS(p_mesh->GetElement(elem_idx)->rGetCornerNodes().size(), 4u);
+            TS_ASSERT_EQUALS(p_mesh->GetElement(elem_idx)->GetNode(0)->GetIndex(),
+                             p_mesh->GetElement(0)->GetNumNodes() + 100 * (elem_idx - 1));
+        }
+
+        // The streamed file matches that written from the mesh, byte for byte
+        ImmersedBoundaryMeshWriter<2,2> mesh_writer(output_directory, "from_mesh", false);
+        mesh_writer.WriteBinaryFilesUsingMesh(*p_mesh);
+
+        OutputFileHandler handler(output_directory, false);
+        std::ifstream streamed_file((handler.GetOutputDirectoryFullPath() + "streamed.ibm").c_str(), std::ios::binary);
+        std::ifstream mesh_file((handler.GetOutputDirectoryFullPath() + "from_mesh.ibm").c_str(), std::ios::binary);
+        std::string streamed_bytes((std::istreambuf_iterator<char>(streamed_file)), std::istreambuf_iterator<char>());
+        std::string mesh_bytes((std::istreambuf_iterator<char>(mesh_file)), std::istreambuf_iterator<char>());
+        TS_ASSERT_EQUALS(streamed_bytes.size(), mesh_bytes.size());
+        TS_ASSERT(streamed_bytes == mesh_bytes);
+
+        // The streamed file can be read back
+        ImmersedBoundaryMeshReader<2,2> reader(handler.GetOutputDirectoryFullPath() + "streamed", true);
+        ImmersedBoundaryMesh<2,2> read_mesh;
+        read_mesh.ConstructFromMeshReader(reader);
+        TS_ASSERT_EQUALS(read_mesh.GetNumNodes(), p_mesh->GetNumNodes());
+        TS_ASSERT_EQUALS(read_mesh.GetCharacteristicNodeSpacing(), p_mesh->GetCharacteristicNodeSpacing());
+        TS_ASSERT_EQUALS(read_mesh.GetNode(321)->rGetLocation()[1], p_mesh->GetNode(321)->rGetLocation()[1]);
+
+        // The same holds for a honeycomb, which has no membrane
+        ImmersedBoundaryHoneycombMeshGenerator honeycomb_gen(4, 3, 5, 0.1, 0.1);
+        honeycomb_gen.SetNumThreads(2);
+        honeycomb_gen.WriteBinaryMeshFile(output_directory, "honeycomb");
+        ImmersedBoundaryMesh<2,2>* p_honeycomb = honeycomb_gen.GetMesh();
+        TS_ASSERT_EQUALS(p_honeycomb->GetNumElements(), 12u);
+        TS_ASSERT_EQUALS(p_honeycomb->GetNumNodes(), 360u);
+
+        ImmersedBoundaryMeshReader<2,2> honeycomb_reader(handler.GetOutputDirectoryFullPath() + "honeycomb", true);
+        TS_ASSERT_EQUALS(honeycomb_reader.GetMembraneIndex(), UINT_MAX);
+        ImmersedBoundaryMesh<2,2> read_honeycomb;
+        read_honeycomb.ConstructFromMeshReader(honeycomb_reader);
+        TS_ASSERT_EQUALS(read_honeycomb.GetCharacteristicNodeSpacing(), p_honeycomb->GetCharacteristicNodeSpacing());
+        for (unsigned node_idx = 0; node_idx < p_honeycomb->GetNumNodes(); node_idx++)
+        {
+            TS_ASSERT_EQUALS(read_honeycomb.GetNode(node_idx)->rGetLocation()[0], p_honeycomb->GetNode(node_idx)->rGetLocation()[0]);
+            TS_ASSERT_EQUALS(read_honeycomb.GetNode(node_idx)->rGetLocation()[1], p_honeycomb->GetNode(node_idx)->rGetLocation()[1]);
+        }
+    }
 };
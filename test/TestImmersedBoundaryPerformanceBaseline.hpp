@@ -0,0 +1,155 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TESTIMMERSEDBOUNDARYPERFORMANCEBASELINE_HPP_
+#define TESTIMMERSEDBOUNDARYPERFORMANCEBASELINE_HPP_
+
+// Needed for test framework
+#include <cxxtest/TestSuite.h>
+
+#include <vector>
+
+// Includes from trunk
+#include "OutputFileHandler.hpp"
+
+// Includes from projects/ImmersedBoundary
+#include "ImmersedBoundaryPerformanceBaseline.hpp"
+
+// This test is never run in parallel
+#include "FakePetscSetup.hpp"
+
+class TestImmersedBoundaryPerformanceBaseline : public CxxTest::TestSuite
+{
+public:
+
+    void TestSetAndGetBaselines() throw(Exception)
+    {
+        ImmersedBoundaryPerformanceBaseline baseline;
+        TS_ASSERT_DELTA(baseline.GetThroughputTolerance(), 0.2, 1e-12);
+        TS_ASSERT_DELTA(baseline.GetMemoryTolerance(), 0.2, 1e-12);
+        TS_ASSERT_EQUALS(baseline.GetNumBaselines(), 0u);
+
+        baseline.SetBaseline("palisade", 100.0, 50.0);
+        TS_ASSERT_EQUALS(baseline.GetNumBaselines(), 1u);
+        TS_ASSERT(baseline.HasBaseline("palisade"));
+        TS_ASSERT(!baseline.HasBaseline("honeycomb"));
+        TS_ASSERT_DELTA(baseline.GetBaselineStepsPerSecond("palisade"), 100.0, 1e-12);
+        TS_ASSERT_DELTA(baseline.GetBaselinePeakRss("palisade"), 50.0, 1e-12);
+
+        // Setting a baseline of the same name replaces it
+        baseline.SetBaseline("palisade", 120.0, 40.0);
+        TS_ASSERT_EQUALS(baseline.GetNumBaselines(), 1u);
+        TS_ASSERT_DELTA(baseline.GetBaselineStepsPerSecond("palisade"), 120.0, 1e-12);
+
+        TS_ASSERT_THROWS_THIS(baseline.GetBaselineStepsPerSecond("honeycomb"), "There is no baseline for run honeycomb");
+        TS_ASSERT_THROWS_THIS(baseline.GetBaselinePeakRss("honeycomb"), "There is no baseline for run honeycomb");
+        TS_ASSERT_THROWS_THIS(baseline.SetBaseline("a,b", 1.0, 1.0),
+                              "The name of a run must be non-empty and contain no commas");
+        TS_ASSERT_THROWS_THIS(baseline.SetBaseline("honeycomb", 0.0, 1.0),
+                              "The baseline of run honeycomb must have positive throughput and non-negative memory use");
+        TS_ASSERT_THROWS_THIS(ImmersedBoundaryPerformanceBaseline(-0.1, 0.2),
+                              "Performance tolerances must be non-negative");
+
+        // The peak resident set size of this process can be measured on Linux and Mac OS
+        TS_ASSERT_LESS_THAN(0.0, ImmersedBoundaryPerformanceBaseline::GetPeakResidentSetSize());
+
+#ifdef __linux__
+        // On Linux the peak can be reset, so that memory freed before a run does not count towards its peak
+        {
+            std::vector<char> large_allocation(256 * 1024 * 1024, 1);
+            TS_ASSERT_LESS_THAN(256.0, ImmersedBoundaryPerformanceBaseline::GetPeakResidentSetSize());
+        }
+        TS_ASSERT(ImmersedBoundaryPerformanceBaseline::ResetPeakResidentSetSize());
+        TS_ASSERT_LESS_THAN(0.0, ImmersedBoundaryPerformanceBaseline::GetPeakResidentSetSize());
+        TS_ASSERT_LESS_THAN(ImmersedBoundaryPerformanceBaseline::GetPeakResidentSetSize(), 256.0);
+#endif
+    }
+
+    void TestCheckRun() throw(Exception)
+    {
+        ImmersedBoundaryPerformanceBaseline baseline(0.1, 0.25);
+        baseline.SetBaseline("palisade", 100.0, 40.0);
+
+        // Runs without a baseline fail
+        TS_ASSERT_THROWS_CONTAINS(baseline.CheckRun("honeycomb", 1.0, 1000.0),
+                                  "There is no baseline for run honeycomb to check it against");
+
+        // Runs within the tolerances of their baseline, or better, pass
+        TS_ASSERT_THROWS_NOTHING(baseline.CheckRun("palisade", 91.0, 49.0));
+        TS_ASSERT_THROWS_NOTHING(baseline.CheckRun("palisade", 150.0, 10.0));
+
+        // A peak resident set size of zero could not be measured, so is not checked
+        TS_ASSERT_THROWS_NOTHING(baseline.CheckRun("palisade", 100.0, 0.0));
+
+        TS_ASSERT_THROWS_CONTAINS(baseline.CheckRun("palisade", 89.0, 40.0),
+                                  "Run palisade simulated 89 steps per second, below its baseline of 100");
+        TS_ASSERT_THROWS_CONTAINS(baseline.CheckRun("palisade", 100.0, 51.0),
+                                  "Run palisade had a peak resident set size of 51 MB, above its baseline of 40 MB");
+    }
+
+    void TestReadAndWriteBaselines() throw(Exception)
+    {
+        ImmersedBoundaryPerformanceBaseline baseline;
+        baseline.ReadBaselinesFromFile("projects/ImmersedBoundary/test/data/TestImmersedBoundaryPerformanceBaseline/baselines.csv");
+
+        TS_ASSERT_EQUALS(baseline.GetNumBaselines(), 2u);
+        TS_ASSERT_DELTA(baseline.GetBaselineStepsPerSecond("palisade_strong_1"), 125.0, 1e-12);
+        TS_ASSERT_DELTA(baseline.GetBaselinePeakRss("palisade_strong_1"), 64.0, 1e-12);
+        TS_ASSERT_DELTA(baseline.GetBaselineStepsPerSecond("palisade_strong_2"), 200.0, 1e-12);
+        TS_ASSERT_DELTA(baseline.GetBaselinePeakRss("palisade_strong_2"), 65.0, 1e-12);
+
+        // Writing the baselines to file and reading them back recovers them
+        baseline.SetBaseline("honeycomb_weak_4", 12.5, 128.0);
+        baseline.WriteBaselinesToFile("TestImmersedBoundaryPerformanceBaseline", "baselines.csv");
+
+        OutputFileHandler handler("TestImmersedBoundaryPerformanceBaseline", false);
+        ImmersedBoundaryPerformanceBaseline read_baseline;
+        read_baseline.ReadBaselinesFromFile(handler.GetOutputDirectoryFullPath() + "baselines.csv");
+
+        TS_ASSERT_EQUALS(read_baseline.GetNumBaselines(), 3u);
+        TS_ASSERT_DELTA(read_baseline.GetBaselineStepsPerSecond("honeycomb_weak_4"), 12.5, 1e-12);
+        TS_ASSERT_DELTA(read_baseline.GetBaselinePeakRss("honeycomb_weak_4"), 128.0, 1e-12);
+        TS_ASSERT_DELTA(read_baseline.GetBaselineStepsPerSecond("palisade_strong_2"), 200.0, 1e-12);
+
+        TS_ASSERT_THROWS_THIS(ImmersedBoundaryPerformanceBaseline().WriteBaselinesToFile("TestImmersedBoundaryPerformanceBaseline", "empty.csv"),
+                              "There are no baselines to write");
+        TS_ASSERT_THROWS_THIS(read_baseline.ReadBaselinesFromFile("not_a_file.csv"),
+                              "Could not open baseline file not_a_file.csv");
+        TS_ASSERT_THROWS_THIS(read_baseline.ReadBaselinesFromFile("projects/ImmersedBoundary/test/data/TestImmersedBoundaryPerformanceBaseline/bad_baselines.csv"),
+                              "Line 3 of baseline file projects/ImmersedBoundary/test/data/TestImmersedBoundaryPerformanceBaseline/bad_baselines.csv does not begin with two numbers");
+    }
+};
+
+#endif /*TESTIMMERSEDBOUNDARYPERFORMANCEBASELINE_HPP_*/
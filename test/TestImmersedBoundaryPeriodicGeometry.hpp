@@ -0,0 +1,163 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TESTIMMERSEDBOUNDARYPERIODICGEOMETRY_HPP_
+#define TESTIMMERSEDBOUNDARYPERIODICGEOMETRY_HPP_
+
+// Needed for test framework
+#include <cxxtest/TestSuite.h>
+
+#include <cmath>
+
+// Includes from projects/ImmersedBoundary
+#include "ImmersedBoundaryPeriodicGeometry.hpp"
+#include "ImmersedBoundaryPalisadeMeshGenerator.hpp"
+
+// This test is never run in parallel
+#include "FakePetscSetup.hpp"
+
+class TestImmersedBoundaryPeriodicGeometry : public CxxTest::TestSuite
+{
+public:
+
+    void TestMinimumImage() throw(Exception)
+    {
+        // Differences of no more than half the period are unchanged
+        TS_ASSERT_EQUALS(ImmersedBoundaryPeriodicGeometry::MinimumImage(0.3, 1.0), 0.3);
+        TS_ASSERT_EQUALS(ImmersedBoundaryPeriodicGeometry::MinimumImage(-0.5, 1.0), -0.5);
+        TS_ASSERT_EQUALS(ImmersedBoundaryPeriodicGeometry::MinimumImage(0.0, 1.0), 0.0);
+
+        // Others are wrapped, and are bitwise the same as the branching form
+        double differences[6] = {0.7, -0.7, 0.5000001, -0.9999, 1.3, -1.7};
+        double periods[6] = {1.0, 1.0, 1.0, 1.0, 2.0, 2.0};
+        for (unsigned i = 0; i < 6; i++)
+        {
+            double expected = copysign(fabs(differences[i]) - periods[i], -differences[i]);
+            TS_ASSERT_EQUALS(ImmersedBoundaryPeriodicGeometry::MinimumImage(differences[i], periods[i]), expected);
+        }
+        TS_ASSERT_DELTA(ImmersedBoundaryPeriodicGeometry::MinimumImage(0.7, 1.0), -0.3, 1e-15);
+    }
+
+    void TestKernelsOnSquareAcrossBoundary() throw(Exception)
+    {
+        // A square of side 0.2, anticlockwise, straddling the corner of the unit square
+        double locations[8] = {0.9, 0.9, 0.1, 0.9, 0.1, 0.1, 0.9, 0.1};
+        double periods[2] = {1.0, 1.0};
+
+        double edge_vectors[8];
+        ImmersedBoundaryPeriodicGeometry::CalculateEdgeVectors(locations, 4, periods, edge_vectors);
+        TS_ASSERT_DELTA(edge_vectors[0], 0.2, 1e-12);
+        TS_ASSERT_DELTA(edge_vectors[1], 0.0, 1e-12);
+        TS_ASSERT_DELTA(edge_vectors[2], 0.0, 1e-12);
+        TS_ASSERT_DELTA(edge_vectors[3], 0.2, 1e-12);
+        TS_ASSERT_DELTA(edge_vectors[4], -0.2, 1e-12);
+        TS_ASSERT_DELTA(edge_vectors[5], 0.0, 1e-12);
+        TS_ASSERT_DELTA(edge_vectors[6], 0.0, 1e-12);
+        TS_ASSERT_DELTA(edge_vectors[7], -0.2, 1e-12);
+
+        double edge_lengths[4];
+        ImmersedBoundaryPeriodicGeometry::CalculateEdgeLengths(edge_vectors, 4, edge_lengths);
+        for (unsigned i = 0; i < 4; i++)
+        {
+            TS_ASSERT_DELTA(edge_lengths[i], 0.2, 1e-12);
+        }
+        TS_ASSERT_DELTA(ImmersedBoundaryPeriodicGeometry::CalculatePerimeter(edge_lengths, 4), 0.8, 1e-12);
+
+        double relative_locations[8];
+        ImmersedBoundaryPeriodicGeometry::CalculateRelativeLocations(locations, 4, periods, relative_locations);
+        TS_ASSERT_DELTA(relative_locations[0], 0.0, 1e-12);
+        TS_ASSERT_DELTA(relative_locations[1], 0.0, 1e-12);
+        TS_ASSERT_DELTA(relative_locations[4], 0.2, 1e-12);
+        TS_ASSERT_DELTA(relative_locations[5], 0.2, 1e-12);
+        TS_ASSERT_DELTA(ImmersedBoundaryPeriodicGeometry::CalculateSignedArea(relative_locations, 4), 0.04, 1e-12);
+
+        // Reversing the orientation negates the area
+        double reversed[8] = {0.9, 0.9, 0.9, 0.1, 0.1, 0.1, 0.1, 0.9};
+        ImmersedBoundaryPeriodicGeometry::CalculateRelativeLocations(reversed, 4, periods, relative_locations);
+        TS_ASSERT_DELTA(ImmersedBoundaryPeriodicGeometry::CalculateSignedArea(relative_locations, 4), -0.04, 1e-12);
+
+        // Locations relative to the centroid, which lies on the corner of the domain, wrap around it
+        double centroid[2] = {0.0, 0.0};
+        ImmersedBoundaryPeriodicGeometry::CalculateLocationsRelativeTo(locations, 4, centroid, periods, relative_locations);
+        for (unsigned i = 0; i < 8; i++)
+        {
+            TS_ASSERT_DELTA(fabs(relative_locations[i]), 0.1, 1e-12);
+        }
+        TS_ASSERT_DELTA(relative_locations[0], -0.1, 1e-12);
+        TS_ASSERT_DELTA(relative_locations[2], 0.1, 1e-12);
+    }
+
+    void TestAreasAndPerimetersMatchThoseOfMesh() throw(Exception)
+    {
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+
+        // Move the mesh so that elements straddle the boundary of the domain
+        for (unsigned node_idx = 0; node_idx < p_mesh->GetNumNodes(); node_idx++)
+        {
+            c_vector<double, 2> location = p_mesh->GetNode(node_idx)->rGetLocation();
+            ChastePoint<2> new_location(fmod(location[0] + 0.45, 1.0), fmod(location[1] + 0.6, 1.0));
+            p_mesh->SetNode(node_idx, new_location);
+        }
+
+        // Computing the geometry again reuses the scratch space, and gives the same result
+        ImmersedBoundaryPeriodicGeometry geometry;
+        geometry.CalculateAreasAndPerimeters(p_mesh->rGetNodeArrays());
+        geometry.CalculateAreasAndPerimeters(p_mesh->rGetNodeArrays());
+
+        TS_ASSERT_EQUALS(geometry.rGetAreas().size(), p_mesh->GetNumElements());
+        TS_ASSERT_EQUALS(geometry.rGetPerimeters().size(), p_mesh->GetNumElements());
+
+        for (unsigned elem_idx = 0; elem_idx < p_mesh->GetNumElements(); elem_idx++)
+        {
+            TS_ASSERT_DELTA(geometry.rGetAreas()[elem_idx], p_mesh->GetVolumeOfElement(elem_idx), 1e-12);
+            TS_ASSERT_DELTA(geometry.rGetPerimeters()[elem_idx], p_mesh->GetSurfaceAreaOfElement(elem_idx), 1e-12);
+        }
+
+        // The node arrays and the mesh give the same vectors between nodes
+        const ImmersedBoundaryNodeArrays<2>& r_arrays = p_mesh->rGetNodeArrays();
+        unsigned slot_a = r_arrays.GetSlotOfNode(0);
+        unsigned slot_b = r_arrays.GetSlotOfNode(p_mesh->GetNumNodes() - 1);
+
+        double vector[2];
+        r_arrays.GetVectorFromAtoB(slot_a, slot_b, vector);
+        c_vector<double, 2> mesh_vector = p_mesh->GetVectorFromAtoB(p_mesh->GetNode(0)->rGetLocation(),
+                                                                    p_mesh->GetNode(p_mesh->GetNumNodes() - 1)->rGetLocation());
+        TS_ASSERT_EQUALS(vector[0], mesh_vector[0]);
+        TS_ASSERT_EQUALS(vector[1], mesh_vector[1]);
+    }
+};
+
+#endif /*TESTIMMERSEDBOUNDARYPERIODICGEOMETRY_HPP_*/
@@ -0,0 +1,119 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TESTIMMERSEDBOUNDARYPHASETIMER_HPP_
+#define TESTIMMERSEDBOUNDARYPHASETIMER_HPP_
+
+// Needed for test framework
+#include <cxxtest/TestSuite.h>
+
+// Includes from trunk
+#include "FileFinder.hpp"
+
+// Includes from projects/ImmersedBoundary
+#include "ImmersedBoundaryPhaseTimer.hpp"
+
+// This test is never run in parallel
+#include "FakePetscSetup.hpp"
+
+class TestImmersedBoundaryPhaseTimer : public CxxTest::TestSuite
+{
+public:
+
+    void TestAddPhases() throw(Exception)
+    {
+        ImmersedBoundaryPhaseTimer timer;
+        TS_ASSERT_EQUALS(timer.GetNumPhases(), 0u);
+
+        TS_ASSERT_EQUALS(timer.AddPhase("first"), 0u);
+        TS_ASSERT_EQUALS(timer.AddPhase("second"), 1u);
+
+        // Adding a phase of an existing name returns the existing phase
+        TS_ASSERT_EQUALS(timer.AddPhase("first"), 0u);
+        TS_ASSERT_EQUALS(timer.GetNumPhases(), 2u);
+
+        TS_ASSERT_EQUALS(timer.GetPhaseIndex("second"), 1u);
+        TS_ASSERT_EQUALS(timer.rGetPhaseName(1), "second");
+        TS_ASSERT_THROWS_THIS(timer.GetPhaseIndex("third"), "No phase named third has been registered");
+    }
+
+    void TestTiming() throw(Exception)
+    {
+        ImmersedBoundaryPhaseTimer timer;
+        unsigned outer = timer.AddPhase("outer");
+        unsigned inner = timer.AddPhase("inner");
+
+        // Phases may be nested
+        timer.StartPhase(outer);
+        for (unsigned call = 0; call < 3; call++)
+        {
+            timer.StartPhase(inner);
+            double start = ImmersedBoundaryPhaseTimer::GetWallTime();
+            while (ImmersedBoundaryPhaseTimer::GetWallTime() - start < 1e-3)
+            {
+            }
+            timer.StopPhase(inner);
+        }
+        timer.StopPhase(outer);
+
+        TS_ASSERT_EQUALS(timer.GetNumCalls(outer), 1u);
+        TS_ASSERT_EQUALS(timer.GetNumCalls(inner), 3u);
+        TS_ASSERT_LESS_THAN_EQUALS(3e-3, timer.GetTotalTime(inner));
+        TS_ASSERT_LESS_THAN_EQUALS(timer.GetTotalTime(inner), timer.GetTotalTime(outer));
+
+        // Resetting clears the timings, but keeps the phases
+        timer.Reset();
+        TS_ASSERT_EQUALS(timer.GetNumPhases(), 2u);
+        TS_ASSERT_EQUALS(timer.GetNumCalls(inner), 0u);
+        TS_ASSERT_DELTA(timer.GetTotalTime(outer), 0.0, 1e-12);
+    }
+
+    void TestWriteDataToFile() throw(Exception)
+    {
+        ImmersedBoundaryPhaseTimer timer;
+        TS_ASSERT_THROWS_THIS(timer.WriteDataToFile("TestImmersedBoundaryPhaseTimer", "timings.csv"),
+                              "No phases have been registered");
+
+        unsigned phase = timer.AddPhase("phase");
+        timer.StartPhase(phase);
+        timer.StopPhase(phase);
+        timer.WriteDataToFile("TestImmersedBoundaryPhaseTimer", "timings.csv");
+
+        FileFinder timings_file("TestImmersedBoundaryPhaseTimer/timings.csv", RelativeTo::ChasteTestOutput);
+        TS_ASSERT(timings_file.Exists());
+    }
+};
+
+#endif /*TESTIMMERSEDBOUNDARYPHASETIMER_HPP_*/
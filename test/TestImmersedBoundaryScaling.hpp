@@ -0,0 +1,239 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TESTIMMERSEDBOUNDARYSCALING_HPP_
+#define TESTIMMERSEDBOUNDARYSCALING_HPP_
+
+// Needed for test framework
+#include <cxxtest/TestSuite.h>
+
+#include <sstream>
+
+// Includes from trunk
+#include "AbstractCellBasedTestSuite.hpp"
+#include "CellsGenerator.hpp"
+#include "DifferentiatedCellProliferativeType.hpp"
+#include "OffLatticeSimulation.hpp"
+#include "SmartPointers.hpp"
+#include "Timer.hpp"
+#include "UniformlyDistributedCellCycleModel.hpp"
+
+// Includes from projects/ImmersedBoundary
+#include "CsvWriter.hpp"
+#include "ImmersedBoundaryCellCellInteractionForce.hpp"
+#include "ImmersedBoundaryCellPopulation.hpp"
+#include "ImmersedBoundaryHoneycombMeshGenerator.hpp"
+#include "ImmersedBoundaryMembraneElasticityForce.hpp"
+#include "ImmersedBoundaryPalisadeMeshGenerator.hpp"
+#include "ImmersedBoundaryPerformanceBaseline.hpp"
+#include "ImmersedBoundarySimulationModifier.hpp"
+
+// This test is never run in parallel
+#include "FakePetscSetup.hpp"
+
+/**
+ * Strong and weak scaling of whole simulations over the number of threads, run from the Benchmark test pack.
+ *
+ * Each run simulates a palisade or honeycomb of cells, in the set-up of TestShortMultiCellSimulation, with every
+ * threaded kernel on the same number of threads.  The steps per second and peak resident set size of each run are
+ * streamed to scaling.csv in the output directory TestImmersedBoundaryScaling, and the phase breakdown of each run
+ * from the simulation modifier to <run>_phases.csv.  Each run is then checked against its stored baseline, in
+ * test/data/TestImmersedBoundaryScaling/baselines.csv, so that a performance regression fails the test.
+ *
+ * The measured results are also written to measured_baselines.csv, which may be copied over the stored baselines
+ * once a change in performance is intended, or to record baselines on a new reference machine.  A run without a
+ * stored baseline fails, so the stored baselines must be recorded on the reference machine before the test can pass.
+ * The peak resident set size of each run is measured from the reset of the peak before it, which is only possible
+ * on Linux; elsewhere it is recorded as zero and not checked.
+ */
+class TestImmersedBoundaryScaling : public AbstractCellBasedTestSuite
+{
+private:
+
+    /** The number of timesteps simulated in each run. */
+    static const unsigned NUM_TIMESTEPS = 100;
+
+    /**
+     * Simulate a mesh of cells on a number of threads, record the throughput and memory use of the simulation, and
+     * check them against the stored baseline of the run.
+     *
+     * @param rName the name of the run
+     * @param pMesh the mesh of cells to simulate
+     * @param numGridPts the number of grid points in each dimension of the fluid grid
+     * @param numThreads the number of threads for every threaded kernel
+     * @param rWriter the writer streaming the results of each run
+     * @param rStoredBaselines the baselines to check the run against
+     * @param rMeasuredBaselines the baselines to which the results of the run are added
+     */
+    void RunSimulation(const std::string& rName,
+                       ImmersedBoundaryMesh<2,2>* pMesh,
+                       unsigned numGridPts,
+                       unsigned numThreads,
+                       CsvWriter& rWriter,
+                       const ImmersedBoundaryPerformanceBaseline& rStoredBaselines,
+                       ImmersedBoundaryPerformanceBaseline& rMeasuredBaselines)
+    {
+        // Reset SimulationTime, so that each run starts from time zero
+        SimulationTime::Destroy();
+        SimulationTime::Instance()->SetStartTime(0.0);
+
+        pMesh->SetNumGridPtsXAndY(numGridPts);
+
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, pMesh->GetNumElements(), p_diff_type);
+
+        ImmersedBoundaryCellPopulation<2> cell_population(*pMesh, cells);
+        cell_population.SetIfPopulationHasActiveSources(false);
+        cell_population.SetNumInterpolationThreads(numThreads);
+
+        OffLatticeSimulation<2> simulator(cell_population);
+
+        MAKE_PTR(ImmersedBoundarySimulationModifier<2>, p_main_modifier);
+        simulator.AddSimulationModifier(p_main_modifier);
+        p_main_modifier->SetNumNeighbourThreads(numThreads);
+        p_main_modifier->SetNumSpreadingThreads(numThreads);
+        p_main_modifier->SetNumFftThreads(numThreads);
+
+        MAKE_PTR(ImmersedBoundaryMembraneElasticityForce<2>, p_boundary_force);
+        p_main_modifier->AddImmersedBoundaryForce(p_boundary_force);
+        p_boundary_force->SetSpringConstant(1.0 * 1e7);
+        p_boundary_force->SetNumThreads(numThreads);
+
+        MAKE_PTR(ImmersedBoundaryCellCellInteractionForce<2>, p_cell_cell_force);
+        p_main_modifier->AddImmersedBoundaryForce(p_cell_cell_force);
+        p_cell_cell_force->SetSpringConstant(1.0 * 1e6);
+        p_cell_cell_force->SetNumThreads(numThreads);
+
+        double dt = 0.05;
+        simulator.SetOutputDirectory("TestImmersedBoundaryScaling/" + rName);
+        simulator.SetDt(dt);
+        simulator.SetSamplingTimestepMultiple(NUM_TIMESTEPS);
+        simulator.SetEndTime(NUM_TIMESTEPS * dt);
+
+        // Unless the peak resident set size can be reset, it would include earlier runs, so is recorded as unmeasured
+        bool peak_rss_was_reset = ImmersedBoundaryPerformanceBaseline::ResetPeakResidentSetSize();
+
+        Timer::Reset();
+        simulator.Solve();
+        double steps_per_second = NUM_TIMESTEPS / std::max(Timer::GetElapsedTime(), 1e-9);
+
+        double peak_rss = peak_rss_was_reset ? ImmersedBoundaryPerformanceBaseline::GetPeakResidentSetSize() : 0.0;
+
+        p_main_modifier->rGetPhaseTimer().WriteDataToFile("TestImmersedBoundaryScaling", rName + "_phases.csv");
+
+        std::vector<unsigned> unsigned_data;
+        unsigned_data.push_back(numThreads);
+        unsigned_data.push_back(pMesh->GetNumNodes());
+        unsigned_data.push_back(numGridPts);
+
+        std::vector<double> double_data;
+        double_data.push_back(steps_per_second);
+        double_data.push_back(peak_rss);
+
+        rWriter.AppendRow(unsigned_data, double_data, std::vector<std::string>(1, rName));
+        rMeasuredBaselines.SetBaseline(rName, steps_per_second, peak_rss);
+        rMeasuredBaselines.WriteBaselinesToFile("TestImmersedBoundaryScaling", "measured_baselines.csv");
+
+        std::cout << "SCALING run=" << rName << " threads=" << numThreads << " num_nodes=" << pMesh->GetNumNodes()
+                  << " grid_pts=" << numGridPts << " steps_per_second=" << steps_per_second
+                  << " peak_rss_mb=" << peak_rss << "\n";
+
+        // A regression, or a run without a stored baseline, throws, failing the test
+        rStoredBaselines.CheckRun(rName, steps_per_second, peak_rss);
+    }
+
+public:
+
+    void TestStrongAndWeakScaling() throw(Exception)
+    {
+        ImmersedBoundaryPerformanceBaseline stored_baselines;
+        stored_baselines.ReadBaselinesFromFile("projects/ImmersedBoundary/test/data/TestImmersedBoundaryScaling/baselines.csv");
+        ImmersedBoundaryPerformanceBaseline measured_baselines;
+
+        std::vector<std::string> headers;
+        headers.push_back("threads");
+        headers.push_back("num_nodes");
+        headers.push_back("grid_pts");
+        headers.push_back("steps_per_second");
+        headers.push_back("peak_rss_mb");
+        headers.push_back("run");
+
+        CsvWriter writer;
+        writer.SetDirectoryName("TestImmersedBoundaryScaling");
+        writer.SetFileName("scaling.csv");
+        writer.AddHeaders(headers);
+        writer.StartStreaming(3, 2, 1, 1);
+
+        // Strong scaling: a fixed problem on increasing numbers of threads
+        unsigned strong_threads[4] = {1, 2, 4, 8};
+        for (unsigned idx = 0; idx < 4; idx++)
+        {
+            std::stringstream threads;
+            threads << strong_threads[idx];
+
+            ImmersedBoundaryPalisadeMeshGenerator palisade_gen(7, 128, 0.1, 2.5, 0.0, true);
+            RunSimulation("palisade_strong_" + threads.str(), palisade_gen.GetMesh(), 256, strong_threads[idx],
+                          writer, stored_baselines, measured_baselines);
+
+            ImmersedBoundaryHoneycombMeshGenerator honeycomb_gen(4, 4, 16, 0.1, 0.1);
+            RunSimulation("honeycomb_strong_" + threads.str(), honeycomb_gen.GetMesh(), 256, strong_threads[idx],
+                          writer, stored_baselines, measured_baselines);
+        }
+
+        // Weak scaling: the numbers of nodes and grid points grow in proportion to the number of threads
+        unsigned weak_threads[3] = {1, 4, 16};
+        unsigned weak_factors[3] = {1, 2, 4};
+        for (unsigned idx = 0; idx < 3; idx++)
+        {
+            std::stringstream threads;
+            threads << weak_threads[idx];
+            unsigned factor = weak_factors[idx];
+
+            ImmersedBoundaryPalisadeMeshGenerator palisade_gen(4 * factor, 64 * factor, 0.1, 2.5, 0.0, true);
+            RunSimulation("palisade_weak_" + threads.str(), palisade_gen.GetMesh(), 128 * factor, weak_threads[idx],
+                          writer, stored_baselines, measured_baselines);
+
+            ImmersedBoundaryHoneycombMeshGenerator honeycomb_gen(2 * factor, 2 * factor, 16, 0.1, 0.1);
+            RunSimulation("honeycomb_weak_" + threads.str(), honeycomb_gen.GetMesh(), 128 * factor, weak_threads[idx],
+                          writer, stored_baselines, measured_baselines);
+        }
+
+        TS_ASSERT_EQUALS(writer.GetNumRowsStreamed(), 14u);
+    }
+};
+
+#endif /*TESTIMMERSEDBOUNDARYSCALING_HPP_*/
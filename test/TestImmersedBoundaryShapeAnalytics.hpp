@@ -0,0 +1,174 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TESTIMMERSEDBOUNDARYSHAPEANALYTICS_HPP_
+#define TESTIMMERSEDBOUNDARYSHAPEANALYTICS_HPP_
+
+// Needed for test framework
+#include <cxxtest/TestSuite.h>
+
+#include <fstream>
+#include <string>
+
+// Includes from trunk
+#include "OutputFileHandler.hpp"
+
+// Includes from projects/ImmersedBoundary
+#include "ImmersedBoundaryShapeAnalytics.hpp"
+#include "ImmersedBoundaryPalisadeMeshGenerator.hpp"
+
+// This test is never run in parallel
+#include "FakePetscSetup.hpp"
+
+class TestImmersedBoundaryShapeAnalytics : public CxxTest::TestSuite
+{
+public:
+
+    void TestGetAndSetMethods() throw(Exception)
+    {
+        ImmersedBoundaryShapeAnalytics analytics;
+        TS_ASSERT_EQUALS(analytics.GetNumRows(), 0u);
+        TS_ASSERT_DELTA(analytics.GetTortuosity(), 0.0, 1e-12);
+
+        // The skewness is about the y axis unless set otherwise
+        TS_ASSERT_DELTA(analytics.rGetSkewnessAxis()[0], 0.0, 1e-12);
+        TS_ASSERT_DELTA(analytics.rGetSkewnessAxis()[1], 1.0, 1e-12);
+
+        c_vector<double, 2> axis;
+        axis[0] = 1.0;
+        axis[1] = 1.0;
+        analytics.SetSkewnessAxis(axis);
+        TS_ASSERT_DELTA(analytics.rGetSkewnessAxis()[0], 1.0, 1e-12);
+
+        TS_ASSERT_EQUALS(analytics.GetNumThreads(), 1u);
+        analytics.SetNumThreads(4);
+        TS_ASSERT_EQUALS(analytics.GetNumThreads(), 4u);
+    }
+
+    void TestMetricsMatchThoseOfMesh() throw(Exception)
+    {
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+
+        c_vector<double, 2> axis;
+        axis[0] = 0.3;
+        axis[1] = 1.0;
+
+        // The metrics are the same whatever the number of threads, and when computed again
+        for (unsigned num_threads = 1; num_threads <= 4; num_threads += 3)
+        {
+            ImmersedBoundaryShapeAnalytics analytics;
+            analytics.SetSkewnessAxis(axis);
+            analytics.SetNumThreads(num_threads);
+            analytics.Compute(*p_mesh);
+            analytics.Compute(*p_mesh);
+
+            // The membrane element has no row
+            TS_ASSERT_EQUALS(analytics.GetNumRows(), p_mesh->GetNumElements() - 1);
+
+            for (unsigned row = 0; row < analytics.GetNumRows(); row++)
+            {
+                unsigned elem_idx = analytics.rGetElementIndices()[row];
+                TS_ASSERT_DIFFERS(p_mesh->GetElement(elem_idx), p_mesh->GetMembraneElement());
+
+                TS_ASSERT_DELTA(analytics.rGetAreas()[row], p_mesh->GetVolumeOfElement(elem_idx), 1e-12);
+                TS_ASSERT_DELTA(analytics.rGetPerimeters()[row], p_mesh->GetSurfaceAreaOfElement(elem_idx), 1e-12);
+                TS_ASSERT_DELTA(analytics.rGetElongationShapeFactors()[row],
+                                p_mesh->GetElongationShapeFactorOfElement(elem_idx), 1e-9);
+                TS_ASSERT_DELTA(analytics.rGetSkewnesses()[row],
+                                p_mesh->GetSkewnessOfElementMassDistributionAboutAxis(elem_idx, axis), 1e-9);
+            }
+
+            TS_ASSERT_DELTA(analytics.GetTortuosity(), p_mesh->GetTortuosityOfMesh(), 1e-12);
+        }
+    }
+
+    void TestTortuosityInWideDomain() throw(Exception)
+    {
+        // A straight palisade has unit tortuosity
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.0, false);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        TS_ASSERT_DELTA(p_mesh->GetTortuosityOfMesh(), 1.0, 1e-9);
+
+        // Stretched across a domain twice as wide, the straight line between the end cells is twice as long
+        p_mesh->SetDomainSize(2.0, 1.0);
+        for (unsigned node_idx = 0; node_idx < p_mesh->GetNumNodes(); node_idx++)
+        {
+            p_mesh->GetNode(node_idx)->rGetModifiableLocation()[0] *= 2.0;
+        }
+        p_mesh->InvalidateNodeArrays();
+
+        TS_ASSERT_DELTA(p_mesh->GetTortuosityOfMesh(), 1.0, 1e-9);
+
+        ImmersedBoundaryShapeAnalytics analytics;
+        analytics.Compute(*p_mesh);
+        TS_ASSERT_DELTA(analytics.GetTortuosity(), 1.0, 1e-9);
+    }
+
+    void TestStreaming() throw(Exception)
+    {
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+
+        ImmersedBoundaryShapeAnalytics analytics;
+        analytics.Compute(*p_mesh);
+
+        CsvWriter writer;
+        writer.SetDirectoryName("TestImmersedBoundaryShapeAnalytics");
+        writer.SetFileName("shapes.csv");
+
+        // A row per element is appended at each output step
+        analytics.StartStreaming(writer);
+        analytics.AppendRows(writer, 0);
+        analytics.AppendRows(writer, 1);
+        TS_ASSERT_EQUALS(writer.GetNumRowsStreamed(), 2 * analytics.GetNumRows());
+        writer.StopStreaming();
+
+        OutputFileHandler output_file_handler("TestImmersedBoundaryShapeAnalytics", false);
+        std::ifstream file((output_file_handler.GetOutputDirectoryFullPath() + "shapes.csv").c_str());
+        std::string line;
+        std::getline(file, line);
+        TS_ASSERT_EQUALS(line, "step,element,area,perimeter,elongation_shape_factor,skewness");
+
+        unsigned num_lines = 0;
+        while (std::getline(file, line))
+        {
+            num_lines++;
+        }
+        TS_ASSERT_EQUALS(num_lines, 2 * analytics.GetNumRows());
+    }
+};
+
+#endif /*TESTIMMERSEDBOUNDARYSHAPEANALYTICS_HPP_*/
@@ -37,11 +37,15 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <cxxtest/TestSuite.h>
 #include "AbstractCellBasedTestSuite.hpp"
 
+#include <algorithm>
+#include <set>
+
 // Includes from trunk
 #include "CellsGenerator.hpp"
 #include "CheckpointArchiveTypes.hpp"
 #include "DifferentiatedCellProliferativeType.hpp"
 #include "FileComparison.hpp"
+#include "FileFinder.hpp"
 #include "HoneycombVertexMeshGenerator.hpp"
 #include "OffLatticeSimulation.hpp"
 #include "SmartPointers.hpp"
@@ -50,14 +54,118 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // Includes from Immersed Boundary
 #include "ImmersedBoundaryMesh.hpp"
 #include "ImmersedBoundaryCellPopulation.hpp"
+#include "ImmersedBoundaryCheckpoint.hpp"
+#include "ImmersedBoundaryFftInterface.hpp"
 #include "ImmersedBoundarySimulationModifier.hpp"
 #include "ImmersedBoundaryPalisadeMeshGenerator.hpp"
 #include "ImmersedBoundaryMembraneElasticityForce.hpp"
 #include "ImmersedBoundaryCellCellInteractionForce.hpp"
+#include "ImmersedBoundaryEnergySpectrumReducer.hpp"
+#include "ImmersedBoundaryVorticityReducer.hpp"
+#include "SuperellipseGenerator.hpp"
 
 // This test is never run in parallel
 #include "FakePetscSetup.hpp"
 
+/**
+ * A stub backend, which counts the transforms it is asked for and delegates them to an fftw backend, used to test that
+ * the modifier performs its transforms with a backend made by an FFT interface factory.
+ */
+class CountingFftInterface : public AbstractImmersedBoundaryFftInterface<2>
+{
+private:
+
+    /** The fftw backend performing the transforms. */
+    ImmersedBoundaryFftInterface<2> mFftwInterface;
+
+    /** The number of forward transforms performed by all backends of the factory. */
+    unsigned& mrNumForward;
+
+    /** The number of inverse transforms performed by all backends of the factory. */
+    unsigned& mrNumInverse;
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param pMesh the immersed boundary mesh
+     * @param pIn pointer to the input array
+     * @param pComplex pointer to the complex number array
+     * @param pOut pointer to the output array
+     * @param activeSources whether the population has active fluid sources
+     * @param rNumForward the count of forward transforms
+     * @param rNumInverse the count of inverse transforms
+     */
+    CountingFftInterface(ImmersedBoundaryMesh<2,2>* pMesh, double* pIn, std::complex<double>* pComplex, double* pOut,
+                         bool activeSources, unsigned& rNumForward, unsigned& rNumInverse)
+        : mFftwInterface(pMesh, pIn, pComplex, pOut, 1, activeSources),
+          mrNumForward(rNumForward),
+          mrNumInverse(rNumInverse)
+    {
+    }
+
+    /** Count, and perform, a forward transform. */
+    void FftExecuteForward()
+    {
+        mrNumForward++;
+        mFftwInterface.FftExecuteForward();
+    }
+
+    /** Count, and perform, an inverse transform. */
+    void FftExecuteInverse()
+    {
+        mrNumInverse++;
+        mFftwInterface.FftExecuteInverse();
+    }
+};
+
+/**
+ * A factory making CountingFftInterface backends, which keeps the counts of the backends it has made.
+ */
+class CountingFftInterfaceFactory : public AbstractImmersedBoundaryFftInterfaceFactory<2>
+{
+public:
+
+    /** The number of backends made. */
+    unsigned mNumCreated;
+
+    /** The number of forward transforms performed by the backends made. */
+    unsigned mNumForward;
+
+    /** The number of inverse transforms performed by the backends made. */
+    unsigned mNumInverse;
+
+    /** Constructor. */
+    CountingFftInterfaceFactory()
+        : mNumCreated(0),
+          mNumForward(0),
+          mNumInverse(0)
+    {
+    }
+
+    /**
+     * Make a CountingFftInterface.
+     *
+     * @param pMesh the immersed boundary mesh
+     * @param pIn pointer to the input array
+     * @param pComplex pointer to the complex number array
+     * @param pOut pointer to the output array
+     * @param activeSources whether the population has active fluid sources
+     *
+     * @return the new backend
+     */
+    AbstractImmersedBoundaryFftInterface<2>* CreateFftInterface(ImmersedBoundaryMesh<2,2>* pMesh,
+                                                                double* pIn,
+                                                                std::complex<double>* pComplex,
+                                                                double* pOut,
+                                                                bool activeSources)
+    {
+        mNumCreated++;
+        return new CountingFftInterface(pMesh, pIn, pComplex, pOut, activeSources, mNumForward, mNumInverse);
+    }
+};
+
 ///\todo Improve testing
 class TestImmersedBoundarySimulationModifier : public AbstractCellBasedTestSuite
 {
@@ -72,10 +180,95 @@ public:
         modifier.SetNodeNeighbourUpdateFrequency(2);
         TS_ASSERT_EQUALS(modifier.GetNodeNeighbourUpdateFrequency(), 2u);
 
+        // Test GetNeighbourSkin() and SetNeighbourSkin()
+        TS_ASSERT_DELTA(modifier.GetNeighbourSkin(), 0.0, 1e-12);
+        modifier.SetNeighbourSkin(0.01);
+        TS_ASSERT_DELTA(modifier.GetNeighbourSkin(), 0.01, 1e-12);
+        TS_ASSERT_EQUALS(modifier.GetNumNodePairCalculations(), 0u);
+
+        // Test GetNumNeighbourThreads() and SetNumNeighbourThreads()
+        TS_ASSERT_EQUALS(modifier.GetNumNeighbourThreads(), 1u);
+        modifier.SetNumNeighbourThreads(4);
+        TS_ASSERT_EQUALS(modifier.GetNumNeighbourThreads(), 4u);
+
+        // Test GetUseIncrementalNodePairUpdates() and SetUseIncrementalNodePairUpdates()
+        TS_ASSERT(!modifier.GetUseIncrementalNodePairUpdates());
+        modifier.SetUseIncrementalNodePairUpdates(true);
+        TS_ASSERT(modifier.GetUseIncrementalNodePairUpdates());
+        TS_ASSERT_EQUALS(modifier.GetNumIncrementalNodePairUpdates(), 0u);
+
         // Test GetReynoldsNumber() and SetReynoldsNumber()
         TS_ASSERT_DELTA(modifier.GetReynoldsNumber(), 1e-4, 1e-6);
         modifier.SetReynoldsNumber(1e-5);
         TS_ASSERT_DELTA(modifier.GetReynoldsNumber(), 1e-5, 1e-6);
+
+        // Test GetNumFftThreads() and SetNumFftThreads()
+        TS_ASSERT_EQUALS(modifier.GetNumFftThreads(), 1u);
+        modifier.SetNumFftThreads(4);
+        TS_ASSERT_EQUALS(modifier.GetNumFftThreads(), 4u);
+
+        // Test the space filling curve reordering get and set methods
+        TS_ASSERT_EQUALS(modifier.GetReorderFrequency(), 0u);
+        modifier.SetReorderFrequency(50);
+        TS_ASSERT_EQUALS(modifier.GetReorderFrequency(), 50u);
+
+        TS_ASSERT_EQUALS(modifier.GetReorderAlongHilbertCurve(), true);
+        modifier.SetReorderAlongHilbertCurve(false);
+        TS_ASSERT_EQUALS(modifier.GetReorderAlongHilbertCurve(), false);
+
+        // Test the remeshing get and set methods
+        TS_ASSERT_EQUALS(modifier.GetRemeshFrequency(), 0u);
+        modifier.SetRemeshFrequency(20);
+        TS_ASSERT_EQUALS(modifier.GetRemeshFrequency(), 20u);
+
+        TS_ASSERT_DELTA(modifier.GetRemeshTargetNodeSpacing(), 0.0, 1e-12);
+        modifier.SetRemeshTargetNodeSpacing(0.01);
+        TS_ASSERT_DELTA(modifier.GetRemeshTargetNodeSpacing(), 0.01, 1e-12);
+
+        // Test GetStorePressureGrid() and SetStorePressureGrid()
+        TS_ASSERT_EQUALS(modifier.GetStorePressureGrid(), false);
+        modifier.SetStorePressureGrid(true);
+        TS_ASSERT_EQUALS(modifier.GetStorePressureGrid(), true);
+
+        // Test GetUseSinglePrecisionFluid() and SetUseSinglePrecisionFluid()
+        TS_ASSERT_EQUALS(modifier.GetUseSinglePrecisionFluid(), false);
+        modifier.SetUseSinglePrecisionFluid(true);
+        TS_ASSERT_EQUALS(modifier.GetUseSinglePrecisionFluid(), true);
+
+        // Test GetUseLowMemoryGrids() and SetUseLowMemoryGrids()
+        TS_ASSERT_EQUALS(modifier.GetUseLowMemoryGrids(), false);
+        modifier.SetUseLowMemoryGrids(true);
+        TS_ASSERT_EQUALS(modifier.GetUseLowMemoryGrids(), true);
+
+        // Test GetUseFastStartFftPlanning() and SetUseFastStartFftPlanning()
+        TS_ASSERT_EQUALS(modifier.GetUseFastStartFftPlanning(), false);
+        modifier.SetUseFastStartFftPlanning(true);
+        TS_ASSERT_EQUALS(modifier.GetUseFastStartFftPlanning(), true);
+
+        // Test GetNumTaskGraphThreads() and SetNumTaskGraphThreads()
+        TS_ASSERT_EQUALS(modifier.GetNumTaskGraphThreads(), 1u);
+        modifier.SetNumTaskGraphThreads(4);
+        TS_ASSERT_EQUALS(modifier.GetNumTaskGraphThreads(), 4u);
+        TS_ASSERT(modifier.GetArrays() == NULL);
+        TS_ASSERT(modifier.GetSinglePrecisionArrays() == NULL);
+
+        // Test the adaptive timestepping get and set methods
+        TS_ASSERT_EQUALS(modifier.GetUseAdaptiveTimestep(), false);
+        modifier.SetUseAdaptiveTimestep(true);
+        TS_ASSERT_EQUALS(modifier.GetUseAdaptiveTimestep(), true);
+
+        TS_ASSERT_DELTA(modifier.GetCflNumber(), 0.25, 1e-12);
+        modifier.SetCflNumber(0.5);
+        TS_ASSERT_DELTA(modifier.GetCflNumber(), 0.5, 1e-12);
+
+        TS_ASSERT_DELTA(modifier.GetMinTimestep(), 0.0, 1e-12);
+        TS_ASSERT_DELTA(modifier.GetMaxTimestep(), 0.0, 1e-12);
+        modifier.SetAdaptiveTimestepBounds(1e-4, 1e-2);
+        TS_ASSERT_DELTA(modifier.GetMinTimestep(), 1e-4, 1e-12);
+        TS_ASSERT_DELTA(modifier.GetMaxTimestep(), 1e-2, 1e-12);
+
+        TS_ASSERT_THROWS_THIS(modifier.SetAdaptiveTimestepBounds(1e-2, 1e-4),
+                              "Adaptive timestep bounds must satisfy 0 < minTimestep <= maxTimestep");
     }
 
     void TestOutputParametersWithImmersedBoundarySimulationModifier() throw(Exception)
@@ -140,7 +333,129 @@ public:
         TS_ASSERT_DELTA(modifier.mGridSpacingY, 0.0039, 1e-4);
         TS_ASSERT_DELTA(modifier.mFftNorm, 65536.0, 1e-6);
         TS_ASSERT(modifier.mpArrays != NULL);
+        TS_ASSERT(modifier.mpSinglePrecisionArrays == NULL);
         TS_ASSERT(modifier.mpFftInterface != NULL);
+
+        // In single precision, only the single precision arrays are allocated
+        ImmersedBoundarySimulationModifier<2> single_modifier;
+        single_modifier.SetUseSinglePrecisionFluid(true);
+        TS_ASSERT_THROWS_NOTHING(single_modifier.SetupConstantMemberVariables(cell_population));
+        TS_ASSERT(single_modifier.GetArrays() == NULL);
+        TS_ASSERT(single_modifier.GetSinglePrecisionArrays() != NULL);
+        TS_ASSERT_EQUALS(single_modifier.GetSinglePrecisionArrays()->rGetModifiableOutputGrids().num_elements(),
+                         2u * 256u * 256u);
+        TS_ASSERT(single_modifier.mpFftInterface != NULL);
+    }
+
+    void TestNeighbourSkin() throw(Exception)
+    {
+        // Set up SimulationTime - needed by SetupConstantMemberVariables()
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(2.0, 2);
+
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+
+        // With a skin, the node pairs are calculated when the simulation is set up
+        ImmersedBoundarySimulationModifier<2> modifier;
+        modifier.SetNodeNeighbourUpdateFrequency(1);
+        modifier.SetNeighbourSkin(0.01);
+        modifier.SetupConstantMemberVariables(cell_population);
+        TS_ASSERT_EQUALS(modifier.GetNumNodePairCalculations(), 1u);
+        TS_ASSERT_DELTA(cell_population.GetNodeDisplacementBound(), 0.0, 1e-12);
+
+        // The node pairs are not recalculated while no node has moved, whatever the update frequency
+        modifier.UpdateAtEndOfTimeStep(cell_population);
+        TS_ASSERT_EQUALS(modifier.GetNumNodePairCalculations(), 1u);
+
+        // Move every node by more than half the skin, in a uniform flow
+        multi_array<double, 3>& r_vel_grids = p_mesh->rGetModifiable2dVelocityGrids();
+        std::fill(r_vel_grids.data(), r_vel_grids.data() + r_vel_grids.num_elements(), 0.0);
+        for (unsigned x = 0; x < modifier.mNumGridPtsX; x++)
+        {
+            for (unsigned y = 0; y < modifier.mNumGridPtsY; y++)
+            {
+                r_vel_grids[0][x][y] = 1.0;
+            }
+        }
+        cell_population.UpdateNodeLocations(0.006);
+        TS_ASSERT_DELTA(cell_population.GetNodeDisplacementBound(), 0.006, 1e-6);
+
+        // The node pairs are now recalculated, which resets the displacement bound
+        modifier.UpdateAtEndOfTimeStep(cell_population);
+        TS_ASSERT_EQUALS(modifier.GetNumNodePairCalculations(), 2u);
+        TS_ASSERT_DELTA(cell_population.GetNodeDisplacementBound(), 0.0, 1e-12);
+    }
+
+    void TestIncrementalNodePairUpdates() throw(Exception)
+    {
+        // Set up SimulationTime - needed by SetupConstantMemberVariables()
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(2.0, 2);
+
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+
+        ImmersedBoundarySimulationModifier<2> modifier;
+        modifier.SetNeighbourSkin(0.01);
+        modifier.SetUseIncrementalNodePairUpdates(true);
+        modifier.SetupConstantMemberVariables(cell_population);
+        TS_ASSERT_EQUALS(modifier.GetNumNodePairCalculations(), 1u);
+        TS_ASSERT(!p_mesh->rGetTopologyChanges().HasChanges());
+
+        // Kill the cell of an element other than the membrane, and compact the mesh
+        for (AbstractCellPopulation<2>::Iterator cell_iter = cell_population.Begin();
+             cell_iter != cell_population.End();
+             ++cell_iter)
+        {
+            if (cell_population.GetElementCorrespondingToCell(*cell_iter) != p_mesh->GetMembraneElement())
+            {
+                cell_iter->Kill();
+                break;
+            }
+        }
+        cell_population.RemoveDeadCells();
+        cell_population.Update();
+        TS_ASSERT_EQUALS(p_mesh->GetNumReMeshes(), 1u);
+        TS_ASSERT(p_mesh->rGetTopologyChanges().HasChanges());
+
+        // The node pairs are updated rather than recalculated, and the changes cleared
+        modifier.UpdateAtEndOfTimeStep(cell_population);
+        TS_ASSERT_EQUALS(modifier.GetNumNodePairCalculations(), 1u);
+        TS_ASSERT_EQUALS(modifier.GetNumIncrementalNodePairUpdates(), 1u);
+        TS_ASSERT(!p_mesh->rGetTopologyChanges().HasChanges());
+
+        // The updated pairs are those found by building the list afresh
+        ImmersedBoundaryNodePairList<2> built_list(modifier.mpNodePairList->GetCutoff());
+        built_list.Build(p_mesh->rGetNodeArrays());
+        TS_ASSERT_EQUALS(modifier.mpNodePairList->GetNumPairs(), built_list.GetNumPairs());
+
+        std::set<std::pair<unsigned, unsigned> > updated_pairs;
+        std::set<std::pair<unsigned, unsigned> > built_pairs;
+        for (unsigned pair = 0; pair < built_list.GetNumPairs(); pair++)
+        {
+            const ImmersedBoundaryNodePairList<2>::NodePair& r_updated = modifier.mpNodePairList->rGetPair(pair);
+            const ImmersedBoundaryNodePairList<2>::NodePair& r_built = built_list.rGetPair(pair);
+            updated_pairs.insert(std::make_pair(std::min(r_updated.mNodeA, r_updated.mNodeB), std::max(r_updated.mNodeA, r_updated.mNodeB)));
+            built_pairs.insert(std::make_pair(std::min(r_built.mNodeA, r_built.mNodeB), std::max(r_built.mNodeA, r_built.mNodeB)));
+        }
+        TS_ASSERT(updated_pairs == built_pairs);
+
+        // Renumbering is not recorded in detail, so the node pairs are recalculated
+        cell_population.ReorderAlongSpaceFillingCurve();
+        TS_ASSERT(!p_mesh->rGetTopologyChanges().IsComplete());
+        modifier.UpdateAtEndOfTimeStep(cell_population);
+        TS_ASSERT_EQUALS(modifier.GetNumNodePairCalculations(), 2u);
+        TS_ASSERT_EQUALS(modifier.GetNumIncrementalNodePairUpdates(), 1u);
+        TS_ASSERT(p_mesh->rGetTopologyChanges().IsComplete());
     }
 
     void TestClearForcesAndSources() throw(Exception)
@@ -177,10 +492,11 @@ public:
         // Test ClearForcesAndSources() correctly resets the applied force on each node
         modifier.ClearForcesAndSources();
 
-        for (unsigned i=0; i<p_mesh->GetNumNodes(); i++)
+        ImmersedBoundaryNodeArrays<2>& r_node_arrays = p_mesh->rGetNodeArrays();
+        for (unsigned slot=0; slot<r_node_arrays.GetNumSlots(); slot++)
         {
-            TS_ASSERT_DELTA(p_mesh->GetNode(i)->rGetAppliedForce()[0], 0.0, 1e-6);
-            TS_ASSERT_DELTA(p_mesh->GetNode(i)->rGetAppliedForce()[1], 0.0, 1e-6);
+            TS_ASSERT_DELTA(r_node_arrays.GetAppliedForce(slot)[0], 0.0, 1e-6);
+            TS_ASSERT_DELTA(r_node_arrays.GetAppliedForce(slot)[1], 0.0, 1e-6);
         }
 
         // Test ClearForcesAndSources() correctly resets mpArrays
@@ -202,7 +518,83 @@ public:
 
     void TestPropagateForcesToFluidGrid() throw(Exception)
     {
-        ///\todo Test this method
+        // Set up SimulationTime - needed by SetupConstantMemberVariables()
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(2.0, 2);
+
+        // Create an immersed boundary cell population where each node holds a non-zero applied force
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        for (unsigned i=0; i<p_mesh->GetNumNodes(); i++)
+        {
+            c_vector<double, 2> force;
+            force[0] = sin(0.1 * i);
+            force[1] = cos(0.3 * i);
+
+            p_mesh->GetNode(i)->ClearAppliedForce();
+            p_mesh->GetNode(i)->AddAppliedForceContribution(force);
+        }
+
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+
+        ImmersedBoundarySimulationModifier<2> modifier;
+        modifier.SetupConstantMemberVariables(cell_population);
+
+        multi_array<double, 3>& r_force_grids = modifier.mpArrays->rGetModifiableForceGrids();
+        std::fill(r_force_grids.data(), r_force_grids.data() + r_force_grids.num_elements(), 0.0);
+
+        modifier.PropagateForcesToFluidGrid();
+        multi_array<double, 3> serial_force_grids = r_force_grids;
+
+        // The total force on the grid matches the total force on the nodes, as the delta function weights sum to one
+        double total_node_force_x = 0.0;
+        for (ImmersedBoundaryMesh<2,2>::ImmersedBoundaryElementIterator elem_iter = p_mesh->GetElementIteratorBegin(false);
+             elem_iter != p_mesh->GetElementIteratorEnd();
+             ++elem_iter)
+        {
+            double dl = p_mesh->GetAverageNodeSpacingOfElement(elem_iter->GetIndex(), false);
+            for (unsigned node_idx = 0; node_idx < elem_iter->GetNumNodes(); node_idx++)
+            {
+                total_node_force_x += elem_iter->GetNode(node_idx)->rGetAppliedForce()[0] * dl;
+            }
+        }
+
+        double total_grid_force_x = 0.0;
+        for (unsigned x=0; x<modifier.mNumGridPtsX; x++)
+        {
+            for (unsigned y=0; y<modifier.mNumGridPtsY; y++)
+            {
+                total_grid_force_x += r_force_grids[0][x][y];
+            }
+        }
+        total_grid_force_x *= modifier.mGridSpacingX * modifier.mGridSpacingY;
+
+        TS_ASSERT_DELTA(total_grid_force_x, total_node_force_x, 1e-10);
+
+        // The node stencils are stored for reuse by the cell population
+        TS_ASSERT(cell_population.rGetNodeStencilCache().IsValid(4, p_mesh->rGetNodeArrays().GetNumSlots()));
+
+        // Spreading with several threads gives identical results
+        TS_ASSERT_EQUALS(modifier.GetNumSpreadingThreads(), 1u);
+        modifier.SetNumSpreadingThreads(4);
+        TS_ASSERT_EQUALS(modifier.GetNumSpreadingThreads(), 4u);
+
+        std::fill(r_force_grids.data(), r_force_grids.data() + r_force_grids.num_elements(), 0.0);
+        modifier.PropagateForcesToFluidGrid();
+
+        for (unsigned dim=0; dim<2; dim++)
+        {
+            for (unsigned x=0; x<modifier.mNumGridPtsX; x++)
+            {
+                for (unsigned y=0; y<modifier.mNumGridPtsY; y++)
+                {
+                    TS_ASSERT_EQUALS(r_force_grids[dim][x][y], serial_force_grids[dim][x][y]);
+                }
+            }
+        }
     }
 
     void TestPropagateFluidSourcesToGrid() throw(Exception)
@@ -220,14 +612,136 @@ public:
         ///\todo Test this method
     }
 
-    void TestDelta1D() throw(Exception)
+    void TestUpwind2d() throw(Exception)
     {
-        ///\todo Test this method
+        ImmersedBoundarySimulationModifier<2> modifier;
+        modifier.SetMemberVariablesForTesting(5, 4);
+
+        multi_array<double, 3> input(extents[2][4][5]);
+        multi_array<double, 3> output(extents[2][4][5]);
+
+        // Uniform positive x velocity, and a y velocity that varies only in x
+        for (unsigned x = 0; x < 4; x++)
+        {
+            for (unsigned y = 0; y < 5; y++)
+            {
+                input[0][x][y] = 1.0;
+                input[1][x][y] = (double) x;
+            }
+        }
+
+        modifier.Upwind2d(input, output);
+
+        for (unsigned x = 0; x < 4; x++)
+        {
+            for (unsigned y = 0; y < 5; y++)
+            {
+                TS_ASSERT_DELTA(output[0][x][y], 0.0, 1e-12);
+
+                // Backward difference in x, with periodic wrap-around at x = 0
+                double expected = (x == 0) ? -12.0 : 4.0;
+                TS_ASSERT_DELTA(output[1][x][y], expected, 1e-12);
+            }
+        }
+
+        // Negative x velocity that varies only in y, and a uniform negative y velocity
+        for (unsigned x = 0; x < 4; x++)
+        {
+            for (unsigned y = 0; y < 5; y++)
+            {
+                input[0][x][y] = -1.0 - (double) y;
+                input[1][x][y] = -1.0;
+            }
+        }
+
+        modifier.Upwind2d(input, output);
+
+        for (unsigned x = 0; x < 4; x++)
+        {
+            for (unsigned y = 0; y < 5; y++)
+            {
+                // Forward difference in y, with periodic wrap-around at y = 4
+                double expected = (y == 4) ? -20.0 : 5.0;
+                TS_ASSERT_DELTA(output[0][x][y], expected, 1e-12);
+                TS_ASSERT_DELTA(output[1][x][y], 0.0, 1e-12);
+            }
+        }
     }
 
-    void TestUpwind2d() throw(Exception)
+    void TestAssembleRightHandSide2d() throw(Exception)
     {
-        ///\todo Test this method
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(1.0, 10);
+        double dt = SimulationTime::Instance()->GetTimeStep();
+
+        ImmersedBoundarySimulationModifier<2> modifier;
+        modifier.SetMemberVariablesForTesting(6, 5);
+        modifier.SetReynoldsNumber(0.5);
+
+        multi_array<double, 3> vel_grids(extents[2][5][6]);
+        multi_array<double, 3> force_grids(extents[2][5][6]);
+        multi_array<double, 3> rhs_grids(extents[3][5][6]);
+
+        for (unsigned x = 0; x < 5; x++)
+        {
+            for (unsigned y = 0; y < 6; y++)
+            {
+                vel_grids[0][x][y] = sin(1.0 + x * y);
+                vel_grids[1][x][y] = cos(2.0 * x + y);
+                force_grids[0][x][y] = 0.1 * x;
+                force_grids[1][x][y] = 0.2 * y;
+                rhs_grids[2][x][y] = (double) (x * x + 2 * y);
+            }
+        }
+
+        // Calculate the expected right hand side from the separate upwind and source gradient methods
+        multi_array<double, 3> upwind(extents[2][5][6]);
+        modifier.Upwind2d(vel_grids, upwind);
+
+        multi_array<double, 3> expected(extents[2][5][6]);
+        for (unsigned x = 0; x < 5; x++)
+        {
+            for (unsigned y = 0; y < 6; y++)
+            {
+                double grad_x = 2.5 * (rhs_grids[2][(x + 1) % 5][y] - rhs_grids[2][(x + 4) % 5][y]);
+                double grad_y = 3.0 * (rhs_grids[2][x][(y + 1) % 6] - rhs_grids[2][x][(y + 5) % 6]);
+
+                expected[0][x][y] = vel_grids[0][x][y] + dt * (force_grids[0][x][y] + grad_x / 1.5 - upwind[0][x][y]);
+                expected[1][x][y] = vel_grids[1][x][y] + dt * (force_grids[1][x][y] + grad_y / 1.5 - upwind[1][x][y]);
+            }
+        }
+
+        modifier.AssembleRightHandSide2d<true>(vel_grids, force_grids, rhs_grids);
+
+        for (unsigned x = 0; x < 5; x++)
+        {
+            for (unsigned y = 0; y < 6; y++)
+            {
+                for (unsigned dim = 0; dim < 2; dim++)
+                {
+                    TS_ASSERT_DELTA(rhs_grids[dim][x][y], expected[dim][x][y], 1e-12);
+
+                    // The force grids are cleared as they are consumed
+                    TS_ASSERT_DELTA(force_grids[dim][x][y], 0.0, 1e-12);
+                }
+
+                // The source strengths are unchanged
+                TS_ASSERT_DELTA(rhs_grids[2][x][y], (double) (x * x + 2 * y), 1e-12);
+            }
+        }
+
+        // Without active sources, the right hand side is just vel - dt * upwind since the forces are now zero
+        modifier.AssembleRightHandSide2d<false>(vel_grids, force_grids, rhs_grids);
+
+        for (unsigned x = 0; x < 5; x++)
+        {
+            for (unsigned y = 0; y < 6; y++)
+            {
+                for (unsigned dim = 0; dim < 2; dim++)
+                {
+                    TS_ASSERT_DELTA(rhs_grids[dim][x][y], vel_grids[dim][x][y] - dt * upwind[dim][x][y], 1e-12);
+                }
+            }
+        }
     }
 
     void TestSetMemberVariablesForTesting() throw(Exception)
@@ -284,10 +798,866 @@ public:
         // Note: testing of the force calculations themselves occurs in TestImmersedBoundaryForces
         modifier.AddImmersedBoundaryForceContributions();
 
+        // The forces add their contributions to the mesh's node arrays, which are copied back to the nodes on request
+        p_mesh->SynchroniseNodeAppliedForces();
+
         TS_ASSERT_DELTA(p_mesh->GetNode(0)->rGetAppliedForce()[0], -125.2290, 1e-3);
         TS_ASSERT_DELTA(p_mesh->GetNode(0)->rGetAppliedForce()[1], 6352.7140, 1e-3);
 
         TS_ASSERT_DELTA(p_mesh->GetNode(5)->rGetAppliedForce()[0], -1235.1356, 1e-3);
         TS_ASSERT_DELTA(p_mesh->GetNode(5)->rGetAppliedForce()[1], 16800.5590, 1e-3);
     }
+
+    void TestPhaseTimings() throw(Exception)
+    {
+        // Set up SimulationTime - needed by SetupConstantMemberVariables()
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(2.0, 2);
+
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+
+        ImmersedBoundarySimulationModifier<2> modifier;
+        MAKE_PTR(ImmersedBoundaryMembraneElasticityForce<2>, p_boundary_force);
+        modifier.AddImmersedBoundaryForce(p_boundary_force);
+        MAKE_PTR(ImmersedBoundaryCellCellInteractionForce<2>, p_cell_cell_force);
+        modifier.AddImmersedBoundaryForce(p_cell_cell_force);
+
+        TS_ASSERT_EQUALS(modifier.GetTimingOutputFrequency(), 0u);
+        modifier.SetTimingOutputFrequency(1);
+        TS_ASSERT_EQUALS(modifier.GetTimingOutputFrequency(), 1u);
+
+        // Setting up the simulation calculates the node pairs and solves the fluid problem once
+        modifier.SetupSolve(cell_population, "TestImmersedBoundaryPhaseTimings");
+
+        const ImmersedBoundaryPhaseTimer& r_timer = modifier.rGetPhaseTimer();
+        TS_ASSERT_EQUALS(r_timer.GetNumCalls(r_timer.GetPhaseIndex("CalculateNodePairs")), 1u);
+        TS_ASSERT_EQUALS(r_timer.GetNumCalls(r_timer.GetPhaseIndex("ClearForcesAndSources")), 1u);
+        TS_ASSERT_EQUALS(r_timer.GetNumCalls(r_timer.GetPhaseIndex("SolveNavierStokesSpectral")), 1u);
+        TS_ASSERT_EQUALS(r_timer.GetNumCalls(r_timer.GetPhaseIndex("FftExecuteForward")), 1u);
+        TS_ASSERT_EQUALS(r_timer.GetNumCalls(r_timer.GetPhaseIndex("PropagateFluidSourcesToGrid")), 0u);
+
+        // Each class of force is timed separately, within the phase adding all force contributions
+        unsigned membrane_phase = r_timer.GetPhaseIndex("ImmersedBoundaryMembraneElasticityForce-2");
+        unsigned cell_cell_phase = r_timer.GetPhaseIndex("ImmersedBoundaryCellCellInteractionForce-2");
+        TS_ASSERT_EQUALS(r_timer.GetNumCalls(membrane_phase), 1u);
+        TS_ASSERT_EQUALS(r_timer.GetNumCalls(cell_cell_phase), 1u);
+        TS_ASSERT_LESS_THAN_EQUALS(r_timer.GetTotalTime(membrane_phase) + r_timer.GetTotalTime(cell_cell_phase),
+                                   r_timer.GetTotalTime(r_timer.GetPhaseIndex("AddImmersedBoundaryForceContributions")));
+
+        // The cell population times its node updates in the same timer
+        cell_population.UpdateNodeLocations(0.001);
+        TS_ASSERT_EQUALS(r_timer.GetNumCalls(r_timer.GetPhaseIndex("UpdateNodeLocations")), 1u);
+
+        // The timings are written to file at the end of each timestep, with this output frequency
+        modifier.UpdateAtEndOfTimeStep(cell_population);
+        TS_ASSERT_EQUALS(r_timer.GetNumCalls(r_timer.GetPhaseIndex("SolveNavierStokesSpectral")), 2u);
+
+        FileFinder timings_file("TestImmersedBoundaryPhaseTimings/phase_timings_0.csv", RelativeTo::ChasteTestOutput);
+        TS_ASSERT(timings_file.Exists());
+    }
+
+    void TestPhaseTimerOutlivesModifier() throw(Exception)
+    {
+        // Set up SimulationTime - needed by SetupConstantMemberVariables()
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(2.0, 2);
+
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+
+        // The population shares the timer with the modifier, so it may be used after the modifier is destroyed
+        boost::shared_ptr<ImmersedBoundaryPhaseTimer> p_timer;
+        {
+            ImmersedBoundarySimulationModifier<2> modifier;
+            modifier.SetupSolve(cell_population, "TestImmersedBoundaryPhaseTimerOutlivesModifier");
+            p_timer = modifier.mpPhaseTimer;
+            TS_ASSERT_EQUALS(p_timer.use_count(), 3);
+        }
+        TS_ASSERT_EQUALS(p_timer.use_count(), 2);
+
+        unsigned phase = p_timer->GetPhaseIndex("UpdateNodeLocations");
+        TS_ASSERT_EQUALS(p_timer->GetNumCalls(phase), 0u);
+        cell_population.UpdateNodeLocations(SimulationTime::Instance()->GetTimeStep());
+        TS_ASSERT_EQUALS(p_timer->GetNumCalls(phase), 1u);
+    }
+
+    void TestLowMemoryGridsGiveSameSolution() throw(Exception)
+    {
+        // Set up SimulationTime - needed by SetupConstantMemberVariables()
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(2.0, 2);
+
+        // Two identical simulations, the second with the low-memory grid layout
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryPalisadeMeshGenerator low_memory_gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        ImmersedBoundaryMesh<2,2>* p_low_memory_mesh = low_memory_gen.GetMesh();
+
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        std::vector<CellPtr> cells;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        std::vector<CellPtr> low_memory_cells;
+        cells_generator.GenerateBasicRandom(low_memory_cells, p_low_memory_mesh->GetNumElements(), p_diff_type);
+
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+        ImmersedBoundaryCellPopulation<2> low_memory_population(*p_low_memory_mesh, low_memory_cells);
+        cell_population.SetIfPopulationHasActiveSources(true);
+        low_memory_population.SetIfPopulationHasActiveSources(true);
+
+        ImmersedBoundarySimulationModifier<2> modifier;
+        ImmersedBoundarySimulationModifier<2> low_memory_modifier;
+        low_memory_modifier.SetUseLowMemoryGrids(true);
+
+        MAKE_PTR(ImmersedBoundaryMembraneElasticityForce<2>, p_boundary_force);
+        modifier.AddImmersedBoundaryForce(p_boundary_force);
+        low_memory_modifier.AddImmersedBoundaryForce(p_boundary_force);
+
+        modifier.SetStorePressureGrid(true);
+        low_memory_modifier.SetStorePressureGrid(true);
+
+        // Setting up each simulation solves the fluid problem once
+        modifier.SetupSolve(cell_population, "TestLowMemoryGrids");
+        low_memory_modifier.SetupSolve(low_memory_population, "TestLowMemoryGrids");
+
+        TS_ASSERT_EQUALS(low_memory_modifier.GetArrays()->IsLowMemory(), true);
+        TS_ASSERT_LESS_THAN(low_memory_modifier.GetArrays()->GetNumBytes(), modifier.GetArrays()->GetNumBytes());
+
+        const multi_array<double, 3>& r_vel_grids = p_mesh->rGet2dVelocityGrids();
+        const multi_array<double, 3>& r_low_memory_vel_grids = p_low_memory_mesh->rGet2dVelocityGrids();
+        multi_array_ref<std::complex<double>, 2>& r_pressure = modifier.GetArrays()->rGetModifiablePressureGrid();
+        multi_array_ref<std::complex<double>, 2>& r_low_memory_pressure =
+                low_memory_modifier.GetArrays()->rGetModifiablePressureGrid();
+
+        for (unsigned x = 0; x < 256; x++)
+        {
+            for (unsigned y = 0; y < 256; y++)
+            {
+                TS_ASSERT_DELTA(r_low_memory_vel_grids[0][x][y], r_vel_grids[0][x][y], 1e-12);
+                TS_ASSERT_DELTA(r_low_memory_vel_grids[1][x][y], r_vel_grids[1][x][y], 1e-12);
+            }
+            for (unsigned y = 0; y < 129; y++)
+            {
+                TS_ASSERT_DELTA(std::abs(r_low_memory_pressure[x][y] - r_pressure[x][y]), 0.0, 1e-12);
+            }
+        }
+    }
+
+    void TestFftInterfaceFactory() throw(Exception)
+    {
+        // Set up SimulationTime - needed by SetupConstantMemberVariables()
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(2.0, 2);
+
+        // Two identical simulations, the second with its transforms performed by a backend made by a factory
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryPalisadeMeshGenerator factory_gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        ImmersedBoundaryMesh<2,2>* p_factory_mesh = factory_gen.GetMesh();
+
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        std::vector<CellPtr> cells;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        std::vector<CellPtr> factory_cells;
+        cells_generator.GenerateBasicRandom(factory_cells, p_factory_mesh->GetNumElements(), p_diff_type);
+
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+        ImmersedBoundaryCellPopulation<2> factory_population(*p_factory_mesh, factory_cells);
+        cell_population.SetIfPopulationHasActiveSources(true);
+        factory_population.SetIfPopulationHasActiveSources(true);
+
+        ImmersedBoundarySimulationModifier<2> modifier;
+        ImmersedBoundarySimulationModifier<2> factory_modifier;
+        TS_ASSERT(!factory_modifier.GetFftInterfaceFactory());
+        MAKE_PTR(CountingFftInterfaceFactory, p_factory);
+        factory_modifier.SetFftInterfaceFactory(p_factory);
+        TS_ASSERT(factory_modifier.GetFftInterfaceFactory() == p_factory);
+
+        MAKE_PTR(ImmersedBoundaryMembraneElasticityForce<2>, p_boundary_force);
+        modifier.AddImmersedBoundaryForce(p_boundary_force);
+        factory_modifier.AddImmersedBoundaryForce(p_boundary_force);
+
+        // Setting up each simulation solves the fluid problem once, with one transform in each direction
+        modifier.SetupSolve(cell_population, "TestFftInterfaceFactory");
+        factory_modifier.SetupSolve(factory_population, "TestFftInterfaceFactory");
+
+        TS_ASSERT_EQUALS(p_factory->mNumCreated, 1u);
+        TS_ASSERT_EQUALS(p_factory->mNumForward, 1u);
+        TS_ASSERT_EQUALS(p_factory->mNumInverse, 1u);
+        TS_ASSERT(dynamic_cast<CountingFftInterface*>(factory_modifier.GetFftInterface()) != NULL);
+        TS_ASSERT(dynamic_cast<CountingFftInterface*>(modifier.GetFftInterface()) == NULL);
+
+        // The backend is handed the grids of the solver, so the solution is that of the fftw backend
+        const multi_array<double, 3>& r_vel_grids = p_mesh->rGet2dVelocityGrids();
+        const multi_array<double, 3>& r_factory_vel_grids = p_factory_mesh->rGet2dVelocityGrids();
+        for (unsigned x = 0; x < 256; x++)
+        {
+            for (unsigned y = 0; y < 256; y++)
+            {
+                TS_ASSERT_DELTA(r_factory_vel_grids[0][x][y], r_vel_grids[0][x][y], 1e-12);
+                TS_ASSERT_DELTA(r_factory_vel_grids[1][x][y], r_vel_grids[1][x][y], 1e-12);
+            }
+        }
+
+        // A backend made by a factory is only supported for a fluid solved in double precision
+        ImmersedBoundaryPalisadeMeshGenerator single_gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_single_mesh = single_gen.GetMesh();
+        std::vector<CellPtr> single_cells;
+        cells_generator.GenerateBasicRandom(single_cells, p_single_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> single_population(*p_single_mesh, single_cells);
+
+        ImmersedBoundarySimulationModifier<2> single_modifier;
+        single_modifier.AddImmersedBoundaryForce(p_boundary_force);
+        single_modifier.SetUseSinglePrecisionFluid(true);
+        single_modifier.SetFftInterfaceFactory(p_factory);
+        TS_ASSERT_THROWS_THIS(single_modifier.SetupSolve(single_population, "TestFftInterfaceFactory"),
+                "An FFT interface factory may only be used for periodic transforms in double precision, without a shared FFT interface");
+        TS_ASSERT_EQUALS(p_factory->mNumCreated, 1u);
+    }
+
+    void TestTaskGraphGivesSameSolution() throw(Exception)
+    {
+        // Set up SimulationTime - needed by SetupConstantMemberVariables()
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(2.0, 2);
+
+        // Two identical simulations, the second running the phases of each timestep as a task graph
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryPalisadeMeshGenerator task_graph_gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        ImmersedBoundaryMesh<2,2>* p_task_graph_mesh = task_graph_gen.GetMesh();
+
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        std::vector<CellPtr> cells;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        std::vector<CellPtr> task_graph_cells;
+        cells_generator.GenerateBasicRandom(task_graph_cells, p_task_graph_mesh->GetNumElements(), p_diff_type);
+
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+        ImmersedBoundaryCellPopulation<2> task_graph_population(*p_task_graph_mesh, task_graph_cells);
+        cell_population.SetIfPopulationHasActiveSources(true);
+        task_graph_population.SetIfPopulationHasActiveSources(true);
+
+        ImmersedBoundarySimulationModifier<2> modifier;
+        ImmersedBoundarySimulationModifier<2> task_graph_modifier;
+        task_graph_modifier.SetNumTaskGraphThreads(4);
+
+        // The membrane force does not use the node pairs, so is calculated while they are recalculated
+        MAKE_PTR(ImmersedBoundaryMembraneElasticityForce<2>, p_boundary_force);
+        MAKE_PTR(ImmersedBoundaryMembraneElasticityForce<2>, p_task_graph_boundary_force);
+        MAKE_PTR(ImmersedBoundaryCellCellInteractionForce<2>, p_cell_cell_force);
+        MAKE_PTR(ImmersedBoundaryCellCellInteractionForce<2>, p_task_graph_cell_cell_force);
+        modifier.AddImmersedBoundaryForce(p_boundary_force);
+        modifier.AddImmersedBoundaryForce(p_cell_cell_force);
+        task_graph_modifier.AddImmersedBoundaryForce(p_task_graph_boundary_force);
+        task_graph_modifier.AddImmersedBoundaryForce(p_task_graph_cell_cell_force);
+
+        // The first solve, in SetupSolve(), calculates the forces in turn; the node pairs are recalculated each timestep
+        modifier.SetupSolve(cell_population, "TestTaskGraph");
+        task_graph_modifier.SetupSolve(task_graph_population, "TestTaskGraph");
+        for (unsigned step = 0; step < 2; step++)
+        {
+            modifier.UpdateAtEndOfTimeStep(cell_population);
+            task_graph_modifier.UpdateAtEndOfTimeStep(task_graph_population);
+        }
+        TS_ASSERT_EQUALS(task_graph_modifier.GetNumNodePairCalculations(), modifier.GetNumNodePairCalculations());
+        TS_ASSERT_EQUALS(task_graph_modifier.mTaskGraph.GetNumTasks(), 8u);
+
+        // The forces are summed in a different order, so the solutions differ only by rounding
+        const multi_array<double, 3>& r_vel_grids = p_mesh->rGet2dVelocityGrids();
+        const multi_array<double, 3>& r_task_graph_vel_grids = p_task_graph_mesh->rGet2dVelocityGrids();
+        for (unsigned x = 0; x < 256; x++)
+        {
+            for (unsigned y = 0; y < 256; y++)
+            {
+                TS_ASSERT_DELTA(r_task_graph_vel_grids[0][x][y], r_vel_grids[0][x][y], 1e-9);
+                TS_ASSERT_DELTA(r_task_graph_vel_grids[1][x][y], r_vel_grids[1][x][y], 1e-9);
+            }
+        }
+
+        // Forces must use the node arrays to be calculated in the task graph
+        TS_ASSERT_EQUALS(task_graph_modifier.UsesTaskGraph(), true);
+    }
+
+    void TestGridOutput() throw(Exception)
+    {
+        // Set up SimulationTime - needed by SetupConstantMemberVariables()
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(2.0, 2);
+
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+
+        ImmersedBoundarySimulationModifier<2> modifier;
+        MAKE_PTR(ImmersedBoundaryMembraneElasticityForce<2>, p_boundary_force);
+        modifier.AddImmersedBoundaryForce(p_boundary_force);
+
+        TS_ASSERT_EQUALS(modifier.GetGridOutputFrequency(), 0u);
+        modifier.SetGridOutputFrequency(1);
+        TS_ASSERT_EQUALS(modifier.GetGridOutputFrequency(), 1u);
+        modifier.SetStorePressureGrid(true);
+
+        // The initial solution and the solution at the end of each timestep are written
+        modifier.SetupSolve(cell_population, "TestImmersedBoundaryGridOutput");
+        modifier.UpdateAtEndOfTimeStep(cell_population);
+        TS_ASSERT_EQUALS(modifier.mpGridWriter->GetNumStepsWritten(), 2u);
+
+        FileFinder grid_file("TestImmersedBoundaryGridOutput/fluid_grids.h5", RelativeTo::ChasteTestOutput);
+        TS_ASSERT(grid_file.Exists());
+
+        // The force grids spread for each solve are written, although the solve clears them
+        TS_ASSERT_EQUALS(modifier.mOutputForceGrids.num_elements(), 2 * p_mesh->GetNumGridPtsX() * p_mesh->GetNumGridPtsY());
+        double max_force = 0.0;
+        for (unsigned i = 0; i < modifier.mOutputForceGrids.num_elements(); i++)
+        {
+            max_force = std::max(max_force, fabs(modifier.mOutputForceGrids.data()[i]));
+        }
+        TS_ASSERT_LESS_THAN(0.0, max_force);
+
+        modifier.mpGridWriter->Close();
+        hid_t file = H5Fopen(grid_file.GetAbsolutePath().c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+        TS_ASSERT(H5Lexists(file, "Force", H5P_DEFAULT) > 0);
+        TS_ASSERT(H5Lexists(file, "PressureSpectrum", H5P_DEFAULT) > 0);
+        H5Fclose(file);
+    }
+
+    void TestFluidReducers() throw(Exception)
+    {
+        // Set up SimulationTime - needed by SetupConstantMemberVariables()
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(2.0, 2);
+
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        std::vector<CellPtr> cells;
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+
+        ImmersedBoundarySimulationModifier<2> modifier;
+        MAKE_PTR(ImmersedBoundaryMembraneElasticityForce<2>, p_boundary_force);
+        modifier.AddImmersedBoundaryForce(p_boundary_force);
+
+        MAKE_PTR(ImmersedBoundaryVorticityReducer, p_vorticity_reducer);
+        modifier.AddFluidReducer(p_vorticity_reducer);
+        MAKE_PTR(ImmersedBoundaryEnergySpectrumReducer, p_spectrum_reducer);
+        modifier.AddFluidReducer(p_spectrum_reducer);
+        TS_ASSERT_EQUALS(modifier.rGetFluidReducers().size(), 2u);
+
+        TS_ASSERT_EQUALS(modifier.GetFluidReducerOutputFrequency(), 0u);
+        modifier.SetFluidReducerOutputFrequency(1);
+        TS_ASSERT_EQUALS(modifier.GetFluidReducerOutputFrequency(), 1u);
+
+        // The reducers are run on the initial solution and at the end of each timestep
+        modifier.SetupSolve(cell_population, "TestImmersedBoundaryFluidReducerOutput");
+        modifier.UpdateAtEndOfTimeStep(cell_population);
+
+        unsigned num_shells = p_spectrum_reducer->rGetShellEnergies().size();
+        TS_ASSERT_EQUALS(p_vorticity_reducer->rGetWriter().GetNumRowsStreamed(), 2u);
+        TS_ASSERT_EQUALS(p_spectrum_reducer->rGetWriter().GetNumRowsStreamed(), 2 * num_shells);
+
+        // The spectrum is taken from the Fourier grids of the solve, and sums to the mean kinetic energy of the solution
+        const multi_array<double, 3>& r_vel_grids = p_mesh->rGet2dVelocityGrids();
+        double mean_energy = 0.0;
+        for (unsigned x = 0; x < r_vel_grids.shape()[1]; x++)
+        {
+            for (unsigned y = 0; y < r_vel_grids.shape()[2]; y++)
+            {
+                mean_energy += 0.5 * (r_vel_grids[0][x][y] * r_vel_grids[0][x][y] + r_vel_grids[1][x][y] * r_vel_grids[1][x][y]);
+            }
+        }
+        mean_energy /= r_vel_grids.shape()[1] * r_vel_grids.shape()[2];
+
+        double spectrum_energy = 0.0;
+        for (unsigned shell = 0; shell < num_shells; shell++)
+        {
+            spectrum_energy += p_spectrum_reducer->rGetShellEnergies()[shell];
+        }
+        TS_ASSERT_LESS_THAN(0.0, mean_energy);
+        TS_ASSERT_DELTA(spectrum_energy, mean_energy, 1e-9 * mean_energy);
+
+        const ImmersedBoundaryPhaseTimer& r_timer = modifier.rGetPhaseTimer();
+        TS_ASSERT_EQUALS(r_timer.GetNumCalls(r_timer.GetPhaseIndex("ReduceFluidGrids")), 4u);
+
+        FileFinder vorticity_file("TestImmersedBoundaryFluidReducerOutput/vorticity.csv", RelativeTo::ChasteTestOutput);
+        TS_ASSERT(vorticity_file.Exists());
+    }
+
+    void TestCheckpointRestart() throw(Exception)
+    {
+        // Set up SimulationTime - needed by SetupConstantMemberVariables()
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(2.0, 2);
+
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        MAKE_PTR(ImmersedBoundaryMembraneElasticityForce<2>, p_boundary_force);
+        MAKE_PTR(ImmersedBoundaryCellCellInteractionForce<2>, p_cell_cell_force);
+
+        // Run a simulation for a step, then save a checkpoint
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        std::vector<CellPtr> cells;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+
+        ImmersedBoundarySimulationModifier<2> modifier;
+        modifier.AddImmersedBoundaryForce(p_boundary_force);
+        modifier.AddImmersedBoundaryForce(p_cell_cell_force);
+
+        TS_ASSERT_THROWS_THIS(modifier.SaveCheckpoint("TestImmersedBoundaryCheckpoint"),
+                "A checkpoint can only be saved once SetupSolve() has been called");
+
+        TS_ASSERT_EQUALS(modifier.GetCheckpointFrequency(), 0u);
+        modifier.SetCheckpointFrequency(1);
+        TS_ASSERT_EQUALS(modifier.GetCheckpointFrequency(), 1u);
+
+        modifier.SetupSolve(cell_population, "TestImmersedBoundaryCheckpoint");
+        cell_population.UpdateNodeLocations(0.001);
+        modifier.UpdateAtEndOfTimeStep(cell_population);
+
+        FileFinder checkpoint_file("TestImmersedBoundaryCheckpoint/checkpoint.ibc", RelativeTo::ChasteTestOutput);
+        TS_ASSERT(checkpoint_file.Exists());
+
+        // Set up the same simulation afresh, and restart it from the checkpoint
+        ImmersedBoundaryPalisadeMeshGenerator restart_gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_restart_mesh = restart_gen.GetMesh();
+        std::vector<CellPtr> restart_cells;
+        cells_generator.GenerateBasicRandom(restart_cells, p_restart_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> restart_population(*p_restart_mesh, restart_cells);
+
+        ImmersedBoundarySimulationModifier<2> restart_modifier;
+        restart_modifier.AddImmersedBoundaryForce(p_boundary_force);
+        restart_modifier.AddImmersedBoundaryForce(p_cell_cell_force);
+
+        FileFinder missing_file("TestImmersedBoundaryCheckpoint/missing.ibc", RelativeTo::ChasteTestOutput);
+        TS_ASSERT_THROWS_CONTAINS(restart_modifier.SetRestartCheckpoint(missing_file), "does not exist");
+
+        restart_modifier.SetRestartCheckpoint(checkpoint_file);
+        restart_modifier.SetupSolve(restart_population, "TestImmersedBoundaryCheckpointRestart");
+
+        // Neither the node pairs nor the fluid velocity are recalculated
+        const ImmersedBoundaryPhaseTimer& r_timer = restart_modifier.rGetPhaseTimer();
+        TS_ASSERT_EQUALS(r_timer.GetNumCalls(r_timer.GetPhaseIndex("CalculateNodePairs")), 0u);
+        TS_ASSERT_EQUALS(r_timer.GetNumCalls(r_timer.GetPhaseIndex("SolveNavierStokesSpectral")), 0u);
+
+        // The state is restored exactly
+        TS_ASSERT_EQUALS(restart_modifier.mpNodePairList->GetNumPairs(), modifier.mpNodePairList->GetNumPairs());
+        TS_ASSERT_DELTA(restart_population.GetNodeDisplacementBound(), cell_population.GetNodeDisplacementBound(), 1e-15);
+
+        for (unsigned node_idx = 0; node_idx < p_mesh->GetNumNodes(); node_idx++)
+        {
+            TS_ASSERT_DELTA(p_restart_mesh->GetNode(node_idx)->rGetLocation()[0], p_mesh->GetNode(node_idx)->rGetLocation()[0], 1e-15);
+            TS_ASSERT_DELTA(p_restart_mesh->GetNode(node_idx)->rGetLocation()[1], p_mesh->GetNode(node_idx)->rGetLocation()[1], 1e-15);
+        }
+
+        const multi_array<double, 3>& r_grids = p_mesh->rGet2dVelocityGrids();
+        const multi_array<double, 3>& r_restart_grids = p_restart_mesh->rGet2dVelocityGrids();
+        for (unsigned x = 0; x < p_mesh->GetNumGridPtsX(); x++)
+        {
+            for (unsigned y = 0; y < p_mesh->GetNumGridPtsY(); y++)
+            {
+                TS_ASSERT_DELTA(r_restart_grids[0][x][y], r_grids[0][x][y], 1e-15);
+                TS_ASSERT_DELTA(r_restart_grids[1][x][y], r_grids[1][x][y], 1e-15);
+            }
+        }
+
+        // A restart set up differently from the simulation that saved the checkpoint is refused
+        ImmersedBoundarySimulationModifier<2> wrong_modifier;
+        wrong_modifier.AddImmersedBoundaryForce(p_boundary_force);
+        wrong_modifier.SetRestartCheckpoint(checkpoint_file);
+        TS_ASSERT_THROWS_THIS(wrong_modifier.SetupSolve(restart_population, "TestImmersedBoundaryCheckpointRestart"),
+                "The checkpoint was saved with different forces");
+
+        // A restart onto a mesh of different size or topology is refused, as the mesh itself is not restored
+        ImmersedBoundaryPalisadeMeshGenerator bigger_gen(6, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_bigger_mesh = bigger_gen.GetMesh();
+        std::vector<CellPtr> bigger_cells;
+        cells_generator.GenerateBasicRandom(bigger_cells, p_bigger_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> bigger_population(*p_bigger_mesh, bigger_cells);
+
+        ImmersedBoundarySimulationModifier<2> bigger_modifier;
+        bigger_modifier.AddImmersedBoundaryForce(p_boundary_force);
+        bigger_modifier.AddImmersedBoundaryForce(p_cell_cell_force);
+        bigger_modifier.SetRestartCheckpoint(checkpoint_file);
+        TS_ASSERT_THROWS_CONTAINS(bigger_modifier.SetupSolve(bigger_population, "TestImmersedBoundaryCheckpointRestart"),
+                "a checkpoint can only be restored to the mesh it was saved from");
+
+        ImmersedBoundaryPalisadeMeshGenerator rotated_gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_rotated_mesh = rotated_gen.GetMesh();
+        ImmersedBoundaryElement<2,2>* p_element = p_rotated_mesh->GetElement(1);
+        std::vector<Node<2>*> rotated_nodes;
+        for (unsigned local_idx = 0; local_idx < p_element->GetNumNodes(); local_idx++)
+        {
+            rotated_nodes.push_back(p_element->GetNode((local_idx + 1) % p_element->GetNumNodes()));
+        }
+        p_element->ReplaceNodes(rotated_nodes);
+        std::vector<CellPtr> rotated_cells;
+        cells_generator.GenerateBasicRandom(rotated_cells, p_rotated_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> rotated_population(*p_rotated_mesh, rotated_cells);
+
+        ImmersedBoundarySimulationModifier<2> rotated_modifier;
+        rotated_modifier.AddImmersedBoundaryForce(p_boundary_force);
+        rotated_modifier.AddImmersedBoundaryForce(p_cell_cell_force);
+        rotated_modifier.SetRestartCheckpoint(checkpoint_file);
+        TS_ASSERT_THROWS_CONTAINS(rotated_modifier.SetupSolve(rotated_population, "TestImmersedBoundaryCheckpointRestart"),
+                "The checkpoint was saved with elements made of different nodes");
+    }
+
+    void TestAdaptiveTimestepKeepsOutputCadence() throw(Exception)
+    {
+        // Set up SimulationTime with a timestep above the largest the adaptive timestepping allows, so it must shrink
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(1.0, 100);
+
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        MAKE_PTR(ImmersedBoundaryMembraneElasticityForce<2>, p_boundary_force);
+
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        std::vector<CellPtr> cells;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+
+        ImmersedBoundarySimulationModifier<2> modifier;
+        modifier.AddImmersedBoundaryForce(p_boundary_force);
+        modifier.SetUseAdaptiveTimestep(true);
+        modifier.SetAdaptiveTimestepBounds(1e-4, 5e-3);
+
+        TS_ASSERT_EQUALS(modifier.GetTimestepAdaptationInterval(), 1u);
+        modifier.SetTimestepAdaptationInterval(3);
+        TS_ASSERT_EQUALS(modifier.GetTimestepAdaptationInterval(), 3u);
+
+        modifier.SetGridOutputFrequency(2);
+        modifier.SetCheckpointFrequency(2);
+        modifier.SetupSolve(cell_population, "TestAdaptiveTimestepOutputCadence");
+        TS_ASSERT_EQUALS(modifier.GetTimeStepsElapsed(), 0u);
+
+        std::vector<double> output_times(1, 0.0);
+        for (unsigned step = 1; step <= 5; step++)
+        {
+            cell_population.UpdateNodeLocations(SimulationTime::Instance()->GetTimeStep());
+            SimulationTime::Instance()->IncrementTimeOneStep();
+            if (step % 2 == 0)
+            {
+                output_times.push_back(SimulationTime::Instance()->GetTime());
+            }
+            modifier.UpdateAtEndOfTimeStep(cell_population);
+
+            // The timestep only shrinks at the end of the third timestep, where SimulationTime restarts its count
+            TS_ASSERT_EQUALS(modifier.GetTimeStepsElapsed(), step);
+            if (step < 3)
+            {
+                TS_ASSERT_DELTA(SimulationTime::Instance()->GetTimeStep(), 0.01, 1e-12);
+                TS_ASSERT_EQUALS(SimulationTime::Instance()->GetTimeStepsElapsed(), step);
+            }
+            else
+            {
+                TS_ASSERT_LESS_THAN_EQUALS(SimulationTime::Instance()->GetTimeStep(), 5e-3 + 1e-12);
+                TS_ASSERT_EQUALS(SimulationTime::Instance()->GetTimeStepsElapsed(), step - 3);
+                TS_ASSERT_EQUALS(cell_population.GetTimeStepsElapsedOffset(), 3u);
+            }
+        }
+
+        // The grids are written at every second timestep counted from the start, not from the change of timestep
+        TS_ASSERT_EQUALS(modifier.mpGridWriter->GetNumStepsWritten(), 3u);
+        modifier.mpGridWriter->Close();
+
+        FileFinder grid_file("TestAdaptiveTimestepOutputCadence/fluid_grids.h5", RelativeTo::ChasteTestOutput);
+        hid_t file = H5Fopen(grid_file.GetAbsolutePath().c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+        hid_t dataset = H5Dopen2(file, "Time", H5P_DEFAULT);
+        std::vector<double> written_times(3);
+        H5Dread(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, &written_times[0]);
+        H5Dclose(dataset);
+        H5Fclose(file);
+        for (unsigned i = 0; i < 3; i++)
+        {
+            TS_ASSERT_DELTA(written_times[i], output_times[i], 1e-12);
+        }
+
+        // Likewise the last checkpoint is from the fourth timestep, and records the timesteps elapsed since the start
+        FileFinder checkpoint_file("TestAdaptiveTimestepOutputCadence/checkpoint.ibc", RelativeTo::ChasteTestOutput);
+        ImmersedBoundaryCheckpoint<2> checkpoint;
+        checkpoint.Read(checkpoint_file.GetAbsolutePath());
+        TS_ASSERT_EQUALS(checkpoint.GetTimeStepsElapsed(), 4u);
+        TS_ASSERT_DELTA(checkpoint.GetTime(), output_times[2], 1e-12);
+
+        // A simulation restarted from the checkpoint carries on counting from it
+        SimulationTime::Destroy();
+        SimulationTime::Instance()->SetStartTime(checkpoint.GetTime());
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(1.0, 100);
+
+        ImmersedBoundaryPalisadeMeshGenerator restart_gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_restart_mesh = restart_gen.GetMesh();
+        std::vector<CellPtr> restart_cells;
+        cells_generator.GenerateBasicRandom(restart_cells, p_restart_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> restart_population(*p_restart_mesh, restart_cells);
+
+        ImmersedBoundarySimulationModifier<2> restart_modifier;
+        restart_modifier.AddImmersedBoundaryForce(p_boundary_force);
+        restart_modifier.SetRestartCheckpoint(checkpoint_file);
+        restart_modifier.SetupSolve(restart_population, "TestAdaptiveTimestepOutputCadenceRestart");
+        TS_ASSERT_EQUALS(restart_modifier.GetTimeStepsElapsed(), 4u);
+        TS_ASSERT_EQUALS(restart_population.GetTimeStepsElapsedOffset(), 4u);
+    }
+
+    void TestWarmStart() throw(Exception)
+    {
+        // Set up SimulationTime - needed by SetupConstantMemberVariables()
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(2.0, 2);
+
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        MAKE_PTR(ImmersedBoundaryMembraneElasticityForce<2>, p_boundary_force);
+
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+        std::vector<CellPtr> cells;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+
+        unsigned num_grid_pts_x = p_mesh->GetNumGridPtsX();
+        unsigned num_grid_pts_y = p_mesh->GetNumGridPtsY();
+        unsigned num_nodes = p_mesh->GetNumNodes();
+        c_vector<double, 2> initial_location = p_mesh->GetNode(0)->rGetLocation();
+
+        // Test the get and set methods
+        ImmersedBoundarySimulationModifier<2> modifier;
+        modifier.AddImmersedBoundaryForce(p_boundary_force);
+        TS_ASSERT_EQUALS(modifier.GetWarmStartNumSteps(), 0u);
+        TS_ASSERT_EQUALS(modifier.GetWarmStartCoarseningFactor(), 2u);
+        TS_ASSERT_DELTA(modifier.GetWarmStartNodeSpacingMultiplier(), 1.0, 1e-12);
+
+        TS_ASSERT_THROWS_THIS(modifier.SetWarmStart(10, 0),
+                "The warm start coarsening factor and node spacing multiplier must be at least one");
+        TS_ASSERT_THROWS_THIS(modifier.SetWarmStart(10, 2, 0.5),
+                "The warm start coarsening factor and node spacing multiplier must be at least one");
+
+        // A coarsening factor must leave an even number of grid points in each direction
+        modifier.SetWarmStart(3, 3);
+        TS_ASSERT_THROWS_THIS(modifier.SetupSolve(cell_population, "TestImmersedBoundaryWarmStart"),
+                "The warm start coarsening factor must divide the number of grid points in each direction, leaving an even number");
+
+        modifier.SetWarmStart(3, 2);
+        TS_ASSERT_EQUALS(modifier.GetWarmStartNumSteps(), 3u);
+        TS_ASSERT_EQUALS(modifier.GetWarmStartCoarseningFactor(), 2u);
+        modifier.SetupSolve(cell_population, "TestImmersedBoundaryWarmStart");
+
+        // The warm start steps are solved and the nodes moved, before the usual solve on the production grid
+        const ImmersedBoundaryPhaseTimer& r_timer = modifier.rGetPhaseTimer();
+        TS_ASSERT_EQUALS(r_timer.GetNumCalls(r_timer.GetPhaseIndex("SolveNavierStokesSpectral")), 4u);
+        TS_ASSERT_EQUALS(p_mesh->GetNumGridPtsX(), num_grid_pts_x);
+        TS_ASSERT_EQUALS(p_mesh->GetNumGridPtsY(), num_grid_pts_y);
+        TS_ASSERT_EQUALS(p_mesh->GetNumNodes(), num_nodes);
+        TS_ASSERT_LESS_THAN(0.0, norm_2(p_mesh->GetNode(0)->rGetLocation() - initial_location));
+
+        // The simulation time is not advanced
+        TS_ASSERT_EQUALS(SimulationTime::Instance()->GetTimeStepsElapsed(), 0u);
+
+        // The production grid has a fluid velocity
+        const multi_array<double, 3>& r_grids = p_mesh->rGet2dVelocityGrids();
+        TS_ASSERT_EQUALS(r_grids.shape()[1], num_grid_pts_x);
+        TS_ASSERT_EQUALS(r_grids.shape()[2], num_grid_pts_y);
+        double max_speed = 0.0;
+        for (unsigned x = 0; x < num_grid_pts_x; x++)
+        {
+            for (unsigned y = 0; y < num_grid_pts_y; y++)
+            {
+                max_speed = std::max(max_speed, fabs(r_grids[0][x][y]) + fabs(r_grids[1][x][y]));
+            }
+        }
+        TS_ASSERT_LESS_THAN(0.0, max_speed);
+
+        // The warm start may relax the elements with fewer nodes, which are then refined again
+        ImmersedBoundaryPalisadeMeshGenerator coarse_gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_coarse_mesh = coarse_gen.GetMesh();
+        std::vector<CellPtr> coarse_cells;
+        cells_generator.GenerateBasicRandom(coarse_cells, p_coarse_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> coarse_population(*p_coarse_mesh, coarse_cells);
+
+        ImmersedBoundarySimulationModifier<2> coarse_modifier;
+        coarse_modifier.AddImmersedBoundaryForce(p_boundary_force);
+        coarse_modifier.SetWarmStart(2, 2, 2.0);
+        coarse_modifier.SetupSolve(coarse_population, "TestImmersedBoundaryWarmStart");
+        TS_ASSERT_EQUALS(p_coarse_mesh->GetNumGridPtsX(), num_grid_pts_x);
+        TS_ASSERT_LESS_THAN(0.5 * num_nodes, (double) p_coarse_mesh->GetNumNodes());
+    }
+
+    void TestSemiImplicitMembraneUpdate() throw(Exception)
+    {
+        // Set up SimulationTime - needed by SetupConstantMemberVariables()
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(2.0, 2);
+
+        ImmersedBoundaryPalisadeMeshGenerator gen(5, 100, 0.2, 2.0, 0.15, true);
+        ImmersedBoundaryMesh<2,2>* p_mesh = gen.GetMesh();
+
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        std::vector<CellPtr> cells;
+        cells_generator.GenerateBasicRandom(cells, p_mesh->GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> cell_population(*p_mesh, cells);
+
+        // Test the get and set methods
+        ImmersedBoundarySimulationModifier<2> modifier;
+        TS_ASSERT_EQUALS(modifier.GetUseSemiImplicitMembraneUpdate(), false);
+        TS_ASSERT_DELTA(modifier.GetSemiImplicitSafetyFactor(), 2.0, 1e-12);
+        modifier.SetUseSemiImplicitMembraneUpdate(true);
+        modifier.SetSemiImplicitSafetyFactor(4.0);
+        TS_ASSERT_EQUALS(modifier.GetUseSemiImplicitMembraneUpdate(), true);
+        TS_ASSERT_DELTA(modifier.GetSemiImplicitSafetyFactor(), 4.0, 1e-12);
+
+        MAKE_PTR(ImmersedBoundaryMembraneElasticityForce<2>, p_boundary_force);
+        MAKE_PTR(ImmersedBoundaryCellCellInteractionForce<2>, p_cell_cell_force);
+        modifier.AddImmersedBoundaryForce(p_boundary_force);
+        modifier.AddImmersedBoundaryForce(p_cell_cell_force);
+
+        // The first solve sets a coefficient for each element, from the membrane force alone
+        modifier.SetupSolve(cell_population, "TestSemiImplicitMembraneUpdate");
+        const std::vector<double>& r_coefficients = cell_population.rGetImplicitMembraneCoefficients();
+        TS_ASSERT_EQUALS(r_coefficients.size(), p_mesh->GetNumAllElements());
+        for (unsigned elem_idx = 0; elem_idx < p_mesh->GetNumElements(); elem_idx++)
+        {
+            TS_ASSERT_LESS_THAN(0.0, r_coefficients[elem_idx]);
+        }
+
+        std::vector<double> spring_constants;
+        p_cell_cell_force->AddElementSpringConstants(spring_constants);
+        TS_ASSERT(spring_constants.empty());
+        p_boundary_force->AddElementSpringConstants(spring_constants);
+        TS_ASSERT_EQUALS(spring_constants.size(), p_mesh->GetNumAllElements());
+
+        // Doubling the safety factor doubles the coefficients
+        std::vector<double> old_coefficients = r_coefficients;
+        modifier.SetSemiImplicitSafetyFactor(8.0);
+        modifier.UpdateFluidVelocityGrids(cell_population);
+        for (unsigned elem_idx = 0; elem_idx < p_mesh->GetNumElements(); elem_idx++)
+        {
+            TS_ASSERT_DELTA(r_coefficients[elem_idx], 2.0 * old_coefficients[elem_idx], 1e-9 * old_coefficients[elem_idx]);
+        }
+
+        // The nodes are moved with the corrected displacements
+        TS_ASSERT_THROWS_NOTHING(cell_population.UpdateNodeLocations(SimulationTime::Instance()->GetTimeStep()));
+        TS_ASSERT_THROWS_NOTHING(modifier.UpdateAtEndOfTimeStep(cell_population));
+
+        // Turning the mode off stops the correction straight away
+        modifier.SetUseSemiImplicitMembraneUpdate(false);
+        TS_ASSERT(cell_population.rGetImplicitMembraneCoefficients().empty());
+        modifier.UpdateFluidVelocityGrids(cell_population);
+        TS_ASSERT(cell_population.rGetImplicitMembraneCoefficients().empty());
+    }
+
+    /**
+     * Helper method for TestSemiImplicitMembraneUpdateIsStable().  Runs a circular cell, which is in equilibrium, with
+     * node displacements unlimited so that any instability grows unchecked.
+     *
+     * @param springConstant the membrane spring constant
+     * @param semiImplicit whether to use the semi-implicit membrane update
+     * @param safetyFactor the semi-implicit safety factor
+     * @param numSteps the number of timesteps to run
+     * @param rCoefficient filled in with the implicit membrane coefficient of the cell after setting up, if semiImplicit
+     * @return the largest distance between neighbouring nodes at the end, relative to that at the start
+     */
+    double RunStiffCircularCell(double springConstant, bool semiImplicit, double safetyFactor, unsigned numSteps,
+                                double& rCoefficient)
+    {
+        SimulationTime::Destroy();
+        SimulationTime::Instance()->SetStartTime(0.0);
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(0.01 * numSteps, numSteps);
+
+        SuperellipseGenerator gen(128, 1.0, 0.3, 0.3, 0.35, 0.35);
+        std::vector<c_vector<double, 2> > locations = gen.GetPointsAsVectors();
+        std::vector<Node<2>*> nodes;
+        for (unsigned node_idx = 0; node_idx < locations.size(); node_idx++)
+        {
+            nodes.push_back(new Node<2>(node_idx, locations[node_idx], true));
+        }
+        std::vector<ImmersedBoundaryElement<2,2>*> elements;
+        elements.push_back(new ImmersedBoundaryElement<2,2>(0, nodes));
+        ImmersedBoundaryMesh<2,2> mesh(nodes, elements);
+        mesh.SetNumGridPtsXAndY(64);
+
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        CellsGenerator<UniformlyDistributedCellCycleModel, 2> cells_generator;
+        std::vector<CellPtr> cells;
+        cells_generator.GenerateBasicRandom(cells, mesh.GetNumElements(), p_diff_type);
+        ImmersedBoundaryCellPopulation<2> cell_population(mesh, cells);
+        cell_population.SetIfPopulationHasActiveSources(false);
+        cell_population.SetLimitNodeDisplacements(false);
+
+        ImmersedBoundarySimulationModifier<2> modifier;
+        MAKE_PTR(ImmersedBoundaryMembraneElasticityForce<2>, p_boundary_force);
+        p_boundary_force->SetSpringConstant(springConstant);
+        modifier.AddImmersedBoundaryForce(p_boundary_force);
+        modifier.SetUseSemiImplicitMembraneUpdate(semiImplicit);
+        modifier.SetSemiImplicitSafetyFactor(safetyFactor);
+
+        double initial_spacing = 0.0;
+        for (unsigned node_idx = 0; node_idx < mesh.GetNumNodes(); node_idx++)
+        {
+            c_vector<double, 2> gap = mesh.GetVectorFromAtoB(mesh.GetNode(node_idx)->rGetLocation(),
+                                                             mesh.GetNode((node_idx + 1) % mesh.GetNumNodes())->rGetLocation());
+            initial_spacing = std::max(initial_spacing, norm_2(gap));
+        }
+
+        modifier.SetupSolve(cell_population, "TestSemiImplicitMembraneUpdateIsStable");
+        rCoefficient = semiImplicit ? cell_population.rGetImplicitMembraneCoefficients()[0] : 0.0;
+
+        for (unsigned step = 0; step < numSteps; step++)
+        {
+            cell_population.UpdateNodeLocations(SimulationTime::Instance()->GetTimeStep());
+            SimulationTime::Instance()->IncrementTimeOneStep();
+            modifier.UpdateAtEndOfTimeStep(cell_population);
+        }
+
+        // An unstable membrane breaks up into nodes scattered over the domain, or becomes NaN, both caught by the caller
+        double final_spacing = 0.0;
+        for (unsigned node_idx = 0; node_idx < mesh.GetNumNodes(); node_idx++)
+        {
+            c_vector<double, 2> gap = mesh.GetVectorFromAtoB(mesh.GetNode(node_idx)->rGetLocation(),
+                                                             mesh.GetNode((node_idx + 1) % mesh.GetNumNodes())->rGetLocation());
+            double spacing = norm_2(gap);
+            if (!(spacing <= final_spacing))
+            {
+                final_spacing = spacing;
+            }
+            if (final_spacing != final_spacing)
+            {
+                break;
+            }
+        }
+
+        return final_spacing / initial_spacing;
+    }
+
+    void TestSemiImplicitMembraneUpdateIsStable() throw(Exception)
+    {
+        /*
+         * The implicit coefficient is dt times the spring constant times the fastest mobility of the membrane, so the
+         * explicit update is unstable once it exceeds a half or so.  Scale the spring constant so that it is 20.
+         */
+        double coefficient = 0.0;
+        RunStiffCircularCell(1e6, true, 1.0, 1, coefficient);
+        TS_ASSERT_LESS_THAN(0.0, coefficient);
+        double stiff_spring_constant = 1e6 * 20.0 / coefficient;
+
+        // The explicit update blows up
+        double explicit_ratio = RunStiffCircularCell(stiff_spring_constant, false, 2.0, 20, coefficient);
+        TS_ASSERT(!(explicit_ratio < 1.5));
+
+        // The semi-implicit update keeps the membrane intact
+        double semi_implicit_ratio = RunStiffCircularCell(stiff_spring_constant, true, 2.0, 20, coefficient);
+        TS_ASSERT_DELTA(coefficient, 40.0, 1e-6 * 40.0);
+        TS_ASSERT_LESS_THAN(semi_implicit_ratio, 1.5);
+    }
 };
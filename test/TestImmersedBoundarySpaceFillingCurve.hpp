@@ -0,0 +1,158 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TESTIMMERSEDBOUNDARYSPACEFILLINGCURVE_HPP_
+#define TESTIMMERSEDBOUNDARYSPACEFILLINGCURVE_HPP_
+
+// Needed for test framework
+#include <cxxtest/TestSuite.h>
+
+#include <cstdlib>
+
+// Includes from projects/ImmersedBoundary
+#include "ImmersedBoundarySpaceFillingCurve.hpp"
+
+// This test is never run in parallel
+#include "FakePetscSetup.hpp"
+
+class TestImmersedBoundarySpaceFillingCurve : public CxxTest::TestSuite
+{
+private:
+
+    /**
+     * Check every cell of a curve of the given order has a distinct key, and return the number of consecutive pairs
+     * of cells along the curve which are not adjacent.
+     */
+    unsigned CountJumps(const ImmersedBoundarySpaceFillingCurve& rCurve)
+    {
+        unsigned num_cells_per_side = 1u << rCurve.GetOrder();
+        unsigned num_cells = num_cells_per_side * num_cells_per_side;
+
+        std::vector<int> x_of_key(num_cells, -1);
+        std::vector<int> y_of_key(num_cells, -1);
+
+        for (unsigned x = 0; x < num_cells_per_side; x++)
+        {
+            for (unsigned y = 0; y < num_cells_per_side; y++)
+            {
+                unsigned key = rCurve.GetKey((x + 0.5) / num_cells_per_side, (y + 0.5) / num_cells_per_side);
+                TS_ASSERT_LESS_THAN(key, num_cells);
+                TS_ASSERT_EQUALS(x_of_key[key], -1);
+
+                x_of_key[key] = x;
+                y_of_key[key] = y;
+            }
+        }
+
+        unsigned num_jumps = 0;
+        for (unsigned key = 1; key < num_cells; key++)
+        {
+            if (abs(x_of_key[key] - x_of_key[key - 1]) + abs(y_of_key[key] - y_of_key[key - 1]) != 1)
+            {
+                num_jumps++;
+            }
+        }
+        return num_jumps;
+    }
+
+public:
+
+    void TestHilbertCurve() throw(Exception)
+    {
+        ImmersedBoundarySpaceFillingCurve curve(true, 3);
+        TS_ASSERT(curve.GetUseHilbertCurve());
+        TS_ASSERT_EQUALS(curve.GetOrder(), 3u);
+
+        // Consecutive cells along a Hilbert curve are always adjacent
+        TS_ASSERT_EQUALS(CountJumps(curve), 0u);
+
+        // The curve starts in one corner and ends in the next
+        TS_ASSERT_EQUALS(curve.GetKey(0.01, 0.01), 0u);
+        TS_ASSERT_EQUALS(curve.GetKey(0.99, 0.01), 63u);
+    }
+
+    void TestMortonCurve() throw(Exception)
+    {
+        ImmersedBoundarySpaceFillingCurve curve(false, 3);
+        TS_ASSERT(!curve.GetUseHilbertCurve());
+
+        // A Morton curve jumps at the end of each row of each quadrant, but still visits every cell once
+        TS_ASSERT_EQUALS(CountJumps(curve), 31u);
+
+        // The bits of the x and y cell indices are interleaved
+        TS_ASSERT_EQUALS(curve.GetKey(0.01, 0.01), 0u);
+        TS_ASSERT_EQUALS(curve.GetKey(0.126, 0.01), 1u);
+        TS_ASSERT_EQUALS(curve.GetKey(0.01, 0.126), 2u);
+        TS_ASSERT_EQUALS(curve.GetKey(0.99, 0.99), 63u);
+    }
+
+    void TestKeysWrapPeriodically() throw(Exception)
+    {
+        ImmersedBoundarySpaceFillingCurve curve;
+        TS_ASSERT(curve.GetUseHilbertCurve());
+        TS_ASSERT_EQUALS(curve.GetOrder(), 16u);
+
+        TS_ASSERT_EQUALS(curve.GetKey(1.3, 0.2), curve.GetKey(0.3, 0.2));
+        TS_ASSERT_EQUALS(curve.GetKey(-0.7, 0.2), curve.GetKey(0.3, 0.2));
+        TS_ASSERT_EQUALS(curve.GetKey(0.3, 1.0), curve.GetKey(0.3, 0.0));
+    }
+
+    void TestSort() throw(Exception)
+    {
+        ImmersedBoundarySpaceFillingCurve curve(false, 1);
+
+        // Points in the four quadrants, with two points sharing the last quadrant
+        std::vector<double> x_coordinates;
+        std::vector<double> y_coordinates;
+        x_coordinates.push_back(0.75); y_coordinates.push_back(0.75);
+        x_coordinates.push_back(0.25); y_coordinates.push_back(0.75);
+        x_coordinates.push_back(0.80); y_coordinates.push_back(0.90);
+        x_coordinates.push_back(0.75); y_coordinates.push_back(0.25);
+        x_coordinates.push_back(0.25); y_coordinates.push_back(0.25);
+
+        std::vector<unsigned> order;
+        curve.Sort(x_coordinates, y_coordinates, order);
+
+        // Points with the same key keep their original relative order
+        TS_ASSERT_EQUALS(order.size(), 5u);
+        TS_ASSERT_EQUALS(order[0], 4u);
+        TS_ASSERT_EQUALS(order[1], 3u);
+        TS_ASSERT_EQUALS(order[2], 1u);
+        TS_ASSERT_EQUALS(order[3], 0u);
+        TS_ASSERT_EQUALS(order[4], 2u);
+    }
+};
+
+#endif /*TESTIMMERSEDBOUNDARYSPACEFILLINGCURVE_HPP_*/
@@ -0,0 +1,298 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TESTIMMERSEDBOUNDARYSTENCIL_HPP_
+#define TESTIMMERSEDBOUNDARYSTENCIL_HPP_
+
+// Needed for test framework
+#include <cxxtest/TestSuite.h>
+
+// Includes from projects/ImmersedBoundary
+#include <cmath>
+#include "ImmersedBoundaryStencil.hpp"
+#include "ImmersedBoundaryStencilCache.hpp"
+
+// This test is never run in parallel
+#include "FakePetscSetup.hpp"
+
+class TestImmersedBoundaryStencil : public CxxTest::TestSuite
+{
+private:
+
+    /**
+     * Check that the weights of a stencil sum to one, for points throughout the domain.
+     *
+     * @param rStencil the stencil
+     */
+    template<unsigned WIDTH>
+    void CheckWeightsSumToOne(ImmersedBoundaryStencil<WIDTH>& rStencil)
+    {
+        for (unsigned k = 0; k < 100; k++)
+        {
+            double x = (k + 0.37) / 100.0;
+            double y = fmod(7.3 * x, 1.0);
+            rStencil.Update(x, y);
+
+            double sum = 0.0;
+            for (unsigned i = 0; i < WIDTH; i++)
+            {
+                for (unsigned j = 0; j < WIDTH; j++)
+                {
+                    sum += rStencil.GetWeight(i, j);
+                }
+            }
+            TS_ASSERT_DELTA(sum, 1.0, 1e-12);
+        }
+    }
+
+public:
+
+    void TestFourPointStencil() throw(Exception)
+    {
+        ImmersedBoundaryStencil<4> stencil(16, 8);
+
+        // A point between grid points 2 and 3 in x, and 1 and 2 in y
+        stencil.Update(2.25 / 16.0, 1.5 / 8.0);
+
+        for (unsigned i = 0; i < 4; i++)
+        {
+            TS_ASSERT_EQUALS(stencil.GetIndexX(i), 1 + i);
+            TS_ASSERT_EQUALS(stencil.GetIndexY(i), i);
+        }
+
+        // The weights agree with the cosine kernel 0.25 * (1 + cos(pi r / 2))
+        for (unsigned i = 0; i < 4; i++)
+        {
+            double r_x = (1.0 + i) - 2.25;
+            double r_y = (0.0 + i) - 1.5;
+            double delta_x = 0.25 * (1.0 + cos(0.5 * M_PI * r_x));
+            double delta_y = 0.25 * (1.0 + cos(0.5 * M_PI * r_y));
+
+            TS_ASSERT_DELTA(stencil.GetWeight(i, i), delta_x * delta_y, 1e-12);
+        }
+
+        // Near the boundary, the indices wrap around and the weights are unaffected
+        stencil.Update(0.25 / 16.0, 7.5 / 8.0);
+
+        TS_ASSERT_EQUALS(stencil.GetIndexX(0), 15u);
+        TS_ASSERT_EQUALS(stencil.GetIndexX(1), 0u);
+        TS_ASSERT_EQUALS(stencil.GetIndexX(3), 2u);
+        TS_ASSERT_EQUALS(stencil.GetIndexY(0), 6u);
+        TS_ASSERT_EQUALS(stencil.GetIndexY(2), 0u);
+        TS_ASSERT_EQUALS(stencil.GetIndexY(3), 1u);
+
+        double delta_x_0 = 0.25 * (1.0 + cos(0.5 * M_PI * (-1.25)));
+        double delta_y_0 = 0.25 * (1.0 + cos(0.5 * M_PI * (-1.5)));
+        TS_ASSERT_DELTA(stencil.GetWeight(0, 0), delta_x_0 * delta_y_0, 1e-12);
+
+        CheckWeightsSumToOne(stencil);
+    }
+
+    void TestThreePointStencil() throw(Exception)
+    {
+        ImmersedBoundaryStencil<3> stencil(16, 16);
+
+        // At a grid point, the kernel of Roma et al. gives weights 1/6, 2/3, 1/6
+        stencil.Update(5.0 / 16.0, 5.0 / 16.0);
+
+        TS_ASSERT_EQUALS(stencil.GetIndexX(0), 4u);
+        TS_ASSERT_EQUALS(stencil.GetIndexX(1), 5u);
+        TS_ASSERT_EQUALS(stencil.GetIndexX(2), 6u);
+
+        TS_ASSERT_DELTA(stencil.GetWeight(1, 1), 4.0 / 9.0, 1e-12);
+        TS_ASSERT_DELTA(stencil.GetWeight(0, 1), 1.0 / 9.0, 1e-12);
+        TS_ASSERT_DELTA(stencil.GetWeight(0, 2), 1.0 / 36.0, 1e-12);
+
+        CheckWeightsSumToOne(stencil);
+    }
+
+    void TestSixPointStencil() throw(Exception)
+    {
+        ImmersedBoundaryStencil<6> stencil(32, 32);
+
+        stencil.Update(10.4 / 32.0, 0.1 / 32.0);
+
+        TS_ASSERT_EQUALS(stencil.GetIndexX(0), 8u);
+        TS_ASSERT_EQUALS(stencil.GetIndexX(5), 13u);
+        TS_ASSERT_EQUALS(stencil.GetIndexY(0), 30u);
+        TS_ASSERT_EQUALS(stencil.GetIndexY(5), 3u);
+
+        // The weights agree with the cosine kernel (1 + cos(pi r / 3)) / 6
+        double r_x = 8.0 - 10.4;
+        double r_y = -2.0 - 0.1;
+        double expected = (1.0 + cos(M_PI * r_x / 3.0)) * (1.0 + cos(M_PI * r_y / 3.0)) / 36.0;
+        TS_ASSERT_DELTA(stencil.GetWeight(0, 0), expected, 1e-12);
+
+        CheckWeightsSumToOne(stencil);
+    }
+
+    void TestStencilInRectangularDomain() throw(Exception)
+    {
+        // In a 2 x 0.5 domain, a point has the same indices and weights as the scaled point in the unit square
+        ImmersedBoundaryStencil<4> unit_stencil(16, 8);
+        ImmersedBoundaryStencil<4> rect_stencil(16, 8, 2.0, 0.5);
+
+        unit_stencil.Update(0.3, 0.95);
+        rect_stencil.Update(0.6, 0.475);
+
+        for (unsigned i = 0; i < 4; i++)
+        {
+            TS_ASSERT_EQUALS(rect_stencil.GetIndexX(i), unit_stencil.GetIndexX(i));
+            TS_ASSERT_EQUALS(rect_stencil.GetIndexY(i), unit_stencil.GetIndexY(i));
+
+            for (unsigned j = 0; j < 4; j++)
+            {
+                TS_ASSERT_DELTA(rect_stencil.GetWeight(i, j), unit_stencil.GetWeight(i, j), 1e-12);
+            }
+        }
+    }
+
+    void TestStencilWithWalls() throw(Exception)
+    {
+        // With walls normal to y, the grid points lie at (j + 1/2) / 8, and the stencil reflects at y = 0 and y = 1
+        ImmersedBoundaryStencil<4> stencil(16, 8, 1.0, 1.0, false, true);
+
+        stencil.Update(0.5, 0.25 / 8.0);
+
+        unsigned expected_indices[4] = {1u, 0u, 0u, 1u};
+        double expected_signs[4] = {-1.0, -1.0, 1.0, 1.0};
+        for (unsigned j = 0; j < 4; j++)
+        {
+            TS_ASSERT_EQUALS(stencil.GetIndexY(j), expected_indices[j]);
+            TS_ASSERT_DELTA(stencil.GetSignY(j), expected_signs[j], 1e-15);
+            TS_ASSERT_DELTA(stencil.GetSignX(j), 1.0, 1e-15);
+        }
+
+        // The x direction is still periodic
+        stencil.Update(0.25 / 16.0, 0.5);
+        TS_ASSERT_EQUALS(stencil.GetIndexX(0), 15u);
+
+        // A point on either wall sees an odd quantity cancel exactly, and an even quantity with weights summing to one
+        for (unsigned k = 0; k < 2; k++)
+        {
+            stencil.Update(0.3, (double) k);
+
+            double odd_weights[8] = {0.0};
+            double sum = 0.0;
+            for (unsigned j = 0; j < 4; j++)
+            {
+                for (unsigned i = 0; i < 4; i++)
+                {
+                    odd_weights[stencil.GetIndexY(j)] += stencil.GetSignY(j) * stencil.GetWeight(i, j);
+                    sum += stencil.GetWeight(i, j);
+                }
+            }
+
+            TS_ASSERT_DELTA(sum, 1.0, 1e-12);
+            for (unsigned j = 0; j < 8; j++)
+            {
+                TS_ASSERT_DELTA(odd_weights[j], 0.0, 1e-12);
+            }
+        }
+
+        // Reflections are reconstructed from a cache
+        ImmersedBoundaryStencilCache cache;
+        cache.Reset(4, 1);
+
+        stencil.Update(0.5, 7.9 / 8.0);
+        stencil.Store(cache, 0);
+        cache.SetValid();
+
+        ImmersedBoundaryStencil<4> loaded(16, 8, 1.0, 1.0, false, true);
+        TS_ASSERT_EQUALS(loaded.Load(cache, 0), true);
+        for (unsigned j = 0; j < 4; j++)
+        {
+            TS_ASSERT_EQUALS(loaded.GetIndexY(j), stencil.GetIndexY(j));
+            TS_ASSERT_DELTA(loaded.GetSignY(j), stencil.GetSignY(j), 1e-15);
+        }
+        TS_ASSERT_EQUALS(loaded.GetIndexY(3), 6u);
+        TS_ASSERT_DELTA(loaded.GetSignY(3), -1.0, 1e-15);
+    }
+
+    void TestStencilCache() throw(Exception)
+    {
+        ImmersedBoundaryStencilCache cache;
+
+        // A default cache is valid for nothing
+        TS_ASSERT_EQUALS(cache.IsValid(4, 0), false);
+
+        cache.Reset(4, 3);
+        TS_ASSERT_EQUALS(cache.IsValid(4, 3), false);
+
+        // Store stencils for two of the three points
+        ImmersedBoundaryStencil<4> stencil(16, 8);
+
+        stencil.Update(0.25 / 16.0, 7.5 / 8.0);
+        stencil.Store(cache, 0);
+
+        stencil.Update(2.25 / 16.0, 1.5 / 8.0);
+        stencil.Store(cache, 2);
+
+        cache.SetValid();
+        TS_ASSERT_EQUALS(cache.IsValid(4, 3), true);
+        TS_ASSERT_EQUALS(cache.IsValid(3, 3), false);
+        TS_ASSERT_EQUALS(cache.IsValid(4, 4), false);
+
+        // Loading a point reproduces its stencil exactly, including indices which wrap around
+        ImmersedBoundaryStencil<4> fresh(16, 8);
+        fresh.Update(0.25 / 16.0, 7.5 / 8.0);
+
+        ImmersedBoundaryStencil<4> loaded(16, 8);
+        TS_ASSERT_EQUALS(loaded.Load(cache, 0), true);
+
+        for (unsigned i = 0; i < 4; i++)
+        {
+            TS_ASSERT_EQUALS(loaded.GetIndexX(i), fresh.GetIndexX(i));
+            TS_ASSERT_EQUALS(loaded.GetIndexY(i), fresh.GetIndexY(i));
+
+            for (unsigned j = 0; j < 4; j++)
+            {
+                TS_ASSERT_DELTA(loaded.GetWeight(i, j), fresh.GetWeight(i, j), 1e-15);
+            }
+        }
+
+        // A point with nothing stored cannot be loaded, and leaves the stencil as it was
+        TS_ASSERT_EQUALS(loaded.Load(cache, 1), false);
+        TS_ASSERT_EQUALS(loaded.GetIndexX(0), 15u);
+
+        TS_ASSERT_EQUALS(loaded.Load(cache, 2), true);
+        TS_ASSERT_EQUALS(loaded.GetIndexX(0), 1u);
+
+        cache.Invalidate();
+        TS_ASSERT_EQUALS(cache.IsValid(4, 3), false);
+    }
+};
+
+#endif /*TESTIMMERSEDBOUNDARYSTENCIL_HPP_*/
@@ -0,0 +1,138 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TESTIMMERSEDBOUNDARYSTRIPPARTITION_HPP_
+#define TESTIMMERSEDBOUNDARYSTRIPPARTITION_HPP_
+
+// Needed for test framework
+#include <cxxtest/TestSuite.h>
+
+// Includes from projects/ImmersedBoundary
+#include "ImmersedBoundaryStencil.hpp"
+#include "ImmersedBoundaryStripPartition.hpp"
+
+// This test is never run in parallel
+#include "FakePetscSetup.hpp"
+
+class TestImmersedBoundaryStripPartition : public CxxTest::TestSuite
+{
+public:
+
+    void TestStripLayout() throw(Exception)
+    {
+        // Strips are twice the stencil width, with an even number of them
+        ImmersedBoundaryStripPartition partition_small(32, 4);
+        TS_ASSERT_EQUALS(partition_small.GetNumStrips(), 4u);
+
+        ImmersedBoundaryStripPartition partition_odd(40, 4);
+        TS_ASSERT_EQUALS(partition_odd.GetNumStrips(), 4u);
+
+        // Large grids are divided into 64 strips
+        ImmersedBoundaryStripPartition partition_large(1024, 4);
+        TS_ASSERT_EQUALS(partition_large.GetNumStrips(), 64u);
+
+        // Grids too small for two strips are not partitioned
+        ImmersedBoundaryStripPartition partition_tiny(12, 4);
+        TS_ASSERT_EQUALS(partition_tiny.GetNumStrips(), 1u);
+
+        std::vector<double> x_coordinates(3, 0.5);
+        partition_tiny.Partition(x_coordinates);
+        TS_ASSERT_EQUALS(partition_tiny.GetStripBegin(0), 0u);
+        TS_ASSERT_EQUALS(partition_tiny.GetStripEnd(0), 3u);
+    }
+
+    void TestPartition() throw(Exception)
+    {
+        const unsigned num_grid_pts = 64;
+        ImmersedBoundaryStripPartition partition(num_grid_pts, 4);
+        TS_ASSERT_EQUALS(partition.GetNumStrips(), 8u);
+
+        // Points spread irregularly over the unit interval, including either side of the periodic boundary
+        std::vector<double> x_coordinates;
+        for (unsigned i = 0; i < 200; i++)
+        {
+            x_coordinates.push_back(fmod(0.618034 * i * i, 1.0));
+        }
+        x_coordinates.push_back(0.0);
+        x_coordinates.push_back(0.999);
+
+        partition.Partition(x_coordinates);
+
+        // Every point appears exactly once, and in the original order within each strip
+        std::vector<unsigned> times_seen(x_coordinates.size(), 0u);
+        TS_ASSERT_EQUALS(partition.GetStripBegin(0), 0u);
+        TS_ASSERT_EQUALS(partition.GetStripEnd(7), x_coordinates.size());
+
+        for (unsigned strip = 0; strip < partition.GetNumStrips(); strip++)
+        {
+            for (unsigned offset = partition.GetStripBegin(strip); offset < partition.GetStripEnd(strip); offset++)
+            {
+                times_seen[partition.GetPoint(offset)]++;
+
+                if (offset > partition.GetStripBegin(strip))
+                {
+                    TS_ASSERT_LESS_THAN(partition.GetPoint(offset - 1), partition.GetPoint(offset));
+                }
+            }
+        }
+        for (unsigned i = 0; i < times_seen.size(); i++)
+        {
+            TS_ASSERT_EQUALS(times_seen[i], 1u);
+        }
+
+        // Record which strip writes to each grid column; no two strips of the same parity may share a column
+        std::vector<int> writer_by_parity[2];
+        writer_by_parity[0].assign(num_grid_pts, -1);
+        writer_by_parity[1].assign(num_grid_pts, -1);
+
+        ImmersedBoundaryStencil<4> stencil(num_grid_pts, num_grid_pts);
+        for (unsigned strip = 0; strip < partition.GetNumStrips(); strip++)
+        {
+            for (unsigned offset = partition.GetStripBegin(strip); offset < partition.GetStripEnd(strip); offset++)
+            {
+                stencil.Update(x_coordinates[partition.GetPoint(offset)], 0.5);
+
+                for (unsigned i = 0; i < 4; i++)
+                {
+                    int& r_writer = writer_by_parity[strip % 2][stencil.GetIndexX(i)];
+                    TS_ASSERT(r_writer == -1 || r_writer == (int) strip);
+                    r_writer = (int) strip;
+                }
+            }
+        }
+    }
+};
+
+#endif /*TESTIMMERSEDBOUNDARYSTRIPPARTITION_HPP_*/
@@ -0,0 +1,185 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TESTIMMERSEDBOUNDARYTASKGRAPH_HPP_
+#define TESTIMMERSEDBOUNDARYTASKGRAPH_HPP_
+
+// Needed for test framework
+#include <cxxtest/TestSuite.h>
+
+#include <climits>
+#include <vector>
+
+// Includes from projects/ImmersedBoundary
+#include "ImmersedBoundaryTaskGraph.hpp"
+
+// This test is never run in parallel
+#include "FakePetscSetup.hpp"
+
+/**
+ * Record that a task has run, by appending its argument to the vector of unsigneds pointed to by pData.
+ *
+ * @param pData the order in which the tasks have run
+ * @param argument the task
+ */
+void RecordTask(void* pData, unsigned argument)
+{
+    std::vector<unsigned>& r_order = *static_cast<std::vector<unsigned>*>(pData);
+#ifdef _OPENMP
+#pragma omp critical(TestImmersedBoundaryTaskGraph)
+#endif
+    {
+        r_order.push_back(argument);
+    }
+}
+
+/**
+ * Throw an exception.
+ *
+ * @param pData unused
+ * @param argument unused
+ */
+void ThrowFromTask(void* pData, unsigned argument)
+{
+    EXCEPTION("Task failed");
+}
+
+class TestImmersedBoundaryTaskGraph : public CxxTest::TestSuite
+{
+private:
+
+    /**
+     * @return the position of a task in the order in which the tasks ran
+     *
+     * @param rOrder the order in which the tasks ran
+     * @param task the task
+     */
+    unsigned GetPosition(const std::vector<unsigned>& rOrder, unsigned task)
+    {
+        for (unsigned idx = 0; idx < rOrder.size(); idx++)
+        {
+            if (rOrder[idx] == task)
+            {
+                return idx;
+            }
+        }
+        return UINT_MAX;
+    }
+
+public:
+
+    void TestDependenciesAreRespected() throw(Exception)
+    {
+        for (unsigned num_threads = 1; num_threads <= 4; num_threads += 3)
+        {
+            /*
+             * Two independent chains of work, 0 -> 2 and 1 -> 2, joined at 2, which 3 and 4 depend on, and which are
+             * in turn joined at 5.  Task 6 depends on nothing.
+             */
+            std::vector<unsigned> order;
+            ImmersedBoundaryTaskGraph graph;
+            for (unsigned task = 0; task < 7; task++)
+            {
+                TS_ASSERT_EQUALS(graph.AddTask(RecordTask, &order, task), task);
+            }
+            TS_ASSERT_EQUALS(graph.GetNumTasks(), 7u);
+
+            graph.AddDependency(0, 2);
+            graph.AddDependency(1, 2);
+            graph.AddDependency(2, 3);
+            graph.AddDependency(2, 4);
+            graph.AddDependency(3, 5);
+            graph.AddDependency(4, 5);
+
+            graph.Run(num_threads);
+
+            // Each task runs once, after every task it depends on
+            TS_ASSERT_EQUALS(order.size(), 7u);
+            for (unsigned task = 0; task < 7; task++)
+            {
+                TS_ASSERT_LESS_THAN(GetPosition(order, task), 7u);
+            }
+            TS_ASSERT_LESS_THAN(GetPosition(order, 0), GetPosition(order, 2));
+            TS_ASSERT_LESS_THAN(GetPosition(order, 1), GetPosition(order, 2));
+            TS_ASSERT_LESS_THAN(GetPosition(order, 2), GetPosition(order, 3));
+            TS_ASSERT_LESS_THAN(GetPosition(order, 2), GetPosition(order, 4));
+            TS_ASSERT_LESS_THAN(GetPosition(order, 3), GetPosition(order, 5));
+            TS_ASSERT_LESS_THAN(GetPosition(order, 4), GetPosition(order, 5));
+
+            // The graph may be run again
+            order.clear();
+            graph.Run(num_threads);
+            TS_ASSERT_EQUALS(order.size(), 7u);
+
+            graph.Clear();
+            TS_ASSERT_EQUALS(graph.GetNumTasks(), 0u);
+            graph.Run(num_threads);
+        }
+    }
+
+    void TestExceptions() throw(Exception)
+    {
+        for (unsigned num_threads = 1; num_threads <= 4; num_threads += 3)
+        {
+            // A graph whose dependencies have a cycle cannot be run
+            std::vector<unsigned> order;
+            ImmersedBoundaryTaskGraph graph;
+            graph.AddTask(RecordTask, &order, 0);
+            graph.AddTask(RecordTask, &order, 1);
+            graph.AddTask(RecordTask, &order, 2);
+            graph.AddDependency(0, 1);
+            graph.AddDependency(1, 2);
+            graph.AddDependency(2, 1);
+
+            TS_ASSERT_THROWS_THIS(graph.Run(num_threads), "The dependencies of the task graph have a cycle");
+            TS_ASSERT_EQUALS(order.size(), 0u);
+
+            // An exception thrown by a task is rethrown, and the tasks depending on it are not run
+            graph.Clear();
+            graph.AddTask(ThrowFromTask, NULL, 0);
+            graph.AddTask(RecordTask, &order, 1);
+            graph.AddTask(RecordTask, &order, 2);
+            graph.AddTask(RecordTask, &order, 3);
+            graph.AddDependency(0, 1);
+            graph.AddDependency(1, 2);
+
+            TS_ASSERT_THROWS_THIS(graph.Run(num_threads), "Task failed");
+            TS_ASSERT_EQUALS(order.size(), 1u);
+            TS_ASSERT_EQUALS(order[0], 3u);
+        }
+    }
+};
+
+#endif /*TESTIMMERSEDBOUNDARYTASKGRAPH_HPP_*/
@@ -0,0 +1,228 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TESTIMMERSEDBOUNDARYTRACER_HPP_
+#define TESTIMMERSEDBOUNDARYTRACER_HPP_
+
+// Needed for test framework
+#include <cxxtest/TestSuite.h>
+
+#include <fstream>
+#include <pthread.h>
+#include <sstream>
+#include <string>
+
+// Includes from trunk
+#include "OutputFileHandler.hpp"
+
+// Includes from projects/ImmersedBoundary
+#include "ImmersedBoundaryPhaseTimer.hpp"
+#include "ImmersedBoundaryTracer.hpp"
+
+// This test is never run in parallel
+#include "FakePetscSetup.hpp"
+
+/**
+ * Name the calling thread and record a number of spans on it.
+ *
+ * @param pNumSpans the number of spans to record, as a pointer to an unsigned
+ * @return NULL
+ */
+void* RecordTraceSpans(void* pNumSpans)
+{
+    ImmersedBoundaryTracer::SetThreadName("worker");
+    unsigned num_spans = *static_cast<unsigned*>(pNumSpans);
+    for (unsigned span = 0; span < num_spans; span++)
+    {
+        ImmersedBoundaryTraceSpan trace_span("WorkerSpan", "test");
+    }
+    return NULL;
+}
+
+/**
+ * Record a span, then wait at a barrier twice, so that the thread stays running between the two waits.
+ *
+ * @param pBarrier the barrier, as a pointer to a pthread_barrier_t
+ * @return NULL
+ */
+void* RecordTraceSpanAndWait(void* pBarrier)
+{
+    {
+        ImmersedBoundaryTraceSpan trace_span("WaitingSpan", "test");
+    }
+    pthread_barrier_wait(static_cast<pthread_barrier_t*>(pBarrier));
+    pthread_barrier_wait(static_cast<pthread_barrier_t*>(pBarrier));
+    return NULL;
+}
+
+class TestImmersedBoundaryTracer : public CxxTest::TestSuite
+{
+private:
+
+    /**
+     * @param rFileName the name of a file in the test output directory
+     * @return the contents of the file
+     */
+    std::string ReadTrace(const std::string& rFileName)
+    {
+        OutputFileHandler output_file_handler("TestImmersedBoundaryTracer", false);
+        std::ifstream file((output_file_handler.GetOutputDirectoryFullPath() + rFileName).c_str());
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+public:
+
+    void TestInternName() throw(Exception)
+    {
+        std::string name = "phase";
+        const char* p_name = ImmersedBoundaryTracer::InternName(name);
+        TS_ASSERT_EQUALS(std::string(p_name), "phase");
+
+        // The same name is interned once, and outlives the string it was interned from
+        name = "other";
+        TS_ASSERT_EQUALS(ImmersedBoundaryTracer::InternName("phase"), p_name);
+        TS_ASSERT_EQUALS(std::string(p_name), "phase");
+    }
+
+    void TestSpans() throw(Exception)
+    {
+        // Nothing is recorded until tracing is enabled
+        ImmersedBoundaryTracer::Disable();
+        TS_ASSERT(!ImmersedBoundaryTracer::IsEnabled());
+        {
+            ImmersedBoundaryTraceSpan span("Ignored", "test");
+        }
+        ImmersedBoundaryTracer::Enable(16);
+        TS_ASSERT(ImmersedBoundaryTracer::IsEnabled());
+        TS_ASSERT_EQUALS(ImmersedBoundaryTracer::GetNumSpans(), 0u);
+
+        // Spans may be nested, and phases timed are recorded as spans
+        ImmersedBoundaryPhaseTimer timer;
+        unsigned phase = timer.AddPhase("Phase");
+        {
+            ImmersedBoundaryTraceSpan outer_span("Outer", "test");
+            timer.StartPhase(phase);
+            {
+                ImmersedBoundaryTraceSpan inner_span("Inner \"quoted\"", "test");
+            }
+            timer.StopPhase(phase);
+        }
+        TS_ASSERT_EQUALS(ImmersedBoundaryTracer::GetNumSpans(), 3u);
+
+        ImmersedBoundaryTracer::SetThreadName("main");
+        ImmersedBoundaryTracer::WriteChromeTrace("TestImmersedBoundaryTracer", "trace.json");
+        std::string trace = ReadTrace("trace.json");
+        TS_ASSERT_EQUALS(trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0u);
+        TS_ASSERT_DIFFERS(trace.find("\"name\":\"Outer\",\"cat\":\"test\",\"ph\":\"X\""), std::string::npos);
+        TS_ASSERT_DIFFERS(trace.find("\"name\":\"Inner \\\"quoted\\\"\""), std::string::npos);
+        TS_ASSERT_DIFFERS(trace.find("\"name\":\"Phase\",\"cat\":\"phase\""), std::string::npos);
+        TS_ASSERT_DIFFERS(trace.find("\"args\":{\"name\":\"main\"}"), std::string::npos);
+        TS_ASSERT_EQUALS(trace.find("Ignored"), std::string::npos);
+
+        // Once disabled, spans are no longer recorded, but those recorded are kept
+        ImmersedBoundaryTracer::Disable();
+        {
+            ImmersedBoundaryTraceSpan span("Ignored", "test");
+        }
+        TS_ASSERT_EQUALS(ImmersedBoundaryTracer::GetNumSpans(), 3u);
+
+        // Enabling tracing again discards the spans recorded so far
+        ImmersedBoundaryTracer::Enable(16);
+        TS_ASSERT_EQUALS(ImmersedBoundaryTracer::GetNumSpans(), 0u);
+        ImmersedBoundaryTracer::Disable();
+    }
+
+    void TestRingBuffers() throw(Exception)
+    {
+        ImmersedBoundaryTracer::Enable(8);
+
+        // Only the most recent spans of each thread are kept
+        for (unsigned span = 0; span < 20; span++)
+        {
+            ImmersedBoundaryTraceSpan trace_span(span < 12 ? "Old" : "New", "test");
+        }
+        TS_ASSERT_EQUALS(ImmersedBoundaryTracer::GetNumSpans(), 8u);
+
+        // Each thread records its spans in its own buffer, which outlasts the thread
+        unsigned num_spans = 5;
+        pthread_t thread;
+        TS_ASSERT_EQUALS(pthread_create(&thread, NULL, RecordTraceSpans, &num_spans), 0);
+        pthread_join(thread, NULL);
+        TS_ASSERT_EQUALS(ImmersedBoundaryTracer::GetNumSpans(), 13u);
+
+        ImmersedBoundaryTracer::WriteChromeTrace("TestImmersedBoundaryTracer", "ring_buffers.json");
+        std::string trace = ReadTrace("ring_buffers.json");
+        TS_ASSERT_EQUALS(trace.find("\"name\":\"Old\""), std::string::npos);
+        TS_ASSERT_DIFFERS(trace.find("\"name\":\"New\""), std::string::npos);
+        TS_ASSERT_DIFFERS(trace.find("\"name\":\"WorkerSpan\""), std::string::npos);
+        TS_ASSERT_DIFFERS(trace.find("\"args\":{\"name\":\"worker\"}"), std::string::npos);
+
+        // The spans of finished threads are discarded when tracing is next enabled
+        ImmersedBoundaryTracer::Enable(8);
+        TS_ASSERT_EQUALS(ImmersedBoundaryTracer::GetNumSpans(), 0u);
+        ImmersedBoundaryTracer::Disable();
+    }
+
+    void TestEnableWhileOtherThreadsRun() throw(Exception)
+    {
+        ImmersedBoundaryTracer::Enable(8);
+
+        pthread_barrier_t barrier;
+        pthread_barrier_init(&barrier, NULL, 2);
+        pthread_t thread;
+        TS_ASSERT_EQUALS(pthread_create(&thread, NULL, RecordTraceSpanAndWait, &barrier), 0);
+        pthread_barrier_wait(&barrier);
+        TS_ASSERT_EQUALS(ImmersedBoundaryTracer::GetNumSpans(), 1u);
+
+        // The running thread's buffer cannot be resized under it, but its spans may be discarded
+        TS_ASSERT_THROWS_CONTAINS(ImmersedBoundaryTracer::Enable(4), "while another running thread keeps 8 spans");
+        TS_ASSERT(ImmersedBoundaryTracer::IsEnabled());
+        TS_ASSERT_EQUALS(ImmersedBoundaryTracer::GetNumSpans(), 1u);
+        ImmersedBoundaryTracer::Enable(8);
+        TS_ASSERT_EQUALS(ImmersedBoundaryTracer::GetNumSpans(), 0u);
+
+        pthread_barrier_wait(&barrier);
+        pthread_join(thread, NULL);
+        pthread_barrier_destroy(&barrier);
+
+        // Once the thread has finished, the number of spans may change again
+        TS_ASSERT_THROWS_NOTHING(ImmersedBoundaryTracer::Enable(4));
+        ImmersedBoundaryTracer::Disable();
+    }
+};
+
+#endif /*TESTIMMERSEDBOUNDARYTRACER_HPP_*/
@@ -164,4 +164,41 @@ public:
             TS_ASSERT_DELTA(vector_points[idx][1], chaste_points[idx][1], 1e-6);
         }
     }
+
+    void TestCachedShapesAreScaledAndTranslated() throw(Exception)
+    {
+        SuperellipseGenerator::ClearCache();
+        TS_ASSERT_EQUALS(SuperellipseGenerator::GetNumCachedShapes(), 0u);
+
+        SuperellipseGenerator small_gen(100, 0.2, 0.1, 0.2, 0.0, 0.0);
+        TS_ASSERT_EQUALS(SuperellipseGenerator::GetNumCachedShapes(), 1u);
+
+        // A superellipse with the same number of points, exponent and aspect ratio reuses the cached shape
+        SuperellipseGenerator large_gen(100, 0.2, 0.3, 0.6, 0.25, 0.125);
+        TS_ASSERT_EQUALS(SuperellipseGenerator::GetNumCachedShapes(), 1u);
+
+        std::vector<c_vector<double, 2> > small_points = small_gen.GetPointsAsVectors();
+        std::vector<c_vector<double, 2> > large_points = large_gen.GetPointsAsVectors();
+        TS_ASSERT_EQUALS(large_points.size(), 100u);
+        for (unsigned idx = 0; idx < small_points.size(); idx++)
+        {
+            TS_ASSERT_DELTA(large_points[idx][0], 3.0 * small_points[idx][0] + 0.25, 1e-12);
+            TS_ASSERT_DELTA(large_points[idx][1], 3.0 * small_points[idx][1] + 0.125, 1e-12);
+        }
+        TS_ASSERT_DELTA(large_gen.GetTargetNodeSpacing(), 3.0 * small_gen.GetTargetNodeSpacing(), 1e-12);
+        TS_ASSERT_DELTA(large_gen.GetHeightOfTopSurface(), 3.0 * small_gen.GetHeightOfTopSurface() + 0.125, 1e-12);
+
+        // A different shape is cached separately, and the points of a fresh shape are unchanged by the cache
+        SuperellipseGenerator other_gen(100, 0.2, 0.1, 0.3, 0.0, 0.0);
+        TS_ASSERT_EQUALS(SuperellipseGenerator::GetNumCachedShapes(), 2u);
+
+        SuperellipseGenerator::ClearCache();
+        SuperellipseGenerator fresh_gen(100, 0.2, 0.3, 0.6, 0.25, 0.125);
+        std::vector<c_vector<double, 2> > fresh_points = fresh_gen.GetPointsAsVectors();
+        for (unsigned idx = 0; idx < fresh_points.size(); idx++)
+        {
+            TS_ASSERT_DELTA(fresh_points[idx][0], large_points[idx][0], 1e-15);
+            TS_ASSERT_DELTA(fresh_points[idx][1], large_points[idx][1], 1e-15);
+        }
+    }
 };